@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 namespace folly {
 class AsyncTransport;
 }
@@ -24,6 +26,20 @@ namespace wangle {
 
 class Acceptor;
 
+/**
+ * Counts of accept-path events accumulated for an observer in batched
+ * delivery mode (see AcceptObserver::preferBatchedEvents).
+ *
+ * Transports are deliberately not part of the batch: a connection can be
+ * accepted and destroyed within the same loop iteration, so by the time a
+ * batch is delivered its transports may no longer exist. Observers that
+ * need the transport must use per-connection delivery.
+ */
+struct AcceptEventBatch {
+  uint64_t accepted{0};
+  uint64_t ready{0};
+};
+
 /**
  * Observer of events related to connection acceptance.
  *
@@ -31,11 +47,53 @@ class Acceptor;
  * other observers to enable instrumentation to be installed when a connection
  * is accepted. For instance, a sampling algorithm can be executed in accept()
  * to sample and install instrumentation on a subset of connections.
+ *
+ * Callbacks run synchronously on the accept path, so an expensive observer
+ * is paid for on every accepted connection. Observers that only need a
+ * subset of connections can override getSampleRate(); observers that only
+ * need counts can override preferBatchedEvents() to be taken off the
+ * per-connection path entirely.
  */
 class AcceptObserver {
  public:
   virtual ~AcceptObserver() = default;
 
+  /**
+   * Sampling rate for the per-connection callbacks. accept() and ready()
+   * are each invoked for one in N events; the default of 1 reports every
+   * connection. The two event streams are sampled independently, so a
+   * sampled ready() does not necessarily belong to a connection whose
+   * accept() was sampled; observers that need the two paired should keep
+   * the default and sample in accept() themselves.
+   *
+   * Read once when the observer is attached.
+   */
+  virtual uint32_t getSampleRate() const noexcept {
+    return 1;
+  }
+
+  /**
+   * Whether events should be delivered in batches instead of per
+   * connection. When this returns true, accept() and ready() are never
+   * invoked; the acceptor counts events and delivers onEventBatch() at
+   * most once per event loop iteration. Counts are exact — sampling does
+   * not apply to batches.
+   *
+   * Read once when the observer is attached.
+   */
+  virtual bool preferBatchedEvents() const noexcept {
+    return false;
+  }
+
+  /**
+   * onEventBatch() is invoked once per event loop iteration in which
+   * accept-path events occurred, if preferBatchedEvents() returned true
+   * at attach time.
+   *
+   * @param batch       Event counts since the previous batch.
+   */
+  virtual void onEventBatch(const AcceptEventBatch& /* batch */) noexcept {}
+
   /**
    * accept() is invoked after a connection has been accepted and an
    * AsyncTransport has been instantiated to manage the socket fd / connection.
@@ -24,6 +24,7 @@
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/EventBase.h>
+#include <folly/net/NetOps.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/Sockets.h>
 #include <folly/portability/Unistd.h>
@@ -33,8 +34,10 @@
 #include <wangle/acceptor/ManagedConnection.h>
 #include <wangle/acceptor/SecurityProtocolContextManager.h>
 #include <wangle/ssl/SSLContextManager.h>
+#include <wangle/util/Tracepoints.h>
 
 #include <fstream>
+#include <tuple>
 
 using folly::AsyncServerSocket;
 using folly::AsyncSocket;
@@ -52,13 +55,23 @@ static const std::string empty_string;
 Acceptor::Acceptor(const ServerSocketConfig& accConfig)
     : accConfig_(accConfig),
       socketOptions_(accConfig.getSocketOptions()),
-      observerList_(this) {}
+      observerList_(this) {
+  if (accConfig_.maxHandshakesPerSourcePerWindow > 0) {
+    handshakeRateLimiter_ = std::make_unique<HandshakeRateLimiter>(
+        accConfig_.maxHandshakesPerSourcePerWindow,
+        accConfig_.handshakeRateLimitWindow,
+        accConfig_.handshakeRateLimitPrefixLengthV4,
+        accConfig_.handshakeRateLimitPrefixLengthV6);
+  }
+}
 
 void Acceptor::init(
     AsyncServerSocket* serverSocket,
     EventBase* eventBase,
     SSLStats* stats,
     std::shared_ptr<const fizz::server::FizzServerContext> fizzContext) {
+  sslStats_ = stats;
+  serverSocket_ = serverSocket;
   if (accConfig_.isSSL()) {
     if (accConfig_.allowInsecureConnectionsOnSecureServer) {
       securityProtocolCtxManager_.addPeeker(&tlsPlaintextPeekingCallback_);
@@ -85,6 +98,14 @@ void Acceptor::init(
       securityProtocolCtxManager_.addPeeker(&defaultPeekingCallback_);
     }
 
+    if (!accConfig_.sslCacheOptions.sessionPersistencePath.empty()) {
+      // Registered before the contexts are built, so the first session
+      // cache manager warms the shared local cache from the previous
+      // run's snapshot before traffic lands.
+      SSLSessionCacheManager::setPersistencePath(
+          accConfig_.sslCacheOptions.sessionPersistencePath);
+    }
+
     if (!sslCtxManager_) {
       sslCtxManager_ = std::make_unique<SSLContextManager>(
           "vip_" + getName(), accConfig_.strictSSL, stats);
@@ -130,6 +151,127 @@ void Acceptor::init(
   }
 }
 
+folly::Future<folly::Unit> Acceptor::initAsync(
+    AsyncServerSocket* serverSocket,
+    EventBase* eventBase,
+    folly::Executor* sslSetupExecutor,
+    SSLStats* stats,
+    std::shared_ptr<const fizz::server::FizzServerContext> fizzContext) {
+  if (!accConfig_.isSSL()) {
+    init(serverSocket, eventBase, stats);
+    return folly::makeFuture();
+  }
+
+  sslStats_ = stats;
+  serverSocket_ = serverSocket;
+  if (accConfig_.allowInsecureConnectionsOnSecureServer) {
+    securityProtocolCtxManager_.addPeeker(&tlsPlaintextPeekingCallback_);
+  }
+  if (accConfig_.fizzConfig.enableFizz) {
+    ticketSecrets_ = {
+        accConfig_.initialTicketSeeds.oldSeeds,
+        accConfig_.initialTicketSeeds.currentSeeds,
+        accConfig_.initialTicketSeeds.newSeeds};
+  }
+
+  // Accepting starts before the contexts exist. The TLS peekers are
+  // only registered once the contexts are ready, so until then TLS
+  // hellos fail the peek as unrecognized instead of crashing into a
+  // half-built context.
+  initDownstreamConnectionManager(eventBase);
+  if (serverSocket) {
+    serverSocket->addAcceptCallback(this, eventBase);
+
+    for (auto& fd : serverSocket->getNetworkSockets()) {
+      if (fd == folly::NetworkSocket()) {
+        continue;
+      }
+      for (const auto& opt : socketOptions_) {
+        opt.first.apply(fd, opt.second);
+      }
+    }
+  }
+
+  using BuiltContexts = std::tuple<
+      std::shared_ptr<SSLContextManager>,
+      std::shared_ptr<fizz::server::CertManager>,
+      std::shared_ptr<const fizz::server::FizzServerContext>>;
+  return folly::via(
+             sslSetupExecutor,
+             [this, stats, fizzContext = std::move(fizzContext)]() {
+               // All cert parsing happens here, off the acceptor
+               // thread. Only config and construction helpers are
+               // touched; no acceptor state is mutated until the swap
+               // below.
+               std::shared_ptr<SSLContextManager> ctxManager =
+                   sslCtxManager_;
+               if (!ctxManager) {
+                 ctxManager = std::make_shared<SSLContextManager>(
+                     "vip_" + getName(), accConfig_.strictSSL, stats);
+               }
+               try {
+                 if (ctxManager->getDefaultSSLCtx() == nullptr) {
+                   for (const auto& sslCtxConfig :
+                        accConfig_.sslContextConfigs) {
+                     ctxManager->addSSLContextConfig(
+                         sslCtxConfig,
+                         accConfig_.sslCacheOptions,
+                         &accConfig_.initialTicketSeeds,
+                         accConfig_.bindAddress,
+                         cacheProvider_);
+                   }
+                 }
+                 CHECK(ctxManager->getDefaultSSLCtx());
+               } catch (const std::runtime_error& ex) {
+                 if (accConfig_.strictSSL) {
+                   throw;
+                 }
+                 ctxManager->clear();
+                 LOG(INFO) << "Failed to configure TLS. This is not a "
+                           << "fatal error. " << ex.what();
+               }
+
+               std::shared_ptr<fizz::server::CertManager> certManager =
+                   fizzCertManager_;
+               auto context = fizzContext;
+               if (accConfig_.fizzConfig.enableFizz) {
+                 if (!certManager) {
+                   certManager = createFizzCertManager();
+                 }
+                 if (!context) {
+                   auto newContext = createFizzContext();
+                   if (newContext) {
+                     newContext->setCertManager(certManager);
+                     newContext->setTicketCipher(createFizzTicketCipher(
+                         ticketSecrets_,
+                         newContext->getFactoryPtr(),
+                         certManager,
+                         getPskContext()));
+                   }
+                   context = std::move(newContext);
+                 }
+               }
+               return BuiltContexts(
+                   std::move(ctxManager),
+                   std::move(certManager),
+                   std::move(context));
+             })
+      .via(eventBase)
+      .thenValue([this](BuiltContexts&& contexts) {
+        sslCtxManager_ = std::move(std::get<0>(contexts));
+        if (accConfig_.fizzConfig.enableFizz) {
+          fizzCertManager_ = std::move(std::get<1>(contexts));
+          auto* peeker = getFizzPeeker();
+          peeker->setContext(std::move(std::get<2>(contexts)));
+          peeker->options().setHandshakeRecordAlignedReads(
+              accConfig_.fizzConfig.preferKTLS);
+          securityProtocolCtxManager_.addPeeker(peeker);
+        } else {
+          securityProtocolCtxManager_.addPeeker(&defaultPeekingCallback_);
+        }
+      });
+}
+
 void Acceptor::initDownstreamConnectionManager(EventBase* eventBase) {
   CHECK(nullptr == this->base_ || eventBase == this->base_);
   base_ = eventBase;
@@ -271,10 +413,51 @@ void Acceptor::acceptConnection(
     return;
   }
   auto acceptTime = std::chrono::steady_clock::now();
+  if (info.timeBeforeEnqueue.time_since_epoch().count() > 0) {
+    auto queueDelay = std::chrono::duration_cast<std::chrono::microseconds>(
+        acceptTime - info.timeBeforeEnqueue);
+    constexpr double kAlpha = 0.25;
+    acceptQueueDelayEwmaUs_ = kAlpha * double(queueDelay.count()) +
+        (1.0 - kAlpha) * acceptQueueDelayEwmaUs_;
+    const auto& budget = accConfig_.acceptQueueDelayBudget;
+    if (budget.count() > 0 && queueDelay >= budget) {
+      // This connection already waited too long for this worker; a RST
+      // now gets the client retrying immediately instead of after a
+      // handshake timeout.
+      VLOG(2) << "shedding connection on " << accConfig_.name
+              << ": accept queue delay " << queueDelay.count()
+              << "us budget=" << budget.count() << "ms";
+      acceptQueueShed_++;
+      if (observer) {
+        observer->destroy(nullptr);
+      }
+      struct linger optLinger = {1, 0};
+      fsp::setsockopt(
+          fd, SOL_SOCKET, SO_LINGER, &optLinger, sizeof(optLinger));
+      close(fd);
+      return;
+    }
+  }
+  acceptQueueAccepted_++;
   for (const auto& opt : socketOptions_) {
     opt.first.apply(folly::NetworkSocket::fromFd(fd), opt.second);
   }
 
+  // Layer a per-workload option profile over the base options when the
+  // classifier picks one for this peer.
+  if (accConfig_.socketOptionProfileClassifier) {
+    auto profileName = accConfig_.socketOptionProfileClassifier(clientAddr);
+    if (!profileName.empty()) {
+      if (auto* profile = accConfig_.findSocketOptionProfile(profileName)) {
+        for (const auto& opt : *profile) {
+          opt.first.apply(folly::NetworkSocket::fromFd(fd), opt.second);
+        }
+      } else {
+        VLOG(4) << "Unknown socket option profile " << profileName;
+      }
+    }
+  }
+
   onDoneAcceptingConnection(fd, clientAddr, acceptTime, info, observer);
 }
 
@@ -284,8 +467,16 @@ void Acceptor::onDoneAcceptingConnection(
     std::chrono::steady_clock::time_point acceptTime,
     const AcceptInfo& info,
     folly::AsyncTransport::LifecycleObserver* observer) noexcept {
+  WANGLE_SDT(conn_accepted, fd);
   TransportInfo tinfo;
   tinfo.timeBeforeEnqueue = info.timeBeforeEnqueue;
+  // Decide the capture tier here, before any populating path runs;
+  // everything downstream (handshake helpers, initWithSocket) checks it.
+  if (accConfig_.transportInfoSampleRate > 1 &&
+      (transportInfoSampleCounter_++ % accConfig_.transportInfoSampleRate) !=
+          0) {
+    tinfo.captureLevel = TransportInfo::CaptureLevel::CORE;
+  }
   processEstablishedConnection(fd, clientAddr, acceptTime, tinfo, observer);
 }
 
@@ -319,10 +510,23 @@ void Acceptor::processEstablishedConnection(
       return;
     }
 
-    tinfo.tfoSucceded = sslSock->getTFOSucceded();
-    for (const auto& cb : observerList_.getAll()) {
-      cb->accept(sslSock.get());
+    if (handshakeRateLimiter_ && !handshakeRateLimiter_->admit(clientAddr)) {
+      VLOG(2) << "dropped SSL handshake on " << accConfig_.name
+              << " source prefix over full-handshake rate limit";
+      if (sslStats_) {
+        sslStats_->recordHandshakeRateLimited();
+      }
+      auto error = SSLErrorEnum::DROPPED;
+      auto latency = std::chrono::milliseconds(0);
+      auto ex = folly::make_exception_wrapper<SSLException>(
+          error, latency, sslSock->getRawBytesReceived());
+      updateSSLStats(sslSock.get(), latency, error, ex);
+      sslConnectionError(ex);
+      return;
     }
+
+    tinfo.tfoSucceded = sslSock->getTFOSucceded();
+    observerList_.notifyAccept(sslSock.get());
     startHandshakeManager(
         std::move(sslSock), this, clientAddr, acceptTime, tinfo);
   } else {
@@ -333,9 +537,7 @@ void Acceptor::processEstablishedConnection(
       sock->addLifecycleObserver(observer);
     }
     tinfo.tfoSucceded = sock->getTFOSucceded();
-    for (const auto& cb : observerList_.getAll()) {
-      cb->accept(sock.get());
-    }
+    observerList_.notifyAccept(sock.get());
     plaintextConnectionReady(std::move(sock), clientAddr, tinfo);
   }
 }
@@ -351,6 +553,107 @@ void Acceptor::startHandshakeManager(
   manager->start(std::move(sslSock));
 }
 
+folly::EventBase* Acceptor::getHandshakeOffloadEvb() {
+  if (!handshakeOffloadPool_) {
+    return nullptr;
+  }
+  // numPendingSSLConns_ already counts the handshake being started; with a
+  // threshold of 0 every handshake is offloaded.
+  if (numPendingSSLConns_ <= accConfig_.handshakeOffloadThreshold) {
+    return nullptr;
+  }
+  return handshakeOffloadPool_->getEventBase();
+}
+
+void Acceptor::recordHandshakeLatency(
+    std::chrono::milliseconds latency,
+    bool offloaded) noexcept {
+  if (sslStats_) {
+    sslStats_->recordSSLHandshakeLatency(latency.count(), offloaded);
+  }
+}
+
+Acceptor::ListenBacklog Acceptor::getListenBacklog() const {
+  ListenBacklog result;
+#if defined(__linux__)
+  if (!serverSocket_) {
+    return result;
+  }
+  for (const auto& fd : serverSocket_->getNetworkSockets()) {
+    if (fd == folly::NetworkSocket()) {
+      continue;
+    }
+    struct tcp_info info = {};
+    socklen_t len = sizeof(info);
+    if (folly::netops::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) ==
+        0) {
+      result.depth = std::max(result.depth, int32_t(info.tcpi_unacked));
+      result.limit = std::max(result.limit, int32_t(info.tcpi_sacked));
+    }
+  }
+#endif
+  return result;
+}
+
+Acceptor::AcceptQueueStats Acceptor::getAcceptQueueStats() const {
+  AcceptQueueStats stats;
+  stats.accepted = acceptQueueAccepted_;
+  stats.shedForDelay = acceptQueueShed_;
+  stats.smoothedDelay =
+      std::chrono::microseconds(int64_t(acceptQueueDelayEwmaUs_));
+  return stats;
+}
+
+void Acceptor::recordSetupLatency(milliseconds setupTime) {
+  if (accConfig_.acceptLatencyTarget.count() <= 0) {
+    return;
+  }
+  // A cheap smoothed estimate; it tracks the tail closely enough when
+  // breaches are sustained, which is the only case worth reacting to.
+  constexpr double kAlpha = 0.25;
+  acceptLatencyEwmaMs_ = kAlpha * double(setupTime.count()) +
+      (1.0 - kAlpha) * acceptLatencyEwmaMs_;
+  if (!acceptPaused_ &&
+      acceptLatencyEwmaMs_ > double(accConfig_.acceptLatencyTarget.count())) {
+    pauseAcceptingForBackoff();
+  }
+}
+
+void Acceptor::pauseAcceptingForBackoff() {
+  if (!serverSocket_ || state_ != State::kRunning) {
+    return;
+  }
+  VLOG(2) << "accept governor pausing accepts on " << accConfig_.name
+          << ": setup latency ewma=" << acceptLatencyEwmaMs_
+          << "ms target=" << accConfig_.acceptLatencyTarget.count() << "ms";
+  acceptPaused_ = true;
+  auto socket = serverSocket_;
+  socket->getEventBase()->runInEventBaseThread(
+      [socket] { socket->pauseAccepting(); });
+  if (!acceptResumeTimeout_) {
+    acceptResumeTimeout_ =
+        folly::AsyncTimeout::make(*base_, [this]() noexcept {
+          tryResumeAccepting();
+        });
+  }
+  acceptResumeTimeout_->scheduleTimeout(accConfig_.acceptPauseDuration);
+}
+
+void Acceptor::tryResumeAccepting() {
+  auto backlog = getListenBacklog();
+  if (backlog.limit > 0 && backlog.depth > backlog.limit / 2) {
+    // The kernel queue is still mostly full; let it keep absorbing (and
+    // shedding) SYNs a while longer.
+    acceptResumeTimeout_->scheduleTimeout(accConfig_.acceptPauseDuration);
+    return;
+  }
+  acceptPaused_ = false;
+  acceptLatencyEwmaMs_ = 0;
+  auto socket = serverSocket_;
+  socket->getEventBase()->runInEventBaseThread(
+      [socket] { socket->resumeAccepting(); });
+}
+
 static std::string logContext(folly::AsyncTransport& transport) {
   std::string localAddr;
   std::string remoteAddr;
@@ -387,16 +690,25 @@ AsyncTransport::UniquePtr Acceptor::transformTransport(
       if (!fizzSocket) {
         VLOG(5) << "Acceptor configured to prefer kTLS, but peer is not fizz. "
                 << sockLogContext;
+        if (sslStats_) {
+          sslStats_->recordKTLSOffload(false);
+        }
         return sock;
       }
       auto ktlsSockResult = fizz::tryConvertKTLS(*fizzSocket);
       if (ktlsSockResult.hasValue()) {
         VLOG(5) << "Upgraded socket to kTLS. " << sockLogContext;
+        if (sslStats_) {
+          sslStats_->recordKTLSOffload(true);
+        }
         return std::move(ktlsSockResult).value();
       } else {
         VLOG(5) << "Failed to upgrade to kTLS. ex="
                 << folly::exceptionStr(ktlsSockResult.error()) << " "
                 << sockLogContext;
+        if (sslStats_) {
+          sslStats_->recordKTLSOffload(false);
+        }
         return sock;
       }
     }
@@ -422,11 +734,14 @@ void Acceptor::connectionReady(
   asyncSocket->setMaxReadsPerEvent(accConfig_.socketMaxReadsPerEvent);
   tinfo.initWithSocket(asyncSocket);
   tinfo.appProtocol = std::make_shared<std::string>(nextProtocolName);
-
-  for (const auto& cb : observerList_.getAll()) {
-    cb->ready(sock.get());
+  if (tinfo.acceptTime != std::chrono::steady_clock::time_point()) {
+    tinfo.setupTime = std::chrono::duration_cast<milliseconds>(
+        std::chrono::steady_clock::now() - tinfo.acceptTime);
+    recordSetupLatency(tinfo.setupTime);
   }
 
+  observerList_.notifyReady(sock.get());
+
   folly::AsyncTransport::UniquePtr transformed =
       transformTransport(std::move(sock));
 
@@ -454,8 +769,29 @@ void Acceptor::sslConnectionReady(
     TransportInfo& tinfo) {
   CHECK(numPendingSSLConns_ > 0);
   --numPendingSSLConns_;
+  // Resumed handshakes are exempt from per-source admission control,
+  // but resumption is only known now; return their admission.
+  if (handshakeRateLimiter_ &&
+      (tinfo.sslResume == SSLResumeEnum::RESUME_SESSION_ID ||
+       tinfo.sslResume == SSLResumeEnum::RESUME_TICKET)) {
+    handshakeRateLimiter_->refund(clientAddr);
+  }
+  if (tenantQuotaEnforcer_ && tinfo.sslServerName &&
+      !tenantQuotaEnforcer_->admit(*tinfo.sslServerName)) {
+    VLOG(2) << "dropped connection on " << accConfig_.name << " tenant "
+            << *tinfo.sslServerName << " over quota";
+    sock->closeWithReset();
+    if (state_ == State::kDraining) {
+      checkDrained();
+    }
+    return;
+  }
   connectionReady(
       std::move(sock), clientAddr, nextProtocol, secureTransportType, tinfo);
+  if (tenantQuotaEnforcer_) {
+    // If no connection materialized the admission's lease goes back.
+    tenantQuotaEnforcer_->releaseUnbound();
+  }
   if (state_ == State::kDraining) {
     checkDrained();
   }
@@ -543,13 +879,13 @@ void Acceptor::forceStop() {
   base_->runInEventBaseThread([&] { dropAllConnections(); });
 }
 
-void Acceptor::dropAllConnections() {
+void Acceptor::dropAllConnections(bool dropHard) {
   if (downstreamConnectionManager_) {
     VLOG(3) << "Dropping all connections from Acceptor=" << this
             << " in thread " << base_;
     assert(base_->isInEventBaseThread());
     forceShutdownInProgress_ = true;
-    downstreamConnectionManager_->dropAllConnections();
+    downstreamConnectionManager_->dropAllConnections(dropHard);
     CHECK(downstreamConnectionManager_->getNumConnections() == 0);
     downstreamConnectionManager_.reset();
   }
@@ -576,29 +912,94 @@ Acceptor::AcceptObserverList::AcceptObserverList(Acceptor* acceptor)
     : acceptor_(acceptor) {}
 
 Acceptor::AcceptObserverList::~AcceptObserverList() {
-  for (const auto& cb : observers_) {
-    cb->acceptorDestroy(acceptor_);
+  // deliver any counts accumulated since the last flush before the
+  // observers hear about the destruction
+  if (pendingAccepted_ > 0 || pendingReady_ > 0) {
+    runLoopCallback();
+  }
+  for (const auto& entry : observers_) {
+    entry.observer->acceptorDestroy(acceptor_);
   }
 }
 
 void Acceptor::AcceptObserverList::add(AcceptObserver* observer) {
   // adding the same observer multiple times is not allowed
   CHECK(
-      std::find(observers_.begin(), observers_.end(), observer) ==
+      std::find_if(
+          observers_.begin(),
+          observers_.end(),
+          [&](const Entry& entry) { return entry.observer == observer; }) ==
       observers_.end());
 
-  observers_.emplace_back(observer);
+  Entry entry;
+  entry.observer = observer;
+  // a sampling rate of 0 makes no sense; treat it as "every connection"
+  entry.sampleRate = std::max(observer->getSampleRate(), 1u);
+  entry.batched = observer->preferBatchedEvents();
+  if (entry.batched) {
+    ++numBatched_;
+  }
+  observers_.push_back(entry);
   observer->observerAttach(acceptor_);
 }
 
 bool Acceptor::AcceptObserverList::remove(AcceptObserver* observer) {
-  const auto it = std::find(observers_.begin(), observers_.end(), observer);
+  const auto it = std::find_if(
+      observers_.begin(), observers_.end(), [&](const Entry& entry) {
+        return entry.observer == observer;
+      });
   if (it == observers_.end()) {
     return false;
   }
+  if (it->batched) {
+    --numBatched_;
+  }
   observer->observerDetach(acceptor_);
   observers_.erase(it);
   return true;
 }
 
+void Acceptor::AcceptObserverList::notifyAccept(AsyncTransport* transport) {
+  if (numBatched_ > 0) {
+    ++pendingAccepted_;
+    scheduleFlush();
+  }
+  for (auto& entry : observers_) {
+    if (!entry.batched && entry.acceptCount++ % entry.sampleRate == 0) {
+      entry.observer->accept(transport);
+    }
+  }
+}
+
+void Acceptor::AcceptObserverList::notifyReady(AsyncTransport* transport) {
+  if (numBatched_ > 0) {
+    ++pendingReady_;
+    scheduleFlush();
+  }
+  for (auto& entry : observers_) {
+    if (!entry.batched && entry.readyCount++ % entry.sampleRate == 0) {
+      entry.observer->ready(transport);
+    }
+  }
+}
+
+void Acceptor::AcceptObserverList::scheduleFlush() {
+  if (!isLoopCallbackScheduled()) {
+    acceptor_->base_->runInLoop(this, true /* thisIteration */);
+  }
+}
+
+void Acceptor::AcceptObserverList::runLoopCallback() noexcept {
+  AcceptEventBatch batch;
+  batch.accepted = pendingAccepted_;
+  batch.ready = pendingReady_;
+  pendingAccepted_ = 0;
+  pendingReady_ = 0;
+  for (auto& entry : observers_) {
+    if (entry.batched) {
+      entry.observer->onEventBatch(batch);
+    }
+  }
+}
+
 } // namespace wangle
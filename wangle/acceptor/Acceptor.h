@@ -18,22 +18,28 @@
 
 #include <wangle/acceptor/ConnectionManager.h>
 #include <wangle/acceptor/FizzAcceptorHandshakeHelper.h>
+#include <wangle/acceptor/HandshakeRateLimiter.h>
 #include <wangle/acceptor/LoadShedConfiguration.h>
 #include <wangle/acceptor/SSLAcceptorHandshakeHelper.h>
 #include <wangle/acceptor/SecureTransportType.h>
 #include <wangle/acceptor/SecurityProtocolContextManager.h>
 #include <wangle/acceptor/ServerSocketConfig.h>
 #include <wangle/acceptor/TLSPlaintextPeekingCallback.h>
+#include <wangle/acceptor/TenantQuotaManager.h>
 
 #include <wangle/acceptor/TransportInfo.h>
 #include <wangle/ssl/SSLCacheProvider.h>
 #include <wangle/ssl/SSLStats.h>
 
 #include <folly/ExceptionWrapper.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/futures/Future.h>
 #include <folly/io/SocketOptionMap.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/AsyncUDPServerSocket.h>
+#include <folly/io/async/EventBase.h>
 #include <chrono>
 
 namespace wangle {
@@ -110,6 +116,29 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
       std::shared_ptr<const fizz::server::FizzServerContext> fizzContext =
           nullptr);
 
+  /**
+   * Like init(), but builds the SSL contexts on sslSetupExecutor
+   * instead of serially on the acceptor thread. Cert parsing dominates
+   * init() time on large cert sets, so this lets every acceptor start
+   * accepting immediately: plaintext connections are served from the
+   * first loop when allowInsecureConnectionsOnSecureServer is set,
+   * while TLS handshakes are rejected as unrecognized until the
+   * completed contexts are swapped in on the event base thread.
+   *
+   * The returned future completes on eventBase once the acceptor is
+   * fully TLS-capable (immediately for plain acceptors). With
+   * strictSSL, a context construction failure surfaces through the
+   * future instead of being thrown from init(). The acceptor must stay
+   * alive until the future completes.
+   */
+  virtual folly::Future<folly::Unit> initAsync(
+      folly::AsyncServerSocket* serverSocket,
+      folly::EventBase* eventBase,
+      folly::Executor* sslSetupExecutor,
+      SSLStats* stats = nullptr,
+      std::shared_ptr<const fizz::server::FizzServerContext> fizzContext =
+          nullptr);
+
   /**
    * Recreates ssl configs, re-reads certs
    */
@@ -191,6 +220,83 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
     return accConfig_.sslHandshakeTimeout;
   }
 
+  /**
+   * Sets a pool of handshake threads shared by this acceptor.  When set,
+   * handshakes spill over to the pool (via EvbHandshakeHelper) once the
+   * number of handshakes pending on this acceptor exceeds
+   * handshakeOffloadThreshold in the config; below that they run inline on
+   * the acceptor's own EventBase.  The pool is sized independently of the
+   * IO threads and may be shared across acceptors.
+   */
+  void setHandshakeOffloadPool(
+      std::shared_ptr<folly::IOThreadPoolExecutor> pool) {
+    handshakeOffloadPool_ = std::move(pool);
+  }
+
+  /**
+   * Returns the EventBase the next handshake should be performed on, or
+   * nullptr to run it inline on the acceptor's EventBase.  Non-null only
+   * when an offload pool is set and this acceptor's handshake backlog
+   * exceeds the configured spillover threshold.
+   */
+  folly::EventBase* getHandshakeOffloadEvb();
+
+  /**
+   * Records the latency of a completed handshake, split by whether it ran
+   * inline or was offloaded to the handshake pool.
+   */
+  void recordHandshakeLatency(
+      std::chrono::milliseconds latency,
+      bool offloaded) noexcept;
+
+  /**
+   * The security protocol dispatch for this acceptor. Exposed so
+   * handshake stack sampling can be configured, ramped, and read out
+   * at run time; access it on the acceptor's thread.
+   */
+  SecurityProtocolContextManager& getSecurityProtocolContextManager() {
+    return securityProtocolCtxManager_;
+  }
+
+  /**
+   * Installs per-tenant (SNI-keyed) admission quotas. The pool is
+   * shared by every acceptor serving the tenant set; this acceptor
+   * builds its own lock-free enforcer on it. Call before the acceptor
+   * starts serving traffic.
+   */
+  void setTenantQuotaPool(std::shared_ptr<TenantQuotaPool> pool) {
+    tenantQuotaEnforcer_ =
+        std::make_unique<TenantQuotaEnforcer>(std::move(pool));
+  }
+
+  /**
+   * A snapshot of the kernel listen queue for this acceptor's server
+   * socket, sampled via TCP_INFO (for listening sockets the kernel reports
+   * the backlog depth and limit in tcpi_unacked and tcpi_sacked).  Both
+   * fields are -1 when the socket is missing or the platform does not
+   * support the query.
+   */
+  struct ListenBacklog {
+    int32_t depth{-1};
+    int32_t limit{-1};
+  };
+  ListenBacklog getListenBacklog() const;
+
+  /**
+   * Per-worker accept-queue statistics.  Delay is measured from the
+   * listener thread enqueueing a connection to this acceptor picking it
+   * up on its EventBase; smoothedDelay is an EWMA of that wait.
+   * Connections whose wait exceeded acceptQueueDelayBudget are counted
+   * in shedForDelay (see ServerSocketConfig).  Read on the acceptor's
+   * thread.
+   */
+  struct AcceptQueueStats {
+    uint64_t accepted{0};
+    uint64_t shedForDelay{0};
+    std::chrono::microseconds smoothedDelay{std::chrono::microseconds(0)};
+  };
+  AcceptQueueStats getAcceptQueueStats() const;
+
   /**
    * Time after drainAllConnections() or acceptStopped() during which
    * new requests on connections owned by the downstream
@@ -267,9 +373,11 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
    * Drop all connections.
    *
    * forceStop() schedules dropAllConnections() to be called in the acceptor's
-   * thread.
+   * thread.  With dropHard, connections are torn down in bulk without
+   * per-connection close notification; see
+   * ConnectionManager::dropAllConnections(bool).
    */
-  void dropAllConnections();
+  void dropAllConnections(bool dropHard = false);
 
   /**
    * Force-drop "pct" (0.0 to 1.0) of remaining client connections,
@@ -280,6 +388,20 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
    */
   virtual void dropConnections(double pctToDrop);
 
+  /**
+   * Migrate up to maxConns connections that have been idle for at least
+   * minIdle to the target acceptor's EventBase, for IO-thread
+   * rebalancing. Must be called on this acceptor's EventBase; returns
+   * the number of connections actually migrated. The base
+   * implementation migrates nothing; ServerAcceptor overrides it.
+   */
+  virtual size_t migrateConnectionsTo(
+      Acceptor* /* target */,
+      size_t /* maxConns */,
+      std::chrono::milliseconds /* minIdle */) {
+    return 0;
+  }
+
   /**
    * Wrapper for connectionReady() that can be overridden by
    * subclasses to deal with plaintext connections.
@@ -393,13 +515,18 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
    *                              or an empty string if unknown
    * @param secureTransportType the name of the secure transport type that was
    *                            requested by the client.
+   * @param tinfo               transport properties gathered during accept and
+   *                              handshake. The referenced object is owned by
+   *                              the accept path and dies when this call
+   *                              returns, so implementations that keep the
+   *                              info may move from it instead of copying.
    */
   virtual void onNewConnection(
       folly::AsyncTransport::UniquePtr /*sock*/,
       const folly::SocketAddress* /*address*/,
       const std::string& /*nextProtocolName*/,
       SecureTransportType /*secureTransportType*/,
-      const TransportInfo& /*tinfo*/) {}
+      TransportInfo& /*tinfo*/) {}
 
   void onListenStarted() noexcept override {}
   void onListenStopped() noexcept override {}
@@ -463,8 +590,16 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
 
   // ConnectionManager::Callback methods
   void onEmpty(const wangle::ConnectionManager& cm) override;
-  void onConnectionAdded(const ManagedConnection*) override {}
-  void onConnectionRemoved(const ManagedConnection*) override {}
+  void onConnectionAdded(const ManagedConnection* conn) override {
+    if (tenantQuotaEnforcer_) {
+      tenantQuotaEnforcer_->onConnectionAdded(conn);
+    }
+  }
+  void onConnectionRemoved(const ManagedConnection* conn) override {
+    if (tenantQuotaEnforcer_) {
+      tenantQuotaEnforcer_->onConnectionRemoved(conn);
+    }
+  }
 
   const ServerSocketConfig accConfig_;
 
@@ -523,21 +658,50 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
 
   void checkDrained();
 
+  /**
+   * Accept governor: feeds the accept-to-active latency recorded in
+   * connectionReady() into a smoothed estimate and pauses accepting for
+   * acceptPauseDuration once it breaches acceptLatencyTarget, so the
+   * kernel backlog absorbs the overload instead of the handshake queue.
+   */
+  void recordSetupLatency(std::chrono::milliseconds setupTime);
+  void pauseAcceptingForBackoff();
+  void tryResumeAccepting();
+
   State state_{State::kInit};
   uint64_t numPendingSSLConns_{0};
+  // Rolling position in the 1-in-N TransportInfo full-capture sample;
+  // only touched on the acceptor's EventBase.
+  uint64_t transportInfoSampleCounter_{0};
+
+  std::shared_ptr<folly::IOThreadPoolExecutor> handshakeOffloadPool_;
+  SSLStats* sslStats_{nullptr};
+  std::unique_ptr<HandshakeRateLimiter> handshakeRateLimiter_;
+  std::unique_ptr<TenantQuotaEnforcer> tenantQuotaEnforcer_;
+
+  folly::AsyncServerSocket* serverSocket_{nullptr};
+  double acceptLatencyEwmaMs_{0};
+  bool acceptPaused_{false};
+  std::unique_ptr<folly::AsyncTimeout> acceptResumeTimeout_;
+
+  uint64_t acceptQueueAccepted_{0};
+  uint64_t acceptQueueShed_{0};
+  double acceptQueueDelayEwmaUs_{0};
 
   bool forceShutdownInProgress_{false};
   std::chrono::milliseconds gracefulShutdownTimeout_{5000};
 
-  // Wrapper around list of AcceptObservers to handle cleanup on destruction
-  class AcceptObserverList {
+  // Wrapper around list of AcceptObservers that handles cleanup on
+  // destruction as well as each observer's sampling rate and batching
+  // preference (see AcceptObserver).
+  class AcceptObserverList : private folly::EventBase::LoopCallback {
    public:
     explicit AcceptObserverList(Acceptor* acceptor);
 
     /**
      * Destructor, triggers observerDetach for any attached observers.
      */
-    ~AcceptObserverList();
+    ~AcceptObserverList() override;
 
     /**
      * Add observer and trigger observerAttach.
@@ -550,15 +714,36 @@ class Acceptor : public folly::AsyncServerSocket::AcceptCallback,
     bool remove(AcceptObserver* observer);
 
     /**
-     * Get reference to vector containing observers.
+     * Deliver accept() to per-connection observers due for a sample and
+     * count the event for batched observers.
      */
-    const std::vector<AcceptObserver*>& getAll() const {
-      return observers_;
-    }
+    void notifyAccept(folly::AsyncTransport* transport);
+
+    /**
+     * Deliver ready() to per-connection observers due for a sample and
+     * count the event for batched observers.
+     */
+    void notifyReady(folly::AsyncTransport* transport);
 
    private:
+    struct Entry {
+      AcceptObserver* observer{nullptr};
+      // Cached at attach; see AcceptObserver::getSampleRate.
+      uint32_t sampleRate{1};
+      uint32_t acceptCount{0};
+      uint32_t readyCount{0};
+      bool batched{false};
+    };
+
+    // Schedules batch delivery for the end of the current loop iteration.
+    void scheduleFlush();
+    void runLoopCallback() noexcept override;
+
     Acceptor* acceptor_{nullptr};
-    std::vector<AcceptObserver*> observers_;
+    std::vector<Entry> observers_;
+    size_t numBatched_{0};
+    uint64_t pendingAccepted_{0};
+    uint64_t pendingReady_{0};
   };
 
   // List of AcceptObservers
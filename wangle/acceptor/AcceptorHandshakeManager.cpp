@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <folly/io/async/AsyncSocket.h>
 #include <wangle/acceptor/Acceptor.h>
 #include <wangle/acceptor/AcceptorHandshakeManager.h>
+#include <wangle/acceptor/EvbHandshakeHelper.h>
+#include <wangle/util/Tracepoints.h>
 
 namespace wangle {
 
@@ -63,6 +66,22 @@ void AcceptorHandshakeManager::connectionReady(
             transport->getRawBytesReceived()));
   }
   acceptor_->getConnectionManager()->removeConnection(this);
+  acceptor_->recordHandshakeLatency(timeSinceAcceptMs(), offloaded_);
+  if (!tinfo_.handshakeStack.empty()) {
+    acceptor_->getSecurityProtocolContextManager().recordHandshakeResult(
+        tinfo_.handshakeStack, timeSinceAcceptMs(), true);
+  }
+  if (WANGLE_SDT_ENABLED(handshake_success)) {
+    // The fd joins this connection to its conn_accepted probe; the
+    // transport pointer is the id every later stage's probe carries.
+    int fd = -1;
+    if (auto* sock =
+            transport->getUnderlyingTransport<folly::AsyncSocket>()) {
+      fd = sock->getNetworkSocket().toFd();
+    }
+    WANGLE_SDT_WITH_SEMAPHORE(
+        handshake_success, fd, transport.get(), timeSinceAcceptMs().count());
+  }
   // We pass TransportInfo by reference even though we're about to destroy it,
   // so lets hope that anything saving it makes a copy!
   acceptor_->sslConnectionReady(
@@ -83,10 +102,25 @@ void AcceptorHandshakeManager::connectionError(
         transport, timeSinceAcceptMs(), sslErr.value(), ex);
   }
   acceptor_->getConnectionManager()->removeConnection(this);
+  if (!tinfo_.handshakeStack.empty()) {
+    acceptor_->getSecurityProtocolContextManager().recordHandshakeResult(
+        tinfo_.handshakeStack, timeSinceAcceptMs(), false);
+  }
   acceptor_->sslConnectionError(std::move(ex));
   destroy();
 }
 
+AcceptorHandshakeHelper::UniquePtr AcceptorHandshakeManager::maybeOffloadHelper(
+    AcceptorHandshakeHelper::UniquePtr helper) {
+  auto* handshakeEvb = acceptor_->getHandshakeOffloadEvb();
+  if (!handshakeEvb) {
+    return helper;
+  }
+  offloaded_ = true;
+  return AcceptorHandshakeHelper::UniquePtr(
+      new EvbHandshakeHelper(std::move(helper), handshakeEvb));
+}
+
 std::chrono::milliseconds AcceptorHandshakeManager::timeSinceAcceptMs() const {
   return std::chrono::duration_cast<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - acceptTime_);
@@ -260,6 +260,15 @@ class AcceptorHandshakeManager : public ManagedConnection,
 
   virtual void startHelper(folly::AsyncSSLSocket::UniquePtr sock) = 0;
 
+  /**
+   * Wraps the given helper in an EvbHandshakeHelper when the acceptor
+   * decides this handshake should be offloaded (see
+   * Acceptor::getHandshakeOffloadEvb); returns it unchanged otherwise.
+   * Subclasses should pass their helper through this before starting it.
+   */
+  AcceptorHandshakeHelper::UniquePtr maybeOffloadHelper(
+      AcceptorHandshakeHelper::UniquePtr helper);
+
   void startHandshakeTimeout();
 
   Acceptor* acceptor_;
@@ -267,6 +276,7 @@ class AcceptorHandshakeManager : public ManagedConnection,
   std::chrono::steady_clock::time_point acceptTime_;
   TransportInfo tinfo_;
   AcceptorHandshakeHelper::UniquePtr helper_;
+  bool offloaded_{false};
 };
 
 } // namespace wangle
@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 
 namespace wangle {
 
@@ -68,4 +71,158 @@ class SimpleConnectionCounter : public IConnectionCounter {
   uint64_t numConnections_{0};
 };
 
+/**
+ * A process-wide pool of connection leases shared by many Acceptors.
+ *
+ * Enforcing one global connection cap with a single shared counter puts
+ * a contended atomic on every accept; splitting the cap statically
+ * across Acceptors strands headroom on the quiet ones. The pool sits in
+ * between: Acceptor-local counters draw leases from it in batches, so
+ * the pool's atomic is only touched once per batch and the global cap
+ * still holds exactly (admissions never exceed maxConnections; at most
+ * the cap is reached a batch early per Acceptor while cached leases sit
+ * unused).
+ *
+ * A maxConnections of zero means "unlimited": every acquire succeeds.
+ * getNumConnections() reports leases handed out, which includes leases
+ * cached by counters but not yet backing a connection.
+ */
+class ConnectionLeasePool {
+ public:
+  explicit ConnectionLeasePool(uint64_t maxConnections)
+      : maxConnections_(maxConnections) {}
+
+  /**
+   * Take up to `want` leases from the pool. Returns the number granted,
+   * which is zero once the pool is exhausted. Lock-free.
+   */
+  uint64_t acquire(uint64_t want) {
+    if (maxConnections_ == 0) {
+      leased_.fetch_add(want, std::memory_order_relaxed);
+      return want;
+    }
+    auto cur = leased_.load(std::memory_order_relaxed);
+    uint64_t take;
+    do {
+      if (cur >= maxConnections_) {
+        return 0;
+      }
+      take = std::min(want, maxConnections_ - cur);
+    } while (!leased_.compare_exchange_weak(
+        cur, cur + take, std::memory_order_relaxed));
+    return take;
+  }
+
+  void release(uint64_t count) {
+    leased_.fetch_sub(count, std::memory_order_relaxed);
+  }
+
+  uint64_t getMaxConnections() const {
+    return maxConnections_;
+  }
+
+  uint64_t getNumConnections() const {
+    return leased_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const uint64_t maxConnections_;
+  std::atomic<uint64_t> leased_{0};
+};
+
+/**
+ * Per-Acceptor view of a ConnectionLeasePool. Not thread-safe on its
+ * own (like SimpleConnectionCounter, each Acceptor owns one and uses it
+ * from its event base); cross-Acceptor coordination happens through the
+ * shared pool.
+ *
+ * tryAcquire() is the admission check: in the common case it is a plain
+ * decrement of the local lease cache, refilling a batch from the pool
+ * only when the cache runs dry. onConnectionRemoved() returns leases to
+ * the cache and hands a batch back to the pool once the cache grows to
+ * twice the batch size, so leases flow toward busy Acceptors instead of
+ * pooling on idle ones.
+ */
+class HierarchicalConnectionCounter : public IConnectionCounter {
+ public:
+  explicit HierarchicalConnectionCounter(
+      std::shared_ptr<ConnectionLeasePool> pool,
+      uint64_t batchSize = 64)
+      : pool_(std::move(pool)), batchSize_(std::max<uint64_t>(1, batchSize)) {}
+
+  ~HierarchicalConnectionCounter() override {
+    // Leases backing still-open connections go back too; the pool's
+    // count must not leak when an Acceptor is torn down.
+    auto held = cachedLeases_ + numConnections_ - leaseDebt_;
+    if (held > 0) {
+      pool_->release(held);
+    }
+  }
+
+  /**
+   * Admit a connection if the global cap allows it. Callers that
+   * enforce the cap should gate the accept on this and only then call
+   * onConnectionAdded(); an admitted slot is held until
+   * onConnectionRemoved().
+   */
+  bool tryAcquire() {
+    if (cachedLeases_ == 0) {
+      cachedLeases_ = pool_->acquire(batchSize_);
+    }
+    if (cachedLeases_ == 0) {
+      return false;
+    }
+    cachedLeases_--;
+    acquired_ = true;
+    return true;
+  }
+
+  uint64_t getNumConnections() const override {
+    return numConnections_;
+  }
+
+  uint64_t getMaxConnections() const override {
+    return pool_->getMaxConnections();
+  }
+
+  void onConnectionAdded() override {
+    if (!acquired_ && !tryAcquire()) {
+      // Added without an admission check and the pool is dry: count
+      // the connection anyway and settle the lease on removal.
+      leaseDebt_++;
+    }
+    acquired_ = false;
+    numConnections_++;
+  }
+
+  void onConnectionRemoved() override {
+    numConnections_--;
+    if (leaseDebt_ > 0) {
+      leaseDebt_--;
+      return;
+    }
+    cachedLeases_++;
+    if (cachedLeases_ >= 2 * batchSize_) {
+      cachedLeases_ -= batchSize_;
+      pool_->release(batchSize_);
+    }
+  }
+
+  uint64_t getCachedLeases() const {
+    return cachedLeases_;
+  }
+
+ protected:
+  std::shared_ptr<ConnectionLeasePool> pool_;
+  const uint64_t batchSize_;
+  uint64_t cachedLeases_{0};
+  uint64_t numConnections_{0};
+  // Connections counted past the cap (added without a tryAcquire when
+  // the pool was exhausted).
+  uint64_t leaseDebt_{0};
+  // Set by tryAcquire so the following onConnectionAdded doesn't take
+  // a second lease for the same connection.
+  bool acquired_{false};
+};
+
 } // namespace wangle
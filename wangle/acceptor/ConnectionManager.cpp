@@ -20,10 +20,35 @@
 #include <folly/io/async/EventBase.h>
 #include <glog/logging.h>
 #include <wangle/acceptor/ManagedConnection.h>
+#include <algorithm>
 #include <chrono>
 
 using std::chrono::milliseconds;
 
+namespace {
+
+constexpr size_t kDrainChunkSize = 64;
+// With a time budget, poll the clock every few connections and guarantee
+// a minimum chunk so a saturated loop cannot stall the drain entirely.
+constexpr size_t kDrainClockCheckInterval = 8;
+constexpr std::chrono::microseconds kMinDrainChunkBudget{50};
+
+bool drainChunkHasBudget(
+    size_t processed,
+    std::chrono::steady_clock::time_point chunkStart,
+    std::chrono::microseconds budget) {
+  if (budget.count() == 0) {
+    return processed < kDrainChunkSize;
+  }
+  if (processed < kDrainClockCheckInterval ||
+      processed % kDrainClockCheckInterval != 0) {
+    return true;
+  }
+  return std::chrono::steady_clock::now() - chunkStart < budget;
+}
+
+} // namespace
+
 namespace wangle {
 
 ConnectionManager::ConnectionManager(
@@ -80,7 +105,12 @@ void ConnectionManager::addConnection(
     scheduleTimeout(connection, idleTimeout_);
   }
   if (connectionAgeTimeout) {
-    scheduleTimeout(&connection->connectionAgeTimeout_, connectionAgeTimeout_);
+    if (!connection->connectionAgeTimeout_) {
+      connection->connectionAgeTimeout_ =
+          std::make_unique<ConnectionAgeTimeout>(*connection);
+    }
+    scheduleTimeout(
+        connection->connectionAgeTimeout_.get(), connectionAgeTimeout_);
   }
 
   if (drainHelper_.getShutdownState() >=
@@ -111,27 +141,120 @@ void ConnectionManager::scheduleTimeout(
     ConnectionAgeTimeout* connection,
     std::chrono::milliseconds timeout) {
   if (timeout > std::chrono::milliseconds(0)) {
-    eventBase_->timer().scheduleTimeout(connection, timeout);
+    wheel().scheduleTimeout(connection, timeout);
   }
 }
 
 void ConnectionManager::scheduleTimeout(
     ManagedConnection* const connection,
     std::chrono::milliseconds timeout) {
-  if (timeout > std::chrono::milliseconds(0)) {
-    eventBase_->timer().scheduleTimeout(connection, timeout);
+  if (timeout <= std::chrono::milliseconds(0)) {
+    return;
   }
+  if (idleBucketGranularity_ > std::chrono::milliseconds(0) &&
+      timeout <= idleTimeout_) {
+    scheduleCoalescedTimeout(connection, timeout);
+    return;
+  }
+  wheel().scheduleTimeout(connection, timeout);
 }
 
 void ConnectionManager::scheduleTimeout(
     folly::HHWheelTimer::Callback* callback,
     std::chrono::milliseconds timeout) {
-  eventBase_->timer().scheduleTimeout(callback, timeout);
+  wheel().scheduleTimeout(callback, timeout);
+}
+
+void ConnectionManager::setCoalescedIdleTimeouts(
+    std::chrono::milliseconds granularity) {
+  CHECK_GT(granularity.count(), 0);
+  CHECK(idleBuckets_.empty());
+  idleBucketGranularity_ = granularity;
+  // Room for every slot the default idle timeout can land in, plus slack
+  // so a freshly filed deadline never wraps onto the slot being scanned.
+  idleBuckets_.resize(idleTimeout_ / granularity + 2);
+  lastScannedIdleSlot_ = idleSlotOf(std::chrono::steady_clock::now());
+}
+
+uint64_t ConnectionManager::idleSlotOf(
+    std::chrono::steady_clock::time_point tp) const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             tp.time_since_epoch()) /
+      idleBucketGranularity_;
+}
+
+void ConnectionManager::scheduleCoalescedTimeout(
+    ManagedConnection* const connection,
+    std::chrono::milliseconds timeout) {
+  auto now = std::chrono::steady_clock::now();
+  connection->idleBucketDeadline_ = now + timeout;
+  if (connection->idleBucketHook_.is_linked()) {
+    // Already tracked: the deadline store above is the whole cost of the
+    // reschedule. The scanner re-files the connection when the bucket it
+    // was originally filed in comes up.
+    return;
+  }
+  // The connection may carry a wheel timeout from before coalescing was
+  // enabled or from an oversized resetTimeoutTo; the ring replaces it.
+  connection->cancelTimeout();
+  if (idleBucketCount_ == 0) {
+    // Nothing has kept the scanner running; skip the slots that went by
+    // while the ring was empty.
+    lastScannedIdleSlot_ = std::max(lastScannedIdleSlot_, idleSlotOf(now));
+  }
+  auto slot = idleSlotOf(connection->idleBucketDeadline_);
+  idleBuckets_[slot % idleBuckets_.size()].push_back(*connection);
+  idleBucketCount_++;
+  ensureIdleScanScheduled();
+}
+
+void ConnectionManager::unlinkIdleBucket(ManagedConnection* connection) {
+  if (connection->idleBucketHook_.is_linked()) {
+    connection->idleBucketHook_.unlink();
+    idleBucketCount_--;
+  }
+}
+
+void ConnectionManager::ensureIdleScanScheduled() {
+  if (idleBucketCount_ > 0 && !idleScanner_.isScheduled()) {
+    wheel().scheduleTimeout(&idleScanner_, idleBucketGranularity_);
+  }
+}
+
+void ConnectionManager::scanIdleBuckets() {
+  DestructorGuard g(this);
+  const auto nowSlot = idleSlotOf(std::chrono::steady_clock::now());
+  // The loop may have stalled past several ticks; catch up one bucket at
+  // a time so no slot is skipped.
+  while (lastScannedIdleSlot_ < nowSlot) {
+    const auto slot = ++lastScannedIdleSlot_;
+    auto& bucket = idleBuckets_[slot % idleBuckets_.size()];
+    while (!bucket.empty()) {
+      auto& conn = bucket.front();
+      bucket.pop_front();
+      const auto deadlineSlot = idleSlotOf(conn.idleBucketDeadline_);
+      if (deadlineSlot <= slot) {
+        idleBucketCount_--;
+        conn.timeoutExpired();
+      } else {
+        // Activity pushed the deadline out since the connection was
+        // filed here; re-file it. During catch-up the deadline may lie
+        // further ahead than the ring reaches from this slot, in which
+        // case the connection parks at the far edge and is re-filed
+        // again when that bucket is scanned.
+        const auto target =
+            std::min(deadlineSlot, slot + idleBuckets_.size() - 1);
+        idleBuckets_[target % idleBuckets_.size()].push_back(conn);
+      }
+    }
+  }
+  ensureIdleScanScheduled();
 }
 
 void ConnectionManager::removeConnection(ManagedConnection* connection) {
   if (connection->getConnectionManager() == this) {
     connection->cancelTimeout();
+    unlinkIdleBucket(connection);
     connection->setConnectionManager(nullptr);
 
     // Un-link the connection from our list, being careful to keep the iterator
@@ -143,6 +266,16 @@ void ConnectionManager::removeConnection(ManagedConnection* connection) {
     if (it == idleIterator_) {
       ++idleIterator_;
     }
+    for (auto& exporter : exporters_) {
+      if (it == exporter->it_) {
+        ++exporter->it_;
+      }
+    }
+    for (auto& dropper : droppers_) {
+      if (it == dropper->it_) {
+        ++dropper->it_;
+      }
+    }
     conns_.erase(it);
 
     if (callback_) {
@@ -195,19 +328,35 @@ void ConnectionManager::DrainHelper::startDrainAll(
 
 void ConnectionManager::DrainHelper::startDrain(
     std::chrono::milliseconds idleGrace) {
+  manager_.drainProgress_ = DrainProgress();
   if (idleGrace.count() > 0) {
     shutdownState_ = ShutdownState::NOTIFY_PENDING_SHUTDOWN;
     scheduleTimeout(idleGrace);
     VLOG(3) << "Scheduling idle grace period of " << idleGrace.count() << "ms";
+    manager_.drainIterator_ = drainStartIterator();
   } else {
     manager_.notifyPendingShutdown_ = false;
-    shutdownState_ = ShutdownState::CLOSE_WHEN_IDLE;
     VLOG(3) << "proceeding directly to closing idle connections";
+    startClosePhase();
   }
-  manager_.drainIterator_ = drainStartIterator();
   drainConnections();
 }
 
+void ConnectionManager::DrainHelper::startClosePhase() {
+  shutdownState_ = ShutdownState::CLOSE_WHEN_IDLE;
+  if (all_ && manager_.drainIdleFirst_ && manager_.notifyPendingShutdown_ &&
+      manager_.idleIterator_ != manager_.conns_.end()) {
+    // Shed the idle tail first; the busy head is swept in a second pass.
+    // Connections closed in the first pass are filtered from the sweep by
+    // their drain state, which is why this requires the notify path.
+    idlePassPending_ = true;
+    manager_.drainIterator_ = manager_.idleIterator_;
+  } else {
+    idlePassPending_ = false;
+    manager_.drainIterator_ = drainStartIterator();
+  }
+}
+
 void ConnectionManager::DrainHelper::drainConnections() {
   DestructorGuard g(&manager_);
   size_t numCleared = 0;
@@ -218,7 +367,10 @@ void ConnectionManager::DrainHelper::drainConnections() {
   CHECK(
       shutdownState_ == ShutdownState::NOTIFY_PENDING_SHUTDOWN ||
       shutdownState_ == ShutdownState::CLOSE_WHEN_IDLE);
-  while (it != manager_.conns_.end() && (numKept + numCleared) < 64) {
+  const auto budget = manager_.drainChunkTimeBudget();
+  const auto chunkStart = std::chrono::steady_clock::now();
+  while (it != manager_.conns_.end() &&
+         drainChunkHasBudget(numKept + numCleared, chunkStart, budget)) {
     ManagedConnection& conn = *it++;
     if (shutdownState_ == ShutdownState::NOTIFY_PENDING_SHUTDOWN) {
       conn.fireNotifyPendingShutdown();
@@ -236,9 +388,11 @@ void ConnectionManager::DrainHelper::drainConnections() {
   }
 
   if (shutdownState_ == ShutdownState::CLOSE_WHEN_IDLE) {
+    manager_.drainProgress_.connectionsClosed += numCleared;
     VLOG(2) << "Idle connections cleared: " << numCleared
             << ", busy conns kept: " << numKept;
   } else {
+    manager_.drainProgress_.connectionsNotified += numKept;
     VLOG(3) << this << " notified n=" << numKept;
   }
   manager_.drainIterator_ = it;
@@ -250,12 +404,17 @@ void ConnectionManager::DrainHelper::drainConnections() {
       shutdownState_ = ShutdownState::NOTIFY_PENDING_SHUTDOWN_COMPLETE;
       if (!isScheduled()) {
         // The idle grace timer already fired, start over immediately
-        shutdownState_ = ShutdownState::CLOSE_WHEN_IDLE;
-        manager_.drainIterator_ = drainStartIterator();
+        startClosePhase();
         manager_.eventBase_->runInLoop(this);
       }
+    } else if (idlePassPending_) {
+      // Idle tail done; sweep the whole list for the busy connections
+      idlePassPending_ = false;
+      manager_.drainIterator_ = manager_.conns_.begin();
+      manager_.eventBase_->runInLoop(this);
     } else {
       shutdownState_ = ShutdownState::CLOSE_WHEN_IDLE_COMPLETE;
+      manager_.drainProgress_.closePhaseComplete = true;
     }
   }
 }
@@ -263,8 +422,7 @@ void ConnectionManager::DrainHelper::drainConnections() {
 void ConnectionManager::DrainHelper::idleGracefulTimeoutExpired() {
   VLOG(2) << this << " idleGracefulTimeoutExpired";
   if (shutdownState_ == ShutdownState::NOTIFY_PENDING_SHUTDOWN_COMPLETE) {
-    shutdownState_ = ShutdownState::CLOSE_WHEN_IDLE;
-    manager_.drainIterator_ = drainStartIterator();
+    startClosePhase();
     drainConnections();
   } else {
     VLOG(4) << this
@@ -273,12 +431,24 @@ void ConnectionManager::DrainHelper::idleGracefulTimeoutExpired() {
   }
 }
 
+std::chrono::microseconds ConnectionManager::drainChunkTimeBudget() const {
+  if (drainChunkBudget_.count() == 0) {
+    return std::chrono::microseconds(0);
+  }
+  // Leave headroom for live traffic: the loop's recent average iteration
+  // time approximates the non-drain work per iteration, so spend only
+  // what is left of the budget, floored so drain always advances.
+  const auto avgLoop = std::chrono::microseconds(
+      static_cast<int64_t>(eventBase_->getAvgLoopTime()));
+  return std::max(kMinDrainChunkBudget, drainChunkBudget_ - avgLoop);
+}
+
 void ConnectionManager::stopDrainingForShutdown() {
   drainHelper_.setShutdownState(ShutdownState::CLOSE_WHEN_IDLE_COMPLETE);
   drainHelper_.cancelTimeout();
 }
 
-void ConnectionManager::dropAllConnections() {
+void ConnectionManager::dropAllConnections(bool dropHard) {
   DestructorGuard g(this);
 
   // Signal the drain helper in case that has not happened before.
@@ -293,7 +463,12 @@ void ConnectionManager::dropAllConnections() {
     ManagedConnection& conn = conns_.front();
     conns_.pop_front();
     conn.cancelTimeout();
+    unlinkIdleBucket(&conn);
     conn.setConnectionManager(nullptr);
+    if (dropHard) {
+      conn.dropConnectionHard();
+      continue;
+    }
     // For debugging purposes, dump information about the first few
     // connections.
     static const unsigned MAX_CONNS_TO_DUMP = 2;
@@ -326,6 +501,128 @@ void ConnectionManager::dropConnections(double pct) {
   }
 }
 
+void ConnectionManager::publishConnectionSnapshot() {
+  // The intrusive list may only be walked where it is mutated.
+  eventBase_->dcheckIsInEventBaseThread();
+
+  if (!snapshotBackBuffer_ || snapshotBackBuffer_.use_count() != 1) {
+    snapshotBackBuffer_ = std::make_shared<ConnectionSnapshot>();
+  }
+  auto& buffer = *snapshotBackBuffer_;
+  buffer.clear();
+  buffer.reserve(conns_.size());
+  for (auto& conn : conns_) {
+    ConnectionSnapshotEntry entry;
+    entry.idleTime = conn.getIdleTime();
+    if (auto elapsed = conn.getLastActivityElapsedTime()) {
+      entry.sinceLastActivity = *elapsed;
+    }
+    if (conn.state_ != ManagedConnection::DrainState::NONE) {
+      entry.state = ConnectionSnapshotEntry::State::DRAINING;
+    } else if (conn.isBusy()) {
+      entry.state = ConnectionSnapshotEntry::State::BUSY;
+    }
+    buffer.push_back(entry);
+  }
+
+  // Flip: the filled back buffer becomes the front, and the retired
+  // front is kept as the next back buffer unless a reader holds it.
+  auto previous = connSnapshot_.exchange(
+      std::shared_ptr<const ConnectionSnapshot>(snapshotBackBuffer_),
+      std::memory_order_acq_rel);
+  snapshotBackBuffer_ =
+      std::const_pointer_cast<ConnectionSnapshot>(std::move(previous));
+}
+
+void ConnectionManager::exportConnectionStates(
+    std::shared_ptr<ConnectionStateExportSink> sink,
+    size_t maxRecordsPerLoop) {
+  eventBase_->dcheckIsInEventBaseThread();
+  CHECK(sink);
+  CHECK_GT(maxRecordsPerLoop, 0u);
+  auto exporter = std::make_unique<ConnectionStateExporter>(
+      *this, std::move(sink), maxRecordsPerLoop);
+  exporter->it_ = conns_.begin();
+  exporter->buffer_.reserve(std::min(maxRecordsPerLoop, conns_.size()));
+  eventBase_->runInLoop(exporter.get());
+  exporters_.push_back(std::move(exporter));
+}
+
+void ConnectionManager::exportChunk(ConnectionStateExporter& exporter) {
+  auto& buffer = exporter.buffer_;
+  buffer.clear();
+  while (exporter.it_ != conns_.end() && buffer.size() < exporter.chunkSize_) {
+    ConnectionStateRecord record;
+    exporter.it_->fillConnectionStateRecord(record);
+    buffer.push_back(record);
+    ++exporter.it_;
+  }
+  exporter.numRecords_ += buffer.size();
+  if (!buffer.empty()) {
+    // The sink may remove connections; removeConnection() keeps the
+    // resume iterator valid, like the drain and idle-shed iterators.
+    exporter.sink_->onRecords({buffer.data(), buffer.size()});
+  }
+  if (exporter.it_ != conns_.end()) {
+    eventBase_->runInLoop(&exporter);
+    return;
+  }
+  exporter.sink_->onExportDone(exporter.numRecords_);
+  auto it = std::find_if(
+      exporters_.begin(), exporters_.end(), [&](const auto& owned) {
+        return owned.get() == &exporter;
+      });
+  DCHECK(it != exporters_.end());
+  exporters_.erase(it);
+}
+
+void ConnectionManager::dropConnectionsIf(
+    ConnectionDropPredicate predicate,
+    size_t maxScannedPerLoop,
+    folly::Function<void(size_t, size_t)> onDone) {
+  eventBase_->dcheckIsInEventBaseThread();
+  CHECK(predicate);
+  CHECK_GT(maxScannedPerLoop, 0u);
+  auto dropper = std::make_unique<ConnectionDropper>(
+      *this, std::move(predicate), maxScannedPerLoop, std::move(onDone));
+  dropper->it_ = conns_.begin();
+  eventBase_->runInLoop(dropper.get());
+  droppers_.push_back(std::move(dropper));
+}
+
+void ConnectionManager::dropChunk(ConnectionDropper& dropper) {
+  DestructorGuard g(this);
+  size_t scanned = 0;
+  while (dropper.it_ != conns_.end() && scanned < dropper.chunkSize_) {
+    ManagedConnection& conn = *dropper.it_;
+    // Advance past the candidate first; removeConnection() only fixes
+    // up the resume iterators of the *other* in-flight scans.
+    ++dropper.it_;
+    scanned++;
+    ConnectionStateRecord record;
+    conn.fillConnectionStateRecord(record);
+    if (dropper.predicate_(record)) {
+      removeConnection(&conn);
+      conn.dropConnection();
+      dropper.numDropped_++;
+    }
+  }
+  dropper.numScanned_ += scanned;
+  if (dropper.it_ != conns_.end()) {
+    eventBase_->runInLoop(&dropper);
+    return;
+  }
+  if (dropper.onDone_) {
+    dropper.onDone_(dropper.numScanned_, dropper.numDropped_);
+  }
+  auto it = std::find_if(
+      droppers_.begin(), droppers_.end(), [&](const auto& owned) {
+        return owned.get() == &dropper;
+      });
+  DCHECK(it != droppers_.end());
+  droppers_.erase(it);
+}
+
 void ConnectionManager::reportActivity(ManagedConnection& conn) {
   conn.reportActivity();
   onActivated(conn);
@@ -19,7 +19,10 @@
 #include <wangle/acceptor/ManagedConnection.h>
 
 #include <folly/ConstexprMath.h>
+#include <folly/Function.h>
 #include <folly/Memory.h>
+#include <folly/Range.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/DelayedDestruction.h>
 #include <folly/io/async/EventBase.h>
@@ -137,6 +140,48 @@ class ConnectionManager : public folly::DelayedDestruction,
    */
   void initiateGracefulShutdown(std::chrono::milliseconds idleGrace);
 
+  /**
+   * Progress of the most recent drain, so orchestration can sequence
+   * restarts by actual progress instead of wall-clock guesses.
+   */
+  struct DrainProgress {
+    /** Connections notified of the pending shutdown so far */
+    size_t connectionsNotified{0};
+    /** Connections found idle and closed during the close phase */
+    size_t connectionsClosed{0};
+    /** Connections still managed; busy ones linger until they go idle */
+    size_t connectionsRemaining{0};
+    /** True once every remaining connection has been told to close */
+    bool closePhaseComplete{false};
+  };
+
+  DrainProgress getDrainProgress() const {
+    auto progress = drainProgress_;
+    progress.connectionsRemaining = conns_.size();
+    return progress;
+  }
+
+  /**
+   * Size drain chunks by a time budget instead of the fixed 64-connection
+   * chunks (the default, kept when budget is zero). Each loop iteration
+   * the drain consumes at most the budget minus the loop's recent average
+   * work, so drain backs off while live traffic keeps the loop busy and
+   * speeds up when the loop has slack.
+   */
+  void setDrainChunkBudget(std::chrono::microseconds budget) {
+    drainChunkBudget_ = budget;
+  }
+
+  /**
+   * During the close phase of a full graceful drain, visit the idle tail
+   * of the connection list before the busy head, so connections that can
+   * close immediately are shed first. Only applies to drains that went
+   * through a notify grace period.
+   */
+  void setDrainIdleConnectionsFirst(bool idleFirst) {
+    drainIdleFirst_ = idleFirst;
+  }
+
   /**
    * Gracefully shutdown certain percentage of persistent client connections
    * and leave the rest intact.
@@ -145,9 +190,11 @@ class ConnectionManager : public folly::DelayedDestruction,
 
   /**
    * Destroy all connections Managed by this ConnectionManager, even
-   * the ones that are busy.
+   * the ones that are busy.  With dropHard, each connection is torn
+   * down via ManagedConnection::dropConnectionHard(), skipping
+   * per-connection close notification for deterministic bulk teardown.
    */
-  void dropAllConnections();
+  void dropAllConnections(bool dropHard = false);
 
   /**
    * Force-stop "pct" (0.0 to 1.0) of remaining client connections,
@@ -159,6 +206,62 @@ class ConnectionManager : public folly::DelayedDestruction,
     return conns_.size();
   }
 
+  /**
+   * Fixed framework overhead every managed connection carries (timer
+   * callback, destruction guard, list hooks) before any application
+   * state. Tracked per release by the sizeof regression test.
+   */
+  static constexpr size_t kPerConnectionFrameworkBytes =
+      sizeof(ManagedConnection);
+
+  /**
+   * Total framework bytes across currently managed connections. The
+   * lazily allocated connection age timeout is counted only when this
+   * manager has a connection age timeout configured.
+   */
+  size_t getConnectionFrameworkBytes() const {
+    auto perConn = kPerConnectionFrameworkBytes;
+    if (connectionAgeTimeout_ > std::chrono::milliseconds(0)) {
+      perConn += sizeof(ConnectionAgeTimeout);
+    }
+    return getNumConnections() * perConn;
+  }
+
+  /**
+   * Schedule all connection timeouts on the given wheel timer instead of the
+   * EventBase-wide one. The timer must belong to the same EventBase and must
+   * outlive this ConnectionManager. Used by ShardedConnectionManager to give
+   * each shard an independent wheel.
+   */
+  void setTimeoutWheel(folly::HHWheelTimer* timer) {
+    timer_ = timer;
+  }
+
+  /**
+   * Schedules the drain helper's idle-grace timeout on the given
+   * manager instead of this manager's EventBase. A test seam: the
+   * simulation harness in wangle/test/Simulation.h drives drains on
+   * virtual time. Call before initiateGracefulShutdown().
+   */
+  void setDrainTimeoutManager(folly::TimeoutManager* manager) {
+    drainHelper_.detachTimeoutManager();
+    drainHelper_.attachTimeoutManager(
+        manager, folly::TimeoutManager::InternalEnum::NORMAL);
+  }
+
+  /**
+   * Coalesce per-connection idle timeouts into a ring of buckets with the
+   * given granularity instead of scheduling each connection on the wheel
+   * timer. Rescheduling on activity then costs a timestamp store rather
+   * than a wheel reschedule, which matters with hundreds of thousands of
+   * connections per thread; in exchange, idle timeouts fire up to one
+   * granularity late. The whole ring is driven by a single wheel entry
+   * that expires one bucket per tick. Timeouts longer than the default
+   * idle timeout do not fit the ring and still go to the wheel. Must be
+   * called before any idle timeout is scheduled.
+   */
+  void setCoalescedIdleTimeouts(std::chrono::milliseconds granularity);
+
   template <typename F>
   void forEachConnection(F func) {
     for (auto& connection : conns_) {
@@ -166,6 +269,102 @@ class ConnectionManager : public folly::DelayedDestruction,
     }
   }
 
+  /**
+   * Compact per-connection accounting published for off-thread
+   * monitoring; see publishConnectionSnapshot().
+   */
+  struct ConnectionSnapshotEntry {
+    enum class State : uint8_t { IDLE, BUSY, DRAINING };
+    /** ManagedConnection::getIdleTime at publish time */
+    std::chrono::milliseconds idleTime{0};
+    /** Time since last reported activity; -1 when none was reported */
+    std::chrono::milliseconds sinceLastActivity{-1};
+    State state{State::IDLE};
+  };
+
+  using ConnectionSnapshot = std::vector<ConnectionSnapshotEntry>;
+
+  /**
+   * Walk the live list once, fill the back snapshot buffer, and flip it
+   * to the front. Must run on this manager's EventBase (enqueue it once
+   * per export cycle); this walk is the only EventBase time monitoring
+   * costs, and the buffer is recycled between cycles, so a steady-state
+   * publish does not allocate.
+   */
+  void publishConnectionSnapshot();
+
+  /**
+   * The most recently published snapshot. Safe from any thread: the
+   * returned buffer is immutable, and holding it simply delays its
+   * recycling. Empty until the first publish.
+   */
+  std::shared_ptr<const ConnectionSnapshot> getConnectionSnapshot() const {
+    return connSnapshot_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Receives the records produced by exportConnectionStates().
+   */
+  class ConnectionStateExportSink {
+   public:
+    virtual ~ConnectionStateExportSink() = default;
+
+    /**
+     * A chunk of exported records, invoked on the manager's EventBase.
+     * The range is only valid for the duration of the call, so a sink
+     * that defers its I/O must copy (records are trivially copyable).
+     */
+    virtual void onRecords(
+        folly::Range<const ConnectionStateRecord*> records) = 0;
+
+    /** The export finished after delivering numRecords records. */
+    virtual void onExportDone(size_t numRecords) = 0;
+  };
+
+  /** Default maximum records exported per event loop iteration */
+  static constexpr size_t kExportChunkSize = 4096;
+
+  /**
+   * Stream a fixed-size binary record (see ConnectionStateRecord) for
+   * every managed connection into the sink, at most maxRecordsPerLoop
+   * records per event loop iteration, so dumping millions of
+   * connections never occupies the EventBase for more than one chunk
+   * at a time. Must be called on this manager's EventBase. Connections
+   * removed mid-export are skipped; ones whose list position changes
+   * under activity may be missed or seen twice, which a diagnostic
+   * dump tolerates. Several exports may be in flight at once.
+   */
+  void exportConnectionStates(
+      std::shared_ptr<ConnectionStateExportSink> sink,
+      size_t maxRecordsPerLoop = kExportChunkSize);
+
+  /**
+   * Evaluated against each connection's compact state record; return
+   * true to drop that connection.
+   */
+  using ConnectionDropPredicate =
+      folly::Function<bool(const ConnectionStateRecord&)>;
+
+  /** Default connections examined per event loop iteration */
+  static constexpr size_t kDropScanChunkSize = 4096;
+
+  /**
+   * Drop every managed connection matching the predicate, examining at
+   * most maxScannedPerLoop connections per event loop iteration, so
+   * evicting one population (an abusive tenant, a bad client version)
+   * out of hundreds of thousands of connections never occupies the
+   * EventBase for more than one chunk at a time. Matching connections
+   * are dropped as they are found. Must be called on this manager's
+   * EventBase. Like exportConnectionStates(), connections whose list
+   * position changes under activity may be missed by one scan; callers
+   * needing certainty rerun the eviction. onDone, if given, is invoked
+   * on the EventBase with (scanned, dropped) once the scan completes.
+   */
+  void dropConnectionsIf(
+      ConnectionDropPredicate predicate,
+      size_t maxScannedPerLoop = kDropScanChunkSize,
+      folly::Function<void(size_t, size_t)> onDone = nullptr);
+
   std::chrono::milliseconds getDefaultTimeout() const {
     return idleTimeout_;
   }
@@ -249,6 +448,8 @@ class ConnectionManager : public folly::DelayedDestruction,
     void startDrainPartial(double pct, std::chrono::milliseconds idleGrace);
     void startDrainAll(std::chrono::milliseconds idleGrace);
 
+    void startClosePhase();
+
     void runLoopCallback() noexcept override {
       VLOG(3) << "Draining more conns from loop callback";
       drainConnections();
@@ -280,10 +481,83 @@ class ConnectionManager : public folly::DelayedDestruction,
    private:
     bool all_{true};
     double pct_{1.0};
+    // Close phase still has to sweep the busy head after the idle tail;
+    // see startClosePhase
+    bool idlePassPending_{false};
     ConnectionManager& manager_;
     ShutdownState shutdownState_{ShutdownState::NONE};
   };
 
+  // Drives the coalesced idle-timeout ring: one wheel entry per manager,
+  // rescheduled while any connection is tracked in a bucket.
+  class IdleBucketScanner : public folly::HHWheelTimer::Callback {
+   public:
+    explicit IdleBucketScanner(ConnectionManager& manager)
+        : manager_(manager) {}
+
+    void timeoutExpired() noexcept override {
+      manager_.scanIdleBuckets();
+    }
+
+   private:
+    ConnectionManager& manager_;
+  };
+
+  // One in-flight exportConnectionStates() call: holds the sink, the
+  // resume position, and the chunk buffer reused between iterations.
+  class ConnectionStateExporter : public folly::EventBase::LoopCallback {
+   public:
+    ConnectionStateExporter(
+        ConnectionManager& manager,
+        std::shared_ptr<ConnectionStateExportSink> sink,
+        size_t chunkSize)
+        : manager_(manager), sink_(std::move(sink)), chunkSize_(chunkSize) {}
+
+    void runLoopCallback() noexcept override {
+      manager_.exportChunk(*this);
+    }
+
+   private:
+    friend class ConnectionManager;
+
+    ConnectionManager& manager_;
+    std::shared_ptr<ConnectionStateExportSink> sink_;
+    const size_t chunkSize_;
+    ConnectionIterator it_;
+    size_t numRecords_{0};
+    std::vector<ConnectionStateRecord> buffer_;
+  };
+
+  // One in-flight dropConnectionsIf() scan; mirrors
+  // ConnectionStateExporter's chunked loop-callback walk.
+  class ConnectionDropper : public folly::EventBase::LoopCallback {
+   public:
+    ConnectionDropper(
+        ConnectionManager& manager,
+        ConnectionDropPredicate predicate,
+        size_t chunkSize,
+        folly::Function<void(size_t, size_t)> onDone)
+        : manager_(manager),
+          predicate_(std::move(predicate)),
+          chunkSize_(chunkSize),
+          onDone_(std::move(onDone)) {}
+
+    void runLoopCallback() noexcept override {
+      manager_.dropChunk(*this);
+    }
+
+   private:
+    friend class ConnectionManager;
+
+    ConnectionManager& manager_;
+    ConnectionDropPredicate predicate_;
+    const size_t chunkSize_;
+    folly::Function<void(size_t, size_t)> onDone_;
+    ConnectionIterator it_;
+    size_t numScanned_{0};
+    size_t numDropped_{0};
+  };
+
   ConnectionManager(const ConnectionManager&) = delete;
   ConnectionManager& operator=(ConnectionManager&) = delete;
 
@@ -301,6 +575,24 @@ class ConnectionManager : public folly::DelayedDestruction,
 
   void idleGracefulTimeoutExpired();
 
+  folly::HHWheelTimer& wheel() {
+    return timer_ ? *timer_ : eventBase_->timer();
+  }
+
+  std::chrono::microseconds drainChunkTimeBudget() const;
+
+  void scheduleCoalescedTimeout(
+      ManagedConnection* connection,
+      std::chrono::milliseconds timeout);
+  void unlinkIdleBucket(ManagedConnection* connection);
+  void scanIdleBuckets();
+  void ensureIdleScanScheduled();
+  uint64_t idleSlotOf(std::chrono::steady_clock::time_point tp) const;
+
+  void exportChunk(ConnectionStateExporter& exporter);
+
+  void dropChunk(ConnectionDropper& dropper);
+
   /**
    * All the managed connections. Connections begin in the idle state and move
    * to busy via 'onActivated'.  The move back to idle via 'onDeactivated'.
@@ -323,11 +615,52 @@ class ConnectionManager : public folly::DelayedDestruction,
   /** Event base in which we run */
   folly::EventBase* eventBase_;
 
+  /** Timer for connection timeouts; eventBase_->timer() when unset */
+  folly::HHWheelTimer* timer_{nullptr};
+
+  /**
+   * Coalesced idle-timeout ring, indexed by deadline slot modulo size;
+   * empty unless setCoalescedIdleTimeouts was called. A connection sits
+   * in the bucket of the deadline it had when filed; activity only
+   * updates its idleBucketDeadline_, and the scanner re-files it when the
+   * stale bucket comes up.
+   */
+  std::vector<folly::IntrusiveList<
+      ManagedConnection,
+      &ManagedConnection::idleBucketHook_>>
+      idleBuckets_;
+  std::chrono::milliseconds idleBucketGranularity_{0};
+  uint64_t lastScannedIdleSlot_{0};
+  size_t idleBucketCount_{0};
+  IdleBucketScanner idleScanner_{*this};
+
+  /** In-flight bulk state exports; normally empty */
+  std::vector<std::unique_ptr<ConnectionStateExporter>> exporters_;
+
+  /** In-flight predicate-targeted eviction scans; normally empty */
+  std::vector<std::unique_ptr<ConnectionDropper>> droppers_;
+
   /** Iterator to the next connection to shed; used by drainAllConnections() */
   ConnectionIterator drainIterator_;
   ConnectionIterator idleIterator_;
   DrainHelper drainHelper_;
   bool notifyPendingShutdown_{true};
+  DrainProgress drainProgress_;
+  /** Per-iteration drain time budget; zero keeps fixed-size chunks */
+  std::chrono::microseconds drainChunkBudget_{0};
+  bool drainIdleFirst_{false};
+
+  /** Front snapshot buffer, swapped wholesale at each publish */
+  folly::atomic_shared_ptr<const ConnectionSnapshot> connSnapshot_{
+      std::make_shared<const ConnectionSnapshot>()};
+
+  /**
+   * Back snapshot buffer, written only on the EventBase thread. After a
+   * flip the retired front lands here for reuse; if a monitoring reader
+   * still holds it, the next publish allocates a fresh buffer rather
+   * than mutating under the reader.
+   */
+  std::shared_ptr<ConnectionSnapshot> snapshotBackBuffer_;
 
   /**
    * the default idle timeout for downstream sessions when no system resource
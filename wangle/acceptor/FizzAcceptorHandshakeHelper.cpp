@@ -81,6 +81,15 @@ void FizzAcceptorHandshakeHelper::fizzHandshakeSuccess(
   tinfo_.securityType = transport->getSecurityProtocol();
   tinfo_.sslSetupTime = std::chrono::duration_cast<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - acceptTime_);
+  // With accepted 0-RTT fizz reports success before the handshake is
+  // confirmed, so early application data reaches the pipeline right away;
+  // mark it so handlers know those bytes are replayable until the
+  // transport becomes replay safe.
+  tinfo_.sslEarlyDataAccepted =
+      transport->getState().earlyDataType() == EarlyDataType::Accepted;
+  if (auto certCompAlgo = transport->getState().serverCertCompAlgo()) {
+    tinfo_.sslCertCompressionAlgo = static_cast<uint16_t>(*certCompAlgo);
+  }
   if (tokenBindingExtension_ &&
       tokenBindingExtension_->getNegotiatedKeyParam().has_value()) {
     tinfo_.negotiatedTokenBindingKeyParameters =
@@ -88,7 +97,9 @@ void FizzAcceptorHandshakeHelper::fizzHandshakeSuccess(
   }
 
   auto* handshakeLogging = transport->getState().handshakeLogging();
-  if (handshakeLogging) {
+  // Sampled-out connections skip the string fields; see
+  // TransportInfo::CaptureLevel.
+  if (handshakeLogging && tinfo_.fullCapture()) {
     if (handshakeLogging->clientSni) {
       tinfo_.sslServerName =
           std::make_shared<std::string>(*handshakeLogging->clientSni);
@@ -116,6 +127,8 @@ void FizzAcceptorHandshakeHelper::fizzHandshakeSuccess(
 void FizzAcceptorHandshakeHelper::fizzHandshakeError(
     AsyncFizzServer* transport,
     folly::exception_wrapper ex) noexcept {
+  // Failures always log at full fidelity, sampled or not.
+  tinfo_.captureLevel = TransportInfo::CaptureLevel::FULL;
   if (loggingCallback_) {
     loggingCallback_->logFizzHandshakeError(*transport, ex);
   }
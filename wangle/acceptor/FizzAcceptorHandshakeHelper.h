@@ -305,7 +305,7 @@ class DefaultToFizzPeekingCallback
   }
 
   wangle::AcceptorHandshakeHelper::UniquePtr getHelper(
-      const std::vector<uint8_t>& /* bytes */,
+      folly::ByteRange /* bytes */,
       const folly::SocketAddress& clientAddr,
       std::chrono::steady_clock::time_point acceptTime,
       wangle::TransportInfo& tinfo) override {
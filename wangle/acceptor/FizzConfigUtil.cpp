@@ -16,6 +16,8 @@
 
 #include <wangle/acceptor/FizzConfigUtil.h>
 
+#include <fizz/compression/ZlibCertificateCompressor.h>
+#include <fizz/compression/ZstdCertificateCompressor.h>
 #include <fizz/protocol/DefaultCertificateVerifier.h>
 #include <folly/Format.h>
 #include <folly/String.h>
@@ -29,17 +31,43 @@ using fizz::server::ClientAuthMode;
 
 namespace wangle {
 
+namespace {
+
+// Compression levels are maxed out: each chain is compressed exactly
+// once at load time, so only the compressed size matters.
+std::vector<std::shared_ptr<fizz::CertificateCompressor>> makeCertCompressors(
+    const SSLContextConfig& sslConfig) {
+  std::vector<std::shared_ptr<fizz::CertificateCompressor>> compressors;
+  for (auto algorithm : sslConfig.certCompressionAlgorithms) {
+    switch (algorithm) {
+      case SSLContextConfig::CertCompressionAlgorithm::ZLIB:
+        compressors.push_back(
+            std::make_shared<fizz::ZlibCertificateCompressor>(9));
+        break;
+      case SSLContextConfig::CertCompressionAlgorithm::ZSTD:
+        compressors.push_back(
+            std::make_shared<fizz::ZstdCertificateCompressor>(19));
+        break;
+    }
+  }
+  return compressors;
+}
+
+} // namespace
+
 std::unique_ptr<fizz::server::CertManager> FizzConfigUtil::createCertManager(
     const ServerSocketConfig& config,
     const std::shared_ptr<PasswordInFileFactory>& pwFactory) {
   auto certMgr = std::make_unique<fizz::server::CertManager>();
   auto loadedCert = false;
   for (const auto& sslConfig : config.sslContextConfigs) {
+    auto compressors = makeCertCompressors(sslConfig);
     for (const auto& cert : sslConfig.certificates) {
       try {
         std::unique_ptr<fizz::SelfCert> selfCert;
         if (cert.isBuffer) {
-          selfCert = CertUtils::makeSelfCert(cert.certPath, cert.keyPath);
+          selfCert =
+              CertUtils::makeSelfCert(cert.certPath, cert.keyPath, compressors);
         } else {
           auto x509Chain = FizzUtil::readChainFile(cert.certPath);
           std::shared_ptr<folly::PasswordInFile> pw;
@@ -50,8 +78,8 @@ std::unique_ptr<fizz::server::CertManager> FizzConfigUtil::createCertManager(
           }
 
           auto pkey = FizzUtil::readPrivateKey(cert.keyPath, pw);
-          selfCert =
-              CertUtils::makeSelfCert(std::move(x509Chain), std::move(pkey));
+          selfCert = CertUtils::makeSelfCert(
+              std::move(x509Chain), std::move(pkey), compressors);
         }
         certMgr->addCert(std::move(selfCert), sslConfig.isDefault);
         loadedCert = true;
@@ -99,6 +127,26 @@ FizzConfigUtil::createFizzContext(const ServerSocketConfig& config) {
     ctx->setAlpnMode(fizz::server::AlpnMode::Optional);
   }
 
+  // Offer the compression algorithms the cert manager pre-compressed
+  // the chains with; serving a compressed chain is then a cache lookup.
+  std::vector<fizz::CertificateCompressionAlgorithm> certCompressionAlgos;
+  for (auto algorithm :
+       config.sslContextConfigs.front().certCompressionAlgorithms) {
+    switch (algorithm) {
+      case SSLContextConfig::CertCompressionAlgorithm::ZLIB:
+        certCompressionAlgos.push_back(
+            fizz::CertificateCompressionAlgorithm::zlib);
+        break;
+      case SSLContextConfig::CertCompressionAlgorithm::ZSTD:
+        certCompressionAlgos.push_back(
+            fizz::CertificateCompressionAlgorithm::zstd);
+        break;
+    }
+  }
+  if (!certCompressionAlgos.empty()) {
+    ctx->setSupportedCompressionAlgorithms(std::move(certCompressionAlgos));
+  }
+
   auto verify = config.sslContextConfigs.front().clientVerification;
   switch (verify) {
     case folly::SSLContext::VerifyClientCertificate::ALWAYS:
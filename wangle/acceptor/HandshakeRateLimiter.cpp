@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/acceptor/HandshakeRateLimiter.h>
+
+#include <algorithm>
+
+#include <folly/IPAddress.h>
+
+namespace wangle {
+
+HandshakeRateLimiter::HandshakeRateLimiter(
+    uint32_t maxPerWindow,
+    std::chrono::milliseconds window,
+    uint8_t prefixLengthV4,
+    uint8_t prefixLengthV6,
+    size_t numSlots)
+    : maxPerWindow_(maxPerWindow),
+      window_(std::max(window, std::chrono::milliseconds(1))),
+      prefixLengthV4_(std::min<uint8_t>(prefixLengthV4, 32)),
+      prefixLengthV6_(std::min<uint8_t>(prefixLengthV6, 128)),
+      slots_(std::max<size_t>(numSlots, 1)) {}
+
+HandshakeRateLimiter::Slot& HandshakeRateLimiter::slotFor(
+    const folly::SocketAddress& clientAddr,
+    uint64_t windowIndex) {
+  // Non-IP transports (e.g. unix sockets) all share slot zero.
+  uint64_t hash = 0;
+  if (clientAddr.isFamilyInet()) {
+    const auto addr = clientAddr.getIPAddress();
+    hash = addr.mask(addr.isV4() ? prefixLengthV4_ : prefixLengthV6_).hash();
+  }
+  auto& slot = slots_[hash % slots_.size()];
+  if (slot.windowIndex != windowIndex) {
+    slot.prevCount = slot.windowIndex + 1 == windowIndex ? slot.curCount : 0;
+    slot.curCount = 0;
+    slot.windowIndex = windowIndex;
+  }
+  return slot;
+}
+
+bool HandshakeRateLimiter::admit(
+    const folly::SocketAddress& clientAddr,
+    std::chrono::steady_clock::time_point now) {
+  if (maxPerWindow_ == 0) {
+    return true;
+  }
+  const uint64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             now.time_since_epoch())
+                             .count();
+  auto& slot = slotFor(clientAddr, nowMs / window_.count());
+  const double elapsed =
+      static_cast<double>(nowMs % window_.count()) / window_.count();
+  const double rate = slot.curCount + slot.prevCount * (1.0 - elapsed);
+  if (rate >= maxPerWindow_) {
+    return false;
+  }
+  ++slot.curCount;
+  return true;
+}
+
+void HandshakeRateLimiter::refund(
+    const folly::SocketAddress& clientAddr,
+    std::chrono::steady_clock::time_point now) {
+  if (maxPerWindow_ == 0) {
+    return;
+  }
+  const uint64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             now.time_since_epoch())
+                             .count();
+  auto& slot = slotFor(clientAddr, nowMs / window_.count());
+  if (slot.curCount > 0) {
+    --slot.curCount;
+  } else if (slot.prevCount > 0) {
+    --slot.prevCount;
+  }
+}
+
+} // namespace wangle
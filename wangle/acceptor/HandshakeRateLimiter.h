@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+#include <chrono>
+#include <vector>
+
+namespace wangle {
+
+/**
+ * Sliding-window rate tracker for full TLS handshakes, keyed by source
+ * address prefix (by default /24 for IPv4 and /56 for IPv6) so that a
+ * single misbehaving subnet cannot consume the whole handshake CPU
+ * budget of an acceptor.
+ *
+ * One instance lives per Acceptor, and therefore per EventBase, so no
+ * synchronization is required.  The tracker is a fixed-size flat array
+ * of counting slots allocated once at construction: a source prefix
+ * hashes to a single slot and colliding prefixes share its counters.
+ * That biases the limiter toward shedding when two hot prefixes
+ * collide, but keeps admission decisions allocation-free and O(1).
+ *
+ * Each slot keeps counts for the current and previous window; the
+ * effective rate is the current count plus the previous count weighted
+ * by the fraction of the previous window still covered by the sliding
+ * window.
+ */
+class HandshakeRateLimiter {
+ public:
+  HandshakeRateLimiter(
+      uint32_t maxPerWindow,
+      std::chrono::milliseconds window,
+      uint8_t prefixLengthV4 = 24,
+      uint8_t prefixLengthV6 = 56,
+      size_t numSlots = 4096);
+
+  /**
+   * Records a handshake attempt from the given source.  Returns true
+   * if the attempt is admitted and false if the source prefix is over
+   * its full-handshake budget; rejected attempts are not counted.
+   */
+  bool admit(
+      const folly::SocketAddress& clientAddr,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+  /**
+   * Returns a previously admitted attempt to the budget.  Called when
+   * a handshake turns out to be a session resumption: resumptions are
+   * cheap and exempt from the limit, but that is only known once the
+   * handshake completes.
+   */
+  void refund(
+      const folly::SocketAddress& clientAddr,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+ private:
+  struct Slot {
+    uint64_t windowIndex{0};
+    uint32_t prevCount{0};
+    uint32_t curCount{0};
+  };
+
+  Slot& slotFor(const folly::SocketAddress& clientAddr, uint64_t windowIndex);
+
+  const uint32_t maxPerWindow_;
+  const std::chrono::milliseconds window_;
+  const uint8_t prefixLengthV4_;
+  const uint8_t prefixLengthV6_;
+  std::vector<Slot> slots_;
+};
+
+} // namespace wangle
@@ -19,11 +19,56 @@
 #include <folly/Conv.h>
 #include <folly/portability/OpenSSL.h>
 
+#include <map>
+
 using folly::SocketAddress;
 using std::string;
 
 namespace wangle {
 
+LoadShedConfiguration::AllowlistSnapshot::AllowlistSnapshot(
+    const AddressSet& addrs,
+    const NetworkSet& networks) {
+  addrs_.reserve(addrs.size());
+  for (const auto& addr : addrs) {
+    addrs_.insert(addr.getIPAddress());
+  }
+
+  // Bucket the networks by prefix length, keyed in ascending order so that
+  // the reversed walk below lays out the most specific prefixes first.
+  std::map<uint8_t, folly::F14FastSet<folly::IPAddress>> buckets;
+  for (const auto& network : networks) {
+    auto prefixLen = uint8_t(network.getPrefixLength());
+    buckets[prefixLen].insert(
+        network.getAddress().getIPAddress().mask(prefixLen));
+  }
+  networks_.reserve(buckets.size());
+  for (auto it = buckets.rbegin(); it != buckets.rend(); ++it) {
+    networks_.emplace_back(it->first, std::move(it->second));
+  }
+}
+
+bool LoadShedConfiguration::AllowlistSnapshot::contains(
+    const SocketAddress& addr) const {
+  if (!addr.isFamilyInet()) {
+    return false;
+  }
+  auto ipAddr = addr.getIPAddress();
+  if (addrs_.count(ipAddr)) {
+    return true;
+  }
+  for (const auto& bucket : networks_) {
+    if (bucket.first > ipAddr.bitCount()) {
+      // A prefix longer than the address; can only match the other family.
+      continue;
+    }
+    if (bucket.second.count(ipAddr.mask(bucket.first))) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void LoadShedConfiguration::addAllowlistAddr(folly::StringPiece input) {
   auto addr = input.str();
   size_t separator = addr.find_first_of('/');
@@ -35,18 +80,25 @@ void LoadShedConfiguration::addAllowlistAddr(folly::StringPiece input) {
     allowlistNetworks_.insert(
         NetworkAddress(SocketAddress(addr, 0), prefixLen));
   }
+  updateAllowlistSnapshot();
 }
 
 bool LoadShedConfiguration::isAllowlisted(const SocketAddress& address) const {
-  if (allowlistAddrs_.find(address) != allowlistAddrs_.end()) {
-    return true;
+  auto snapshot =
+      std::atomic_load_explicit(&allowlistSnapshot_, std::memory_order_acquire);
+  if (!snapshot) {
+    return false;
   }
-  for (auto& network : allowlistNetworks_) {
-    if (network.contains(address)) {
-      return true;
-    }
-  }
-  return false;
+  return snapshot->contains(address);
+}
+
+void LoadShedConfiguration::updateAllowlistSnapshot() {
+  std::atomic_store_explicit(
+      &allowlistSnapshot_,
+      std::shared_ptr<const AllowlistSnapshot>(
+          std::make_shared<AllowlistSnapshot>(
+              allowlistAddrs_, allowlistNetworks_)),
+      std::memory_order_release);
 }
 
 void LoadShedConfiguration::checkIsSane(const SysParams& sysParams) const {
@@ -16,13 +16,20 @@
 
 #pragma once
 
+#include <folly/IPAddress.h>
 #include <folly/Range.h>
 #include <folly/SocketAddress.h>
+#include <folly/Utility.h>
+#include <folly/container/F14Set.h>
 #include <glog/logging.h>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <wangle/acceptor/NetworkAddress.h>
 
@@ -45,6 +52,44 @@ class LoadShedConfiguration {
   typedef std::set<folly::SocketAddress, AddressOnlyCompare> AddressSet;
   typedef std::set<NetworkAddress> NetworkSet;
 
+  /**
+   * Immutable, hash based view of the allowlist, compiled whenever the
+   * allowlist is mutated and published via an atomic shared_ptr so that
+   * accept threads can run their checks without taking any locks.
+   *
+   * Exact addresses live in one hash set; networks are bucketed by prefix
+   * length so a lookup costs one hash probe for the address plus one probe
+   * per distinct prefix length in the config.
+   */
+  class AllowlistSnapshot {
+   public:
+    AllowlistSnapshot(const AddressSet& addrs, const NetworkSet& networks);
+
+    bool contains(const folly::SocketAddress& addr) const;
+
+   private:
+    folly::F14FastSet<folly::IPAddress> addrs_;
+    // (prefix length, masked network addresses), most specific first.
+    std::vector<std::pair<uint8_t, folly::F14FastSet<folly::IPAddress>>>
+        networks_;
+  };
+
+  /**
+   * Causes a load shedding decision can be attributed to; used to index the
+   * shed event counters below.
+   */
+  enum class ShedCause : uint8_t {
+    CPU = 0,
+    SOFT_IRQ_CPU,
+    MEMORY,
+    TCP_MEMORY,
+    UDP_MEMORY,
+    MAX_CONNECTIONS,
+    OTHER,
+    // Must be last.
+    NUM_CAUSES,
+  };
+
   LoadShedConfiguration() = default;
 
   virtual ~LoadShedConfiguration() = default;
@@ -57,6 +102,7 @@ class LoadShedConfiguration {
    */
   void setAllowlistAddrs(const AddressSet& addrs) {
     allowlistAddrs_ = addrs;
+    updateAllowlistSnapshot();
   }
   const AddressSet& getAllowlistAddrs() const {
     return allowlistAddrs_;
@@ -68,6 +114,7 @@ class LoadShedConfiguration {
    */
   void setAllowlistNetworks(const NetworkSet& networks) {
     allowlistNetworks_ = networks;
+    updateAllowlistSnapshot();
   }
   const NetworkSet& getAllowlistNetworks() const {
     return allowlistNetworks_;
@@ -258,8 +305,27 @@ class LoadShedConfiguration {
     return loadSheddingEnabled_;
   }
 
+  /**
+   * Lock free check against the current allowlist snapshot; safe to call
+   * from accept threads while another thread mutates the allowlist.
+   */
   bool isAllowlisted(const folly::SocketAddress& addr) const;
 
+  /**
+   * Tally a shed decision attributed to the given cause.  The configuration
+   * only keeps the counters; whatever enforces the limits above classifies
+   * its own decisions.  Thread safe; counters are shared between copies of
+   * the configuration.
+   */
+  void recordShedEvent(ShedCause cause) const {
+    (*shedEvents_)[folly::to_underlying(cause)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+  uint64_t getShedEventCount(ShedCause cause) const {
+    return (*shedEvents_)[folly::to_underlying(cause)].load(
+        std::memory_order_relaxed);
+  }
+
   /**
    * Performs a series of CHECKs to ensure the underlying configuration is
    * sane.
@@ -275,8 +341,18 @@ class LoadShedConfiguration {
   virtual void checkIsSane(const SysParams& sysParams) const;
 
  private:
+  // Recompiles the snapshot from the allowlist sets and atomically publishes
+  // it for readers of isAllowlisted().
+  void updateAllowlistSnapshot();
+
   AddressSet allowlistAddrs_;
   NetworkSet allowlistNetworks_;
+  std::shared_ptr<const AllowlistSnapshot> allowlistSnapshot_;
+
+  using ShedEventCounters = std::
+      array<std::atomic<uint64_t>, folly::to_underlying(ShedCause::NUM_CAUSES)>;
+  std::shared_ptr<ShedEventCounters> shedEvents_{
+      std::make_shared<ShedEventCounters>()};
 
   double cpuSoftLimitRatio_{1.0};
   double cpuHardLimitRatio_{1.0};
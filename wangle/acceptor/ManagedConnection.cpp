@@ -17,17 +17,20 @@
 #include <wangle/acceptor/ManagedConnection.h>
 
 #include <wangle/acceptor/ConnectionManager.h>
+#include <algorithm>
+#include <cstring>
 
 namespace wangle {
 
-ManagedConnection::ManagedConnection()
-    : connectionManager_(nullptr), connectionAgeTimeout_{*this} {}
+ManagedConnection::ManagedConnection() : connectionManager_(nullptr) {}
 
 ManagedConnection::~ManagedConnection() {
   if (connectionManager_) {
     connectionManager_->removeConnection(this);
   }
-  connectionAgeTimeout_.cancelTimeout();
+  if (connectionAgeTimeout_) {
+    connectionAgeTimeout_->cancelTimeout();
+  }
 }
 
 void ManagedConnection::resetTimeout() {
@@ -56,14 +59,42 @@ void ManagedConnection::reportActivity() {
 
 folly::Optional<std::chrono::milliseconds>
 ManagedConnection::getLastActivityElapsedTime() const {
-  if (latestActivity_) {
+  if (latestActivity_ != std::chrono::steady_clock::time_point::min()) {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - *latestActivity_);
+        std::chrono::steady_clock::now() - latestActivity_);
   } else {
     return folly::none;
   }
 }
 
+void ConnectionStateRecord::setPeerAddress(const folly::SocketAddress& addr) {
+  if (!addr.isInitialized() || !addr.isFamilyInet()) {
+    return;
+  }
+  peerAddressFamily = static_cast<uint8_t>(addr.getFamily());
+  peerPort = addr.getPort();
+  const auto ip = addr.getIPAddress();
+  std::memcpy(peerAddress.data(), ip.bytes(), ip.byteCount());
+}
+
+void ManagedConnection::fillConnectionStateRecord(
+    ConnectionStateRecord& record) const {
+  if (state_ != DrainState::NONE) {
+    record.state = ConnectionStateRecord::State::DRAINING;
+  } else if (isBusy()) {
+    record.state = ConnectionStateRecord::State::BUSY;
+  }
+  auto saturateMs = [](std::chrono::milliseconds ms) {
+    const auto count = std::max<int64_t>(ms.count(), 0);
+    return static_cast<uint32_t>(std::min<int64_t>(
+        count, ConnectionStateRecord::kNoActivity - 1));
+  };
+  record.idleTimeMs = saturateMs(getIdleTime());
+  if (auto elapsed = getLastActivityElapsedTime()) {
+    record.sinceLastActivityMs = saturateMs(*elapsed);
+  }
+}
+
 void ConnectionAgeTimeout::timeoutExpired() noexcept {
   if (auto connectionManager = connection_.getConnectionManager()) {
     connectionManager->removeConnection(&connection_);
@@ -17,9 +17,12 @@
 #pragma once
 
 #include <folly/IntrusiveList.h>
+#include <folly/SocketAddress.h>
 #include <folly/io/async/DelayedDestruction.h>
 #include <folly/io/async/HHWheelTimer.h>
 
+#include <array>
+#include <memory>
 #include <ostream>
 #include <string>
 
@@ -37,6 +40,39 @@ class ConnectionAgeTimeout : public folly::HHWheelTimer::Callback {
  private:
   ManagedConnection& connection_;
 };
+/**
+ * Fixed-size binary record describing one connection, produced in bulk
+ * by ConnectionManager::exportConnectionStates(). Dumping the state of
+ * millions of connections through the textual per-connection interface
+ * (describe / dumpConnectionState) costs minutes of EventBase time and
+ * gigabytes of output; a stream of these records answers the same
+ * question in a sub-second scan.
+ */
+struct ConnectionStateRecord {
+  enum class State : uint8_t { IDLE = 0, BUSY = 1, DRAINING = 2 };
+
+  /** Sentinel for sinceLastActivityMs when no activity was reported */
+  static constexpr uint32_t kNoActivity = ~uint32_t(0);
+
+  State state{State::IDLE};
+  /** AF_INET or AF_INET6; 0 when the peer address is unknown */
+  uint8_t peerAddressFamily{0};
+  /** Peer port in host byte order */
+  uint16_t peerPort{0};
+  /** Peer address bytes in network order; IPv4 uses the first 4 */
+  std::array<uint8_t, 16> peerAddress{};
+  /** ManagedConnection::getIdleTime(), saturated */
+  uint32_t idleTimeMs{0};
+  /** Time since last reported activity, saturated; see kNoActivity */
+  uint32_t sinceLastActivityMs{kNoActivity};
+  /** Application byte counts, when the subclass tracks them */
+  uint64_t bytesReceived{0};
+  uint64_t bytesSent{0};
+
+  /** Convenience for fillConnectionStateRecord() overrides */
+  void setPeerAddress(const folly::SocketAddress& addr);
+};
+
 /**
  * Interface describing a connection that can be managed by a
  * container such as an Acceptor.
@@ -113,11 +149,29 @@ class ManagedConnection : public folly::HHWheelTimer::Callback,
    */
   virtual void dropConnection(const std::string& errorMsg = "") = 0;
 
+  /**
+   * Emergency teardown used by bulk shutdown (see
+   * ConnectionManager::dropAllConnections(bool)).  Implementations may
+   * release their resources directly without per-connection close
+   * notification; the default falls back to dropConnection().
+   */
+  virtual void dropConnectionHard() {
+    dropConnection();
+  }
+
   /**
    * Dump the state of the connection to the log
    */
   virtual void dumpConnectionState(uint8_t loglevel) = 0;
 
+  /**
+   * Fill the bulk-export record for this connection; see
+   * ConnectionManager::exportConnectionStates(). The base fills the
+   * state and age fields; subclasses that know their transport should
+   * call through and add the peer address and byte counts.
+   */
+  virtual void fillConnectionStateRecord(ConnectionStateRecord& record) const;
+
   /**
    * If the connection has a connection manager, reset the timeout countdown to
    * connection manager's default timeout.
@@ -153,25 +207,38 @@ class ManagedConnection : public folly::HHWheelTimer::Callback,
   ~ManagedConnection() override;
 
  private:
-  enum class DrainState {
+  enum class DrainState : uint8_t {
     NONE,
     SENT_NOTIFY_PENDING_SHUTDOWN,
     SENT_CLOSE_WHEN_IDLE,
   };
 
-  DrainState state_{DrainState::NONE};
-
   friend class ConnectionManager;
 
   void setConnectionManager(ConnectionManager* mgr) {
     connectionManager_ = mgr;
   }
 
+  // Per-connection footprint matters at millions of connections per
+  // box: members below are kept word-packed, the activity timestamp
+  // uses a sentinel instead of a 2-word folly::Optional, and the age
+  // timeout callback is only allocated when the manager actually has a
+  // connection age timeout configured. The sizeof regression test in
+  // ConnectionManagerTest ratchets this.
   ConnectionManager* connectionManager_;
-  ConnectionAgeTimeout connectionAgeTimeout_;
-  folly::Optional<std::chrono::steady_clock::time_point> latestActivity_;
+  std::unique_ptr<ConnectionAgeTimeout> connectionAgeTimeout_;
+  // time_point::min() means no activity reported yet
+  std::chrono::steady_clock::time_point latestActivity_{
+      std::chrono::steady_clock::time_point::min()};
 
   folly::SafeIntrusiveListHook listHook_;
+
+  // Idle-timeout state owned by ConnectionManager when coalesced idle
+  // timeouts are enabled; see ConnectionManager::setCoalescedIdleTimeouts.
+  std::chrono::steady_clock::time_point idleBucketDeadline_;
+  folly::SafeIntrusiveListHook idleBucketHook_;
+
+  DrainState state_{DrainState::NONE};
 };
 
 std::ostream& operator<<(std::ostream& os, const ManagedConnection& conn);
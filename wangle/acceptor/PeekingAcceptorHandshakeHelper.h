@@ -18,6 +18,7 @@
 
 #include <wangle/acceptor/AcceptorHandshakeManager.h>
 #include <wangle/acceptor/SocketPeeker.h>
+#include <wangle/channel/PipelineContextPool.h>
 
 namespace wangle {
 
@@ -44,7 +45,7 @@ class PeekingAcceptorHandshakeHelper : public AcceptorHandshakeHelper,
     }
 
     virtual AcceptorHandshakeHelper::UniquePtr getHelper(
-        const std::vector<uint8_t>& peekedBytes,
+        folly::ByteRange peekedBytes,
         const folly::SocketAddress& clientAddr,
         std::chrono::steady_clock::time_point acceptTime,
         TransportInfo& tinfo) = 0;
@@ -65,6 +66,18 @@ class PeekingAcceptorHandshakeHelper : public AcceptorHandshakeHelper,
         peekCallbacks_(peekCallbacks),
         numBytes_(numBytes) {}
 
+  // One of these is allocated per accepted connection; recycle the blocks
+  // through the IO thread's context pool. Safe because the helper is
+  // created and destroyed on the accept thread (offload wraps the inner
+  // protocol helper, not this one).
+  void* operator new(size_t size) {
+    return PipelineContextPool::getThreadLocal()->allocate(size);
+  }
+
+  void operator delete(void* p, size_t size) {
+    PipelineContextPool::getThreadLocal()->deallocate(p, size);
+  }
+
   // From AcceptorHandshakeHelper
   void start(
       folly::AsyncSSLSocket::UniquePtr sock,
@@ -81,13 +94,27 @@ class PeekingAcceptorHandshakeHelper : public AcceptorHandshakeHelper,
   void dropConnection(SSLErrorEnum reason = SSLErrorEnum::NO_ERROR) override {
     CHECK_NE(socket_.get() == nullptr, helper_.get() == nullptr);
     if (socket_) {
+      folly::DelayedDestruction::DestructorGuard dg(this);
+      // Stop peeking before closing; the MSG_PEEK path watches the fd
+      // directly and must deregister before the fd goes away.
+      peeker_ = nullptr;
       socket_->closeNow();
+      if (callback_) {
+        // The peeker can no longer signal us; fail the peek ourselves.
+        auto callback = std::exchange(callback_, nullptr);
+        callback->connectionError(
+            socket_.get(),
+            folly::make_exception_wrapper<folly::AsyncSocketException>(
+                folly::AsyncSocketException::AsyncSocketExceptionType::UNKNOWN,
+                "connection dropped while peeking"),
+            folly::none);
+      }
     } else if (helper_) {
       helper_->dropConnection(reason);
     }
   }
 
-  void peekSuccess(std::vector<uint8_t> peekBytes) noexcept override {
+  void peekSuccess(folly::ByteRange peekBytes) noexcept override {
     folly::DelayedDestruction::DestructorGuard dg(this);
     peeker_ = nullptr;
 
@@ -155,10 +182,23 @@ class PeekingAcceptorHandshakeManager : public AcceptorHandshakeManager {
         peekCallbacks_(peekCallbacks),
         numBytes_(numBytes) {}
 
+  // Like the helper above, pooled per IO thread; the manager's terminal
+  // callbacks always run on the accept thread, so it is destroyed where
+  // it was allocated.
+  void* operator new(size_t size) {
+    return PipelineContextPool::getThreadLocal()->allocate(size);
+  }
+
+  void operator delete(void* p, size_t size) {
+    PipelineContextPool::getThreadLocal()->deallocate(p, size);
+  }
+
  protected:
   void startHelper(folly::AsyncSSLSocket::UniquePtr sock) override {
-    helper_.reset(new PeekingAcceptorHandshakeHelper(
-        clientAddr_, acceptTime_, tinfo_, peekCallbacks_, numBytes_));
+    AcceptorHandshakeHelper::UniquePtr helper(
+        new PeekingAcceptorHandshakeHelper(
+            clientAddr_, acceptTime_, tinfo_, peekCallbacks_, numBytes_));
+    helper_ = maybeOffloadHelper(std::move(helper));
     helper_->start(std::move(sock), this);
   }
 
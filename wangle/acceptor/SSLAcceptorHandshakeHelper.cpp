@@ -44,18 +44,22 @@ void SSLAcceptorHandshakeHelper::fillSSLTransportInfoFields(
   tinfo.securityType = sock->getSecurityProtocol();
   tinfo.sslSetupBytesRead = folly::to_narrow(sock->getRawBytesReceived());
   tinfo.sslSetupBytesWritten = folly::to_narrow(sock->getRawBytesWritten());
+  tinfo.sslVersion = sock->getSSLVersion();
+  tinfo.sslCertSize = sock->getSSLCertSize();
+  tinfo.sslResume = SSLUtil::getResumeState(sock);
+  if (!tinfo.fullCapture()) {
+    // Sampled-out connection: the trivially-copyable core above is all
+    // that is retained; skip materializing the string fields.
+    return;
+  }
   tinfo.sslServerName = sock->getSSLServerName()
       ? std::make_shared<std::string>(sock->getSSLServerName())
       : nullptr;
-  tinfo.sslCipher = sock->getNegotiatedCipherName()
-      ? std::make_shared<std::string>(sock->getNegotiatedCipherName())
-      : nullptr;
-  tinfo.sslVersion = sock->getSSLVersion();
+  // Cipher and signature algorithm names come from a tiny fixed set, so
+  // share one interned copy per value instead of allocating per connection.
+  tinfo.sslCipher = SSLUtil::internString(sock->getNegotiatedCipherName());
   const char* sigAlgName = sock->getSSLCertSigAlgName();
-  tinfo.sslCertSigAlgName =
-      std::make_shared<std::string>(sigAlgName ? sigAlgName : "");
-  tinfo.sslCertSize = sock->getSSLCertSize();
-  tinfo.sslResume = SSLUtil::getResumeState(sock);
+  tinfo.sslCertSigAlgName = SSLUtil::internString(sigAlgName ? sigAlgName : "");
   tinfo.sslClientCiphers = std::make_shared<std::string>();
   sock->getSSLClientCiphers(*tinfo.sslClientCiphers);
   tinfo.sslClientCiphersHex = std::make_shared<std::string>();
@@ -108,6 +112,8 @@ void SSLAcceptorHandshakeHelper::handshakeSuc(AsyncSSLSocket* sock) noexcept {
 void SSLAcceptorHandshakeHelper::handshakeErr(
     AsyncSSLSocket* sock,
     const AsyncSocketException& ex) noexcept {
+  // Failures always log at full fidelity, sampled or not.
+  tinfo_.captureLevel = TransportInfo::CaptureLevel::FULL;
   auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - acceptTime_);
   VLOG(3) << "SSL handshake error with " << describeAddresses(sock) << " after "
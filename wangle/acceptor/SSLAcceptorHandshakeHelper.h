@@ -72,7 +72,7 @@ class DefaultToSSLPeekingCallback
       : PeekingAcceptorHandshakeHelper::PeekCallback(0) {}
 
   AcceptorHandshakeHelper::UniquePtr getHelper(
-      const std::vector<uint8_t>& /* bytes */,
+      folly::ByteRange /* bytes */,
       const folly::SocketAddress& clientAddr,
       std::chrono::steady_clock::time_point acceptTime,
       TransportInfo& tinfo) override {
@@ -16,10 +16,66 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Random.h>
 #include <wangle/acceptor/PeekingAcceptorHandshakeHelper.h>
 
 namespace wangle {
 
+/**
+ * Handshake manager for the single-protocol fast path: with exactly one
+ * registered peek callback that needs no peeked bytes (e.g. only Fizz),
+ * the protocol helper can be started directly, skipping the peeking
+ * helper and socket peeker entirely.
+ */
+class DirectHandshakeManager : public AcceptorHandshakeManager {
+ public:
+  DirectHandshakeManager(
+      Acceptor* acceptor,
+      const folly::SocketAddress& clientAddr,
+      std::chrono::steady_clock::time_point acceptTime,
+      TransportInfo tinfo,
+      PeekingCallbackPtr callback)
+      : AcceptorHandshakeManager(
+            acceptor,
+            clientAddr,
+            acceptTime,
+            std::move(tinfo)),
+        callback_(callback) {}
+
+  // Pooled per IO thread, like PeekingAcceptorHandshakeManager
+  void* operator new(size_t size) {
+    return PipelineContextPool::getThreadLocal()->allocate(size);
+  }
+
+  void operator delete(void* p, size_t size) {
+    PipelineContextPool::getThreadLocal()->deallocate(p, size);
+  }
+
+ protected:
+  void startHelper(folly::AsyncSSLSocket::UniquePtr sock) override {
+    auto helper = callback_->getHelper({}, clientAddr_, acceptTime_, tinfo_);
+    if (!helper) {
+      auto type =
+          folly::AsyncSocketException::AsyncSocketExceptionType::CORRUPTED_DATA;
+      connectionError(
+          sock.get(),
+          folly::make_exception_wrapper<folly::AsyncSocketException>(
+              type, "Unrecognized protocol"),
+          folly::none);
+      return;
+    }
+    helper_ = maybeOffloadHelper(std::move(helper));
+    helper_->start(std::move(sock), this);
+  }
+
+ private:
+  PeekingCallbackPtr callback_;
+};
+
 /**
  * This class holds different peekers that will be used to get the appropriate
  * AcceptorHandshakeHelper to handle the security protocol negotiation.
@@ -28,7 +84,9 @@ class SecurityProtocolContextManager {
  public:
   /**
    * Adds a peeker to be used when accepting connections on a secure port.
-   * Peekers will be used in the order they are added.
+   * Peekers will be used in the order they are added. The peek length is
+   * folded into a running maximum here so dispatch never rescans the
+   * callbacks.
    */
   void addPeeker(PeekingCallbackPtr peekingCallback) {
     if (peekingCallback->getBytesRequired() > numBytes_) {
@@ -37,11 +95,127 @@ class SecurityProtocolContextManager {
     peekingCallbacks_.push_back(std::move(peekingCallback));
   }
 
+  /**
+   * Registers a named handshake stack for weighted sampling. When any
+   * sampled stacks are registered they take precedence over addPeeker()
+   * dispatch: each connection draws one stack with probability
+   * weight / (sum of weights), the draw is recorded in
+   * TransportInfo::handshakeStack, and handshake outcomes are
+   * aggregated per stack (see getStackStats()). Migrating between two
+   * stacks that speak the same protocol — say SSLAcceptorHandshakeHelper
+   * and Fizz — is then a weight ramp with live comparative evidence
+   * instead of an all-or-nothing listener config flip, and rollback is
+   * setStackWeight(name, 0). A stack whose callback needs no peeked
+   * bytes keeps the direct (peek-skipping) path.
+   *
+   * Like the rest of this class, accessed only on the owning acceptor's
+   * thread; weight changes take effect on the next connection.
+   */
+  void addSampledStack(
+      std::string name,
+      PeekingCallbackPtr callback,
+      uint32_t weight) {
+    auto stack = std::make_unique<SampledStack>();
+    stack->name = std::move(name);
+    stack->callbacks.push_back(callback);
+    stack->weight = weight;
+    totalWeight_ += weight;
+    stacks_.push_back(std::move(stack));
+  }
+
+  /**
+   * Adjusts a sampled stack's weight; the ramp/rollback lever. Returns
+   * false if no stack has that name.
+   */
+  bool setStackWeight(const std::string& name, uint32_t weight) {
+    for (auto& stack : stacks_) {
+      if (stack->name == name) {
+        totalWeight_ = totalWeight_ - stack->weight + weight;
+        stack->weight = weight;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Per-stack sampling outcome aggregates. Success rate and latency
+   * side by side across stacks is the ramp evidence.
+   */
+  struct StackStats {
+    std::string name;
+    uint32_t weight{0};
+    uint64_t sampled{0};
+    uint64_t successes{0};
+    uint64_t failures{0};
+    uint64_t totalLatencyMs{0};
+    uint64_t maxLatencyMs{0};
+  };
+
+  std::vector<StackStats> getStackStats() const {
+    std::vector<StackStats> result;
+    result.reserve(stacks_.size());
+    for (const auto& stack : stacks_) {
+      result.push_back(stack->stats);
+      result.back().name = stack->name;
+      result.back().weight = stack->weight;
+    }
+    return result;
+  }
+
+  /**
+   * Folds a completed handshake into the named stack's aggregates;
+   * called by AcceptorHandshakeManager for connections that carry a
+   * stack tag. A name no stack owns is ignored.
+   */
+  void recordHandshakeResult(
+      const std::string& name,
+      std::chrono::milliseconds latency,
+      bool success) {
+    for (auto& stack : stacks_) {
+      if (stack->name != name) {
+        continue;
+      }
+      auto& stats = stack->stats;
+      if (success) {
+        stats.successes++;
+      } else {
+        stats.failures++;
+      }
+      const auto ms = static_cast<uint64_t>(std::max<int64_t>(
+          latency.count(), 0));
+      stats.totalLatencyMs += ms;
+      stats.maxLatencyMs = std::max(stats.maxLatencyMs, ms);
+      return;
+    }
+  }
+
   AcceptorHandshakeManager* getHandshakeManager(
       Acceptor* acceptor,
       const folly::SocketAddress& clientAddr,
       std::chrono::steady_clock::time_point acceptTime,
       TransportInfo& tinfo) noexcept {
+    if (totalWeight_ > 0) {
+      auto& stack = pickStack();
+      stack.stats.sampled++;
+      tinfo.handshakeStack = stack.name;
+      auto* callback = stack.callbacks.front();
+      if (callback->getBytesRequired() == 0) {
+        return new DirectHandshakeManager(
+            acceptor, clientAddr, acceptTime, tinfo, callback);
+      }
+      return new PeekingAcceptorHandshakeManager(
+          acceptor,
+          clientAddr,
+          acceptTime,
+          tinfo,
+          stack.callbacks,
+          callback->getBytesRequired());
+    }
+    if (!usesPeekDispatch()) {
+      return new DirectHandshakeManager(
+          acceptor, clientAddr, acceptTime, tinfo, peekingCallbacks_.front());
+    }
     return new PeekingAcceptorHandshakeManager(
         acceptor, clientAddr, acceptTime, tinfo, peekingCallbacks_, numBytes_);
   }
@@ -50,7 +224,38 @@ class SecurityProtocolContextManager {
     return numBytes_;
   }
 
+  /**
+   * Whether connections go through peek dispatch. False with a single
+   * registered protocol that does not inspect peeked bytes, where the
+   * peek is skipped entirely.
+   */
+  bool usesPeekDispatch() const {
+    return peekingCallbacks_.size() != 1 || numBytes_ != 0;
+  }
+
  private:
+  struct SampledStack {
+    std::string name;
+    // Single element; PeekingAcceptorHandshakeManager keeps a reference
+    // to this vector, hence the stable per-stack storage.
+    std::vector<PeekingCallbackPtr> callbacks;
+    uint32_t weight{0};
+    StackStats stats;
+  };
+
+  SampledStack& pickStack() {
+    auto draw = folly::Random::rand64(totalWeight_);
+    for (auto& stack : stacks_) {
+      if (draw < stack->weight) {
+        return *stack;
+      }
+      draw -= stack->weight;
+    }
+    // Unreachable with totalWeight_ > 0; keep the last stack as a
+    // deterministic fallback.
+    return *stacks_.back();
+  }
+
   /**
    * Peeking callbacks for each handshake protocol.
    */
@@ -60,6 +265,13 @@ class SecurityProtocolContextManager {
    * Highest number of bytes required by a peeking callback.
    */
   size_t numBytes_{0};
+
+  /**
+   * Weighted A/B handshake stacks; when non-empty (with non-zero total
+   * weight) they replace peek-order dispatch.
+   */
+  std::vector<std::unique_ptr<SampledStack>> stacks_;
+  uint64_t totalWeight_{0};
 };
 
 } // namespace wangle
@@ -34,6 +34,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <chrono>
+#include <functional>
 #include <list>
 #include <string>
 
@@ -80,6 +81,35 @@ struct ServerSocketConfig {
     return socketOptions_;
   }
 
+  /**
+   * Register a named per-workload socket option profile (e.g.
+   * TCP_NOTSENT_LOWAT for latency-sensitive connections, large buffers
+   * for bulk transfer). A profile is chosen at accept time by
+   * socketOptionProfileClassifier and applied on top of the base
+   * options; a live connection can switch profiles later through
+   * applySocketOptions() in SocketOptions.h.
+   */
+  void addSocketOptionProfile(
+      const std::string& name,
+      const folly::SocketOptionMap& opts) {
+    socketOptionProfiles_[name] =
+        filterIPSocketOptions(opts, bindAddress.getFamily());
+  }
+
+  const folly::SocketOptionMap* findSocketOptionProfile(
+      const std::string& name) const {
+    auto it = socketOptionProfiles_.find(name);
+    return it != socketOptionProfiles_.end() ? &it->second : nullptr;
+  }
+
+  /**
+   * Picks the socket option profile for a newly accepted connection by
+   * peer address. An empty or unregistered name keeps just the base
+   * options; unset, no profile is ever applied at accept.
+   */
+  std::function<std::string(const folly::SocketAddress&)>
+      socketOptionProfileClassifier;
+
   bool hasExternalPrivateKey() const {
     for (const auto& cfg : sslContextConfigs) {
       if (!cfg.isLocalPrivateKey) {
@@ -111,6 +141,32 @@ struct ServerSocketConfig {
    */
   uint32_t maxNumPendingConnectionsPerWorker{1024};
 
+  /**
+   * How many pending connections the acceptor drains from the listen queue
+   * per event loop iteration. Larger values amortize the loop overhead when
+   * accepts arrive in bursts (e.g. reconnect storms after a failover) at the
+   * cost of fairness to other work on the accept thread.
+   */
+  uint32_t maxAcceptAtOnce{30};
+
+  /**
+   * How many UDP datagrams an acceptor may coalesce into one batched
+   * accept pipeline message (AcceptPipelineType::UdpBatchMsg). Datagrams
+   * received within an event loop iteration are delivered together once
+   * the batch fills or the iteration ends. Values <= 1 keep the
+   * one-message-per-datagram behavior.
+   */
+  uint32_t udpBatchSize{1};
+
+  /**
+   * Enable generic receive offload (GRO) on acceptor UDP sockets, so
+   * back-to-back datagrams of one flow arrive coalesced into a single
+   * buffer (OnDataAvailableParams::gro carries the segment size) and
+   * feed the batched delivery above with fewer recvmsg calls. Silently
+   * ineffective on kernels without UDP GRO support.
+   */
+  bool udpGro{false};
+
   /**
    * The number of milliseconds a connection can be idle before we close it.
    */
@@ -168,6 +224,63 @@ struct ServerSocketConfig {
    */
   uint32_t maxConcurrentSSLHandshakes{30720};
 
+  /**
+   * Number of pending SSL handshakes above which new handshakes spill over
+   * to the handshake offload pool, if one was set on the Acceptor.  Below
+   * the threshold handshakes run inline on the acceptor's EventBase,
+   * avoiding the cross-thread hop when the loop is not busy.  0 offloads
+   * every handshake.
+   */
+  uint32_t handshakeOffloadThreshold{0};
+
+  /**
+   * Maximum full SSL handshakes admitted per source address prefix per
+   * sliding window (see HandshakeRateLimiter).  Handshakes that resume
+   * a session are exempt: their admission is refunded once the
+   * handshake completes.  0 disables per-source admission control.
+   */
+  uint32_t maxHandshakesPerSourcePerWindow{0};
+
+  /**
+   * Width of the sliding window for maxHandshakesPerSourcePerWindow.
+   */
+  std::chrono::milliseconds handshakeRateLimitWindow{1000};
+
+  /**
+   * Source prefix lengths the handshake rate limiter aggregates on.
+   */
+  uint8_t handshakeRateLimitPrefixLengthV4{24};
+  uint8_t handshakeRateLimitPrefixLengthV6{56};
+
+  /**
+   * Target accept-to-active latency (TransportInfo::setupTime) for the
+   * accept governor.  When an acceptor's smoothed setup latency climbs
+   * above this target it temporarily pauses accepting, letting the kernel
+   * absorb (and eventually shed) the listen backlog instead of the process
+   * queueing handshakes it cannot finish in time.  Note that pausing acts
+   * on the listening socket, which may be shared by several acceptors.
+   * 0 disables the governor.
+   */
+  std::chrono::milliseconds acceptLatencyTarget{0};
+
+  /**
+   * How long the accept governor pauses accepting after the latency target
+   * is breached.  The pause is extended while the kernel listen backlog
+   * remains more than half full.
+   */
+  std::chrono::milliseconds acceptPauseDuration{100};
+
+  /**
+   * Worker-side companion to the accept governor: a connection that
+   * waited longer than this in its worker's accept queue is closed with
+   * a RST on arrival instead of starting a handshake it would likely
+   * time out of anyway.  The client's retry lands on a less loaded
+   * worker (or VIP peer) immediately, rather than after a multi-second
+   * handshake timeout.  Per-acceptor counts are exposed through
+   * Acceptor::getAcceptQueueStats().  0 disables shedding.
+   */
+  std::chrono::milliseconds acceptQueueDelayBudget{0};
+
   /**
    * Whether to enable TCP fast open. Before turning this
    * option on, for it to work, it must also be enabled on the
@@ -191,6 +304,15 @@ struct ServerSocketConfig {
    */
   uint32_t socketMaxReadsPerEvent{16};
 
+  /**
+   * Capture TransportInfo at full fidelity (string fields, cert
+   * details, tcp_info) for one in this many accepted connections;
+   * the rest keep only the trivially-copyable core. 0 or 1 captures
+   * every connection in full, the historical behavior. Error paths
+   * upgrade a connection back to full capture regardless of sampling.
+   */
+  uint32_t transportInfoSampleRate{0};
+
   /**
    * Enable so-reuseport while binding the listening socket
    */
@@ -206,6 +328,8 @@ struct ServerSocketConfig {
 
  private:
   folly::SocketOptionMap socketOptions_;
+  std::unordered_map<std::string, folly::SocketOptionMap>
+      socketOptionProfiles_;
 };
 
 } // namespace wangle
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/acceptor/ShardedConnectionManager.h>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+using std::chrono::milliseconds;
+
+namespace wangle {
+
+ShardedConnectionManager::ShardedConnectionManager(
+    folly::EventBase* eventBase,
+    milliseconds idleTimeout,
+    size_t numShards,
+    ConnectionManager::Callback* callback)
+    : eventBase_(eventBase),
+      callbackProxy_(*this),
+      callback_(callback),
+      walker_(*this) {
+  CHECK_GT(numShards, 0u);
+  wheels_.reserve(numShards);
+  shards_.reserve(numShards);
+  for (size_t i = 0; i < numShards; i++) {
+    wheels_.push_back(folly::HHWheelTimer::newTimer(eventBase));
+    auto shard = ConnectionManager::makeUnique(
+        eventBase, idleTimeout, callback ? &callbackProxy_ : nullptr);
+    shard->setTimeoutWheel(wheels_.back().get());
+    shards_.push_back(std::move(shard));
+  }
+}
+
+void ShardedConnectionManager::addConnection(
+    ManagedConnection* connection,
+    bool idleTimeout,
+    bool connectionAgeTimeout) {
+  shards_[nextShard_]->addConnection(
+      connection, idleTimeout, connectionAgeTimeout);
+  nextShard_ = (nextShard_ + 1) % shards_.size();
+}
+
+void ShardedConnectionManager::removeConnection(ManagedConnection* connection) {
+  auto* shard = connection->getConnectionManager();
+  if (shard) {
+    shard->removeConnection(connection);
+  }
+}
+
+size_t ShardedConnectionManager::getNumConnections() const {
+  size_t total = 0;
+  for (const auto& shard : shards_) {
+    total += shard->getNumConnections();
+  }
+  return total;
+}
+
+void ShardedConnectionManager::initiateGracefulShutdown(
+    milliseconds idleGrace) {
+  enqueueShardOp([idleGrace](ConnectionManager& shard) {
+    shard.initiateGracefulShutdown(idleGrace);
+  });
+}
+
+void ShardedConnectionManager::drainConnections(
+    double pct,
+    milliseconds idleGrace) {
+  enqueueShardOp([pct, idleGrace](ConnectionManager& shard) {
+    shard.drainConnections(pct, idleGrace);
+  });
+}
+
+void ShardedConnectionManager::dropConnections(double pct) {
+  enqueueShardOp(
+      [pct](ConnectionManager& shard) { shard.dropConnections(pct); });
+}
+
+void ShardedConnectionManager::dropAllConnections() {
+  DestructorGuard g(this);
+  // Abandon any staged incremental work; everything is going away now.
+  pendingOps_.clear();
+  walkShard_ = 0;
+  if (walker_.isLoopCallbackScheduled()) {
+    walker_.cancelLoopCallback();
+  }
+  for (auto& shard : shards_) {
+    shard->dropAllConnections();
+  }
+}
+
+size_t ShardedConnectionManager::dropIdleConnections(size_t num) {
+  // First pass takes an even share from each shard so one shard's idle
+  // connections aren't exhausted first; second pass greedily makes up any
+  // shortfall from shards that still have droppable ones.
+  const size_t perShard = (num + shards_.size() - 1) / shards_.size();
+  size_t dropped = 0;
+  for (auto& shard : shards_) {
+    if (dropped >= num) {
+      break;
+    }
+    dropped += shard->dropIdleConnections(std::min(perShard, num - dropped));
+  }
+  for (auto& shard : shards_) {
+    if (dropped >= num) {
+      break;
+    }
+    dropped += shard->dropIdleConnections(num - dropped);
+  }
+  return dropped;
+}
+
+void ShardedConnectionManager::setLoweredIdleTimeout(milliseconds timeout) {
+  for (auto& shard : shards_) {
+    shard->setLoweredIdleTimeout(timeout);
+  }
+}
+
+void ShardedConnectionManager::setCoalescedIdleTimeouts(
+    milliseconds granularity) {
+  for (auto& shard : shards_) {
+    shard->setCoalescedIdleTimeouts(granularity);
+  }
+}
+
+void ShardedConnectionManager::enqueueShardOp(ShardOp op) {
+  pendingOps_.push_back(std::move(op));
+  if (!walker_.isLoopCallbackScheduled()) {
+    eventBase_->runInLoop(&walker_);
+  }
+}
+
+void ShardedConnectionManager::walkOneShard() {
+  DestructorGuard g(this);
+  if (pendingOps_.empty()) {
+    return;
+  }
+  VLOG(4) << this << " applying management op to shard " << walkShard_;
+  pendingOps_.front()(*shards_[walkShard_]);
+  if (++walkShard_ == shards_.size()) {
+    walkShard_ = 0;
+    pendingOps_.pop_front();
+  }
+  if (!pendingOps_.empty()) {
+    eventBase_->runInLoop(&walker_);
+  }
+}
+
+void ShardedConnectionManager::CallbackProxy::onEmpty(
+    const ConnectionManager& cm) {
+  // Report empty only when the whole sharded set is empty, so callers see
+  // the same "last connection gone" semantics as with one manager.
+  if (manager_.callback_ && manager_.getNumConnections() == 0) {
+    manager_.callback_->onEmpty(cm);
+  }
+}
+
+void ShardedConnectionManager::CallbackProxy::onConnectionAdded(
+    const ManagedConnection* conn) {
+  if (manager_.callback_) {
+    manager_.callback_->onConnectionAdded(conn);
+  }
+}
+
+void ShardedConnectionManager::CallbackProxy::onConnectionRemoved(
+    const ManagedConnection* conn) {
+  if (manager_.callback_) {
+    manager_.callback_->onConnectionRemoved(conn);
+  }
+}
+
+} // namespace wangle
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <wangle/acceptor/ConnectionManager.h>
+
+#include <deque>
+#include <vector>
+
+#include <folly/Function.h>
+
+namespace wangle {
+
+/**
+ * A ShardedConnectionManager splits the connections of one EventBase across
+ * several internal ConnectionManager shards, each with its own intrusive
+ * list and its own HHWheelTimer.
+ *
+ * With a single ConnectionManager, drainConnections() and dropConnections()
+ * walk one list that can hold hundreds of thousands of entries, which stalls
+ * the IO loop. Here management operations visit one shard per event loop
+ * iteration (and each shard's own drain is further chunked), so the hot
+ * read path is never blocked for more than a shard's worth of work. The
+ * per-shard timeout wheels likewise keep a cascade of expiring idle timeouts
+ * from turning into one long callback run.
+ *
+ * Connections are assigned to shards round-robin at add time. A connection's
+ * getConnectionManager() points at its shard, so per-connection operations
+ * (removeConnection, reportActivity, timeout scheduling) go straight to the
+ * shard with no indirection through this class.
+ */
+class ShardedConnectionManager : public folly::DelayedDestruction {
+ public:
+  typedef std::unique_ptr<ShardedConnectionManager, Destructor> UniquePtr;
+
+  static constexpr size_t kDefaultNumShards = 8;
+
+  /**
+   * Returns a new instance of ShardedConnectionManager wrapped in a
+   * unique_ptr
+   */
+  template <typename... Args>
+  static UniquePtr makeUnique(Args&&... args) {
+    return UniquePtr(new ShardedConnectionManager(std::forward<Args>(args)...));
+  }
+
+  ShardedConnectionManager(
+      folly::EventBase* eventBase,
+      std::chrono::milliseconds idleTimeout,
+      size_t numShards = kDefaultNumShards,
+      ConnectionManager::Callback* callback = nullptr);
+
+  /**
+   * Add a connection to the next shard (round-robin).
+   */
+  void addConnection(
+      ManagedConnection* connection,
+      bool idleTimeout = false,
+      bool connectionAgeTimeout = false);
+
+  /**
+   * Remove a connection from the shard that owns it.
+   */
+  void removeConnection(ManagedConnection* connection);
+
+  size_t getNumConnections() const;
+
+  size_t getNumShards() const {
+    return shards_.size();
+  }
+
+  ConnectionManager& getShard(size_t i) {
+    return *shards_[i];
+  }
+
+  /**
+   * Begin gracefully shutting down all connections, one shard per event
+   * loop iteration.
+   */
+  void initiateGracefulShutdown(std::chrono::milliseconds idleGrace);
+
+  /**
+   * Gracefully shutdown "pct" of the connections of each shard, one shard
+   * per event loop iteration.
+   */
+  void drainConnections(double pct, std::chrono::milliseconds idleGrace);
+
+  /**
+   * Force-stop "pct" of the connections of each shard, one shard per event
+   * loop iteration.
+   */
+  void dropConnections(double pct);
+
+  /**
+   * Destroy all connections, even the busy ones. Synchronous: this is the
+   * hard-shutdown path where stalling the loop no longer matters.
+   */
+  void dropAllConnections();
+
+  /**
+   * Try to drop num idle connections, spread evenly across shards. Return
+   * the actual number dropped. Synchronous, but bounded by num.
+   */
+  size_t dropIdleConnections(size_t num);
+
+  void setLoweredIdleTimeout(std::chrono::milliseconds timeout);
+
+  /**
+   * Enable coalesced idle timeouts on every shard; see
+   * ConnectionManager::setCoalescedIdleTimeouts.
+   */
+  void setCoalescedIdleTimeouts(std::chrono::milliseconds granularity);
+
+  /**
+   * Visit every connection in every shard. Walks all shards inline; meant
+   * for stats and debugging, not for the hot path.
+   */
+  template <typename F>
+  void forEachConnection(F func) {
+    for (auto& shard : shards_) {
+      shard->forEachConnection(func);
+    }
+  }
+
+ protected:
+  ~ShardedConnectionManager() override = default;
+
+ private:
+  ShardedConnectionManager(const ShardedConnectionManager&) = delete;
+  ShardedConnectionManager& operator=(ShardedConnectionManager&) = delete;
+
+  /**
+   * Applies queued management operations to one shard per event loop
+   * iteration, re-arming itself until every shard has been visited.
+   */
+  class ShardWalker : public folly::EventBase::LoopCallback {
+   public:
+    explicit ShardWalker(ShardedConnectionManager& manager)
+        : manager_(manager) {}
+
+    void runLoopCallback() noexcept override {
+      manager_.walkOneShard();
+    }
+
+   private:
+    ShardedConnectionManager& manager_;
+  };
+
+  /**
+   * Forwards shard callbacks to the user's callback, firing onEmpty only
+   * when every shard has emptied.
+   */
+  class CallbackProxy : public ConnectionManager::Callback {
+   public:
+    explicit CallbackProxy(ShardedConnectionManager& manager)
+        : manager_(manager) {}
+
+    void onEmpty(const ConnectionManager& cm) override;
+    void onConnectionAdded(const ManagedConnection* conn) override;
+    void onConnectionRemoved(const ManagedConnection* conn) override;
+
+   private:
+    ShardedConnectionManager& manager_;
+  };
+
+  using ShardOp = folly::Function<void(ConnectionManager&)>;
+
+  void enqueueShardOp(ShardOp op);
+  void walkOneShard();
+
+  folly::EventBase* eventBase_;
+  CallbackProxy callbackProxy_;
+  ConnectionManager::Callback* callback_;
+
+  /** One wheel per shard; must be declared before shards_ (shards keep raw
+   *  pointers into it) and therefore outlives them on destruction. */
+  std::vector<folly::HHWheelTimer::UniquePtr> wheels_;
+  std::vector<ConnectionManager::UniquePtr> shards_;
+
+  /** Next shard for round-robin connection placement */
+  size_t nextShard_{0};
+
+  /** Queued management operations; front op is in progress on walkShard_ */
+  std::deque<ShardOp> pendingOps_;
+  size_t walkShard_{0};
+  ShardWalker walker_;
+};
+
+} // namespace wangle
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <fizz/server/AsyncFizzServer.h>
+#include <folly/Executor.h>
 #include <fizz/server/CertManager.h>
 #include <fizz/server/TicketCipher.h>
 #include <fizz/server/TicketCodec.h>
@@ -24,6 +25,7 @@
 #include <wangle/acceptor/Acceptor.h>
 #include <wangle/acceptor/FizzConfigUtil.h>
 #include <wangle/acceptor/ServerSocketConfig.h>
+#include <wangle/ssl/CertFileRegistry.h>
 #include <wangle/ssl/SSLContextManager.h>
 #include <wangle/ssl/TLSTicketKeySeeds.h>
 
@@ -82,8 +84,17 @@ class SharedSSLContextManager {
 template <typename FizzConfigUtilT>
 class SharedSSLContextManagerImpl : public SharedSSLContextManager {
  public:
-  explicit SharedSSLContextManagerImpl(ServerSocketConfig config)
-      : SharedSSLContextManager(config) {
+  /**
+   * If certParsingExecutor is provided, the initial load and every
+   * reload warm the process-wide CertFileRegistry on it, reading and
+   * hashing cert files in parallel before the contexts are built.
+   * Without one the registry is still used, just warmed inline.
+   */
+  explicit SharedSSLContextManagerImpl(
+      ServerSocketConfig config,
+      std::shared_ptr<folly::Executor> certParsingExecutor = nullptr)
+      : SharedSSLContextManager(config),
+        certParsingExecutor_(std::move(certParsingExecutor)) {
     try {
       reloadContexts();
       LOG(INFO) << "Initialized SSL context configs";
@@ -143,6 +154,13 @@ class SharedSSLContextManagerImpl : public SharedSSLContextManager {
  protected:
   // recreates contexts using config_ and seeds_
   void reloadContexts() {
+    auto certRegistry = CertFileRegistry::getInstance();
+    if (certRegistry) {
+      // Warm the shared registry up front: only changed files hit disk,
+      // and sibling managers loading the same certs find them cached.
+      certRegistry->prefetch(
+          collectCertFilePaths(config_), certParsingExecutor_.get());
+    }
     if (config_.fizzConfig.enableFizz) {
       certManager_ = FizzConfigUtilT::createCertManager(config_, nullptr);
       fizzContext_ = FizzConfigUtilT::createFizzContext(config_);
@@ -160,6 +178,7 @@ class SharedSSLContextManagerImpl : public SharedSSLContextManager {
     }
     auto ctxManager = std::make_shared<SSLContextManager>(
         "vip_" + config_.name, config_.strictSSL, nullptr);
+    ctxManager->setCertFileRegistry(certRegistry);
     for (const auto& sslCtxConfig : config_.sslContextConfigs) {
       ctxManager->addSSLContextConfig(
           sslCtxConfig,
@@ -200,6 +219,24 @@ class SharedSSLContextManagerImpl : public SharedSSLContextManager {
     }
     return pskContext;
   }
+
+  // Paths of the file-backed, unencrypted certs and keys in config; the
+  // ones loadCertsFromFiles will serve out of the registry.
+  static std::vector<std::string> collectCertFilePaths(
+      const ServerSocketConfig& config) {
+    std::vector<std::string> paths;
+    for (const auto& ctxConfig : config.sslContextConfigs) {
+      for (const auto& cert : ctxConfig.certificates) {
+        if (!cert.isBuffer && cert.passwordPath.empty()) {
+          paths.push_back(cert.certPath);
+          paths.push_back(cert.keyPath);
+        }
+      }
+    }
+    return paths;
+  }
+
+  std::shared_ptr<folly::Executor> certParsingExecutor_;
 };
 
 class AcceptorFactorySharedSSLContext : public AcceptorFactory {
@@ -41,4 +41,38 @@ folly::SocketOptionMap filterIPSocketOptions(
   return opts;
 }
 
+int applySocketOptions(
+    folly::AsyncTransport* transport,
+    const folly::SocketOptionMap& options) {
+  auto* socket =
+      transport ? transport->getUnderlyingTransport<folly::AsyncSocket>()
+                : nullptr;
+  if (!socket) {
+    return -1;
+  }
+  auto fd = socket->getNetworkSocket();
+  if (fd == folly::NetworkSocket()) {
+    return -1;
+  }
+
+  folly::SocketAddress addr;
+  socket->getLocalAddress(&addr);
+  const auto family = addr.getFamily();
+  // Non-IP sockets (e.g. AF_UNIX in tests) take the map as given.
+  folly::SocketOptionMap filtered;
+  const folly::SocketOptionMap* opts = &options;
+  if (family == AF_INET || family == AF_INET6) {
+    filtered = filterIPSocketOptions(options, family);
+    opts = &filtered;
+  }
+
+  int applied = 0;
+  for (const auto& opt : *opts) {
+    if (opt.first.apply(fd, opt.second) == 0) {
+      applied++;
+    }
+  }
+  return applied;
+}
+
 } // namespace wangle
@@ -29,4 +29,15 @@ folly::SocketOptionMap filterIPSocketOptions(
     const folly::SocketOptionMap& allOptions,
     const int addrFamily);
 
+/**
+ * Apply a socket option map to a live transport's underlying socket,
+ * so a connection can switch between per-workload option profiles
+ * mid-life (see ServerSocketConfig::addSocketOptionProfile). Options
+ * for the wrong IP level are skipped. Returns the number of options
+ * applied, or -1 when the transport has no underlying AsyncSocket fd.
+ */
+int applySocketOptions(
+    folly::AsyncTransport* transport,
+    const folly::SocketOptionMap& options);
+
 } // namespace wangle
@@ -16,8 +16,11 @@
 
 #pragma once
 
+#include <folly/Range.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTransport.h>
+#include <folly/io/async/EventHandler.h>
+#include <folly/net/NetOps.h>
 #include <array>
 
 namespace wangle {
@@ -30,7 +33,8 @@ class TransportPeeker : public folly::AsyncTransport::ReadCallback,
   class Callback {
    public:
     virtual ~Callback() = default;
-    virtual void peekSuccess(std::vector<uint8_t> data) noexcept = 0;
+    // The peeked bytes are only valid for the duration of the callback.
+    virtual void peekSuccess(folly::ByteRange data) noexcept = 0;
     virtual void peekError(const folly::AsyncSocketException& ex) noexcept = 0;
   };
 
@@ -40,7 +44,7 @@ class TransportPeeker : public folly::AsyncTransport::ReadCallback,
       size_t numBytes)
       : transport_(transport),
         transportCallback_(callback),
-        peekBytes_(numBytes) {}
+        numBytes_(numBytes) {}
 
   ~TransportPeeker() override {
     if (transport_.getReadCallback() == this) {
@@ -48,12 +52,13 @@ class TransportPeeker : public folly::AsyncTransport::ReadCallback,
     }
   }
 
-  void start() {
-    if (peekBytes_.size() == 0) {
+  virtual void start() {
+    if (numBytes_ == 0) {
       // No peeking necessary.
       auto callback = std::exchange(transportCallback_, nullptr);
-      callback->peekSuccess(std::move(peekBytes_));
+      callback->peekSuccess(folly::ByteRange());
     } else {
+      peekBytes_.resize(numBytes_);
       transport_.setReadCB(this);
     }
   }
@@ -90,7 +95,7 @@ class TransportPeeker : public folly::AsyncTransport::ReadCallback,
     if (read_ == peekBytes_.size()) {
       transport_.setReadCB(nullptr);
       auto callback = std::exchange(transportCallback_, nullptr);
-      callback->peekSuccess(std::move(peekBytes_));
+      callback->peekSuccess(folly::range(peekBytes_));
     }
   }
 
@@ -100,6 +105,9 @@ class TransportPeeker : public folly::AsyncTransport::ReadCallback,
     return false;
   }
 
+ protected:
+  const size_t numBytes_;
+
  private:
   folly::AsyncTransport& transport_;
   Callback* transportCallback_;
@@ -107,7 +115,20 @@ class TransportPeeker : public folly::AsyncTransport::ReadCallback,
   std::vector<uint8_t> peekBytes_;
 };
 
-class SocketPeeker : public TransportPeeker, private TransportPeeker::Callback {
+/**
+ * Peeks at the first bytes of an AsyncSocket.
+ *
+ * When the socket has a raw fd the bytes are examined in place with
+ * recv(MSG_PEEK): nothing is consumed from the kernel buffer, so no replay
+ * buffer needs to be attached to the socket and the peek adds no copies
+ * and no per-connection allocations.  Sockets without an fd (or peeks
+ * larger than the inline buffer) fall back to the consuming
+ * TransportPeeker path, with the consumed bytes handed back to the socket
+ * via setPreReceivedData().
+ */
+class SocketPeeker : public TransportPeeker,
+                     private TransportPeeker::Callback,
+                     private folly::EventHandler {
  public:
   using UniquePtr = folly::DelayedDestructionUniquePtr<SocketPeeker>;
 
@@ -118,10 +139,67 @@ class SocketPeeker : public TransportPeeker, private TransportPeeker::Callback {
         socket_(socket),
         socketCallback_(callback) {}
 
+  void start() override {
+    auto fd = socket_.getNetworkSocket();
+    if (numBytes_ == 0 || numBytes_ > kMaxPeekLength ||
+        fd == folly::NetworkSocket()) {
+      TransportPeeker::start();
+      return;
+    }
+    initHandler(socket_.getEventBase(), fd);
+    tryPeek();
+  }
+
  private:
-  void peekSuccess(std::vector<uint8_t> data) noexcept override {
+  // Large enough for every registered PeekCallback in the tree; peeks
+  // beyond this use the consuming fallback.
+  static constexpr size_t kMaxPeekLength = 64;
+
+  void handlerReady(uint16_t events) noexcept override {
+    if (events & folly::EventHandler::READ) {
+      tryPeek();
+    }
+  }
+
+  void tryPeek() noexcept {
+    folly::DelayedDestruction::DestructorGuard dg(this);
+
+    auto res = folly::netops::recv(
+        socket_.getNetworkSocket(),
+        peekStorage_.data(),
+        numBytes_,
+        MSG_PEEK | MSG_DONTWAIT);
+    if (res == ssize_t(numBytes_)) {
+      unregisterHandler();
+      auto callback = std::exchange(socketCallback_, nullptr);
+      callback->peekSuccess(folly::ByteRange(peekStorage_.data(), numBytes_));
+    } else if (res == 0) {
+      unregisterHandler();
+      auto type =
+          folly::AsyncSocketException::AsyncSocketExceptionType::END_OF_FILE;
+      auto callback = std::exchange(socketCallback_, nullptr);
+      callback->peekError(
+          folly::AsyncSocketException(type, "Unexpected EOF"));
+    } else if (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      unregisterHandler();
+      auto type =
+          folly::AsyncSocketException::AsyncSocketExceptionType::NETWORK_ERROR;
+      auto callback = std::exchange(socketCallback_, nullptr);
+      callback->peekError(
+          folly::AsyncSocketException(type, "Peek failed", errno));
+    } else {
+      // Nothing (or only part of the data) has arrived; MSG_PEEK left it
+      // all in the kernel, so just wait for more.
+      registerHandler(folly::EventHandler::READ);
+    }
+  }
+
+  // TransportPeeker::Callback methods, used only on the fallback path.
+  void peekSuccess(folly::ByteRange data) noexcept override {
+    // The fallback path consumed the bytes; hand them back to the socket
+    // so the chosen handshake helper can replay them.
     socket_.setPreReceivedData(folly::IOBuf::copyBuffer(data));
-    socketCallback_->peekSuccess(std::move(data));
+    socketCallback_->peekSuccess(data);
   }
 
   void peekError(const folly::AsyncSocketException& ex) noexcept override {
@@ -130,5 +208,6 @@ class SocketPeeker : public TransportPeeker, private TransportPeeker::Callback {
 
   folly::AsyncSocket& socket_;
   Callback* socketCallback_;
+  std::array<uint8_t, kMaxPeekLength> peekStorage_;
 };
 } // namespace wangle
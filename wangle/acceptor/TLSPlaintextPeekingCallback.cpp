@@ -18,8 +18,7 @@
 
 namespace wangle {
 
-bool TLSPlaintextPeekingCallback::looksLikeTLS(
-    const std::vector<uint8_t>& bytes) {
+bool TLSPlaintextPeekingCallback::looksLikeTLS(folly::ByteRange bytes) {
   CHECK_GE(bytes.size(), kPeekCount);
   // TLS starts with
   // 0: 0x16 - handshake magic
@@ -34,7 +33,7 @@ bool TLSPlaintextPeekingCallback::looksLikeTLS(
 }
 
 AcceptorHandshakeHelper::UniquePtr TLSPlaintextPeekingCallback::getHelper(
-    const std::vector<uint8_t>& bytes,
+    folly::ByteRange bytes,
     const folly::SocketAddress& /* clientAddr */,
     std::chrono::steady_clock::time_point /* acceptTime */,
     TransportInfo&) {
@@ -35,13 +35,13 @@ class TLSPlaintextPeekingCallback
       : PeekingAcceptorHandshakeHelper::PeekCallback(kPeekCount) {}
 
   AcceptorHandshakeHelper::UniquePtr getHelper(
-      const std::vector<uint8_t>& bytes,
+      folly::ByteRange bytes,
       const folly::SocketAddress& clientAddr,
       std::chrono::steady_clock::time_point acceptTime,
       TransportInfo& tinfo) override;
 
  private:
-  static bool looksLikeTLS(const std::vector<uint8_t>& peekBytes);
+  static bool looksLikeTLS(folly::ByteRange peekBytes);
 };
 
 } // namespace wangle
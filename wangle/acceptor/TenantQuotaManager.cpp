@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/acceptor/TenantQuotaManager.h>
+
+#include <algorithm>
+
+namespace wangle {
+
+TenantQuotaPool::TenantQuotaPool(
+    std::chrono::milliseconds rateWindow,
+    uint32_t leaseBatchSize)
+    : rateWindow_(std::max(rateWindow, std::chrono::milliseconds(1))),
+      leaseBatchSize_(std::max<uint32_t>(leaseBatchSize, 1)) {}
+
+void TenantQuotaPool::addTenant(std::string sni, TenantQuota quota) {
+  if (sni.empty()) {
+    return;
+  }
+  auto tenant = std::make_unique<Tenant>();
+  tenant->id = tenants_.size();
+  tenant->sni = std::move(sni);
+  tenant->quota = quota;
+  auto& index = tenant->sni.front() == '.' ? wildcard_ : exact_;
+  index[tenant->sni] = tenant->id;
+  tenants_.push_back(std::move(tenant));
+}
+
+TenantQuotaPool::Tenant* TenantQuotaPool::resolve(const std::string& sni) {
+  auto it = exact_.find(sni);
+  if (it != exact_.end()) {
+    return tenants_[it->second].get();
+  }
+  if (!wildcard_.empty()) {
+    auto dot = sni.find('.');
+    if (dot != std::string::npos) {
+      auto wit = wildcard_.find(sni.substr(dot));
+      if (wit != wildcard_.end()) {
+        return tenants_[wit->second].get();
+      }
+    }
+  }
+  return nullptr;
+}
+
+uint32_t TenantQuotaPool::acquireConnections(Tenant& tenant, uint32_t want) {
+  const auto max = tenant.quota.maxConnections;
+  if (max == 0) {
+    tenant.connections.fetch_add(want, std::memory_order_relaxed);
+    return want;
+  }
+  auto cur = tenant.connections.load(std::memory_order_relaxed);
+  uint32_t take;
+  do {
+    if (cur >= max) {
+      return 0;
+    }
+    take = std::min(want, max - cur);
+  } while (!tenant.connections.compare_exchange_weak(
+      cur, cur + take, std::memory_order_relaxed));
+  return take;
+}
+
+void TenantQuotaPool::releaseConnections(Tenant& tenant, uint32_t count) {
+  tenant.connections.fetch_sub(count, std::memory_order_relaxed);
+}
+
+std::vector<TenantQuotaStats> TenantQuotaPool::getTenantStats() const {
+  std::vector<TenantQuotaStats> result;
+  result.reserve(tenants_.size());
+  for (const auto& tenant : tenants_) {
+    TenantQuotaStats stats;
+    stats.sni = tenant->sni;
+    stats.quota = tenant->quota;
+    stats.currentConnections =
+        tenant->connections.load(std::memory_order_relaxed);
+    stats.admitted = tenant->admitted.load(std::memory_order_relaxed);
+    stats.rejectedConnectionLimit =
+        tenant->rejectedConnectionLimit.load(std::memory_order_relaxed);
+    stats.rejectedHandshakeRate =
+        tenant->rejectedHandshakeRate.load(std::memory_order_relaxed);
+    result.push_back(std::move(stats));
+  }
+  return result;
+}
+
+TenantQuotaEnforcer::TenantQuotaEnforcer(std::shared_ptr<TenantQuotaPool> pool)
+    : pool_(std::move(pool)) {}
+
+TenantQuotaEnforcer::~TenantQuotaEnforcer() {
+  releaseUnbound();
+  for (const auto& entry : boundConnections_) {
+    pool_->releaseConnections(*entry.second, 1);
+  }
+  for (size_t id = 0; id < local_.size(); id++) {
+    if (local_[id].leases > 0) {
+      pool_->releaseConnections(*pool_->tenants_[id], local_[id].leases);
+    }
+  }
+}
+
+TenantQuotaEnforcer::LocalState& TenantQuotaEnforcer::localFor(
+    const TenantQuotaPool::Tenant& tenant) {
+  if (tenant.id >= local_.size()) {
+    local_.resize(pool_->tenants_.size());
+  }
+  return local_[tenant.id];
+}
+
+bool TenantQuotaEnforcer::admit(
+    const std::string& sni,
+    std::chrono::steady_clock::time_point now) {
+  // An admission whose connection never materialized returns its lease.
+  releaseUnbound();
+  auto* tenant = pool_->resolve(sni);
+  if (!tenant) {
+    return true;
+  }
+  auto& local = localFor(*tenant);
+  if (tenant->quota.maxHandshakesPerWindow > 0) {
+    const uint64_t nowMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            now.time_since_epoch())
+            .count();
+    const uint64_t window = pool_->rateWindow_.count();
+    const uint64_t windowIndex = nowMs / window;
+    if (local.windowIndex != windowIndex) {
+      local.prevCount =
+          local.windowIndex + 1 == windowIndex ? local.curCount : 0;
+      local.curCount = 0;
+      local.windowIndex = windowIndex;
+    }
+    const double elapsed = static_cast<double>(nowMs % window) / window;
+    const double rate = local.curCount + local.prevCount * (1.0 - elapsed);
+    if (rate >= tenant->quota.maxHandshakesPerWindow) {
+      tenant->rejectedHandshakeRate.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  if (local.leases == 0) {
+    local.leases = pool_->acquireConnections(*tenant, pool_->leaseBatchSize_);
+  }
+  if (local.leases == 0) {
+    tenant->rejectedConnectionLimit.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  local.leases--;
+  pending_ = tenant;
+  if (tenant->quota.maxHandshakesPerWindow > 0) {
+    local.curCount++;
+  }
+  tenant->admitted.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void TenantQuotaEnforcer::onConnectionAdded(const void* conn) {
+  if (pending_ == nullptr) {
+    return;
+  }
+  boundConnections_[conn] = pending_;
+  pending_ = nullptr;
+}
+
+void TenantQuotaEnforcer::onConnectionRemoved(const void* conn) {
+  auto it = boundConnections_.find(conn);
+  if (it == boundConnections_.end()) {
+    return;
+  }
+  auto* tenant = it->second;
+  boundConnections_.erase(it);
+  auto& local = localFor(*tenant);
+  local.leases++;
+  // Hand a batch back once the cache doubles, so leases flow toward
+  // busy acceptors instead of pooling on idle ones.
+  if (local.leases >= 2 * pool_->leaseBatchSize_) {
+    local.leases -= pool_->leaseBatchSize_;
+    pool_->releaseConnections(*tenant, pool_->leaseBatchSize_);
+  }
+}
+
+void TenantQuotaEnforcer::releaseUnbound() {
+  if (pending_ == nullptr) {
+    return;
+  }
+  localFor(*pending_).leases++;
+  pending_ = nullptr;
+}
+
+} // namespace wangle
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wangle {
+
+/**
+ * Resource quota for one tenant of a multi-tenant TLS frontend, keyed
+ * by the SNI the tenant's clients present. A zero field leaves that
+ * dimension unlimited.
+ */
+struct TenantQuota {
+  /**
+   * Maximum concurrent connections for the tenant, enforced across all
+   * acceptors sharing the pool.
+   */
+  uint32_t maxConnections{0};
+
+  /**
+   * Maximum admitted handshakes per rate window, per acceptor.  Like
+   * HandshakeRateLimiter, each acceptor applies the budget to its own
+   * share of the traffic so the check stays lock-free.
+   */
+  uint32_t maxHandshakesPerWindow{0};
+};
+
+/**
+ * Per-tenant usage aggregates, snapshot via
+ * TenantQuotaPool::getTenantStats().  currentConnections counts leases
+ * handed out, which includes leases cached by enforcers but not yet
+ * backing a connection.
+ */
+struct TenantQuotaStats {
+  std::string sni;
+  TenantQuota quota;
+  uint32_t currentConnections{0};
+  uint64_t admitted{0};
+  uint64_t rejectedConnectionLimit{0};
+  uint64_t rejectedHandshakeRate{0};
+};
+
+/**
+ * Process-wide side of per-tenant quotas: one pool is shared by every
+ * acceptor serving the tenant set.
+ *
+ * LoadShedConfiguration bounds totals; it cannot stop one tenant's
+ * surge from exhausting connection and handshake capacity for everyone
+ * else.  This pool bounds the blast radius per tenant while keeping
+ * the cost on other tenants' hot path at a hash lookup: connection
+ * counts are kept exact across threads the same way ConnectionLeasePool
+ * keeps the global cap, with each acceptor's enforcer drawing leases in
+ * batches with a single CAS and serving admissions from its local
+ * cache.
+ *
+ * Tenants are registered up front, before traffic; registration is not
+ * synchronized against admission.
+ */
+class TenantQuotaPool {
+ public:
+  explicit TenantQuotaPool(
+      std::chrono::milliseconds rateWindow = std::chrono::seconds(1),
+      uint32_t leaseBatchSize = 8);
+
+  /**
+   * Registers a tenant keyed by SNI.  A key beginning with '.' is a
+   * wildcard matching any single leading label ("a.example.com"
+   * matches ".example.com"); exact entries win over wildcards.  SNIs
+   * no tenant owns are not subject to quotas.
+   */
+  void addTenant(std::string sni, TenantQuota quota);
+
+  std::vector<TenantQuotaStats> getTenantStats() const;
+
+ private:
+  friend class TenantQuotaEnforcer;
+
+  struct Tenant {
+    size_t id{0};
+    std::string sni;
+    TenantQuota quota;
+    std::atomic<uint32_t> connections{0};
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<uint64_t> rejectedConnectionLimit{0};
+    std::atomic<uint64_t> rejectedHandshakeRate{0};
+  };
+
+  /**
+   * Maps an SNI to its tenant, or nullptr if no tenant owns it.
+   */
+  Tenant* resolve(const std::string& sni);
+
+  /**
+   * Take up to `want` connection leases for the tenant; returns the
+   * number granted, zero once the tenant is at its cap.  Lock-free,
+   * mirroring ConnectionLeasePool::acquire.
+   */
+  uint32_t acquireConnections(Tenant& tenant, uint32_t want);
+  void releaseConnections(Tenant& tenant, uint32_t count);
+
+  const std::chrono::milliseconds rateWindow_;
+  const uint32_t leaseBatchSize_;
+
+  // Stable storage: enforcers hold raw Tenant pointers and index their
+  // local state by id.
+  std::vector<std::unique_ptr<Tenant>> tenants_;
+  std::unordered_map<std::string, size_t> exact_;
+  std::unordered_map<std::string, size_t> wildcard_;
+};
+
+/**
+ * Per-Acceptor (per-EventBase) side of the quotas, so admission itself
+ * needs no locks.  Handshake rates use the same two-window sliding
+ * estimate as HandshakeRateLimiter, tracked per tenant; connection
+ * counts come from the shared pool via batched leases, in the
+ * HierarchicalConnectionCounter pattern.
+ *
+ * A successful admit() for a registered tenant holds one connection
+ * lease for the connection about to be created; onConnectionAdded()
+ * binds that connection to the lease and onConnectionRemoved() returns
+ * it.  If no connection materializes after an admission, the owner
+ * must call releaseUnbound() (the Acceptor does this after
+ * connectionReady()).
+ */
+class TenantQuotaEnforcer {
+ public:
+  explicit TenantQuotaEnforcer(std::shared_ptr<TenantQuotaPool> pool);
+
+  /**
+   * Returns leases for still-bound connections and the local cache to
+   * the pool; tenant counts must not leak when an acceptor is torn
+   * down.
+   */
+  ~TenantQuotaEnforcer();
+
+  /**
+   * Admission decision for a handshake carrying the given SNI.  SNIs
+   * no tenant owns are admitted: quotas bound registered tenants, they
+   * do not implement default-deny.  Rejections are counted per tenant
+   * and cost no allocation.
+   */
+  bool admit(
+      const std::string& sni,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+  /**
+   * Binds the connection created for the last admission to its
+   * tenant's lease.  Admissions and connection creation interleave one
+   * at a time on the acceptor thread; connections with no pending
+   * admission (plaintext, unregistered tenants) are ignored.
+   */
+  void onConnectionAdded(const void* conn);
+
+  /**
+   * Returns the bound connection's lease.  Unknown connections are
+   * ignored.
+   */
+  void onConnectionRemoved(const void* conn);
+
+  /**
+   * Returns the lease held by the last admission if no connection was
+   * bound to it.
+   */
+  void releaseUnbound();
+
+ private:
+  struct LocalState {
+    uint32_t leases{0};
+    uint64_t windowIndex{0};
+    uint32_t prevCount{0};
+    uint32_t curCount{0};
+  };
+
+  LocalState& localFor(const TenantQuotaPool::Tenant& tenant);
+
+  std::shared_ptr<TenantQuotaPool> pool_;
+  std::vector<LocalState> local_;
+  std::unordered_map<const void*, TenantQuotaPool::Tenant*> boundConnections_;
+  TenantQuotaPool::Tenant* pending_{nullptr};
+};
+
+} // namespace wangle
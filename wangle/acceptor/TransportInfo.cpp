@@ -27,6 +27,11 @@ using std::chrono::microseconds;
 namespace wangle {
 
 bool TransportInfo::initWithSocket(const folly::AsyncSocket* sock) {
+  if (!fullCapture()) {
+    // Sampled-out connection: skip the getsockopt round trip; the
+    // always-on core is filled in-process by the acceptor.
+    return false;
+  }
 #if defined(__linux__) || defined(__FreeBSD__) || defined(__APPLE__)
   if (!TransportInfo::readTcpInfo(&tcpinfo, sock)) {
     tcpinfoErrno = errno;
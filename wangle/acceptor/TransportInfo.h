@@ -43,6 +43,28 @@ struct ProtocolInfo {
 };
 
 struct TransportInfo {
+  /*
+   * How much of this structure to materialize for the connection.
+   *
+   * CORE keeps only the trivially-copyable fields that are filled
+   * in-process anyway (timings, byte counts, enums); the string fields
+   * and the getsockopt-backed tcp_info block are skipped. FULL is the
+   * historical behavior. The level is decided at accept time (see
+   * ServerSocketConfig::transportInfoSampleRate) and the populating
+   * paths check it; error paths flip a connection back to FULL so
+   * failures always log at full fidelity from that point on.
+   */
+  enum class CaptureLevel : uint8_t {
+    CORE,
+    FULL,
+  };
+
+  CaptureLevel captureLevel{CaptureLevel::FULL};
+
+  bool fullCapture() const {
+    return captureLevel == CaptureLevel::FULL;
+  }
+
   /*
    * timestamp of when the connection handshake was completed
    */
@@ -270,6 +292,24 @@ struct TransportInfo {
    */
   SSLResumeEnum sslResume{SSLResumeEnum::NA};
 
+  /*
+   * True when the server accepted TLS 1.3 early (0-RTT) application data
+   * on this connection. The handshake may not be confirmed yet when the
+   * transport reaches the pipeline, so early bytes can be an attacker's
+   * replay: handlers must only act on them when that is safe, and can
+   * wait for folly::AsyncTransport::isReplaySafe() /
+   * setReplaySafetyCallback() before doing anything non-idempotent.
+   */
+  bool sslEarlyDataAccepted{false};
+
+  /*
+   * The certificate compression algorithm negotiated for this
+   * handshake (RFC 8879 code point: 1 = zlib, 2 = brotli, 3 = zstd),
+   * or zero when the chain went out uncompressed. Aggregating this
+   * across connections gives the negotiated-compression rate.
+   */
+  uint16_t sslCertCompressionAlgo{0};
+
   /*
    * time used to get a usable connection.
    */
@@ -290,6 +330,13 @@ struct TransportInfo {
    */
   std::string securityType;
 
+  /**
+   * Name of the sampled handshake stack that served this connection;
+   * empty when stack sampling is not in use.
+   * @see SecurityProtocolContextManager::addSampledStack
+   */
+  std::string handshakeStack;
+
   /*
    * Additional protocol info.
    */
@@ -14,10 +14,12 @@
  * limitations under the License.
  */
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/test/AsyncSSLSocketTest.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <folly/portability/Sockets.h>
 #include <glog/logging.h>
 #include <wangle/acceptor/AcceptObserver.h>
 #include <wangle/acceptor/Acceptor.h>
@@ -51,7 +53,7 @@ class TestAcceptor : public Acceptor {
       const folly::SocketAddress* /*address*/,
       const std::string& /*nextProtocolName*/,
       SecureTransportType /*secureTransportType*/,
-      const TransportInfo& /*tinfo*/) override {
+      TransportInfo& /*tinfo*/) override {
     addConnection(new TestConnection);
     getEventBase()->terminateLoopSoon();
   }
@@ -163,6 +165,169 @@ TEST_P(AcceptorTest, Basic) {
   evb_.loop();
 }
 
+TEST_P(AcceptorTest, InitAsync) {
+  TestSSLConfig testConfig = GetParam();
+  ServerSocketConfig config;
+  if (testConfig == TestSSLConfig::SSL ||
+      testConfig == TestSSLConfig::SSL_MULTI_CA) {
+    config.sslContextConfigs.emplace_back(getTestSslContextConfig());
+  }
+  auto acceptor = std::make_shared<TestAcceptor>(config);
+  auto socket = AsyncServerSocket::newSocket(&evb_);
+  folly::CPUThreadPoolExecutor sslSetupExecutor(1);
+  auto ready =
+      acceptor->initAsync(socket.get(), &evb_, &sslSetupExecutor, nullptr);
+  // accepting starts before the SSL contexts are built
+  CHECK(acceptor->getState() == Acceptor::State::kRunning);
+  socket->bind(0);
+  socket->listen(100);
+  socket->startAccepting();
+  while (!ready.isReady()) {
+    evb_.loopOnce();
+  }
+  std::move(ready).get();
+
+  SocketAddress serverAddress;
+  socket->getAddress(&serverAddress);
+  auto clientSocket = connectClientSocket(serverAddress);
+  evb_.loopForever();
+
+  CHECK_EQ(acceptor->getNumConnections(), 1);
+  acceptor->forceStop();
+  socket->stopAccepting();
+  evb_.loop();
+}
+
+TEST_P(AcceptorTest, HandshakeOffloadPool) {
+  TestSSLConfig testConfig = GetParam();
+  ServerSocketConfig config;
+  if (testConfig == TestSSLConfig::SSL ||
+      testConfig == TestSSLConfig::SSL_MULTI_CA) {
+    config.sslContextConfigs.emplace_back(getTestSslContextConfig());
+  }
+  // Threshold of 0 sends every handshake to the pool
+  config.handshakeOffloadThreshold = 0;
+  auto [acceptor, serverSocket] = initTestAcceptorAndSocket(config);
+  auto handshakePool = std::make_shared<folly::IOThreadPoolExecutor>(1);
+  acceptor->setHandshakeOffloadPool(handshakePool);
+
+  SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+  auto clientSocket = connectClientSocket(serverAddress);
+
+  evb_.loopForever();
+
+  CHECK_EQ(acceptor->getNumConnections(), 1);
+  acceptor->forceStop();
+  serverSocket->stopAccepting();
+  evb_.loop();
+}
+
+TEST_P(AcceptorTest, AcceptGovernor) {
+  TestSSLConfig testConfig = GetParam();
+  ServerSocketConfig config;
+  if (testConfig == TestSSLConfig::SSL ||
+      testConfig == TestSSLConfig::SSL_MULTI_CA) {
+    config.sslContextConfigs.emplace_back(getTestSslContextConfig());
+  }
+  // Low enough that a local connection setup breaches the target, so the
+  // governor's pause/resume path gets exercised.
+  config.acceptLatencyTarget = std::chrono::milliseconds(1);
+  config.acceptPauseDuration = std::chrono::milliseconds(1);
+  auto [acceptor, serverSocket] = initTestAcceptorAndSocket(config);
+
+  SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+  auto clientSocket = connectClientSocket(serverAddress);
+
+  evb_.loopForever();
+
+  CHECK_EQ(acceptor->getNumConnections(), 1);
+#if defined(__linux__)
+  auto backlog = acceptor->getListenBacklog();
+  EXPECT_GE(backlog.depth, 0);
+  EXPECT_GT(backlog.limit, 0);
+#endif
+  acceptor->forceStop();
+  serverSocket->stopAccepting();
+  evb_.loop();
+}
+
+TEST_P(AcceptorTest, AcceptQueueDelayShedding) {
+  TestSSLConfig testConfig = GetParam();
+  ServerSocketConfig config;
+  if (testConfig == TestSSLConfig::SSL ||
+      testConfig == TestSSLConfig::SSL_MULTI_CA) {
+    config.sslContextConfigs.emplace_back(getTestSslContextConfig());
+  }
+  config.acceptQueueDelayBudget = std::chrono::milliseconds(10);
+  auto [acceptor, serverSocket] = initTestAcceptorAndSocket(config);
+
+  // Synthesize a connection that sat in the worker's accept queue past
+  // the budget; it is closed on arrival instead of being handshaken.
+  int fds[2];
+  PCHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  folly::AsyncServerSocket::AcceptCallback::AcceptInfo info;
+  info.timeBeforeEnqueue =
+      std::chrono::steady_clock::now() - std::chrono::milliseconds(20);
+  acceptor->acceptConnection(
+      folly::NetworkSocket::fromFd(fds[0]), SocketAddress(), info, nullptr);
+  close(fds[1]);
+
+  auto stats = acceptor->getAcceptQueueStats();
+  EXPECT_EQ(1, stats.shedForDelay);
+  EXPECT_EQ(0, stats.accepted);
+  EXPECT_GT(stats.smoothedDelay.count(), 0);
+  EXPECT_EQ(0, acceptor->getNumConnections());
+
+  // A connection that didn't wait is admitted normally.
+  SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+  auto clientSocket = connectClientSocket(serverAddress);
+  evb_.loopForever();
+
+  stats = acceptor->getAcceptQueueStats();
+  EXPECT_EQ(1, stats.accepted);
+  EXPECT_EQ(1, stats.shedForDelay);
+  CHECK_EQ(acceptor->getNumConnections(), 1);
+  acceptor->forceStop();
+  serverSocket->stopAccepting();
+  evb_.loop();
+}
+
+TEST(SocketOptionProfiles, ApplyToLiveTransport) {
+  EventBase evb;
+  int fds[2];
+  PCHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  auto socket = AsyncSocket::newSocket(&evb, NetworkSocket::fromFd(fds[0]));
+
+  folly::SocketOptionMap profile;
+  profile[folly::SocketOptionKey{SOL_SOCKET, SO_KEEPALIVE}] = 1;
+  EXPECT_EQ(1, applySocketOptions(socket.get(), profile));
+
+  int value = 0;
+  socklen_t len = sizeof(value);
+  PCHECK(getsockopt(fds[0], SOL_SOCKET, SO_KEEPALIVE, &value, &len) == 0);
+  EXPECT_EQ(1, value);
+
+  // No transport, no fd to apply to.
+  EXPECT_EQ(-1, applySocketOptions(nullptr, profile));
+
+  socket->closeNow();
+  close(fds[1]);
+}
+
+TEST(SocketOptionProfiles, ConfigLookup) {
+  ServerSocketConfig config;
+  folly::SocketOptionMap bulk;
+  bulk[folly::SocketOptionKey{SOL_SOCKET, SO_KEEPALIVE}] = 1;
+  config.addSocketOptionProfile("bulk", bulk);
+
+  ASSERT_NE(nullptr, config.findSocketOptionProfile("bulk"));
+  EXPECT_EQ(1, config.findSocketOptionProfile("bulk")->size());
+  EXPECT_EQ(nullptr, config.findSocketOptionProfile("latency"));
+}
+
 class MockAcceptObserver : public AcceptObserver {
  public:
   MOCK_METHOD(void, accept, (folly::AsyncTransport* const), (noexcept));
@@ -269,6 +434,115 @@ TEST_P(AcceptorTest, AcceptObserver) {
   evb_.loop();
 }
 
+class SamplingAcceptObserver : public MockAcceptObserver {
+ public:
+  explicit SamplingAcceptObserver(uint32_t sampleRate)
+      : sampleRate_(sampleRate) {}
+
+  uint32_t getSampleRate() const noexcept override {
+    return sampleRate_;
+  }
+
+ private:
+  const uint32_t sampleRate_;
+};
+
+TEST_P(AcceptorTest, AcceptObserverSampling) {
+  auto [acceptor, serverSocket] = initTestAcceptorAndSocket();
+  SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+
+  auto cb = std::make_unique<StrictMock<SamplingAcceptObserver>>(2);
+  EXPECT_CALL(*cb, observerAttach(acceptor.get()));
+  acceptor->addAcceptObserver(cb.get());
+
+  // first connection is sampled
+  auto clientSocket1 = connectClientSocket(serverAddress);
+  {
+    InSequence s;
+    EXPECT_CALL(*cb, accept(_));
+    EXPECT_CALL(*cb, ready(_));
+  }
+  evb_.loopForever();
+  Mock::VerifyAndClearExpectations(cb.get());
+  CHECK_EQ(acceptor->getNumConnections(), 1);
+
+  // second connection is skipped; the StrictMock fails on any callback
+  auto clientSocket2 = connectClientSocket(serverAddress);
+  evb_.loopForever();
+  Mock::VerifyAndClearExpectations(cb.get());
+  CHECK_EQ(acceptor->getNumConnections(), 2);
+
+  // third connection is sampled again
+  auto clientSocket3 = connectClientSocket(serverAddress);
+  {
+    InSequence s;
+    EXPECT_CALL(*cb, accept(_));
+    EXPECT_CALL(*cb, ready(_));
+  }
+  evb_.loopForever();
+  Mock::VerifyAndClearExpectations(cb.get());
+  CHECK_EQ(acceptor->getNumConnections(), 3);
+
+  // remove AcceptObserver
+  EXPECT_CALL(*cb, observerDetach(acceptor.get()));
+  EXPECT_TRUE(acceptor->removeAcceptObserver(cb.get()));
+  Mock::VerifyAndClearExpectations(cb.get());
+
+  // stop the acceptor
+  acceptor->forceStop();
+  serverSocket->stopAccepting();
+  evb_.loop();
+}
+
+class BatchedAcceptObserver : public MockAcceptObserver {
+ public:
+  bool preferBatchedEvents() const noexcept override {
+    return true;
+  }
+
+  void onEventBatch(const AcceptEventBatch& batch) noexcept override {
+    accepted += batch.accepted;
+    ready += batch.ready;
+  }
+
+  uint64_t accepted{0};
+  uint64_t ready{0};
+};
+
+TEST_P(AcceptorTest, AcceptObserverBatched) {
+  auto [acceptor, serverSocket] = initTestAcceptorAndSocket();
+  SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+
+  // the StrictMock fails if the per-connection accept() / ready()
+  // callbacks are invoked for a batched observer
+  auto cb = std::make_unique<StrictMock<BatchedAcceptObserver>>();
+  EXPECT_CALL(*cb, observerAttach(acceptor.get()));
+  acceptor->addAcceptObserver(cb.get());
+
+  auto clientSocket1 = connectClientSocket(serverAddress);
+  evb_.loopForever();
+  CHECK_EQ(acceptor->getNumConnections(), 1);
+
+  auto clientSocket2 = connectClientSocket(serverAddress);
+  evb_.loopForever();
+  CHECK_EQ(acceptor->getNumConnections(), 2);
+
+  // stop the acceptor; any batch still pending is flushed by then
+  acceptor->forceStop();
+  serverSocket->stopAccepting();
+  evb_.loop();
+
+  EXPECT_EQ(2, cb->accepted);
+  EXPECT_EQ(2, cb->ready);
+
+  // remove AcceptObserver
+  EXPECT_CALL(*cb, observerDetach(acceptor.get()));
+  EXPECT_TRUE(acceptor->removeAcceptObserver(cb.get()));
+  Mock::VerifyAndClearExpectations(cb.get());
+}
+
 TEST_P(AcceptorTest, AcceptObserverRemove) {
   auto [acceptor, serverSocket] = initTestAcceptorAndSocket();
   auto cb = std::make_unique<StrictMock<MockAcceptObserver>>();
@@ -598,3 +872,14 @@ TEST_P(
   acceptor = nullptr;
   Mock::VerifyAndClearExpectations(onAcceptCb.get());
 }
+
+TEST(TransportInfoCaptureTest, CoreCaptureSkipsSocketReads) {
+  TransportInfo tinfo;
+  EXPECT_TRUE(tinfo.fullCapture()); // full capture is the default
+
+  tinfo.captureLevel = TransportInfo::CaptureLevel::CORE;
+  // Safe without a socket: a sampled-out connection returns before
+  // touching it.
+  EXPECT_FALSE(tinfo.initWithSocket(nullptr));
+  EXPECT_FALSE(tinfo.validTcpinfo);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/acceptor/ConnectionCounter.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+TEST(HierarchicalConnectionCounterTest, BatchedLeaseDraw) {
+  auto pool = std::make_shared<ConnectionLeasePool>(100);
+  HierarchicalConnectionCounter counter(pool, 10);
+
+  // The first admission pulls a whole batch from the pool.
+  EXPECT_TRUE(counter.tryAcquire());
+  counter.onConnectionAdded();
+  EXPECT_EQ(10, pool->getNumConnections());
+  EXPECT_EQ(9, counter.getCachedLeases());
+
+  // The next nine admissions are served from the local cache.
+  for (int i = 0; i < 9; i++) {
+    EXPECT_TRUE(counter.tryAcquire());
+    counter.onConnectionAdded();
+  }
+  EXPECT_EQ(10, pool->getNumConnections());
+  EXPECT_EQ(0, counter.getCachedLeases());
+
+  // The eleventh triggers a refill.
+  EXPECT_TRUE(counter.tryAcquire());
+  counter.onConnectionAdded();
+  EXPECT_EQ(20, pool->getNumConnections());
+  EXPECT_EQ(11, counter.getNumConnections());
+}
+
+TEST(HierarchicalConnectionCounterTest, GlobalCapSharedAcrossCounters) {
+  auto pool = std::make_shared<ConnectionLeasePool>(10);
+  HierarchicalConnectionCounter a(pool, 4);
+  HierarchicalConnectionCounter b(pool, 4);
+
+  uint64_t admitted = 0;
+  for (int i = 0; i < 20; i++) {
+    auto& counter = (i % 2 == 0) ? a : b;
+    if (counter.tryAcquire()) {
+      counter.onConnectionAdded();
+      admitted++;
+    }
+  }
+  // The cap holds globally even though neither counter saw all of it.
+  EXPECT_EQ(10, admitted);
+  EXPECT_FALSE(a.tryAcquire());
+  EXPECT_FALSE(b.tryAcquire());
+  EXPECT_EQ(10, pool->getNumConnections());
+}
+
+TEST(HierarchicalConnectionCounterTest, RemovalsReturnLeases) {
+  auto pool = std::make_shared<ConnectionLeasePool>(100);
+  HierarchicalConnectionCounter counter(pool, 4);
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(counter.tryAcquire());
+    counter.onConnectionAdded();
+  }
+  EXPECT_EQ(4, pool->getNumConnections());
+
+  // Removals refill the local cache; once it reaches twice the batch
+  // size, a batch flows back to the pool.
+  for (int i = 0; i < 4; i++) {
+    counter.onConnectionRemoved();
+  }
+  EXPECT_EQ(4, counter.getCachedLeases());
+  EXPECT_EQ(4, pool->getNumConnections());
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(counter.tryAcquire());
+    counter.onConnectionAdded();
+  }
+  EXPECT_EQ(4, pool->getNumConnections());
+  for (int i = 0; i < 4; i++) {
+    counter.onConnectionRemoved();
+  }
+  EXPECT_EQ(4, counter.getCachedLeases());
+}
+
+TEST(HierarchicalConnectionCounterTest, DestructionReleasesHeldLeases) {
+  auto pool = std::make_shared<ConnectionLeasePool>(10);
+  {
+    HierarchicalConnectionCounter counter(pool, 4);
+    ASSERT_TRUE(counter.tryAcquire());
+    counter.onConnectionAdded();
+    EXPECT_EQ(4, pool->getNumConnections());
+  }
+  // Both the cached leases and the one backing the open connection
+  // come back when the counter is torn down.
+  EXPECT_EQ(0, pool->getNumConnections());
+}
+
+TEST(HierarchicalConnectionCounterTest, UncheckedAddsCountAsDebt) {
+  auto pool = std::make_shared<ConnectionLeasePool>(2);
+  HierarchicalConnectionCounter counter(pool, 2);
+
+  // Legacy callers may add without an admission check; past the cap
+  // the connection is still counted and settled on removal.
+  counter.onConnectionAdded();
+  counter.onConnectionAdded();
+  counter.onConnectionAdded();
+  EXPECT_EQ(3, counter.getNumConnections());
+  EXPECT_EQ(2, pool->getNumConnections());
+
+  counter.onConnectionRemoved();
+  counter.onConnectionRemoved();
+  counter.onConnectionRemoved();
+  EXPECT_EQ(0, counter.getNumConnections());
+  EXPECT_EQ(2, counter.getCachedLeases());
+}
+
+TEST(HierarchicalConnectionCounterTest, UnlimitedPoolAdmitsEverything) {
+  auto pool = std::make_shared<ConnectionLeasePool>(0);
+  HierarchicalConnectionCounter counter(pool, 4);
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(counter.tryAcquire());
+    counter.onConnectionAdded();
+  }
+  EXPECT_EQ(1000, counter.getNumConnections());
+}
+
+TEST(HierarchicalConnectionCounterTest, ConcurrentCountersRespectCap) {
+  constexpr uint64_t kCap = 1000;
+  auto pool = std::make_shared<ConnectionLeasePool>(kCap);
+  std::atomic<uint64_t> admitted{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&] {
+      HierarchicalConnectionCounter counter(pool, 16);
+      for (int i = 0; i < 1000; i++) {
+        if (counter.tryAcquire()) {
+          counter.onConnectionAdded();
+          admitted.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      // Counter destruction returns this thread's leases.
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // The cap is never exceeded, and at most one partial batch per
+  // counter can sit stranded in a cache when its thread stops trying.
+  EXPECT_LE(admitted.load(), kCap);
+  EXPECT_GE(admitted.load(), kCap - 8 * 16);
+  // All leases return on destruction.
+  EXPECT_EQ(0, pool->getNumConnections());
+}
@@ -15,10 +15,13 @@
  */
 
 #include <wangle/acceptor/ConnectionManager.h>
+#include <wangle/acceptor/ShardedConnectionManager.h>
 
 #include <folly/portability/GFlags.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <functional>
+#include <utility>
 
 using namespace testing;
 using namespace wangle;
@@ -119,6 +122,26 @@ void MockConnection::closeWhenIdleImpl() {
   }
 }
 
+TEST_F(ConnectionManagerTest, testFrameworkOverheadBudget) {
+  // Ratchet on per-connection framework overhead: at millions of
+  // connections per box every word in ManagedConnection is megabytes of
+  // RAM. If this fails, either shrink what was added or consciously
+  // raise the budget in the same change.
+  EXPECT_LE(sizeof(ManagedConnection), 192);
+  EXPECT_EQ(
+      ConnectionManager::kPerConnectionFrameworkBytes,
+      sizeof(ManagedConnection));
+}
+
+TEST_F(ConnectionManagerTest, testConnectionFrameworkBytes) {
+  // no connection age timeout configured, so no age callback is counted
+  EXPECT_GT(cm_->getNumConnections(), 0);
+  EXPECT_EQ(
+      cm_->getConnectionFrameworkBytes(),
+      cm_->getNumConnections() *
+          ConnectionManager::kPerConnectionFrameworkBytes);
+}
+
 TEST_F(ConnectionManagerTest, testShutdownSequence) {
   InSequence enforceOrder;
 
@@ -448,4 +471,368 @@ TEST_F(ConnectionManagerTest, testAddDuringCloseWhenIdleActive) {
 TEST_F(ConnectionManagerTest, testAddDuringCloseWhenIdleInactive) {
   testAddDuringCloseWhenIdle(true);
 }
+
+TEST_F(ConnectionManagerTest, testDrainIdleConnectionsFirst) {
+  cm_->setDrainIdleConnectionsFirst(true);
+
+  // Move the first half of the connections to the idle tail of the list
+  for (size_t i = 0; i < conns_.size() / 2; i++) {
+    cm_->onDeactivated(*conns_[i]);
+  }
+  for (const auto& conn : conns_) {
+    EXPECT_CALL(*conn, notifyPendingShutdown());
+  }
+  {
+    // The idle tail must be closed before the busy head
+    InSequence enforceOrder;
+    for (size_t i = 0; i < conns_.size() / 2; i++) {
+      EXPECT_CALL(*conns_[i], closeWhenIdle());
+    }
+    for (size_t i = conns_.size() / 2; i < conns_.size(); i++) {
+      EXPECT_CALL(*conns_[i], closeWhenIdle());
+    }
+  }
+  cm_->initiateGracefulShutdown(std::chrono::milliseconds(50));
+  eventBase_.loop();
+}
+
+TEST_F(ConnectionManagerTest, testDrainWithTimeBudget) {
+  cm_->setDrainChunkBudget(std::chrono::microseconds(200));
+
+  for (const auto& conn : conns_) {
+    EXPECT_CALL(*conn, notifyPendingShutdown());
+    EXPECT_CALL(*conn, closeWhenIdle());
+  }
+  cm_->initiateGracefulShutdown(std::chrono::milliseconds(10));
+  eventBase_.loop();
+}
+
+TEST_F(ConnectionManagerTest, testDrainProgress) {
+  for (auto& conn : conns_) {
+    conn->setIdle(true);
+    EXPECT_CALL(*conn, notifyPendingShutdown());
+    EXPECT_CALL(*conn, closeWhenIdle());
+  }
+  auto before = cm_->getDrainProgress();
+  EXPECT_EQ(0, before.connectionsNotified);
+  EXPECT_EQ(65, before.connectionsRemaining);
+  EXPECT_FALSE(before.closePhaseComplete);
+
+  cm_->initiateGracefulShutdown(std::chrono::milliseconds(50));
+  eventBase_.loop();
+
+  auto after = cm_->getDrainProgress();
+  EXPECT_EQ(65, after.connectionsNotified);
+  EXPECT_EQ(65, after.connectionsClosed);
+  EXPECT_EQ(0, after.connectionsRemaining);
+  EXPECT_TRUE(after.closePhaseComplete);
+}
+
+TEST_F(ConnectionManagerTest, testConnectionSnapshot) {
+  for (auto& conn : conns_) {
+    EXPECT_CALL(*conn, getIdleTime())
+        .WillRepeatedly(Return(std::chrono::milliseconds(5)));
+    EXPECT_CALL(*conn, getLastActivityElapsedTime())
+        .WillRepeatedly(
+            Return(folly::Optional<std::chrono::milliseconds>()));
+  }
+  EXPECT_CALL(*conns_[0], isBusy()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*conns_[1], notifyPendingShutdown());
+  conns_[1]->fireNotifyPendingShutdown();
+
+  EXPECT_TRUE(cm_->getConnectionSnapshot()->empty());
+  cm_->publishConnectionSnapshot();
+  auto snapshot = cm_->getConnectionSnapshot();
+  ASSERT_EQ(65, snapshot->size());
+
+  using State = ConnectionManager::ConnectionSnapshotEntry::State;
+  size_t busy = 0;
+  size_t draining = 0;
+  for (const auto& entry : *snapshot) {
+    EXPECT_EQ(std::chrono::milliseconds(5), entry.idleTime);
+    EXPECT_EQ(std::chrono::milliseconds(-1), entry.sinceLastActivity);
+    busy += entry.state == State::BUSY;
+    draining += entry.state == State::DRAINING;
+  }
+  EXPECT_EQ(1, busy);
+  EXPECT_EQ(1, draining);
+
+  // A held front buffer is never mutated by the next publish; once it
+  // is released it gets recycled as a back buffer.
+  const auto* firstRaw = snapshot.get();
+  cm_->publishConnectionSnapshot();
+  EXPECT_NE(firstRaw, cm_->getConnectionSnapshot().get());
+  EXPECT_EQ(65, snapshot->size());
+  snapshot.reset();
+  cm_->publishConnectionSnapshot();
+  EXPECT_EQ(firstRaw, cm_->getConnectionSnapshot().get());
+}
+
+TEST_F(ConnectionManagerTest, testExportConnectionStates) {
+  struct CollectingSink : ConnectionManager::ConnectionStateExportSink {
+    void onRecords(
+        folly::Range<const ConnectionStateRecord*> records) override {
+      chunkSizes.push_back(records.size());
+      for (const auto& record : records) {
+        busy += record.state == ConnectionStateRecord::State::BUSY;
+        EXPECT_EQ(5, record.idleTimeMs);
+        EXPECT_EQ(ConnectionStateRecord::kNoActivity,
+                  record.sinceLastActivityMs);
+      }
+    }
+    void onExportDone(size_t numRecords) override {
+      done = numRecords;
+    }
+    std::vector<size_t> chunkSizes;
+    size_t busy{0};
+    folly::Optional<size_t> done;
+  };
+
+  for (auto& conn : conns_) {
+    EXPECT_CALL(*conn, getIdleTime())
+        .WillRepeatedly(Return(std::chrono::milliseconds(5)));
+    EXPECT_CALL(*conn, getLastActivityElapsedTime())
+        .WillRepeatedly(Return(folly::Optional<std::chrono::milliseconds>()));
+  }
+  EXPECT_CALL(*conns_[0], isBusy()).WillRepeatedly(Return(true));
+
+  auto sink = std::make_shared<CollectingSink>();
+  cm_->exportConnectionStates(sink, 10 /* maxRecordsPerLoop */);
+  // Nothing is exported synchronously; chunks arrive one per loop.
+  EXPECT_TRUE(sink->chunkSizes.empty());
+  while (!sink->done) {
+    eventBase_.loopOnce();
+  }
+  EXPECT_EQ(65, *sink->done);
+  ASSERT_EQ(7, sink->chunkSizes.size());
+  EXPECT_EQ(10, sink->chunkSizes.front());
+  EXPECT_EQ(5, sink->chunkSizes.back());
+  EXPECT_EQ(1, sink->busy);
+}
+
+TEST_F(ConnectionManagerTest, testExportSurvivesRemovalMidExport) {
+  struct Sink : ConnectionManager::ConnectionStateExportSink {
+    void onRecords(
+        folly::Range<const ConnectionStateRecord*> records) override {
+      exported += records.size();
+      if (onFirstChunk) {
+        std::exchange(onFirstChunk, nullptr)();
+      }
+    }
+    void onExportDone(size_t numRecords) override {
+      done = numRecords;
+    }
+    std::function<void()> onFirstChunk;
+    size_t exported{0};
+    folly::Optional<size_t> done;
+  };
+
+  for (auto& conn : conns_) {
+    EXPECT_CALL(*conn, getIdleTime())
+        .WillRepeatedly(Return(std::chrono::milliseconds(0)));
+    EXPECT_CALL(*conn, getLastActivityElapsedTime())
+        .WillRepeatedly(Return(folly::Optional<std::chrono::milliseconds>()));
+  }
+
+  auto sink = std::make_shared<Sink>();
+  sink->onFirstChunk = [&] {
+    // Drop a swath of connections while the export is parked between
+    // chunks; the exporter's resume iterator must stay valid.
+    for (size_t i = 10; i < 50; i++) {
+      removeConn(conns_[i].get());
+    }
+  };
+  cm_->exportConnectionStates(sink, 10 /* maxRecordsPerLoop */);
+  while (!sink->done) {
+    eventBase_.loopOnce();
+  }
+  EXPECT_EQ(sink->exported, *sink->done);
+  EXPECT_GE(*sink->done, cm_->getNumConnections());
+  EXPECT_LE(*sink->done, 65);
+}
+
+TEST_F(ConnectionManagerTest, testDropConnectionsIfTargetsMatching) {
+  for (auto& conn : conns_) {
+    EXPECT_CALL(*conn, getIdleTime())
+        .WillRepeatedly(Return(std::chrono::milliseconds(5)));
+    EXPECT_CALL(*conn, getLastActivityElapsedTime())
+        .WillRepeatedly(Return(folly::Optional<std::chrono::milliseconds>()));
+  }
+  // Only the busy population should be evicted.
+  for (size_t i : {0, 7, 33}) {
+    EXPECT_CALL(*conns_[i], isBusy()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*conns_[i], dropConnection(_));
+  }
+
+  folly::Optional<std::pair<size_t, size_t>> result;
+  cm_->dropConnectionsIf(
+      [](const ConnectionStateRecord& record) {
+        return record.state == ConnectionStateRecord::State::BUSY;
+      },
+      10 /* maxScannedPerLoop */,
+      [&](size_t scanned, size_t dropped) {
+        result.emplace(scanned, dropped);
+      });
+  // Nothing is dropped synchronously; the scan runs chunk per loop.
+  EXPECT_EQ(65, cm_->getNumConnections());
+  while (!result) {
+    eventBase_.loopOnce();
+  }
+  EXPECT_EQ(65, result->first);
+  EXPECT_EQ(3, result->second);
+  EXPECT_EQ(62, cm_->getNumConnections());
+}
+
+TEST_F(ConnectionManagerTest, testDropConnectionsIfIsIncremental) {
+  for (auto& conn : conns_) {
+    EXPECT_CALL(*conn, getIdleTime())
+        .WillRepeatedly(Return(std::chrono::milliseconds(5)));
+    EXPECT_CALL(*conn, getLastActivityElapsedTime())
+        .WillRepeatedly(Return(folly::Optional<std::chrono::milliseconds>()));
+    EXPECT_CALL(*conn, dropConnection(_));
+  }
+
+  bool done = false;
+  cm_->dropConnectionsIf(
+      [](const ConnectionStateRecord&) { return true; },
+      10 /* maxScannedPerLoop */,
+      [&](size_t, size_t) { done = true; });
+  eventBase_.loopOnce();
+  // Only one chunk's worth has gone; the rest waits for later loops.
+  EXPECT_EQ(55, cm_->getNumConnections());
+  while (!done) {
+    eventBase_.loopOnce();
+  }
+  EXPECT_EQ(0, cm_->getNumConnections());
+}
+
+TEST_F(ConnectionManagerTest, testDropConnectionsIfSurvivesRemovalMidScan) {
+  for (auto& conn : conns_) {
+    EXPECT_CALL(*conn, getIdleTime())
+        .WillRepeatedly(Return(std::chrono::milliseconds(5)));
+    EXPECT_CALL(*conn, getLastActivityElapsedTime())
+        .WillRepeatedly(Return(folly::Optional<std::chrono::milliseconds>()));
+  }
+
+  folly::Optional<std::pair<size_t, size_t>> result;
+  cm_->dropConnectionsIf(
+      [](const ConnectionStateRecord&) { return false; },
+      10 /* maxScannedPerLoop */,
+      [&](size_t scanned, size_t dropped) {
+        result.emplace(scanned, dropped);
+      });
+  eventBase_.loopOnce();
+  // Remove a swath while the scan is parked between chunks; the resume
+  // iterator must be fixed up like the exporters' iterators are.
+  for (size_t i = 10; i < 50; i++) {
+    removeConn(conns_[i].get());
+  }
+  while (!result) {
+    eventBase_.loopOnce();
+  }
+  EXPECT_GE(result->first, cm_->getNumConnections());
+  EXPECT_LE(result->first, 65);
+  EXPECT_EQ(0, result->second);
+  EXPECT_EQ(25, cm_->getNumConnections());
+}
+
+TEST_F(ConnectionManagerTest, testCoalescedIdleTimeoutExpires) {
+  cm_->setCoalescedIdleTimeouts(std::chrono::milliseconds(10));
+  auto conn = MockConnection::makeUnique(this);
+  EXPECT_CALL(*conn, timeoutExpired_()).WillOnce(Invoke([&] {
+    cm_->removeConnection(conn.get());
+  }));
+  cm_->addConnection(conn.get(), true /* idleTimeout */);
+  // The loop drains once the timeout has fired: with the ring empty the
+  // scanner stops rescheduling itself.
+  eventBase_.loop();
+}
+
+TEST_F(ConnectionManagerTest, testCoalescedIdleTimeoutCanceledOnRemove) {
+  cm_->setCoalescedIdleTimeouts(std::chrono::milliseconds(10));
+  auto conn = MockConnection::makeUnique(this);
+  cm_->addConnection(conn.get(), true /* idleTimeout */);
+  // Removing the connection must unlink it from its bucket; the strict
+  // mock fails the test if timeoutExpired_ fires anyway.
+  cm_->removeConnection(conn.get());
+  eventBase_.loop();
+}
+
+TEST_F(ConnectionManagerTest, testCoalescedIdleTimeoutResetPushesDeadline) {
+  const auto granularity = std::chrono::milliseconds(10);
+  cm_->setCoalescedIdleTimeouts(granularity);
+  auto conn = MockConnection::makeUnique(this);
+  cm_->addConnection(conn.get(), true /* idleTimeout */);
+
+  std::chrono::steady_clock::time_point resetAt;
+  eventBase_.runAfterDelay(
+      [&] {
+        resetAt = std::chrono::steady_clock::now();
+        conn->resetTimeout();
+      },
+      50);
+
+  std::chrono::steady_clock::time_point expiredAt;
+  EXPECT_CALL(*conn, timeoutExpired_()).WillOnce(Invoke([&] {
+    expiredAt = std::chrono::steady_clock::now();
+    cm_->removeConnection(conn.get());
+  }));
+  eventBase_.loop();
+
+  // The reset restarted the full idle timeout; coalescing may fire up to
+  // one granularity early relative to the restarted deadline, never more.
+  EXPECT_GE(expiredAt - resetAt, cm_->getDefaultTimeout() - granularity);
+}
+
+class ShardedConnectionManagerTest : public testing::Test {
+ public:
+  ShardedConnectionManagerTest() {
+    scm_ = ShardedConnectionManager::makeUnique(
+        &eventBase_, std::chrono::milliseconds(100), 4);
+  }
+
+  void addConns(uint64_t n) {
+    for (size_t i = 0; i < n; i++) {
+      conns_.insert(conns_.begin(), MockConnection::makeUnique(nullptr));
+      scm_->addConnection(conns_.front().get());
+    }
+  }
+
+ protected:
+  folly::EventBase eventBase_;
+  ShardedConnectionManager::UniquePtr scm_;
+  std::vector<MockConnection::UniquePtr> conns_;
+};
+
+TEST_F(ShardedConnectionManagerTest, testRoundRobinPlacement) {
+  addConns(8);
+  EXPECT_EQ(8, scm_->getNumConnections());
+  for (size_t i = 0; i < scm_->getNumShards(); i++) {
+    EXPECT_EQ(2, scm_->getShard(i).getNumConnections());
+  }
+}
+
+TEST_F(ShardedConnectionManagerTest, testDropPercentIsIncremental) {
+  addConns(8);
+  for (const auto& conn : conns_) {
+    EXPECT_CALL(*conn, dropConnection(_));
+  }
+  scm_->dropConnections(1.0);
+  // Nothing happens until the loop runs; shards are visited one loop
+  // iteration at a time.
+  EXPECT_EQ(8, scm_->getNumConnections());
+  eventBase_.loopOnce();
+  EXPECT_EQ(6, scm_->getNumConnections());
+  eventBase_.loop();
+  EXPECT_EQ(0, scm_->getNumConnections());
+}
+
+TEST_F(ShardedConnectionManagerTest, testDropAllSynchronous) {
+  addConns(8);
+  for (const auto& conn : conns_) {
+    EXPECT_CALL(*conn, dropConnection(_));
+  }
+  scm_->dropAllConnections();
+  EXPECT_EQ(0, scm_->getNumConnections());
+}
 } // namespace
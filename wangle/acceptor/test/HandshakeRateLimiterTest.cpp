@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/acceptor/HandshakeRateLimiter.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono;
+using namespace wangle;
+
+namespace {
+
+folly::SocketAddress addr(const std::string& ip) {
+  return folly::SocketAddress(ip, 443);
+}
+
+steady_clock::time_point at(uint64_t ms) {
+  return steady_clock::time_point(milliseconds(ms));
+}
+
+} // namespace
+
+TEST(HandshakeRateLimiterTest, ShedsOverLimit) {
+  HandshakeRateLimiter limiter(3, seconds(1));
+
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(0)));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(10)));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(20)));
+  EXPECT_FALSE(limiter.admit(addr("10.0.0.1"), at(30)));
+
+  // An unrelated prefix has its own budget.
+  EXPECT_TRUE(limiter.admit(addr("192.168.1.1"), at(30)));
+}
+
+TEST(HandshakeRateLimiterTest, AggregatesBySourcePrefix) {
+  HandshakeRateLimiter limiter(2, seconds(1));
+
+  // Two hosts in the same /24 share one budget.
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(0)));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.2"), at(0)));
+  EXPECT_FALSE(limiter.admit(addr("10.0.0.3"), at(0)));
+
+  // The neighboring /24 does not.
+  EXPECT_TRUE(limiter.admit(addr("10.0.1.1"), at(0)));
+}
+
+TEST(HandshakeRateLimiterTest, WindowSlides) {
+  HandshakeRateLimiter limiter(2, seconds(1));
+
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(900)));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(950)));
+  // Just into the next window the previous one still counts in full.
+  EXPECT_FALSE(limiter.admit(addr("10.0.0.1"), at(1000)));
+  // Most of the way through it has decayed out of the sliding window.
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(1900)));
+  // Two full windows of silence clear the budget entirely.
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(4000)));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(4000)));
+}
+
+TEST(HandshakeRateLimiterTest, RefundExemptsResumptions) {
+  HandshakeRateLimiter limiter(2, seconds(1));
+
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(0)));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(10)));
+  // The second handshake resumed a session; returning its admission
+  // leaves room for another full handshake.
+  limiter.refund(addr("10.0.0.1"), at(20));
+  EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(30)));
+  EXPECT_FALSE(limiter.admit(addr("10.0.0.1"), at(40)));
+}
+
+TEST(HandshakeRateLimiterTest, DisabledLimiterAdmitsEverything) {
+  HandshakeRateLimiter limiter(0, seconds(1));
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(limiter.admit(addr("10.0.0.1"), at(0)));
+  }
+}
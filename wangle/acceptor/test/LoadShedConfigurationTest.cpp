@@ -69,3 +69,42 @@ TEST(LoadShedConfigurationTest, TestSettersAndGetters) {
   lsc.addAllowlistAddr(folly::StringPiece("10.0.0.7/20"));
   EXPECT_TRUE(lsc.isAllowlisted(folly::SocketAddress("10.0.0.7", 0)));
 }
+
+TEST(LoadShedConfigurationTest, TestAllowlistMixedFamilies) {
+  LoadShedConfiguration lsc;
+  EXPECT_FALSE(lsc.isAllowlisted(folly::SocketAddress("10.0.0.1", 0)));
+
+  lsc.addAllowlistAddr(folly::StringPiece("2401:db00::1"));
+  lsc.addAllowlistAddr(folly::StringPiece("2a03:2880::/32"));
+  lsc.addAllowlistAddr(folly::StringPiece("10.1.0.0/16"));
+
+  EXPECT_TRUE(lsc.isAllowlisted(folly::SocketAddress("2401:db00::1", 443)));
+  EXPECT_FALSE(lsc.isAllowlisted(folly::SocketAddress("2401:db00::2", 443)));
+  EXPECT_TRUE(lsc.isAllowlisted(folly::SocketAddress("2a03:2880:ffff::1", 0)));
+  EXPECT_FALSE(lsc.isAllowlisted(folly::SocketAddress("2a03:2881::1", 0)));
+  EXPECT_TRUE(lsc.isAllowlisted(folly::SocketAddress("10.1.2.3", 0)));
+  EXPECT_FALSE(lsc.isAllowlisted(folly::SocketAddress("10.2.2.3", 0)));
+
+  // Clearing the networks drops the CIDR entries but keeps exact addresses.
+  lsc.setAllowlistNetworks({});
+  EXPECT_TRUE(lsc.isAllowlisted(folly::SocketAddress("2401:db00::1", 443)));
+  EXPECT_FALSE(lsc.isAllowlisted(folly::SocketAddress("10.1.2.3", 0)));
+}
+
+TEST(LoadShedConfigurationTest, TestShedEventCounters) {
+  using ShedCause = LoadShedConfiguration::ShedCause;
+  LoadShedConfiguration lsc;
+
+  EXPECT_EQ(0, lsc.getShedEventCount(ShedCause::CPU));
+  lsc.recordShedEvent(ShedCause::CPU);
+  lsc.recordShedEvent(ShedCause::CPU);
+  lsc.recordShedEvent(ShedCause::MEMORY);
+  EXPECT_EQ(2, lsc.getShedEventCount(ShedCause::CPU));
+  EXPECT_EQ(1, lsc.getShedEventCount(ShedCause::MEMORY));
+  EXPECT_EQ(0, lsc.getShedEventCount(ShedCause::OTHER));
+
+  // Copies of the configuration share the same counters.
+  LoadShedConfiguration copy = lsc;
+  copy.recordShedEvent(ShedCause::CPU);
+  EXPECT_EQ(3, lsc.getShedEventCount(ShedCause::CPU));
+}
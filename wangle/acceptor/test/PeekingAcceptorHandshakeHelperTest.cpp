@@ -36,13 +36,13 @@ class MockPeekingCallback
   MOCK_METHOD4_T(
       getHelperInternal,
       AcceptorHandshakeHelper*(
-          const std::vector<uint8_t>&,
+          folly::ByteRange,
           const folly::SocketAddress&,
           std::chrono::steady_clock::time_point,
           TransportInfo&));
 
   wangle::AcceptorHandshakeHelper::UniquePtr getHelper(
-      const std::vector<uint8_t>& peekedBytes,
+      folly::ByteRange peekedBytes,
       const folly::SocketAddress& clientAddr,
       std::chrono::steady_clock::time_point acceptTime,
       TransportInfo& tinfo) override {
@@ -98,7 +98,7 @@ TEST_F(PeekingAcceptorHandshakeHelperTest, TestPeekSuccess) {
   EXPECT_CALL(mockPeekCallback1_, getHelperInternal(_, _, _, _))
       .WillOnce(Return(helperPtr_.release()));
   EXPECT_CALL(*innerHelper_, startInternal(_, _));
-  helper_->peekSuccess(buf);
+  helper_->peekSuccess(folly::range(buf));
 }
 
 TEST_F(PeekingAcceptorHandshakeHelperTest, TestPeekNonSuccess) {
@@ -112,7 +112,7 @@ TEST_F(PeekingAcceptorHandshakeHelperTest, TestPeekNonSuccess) {
   EXPECT_CALL(mockPeekCallback2_, getHelperInternal(_, _, _, _))
       .WillOnce(Return(nullptr));
   EXPECT_CALL(callback_, connectionError_(_, _, _));
-  helper_->peekSuccess(buf);
+  helper_->peekSuccess(folly::range(buf));
 }
 
 TEST_F(PeekingAcceptorHandshakeHelperTest, TestPeek2ndSuccess) {
@@ -126,7 +126,7 @@ TEST_F(PeekingAcceptorHandshakeHelperTest, TestPeek2ndSuccess) {
   EXPECT_CALL(mockPeekCallback2_, getHelperInternal(_, _, _, _))
       .WillOnce(Return(helperPtr_.release()));
   EXPECT_CALL(*innerHelper_, startInternal(_, _));
-  helper_->peekSuccess(buf);
+  helper_->peekSuccess(folly::range(buf));
 }
 
 TEST_F(PeekingAcceptorHandshakeHelperTest, TestEOFDuringPeek) {
@@ -168,7 +168,7 @@ TEST_F(PeekingAcceptorHandshakeHelperTest, TestDropAfterPeek) {
   EXPECT_CALL(mockPeekCallback1_, getHelperInternal(_, _, _, _))
       .WillOnce(Return(helperPtr_.release()));
   EXPECT_CALL(*innerHelper_, startInternal(_, _));
-  helper_->peekSuccess(buf);
+  helper_->peekSuccess(folly::range(buf));
 
   EXPECT_CALL(*innerHelper_, dropConnection(_));
   helper_->dropConnection();
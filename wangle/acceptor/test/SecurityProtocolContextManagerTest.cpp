@@ -29,7 +29,7 @@ class LengthPeeker : public PeekingAcceptorHandshakeHelper::PeekCallback {
   LengthPeeker() : PeekingAcceptorHandshakeHelper::PeekCallback(N) {}
 
   AcceptorHandshakeHelper::UniquePtr getHelper(
-      const std::vector<uint8_t>& /* bytes */,
+      folly::ByteRange /* bytes */,
       const folly::SocketAddress& /* clientAddr */,
       std::chrono::steady_clock::time_point /* acceptTime */,
       TransportInfo&) override {
@@ -70,6 +70,25 @@ TEST_F(SecurityProtocolContextManagerTest, TestLongAtEnd) {
   EXPECT_EQ(manager_.getPeekBytes(), 9);
 }
 
+TEST_F(SecurityProtocolContextManagerTest, TestSingleProtocolSkipsPeek) {
+  manager_.addPeeker(&p0_);
+
+  EXPECT_FALSE(manager_.usesPeekDispatch());
+}
+
+TEST_F(SecurityProtocolContextManagerTest, TestPeekingProtocolNeedsPeek) {
+  manager_.addPeeker(&p2_);
+
+  EXPECT_TRUE(manager_.usesPeekDispatch());
+}
+
+TEST_F(SecurityProtocolContextManagerTest, TestMultipleProtocolsNeedPeek) {
+  manager_.addPeeker(&p0_);
+  manager_.addPeeker(&p2_);
+
+  EXPECT_TRUE(manager_.usesPeekDispatch());
+}
+
 TEST_F(SecurityProtocolContextManagerTest, TestLongMiddle) {
   manager_.addPeeker(&p0_);
   manager_.addPeeker(&p9_);
@@ -78,3 +97,59 @@ TEST_F(SecurityProtocolContextManagerTest, TestLongMiddle) {
 
   EXPECT_EQ(manager_.getPeekBytes(), 9);
 }
+
+TEST_F(SecurityProtocolContextManagerTest, SampledStackWeightedDraw) {
+  manager_.addSampledStack("openssl", &p2_, 1);
+  manager_.addSampledStack("fizz", &p0_, 0);
+
+  // Only one stack has weight, so the draw is deterministic and the
+  // connection is tagged with it.
+  TransportInfo tinfo;
+  auto* mgr = manager_.getHandshakeManager(
+      nullptr, folly::SocketAddress(), std::chrono::steady_clock::now(), tinfo);
+  EXPECT_EQ(tinfo.handshakeStack, "openssl");
+  mgr->destroy();
+
+  // Flipping the weights flips the draw: the rollback lever.
+  EXPECT_TRUE(manager_.setStackWeight("openssl", 0));
+  EXPECT_TRUE(manager_.setStackWeight("fizz", 3));
+  TransportInfo tinfo2;
+  auto* mgr2 = manager_.getHandshakeManager(
+      nullptr,
+      folly::SocketAddress(),
+      std::chrono::steady_clock::now(),
+      tinfo2);
+  EXPECT_EQ(tinfo2.handshakeStack, "fizz");
+  mgr2->destroy();
+
+  EXPECT_FALSE(manager_.setStackWeight("quic", 1));
+
+  auto stats = manager_.getStackStats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].sampled, 1);
+  EXPECT_EQ(stats[1].sampled, 1);
+}
+
+TEST_F(SecurityProtocolContextManagerTest, SampledStackStatsAggregate) {
+  manager_.addSampledStack("openssl", &p2_, 1);
+  manager_.addSampledStack("fizz", &p0_, 1);
+
+  manager_.recordHandshakeResult("fizz", std::chrono::milliseconds(10), true);
+  manager_.recordHandshakeResult("fizz", std::chrono::milliseconds(30), true);
+  manager_.recordHandshakeResult(
+      "openssl", std::chrono::milliseconds(50), false);
+  // Tags no stack owns are ignored.
+  manager_.recordHandshakeResult("quic", std::chrono::milliseconds(5), true);
+
+  auto stats = manager_.getStackStats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].name, "openssl");
+  EXPECT_EQ(stats[0].successes, 0);
+  EXPECT_EQ(stats[0].failures, 1);
+  EXPECT_EQ(stats[0].totalLatencyMs, 50);
+  EXPECT_EQ(stats[1].name, "fizz");
+  EXPECT_EQ(stats[1].successes, 2);
+  EXPECT_EQ(stats[1].failures, 0);
+  EXPECT_EQ(stats[1].totalLatencyMs, 40);
+  EXPECT_EQ(stats[1].maxLatencyMs, 30);
+}
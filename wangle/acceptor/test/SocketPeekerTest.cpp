@@ -18,6 +18,8 @@
 
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <folly/portability/Sockets.h>
+#include <folly/portability/Unistd.h>
 #include <thread>
 
 #include <folly/io/async/test/MockAsyncSocket.h>
@@ -31,8 +33,8 @@ class MockSocketPeekerCallback : public SocketPeeker::Callback {
  public:
   ~MockSocketPeekerCallback() override = default;
 
-  MOCK_METHOD1(peekSuccess_, void(typename std::vector<uint8_t>));
-  void peekSuccess(std::vector<uint8_t> peekBytes) noexcept override {
+  MOCK_METHOD1(peekSuccess_, void(folly::ByteRange));
+  void peekSuccess(folly::ByteRange peekBytes) noexcept override {
     peekSuccess_(peekBytes);
   }
 
@@ -152,3 +154,65 @@ TEST_F(SocketPeekerTest, TestNoPeekSuccess) {
   EXPECT_CALL(callback, peekSuccess_(BufMatches(&buf, 0)));
   peeker->start();
 }
+
+class MsgPeekTest : public Test {
+ public:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    sock = AsyncSocket::newSocket(&base, NetworkSocket::fromFd(fds[0]));
+    remoteFd = fds[1];
+  }
+
+  void TearDown() override {
+    if (remoteFd >= 0) {
+      ::close(remoteFd);
+    }
+  }
+
+  std::shared_ptr<AsyncSocket> sock;
+  int remoteFd;
+  MockSocketPeekerCallback callback;
+  EventBase base;
+};
+
+TEST_F(MsgPeekTest, TestPeekDoesNotConsume) {
+  ASSERT_EQ(3, ::write(remoteFd, "\x16\x03\x01", 3));
+
+  SocketPeeker::UniquePtr peeker(new SocketPeeker(*sock, &callback, 3));
+  EXPECT_CALL(callback, peekSuccess_(BufMatches("\x16\x03\x01", 3)));
+  // The data has already arrived, so the peek completes synchronously.
+  peeker->start();
+  peeker = nullptr;
+
+  // The peeked bytes are still in the kernel buffer.
+  char buf[3];
+  EXPECT_EQ(
+      3, ::recv(sock->getNetworkSocket().toFd(), buf, sizeof(buf), MSG_DONTWAIT));
+  EXPECT_EQ(0, memcmp(buf, "\x16\x03\x01", 3));
+}
+
+TEST_F(MsgPeekTest, TestPeekWaitsForAllBytes) {
+  SocketPeeker::UniquePtr peeker(new SocketPeeker(*sock, &callback, 3));
+  peeker->start();
+
+  ASSERT_EQ(2, ::write(remoteFd, "\x16\x03", 2));
+  base.loopOnce();
+
+  EXPECT_CALL(callback, peekSuccess_(BufMatches("\x16\x03\x01", 3)))
+      .WillOnce(Invoke([&](ByteRange) { base.terminateLoopSoon(); }));
+  ASSERT_EQ(1, ::write(remoteFd, "\x01", 1));
+  base.loopForever();
+}
+
+TEST_F(MsgPeekTest, TestEOFWhilePeeking) {
+  SocketPeeker::UniquePtr peeker(new SocketPeeker(*sock, &callback, 3));
+  peeker->start();
+
+  EXPECT_CALL(callback, peekError_(_)).WillOnce(Invoke([&](const auto&) {
+    base.terminateLoopSoon();
+  }));
+  ::close(remoteFd);
+  remoteFd = -1;
+  base.loopForever();
+}
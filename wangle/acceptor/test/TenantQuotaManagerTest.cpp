@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/acceptor/TenantQuotaManager.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono;
+using namespace wangle;
+
+namespace {
+
+steady_clock::time_point at(uint64_t ms) {
+  return steady_clock::time_point(milliseconds(ms));
+}
+
+} // namespace
+
+TEST(TenantQuotaManagerTest, ConnectionQuotaBoundsOneTenant) {
+  auto pool = std::make_shared<TenantQuotaPool>(seconds(1), 1);
+  TenantQuota quota;
+  quota.maxConnections = 2;
+  pool->addTenant("a.example.com", quota);
+
+  TenantQuotaEnforcer enforcer(pool);
+  int c1, c2;
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(0)));
+  enforcer.onConnectionAdded(&c1);
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(10)));
+  enforcer.onConnectionAdded(&c2);
+  EXPECT_FALSE(enforcer.admit("a.example.com", at(20)));
+
+  // An SNI no tenant owns is not subject to quotas.
+  EXPECT_TRUE(enforcer.admit("other.example.net", at(20)));
+
+  // Closing a connection makes room again.
+  enforcer.onConnectionRemoved(&c1);
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(30)));
+
+  auto stats = pool->getTenantStats();
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats[0].sni, "a.example.com");
+  EXPECT_EQ(stats[0].admitted, 3);
+  EXPECT_EQ(stats[0].rejectedConnectionLimit, 1);
+  EXPECT_EQ(stats[0].rejectedHandshakeRate, 0);
+}
+
+TEST(TenantQuotaManagerTest, HandshakeRateWindowSlides) {
+  auto pool = std::make_shared<TenantQuotaPool>(seconds(1), 1);
+  TenantQuota quota;
+  quota.maxHandshakesPerWindow = 2;
+  pool->addTenant("a.example.com", quota);
+
+  TenantQuotaEnforcer enforcer(pool);
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(0)));
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(10)));
+  EXPECT_FALSE(enforcer.admit("a.example.com", at(20)));
+  // Most of the way through the next window the burst has decayed out
+  // of the sliding estimate.
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(1900)));
+
+  auto stats = pool->getTenantStats();
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats[0].rejectedHandshakeRate, 1);
+}
+
+TEST(TenantQuotaManagerTest, WildcardMatchesOneLeadingLabel) {
+  auto pool = std::make_shared<TenantQuotaPool>(seconds(1), 1);
+  TenantQuota quota;
+  quota.maxConnections = 1;
+  pool->addTenant(".wild.example.com", quota);
+
+  TenantQuotaEnforcer enforcer(pool);
+  int c1;
+  EXPECT_TRUE(enforcer.admit("a.wild.example.com", at(0)));
+  enforcer.onConnectionAdded(&c1);
+  // A sibling host shares the wildcard tenant's budget.
+  EXPECT_FALSE(enforcer.admit("b.wild.example.com", at(10)));
+  // The bare suffix is not covered by the wildcard.
+  EXPECT_TRUE(enforcer.admit("wild.example.com", at(10)));
+}
+
+TEST(TenantQuotaManagerTest, EnforcerTeardownReturnsLeases) {
+  auto pool = std::make_shared<TenantQuotaPool>(seconds(1), 1);
+  TenantQuota quota;
+  quota.maxConnections = 1;
+  pool->addTenant("a.example.com", quota);
+
+  {
+    TenantQuotaEnforcer enforcer(pool);
+    int c1;
+    EXPECT_TRUE(enforcer.admit("a.example.com", at(0)));
+    enforcer.onConnectionAdded(&c1);
+    EXPECT_FALSE(enforcer.admit("a.example.com", at(10)));
+  }
+
+  // The torn-down enforcer's bound connection went back to the pool.
+  EXPECT_EQ(pool->getTenantStats()[0].currentConnections, 0);
+  TenantQuotaEnforcer enforcer(pool);
+  EXPECT_TRUE(enforcer.admit("a.example.com", at(20)));
+}
@@ -28,21 +28,17 @@ void AcceptRoutingHandler<Pipeline, R>::read(
 
   populateAcceptors();
 
-  const auto& connInfo = boost::get<ConnInfo&>(conn);
+  const auto& connInfo = conn.get<ConnInfo&>();
   auto socket = std::shared_ptr<folly::AsyncTransport>(
       connInfo.sock, folly::DelayedDestruction::Destructor());
 
   uint64_t connId = nextConnId_++;
 
-  // Create a new routing pipeline for this connection to read from
-  // the socket until it parses the routing data
-  auto routingPipeline = newRoutingPipeline();
-  routingPipeline->addBack(wangle::AsyncSocketHandler(socket));
-  routingPipeline->addBack(routingHandlerFactory_->newHandler(connId, this));
-  routingPipeline->finalize();
-
-  // Initialize TransportInfo and set it on the routing pipeline
-  auto transportInfo = std::make_shared<TransportInfo>(connInfo.tinfo);
+  // Initialize TransportInfo for the connection. The accept path's
+  // TransportInfo dies when this read returns, so move it instead of
+  // copying.
+  auto transportInfo =
+      std::make_shared<TransportInfo>(std::move(connInfo.tinfo));
   folly::SocketAddress localAddr, peerAddr;
   try {
     socket->getLocalAddress(&localAddr);
@@ -53,12 +49,124 @@ void AcceptRoutingHandler<Pipeline, R>::read(
   }
   transportInfo->localAddr = std::make_shared<folly::SocketAddress>(localAddr);
   transportInfo->remoteAddr = std::make_shared<folly::SocketAddress>(peerAddr);
-  routingPipeline->setTransportInfo(transportInfo);
 
+  if (peekBytes_ > 0) {
+    if (auto* sock = socket->getUnderlyingTransport<folly::AsyncSocket>()) {
+      // Sniff the routing key off the socket without building a routing
+      // pipeline. The peeker may complete synchronously if the bytes
+      // have already arrived.
+      auto peeker = std::make_unique<RoutingPeeker>(
+          this, connId, socket, std::move(transportInfo));
+      auto* rawPeeker = peeker.get();
+      peekers_[connId] = std::move(peeker);
+      rawPeeker->start(sock, peekBytes_);
+      return;
+    }
+  }
+
+  startRoutingPipeline(
+      connId,
+      std::move(socket),
+      routingHandlerFactory_->newHandler(connId, this),
+      std::move(transportInfo));
+}
+
+template <typename Pipeline, typename R>
+void AcceptRoutingHandler<Pipeline, R>::startRoutingPipeline(
+    uint64_t connId,
+    std::shared_ptr<folly::AsyncTransport> socket,
+    std::shared_ptr<RoutingDataHandler<R>> routingHandler,
+    std::shared_ptr<TransportInfo> transportInfo) {
+  // Grab a routing pipeline for this connection to read from the socket
+  // until it parses the routing data
+  auto routingPipeline = takeRoutingPipeline();
+  routingPipeline->addBack(wangle::AsyncSocketHandler(socket));
+  routingPipeline->addBack(routingHandler);
+  routingPipeline->finalize();
+  routingPipeline->setTransportInfo(std::move(transportInfo));
+
+  routingHandlers_[connId] = std::move(routingHandler);
   routingPipeline->transportActive();
   routingPipelines_[connId] = std::move(routingPipeline);
 }
 
+template <typename Pipeline, typename R>
+void AcceptRoutingHandler<Pipeline, R>::onPeekedRoutingData(
+    uint64_t connId,
+    folly::ByteRange data) {
+  auto peekerIter = peekers_.find(connId);
+  CHECK(peekerIter != peekers_.end());
+  auto peeker = std::move(peekerIter->second);
+  peekers_.erase(peekerIter);
+
+  auto routingHandler = routingHandlerFactory_->newHandler(connId, this);
+
+  // Hand the peeked prefix to the parser as a copy; the peeked bytes are
+  // only valid for the duration of the peek callback, and remain in the
+  // socket either way.
+  folly::IOBufQueue bufQueue{folly::IOBufQueue::cacheChainLength()};
+  bufQueue.append(folly::IOBuf::copyBuffer(data));
+
+  typename RoutingDataHandler<R>::RoutingData routingData;
+  if (routingHandler->parseRoutingData(bufQueue, routingData)) {
+    routeConnection(
+        peeker->getSocket(),
+        std::move(routingHandler),
+        peeker->getTransportInfo(),
+        routingData,
+        false /* deliverBufQueue: the socket still holds these bytes */);
+    return;
+  }
+
+  // The routing key needs more than the peeked prefix (or a stateful
+  // parse); fall back to the routing-pipeline path. Nothing has been
+  // consumed, so the pipeline re-reads from the first byte.
+  startRoutingPipeline(
+      connId,
+      peeker->getSocket(),
+      std::move(routingHandler),
+      peeker->getTransportInfo());
+}
+
+template <typename Pipeline, typename R>
+void AcceptRoutingHandler<Pipeline, R>::onPeekError(
+    uint64_t connId,
+    const folly::AsyncSocketException& ex) {
+  VLOG(4) << "Exception while peeking for routing data: " << ex.what();
+
+  // Notify all handlers of the exception; dropping the peeker closes and
+  // deletes the socket.
+  auto ctx = getContext();
+  auto pipeline =
+      CHECK_NOTNULL(dynamic_cast<AcceptPipeline*>(ctx->getPipeline()));
+  pipeline->readException(
+      folly::make_exception_wrapper<folly::AsyncSocketException>(ex));
+
+  peekers_.erase(connId);
+}
+
+template <typename Pipeline, typename R>
+DefaultPipeline::Ptr AcceptRoutingHandler<Pipeline, R>::takeRoutingPipeline() {
+  if (!routingPipelinePool_.empty()) {
+    auto pipeline = std::move(routingPipelinePool_.back());
+    routingPipelinePool_.pop_back();
+    return pipeline;
+  }
+  return newRoutingPipeline();
+}
+
+template <typename Pipeline, typename R>
+void AcceptRoutingHandler<Pipeline, R>::recycleRoutingPipeline(
+    DefaultPipeline::Ptr pipeline) {
+  // Strip the per-connection handlers; the pipeline object (and, when a
+  // context pool is set, its context allocations) is reused for the next
+  // connection's parse.
+  pipeline->removeBack(); // the routing data handler
+  pipeline->removeFront(); // the AsyncSocketHandler
+  pipeline->setTransportInfo(nullptr);
+  routingPipelinePool_.push_back(std::move(pipeline));
+}
+
 template <typename Pipeline, typename R>
 void AcceptRoutingHandler<Pipeline, R>::readEOF(Context*) {
   // Null implementation to terminate the call in this handler
@@ -85,34 +193,65 @@ void AcceptRoutingHandler<Pipeline, R>::onRoutingData(
   auto routingPipeline = std::move(routingPipelineIter->second);
   routingPipelines_.erase(routingPipelineIter);
 
+  auto routingHandlerIter = routingHandlers_.find(connId);
+  CHECK(routingHandlerIter != routingHandlers_.end());
+  auto routingHandler = std::move(routingHandlerIter->second);
+  routingHandlers_.erase(routingHandlerIter);
+
   // Fetch the socket from the pipeline and pause reading from the
   // socket
   auto socket = std::dynamic_pointer_cast<folly::AsyncTransport>(
       routingPipeline->getTransport());
   CHECK(socket);
   routingPipeline->transportInactive();
-  auto originalEvb = socket->getEventBase();
-  socket->detachEventBase();
+  auto transportInfo = routingPipeline->getTransportInfo();
+
+  // The pipeline is done with this connection; put it back on the free
+  // list before the connection migrates.
+  recycleRoutingPipeline(std::move(routingPipeline));
 
+  routeConnection(
+      std::move(socket),
+      std::move(routingHandler),
+      std::move(transportInfo),
+      routingData,
+      true /* deliverBufQueue */);
+}
+
+template <typename Pipeline, typename R>
+void AcceptRoutingHandler<Pipeline, R>::routeConnection(
+    std::shared_ptr<folly::AsyncTransport> socket,
+    std::shared_ptr<RoutingDataHandler<R>> routingHandler,
+    std::shared_ptr<TransportInfo> transportInfo,
+    typename RoutingDataHandler<R>::RoutingData& routingData,
+    bool deliverBufQueue) {
   // Hash based on routing data to pick a new acceptor
   uint64_t hash = std::hash<R>()(routingData.routingData);
-  auto acceptor = acceptors_[hash % acceptors_.size()];
+  auto workerIdx = workerPolicy_->select(hash, acceptors_);
+  DCHECK_LT(workerIdx, acceptors_.size());
+  placementCounts_[workerIdx]++;
+  auto acceptor = acceptors_[workerIdx];
+  auto originalEvb = socket->getEventBase();
 
   originalEvb->runInLoop(
       [=, routingData = std::move(routingData)]() mutable {
+        // Detaching in the loop callback lets any in-flight callbacks on
+        // the socket (including a peeker's deferred destruction) finish
+        // first.
+        socket->detachEventBase();
+
         // Switch to the new acceptor's thread
         acceptor->getEventBase()->runInEventBaseThread(
             [=, routingData = std::move(routingData)]() mutable {
               socket->attachEventBase(acceptor->getEventBase());
 
-              auto routingHandler =
-                  routingPipeline->template getHandler<RoutingDataHandler<R>>();
-              DCHECK(routingHandler);
-              auto transportInfo = routingPipeline->getTransportInfo();
+              // The child pipeline is built directly on the destination
+              // EventBase; the routing handler outlives the hop through
+              // this closure, matching its old routing-pipeline lifetime.
               auto pipeline = childPipelineFactory_->newPipeline(
                   socket,
                   routingData.routingData,
-                  routingHandler,
+                  routingHandler.get(),
                   transportInfo);
 
               auto connection = new
@@ -121,8 +260,10 @@ void AcceptRoutingHandler<Pipeline, R>::onRoutingData(
 
               pipeline->transportActive();
 
-              // Pass in the buffered bytes to the pipeline
-              pipeline->read(routingData.bufQueue);
+              if (deliverBufQueue) {
+                // Pass in the buffered bytes to the pipeline
+                pipeline->read(routingData.bufQueue);
+              }
             });
       },
       /* thisIteration = */ true);
@@ -142,6 +283,7 @@ void AcceptRoutingHandler<Pipeline, R>::onError(
 
   // Delete the routing pipeline. This will close and delete the socket as well.
   routingPipelines_.erase(connId);
+  routingHandlers_.erase(connId);
 }
 
 template <typename Pipeline, typename R>
@@ -152,6 +294,8 @@ void AcceptRoutingHandler<Pipeline, R>::populateAcceptors() {
   CHECK(server_);
   server_->forEachWorker(
       [&](Acceptor* acceptor) { acceptors_.push_back(acceptor); });
+  placementCounts_.resize(acceptors_.size());
+  workerPolicy_->initialize(acceptors_);
 }
 
 } // namespace wangle
@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <wangle/acceptor/SocketPeeker.h>
 #include <wangle/bootstrap/RoutingDataHandler.h>
 #include <wangle/bootstrap/ServerBootstrap.h>
+#include <wangle/bootstrap/WorkerSelectionPolicy.h>
 #include <wangle/channel/Pipeline.h>
 
 namespace wangle {
@@ -34,6 +36,13 @@ namespace wangle {
  * to notify the AcceptRoutingHandler. AcceptRoutingHandler then pauses
  * reads from the socket, moves the connection over to the hashed
  * worker thread, and resumes reading from the socket on the child pipeline.
+ *
+ * With setPeekRoutingBytes the routing pipeline is skipped entirely for
+ * the common case: the routing key is sniffed off the socket with
+ * MSG_PEEK and the child pipeline is the only pipeline ever built for
+ * the connection. Connections that do take the routing-pipeline path
+ * reuse pipeline objects from a free list instead of constructing one
+ * per connection.
  */
 
 template <typename Pipeline, typename R>
@@ -67,19 +76,149 @@ class AcceptRoutingHandler : public wangle::InboundHandler<AcceptPipelineType>,
     return routingPipelines_.size();
   }
 
+  /**
+   * Try to extract the routing data from the first numBytes of each
+   * connection with a kernel peek (see SocketPeeker) instead of building
+   * a routing pipeline. The peeked prefix is handed to a handler from the
+   * routing handler factory; nothing is consumed from the socket, so the
+   * child pipeline reads the stream from the first byte and
+   * RoutingData::bufQueue is ignored. A parse that needs more than
+   * numBytes (parseRoutingData returning false), or a transport that is
+   * not an AsyncSocket, falls back to the routing-pipeline path.
+   */
+  void setPeekRoutingBytes(size_t numBytes) {
+    peekBytes_ = numBytes;
+  }
+
+  /**
+   * Replace how routed connections are spread over the worker threads.
+   * The default is HashModWorkerSelectionPolicy (hash modulo worker
+   * count); BoundedLoadWorkerSelectionPolicy adds connection-count
+   * feedback, and LagAwareWorkerSelectionPolicy steers by instantaneous
+   * loop lag. Must be set before the server starts accepting.
+   */
+  void setWorkerSelectionPolicy(std::shared_ptr<WorkerSelectionPolicy> policy) {
+    workerPolicy_ = std::move(policy);
+    if (!acceptors_.empty()) {
+      workerPolicy_->initialize(acceptors_);
+    }
+  }
+
+  /**
+   * How evenly routed connections have been placed across workers.
+   * imbalance is the busiest worker's share of placements relative to a
+   * perfectly even split: 1.0 is balanced, 1.3 means the hottest worker
+   * got 30% more than its fair share.
+   */
+  struct PlacementStats {
+    std::vector<uint64_t> placementsPerWorker;
+    uint64_t totalPlacements{0};
+    double imbalance{0};
+  };
+
+  PlacementStats getPlacementStats() const {
+    PlacementStats stats;
+    stats.placementsPerWorker = placementCounts_;
+    for (auto count : placementCounts_) {
+      stats.totalPlacements += count;
+    }
+    if (stats.totalPlacements > 0) {
+      auto maxCount = *std::max_element(
+          placementCounts_.begin(), placementCounts_.end());
+      stats.imbalance = static_cast<double>(maxCount) *
+          placementCounts_.size() / stats.totalPlacements;
+    }
+    return stats;
+  }
+
  private:
+  // Per-connection state for the peek-based routing mode: owns the
+  // SocketPeeker and the accept-path metadata until routing resolves.
+  class RoutingPeeker : public SocketPeeker::Callback {
+   public:
+    RoutingPeeker(
+        AcceptRoutingHandler* handler,
+        uint64_t connId,
+        std::shared_ptr<folly::AsyncTransport> socket,
+        std::shared_ptr<TransportInfo> transportInfo)
+        : handler_(handler),
+          connId_(connId),
+          socket_(std::move(socket)),
+          transportInfo_(std::move(transportInfo)) {}
+
+    void start(folly::AsyncSocket* socket, size_t numBytes) {
+      peeker_.reset(new SocketPeeker(*socket, this, numBytes));
+      peeker_->start();
+    }
+
+    void peekSuccess(folly::ByteRange data) noexcept override {
+      handler_->onPeekedRoutingData(connId_, data);
+    }
+
+    void peekError(const folly::AsyncSocketException& ex) noexcept override {
+      handler_->onPeekError(connId_, ex);
+    }
+
+    const std::shared_ptr<folly::AsyncTransport>& getSocket() const {
+      return socket_;
+    }
+
+    const std::shared_ptr<TransportInfo>& getTransportInfo() const {
+      return transportInfo_;
+    }
+
+   private:
+    AcceptRoutingHandler* handler_;
+    uint64_t connId_;
+    std::shared_ptr<folly::AsyncTransport> socket_;
+    std::shared_ptr<TransportInfo> transportInfo_;
+    SocketPeeker::UniquePtr peeker_;
+  };
+
   void populateAcceptors();
   virtual DefaultPipeline::Ptr newRoutingPipeline() {
     return DefaultPipeline::create();
   }
 
+  void startRoutingPipeline(
+      uint64_t connId,
+      std::shared_ptr<folly::AsyncTransport> socket,
+      std::shared_ptr<RoutingDataHandler<R>> routingHandler,
+      std::shared_ptr<TransportInfo> transportInfo);
+
+  // Picks the target acceptor from the routing data and migrates the
+  // connection to its EventBase, where the child pipeline is built
+  // directly. deliverBufQueue is false on the peek path, where the
+  // routed bytes are still in the socket.
+  void routeConnection(
+      std::shared_ptr<folly::AsyncTransport> socket,
+      std::shared_ptr<RoutingDataHandler<R>> routingHandler,
+      std::shared_ptr<TransportInfo> transportInfo,
+      typename RoutingDataHandler<R>::RoutingData& routingData,
+      bool deliverBufQueue);
+
+  void onPeekedRoutingData(uint64_t connId, folly::ByteRange data);
+  void onPeekError(uint64_t connId, const folly::AsyncSocketException& ex);
+
+  DefaultPipeline::Ptr takeRoutingPipeline();
+  void recycleRoutingPipeline(DefaultPipeline::Ptr pipeline);
+
   ServerBootstrap<Pipeline>* server_;
   std::shared_ptr<RoutingDataHandlerFactory<R>> routingHandlerFactory_;
   std::shared_ptr<RoutingDataPipelineFactory<Pipeline, R>>
       childPipelineFactory_;
 
   std::vector<Acceptor*> acceptors_;
+  std::shared_ptr<WorkerSelectionPolicy> workerPolicy_{
+      std::make_shared<HashModWorkerSelectionPolicy>()};
+  std::vector<uint64_t> placementCounts_;
   std::map<uint64_t, DefaultPipeline::Ptr> routingPipelines_;
+  std::map<uint64_t, std::shared_ptr<RoutingDataHandler<R>>> routingHandlers_;
+  std::map<uint64_t, std::unique_ptr<RoutingPeeker>> peekers_;
+  // Stripped routing pipelines ready for reuse; bounded by the peak
+  // number of concurrent routing parses.
+  std::vector<DefaultPipeline::Ptr> routingPipelinePool_;
+  size_t peekBytes_{0};
   uint64_t nextConnId_{0};
 };
 
@@ -95,10 +234,24 @@ class AcceptRoutingPipelineFactory : public AcceptPipelineFactory {
         routingHandlerFactory_(routingHandlerFactory),
         childPipelineFactory_(childPipelineFactory) {}
 
+  /**
+   * Install this worker selection policy on every accept thread's
+   * routing handler. Share one instance only if the policy tolerates
+   * concurrent select() calls (LagAwareWorkerSelectionPolicy does; it
+   * reads published atomics).
+   */
+  void setWorkerSelectionPolicy(std::shared_ptr<WorkerSelectionPolicy> policy) {
+    workerPolicy_ = std::move(policy);
+  }
+
   AcceptPipeline::Ptr newPipeline(Acceptor*) override {
     auto pipeline = AcceptPipeline::create();
-    pipeline->addBack(AcceptRoutingHandler<Pipeline, R>(
-        server_, routingHandlerFactory_, childPipelineFactory_));
+    AcceptRoutingHandler<Pipeline, R> handler(
+        server_, routingHandlerFactory_, childPipelineFactory_);
+    if (workerPolicy_) {
+      handler.setWorkerSelectionPolicy(workerPolicy_);
+    }
+    pipeline->addBack(std::move(handler));
     pipeline->finalize();
 
     return pipeline;
@@ -109,6 +262,7 @@ class AcceptRoutingPipelineFactory : public AcceptPipelineFactory {
   std::shared_ptr<RoutingDataHandlerFactory<R>> routingHandlerFactory_;
   std::shared_ptr<RoutingDataPipelineFactory<Pipeline, R>>
       childPipelineFactory_;
+  std::shared_ptr<WorkerSelectionPolicy> workerPolicy_;
 };
 
 template <typename Pipeline, typename R>
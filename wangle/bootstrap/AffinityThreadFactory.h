@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace wangle {
+
+/**
+ * A NamedThreadFactory that pins each thread it creates to a CPU set,
+ * assigned round-robin from the given list. With one CPU per set this pins
+ * threads to distinct cores; with one set per NUMA node it partitions the
+ * pool across nodes, so an IO thread's working set stays node-local
+ * instead of following the scheduler across sockets.
+ *
+ * On platforms without sched_setaffinity pinning is a no-op and the
+ * factory behaves like a plain NamedThreadFactory.
+ */
+class AffinityThreadFactory : public folly::NamedThreadFactory {
+ public:
+  AffinityThreadFactory(
+      folly::StringPiece prefix,
+      std::vector<std::vector<int>> cpuSets)
+      : NamedThreadFactory(prefix), cpuSets_(std::move(cpuSets)) {
+    CHECK(!cpuSets_.empty());
+  }
+
+  std::thread newThread(folly::Func&& func) override {
+    auto cpus = cpuSets_[next_++ % cpuSets_.size()];
+    return folly::NamedThreadFactory::newThread(
+        [cpus = std::move(cpus), func = std::move(func)]() mutable {
+          applyCpuSet(cpus);
+          func();
+        });
+  }
+
+  /**
+   * One single-CPU set per core: pins a pool's threads to distinct cores.
+   */
+  static std::vector<std::vector<int>> perCoreCpuSets() {
+    std::vector<std::vector<int>> sets;
+    const auto numCpus = std::thread::hardware_concurrency();
+    for (unsigned i = 0; i < numCpus; i++) {
+      sets.push_back({static_cast<int>(i)});
+    }
+    if (sets.empty()) {
+      // Concurrency unknown; an empty set leaves the thread unpinned
+      sets.push_back({});
+    }
+    return sets;
+  }
+
+  /**
+   * One set per NUMA node, parsed from sysfs. Empty on platforms or
+   * machines without exposed NUMA topology; callers should fall back to
+   * per-core pinning or no pinning.
+   */
+  static std::vector<std::vector<int>> numaNodeCpuSets() {
+    std::vector<std::vector<int>> sets;
+#ifdef __linux__
+    for (int node = 0;; node++) {
+      std::string cpulist;
+      auto path = folly::to<std::string>(
+          "/sys/devices/system/node/node", node, "/cpulist");
+      if (!folly::readFile(path.c_str(), cpulist)) {
+        break;
+      }
+      sets.push_back(parseCpuList(cpulist));
+    }
+#endif
+    return sets;
+  }
+
+  /**
+   * Parses a sysfs-style CPU list such as "0-23,48-71". Public for tests.
+   */
+  static std::vector<int> parseCpuList(folly::StringPiece cpulist) {
+    std::vector<int> cpus;
+    std::vector<folly::StringPiece> ranges;
+    folly::split(',', folly::trimWhitespace(cpulist), ranges);
+    for (auto range : ranges) {
+      auto dash = range.find('-');
+      if (dash == std::string::npos) {
+        cpus.push_back(folly::to<int>(range));
+      } else {
+        const int lo = folly::to<int>(range.subpiece(0, dash));
+        const int hi = folly::to<int>(range.subpiece(dash + 1));
+        for (int cpu = lo; cpu <= hi; cpu++) {
+          cpus.push_back(cpu);
+        }
+      }
+    }
+    return cpus;
+  }
+
+ private:
+  static void applyCpuSet(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) {
+      return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+      CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      PLOG(WARNING) << "failed to set thread CPU affinity";
+    }
+#else
+    (void)cpus;
+#endif
+  }
+
+  std::vector<std::vector<int>> cpuSets_;
+  std::atomic<size_t> next_{0};
+};
+
+} // namespace wangle
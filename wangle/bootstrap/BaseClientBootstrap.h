@@ -22,7 +22,9 @@
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/ssl/SSLSession.h>
+#include <wangle/bootstrap/NameResolver.h>
 #include <wangle/channel/Pipeline.h>
+#include <wangle/client/ssl/ClientSSLSessionCache.h>
 #include <memory>
 
 namespace wangle {
@@ -110,11 +112,48 @@ class BaseClientBootstrap {
     return this;
   }
 
+  /*
+   * Resolver used by hostname-based connects; when unset they fall
+   * back to the process-wide caching resolver
+   * (CachingNameResolver::getShared()).
+   */
+  BaseClientBootstrap* nameResolver(std::shared_ptr<NameResolver> resolver) {
+    nameResolver_ = std::move(resolver);
+    return this;
+  }
+
+  /*
+   * Resume TLS sessions across connects with no further plumbing: a
+   * cached session for the destination is applied before the handshake,
+   * and a freshly established one is captured back into the cache.
+   * Sessions are keyed by the SNI name when one is set, otherwise by
+   * the host:port being dialed, so one cache can be shared by every
+   * client bootstrap in the process. An explicitly provided sslSession()
+   * takes precedence over a cached one.
+   */
+  BaseClientBootstrap* sslSessionCache(
+      std::shared_ptr<ClientSSLSessionCache> cache) {
+    sslSessionCache_ = std::move(cache);
+    return this;
+  }
+
   BaseClientBootstrap* deferSecurityNegotiation(bool deferSecurityNegotiation) {
     deferSecurityNegotiation_ = deferSecurityNegotiation;
     return this;
   }
 
+  /*
+   * Attempt TCP Fast Open on connect(): when the kernel holds a valid TFO
+   * cookie for the peer, the first write rides in the SYN and the
+   * connection saves a round trip. Without a cookie the socket falls back
+   * to a regular handshake transparently, so this is safe to enable
+   * whether or not the server supports TFO.
+   */
+  BaseClientBootstrap* enableTFO(bool enable) {
+    enableTFO_ = enable;
+    return this;
+  }
+
   void setPipeline(const typename P::Ptr& pipeline) {
     pipeline_ = pipeline;
   }
@@ -137,13 +176,20 @@ class BaseClientBootstrap {
     return folly::emptySocketOptionMap;
   }
 
+  std::string sessionCacheKey(const folly::SocketAddress& address) const {
+    return sni_.empty() ? address.describe() : sni_;
+  }
+
   std::shared_ptr<PipelineFactory<P>> pipelineFactory_;
   typename P::Ptr pipeline_;
   folly::SSLContextPtr sslContext_;
   std::shared_ptr<folly::ssl::SSLSession> sslSession_{nullptr};
   std::string sni_;
   bool deferSecurityNegotiation_{false};
+  bool enableTFO_{false};
   SSLSessionEstablishedCallbackUniquePtr sslSessionEstablishedCallback_;
+  std::shared_ptr<NameResolver> nameResolver_;
+  std::shared_ptr<ClientSSLSessionCache> sslSessionCache_;
   ClientBootstrapSocketOptions socketOptions_;
 };
 
@@ -23,6 +23,8 @@
 #include <folly/io/async/EventBaseManager.h>
 #include <wangle/bootstrap/BaseClientBootstrap.h>
 #include <wangle/channel/Pipeline.h>
+#include <algorithm>
+#include <vector>
 
 using folly::AsyncSSLSocket;
 
@@ -59,6 +61,7 @@ class ClientBootstrap : public BaseClientBootstrap<Pipeline>,
                 sslSocket->getSSLSession());
           }
         }
+        bootstrap_->captureSSLSession(socket_.get());
         bootstrap_->makePipeline(std::move(socket_));
         if (bootstrap_->getPipeline()) {
           bootstrap_->getPipeline()->transportActive();
@@ -103,20 +106,7 @@ class ClientBootstrap : public BaseClientBootstrap<Pipeline>,
                          : folly::EventBaseManager::get()->getEventBase();
     folly::Future<Pipeline*> retval((Pipeline*)nullptr);
     base->runImmediatelyOrRunInEventBaseThreadAndWait([&]() {
-      std::shared_ptr<folly::AsyncSocket> socket;
-      if (this->sslContext_) {
-        auto sslSocket = folly::AsyncSSLSocket::newSocket(
-            this->sslContext_, base, this->deferSecurityNegotiation_);
-        if (!this->sni_.empty()) {
-          sslSocket->setServerName(this->sni_);
-        }
-        if (this->sslSession_) {
-          sslSocket->setSSLSession(this->sslSession_);
-        }
-        socket = std::move(sslSocket);
-      } else {
-        socket = folly::AsyncSocket::newSocket(base);
-      }
+      auto socket = makeSocket(base, address);
       folly::Promise<Pipeline*> promise;
       retval = promise.getFuture();
       DCHECK_LE(timeout.count(), std::numeric_limits<int>::max());
@@ -133,11 +123,266 @@ class ClientBootstrap : public BaseClientBootstrap<Pipeline>,
     return retval;
   }
 
+  /**
+   * Connects to the first of the given addresses to answer, RFC 8305
+   * style: attempts are started in order, staggered by staggerDelay (or
+   * immediately once an earlier attempt fails hard), the first successful
+   * connect is adopted and all others are canceled. Worst-case latency to
+   * a reachable fallback address is therefore the stagger delay rather
+   * than a full connect timeout on the preferred one.
+   */
+  folly::Future<Pipeline*> connect(
+      const std::vector<folly::SocketAddress>& addresses,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+      std::chrono::milliseconds staggerDelay = std::chrono::milliseconds(250)) {
+    if (addresses.empty()) {
+      return folly::makeFuture<Pipeline*>(
+          folly::make_exception_wrapper<std::invalid_argument>(
+              "no addresses to connect to"));
+    }
+    auto base = (group_) ? group_->getEventBase()
+                         : folly::EventBaseManager::get()->getEventBase();
+    folly::Future<Pipeline*> retval((Pipeline*)nullptr);
+    base->runImmediatelyOrRunInEventBaseThreadAndWait([&]() {
+      folly::Promise<Pipeline*> promise;
+      retval = promise.getFuture();
+      auto race = std::make_shared<ConnectRace>(
+          this,
+          addresses,
+          timeout,
+          staggerDelay,
+          base,
+          std::move(promise),
+          std::move(this->sslSessionEstablishedCallback_));
+      race->start();
+    });
+    return retval;
+  }
+
+  /**
+   * Resolve hostname:port asynchronously and connect to the results
+   * with the staggered multi-address connect above. Lookups go through
+   * the bootstrap's nameResolver() when one was set, otherwise the
+   * process-wide caching resolver, so repeat dials to the same
+   * destination usually skip the resolver entirely and connect latency
+   * stops including DNS.
+   */
+  folly::Future<Pipeline*> connectTo(
+      const std::string& hostname,
+      uint16_t port,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+      std::chrono::milliseconds staggerDelay = std::chrono::milliseconds(250)) {
+    auto resolver = this->nameResolver_;
+    if (!resolver) {
+      resolver = CachingNameResolver::getShared();
+    }
+    auto safety = std::make_shared<folly::DestructorCheck::Safety>(*this);
+    return resolver->resolve(hostname, port)
+        .thenValue([this, safety, timeout, staggerDelay](
+                       std::vector<folly::SocketAddress> addresses) {
+          if (safety->destroyed()) {
+            return folly::makeFuture<Pipeline*>(
+                folly::make_exception_wrapper<folly::AsyncSocketException>(
+                    folly::AsyncSocketException::NOT_OPEN,
+                    "bootstrap destroyed during name resolution"));
+          }
+          return connect(addresses, timeout, staggerDelay);
+        });
+  }
+
   ~ClientBootstrap() override = default;
 
  protected:
   int port_;
   std::shared_ptr<folly::IOThreadPoolExecutor> group_;
+
+ private:
+  std::shared_ptr<folly::AsyncSocket> makeSocket(
+      folly::EventBase* base,
+      const folly::SocketAddress& address) {
+    std::shared_ptr<folly::AsyncSocket> socket;
+    if (this->sslContext_) {
+      auto sslSocket = folly::AsyncSSLSocket::newSocket(
+          this->sslContext_, base, this->deferSecurityNegotiation_);
+      if (!this->sni_.empty()) {
+        sslSocket->setServerName(this->sni_);
+      }
+      auto session = this->sslSession_;
+      if (!session && this->sslSessionCache_) {
+        session = this->sslSessionCache_->get(this->sessionCacheKey(address));
+      }
+      if (session) {
+        sslSocket->setSSLSession(std::move(session));
+      }
+      socket = std::move(sslSocket);
+    } else {
+      socket = folly::AsyncSocket::newSocket(base);
+    }
+    if (this->enableTFO_) {
+      socket->enableTFO();
+    }
+    return socket;
+  }
+
+  void captureSSLSession(folly::AsyncSocket* socket) {
+    if (!this->sslSessionCache_) {
+      return;
+    }
+    auto* sslSocket = dynamic_cast<AsyncSSLSocket*>(socket);
+    if (!sslSocket || sslSocket->getSSLSessionReused()) {
+      return;
+    }
+    folly::SocketAddress peer;
+    sslSocket->getPeerAddress(&peer);
+    this->sslSessionCache_->put(
+        this->sessionCacheKey(peer), sslSocket->getSSLSession());
+  }
+
+  // Shared state of one multi-address connect; kept alive by the attempt
+  // callbacks and stagger timers until the last of them resolves.
+  class ConnectRace : public std::enable_shared_from_this<ConnectRace> {
+   public:
+    ConnectRace(
+        ClientBootstrap* bootstrap,
+        std::vector<folly::SocketAddress> addresses,
+        std::chrono::milliseconds timeout,
+        std::chrono::milliseconds staggerDelay,
+        folly::EventBase* base,
+        folly::Promise<Pipeline*> promise,
+        SSLSessionEstablishedCallbackUniquePtr sslSessionEstablishedCallback)
+        : bootstrap_(bootstrap),
+          addresses_(std::move(addresses)),
+          timeout_(timeout),
+          staggerDelay_(staggerDelay),
+          base_(base),
+          promise_(std::move(promise)),
+          safety_(*bootstrap),
+          sslSessionEstablishedCallback_(
+              std::move(sslSessionEstablishedCallback)) {}
+
+    void start() {
+      startNextAttempt();
+    }
+
+   private:
+    class AttemptCallback : public folly::AsyncSocket::ConnectCallback {
+     public:
+      AttemptCallback(
+          std::shared_ptr<ConnectRace> race,
+          std::shared_ptr<folly::AsyncSocket> socket)
+          : race_(std::move(race)), socket_(std::move(socket)) {}
+
+      void connectSuccess() noexcept override {
+        race_->attemptSucceeded(std::move(socket_));
+        delete this;
+      }
+
+      void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+        race_->attemptFailed(socket_, ex);
+        delete this;
+      }
+
+     private:
+      std::shared_ptr<ConnectRace> race_;
+      std::shared_ptr<folly::AsyncSocket> socket_;
+    };
+
+    void startNextAttempt() {
+      if (won_ || safety_.destroyed() || nextAddress_ >= addresses_.size()) {
+        return;
+      }
+      const auto& address = addresses_[nextAddress_++];
+      auto socket = bootstrap_->makeSocket(base_, address);
+      pending_.push_back(socket);
+      inFlight_++;
+      DCHECK_LE(timeout_.count(), std::numeric_limits<int>::max());
+      socket->connect(
+          new AttemptCallback(this->shared_from_this(), socket),
+          address,
+          folly::to_narrow(timeout_.count()),
+          bootstrap_->getSocketOptions(address.getFamily()));
+      if (nextAddress_ < addresses_.size()) {
+        auto self = this->shared_from_this();
+        base_->tryRunAfterDelay(
+            [self] { self->startNextAttempt(); },
+            folly::to_narrow(staggerDelay_.count()));
+      }
+    }
+
+    void attemptSucceeded(std::shared_ptr<folly::AsyncSocket> socket) {
+      inFlight_--;
+      removePending(socket.get());
+      if (won_ || safety_.destroyed()) {
+        socket->closeNow();
+        return;
+      }
+      won_ = true;
+
+      // Cancel the losers; closeNow invokes their connectErr inline
+      auto losers = std::move(pending_);
+      pending_.clear();
+      for (auto& loser : losers) {
+        loser->closeNow();
+      }
+
+      if (sslSessionEstablishedCallback_) {
+        auto* sslSocket = dynamic_cast<AsyncSSLSocket*>(socket.get());
+        if (sslSocket && !sslSocket->getSSLSessionReused()) {
+          sslSessionEstablishedCallback_->onEstablished(
+              sslSocket->getSSLSession());
+        }
+      }
+      bootstrap_->captureSSLSession(socket.get());
+      bootstrap_->makePipeline(std::move(socket));
+      if (bootstrap_->getPipeline()) {
+        bootstrap_->getPipeline()->transportActive();
+      }
+      promise_.setValue(bootstrap_->getPipeline());
+    }
+
+    void attemptFailed(
+        const std::shared_ptr<folly::AsyncSocket>& socket,
+        const folly::AsyncSocketException& ex) {
+      inFlight_--;
+      removePending(socket.get());
+      if (won_) {
+        return;
+      }
+      lastError_ =
+          folly::make_exception_wrapper<folly::AsyncSocketException>(ex);
+      if (nextAddress_ < addresses_.size()) {
+        // A hard failure promotes the next candidate immediately instead
+        // of waiting out the stagger delay.
+        startNextAttempt();
+      } else if (inFlight_ == 0) {
+        promise_.setException(std::move(lastError_));
+      }
+    }
+
+    void removePending(folly::AsyncSocket* socket) {
+      pending_.erase(
+          std::remove_if(
+              pending_.begin(),
+              pending_.end(),
+              [&](const auto& s) { return s.get() == socket; }),
+          pending_.end());
+    }
+
+    ClientBootstrap* bootstrap_;
+    std::vector<folly::SocketAddress> addresses_;
+    std::chrono::milliseconds timeout_;
+    std::chrono::milliseconds staggerDelay_;
+    folly::EventBase* base_;
+    folly::Promise<Pipeline*> promise_;
+    folly::DestructorCheck::Safety safety_;
+    SSLSessionEstablishedCallbackUniquePtr sslSessionEstablishedCallback_;
+
+    std::vector<std::shared_ptr<folly::AsyncSocket>> pending_;
+    size_t nextAddress_{0};
+    size_t inFlight_{0};
+    bool won_{false};
+    folly::exception_wrapper lastError_;
+  };
 };
 
 class ClientBootstrapFactory
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/container/F14Map.h>
+#include <wangle/acceptor/ConnectionManager.h>
+#include <wangle/bootstrap/BaseClientBootstrap.h>
+#include <wangle/bootstrap/ClientBootstrap.h>
+#include <wangle/channel/Pipeline.h>
+
+namespace wangle {
+
+/**
+ * A pool of client pipelines keyed by upstream address, for callers that
+ * re-dial the same hosts frequently and want to amortize TCP/TLS setup.
+ *
+ * Checked-in connections are parked per host in LIFO order, so the most
+ * recently used transport (warmest in cache, least likely to have idled out
+ * on the peer) is handed out first. Parking is bounded per host; overflow
+ * checkins and connections that come back unhealthy are closed. Parked
+ * connections are registered with a ConnectionManager, so the usual idle
+ * timeout machinery evicts the ones nobody reclaims.
+ *
+ * getConnection() hands out a pipeline the caller uses exclusively until
+ * returning it with checkin(). An optional checkin hook lets the caller
+ * reset per-request pipeline state before a connection is parked.
+ *
+ * Like BroadcastPool, this is meant to be used from a single thread,
+ * typically as a thread-local instance, and must outlive any outstanding
+ * getConnection() futures. Destroying the pool closes every pooled
+ * connection, parked or leased.
+ */
+template <typename P = DefaultPipeline>
+class ClientConnectionPool {
+ public:
+  struct Options {
+    // Max idle connections parked per host; overflow checkins are closed.
+    size_t maxIdlePerHost{8};
+
+    // Parked connections are closed after this long without reuse.
+    std::chrono::milliseconds idleTimeout{std::chrono::minutes(1)};
+  };
+
+  struct Stats {
+    uint64_t reuses{0}; // checkouts served from the pool
+    uint64_t dials{0}; // checkouts that had to connect upstream
+    uint64_t checkins{0};
+    uint64_t evictions{0}; // closed for overflow, ill health or idling out
+  };
+
+  ClientConnectionPool(
+      folly::EventBase* eventBase,
+      std::shared_ptr<PipelineFactory<P>> pipelineFactory,
+      std::shared_ptr<BaseClientBootstrapFactory<BaseClientBootstrap<P>>>
+          clientFactory,
+      Options options = Options())
+      : pipelineFactory_(pipelineFactory),
+        clientFactory_(clientFactory),
+        options_(options),
+        connectionManager_(
+            ConnectionManager::makeUnique(eventBase, options.idleTimeout)) {}
+
+  ~ClientConnectionPool() {
+    for (auto& hostEntry : idle_) {
+      for (auto* conn : hostEntry.second) {
+        closeAndDestroy(conn);
+      }
+    }
+    idle_.clear();
+    for (auto& leasedEntry : leased_) {
+      closeAndDestroy(leasedEntry.second);
+    }
+    leased_.clear();
+  }
+
+  // Non-copyable
+  ClientConnectionPool(const ClientConnectionPool&) = delete;
+  ClientConnectionPool& operator=(const ClientConnectionPool&) = delete;
+
+  /**
+   * Gets a connected pipeline for the given upstream, reusing a parked
+   * connection when one is available and dialing otherwise. The returned
+   * future completes inline on reuse.
+   */
+  folly::Future<P*> getConnection(
+      const folly::SocketAddress& address,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+    auto it = idle_.find(address);
+    while (it != idle_.end() && !it->second.empty()) {
+      auto* conn = it->second.back();
+      it->second.pop_back();
+      connectionManager_->removeConnection(conn);
+      auto* pipeline = conn->pipeline();
+      auto transport = pipeline ? pipeline->getTransport() : nullptr;
+      if (!transport || !transport->good()) {
+        // Went bad while parked
+        stats_.evictions++;
+        closeAndDestroy(conn);
+        continue;
+      }
+      stats_.reuses++;
+      leased_[pipeline] = conn;
+      return folly::makeFuture(pipeline);
+    }
+
+    stats_.dials++;
+    auto client = clientFactory_->newClient();
+    client->pipelineFactory(pipelineFactory_);
+    auto* clientPtr = client.get();
+    return clientPtr->connect(address, timeout)
+        .thenValue(
+            [this, address, client = std::move(client)](P* pipeline) mutable {
+              auto* conn =
+                  new PooledConnection(this, address, std::move(client));
+              leased_[pipeline] = conn;
+              return pipeline;
+            });
+  }
+
+  /**
+   * Returns a leased pipeline to the pool. Unhealthy connections and
+   * overflow beyond maxIdlePerHost are closed instead of parked.
+   */
+  void checkin(P* pipeline) {
+    auto it = leased_.find(pipeline);
+    if (it == leased_.end()) {
+      LOG(DFATAL) << "checkin of a pipeline this pool did not hand out";
+      return;
+    }
+    auto* conn = it->second;
+    leased_.erase(it);
+    stats_.checkins++;
+
+    auto transport = pipeline->getTransport();
+    auto& parked = idle_[conn->address()];
+    if (!transport || !transport->good() ||
+        parked.size() >= options_.maxIdlePerHost) {
+      if (parked.empty()) {
+        idle_.erase(conn->address());
+      }
+      stats_.evictions++;
+      closeAndDestroy(conn);
+      return;
+    }
+    if (checkinHook_) {
+      checkinHook_(pipeline);
+    }
+    parked.push_back(conn);
+    connectionManager_->addConnection(conn, true /* timeout */);
+  }
+
+  /**
+   * Invoked with each pipeline on checkin, before it is parked. Use this
+   * to clear per-request state so the next lease starts clean.
+   */
+  void setCheckinHook(folly::Function<void(P*)> hook) {
+    checkinHook_ = std::move(hook);
+  }
+
+  const Stats& getStats() const {
+    return stats_;
+  }
+
+  size_t getNumIdle() const {
+    size_t n = 0;
+    for (const auto& hostEntry : idle_) {
+      n += hostEntry.second.size();
+    }
+    return n;
+  }
+
+ private:
+  class PooledConnection : public ManagedConnection {
+   public:
+    PooledConnection(
+        ClientConnectionPool* pool,
+        folly::SocketAddress address,
+        typename BaseClientBootstrap<P>::Ptr client)
+        : pool_(pool), address_(std::move(address)), client_(std::move(client)) {}
+
+    P* pipeline() {
+      return client_->getPipeline();
+    }
+
+    const folly::SocketAddress& address() const {
+      return address_;
+    }
+
+    // ManagedConnection implementation; only parked connections are
+    // registered with the manager, so they are never busy.
+    void timeoutExpired() noexcept override {
+      pool_->evict(this);
+    }
+    void describe(std::ostream& os) const override {
+      os << "pooled connection to " << address_;
+    }
+    bool isBusy() const override {
+      return false;
+    }
+    void notifyPendingShutdown() override {}
+    void closeWhenIdle() override {
+      pool_->evict(this);
+    }
+    void dropConnection(const std::string& /* errorMsg */ = "") override {
+      pool_->evict(this);
+    }
+    void dumpConnectionState(uint8_t /* loglevel */) override {}
+
+   private:
+    ~PooledConnection() override = default;
+
+    ClientConnectionPool* pool_;
+    folly::SocketAddress address_;
+    typename BaseClientBootstrap<P>::Ptr client_;
+  };
+
+  void evict(PooledConnection* conn) {
+    auto it = idle_.find(conn->address());
+    if (it != idle_.end()) {
+      auto& parked = it->second;
+      parked.erase(
+          std::remove(parked.begin(), parked.end(), conn), parked.end());
+      if (parked.empty()) {
+        idle_.erase(it);
+      }
+    }
+    stats_.evictions++;
+    closeAndDestroy(conn);
+  }
+
+  void closeAndDestroy(PooledConnection* conn) {
+    if (auto* pipeline = conn->pipeline()) {
+      pipeline->close();
+    }
+    conn->destroy();
+  }
+
+  std::shared_ptr<PipelineFactory<P>> pipelineFactory_;
+  std::shared_ptr<BaseClientBootstrapFactory<BaseClientBootstrap<P>>>
+      clientFactory_;
+  Options options_;
+  ConnectionManager::UniquePtr connectionManager_;
+
+  folly::F14FastMap<folly::SocketAddress, std::vector<PooledConnection*>>
+      idle_;
+  folly::F14FastMap<P*, PooledConnection*> leased_;
+  folly::Function<void(P*)> checkinHook_;
+  Stats stats_;
+};
+
+} // namespace wangle
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/bootstrap/ListenerFdHandoff.h>
+
+#include <cstring>
+
+#include <glog/logging.h>
+
+#include <folly/net/NetOps.h>
+#include <folly/portability/Sockets.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace wangle {
+
+namespace {
+
+// One sendmsg carries the whole handoff: this header in the data
+// part, the fds in an SCM_RIGHTS control message. The receiver
+// answers with a single ack byte once it owns the fds.
+struct HandoffHeader {
+  uint32_t magic;
+  uint32_t numFds;
+};
+
+constexpr uint32_t kHandoffMagic = 0x57464431; // "WFD1"
+constexpr char kHandoffAck = 1;
+
+void setIoTimeout(folly::NetworkSocket sock, std::chrono::milliseconds t) {
+  struct timeval tv;
+  tv.tv_sec = t.count() / 1000;
+  tv.tv_usec = (t.count() % 1000) * 1000;
+  folly::netops::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  folly::netops::setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+bool fillUnixAddress(const std::string& path, sockaddr_un& addr) {
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    LOG(ERROR) << "Invalid handoff socket path: " << path;
+    return false;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+bool sendFdsAndAwaitAck(
+    folly::NetworkSocket sock,
+    const std::vector<folly::NetworkSocket>& fds,
+    std::chrono::milliseconds timeout) {
+  setIoTimeout(sock, timeout);
+
+  HandoffHeader header = {kHandoffMagic, uint32_t(fds.size())};
+  struct iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+
+  char control[CMSG_SPACE(sizeof(int) * kMaxHandoffFds)] = {};
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+  auto* fdData = reinterpret_cast<int*>(CMSG_DATA(cmsg));
+  for (size_t i = 0; i < fds.size(); i++) {
+    fdData[i] = fds[i].toFd();
+  }
+
+  if (folly::netops::sendmsg(sock, &msg, 0) !=
+      ssize_t(sizeof(HandoffHeader))) {
+    PLOG(ERROR) << "Failed to send listening fds to successor";
+    return false;
+  }
+
+  // The kernel dups the fds into the message at sendmsg time; wait for
+  // the ack so "handed off" means the successor actually holds them.
+  char ack = 0;
+  if (folly::netops::recv(sock, &ack, 1, 0) != 1 || ack != kHandoffAck) {
+    LOG(WARNING) << "Successor never acknowledged the fd handoff";
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+bool serveListeningFdHandoff(
+    const std::string& handoffPath,
+    const std::vector<folly::NetworkSocket>& fds,
+    std::chrono::milliseconds timeout) {
+  if (fds.empty() || fds.size() > kMaxHandoffFds) {
+    LOG(ERROR) << "Cannot hand off " << fds.size() << " fds";
+    return false;
+  }
+  sockaddr_un addr;
+  if (!fillUnixAddress(handoffPath, addr)) {
+    return false;
+  }
+
+  auto server = folly::netops::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server == folly::NetworkSocket()) {
+    PLOG(ERROR) << "Failed to create handoff socket";
+    return false;
+  }
+  // A crashed predecessor may have left its socket file behind.
+  ::unlink(handoffPath.c_str());
+  if (folly::netops::bind(
+          server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      folly::netops::listen(server, 1) != 0) {
+    PLOG(ERROR) << "Failed to listen on handoff socket " << handoffPath;
+    folly::netops::close(server);
+    return false;
+  }
+
+  bool handedOff = false;
+  folly::netops::PollDescriptor pfd;
+  pfd.fd = server;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  if (folly::netops::poll(&pfd, 1, int(timeout.count())) == 1) {
+    auto client = folly::netops::accept(server, nullptr, nullptr);
+    if (client != folly::NetworkSocket()) {
+      handedOff = sendFdsAndAwaitAck(client, fds, timeout);
+      folly::netops::close(client);
+    }
+  } else {
+    LOG(WARNING) << "No successor connected to " << handoffPath << " within "
+                 << timeout.count() << "ms";
+  }
+  folly::netops::close(server);
+  ::unlink(handoffPath.c_str());
+  return handedOff;
+}
+
+std::vector<folly::NetworkSocket> receiveListeningFds(
+    const std::string& handoffPath,
+    std::chrono::milliseconds timeout) {
+  std::vector<folly::NetworkSocket> fds;
+  sockaddr_un addr;
+  if (!fillUnixAddress(handoffPath, addr)) {
+    return fds;
+  }
+
+  auto sock = folly::netops::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock == folly::NetworkSocket()) {
+    PLOG(ERROR) << "Failed to create handoff socket";
+    return fds;
+  }
+  if (folly::netops::connect(
+          sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    // No predecessor offering fds: the normal first-boot case.
+    folly::netops::close(sock);
+    return fds;
+  }
+  setIoTimeout(sock, timeout);
+
+  HandoffHeader header = {};
+  struct iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+
+  char control[CMSG_SPACE(sizeof(int) * kMaxHandoffFds)] = {};
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  auto received = folly::netops::recvmsg(sock, &msg, 0);
+  if (received != ssize_t(sizeof(HandoffHeader)) ||
+      (msg.msg_flags & MSG_CTRUNC) || header.magic != kHandoffMagic ||
+      header.numFds == 0 || header.numFds > kMaxHandoffFds) {
+    LOG(ERROR) << "Malformed fd handoff message on " << handoffPath;
+    folly::netops::close(sock);
+    return fds;
+  }
+
+  for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const auto* fdData = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+    for (size_t i = 0; i < count; i++) {
+      // Keep the fds across this process's lifetime but not across a
+      // further exec; the next restart hands them off explicitly too.
+      ::fcntl(fdData[i], F_SETFD, FD_CLOEXEC);
+      fds.push_back(folly::NetworkSocket::fromFd(fdData[i]));
+    }
+  }
+  if (fds.size() != header.numFds) {
+    LOG(ERROR) << "Expected " << header.numFds << " fds in handoff, got "
+               << fds.size();
+    for (auto fd : fds) {
+      folly::netops::close(fd);
+    }
+    fds.clear();
+    folly::netops::close(sock);
+    return fds;
+  }
+
+  char ack = kHandoffAck;
+  folly::netops::send(sock, &ack, 1, 0);
+  folly::netops::close(sock);
+  return fds;
+}
+
+} // namespace wangle
+
+#else
+
+namespace wangle {
+
+bool serveListeningFdHandoff(
+    const std::string& /* handoffPath */,
+    const std::vector<folly::NetworkSocket>& /* fds */,
+    std::chrono::milliseconds /* timeout */) {
+  return false;
+}
+
+std::vector<folly::NetworkSocket> receiveListeningFds(
+    const std::string& /* handoffPath */,
+    std::chrono::milliseconds /* timeout */) {
+  return {};
+}
+
+} // namespace wangle
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <folly/net/NetworkSocket.h>
+
+namespace wangle {
+
+/**
+ * Listening-fd handoff between a draining process and its replacement,
+ * for zero-downtime binary restarts (see
+ * ServerBootstrap::exportListeningFds() /
+ * ServerBootstrap::bindInheritedListeners()).
+ *
+ * The old binary offers its listening fds on a unix domain socket; the
+ * new binary connects and receives them via SCM_RIGHTS. The fds stay
+ * open (and accepting) in the old process until it stops, and the new
+ * process starts accepting on the very same sockets, so no SYN is ever
+ * refused across the restart.
+ */
+
+/** Upper bound on the fds carried in one handoff */
+constexpr size_t kMaxHandoffFds = 64;
+
+/**
+ * Old-process side: listen on a unix domain socket at handoffPath,
+ * wait for the successor to connect, and pass it the given fds.
+ * A stale socket file from a crashed predecessor is replaced. Blocks
+ * until the successor acknowledges receipt or the timeout elapses;
+ * returns whether the handoff completed. The caller's fds are
+ * unaffected either way.
+ */
+bool serveListeningFdHandoff(
+    const std::string& handoffPath,
+    const std::vector<folly::NetworkSocket>& fds,
+    std::chrono::milliseconds timeout);
+
+/**
+ * New-process side: connect to the predecessor's handoff socket and
+ * receive its listening fds. Returns an empty vector when no
+ * predecessor is offering fds (the normal first-boot case) or on
+ * error; errors are logged. Received fds are marked close-on-exec.
+ */
+std::vector<folly::NetworkSocket> receiveListeningFds(
+    const std::string& handoffPath,
+    std::chrono::milliseconds timeout);
+
+} // namespace wangle
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+
+namespace wangle {
+
+/**
+ * Continuously samples one EventBase's scheduling lag. A timer is armed
+ * for a known deadline each interval; the delta between that deadline
+ * and when the callback actually runs is how far behind the loop is —
+ * a loop stuck in a long TLS batch shows up within one interval. The
+ * smoothed lag (EWMA, gain 1/8 as in TCP RTT smoothing) is published
+ * through an atomic readable from any thread, so accept-path policies
+ * can consult worker health without touching the worker's loop.
+ *
+ * Probing costs one timer callback per interval per worker; a
+ * quiescent loop measures (and pays) essentially nothing.
+ */
+class LoopLagProbe : private folly::AsyncTimeout {
+ public:
+  LoopLagProbe(folly::EventBase* evb, std::chrono::milliseconds interval)
+      : folly::AsyncTimeout(evb), evb_(evb), interval_(interval) {
+    evb_->runInEventBaseThread([this] { arm(); });
+  }
+
+  ~LoopLagProbe() override {
+    // A timeout may only be cancelled on its EventBase's thread.
+    evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+        [this] { cancelTimeout(); });
+  }
+
+  /** Smoothed scheduling lag; zero until the first sample lands. */
+  std::chrono::microseconds getLag() const {
+    return std::chrono::microseconds(lagUs_.load(std::memory_order_relaxed));
+  }
+
+ private:
+  void arm() {
+    deadline_ = std::chrono::steady_clock::now() + interval_;
+    scheduleTimeout(interval_);
+  }
+
+  void timeoutExpired() noexcept override {
+    const auto lag = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - deadline_);
+    const auto sample = std::max<int64_t>(lag.count(), 0);
+    const auto prev = lagUs_.load(std::memory_order_relaxed);
+    lagUs_.store(prev + (sample - prev) / 8, std::memory_order_relaxed);
+    arm();
+  }
+
+  folly::EventBase* evb_;
+  const std::chrono::milliseconds interval_;
+  std::chrono::steady_clock::time_point deadline_;
+  std::atomic<int64_t> lagUs_{0};
+};
+
+} // namespace wangle
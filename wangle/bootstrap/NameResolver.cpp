@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/bootstrap/NameResolver.h>
+
+#include <folly/Conv.h>
+#include <folly/Optional.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Singleton.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/portability/Sockets.h>
+
+using folly::SharedMutex;
+using folly::SocketAddress;
+
+namespace wangle {
+
+namespace {
+
+constexpr size_t kDefaultResolverThreads = 2;
+
+folly::Singleton<CachingNameResolver> sharedResolverSingleton([] {
+  return new CachingNameResolver(std::make_shared<ThreadedNameResolver>());
+});
+
+std::string cacheKey(const std::string& hostname, uint16_t port) {
+  return folly::to<std::string>(hostname, ':', port);
+}
+
+} // namespace
+
+ThreadedNameResolver::ThreadedNameResolver(
+    std::shared_ptr<folly::Executor> executor)
+    : executor_(std::move(executor)) {
+  if (!executor_) {
+    executor_ = std::make_shared<folly::CPUThreadPoolExecutor>(
+        kDefaultResolverThreads,
+        std::make_shared<folly::NamedThreadFactory>("NameResolver"));
+  }
+}
+
+folly::Future<std::vector<SocketAddress>> ThreadedNameResolver::resolve(
+    const std::string& hostname,
+    uint16_t port) {
+  return folly::via(executor_.get(), [hostname, port]() {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* results = nullptr;
+    const auto rc = getaddrinfo(hostname.c_str(), nullptr, &hints, &results);
+    if (rc != 0) {
+      throw std::runtime_error(folly::to<std::string>(
+          "failed to resolve ", hostname, ": ", gai_strerror(rc)));
+    }
+    SCOPE_EXIT {
+      freeaddrinfo(results);
+    };
+    std::vector<SocketAddress> addresses;
+    for (auto* ai = results; ai != nullptr; ai = ai->ai_next) {
+      SocketAddress address;
+      address.setFromSockaddr(ai->ai_addr, ai->ai_addrlen);
+      address.setPort(port);
+      addresses.push_back(std::move(address));
+    }
+    if (addresses.empty()) {
+      throw std::runtime_error(
+          folly::to<std::string>("no addresses for ", hostname));
+    }
+    return addresses;
+  });
+}
+
+CachingNameResolver::CachingNameResolver(
+    std::shared_ptr<NameResolver> upstream,
+    Options options)
+    : upstream_(std::move(upstream)), options_(options) {
+  CHECK(upstream_);
+}
+
+std::shared_ptr<CachingNameResolver> CachingNameResolver::getShared() {
+  return sharedResolverSingleton.try_get();
+}
+
+folly::Future<std::vector<SocketAddress>> CachingNameResolver::resolve(
+    const std::string& hostname,
+    uint16_t port) {
+  auto key = cacheKey(hostname, port);
+  const auto now = std::chrono::steady_clock::now();
+  folly::Optional<folly::Future<std::vector<SocketAddress>>> result;
+  ResultPromise promise;
+  bool refresh = false;
+  {
+    SharedMutex::WriteHolder lock(mutex_);
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+      auto& entry = it->second;
+      if (now < entry.freshUntil) {
+        result = entry.error
+            ? folly::makeFuture<std::vector<SocketAddress>>(entry.error)
+            : folly::makeFuture(entry.addresses);
+      } else if (now < entry.staleUntil && !entry.addresses.empty()) {
+        // Stale-while-revalidate: serve the old addresses immediately
+        // and refresh the entry off the caller's path. Only the first
+        // lookup to find the entry stale kicks off the refresh.
+        if (!entry.refreshing) {
+          entry.refreshing = true;
+          refresh = true;
+        }
+        result = folly::makeFuture(entry.addresses);
+      }
+    }
+    if (!result) {
+      auto pendingIt = pending_.find(key);
+      if (pendingIt != pending_.end()) {
+        result = pendingIt->second->getFuture();
+      } else {
+        promise = std::make_shared<
+            folly::SharedPromise<std::vector<SocketAddress>>>();
+        pending_.emplace(key, promise);
+        result = promise->getFuture();
+      }
+    }
+  }
+  if (promise) {
+    startLookup(std::move(key), hostname, port, std::move(promise));
+  } else if (refresh) {
+    startRefresh(std::move(key), hostname, port);
+  }
+  return std::move(*result);
+}
+
+void CachingNameResolver::startLookup(
+    std::string key,
+    const std::string& hostname,
+    uint16_t port,
+    ResultPromise promise) {
+  upstream_->resolve(hostname, port)
+      .thenTry([self = shared_from_this(),
+                key = std::move(key),
+                promise = std::move(promise)](
+                   folly::Try<std::vector<SocketAddress>> result) {
+        self->store(key, result);
+        promise->setTry(std::move(result));
+      });
+}
+
+void CachingNameResolver::startRefresh(
+    std::string key,
+    const std::string& hostname,
+    uint16_t port) {
+  upstream_->resolve(hostname, port)
+      .thenTry([self = shared_from_this(), key = std::move(key)](
+                   folly::Try<std::vector<SocketAddress>> result) {
+        if (result.hasValue()) {
+          self->store(key, result);
+        } else {
+          // Keep serving the stale addresses until they age out; clear
+          // the flag so a later lookup may try to refresh again.
+          SharedMutex::WriteHolder lock(self->mutex_);
+          auto it = self->cache_.find(key);
+          if (it != self->cache_.end()) {
+            it->second.refreshing = false;
+          }
+        }
+      });
+}
+
+void CachingNameResolver::store(
+    const std::string& key,
+    const folly::Try<std::vector<SocketAddress>>& result) {
+  const auto now = std::chrono::steady_clock::now();
+  CacheEntry entry;
+  if (result.hasValue()) {
+    entry.addresses = result.value();
+    entry.freshUntil = now + options_.positiveTtl;
+    entry.staleUntil = entry.freshUntil + options_.staleTtl;
+  } else {
+    entry.error = result.exception();
+    entry.freshUntil = now + options_.negativeTtl;
+    entry.staleUntil = entry.freshUntil;
+  }
+  SharedMutex::WriteHolder lock(mutex_);
+  cache_[key] = std::move(entry);
+  pending_.erase(key);
+}
+
+} // namespace wangle
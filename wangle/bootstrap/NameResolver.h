@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/SharedMutex.h>
+#include <folly/SocketAddress.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
+
+namespace wangle {
+
+/**
+ * Asynchronous hostname resolution for client bootstraps. resolve()
+ * must not block the calling thread; the returned future completes
+ * with the resolved addresses, already carrying the requested port,
+ * or with the resolution error.
+ */
+class NameResolver {
+ public:
+  virtual ~NameResolver() = default;
+
+  virtual folly::Future<std::vector<folly::SocketAddress>> resolve(
+      const std::string& hostname,
+      uint16_t port) = 0;
+};
+
+/**
+ * Runs getaddrinfo() on a background executor, so resolver slowness
+ * parks a thread there instead of stalling the caller. Addresses keep
+ * the order the system resolver returned (RFC 6724 preference), which
+ * is the order the staggered multi-address connect wants to try them
+ * in.
+ */
+class ThreadedNameResolver : public NameResolver {
+ public:
+  /**
+   * Blocking lookups run on the given executor; when none is provided
+   * a small dedicated thread pool is created.
+   */
+  explicit ThreadedNameResolver(
+      std::shared_ptr<folly::Executor> executor = nullptr);
+
+  folly::Future<std::vector<folly::SocketAddress>> resolve(
+      const std::string& hostname,
+      uint16_t port) override;
+
+ private:
+  std::shared_ptr<folly::Executor> executor_;
+};
+
+/**
+ * Caches another resolver's results so reconnect storms hit memory
+ * instead of the resolver.
+ *
+ * Positive results are served from cache for positiveTtl. For a
+ * further staleTtl after that, a lookup still returns the stale
+ * addresses immediately while a single background refresh updates the
+ * entry (stale-while-revalidate), so dials keep completing through a
+ * resolver hiccup. Failures are cached for negativeTtl. Concurrent
+ * lookups for the same hostname:port share one upstream resolution.
+ * getaddrinfo() does not surface record TTLs, so entries age by these
+ * configured times rather than by the DNS TTL.
+ *
+ * Must be owned by a shared_ptr: in-flight lookups keep the cache
+ * alive. getShared() returns the process-wide instance that
+ * ClientBootstrap::connectTo() falls back to.
+ */
+class CachingNameResolver
+    : public NameResolver,
+      public std::enable_shared_from_this<CachingNameResolver> {
+ public:
+  struct Options {
+    std::chrono::seconds positiveTtl{60};
+    std::chrono::seconds negativeTtl{5};
+    std::chrono::seconds staleTtl{300};
+  };
+
+  explicit CachingNameResolver(
+      std::shared_ptr<NameResolver> upstream,
+      Options options = Options());
+
+  static std::shared_ptr<CachingNameResolver> getShared();
+
+  folly::Future<std::vector<folly::SocketAddress>> resolve(
+      const std::string& hostname,
+      uint16_t port) override;
+
+ private:
+  struct CacheEntry {
+    std::vector<folly::SocketAddress> addresses;
+    folly::exception_wrapper error;
+    std::chrono::steady_clock::time_point freshUntil;
+    std::chrono::steady_clock::time_point staleUntil;
+    bool refreshing{false};
+  };
+
+  using ResultPromise = std::shared_ptr<
+      folly::SharedPromise<std::vector<folly::SocketAddress>>>;
+
+  void startLookup(
+      std::string key,
+      const std::string& hostname,
+      uint16_t port,
+      ResultPromise promise);
+  void startRefresh(
+      std::string key,
+      const std::string& hostname,
+      uint16_t port);
+  void store(
+      const std::string& key,
+      const folly::Try<std::vector<folly::SocketAddress>>& result);
+
+  std::shared_ptr<NameResolver> upstream_;
+  Options options_;
+  mutable folly::SharedMutex mutex_;
+  folly::F14FastMap<std::string, CacheEntry> cache_;
+  folly::F14FastMap<std::string, ResultPromise> pending_;
+};
+
+} // namespace wangle
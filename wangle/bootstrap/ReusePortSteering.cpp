@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/bootstrap/ReusePortSteering.h>
+
+#include <glog/logging.h>
+
+#include <folly/net/NetOps.h>
+#include <folly/portability/Sockets.h>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+namespace wangle {
+
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+
+bool attachReusePortSteering(
+    folly::NetworkSocket socket,
+    ReusePortSteering steering,
+    uint32_t numListeners) {
+  if (steering == ReusePortSteering::KERNEL_HASH) {
+#ifdef SO_DETACH_REUSEPORT_BPF
+    int none = 0;
+    folly::netops::setsockopt(
+        socket, SOL_SOCKET, SO_DETACH_REUSEPORT_BPF, &none, sizeof(none));
+#endif
+    return true;
+  }
+  if (numListeners == 0) {
+    return false;
+  }
+
+  // A = flow hash or receiving CPU; return A % numListeners. The
+  // kernel delivers to the group member at the returned index, with
+  // members indexed in the order they joined the group.
+  const auto source = static_cast<uint32_t>(
+      steering == ReusePortSteering::CPU ? SKF_AD_OFF + SKF_AD_CPU
+                                         : SKF_AD_OFF + SKF_AD_RXHASH);
+  struct sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, source),
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, numListeners),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+  };
+  struct sock_fprog prog = {};
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+
+  if (folly::netops::setsockopt(
+          socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) !=
+      0) {
+    PLOG(WARNING) << "Failed to attach reuseport steering program";
+    return false;
+  }
+  return true;
+}
+
+#else
+
+bool attachReusePortSteering(
+    folly::NetworkSocket /* socket */,
+    ReusePortSteering /* steering */,
+    uint32_t /* numListeners */) {
+  return false;
+}
+
+#endif
+
+} // namespace wangle
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <folly/net/NetworkSocket.h>
+
+namespace wangle {
+
+/**
+ * How the kernel picks the listening socket for a new connection or
+ * datagram within a SO_REUSEPORT group (see
+ * ServerBootstrap::setPerThreadListeners()).
+ */
+enum class ReusePortSteering {
+  // The kernel's default reuseport hashing. Adding or removing a
+  // listener re-shuffles which socket a given flow hashes to.
+  KERNEL_HASH,
+  // Steer by the NIC-provided flow hash modulo the listener count.
+  // The same hash drives RSS queue selection, so successive packets
+  // of a flow keep landing on the same listener regardless of the
+  // kernel's per-protocol default - the property per-peer UDP state
+  // relies on - and, with RSS queues pinned alongside the IO threads,
+  // on the CPU that already holds the flow's cache lines.
+  FLOW_HASH,
+  // Steer by the CPU the packet arrived on, modulo the listener
+  // count: listener i receives the traffic of CPU i. Pair with
+  // AffinityThreadFactory pinning worker i to CPU i so a packet is
+  // handled end to end on the core that received it.
+  CPU,
+};
+
+/**
+ * Attaches a classic-BPF steering program (SO_ATTACH_REUSEPORT_CBPF)
+ * to the reuseport group the given socket belongs to. Call once, after
+ * all numListeners sockets have joined the group; the program applies
+ * to the group as a whole. KERNEL_HASH removes a previously attached
+ * program where the kernel supports detaching.
+ *
+ * Works for TCP listeners and bound UDP sockets alike; UDP servers not
+ * going through ServerBootstrap can call this directly on a member fd.
+ *
+ * Returns false when the platform or kernel lacks support (non-Linux,
+ * or kernels before 4.5); the group then keeps the default steering.
+ */
+bool attachReusePortSteering(
+    folly::NetworkSocket socket,
+    ReusePortSteering steering,
+    uint32_t numListeners);
+
+} // namespace wangle
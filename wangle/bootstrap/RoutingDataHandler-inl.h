@@ -24,8 +24,19 @@ RoutingDataHandler<R>::RoutingDataHandler(uint64_t connId, Callback* cob)
 
 template <typename R>
 void RoutingDataHandler<R>::read(Context*, folly::IOBufQueue& q) {
+  if (maxRoutingDataSize_ != 0 && q.chainLength() > maxRoutingDataSize_) {
+    const auto& ex = folly::make_exception_wrapper<folly::AsyncSocketException>(
+        folly::AsyncSocketException::CORRUPTED_DATA,
+        "Buffered routing data exceeded the configured limit");
+    cob_->onError(connId_, ex);
+    return;
+  }
+  if (parseCursor_ > q.chainLength()) {
+    parseCursor_ = q.chainLength();
+  }
   RoutingData routingData;
   if (parseRoutingData(q, routingData)) {
+    parseCursor_ = 0;
     parseRoutingDataCallback(routingData);
   }
 }
@@ -40,6 +40,16 @@ class RoutingDataHandler : public wangle::BytesToBytesHandler {
   RoutingDataHandler(uint64_t connId, Callback* cob);
   ~RoutingDataHandler() override {}
 
+  /**
+   * Cap the number of bytes buffered while waiting for the routing
+   * data to parse. Once the accumulated preamble exceeds the limit,
+   * the connection is rejected through Callback::onError without
+   * calling parseRoutingData again. 0 (the default) is unlimited.
+   */
+  void setMaxRoutingDataSize(uint64_t bytes) {
+    maxRoutingDataSize_ = bytes;
+  }
+
   // BytesToBytesHandler implementation
   void read(Context* ctx, folly::IOBufQueue& q) override;
   void readEOF(Context* ctx) override;
@@ -72,9 +82,28 @@ class RoutingDataHandler : public wangle::BytesToBytesHandler {
    */
   void parseRoutingDataCallback(RoutingData& routingData);
 
+  /**
+   * Resumable-parse cursor for parseRoutingData implementations.
+   * Handlers that scan the queue for a delimiter can record how many
+   * leading bytes they have already inspected and skip them on the
+   * next read event, instead of re-scanning from offset zero every
+   * time a slow client trickles in another byte. The cursor is clamped
+   * to the buffered length before each parse and reset to zero once
+   * routing data has been parsed.
+   */
+  uint64_t parseCursor() const {
+    return parseCursor_;
+  }
+
+  void setParseCursor(uint64_t cursor) {
+    parseCursor_ = cursor;
+  }
+
  private:
   uint64_t connId_;
   Callback* cob_{nullptr};
+  uint64_t maxRoutingDataSize_{0};
+  uint64_t parseCursor_{0};
 };
 
 template <typename R>
@@ -18,19 +18,38 @@
 
 #include <folly/ExceptionWrapper.h>
 #include <folly/SharedMutex.h>
+#include <folly/container/F14Map.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/io/async/DelayedDestruction.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <wangle/acceptor/Acceptor.h>
 #include <wangle/acceptor/ManagedConnection.h>
 #include <wangle/acceptor/SharedSSLContextManager.h>
+#include <wangle/acceptor/SocketPeeker.h>
 #include <wangle/bootstrap/ServerSocketFactory.h>
+#include <wangle/bootstrap/WorkerPlacementPolicy.h>
 #include <wangle/channel/Handler.h>
 #include <wangle/channel/Pipeline.h>
 #include <wangle/ssl/SSLStats.h>
 
 namespace wangle {
 
+namespace bootstrap_detail {
+
+// True when the pipeline's inbound type is IOBufQueue& — the shape
+// per-peer UDP datagram payloads are delivered in. Gates the per-peer
+// UDP code so acceptors for other pipeline types still compile.
+template <class P, class = void>
+struct PipelineReadsIOBufQueue : std::false_type {};
+
+template <class P>
+struct PipelineReadsIOBufQueue<
+    P,
+    std::void_t<decltype(std::declval<P&>().read(
+        std::declval<folly::IOBufQueue&>()))>> : std::true_type {};
+
+} // namespace bootstrap_detail
+
 class AcceptorException : public std::runtime_error {
  public:
   enum class ExceptionType {
@@ -113,6 +132,15 @@ class ServerAcceptor : public Acceptor,
           AcceptorException::ExceptionType::DROPPED, "dropped");
       pipeline_->readException(ew);
     }
+
+    void dropConnectionHard() override {
+      // Emergency teardown: skip the readException walk through the
+      // handlers and release the pipeline directly.  Handlers, contexts
+      // and the transport go down with the pipeline's destructor, with
+      // no close notification to the peer beyond the socket closing.
+      destroy();
+    }
+
     void dumpConnectionState(uint8_t /* loglevel */) override {}
 
     void deletePipeline(wangle::PipelineBase* p) override {
@@ -132,6 +160,28 @@ class ServerAcceptor : public Acceptor,
       enableNotifyPendingShutdown_ = isEnabled;
     }
 
+    /**
+     * Move this connection to the target acceptor's EventBase: reads
+     * are quiesced, the transport and the connection manager
+     * registration move, and the pipeline resumes on the target loop.
+     * Must be called on the current EventBase; returns false (leaving
+     * the connection untouched) when the transport has writes in
+     * flight.
+     */
+    bool migrateTo(Acceptor* target) {
+      if (!pipeline_->migrateTo(target->getEventBase())) {
+        return false;
+      }
+      if (auto* cm = getConnectionManager()) {
+        cm->removeConnection(this);
+      }
+      // Enqueued after the transport's re-attach, so the target's
+      // manager only sees the connection once it lives on that loop.
+      target->getEventBase()->runInEventBaseThread(
+          [this, target] { target->addConnection(this); });
+      return true;
+    }
+
    private:
     ~ServerConnection() override {
       pipeline_->setPipelineManager(nullptr);
@@ -140,6 +190,166 @@ class ServerAcceptor : public Acceptor,
     bool enableNotifyPendingShutdown_{false};
   };
 
+  /**
+   * An accepted socket that has not yet sent a byte. Port scans, load
+   * balancer health probes and speculative preconnects close without
+   * writing anything; holding them here — one MSG_PEEK readability
+   * watch plus the connection manager's idle timeout — means the child
+   * pipeline and its handlers are never built for that population. The
+   * first byte (peeked, left in the kernel buffer for the real read
+   * path) materializes the pipeline.
+   */
+  class PendingConnection : public wangle::ManagedConnection,
+                            private SocketPeeker::Callback {
+   public:
+    PendingConnection(
+        ServerAcceptor* acceptor,
+        folly::AsyncTransport::UniquePtr transport,
+        std::shared_ptr<TransportInfo> tinfo)
+        : acceptor_(acceptor),
+          transport_(std::move(transport)),
+          tinfo_(std::move(tinfo)) {}
+
+    void start() {
+      auto* socket = transport_->getUnderlyingTransport<folly::AsyncSocket>();
+      peeker_.reset(new SocketPeeker(*socket, this, 1));
+      peeker_->start();
+    }
+
+    void peekSuccess(folly::ByteRange) noexcept override {
+      folly::DelayedDestruction::DestructorGuard dg(this);
+      peeker_.reset();
+      acceptor_->materializeConnection(
+          std::move(transport_), std::move(tinfo_));
+      destroy();
+    }
+
+    void peekError(const folly::AsyncSocketException&) noexcept override {
+      drop();
+    }
+
+    void timeoutExpired() noexcept override {
+      // Idle before the first byte: reaped without a pipeline ever
+      // having been built.
+      drop();
+    }
+
+    void describe(std::ostream&) const override {}
+    bool isBusy() const override {
+      return false;
+    }
+    void notifyPendingShutdown() override {}
+    void closeWhenIdle() override {
+      drop();
+    }
+    void dropConnection(const std::string& /* errorMsg */ = "") override {
+      drop();
+    }
+    void dumpConnectionState(uint8_t /* loglevel */) override {}
+
+   private:
+    ~PendingConnection() override = default;
+
+    void drop() noexcept {
+      folly::DelayedDestruction::DestructorGuard dg(this);
+      peeker_.reset();
+      transport_->closeNow();
+      destroy();
+    }
+
+    ServerAcceptor* acceptor_;
+    folly::AsyncTransport::UniquePtr transport_;
+    std::shared_ptr<TransportInfo> tinfo_;
+    SocketPeeker::UniquePtr peeker_;
+  };
+
+  /**
+   * A managed per-peer UDP "connection": the pipeline a child factory
+   * returned for one datagram source. Lives in the acceptor's peer table
+   * and in the regular ConnectionManager, whose idle timeout (refreshed
+   * on every datagram) expires quiet peers.
+   */
+  class UdpServerConnection : public wangle::ManagedConnection,
+                              public wangle::PipelineManager {
+   public:
+    UdpServerConnection(
+        ServerAcceptor* acceptor,
+        folly::SocketAddress peer,
+        typename Pipeline::Ptr pipeline)
+        : acceptor_(acceptor),
+          peer_(std::move(peer)),
+          pipeline_(std::move(pipeline)) {
+      pipeline_->setPipelineManager(this);
+    }
+
+    void init() {
+      pipeline_->transportActive();
+    }
+
+    void onDatagram(std::unique_ptr<folly::IOBuf> buf) {
+      resetTimeout();
+      if constexpr (bootstrap_detail::PipelineReadsIOBufQueue<
+                        Pipeline>::value) {
+        queue_.append(std::move(buf));
+        pipeline_->read(queue_);
+      }
+    }
+
+    // Called when the acceptor is destroyed before the connection
+    // manager tears us down, so the destructor doesn't reach back into
+    // the already-destroyed peer table.
+    void detachFromAcceptor() {
+      acceptor_ = nullptr;
+    }
+
+    void timeoutExpired() noexcept override {
+      folly::DelayedDestruction::DestructorGuard dg(this);
+      auto ew = folly::make_exception_wrapper<AcceptorException>(
+          AcceptorException::ExceptionType::TIMED_OUT, "timeout");
+      pipeline_->readException(ew);
+      destroy();
+    }
+
+    void describe(std::ostream&) const override {}
+    bool isBusy() const override {
+      return false;
+    }
+    void notifyPendingShutdown() override {}
+    void closeWhenIdle() override {
+      destroy();
+    }
+    void dropConnection(const std::string& /* errorMsg */ = "") override {
+      folly::DelayedDestruction::DestructorGuard dg(this);
+      auto ew = folly::make_exception_wrapper<AcceptorException>(
+          AcceptorException::ExceptionType::DROPPED, "dropped");
+      pipeline_->readException(ew);
+      destroy();
+    }
+    void dumpConnectionState(uint8_t /* loglevel */) override {}
+
+    void deletePipeline(wangle::PipelineBase* p) override {
+      CHECK(p == pipeline_.get());
+      destroy();
+    }
+
+    void refreshTimeout() override {
+      resetTimeout();
+    }
+
+   private:
+    ~UdpServerConnection() override {
+      if (acceptor_) {
+        acceptor_->udpPeers_.erase(peer_);
+      }
+      pipeline_->setPipelineManager(nullptr);
+    }
+
+    ServerAcceptor* acceptor_;
+    folly::SocketAddress peer_;
+    typename Pipeline::Ptr pipeline_;
+    folly::IOBufQueue queue_{folly::IOBufQueue::cacheChainLength()};
+  };
+
   explicit ServerAcceptor(
       std::shared_ptr<AcceptPipelineFactory> acceptPipelineFactory,
       std::shared_ptr<PipelineFactory<Pipeline>> childPipelineFactory,
@@ -148,6 +358,18 @@ class ServerAcceptor : public Acceptor,
         acceptPipelineFactory_(acceptPipelineFactory),
         childPipelineFactory_(childPipelineFactory) {}
 
+  ~ServerAcceptor() override {
+    // Peer connections are reaped by the connection manager, a base class
+    // member destroyed after our own members.
+    for (auto& peer : udpPeers_) {
+      peer.second->detachFromAcceptor();
+    }
+    // Free any datagrams batched but never flushed
+    for (auto& pkt : udpBatch_) {
+      delete pkt.buf;
+    }
+  }
+
   void init(
       folly::AsyncServerSocket* serverSocket,
       folly::EventBase* eventBase,
@@ -176,11 +398,13 @@ class ServerAcceptor : public Acceptor,
       return;
     }
 
-    auto connInfo = boost::get<ConnInfo&>(conn);
+    auto connInfo = conn.get<ConnInfo&>();
     folly::AsyncTransport::UniquePtr transport(connInfo.sock);
 
-    // Setup local and remote addresses
-    auto tInfoPtr = std::make_shared<TransportInfo>(connInfo.tinfo);
+    // Setup local and remote addresses.  The accept path's TransportInfo
+    // dies when this read returns, so move it rather than copying ~50
+    // fields (several of them strings) per accepted connection.
+    auto tInfoPtr = std::make_shared<TransportInfo>(std::move(connInfo.tinfo));
     tInfoPtr->localAddr =
         std::make_shared<folly::SocketAddress>(accConfig_.bindAddress);
     transport->getLocalAddress(tInfoPtr->localAddr.get());
@@ -189,14 +413,30 @@ class ServerAcceptor : public Acceptor,
     tInfoPtr->appProtocol =
         std::make_shared<std::string>(connInfo.nextProtoName);
 
-    auto pipeline = childPipelineFactory_->newPipeline(
-        std::shared_ptr<folly::AsyncTransport>(
-            transport.release(), folly::DelayedDestruction::Destructor()));
-    pipeline->setTransportInfo(tInfoPtr);
-    auto connection = new ServerConnection(std::move(pipeline));
-    connection->setNotifyPendingShutdown(enableNotifyPendingShutdown_);
-    Acceptor::addConnection(connection);
-    connection->init();
+    if (lazyChildPipeline_ &&
+        connInfo.secureTransportType == SecureTransportType::NONE &&
+        transport->getUnderlyingTransport<folly::AsyncSocket>()) {
+      auto pending = new PendingConnection(
+          this, std::move(transport), std::move(tInfoPtr));
+      Acceptor::addConnection(pending);
+      pending->start();
+      return;
+    }
+
+    materializeConnection(std::move(transport), std::move(tInfoPtr));
+  }
+
+  /**
+   * Defers child pipeline construction until a connection's first
+   * readable byte; until then the socket is held by a PendingConnection
+   * only. Only plaintext connections take the lazy path: a negotiated
+   * transport can hold decrypted bytes above the socket where MSG_PEEK
+   * cannot see them, and with TLS the dead-connection population
+   * already dies in the handshake path without a child pipeline. Off by
+   * default.
+   */
+  void setLazyChildPipeline(bool enabled) {
+    lazyChildPipeline_ = enabled;
   }
 
   // Null implementation to terminate the call in this handler
@@ -210,7 +450,7 @@ class ServerAcceptor : public Acceptor,
       const folly::SocketAddress* clientAddr,
       const std::string& nextProtocolName,
       SecureTransportType secureTransportType,
-      const TransportInfo& tinfo) override {
+      TransportInfo& tinfo) override {
     ConnInfo connInfo = {
         transport.release(),
         clientAddr,
@@ -264,9 +504,95 @@ class ServerAcceptor : public Acceptor,
       const folly::SocketAddress& addr,
       std::unique_ptr<folly::IOBuf> buf,
       bool /* truncated */,
-      OnDataAvailableParams /* params */) noexcept override {
-    acceptPipeline_->read(
-        AcceptPipelineType(make_tuple(buf.release(), socket, addr)));
+      OnDataAvailableParams params) noexcept override {
+    if (accConfig_.udpGro && !udpGroRequested_) {
+      // The first datagram is the earliest point this acceptor sees the
+      // socket; enabling GRO here covers the rest of the socket's life.
+      udpGroRequested_ = true;
+      socket->setGRO(true);
+    }
+    udpReadStats_.reads++;
+    if (params.gro > 0) {
+      udpReadStats_.groReads++;
+    }
+
+    // Per-peer mode: a child factory that implements the UDP overload of
+    // newPipeline gets one cached pipeline per datagram source, and each
+    // datagram costs one hash probe. Factories that return nullptr (the
+    // default) keep the accept-pipeline routing below.
+    if constexpr (bootstrap_detail::PipelineReadsIOBufQueue<Pipeline>::value) {
+      if (childPipelineFactory_ && !udpPerPeerDisabled_ &&
+          routeDatagramToPeer(socket, addr, buf)) {
+        return;
+      }
+    }
+
+    const auto batchSize = accConfig_.udpBatchSize;
+    if (batchSize <= 1) {
+      acceptPipeline_->read(
+          AcceptPipelineType(make_tuple(buf.release(), socket, addr)));
+      return;
+    }
+
+    // Coalesce datagrams arriving within one event loop iteration into a
+    // single accept pipeline traversal.
+    if (udpBatch_.empty()) {
+      udpBatch_.reserve(batchSize);
+      udpBatchSocket_ = std::move(socket);
+      base_->runInLoop(&udpBatchFlusher_, true /* thisIteration */);
+    }
+    udpBatch_.push_back(
+        AcceptPipelineType::UdpPacket{buf.release(), addr, params});
+    if (udpBatch_.size() >= batchSize) {
+      flushUdpBatch();
+    }
+  }
+
+  size_t migrateConnectionsTo(
+      Acceptor* target,
+      size_t maxConns,
+      std::chrono::milliseconds minIdle) override {
+    auto* cm = getConnectionManager();
+    if (!cm || !target || target == this || maxConns == 0) {
+      return 0;
+    }
+    // Collect candidates first; migration mutates the manager's list.
+    std::vector<ServerConnection*> candidates;
+    cm->forEachConnection([&](ManagedConnection* conn) {
+      if (candidates.size() >= maxConns) {
+        return;
+      }
+      // A connection with no recorded activity is treated as idle.
+      auto idle = conn->getLastActivityElapsedTime();
+      if (idle && *idle < minIdle) {
+        return;
+      }
+      if (auto* serverConn = dynamic_cast<ServerConnection*>(conn)) {
+        candidates.push_back(serverConn);
+      }
+    });
+    size_t migrated = 0;
+    for (auto* conn : candidates) {
+      if (conn->migrateTo(target)) {
+        migrated++;
+      }
+    }
+    return migrated;
+  }
+
+  /**
+   * Read-side segmentation counters: the ratio of groReads to reads
+   * tells how often the kernel handed up GRO-coalesced buffers, i.e.
+   * how many recvmsg calls the offload saved.
+   */
+  struct UdpReadStats {
+    uint64_t reads{0};
+    /** Reads that arrived GRO-coalesced (params.gro > 0) */
+    uint64_t groReads{0};
+  };
+
+  const UdpReadStats& getUdpReadStats() const {
+    return udpReadStats_;
   }
 
   void onConnectionAdded(const ManagedConnection*) override {
@@ -287,8 +613,81 @@ class ServerAcceptor : public Acceptor,
   bool enableNotifyPendingShutdown_{false};
 
  private:
+  class UdpBatchFlusher : public folly::EventBase::LoopCallback {
+   public:
+    explicit UdpBatchFlusher(ServerAcceptor* acceptor) : acceptor_(acceptor) {}
+
+    void runLoopCallback() noexcept override {
+      acceptor_->flushUdpBatch();
+    }
+
+   private:
+    ServerAcceptor* acceptor_;
+  };
+
+  void materializeConnection(
+      folly::AsyncTransport::UniquePtr transport,
+      std::shared_ptr<TransportInfo> tinfo) {
+    auto pipeline = childPipelineFactory_->newPipeline(
+        std::shared_ptr<folly::AsyncTransport>(
+            transport.release(), folly::DelayedDestruction::Destructor()));
+    pipeline->setTransportInfo(std::move(tinfo));
+    auto connection = new ServerConnection(std::move(pipeline));
+    connection->setNotifyPendingShutdown(enableNotifyPendingShutdown_);
+    Acceptor::addConnection(connection);
+    connection->init();
+  }
+
+  // Returns false (leaving buf intact) when the factory declines per-peer
+  // handling, which is then remembered so later datagrams skip the probe.
+  bool routeDatagramToPeer(
+      const std::shared_ptr<folly::AsyncUDPSocket>& socket,
+      const folly::SocketAddress& addr,
+      std::unique_ptr<folly::IOBuf>& buf) {
+    auto it = udpPeers_.find(addr);
+    if (it == udpPeers_.end()) {
+      auto pipeline = childPipelineFactory_->newPipeline(socket, addr);
+      if (!pipeline) {
+        udpPerPeerDisabled_ = true;
+        return false;
+      }
+      auto* connection =
+          new UdpServerConnection(this, addr, std::move(pipeline));
+      Acceptor::addConnection(connection);
+      it = udpPeers_.emplace(addr, connection).first;
+      connection->init();
+    }
+    it->second->onDatagram(std::move(buf));
+    return true;
+  }
+
+  void flushUdpBatch() noexcept {
+    if (udpBatch_.empty()) {
+      return;
+    }
+    // No-op when invoked from the loop callback itself
+    udpBatchFlusher_.cancelLoopCallback();
+    auto batch = std::move(udpBatch_);
+    udpBatch_.clear();
+    acceptPipeline_->read(AcceptPipelineType(
+        std::make_tuple(std::move(batch), std::move(udpBatchSocket_))));
+  }
+
   std::shared_ptr<AcceptPipelineFactory> acceptPipelineFactory_;
   std::shared_ptr<PipelineFactory<Pipeline>> childPipelineFactory_;
+  bool lazyChildPipeline_{false};
+
+  std::vector<AcceptPipelineType::UdpPacket> udpBatch_;
+  std::shared_ptr<folly::AsyncUDPSocket> udpBatchSocket_;
+  UdpBatchFlusher udpBatchFlusher_{this};
+
+  // Keyed by peer address; the local socket pins the rest of the 5-tuple.
+  // One acceptor per EventBase, so the table is single-threaded.
+  folly::F14FastMap<folly::SocketAddress, UdpServerConnection*> udpPeers_;
+  bool udpPerPeerDisabled_{false};
+
+  UdpReadStats udpReadStats_;
+  bool udpGroRequested_{false};
 };
 
 template <typename Pipeline>
@@ -361,6 +760,39 @@ class ServerWorkerPool : public folly::ThreadPoolExecutor::Observer {
   template <typename F>
   void forRandomWorker(F&& f) const;
 
+  /**
+   * Invokes f on the worker chosen by the placement policy, handing the
+   * policy a load sample per worker; see WorkerPlacementPolicy.
+   */
+  template <typename F>
+  void forPlacedWorker(F&& f) const;
+
+  /**
+   * Replaces the placement policy consulted by forPlacedWorker. The
+   * default is RandomWorkerPlacementPolicy, the historical behavior.
+   */
+  void setWorkerPlacementPolicy(std::shared_ptr<WorkerPlacementPolicy> policy);
+
+  /**
+   * Per-worker load gauges: active connections, loop lag, and the rate
+   * of pool placements over the window since the previous call (zero on
+   * the first call). Sampled without touching the worker loops.
+   */
+  std::vector<WorkerLoad> getWorkerLoads();
+
+  /**
+   * One connection-rebalancing pass: compares loop lag
+   * (EventBase::getAvgLoopTime) across workers and, when the busiest
+   * loop lags the least busy one by more than 2x, migrates up to
+   * maxMigrations connections idle for at least minIdle from the former
+   * to the latter. Returns the number migrated. Safe to call
+   * periodically from any thread; a pass that finds the loops balanced
+   * migrates nothing.
+   */
+  size_t rebalanceConnections(
+      size_t maxMigrations,
+      std::chrono::milliseconds minIdle);
+
   void threadStarted(folly::ThreadPoolExecutor::ThreadHandle*) override;
   void threadStopped(folly::ThreadPoolExecutor::ThreadHandle*) override;
   void threadPreviouslyStarted(
@@ -373,13 +805,29 @@ class ServerWorkerPool : public folly::ThreadPoolExecutor::Observer {
   }
 
  private:
-  using WorkerMap = std::vector<std::pair<
-      folly::ThreadPoolExecutor::ThreadHandle*,
-      std::shared_ptr<Acceptor>>>;
+  struct WorkerEntry {
+    folly::ThreadPoolExecutor::ThreadHandle* thread{nullptr};
+    std::shared_ptr<Acceptor> acceptor;
+    // Placements routed to this worker; bumped under the read lock, so
+    // atomic. Heap-allocated to keep the entry movable.
+    std::shared_ptr<std::atomic<uint64_t>> placed{
+        std::make_shared<std::atomic<uint64_t>>(0)};
+    // placed as of the previous getWorkerLoads() call; only touched
+    // under the write lock.
+    uint64_t lastPlaced{0};
+  };
+  using WorkerMap = std::vector<WorkerEntry>;
   using Mutex = folly::SharedMutexReadPriority;
 
+  // Under workersMutex_; sample a worker's load without touching its
+  // loop.
+  static WorkerLoad sampleWorkerLoad(const WorkerEntry& entry);
+
   std::shared_ptr<WorkerMap> workers_;
   std::shared_ptr<Mutex> workersMutex_;
+  std::shared_ptr<WorkerPlacementPolicy> placementPolicy_{
+      std::make_shared<RandomWorkerPlacementPolicy>()};
+  std::chrono::steady_clock::time_point lastLoadSnapshot_;
   std::shared_ptr<AcceptorFactory> acceptorFactory_;
   folly::IOThreadPoolExecutor* exec_{nullptr};
   std::shared_ptr<std::vector<std::shared_ptr<folly::AsyncSocketBase>>>
@@ -390,8 +838,8 @@ class ServerWorkerPool : public folly::ThreadPoolExecutor::Observer {
 template <typename F>
 void ServerWorkerPool::forEachWorker(F&& f) const {
   Mutex::ReadHolder holder(workersMutex_.get());
-  for (const auto& kv : *workers_) {
-    f(kv.second.get());
+  for (const auto& entry : *workers_) {
+    f(entry.acceptor.get());
   }
 }
 
@@ -399,7 +847,22 @@ template <typename F>
 void ServerWorkerPool::forRandomWorker(F&& f) const {
   Mutex::ReadHolder holder(workersMutex_.get());
   DCHECK(workers_->size());
-  f((*workers_)[folly::Random::rand32(workers_->size())].second.get());
+  f((*workers_)[folly::Random::rand32(workers_->size())].acceptor.get());
+}
+
+template <typename F>
+void ServerWorkerPool::forPlacedWorker(F&& f) const {
+  Mutex::ReadHolder holder(workersMutex_.get());
+  DCHECK(workers_->size());
+  std::vector<WorkerLoad> loads;
+  loads.reserve(workers_->size());
+  for (const auto& entry : *workers_) {
+    loads.push_back(sampleWorkerLoad(entry));
+  }
+  auto index = placementPolicy_->pickWorker(loads) % workers_->size();
+  const auto& chosen = (*workers_)[index];
+  chosen.placed->fetch_add(1, std::memory_order_relaxed);
+  f(chosen.acceptor.get());
 }
 
 class DefaultAcceptPipelineFactory : public AcceptPipelineFactory {
@@ -26,7 +26,10 @@ void ServerWorkerPool::threadStarted(
   auto worker = acceptorFactory_->newAcceptor(exec_->getEventBase(h));
   {
     Mutex::WriteHolder holder(workersMutex_.get());
-    workers_->push_back({h, worker});
+    WorkerEntry entry;
+    entry.thread = h;
+    entry.acceptor = worker;
+    workers_->push_back(std::move(entry));
   }
 
   for (auto socket : *sockets_) {
@@ -38,15 +41,100 @@ void ServerWorkerPool::threadStarted(
   }
 }
 
+size_t ServerWorkerPool::rebalanceConnections(
+    size_t maxMigrations,
+    std::chrono::milliseconds minIdle) {
+  // A busiest loop lagging the calmest by less than this is considered
+  // balanced; migrating connections around inside the noise band would
+  // just churn them between loops.
+  constexpr double kLagRatio = 2.0;
+
+  std::shared_ptr<Acceptor> busiest;
+  std::shared_ptr<Acceptor> calmest;
+  double busiestLag = 0;
+  double calmestLag = 0;
+  {
+    Mutex::ReadHolder holder(workersMutex_.get());
+    for (const auto& entry : *workers_) {
+      const auto& acceptor = entry.acceptor;
+      auto* evb = acceptor->getEventBase();
+      if (!evb) {
+        continue;
+      }
+      const double lag = evb->getAvgLoopTime();
+      if (!busiest || lag > busiestLag) {
+        busiest = acceptor;
+        busiestLag = lag;
+      }
+      if (!calmest || lag < calmestLag) {
+        calmest = acceptor;
+        calmestLag = lag;
+      }
+    }
+  }
+  if (!busiest || busiest == calmest || busiestLag < kLagRatio * calmestLag) {
+    return 0;
+  }
+
+  size_t migrated = 0;
+  busiest->getEventBase()->runImmediatelyOrRunInEventBaseThreadAndWait([&] {
+    migrated =
+        busiest->migrateConnectionsTo(calmest.get(), maxMigrations, minIdle);
+  });
+  return migrated;
+}
+
+WorkerLoad ServerWorkerPool::sampleWorkerLoad(const WorkerEntry& entry) {
+  WorkerLoad load;
+  load.activeConnections = entry.acceptor->getNumConnections();
+  load.placedConnections = entry.placed->load(std::memory_order_relaxed);
+  if (auto* evb = entry.acceptor->getEventBase()) {
+    load.avgLoopTime = std::chrono::microseconds(
+        static_cast<int64_t>(evb->getAvgLoopTime()));
+  }
+  return load;
+}
+
+void ServerWorkerPool::setWorkerPlacementPolicy(
+    std::shared_ptr<WorkerPlacementPolicy> policy) {
+  CHECK(policy);
+  Mutex::WriteHolder holder(workersMutex_.get());
+  placementPolicy_ = std::move(policy);
+}
+
+std::vector<WorkerLoad> ServerWorkerPool::getWorkerLoads() {
+  Mutex::WriteHolder holder(workersMutex_.get());
+  auto now = std::chrono::steady_clock::now();
+  const double windowSec =
+      std::chrono::duration<double>(now - lastLoadSnapshot_).count();
+  const bool haveWindow =
+      lastLoadSnapshot_ != std::chrono::steady_clock::time_point() &&
+      windowSec > 0;
+
+  std::vector<WorkerLoad> loads;
+  loads.reserve(workers_->size());
+  for (auto& entry : *workers_) {
+    auto load = sampleWorkerLoad(entry);
+    if (haveWindow) {
+      load.acceptRate =
+          double(load.placedConnections - entry.lastPlaced) / windowSec;
+    }
+    entry.lastPlaced = load.placedConnections;
+    loads.push_back(load);
+  }
+  lastLoadSnapshot_ = now;
+  return loads;
+}
+
 void ServerWorkerPool::threadStopped(
     folly::ThreadPoolExecutor::ThreadHandle* h) {
   auto worker = [&]() -> std::shared_ptr<Acceptor> {
     Mutex::WriteHolder holder(workersMutex_.get());
     for (auto it = workers_->begin(); it != workers_->end(); ++it) {
-      if (it->first != h) {
+      if (it->thread != h) {
         continue;
       }
-      auto acceptor = std::move(it->second);
+      auto acceptor = std::move(it->acceptor);
       workers_->erase(it);
       return acceptor;
     }
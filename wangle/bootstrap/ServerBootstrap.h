@@ -16,11 +16,17 @@
 
 #pragma once
 
+#include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/synchronization/Baton.h>
+#include <wangle/bootstrap/AffinityThreadFactory.h>
+#include <wangle/bootstrap/ListenerFdHandoff.h>
+#include <wangle/bootstrap/ReusePortSteering.h>
 #include <wangle/bootstrap/ServerBootstrap-inl.h>
 #include <wangle/channel/Pipeline.h>
+#include <wangle/channel/ReadBufferPool.h>
 #include <iostream>
+#include <mutex>
 #include <thread>
 
 namespace wangle {
@@ -95,6 +101,78 @@ class ServerBootstrap {
     return this;
   }
 
+  /*
+   * Placement policy for the default IO thread pool created by group()
+   * when no io executor is passed in.  Pinning avoids cross-core thread
+   * migration (cold caches, remote-node memory) under load; per-node
+   * partitioning keeps each IO thread's working set on one NUMA node
+   * while still letting the scheduler balance within the node.
+   */
+  enum class IOThreadPlacement {
+    // Leave thread placement to the scheduler (default)
+    NONE,
+    // Pin each IO thread to its own core
+    PIN_PER_CORE,
+    // Confine each IO thread to the CPUs of one NUMA node, spreading the
+    // threads round-robin across nodes.  Falls back to NONE on machines
+    // without exposed NUMA topology.
+    PARTITION_PER_NUMA_NODE,
+  };
+
+  /*
+   * Set the placement policy for the default IO thread pool.  Only
+   * affects the pool group() creates; callers passing their own io
+   * executor control placement through its thread factory (see
+   * AffinityThreadFactory).  Must be called before group()/bind().
+   */
+  ServerBootstrap* setIOThreadPlacement(IOThreadPlacement placement) {
+    ioThreadPlacement_ = placement;
+    return this;
+  }
+
+  /*
+   * Back each IO thread's read buffer pool with 2MB hugepage slabs,
+   * reserving (and pre-faulting) the given bytes per thread at group()
+   * time.  Sequential codec scans over freshly 4KB-page-backed buffers
+   * are dTLB-bound at bulk-transfer rates; hugepage slabs cover the
+   * same memory with a few TLB entries.  Handlers opt in per connection
+   * via AsyncSocketHandler::setReadBufferPool(
+   * ReadBufferPool::getThreadLocal()).  Must be called before
+   * group()/bind(); falls back to plain allocation where hugepages are
+   * unavailable.
+   */
+  ServerBootstrap* setHugePageReadBuffers(size_t reserveBytesPerThread) {
+    hugePageReadBufferBytes_ = reserveBytesPerThread;
+    return this;
+  }
+
+  /*
+   * Set the policy that picks the IO worker each directly accepted
+   * connection is placed on, and whose load samples getWorkerLoads()
+   * exports.  Defaults to random placement; see WorkerPlacementPolicy
+   * for least-connections and least-lag alternatives.
+   */
+  ServerBootstrap* workerPlacementPolicy(
+      std::shared_ptr<WorkerPlacementPolicy> policy) {
+    placementPolicy_ = policy;
+    if (workerFactory_) {
+      workerFactory_->setWorkerPlacementPolicy(std::move(policy));
+    }
+    return this;
+  }
+
+  /*
+   * Per-worker load gauges (active connections, placement rate, loop
+   * lag), sampled without touching the worker loops.  Empty before
+   * group()/bind().
+   */
+  std::vector<WorkerLoad> getWorkerLoads() {
+    if (!workerFactory_) {
+      return {};
+    }
+    return workerFactory_->getWorkerLoads();
+  }
+
   /*
    * Set the IO executor.  If not set, a default one will be created
    * with one thread per core.
@@ -129,7 +207,7 @@ class ServerBootstrap {
         threads = 8;
       }
       io_group = std::make_shared<folly::IOThreadPoolExecutor>(
-          threads, std::make_shared<folly::NamedThreadFactory>("IO Thread"));
+          threads, makeIOThreadFactory());
     }
 
     // TODO better config checking
@@ -148,8 +226,22 @@ class ServerBootstrap {
           acceptorFactory, io_group.get(), sockets_, socketFactory_);
     }
 
+    if (placementPolicy_) {
+      workerFactory_->setWorkerPlacementPolicy(placementPolicy_);
+    }
+
     io_group->addObserver(workerFactory_);
 
+    if (hugePageReadBufferBytes_ > 0) {
+      ReadBufferPool::setThreadLocalOptions(
+          {true /* hugePageSlabs */, hugePageReadBufferBytes_});
+      // Construct each IO thread's pool now so the slabs are faulted
+      // in before the first connection lands on it.
+      for (auto& evb : io_group->getAllEventBases()) {
+        evb->runInEventBaseThread([] { ReadBufferPool::getThreadLocal(); });
+      }
+    }
+
     acceptor_group_ = accept_group;
     io_group_ = io_group;
 
@@ -217,6 +309,11 @@ class ServerBootstrap {
       group(nullptr);
     }
 
+    if (perThreadListeners_) {
+      bindPerThreadListeners(address);
+      return;
+    }
+
     bool reusePort = reusePort_ || (acceptor_group_->numThreads() > 1) ||
         accConfig_.reusePort;
 
@@ -225,31 +322,46 @@ class ServerBootstrap {
 
     std::exception_ptr exn;
 
-    auto startupFunc = [&](std::shared_ptr<folly::Baton<>> barrier) {
+    auto startupFunc = [&](std::shared_ptr<folly::Baton<>> barrier,
+                           bool recordAddress) {
       try {
         auto socket = socketFactory_->newSocket(
             address, socketConfig.acceptBacklog, reusePort, socketConfig);
         sock_lock.lock();
         new_sockets.push_back(socket);
         sock_lock.unlock();
-        socket->getAddress(&address);
+        if (recordAddress) {
+          socket->getAddress(&address);
+        }
 
         barrier->post();
       } catch (...) {
-        exn = std::current_exception();
+        sock_lock.lock();
+        if (!exn) {
+          exn = std::current_exception();
+        }
+        sock_lock.unlock();
         barrier->post();
 
         return;
       }
     };
 
+    // The first bind runs alone so it can claim an ephemeral port.
     auto wait0 = std::make_shared<folly::Baton<>>();
-    acceptor_group_->add(std::bind(startupFunc, wait0));
+    acceptor_group_->add(std::bind(startupFunc, wait0, true));
     wait0->wait();
 
+    // The remaining reuse-port binds all target the now-concrete
+    // address, so they dispatch concurrently and are awaited as a
+    // group instead of one blocking round trip per socket.
+    std::vector<std::shared_ptr<folly::Baton<>>> barriers;
     for (size_t i = 1; i < acceptor_group_->numThreads(); i++) {
       auto barrier = std::make_shared<folly::Baton<>>();
-      acceptor_group_->add(std::bind(startupFunc, barrier));
+      barriers.push_back(barrier);
+      acceptor_group_->add(std::bind(startupFunc, barrier, false));
+    }
+    for (auto& barrier : barriers) {
       barrier->wait();
     }
 
@@ -257,18 +369,101 @@ class ServerBootstrap {
       std::rethrow_exception(exn);
     }
 
-    for (auto& socket : new_sockets) {
-      // Startup all the threads
-      workerFactory_->forEachWorker([this, socket](Acceptor* worker) {
+    attachWorkersToSockets(new_sockets);
+  }
+
+  /*
+   * Zero-downtime restart, predecessor side: offer this server's
+   * listening fds to a successor process over a unix domain socket at
+   * handoffPath (SCM_RIGHTS).  Blocks until the successor holds the
+   * fds or the timeout elapses; returns whether the handoff happened.
+   * This process keeps accepting until stop() and the successor
+   * starts accepting on the very same sockets as soon as it adopts
+   * them, so no connection is refused across the restart.
+   * Established connections stay with this process; drain them
+   * afterwards with stop() or forceStopWithin().
+   */
+  bool exportListeningFds(
+      const std::string& handoffPath,
+      std::chrono::milliseconds timeout = std::chrono::seconds(30)) {
+    std::vector<folly::NetworkSocket> fds;
+    if (sockets_) {
+      for (auto& sock : *sockets_) {
+        auto socket =
+            std::dynamic_pointer_cast<folly::AsyncServerSocket>(sock);
+        if (!socket) {
+          continue; // only TCP listeners are handed off
+        }
         socket->getEventBase()->runImmediatelyOrRunInEventBaseThreadAndWait(
-            [this, worker, socket]() {
-              socketFactory_->addAcceptCB(
-                  socket, worker, worker->getEventBase());
+            [&] {
+              for (auto fd : socket->getNetworkSockets()) {
+                fds.push_back(fd);
+              }
             });
-      });
+      }
+    }
+    if (fds.empty()) {
+      return false;
+    }
+    return serveListeningFdHandoff(handoffPath, fds, timeout);
+  }
 
-      sockets_->push_back(socket);
+  /*
+   * Zero-downtime restart, successor side: receive the listening
+   * sockets a draining predecessor offers via exportListeningFds()
+   * and resume accepting on them, registering every worker exactly as
+   * bind() does.  Returns the number of listeners resumed; 0 means no
+   * predecessor was offering fds (a first boot) and the caller should
+   * fall back to a fresh bind().
+   */
+  size_t bindInheritedListeners(
+      const std::string& handoffPath,
+      std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+    if (!workerFactory_) {
+      group(nullptr);
+    }
+    auto fds = receiveListeningFds(handoffPath, timeout);
+    if (fds.empty()) {
+      return 0;
+    }
+
+    std::mutex sock_lock;
+    std::vector<std::shared_ptr<folly::AsyncSocketBase>> new_sockets;
+    std::exception_ptr exn;
+
+    // Adopt each fd on the acceptor group, spreading across its
+    // threads the way bindImpl() spreads the reuse-port binds.
+    std::vector<std::shared_ptr<folly::Baton<>>> barriers;
+    for (auto fd : fds) {
+      auto barrier = std::make_shared<folly::Baton<>>();
+      barriers.push_back(barrier);
+      acceptor_group_->add([&, fd, barrier] {
+        try {
+          auto socket = socketFactory_->newInheritedSocket(fd, socketConfig);
+          if (!socket) {
+            throw std::runtime_error(
+                "socket factory cannot adopt inherited fds");
+          }
+          std::lock_guard<std::mutex> guard(sock_lock);
+          new_sockets.push_back(std::move(socket));
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(sock_lock);
+          if (!exn) {
+            exn = std::current_exception();
+          }
+        }
+        barrier->post();
+      });
     }
+    for (auto& barrier : barriers) {
+      barrier->wait();
+    }
+    if (exn) {
+      std::rethrow_exception(exn);
+    }
+
+    attachWorkersToSockets(new_sockets);
+    return new_sockets.size();
   }
 
   /*
@@ -277,7 +472,21 @@ class ServerBootstrap {
   void stop() {
     // sockets_ may be null if ServerBootstrap has been std::move'd
     if (sockets_) {
+      // Each listener's destructor blocks on its own EventBase, so
+      // release them onto their event bases first and wait once;
+      // otherwise teardown costs one blocking hop per socket.
+      std::vector<folly::Future<folly::Unit>> releases;
+      for (auto& socket : *sockets_) {
+        auto* evb = socket->getEventBase();
+        if (evb && !evb->isInEventBaseThread()) {
+          releases.push_back(folly::via(
+              evb, [s = std::move(socket)]() mutable { s.reset(); }));
+        } else {
+          socket.reset();
+        }
+      }
       sockets_->clear();
+      folly::collectAll(std::move(releases)).get();
     }
     if (!stopped_) {
       stopped_ = true;
@@ -288,6 +497,36 @@ class ServerBootstrap {
     }
   }
 
+  /*
+   * Emergency shutdown for restarts that must release the port in
+   * bounded time.  Stops the listeners like stop(), then drops every
+   * connection in bulk on its worker
+   * (ManagedConnection::dropConnectionHard), skipping per-connection
+   * close notification.  Returns once the workers finish tearing down
+   * or the budget elapses; in the latter case teardown keeps running on
+   * the workers and join() still waits for it.  The port is released
+   * before this returns either way.
+   */
+  void forceStopWithin(std::chrono::milliseconds budget) {
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    stop();
+    std::vector<folly::Future<folly::Unit>> drops;
+    forEachWorker([&](Acceptor* acceptor) {
+      if (!acceptor || !acceptor->getEventBase()) {
+        return;
+      }
+      drops.push_back(folly::via(acceptor->getEventBase(), [acceptor] {
+        acceptor->dropAllConnections(true /* dropHard */);
+      }));
+    });
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (remaining.count() < 0) {
+      remaining = std::chrono::milliseconds(0);
+    }
+    folly::collectAll(std::move(drops)).wait(remaining);
+  }
+
   void join() {
     if (acceptor_group_) {
       acceptor_group_->join();
@@ -336,29 +575,208 @@ class ServerBootstrap {
     return this;
   }
 
+  /*
+   * Create one SO_REUSEPORT listening socket per IO thread instead of
+   * accepting on the acceptor_group_ and handing connections off.  The
+   * kernel distributes incoming connections across the listeners, and each
+   * connection is accepted directly on the EventBase that will serve it, so
+   * there is no cross-thread hop per accept and no single accept-thread
+   * bottleneck.  Must be called before bind(); only affects bind(port) /
+   * bind(address), not bind(socket).
+   */
+  ServerBootstrap* setPerThreadListeners(bool enabled) {
+    perThreadListeners_ = enabled;
+    return this;
+  }
+
+  /*
+   * Steering for the per-thread listeners' SO_REUSEPORT group.  The
+   * kernel's default hashing re-shuffles flows whenever a listener
+   * joins or leaves the group (e.g. a worker restart); FLOW_HASH keeps
+   * a flow mapped by its NIC-provided hash and CPU delivers each
+   * packet to the listener of the CPU it arrived on, aligning with RSS
+   * queues and AffinityThreadFactory pinning.  Must be set before
+   * bind(); only takes effect with setPerThreadListeners(true).  Where
+   * the platform lacks SO_ATTACH_REUSEPORT_CBPF the group silently
+   * keeps the default steering.
+   */
+  ServerBootstrap* setReusePortSteering(ReusePortSteering steering) {
+    reusePortSteering_ = steering;
+    return this;
+  }
+
   ServerBootstrap* setUseSharedSSLContextManager(bool enabled) {
     useSharedSSLContextManager_ = enabled;
     return this;
   }
 
  protected:
+  /*
+   * Register every worker on each of the given sockets, then publish
+   * them in sockets_.  Registrations dispatch to each socket's
+   * EventBase concurrently and are awaited once; a per-registration
+   * wait would cost S*W blocking thread hops in a row.
+   */
+  void attachWorkersToSockets(
+      const std::vector<std::shared_ptr<folly::AsyncSocketBase>>&
+          new_sockets) {
+    std::vector<folly::Future<folly::Unit>> attaches;
+    for (auto& socket : new_sockets) {
+      auto* evb = socket->getEventBase();
+      workerFactory_->forEachWorker([&, this, socket, evb](Acceptor* worker) {
+        auto attach = [this, worker, socket]() {
+          socketFactory_->addAcceptCB(socket, worker, worker->getEventBase());
+        };
+        if (evb->isInEventBaseThread()) {
+          attach();
+        } else {
+          attaches.push_back(folly::via(evb, std::move(attach)));
+        }
+      });
+
+      sockets_->push_back(socket);
+    }
+    folly::collectAll(std::move(attaches)).get();
+  }
+
+  /*
+   * Per-thread listener mode: bind one SO_REUSEPORT socket on every IO
+   * worker's EventBase and register only that worker as its accept
+   * callback.  Since the callback's EventBase is the socket's own, folly
+   * invokes connectionAccepted directly with no notification-queue hop.
+   */
+  void bindPerThreadListeners(folly::SocketAddress& address) {
+    std::mutex lock;
+    std::exception_ptr exn;
+    const size_t socketsBefore = sockets_->size();
+
+    // The first bind runs alone so it can claim an ephemeral port; the
+    // rest bind the now-concrete address concurrently on their own
+    // event bases and are awaited as a group.
+    std::vector<std::shared_ptr<folly::Baton<>>> barriers;
+    bool first = true;
+    workerFactory_->forEachWorker([&](Acceptor* worker) {
+      auto* evb = worker->getEventBase();
+      auto bindFunc = [&, worker, evb] {
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          if (exn) {
+            return;
+          }
+        }
+        try {
+          auto socket = socketFactory_->newSocket(
+              address,
+              socketConfig.acceptBacklog,
+              true /* reusePort */,
+              socketConfig);
+          socketFactory_->addAcceptCB(socket, worker, evb);
+          std::lock_guard<std::mutex> guard(lock);
+          sockets_->push_back(std::move(socket));
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(lock);
+          if (!exn) {
+            exn = std::current_exception();
+          }
+        }
+      };
+      if (first) {
+        first = false;
+        evb->runImmediatelyOrRunInEventBaseThreadAndWait([&] {
+          bindFunc();
+          std::lock_guard<std::mutex> guard(lock);
+          if (!sockets_->empty()) {
+            sockets_->back()->getAddress(&address);
+          }
+        });
+      } else {
+        auto barrier = std::make_shared<folly::Baton<>>();
+        barriers.push_back(barrier);
+        evb->runInEventBaseThread([bindFunc, barrier] {
+          bindFunc();
+          barrier->post();
+        });
+      }
+    });
+    for (auto& barrier : barriers) {
+      barrier->wait();
+    }
+
+    if (exn) {
+      std::rethrow_exception(exn);
+    }
+
+    if (reusePortSteering_ != ReusePortSteering::KERNEL_HASH) {
+      attachReusePortSteeringProgram(sockets_->size() - socketsBefore);
+    }
+  }
+
+  /*
+   * Attach the configured steering program to the listeners' reuseport
+   * group.  The program applies to the group as a whole, so it is
+   * attached once through the last listener after every member has
+   * joined; packets arriving before that use the default hashing.
+   */
+  void attachReusePortSteeringProgram(size_t groupSize) {
+    if (groupSize == 0 || sockets_->empty()) {
+      return;
+    }
+    auto socket =
+        std::dynamic_pointer_cast<folly::AsyncServerSocket>(sockets_->back());
+    if (!socket) {
+      // Non-TCP listeners: apply attachReusePortSteering() to the
+      // bound fd directly instead.
+      return;
+    }
+    auto numListeners = static_cast<uint32_t>(groupSize);
+    auto steering = reusePortSteering_;
+    socket->getEventBase()->runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&socket, steering, numListeners] {
+          auto fds = socket->getNetworkSockets();
+          if (!fds.empty()) {
+            attachReusePortSteering(fds.front(), steering, numListeners);
+          }
+        });
+  }
+
   void acceptConnection(
       folly::NetworkSocket fd,
       const folly::SocketAddress& clientAddr,
       folly::AsyncServerSocket::AcceptCallback::AcceptInfo info,
       folly::AsyncTransport::LifecycleObserver* observer) {
-    workerFactory_->forRandomWorker([&](Acceptor* acceptor) {
+    workerFactory_->forPlacedWorker([&](Acceptor* acceptor) {
       acceptor->getEventBase()->runInEventBaseThread(
           [=] { acceptor->acceptConnection(fd, clientAddr, info, observer); });
     });
   }
 
  private:
+  std::shared_ptr<folly::ThreadFactory> makeIOThreadFactory() const {
+    switch (ioThreadPlacement_) {
+      case IOThreadPlacement::PIN_PER_CORE:
+        return std::make_shared<AffinityThreadFactory>(
+            "IO Thread", AffinityThreadFactory::perCoreCpuSets());
+      case IOThreadPlacement::PARTITION_PER_NUMA_NODE: {
+        auto cpuSets = AffinityThreadFactory::numaNodeCpuSets();
+        if (!cpuSets.empty()) {
+          return std::make_shared<AffinityThreadFactory>(
+              "IO Thread", std::move(cpuSets));
+        }
+        LOG(WARNING) << "No NUMA topology exposed; IO threads left unpinned";
+        break;
+      }
+      case IOThreadPlacement::NONE:
+        break;
+    }
+    return std::make_shared<folly::NamedThreadFactory>("IO Thread");
+  }
+
   std::shared_ptr<folly::IOThreadPoolExecutor> acceptor_group_;
   std::shared_ptr<folly::IOThreadPoolExecutor> io_group_;
   std::shared_ptr<SharedSSLContextManager> sharedSSLContextManager_;
 
   std::shared_ptr<ServerWorkerPool> workerFactory_;
+  std::shared_ptr<WorkerPlacementPolicy> placementPolicy_;
   std::shared_ptr<std::vector<std::shared_ptr<folly::AsyncSocketBase>>>
       sockets_{std::make_shared<
           std::vector<std::shared_ptr<folly::AsyncSocketBase>>>()};
@@ -373,12 +791,16 @@ class ServerBootstrap {
   ServerSocketConfig accConfig_;
 
   bool reusePort_{false};
+  bool perThreadListeners_{false};
+  ReusePortSteering reusePortSteering_{ReusePortSteering::KERNEL_HASH};
 
   std::unique_ptr<folly::Baton<>> stopBaton_{
       std::make_unique<folly::Baton<>>()};
   bool stopped_{false};
   bool useZeroCopy_{false};
   bool useSharedSSLContextManager_{false};
+  IOThreadPlacement ioThreadPlacement_{IOThreadPlacement::NONE};
+  size_t hugePageReadBufferBytes_{0};
 };
 
 } // namespace wangle
@@ -19,8 +19,14 @@
 #include <folly/io/async/AsyncServerSocket.h>
 #include <folly/io/async/AsyncUDPServerSocket.h>
 #include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/Liburing.h>
 #include <wangle/acceptor/Acceptor.h>
 
+#if FOLLY_HAS_LIBURING
+#include <folly/io/async/IoUringBackend.h>
+#include <folly/io/async/IoUringEventBaseLocal.h>
+#endif
+
 namespace wangle {
 
 class ServerSocketFactory {
@@ -31,6 +37,18 @@ class ServerSocketFactory {
       bool reuse,
       const ServerSocketConfig& config) = 0;
 
+  /**
+   * Resume accepting on a listening fd inherited from a previous
+   * process (see ServerBootstrap::bindInheritedListeners()). The fd
+   * is already bound and listening. Returns nullptr if this factory
+   * cannot adopt inherited fds.
+   */
+  virtual std::shared_ptr<folly::AsyncSocketBase> newInheritedSocket(
+      folly::NetworkSocket /*fd*/,
+      const ServerSocketConfig& /*config*/) {
+    return nullptr;
+  }
+
   virtual void removeAcceptCB(
       std::shared_ptr<folly::AsyncSocketBase> sock,
       Acceptor* callback,
@@ -58,6 +76,7 @@ class AsyncServerSocketFactory : public ServerSocketFactory {
       socket->setZeroCopy(true);
     }
     socket->setMaxNumMessagesInQueue(config.maxNumPendingConnectionsPerWorker);
+    socket->setMaxAcceptAtOnce(config.maxAcceptAtOnce);
     socket->setReusePortEnabled(reuse);
     if (config.enableTCPFastOpen) {
       socket->setTFOEnabled(true, config.fastOpenQueueSize);
@@ -70,6 +89,26 @@ class AsyncServerSocketFactory : public ServerSocketFactory {
     return socket;
   }
 
+  std::shared_ptr<folly::AsyncSocketBase> newInheritedSocket(
+      folly::NetworkSocket fd,
+      const ServerSocketConfig& config) override {
+    auto* evb = folly::EventBaseManager::get()->getEventBase();
+    std::shared_ptr<folly::AsyncServerSocket> socket(
+        new folly::AsyncServerSocket(evb), ThreadSafeDestructor());
+    if (config.useZeroCopy) {
+      socket->setZeroCopy(true);
+    }
+    socket->setMaxNumMessagesInQueue(config.maxNumPendingConnectionsPerWorker);
+    socket->setMaxAcceptAtOnce(config.maxAcceptAtOnce);
+    socket->useExistingSocket(fd);
+    // The inherited fd is already listening; this just refreshes the
+    // backlog to this process's configuration.
+    socket->listen(config.acceptBacklog);
+    socket->startAccepting();
+
+    return socket;
+  }
+
   void removeAcceptCB(
       std::shared_ptr<folly::AsyncSocketBase> s,
       Acceptor* callback,
@@ -102,6 +141,63 @@ class AsyncServerSocketFactory : public ServerSocketFactory {
   };
 };
 
+#if FOLLY_HAS_LIBURING
+
+/**
+ * A ServerSocketFactory for servers that drive connection I/O through
+ * io_uring. Listening and accepting work exactly as with
+ * AsyncServerSocketFactory; in addition, the factory attaches an io_uring
+ * to each worker EventBase it binds a socket on, so transports created on
+ * those threads (e.g. folly::AsyncIoUringSocket) submit their reads and
+ * writes through the ring with provided buffers instead of making one
+ * syscall per event. Selectable per server via
+ * ServerBootstrap::channelFactory without touching pipeline code.
+ *
+ * Binding throws if the kernel does not support io_uring, so a
+ * misconfigured deployment fails at startup rather than silently falling
+ * back to the syscall path.
+ */
+class IoUringServerSocketFactory : public AsyncServerSocketFactory {
+ public:
+  explicit IoUringServerSocketFactory(
+      folly::IoUringBackend::Options options = defaultBackendOptions())
+      : options_(std::move(options)) {}
+
+  std::shared_ptr<folly::AsyncSocketBase> newSocket(
+      folly::SocketAddress address,
+      int backlog,
+      bool reuse,
+      const ServerSocketConfig& config) override {
+    auto* evb = folly::EventBaseManager::get()->getEventBase();
+    if (!folly::IoUringEventBaseLocal::try_get(evb)) {
+      folly::IoUringEventBaseLocal::attach(evb, options_);
+    }
+    return AsyncServerSocketFactory::newSocket(address, backlog, reuse, config);
+  }
+
+  std::shared_ptr<folly::AsyncSocketBase> newInheritedSocket(
+      folly::NetworkSocket fd,
+      const ServerSocketConfig& config) override {
+    auto* evb = folly::EventBaseManager::get()->getEventBase();
+    if (!folly::IoUringEventBaseLocal::try_get(evb)) {
+      folly::IoUringEventBaseLocal::attach(evb, options_);
+    }
+    return AsyncServerSocketFactory::newInheritedSocket(fd, config);
+  }
+
+  static folly::IoUringBackend::Options defaultBackendOptions() {
+    // ~2MB of provided receive buffers per IO thread
+    return folly::IoUringBackend::Options()
+        .setCapacity(512)
+        .setInitialProvidedBuffers(2048, 1000);
+  }
+
+ private:
+  folly::IoUringBackend::Options options_;
+};
+
+#endif // FOLLY_HAS_LIBURING
+
 class AsyncUDPServerSocketFactory : public ServerSocketFactory {
  public:
   std::shared_ptr<folly::AsyncSocketBase> newSocket(
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <folly/Random.h>
+
+namespace wangle {
+
+/**
+ * Point-in-time load of one IO worker, sampled by ServerWorkerPool
+ * without touching the worker's loop: connection counts and the
+ * smoothed loop time are readable cross-thread.
+ */
+struct WorkerLoad {
+  // Connections currently owned by the worker's connection manager.
+  uint64_t activeConnections{0};
+  // Connections the pool has placed on this worker since it started.
+  uint64_t placedConnections{0};
+  // Placements per second over the window since the previous
+  // ServerWorkerPool::getWorkerLoads() call. Only filled in by that
+  // call; zero in the samples handed to placement policies.
+  double acceptRate{0};
+  // Smoothed loop iteration time (EventBase::getAvgLoopTime); the
+  // worker's loop lag.
+  std::chrono::microseconds avgLoopTime{0};
+};
+
+/**
+ * Picks the worker a directly accepted connection is placed on; see
+ * ServerWorkerPool::setWorkerPlacementPolicy. Unlike
+ * WorkerSelectionPolicy, which spreads routed connections by routing
+ * hash, placement policies see per-worker load and may be called from
+ * several accept threads at once, so they must synchronize any state of
+ * their own.
+ */
+class WorkerPlacementPolicy {
+ public:
+  virtual ~WorkerPlacementPolicy() = default;
+
+  /**
+   * Returns the index of the worker the connection should be placed on.
+   * workers is never empty.
+   */
+  virtual size_t pickWorker(const std::vector<WorkerLoad>& workers) = 0;
+};
+
+/**
+ * Uniformly random placement; the historical ServerWorkerPool behavior
+ * and its default policy.
+ */
+class RandomWorkerPlacementPolicy : public WorkerPlacementPolicy {
+ public:
+  size_t pickWorker(const std::vector<WorkerLoad>& workers) override {
+    return folly::Random::rand32(workers.size());
+  }
+};
+
+class RoundRobinWorkerPlacementPolicy : public WorkerPlacementPolicy {
+ public:
+  size_t pickWorker(const std::vector<WorkerLoad>& workers) override {
+    return next_.fetch_add(1, std::memory_order_relaxed) % workers.size();
+  }
+
+ private:
+  std::atomic<uint64_t> next_{0};
+};
+
+/**
+ * Places each connection on the worker with the fewest active
+ * connections; the first such worker wins ties.
+ */
+class LeastConnectionsWorkerPlacementPolicy : public WorkerPlacementPolicy {
+ public:
+  size_t pickWorker(const std::vector<WorkerLoad>& workers) override {
+    size_t best = 0;
+    for (size_t i = 1; i < workers.size(); i++) {
+      if (workers[i].activeConnections < workers[best].activeConnections) {
+        best = i;
+      }
+    }
+    return best;
+  }
+};
+
+/**
+ * Places each connection on the worker with the lowest loop lag, so a
+ * loop bogged down by expensive connections stops receiving new ones
+ * even when its connection count looks average.
+ */
+class LeastLagWorkerPlacementPolicy : public WorkerPlacementPolicy {
+ public:
+  size_t pickWorker(const std::vector<WorkerLoad>& workers) override {
+    size_t best = 0;
+    for (size_t i = 1; i < workers.size(); i++) {
+      if (workers[i].avgLoopTime < workers[best].avgLoopTime) {
+        best = i;
+      }
+    }
+    return best;
+  }
+};
+
+} // namespace wangle
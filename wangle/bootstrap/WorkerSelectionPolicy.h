@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/hash/Hash.h>
+#include <wangle/acceptor/Acceptor.h>
+#include <wangle/bootstrap/LoopLagProbe.h>
+
+namespace wangle {
+
+/**
+ * Picks the worker thread a routed connection lands on; see
+ * AcceptRoutingHandler::setWorkerSelectionPolicy. Policies run on the
+ * accept thread, so they need no synchronization of their own.
+ */
+class WorkerSelectionPolicy {
+ public:
+  virtual ~WorkerSelectionPolicy() = default;
+
+  /**
+   * Called once the worker list is known. The list never changes for the
+   * lifetime of the server, so policies may precompute against it.
+   */
+  virtual void initialize(const std::vector<Acceptor*>& /*acceptors*/) {}
+
+  /**
+   * Returns the index of the worker the connection with the given routing
+   * hash should be placed on. acceptors is never empty.
+   */
+  virtual size_t select(
+      uint64_t routingHash,
+      const std::vector<Acceptor*>& acceptors) = 0;
+};
+
+/**
+ * Hash modulo the worker count; the historical AcceptRoutingHandler
+ * behavior and its default policy.
+ */
+class HashModWorkerSelectionPolicy : public WorkerSelectionPolicy {
+ public:
+  size_t select(
+      uint64_t routingHash,
+      const std::vector<Acceptor*>& acceptors) override {
+    return routingHash % acceptors.size();
+  }
+};
+
+/**
+ * Bounded-load consistent hashing over the workers. The routing hash is
+ * looked up on a ring of virtual nodes, which keeps a given routing key
+ * pinned to the same worker; a worker whose connection count exceeds
+ * loadFactor times the current average is skipped in favor of the next
+ * one on the ring, which caps how far the hottest thread can drift from
+ * the mean after drains or reconnect storms.
+ *
+ * Connection counts come from Acceptor::getNumConnections(), which is
+ * written on the worker's own thread; reading it here is racy but only
+ * ever used as a load hint, so staleness costs at most a slightly
+ * suboptimal placement.
+ */
+class BoundedLoadWorkerSelectionPolicy : public WorkerSelectionPolicy {
+ public:
+  explicit BoundedLoadWorkerSelectionPolicy(
+      double loadFactor = 1.25,
+      size_t virtualNodesPerWorker = 100)
+      : loadFactor_(loadFactor),
+        virtualNodesPerWorker_(virtualNodesPerWorker) {
+    CHECK_GT(loadFactor_, 1.0);
+  }
+
+  void initialize(const std::vector<Acceptor*>& acceptors) override {
+    ring_.clear();
+    ring_.reserve(acceptors.size() * virtualNodesPerWorker_);
+    for (size_t worker = 0; worker < acceptors.size(); worker++) {
+      for (size_t replica = 0; replica < virtualNodesPerWorker_; replica++) {
+        ring_.emplace_back(
+            folly::hash::twang_mix64(
+                (uint64_t(worker) << 32) | uint64_t(replica)),
+            worker);
+      }
+    }
+    std::sort(ring_.begin(), ring_.end());
+  }
+
+  size_t select(
+      uint64_t routingHash,
+      const std::vector<Acceptor*>& acceptors) override {
+    CHECK(!ring_.empty());
+
+    // The per-worker budget counts the incoming connection, so a bound of
+    // at least one connection per worker always exists and the clockwise
+    // walk below cannot skip every worker.
+    uint64_t total = 0;
+    for (auto* acceptor : acceptors) {
+      total += getLoad(acceptor);
+    }
+    const double bound =
+        loadFactor_ * static_cast<double>(total + 1) / acceptors.size();
+
+    auto it = std::lower_bound(
+        ring_.begin(),
+        ring_.end(),
+        std::make_pair(routingHash, size_t(0)));
+    for (size_t probes = 0; probes < ring_.size(); probes++, ++it) {
+      if (it == ring_.end()) {
+        it = ring_.begin();
+      }
+      if (getLoad(acceptors[it->second]) < bound) {
+        return it->second;
+      }
+    }
+    // Unreachable given the bound above; kept as a safe fallback.
+    return routingHash % acceptors.size();
+  }
+
+ protected:
+  /**
+   * Load hint for a worker; overridable so tests can inject counts.
+   */
+  virtual uint64_t getLoad(Acceptor* acceptor) {
+    return acceptor->getNumConnections();
+  }
+
+ private:
+  double loadFactor_;
+  size_t virtualNodesPerWorker_;
+  // (point on the ring, worker index), sorted by point.
+  std::vector<std::pair<uint64_t, size_t>> ring_;
+};
+
+/**
+ * Hash-based selection that deprioritizes laggy loops. Each worker's
+ * EventBase is probed continuously for scheduling lag (LoopLagProbe,
+ * published through shared atomics), and select() walks forward from
+ * the hashed worker to the first one whose smoothed lag is under the
+ * threshold, so an IO thread stuck in a long TLS batch stops receiving
+ * new connections until it drains. When every loop is over threshold
+ * the least laggy one wins. A key keeps its hashed worker while that
+ * worker is healthy, so steering degrades to plain hash-mod when the
+ * pool is calm.
+ *
+ * select() only reads the published atomics, so one instance may be
+ * shared by several accept threads.
+ */
+class LagAwareWorkerSelectionPolicy : public WorkerSelectionPolicy {
+ public:
+  explicit LagAwareWorkerSelectionPolicy(
+      std::chrono::microseconds lagThreshold = std::chrono::milliseconds(5),
+      std::chrono::milliseconds probeInterval = std::chrono::milliseconds(100))
+      : lagThreshold_(lagThreshold), probeInterval_(probeInterval) {}
+
+  void initialize(const std::vector<Acceptor*>& acceptors) override {
+    // A shared instance is initialized by each accept thread's routing
+    // handler; the probes are started once and reused.
+    if (!probes_.empty()) {
+      return;
+    }
+    probes_.reserve(acceptors.size());
+    for (auto* acceptor : acceptors) {
+      probes_.push_back(std::make_unique<LoopLagProbe>(
+          acceptor->getEventBase(), probeInterval_));
+    }
+  }
+
+  size_t select(
+      uint64_t routingHash,
+      const std::vector<Acceptor*>& acceptors) override {
+    const size_t n = acceptors.size();
+    size_t best = routingHash % n;
+    auto bestLag = std::chrono::microseconds::max();
+    for (size_t i = 0; i < n; i++) {
+      const size_t idx = (routingHash + i) % n;
+      const auto lag = getLag(idx);
+      if (lag <= lagThreshold_) {
+        return idx;
+      }
+      if (lag < bestLag) {
+        bestLag = lag;
+        best = idx;
+      }
+    }
+    return best;
+  }
+
+ protected:
+  /**
+   * Published lag of one worker; overridable so tests can inject lags.
+   */
+  virtual std::chrono::microseconds getLag(size_t worker) {
+    return probes_[worker]->getLag();
+  }
+
+ private:
+  const std::chrono::microseconds lagThreshold_;
+  const std::chrono::milliseconds probeInterval_;
+  std::vector<std::unique_ptr<LoopLagProbe>> probes_;
+};
+
+} // namespace wangle
@@ -204,6 +204,49 @@ TEST_F(AcceptRoutingHandlerTest, ParseRoutingDataSuccess) {
   EXPECT_EQ(0, acceptRoutingHandler_->getRoutingPipelineCount());
 }
 
+TEST_F(AcceptRoutingHandlerTest, PeekBasedRouting) {
+  acceptRoutingHandler_->setPeekRoutingBytes(1);
+
+  // The routing key is parsed straight from the peeked prefix; no
+  // routing pipeline is ever built, so the routing handler is never
+  // attached to one.
+  EXPECT_CALL(*routingDataHandler_, transportActive(_)).Times(0);
+  EXPECT_CALL(*routingDataHandler_, parseRoutingData(_, _))
+      .WillOnce(Invoke(
+          [&](folly::IOBufQueue& bufQueue,
+              MockRoutingDataHandler::RoutingData& /*routingData*/) {
+            EXPECT_EQ(1, bufQueue.chainLength());
+            VLOG(4) << "Parsed peeked routing data";
+            return true;
+          }));
+
+  // Downstream pipeline is created directly, and re-reads the routing
+  // byte from the socket since the peek consumed nothing.
+  boost::barrier barrier(2);
+  EXPECT_CALL(*downstreamHandler_, transportActive(_));
+  EXPECT_CALL(*downstreamHandler_, read(_, _))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* /*ctx*/,
+                           IOBufQueue& bufQueue) {
+        EXPECT_EQ(1, bufQueue.chainLength());
+        VLOG(4) << "Downstream received the peeked byte";
+      }));
+  EXPECT_CALL(*downstreamHandler_, readEOF(_))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* ctx) {
+        VLOG(4) << "Downstream EOF";
+        ctx->fireClose();
+        barrier.wait();
+      }));
+  EXPECT_CALL(*downstreamHandler_, transportInactive(_));
+
+  // Send client request that triggers server processing
+  clientConnectAndCleanClose();
+
+  barrier.wait();
+
+  // No routing pipeline was created
+  EXPECT_EQ(0, acceptRoutingHandler_->getRoutingPipelineCount());
+}
+
 TEST_F(AcceptRoutingHandlerTest, SocketErrorInRoutingPipeline) {
   // Server receives data, and parses routing data
   boost::barrier barrierConnect(2);
@@ -286,3 +329,97 @@ TEST_F(AcceptRoutingHandlerTest, RoutingPipelineErasedOnlyOnce) {
       std::runtime_error("An exception from the socket."));
   acceptRoutingHandler_->onRoutingData(kConnId0, routingData_);
 }
+
+namespace {
+
+// A newline-delimited routing handler that resumes its delimiter scan
+// at the parse cursor instead of re-scanning the queue from offset
+// zero on every read event.
+class LineRoutingDataHandler : public RoutingDataHandler<char> {
+ public:
+  LineRoutingDataHandler(uint64_t connId, Callback* cob)
+      : RoutingDataHandler<char>(connId, cob) {}
+
+  bool parseRoutingData(folly::IOBufQueue& bufQueue, RoutingData& routingData)
+      override {
+    scannedFrom.push_back(parseCursor());
+    auto buf = bufQueue.move();
+    if (!buf) {
+      return false;
+    }
+    buf->coalesce();
+    const auto* data = buf->data();
+    for (size_t i = parseCursor(); i < buf->length(); i++) {
+      if (data[i] == '\n') {
+        routingData.routingData = static_cast<char>(data[0]);
+        buf->trimStart(i + 1);
+        routingData.bufQueue.append(std::move(buf));
+        return true;
+      }
+    }
+    setParseCursor(buf->length());
+    bufQueue.append(std::move(buf));
+    return false;
+  }
+
+  std::vector<uint64_t> scannedFrom;
+};
+
+class RecordingRoutingCallback : public RoutingDataHandler<char>::Callback {
+ public:
+  void onRoutingData(
+      uint64_t /*connId*/,
+      RoutingDataHandler<char>::RoutingData& routingData) override {
+    routed = true;
+    routingKey = routingData.routingData;
+  }
+
+  void onError(uint64_t /*connId*/, folly::exception_wrapper ex) override {
+    error = std::move(ex);
+  }
+
+  bool routed{false};
+  char routingKey{0};
+  folly::exception_wrapper error;
+};
+
+} // namespace
+
+TEST(RoutingDataHandlerTest, ResumableParseCursor) {
+  RecordingRoutingCallback cob;
+  LineRoutingDataHandler handler(0, &cob);
+
+  folly::IOBufQueue q(folly::IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer("sha"));
+  handler.read(nullptr, q);
+  EXPECT_FALSE(cob.routed);
+  q.append(IOBuf::copyBuffer("rd"));
+  handler.read(nullptr, q);
+  EXPECT_FALSE(cob.routed);
+  q.append(IOBuf::copyBuffer("\n"));
+  handler.read(nullptr, q);
+  EXPECT_TRUE(cob.routed);
+  EXPECT_EQ('s', cob.routingKey);
+
+  // Each read event resumed the scan where the previous one left off.
+  EXPECT_EQ((std::vector<uint64_t>{0, 3, 5}), handler.scannedFrom);
+}
+
+TEST(RoutingDataHandlerTest, RejectsOversizedRoutingData) {
+  RecordingRoutingCallback cob;
+  LineRoutingDataHandler handler(0, &cob);
+  handler.setMaxRoutingDataSize(4);
+
+  folly::IOBufQueue q(folly::IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer("abc"));
+  handler.read(nullptr, q);
+  EXPECT_FALSE(cob.error);
+  EXPECT_FALSE(cob.routed);
+
+  // Crossing the cap rejects the connection without parsing again.
+  q.append(IOBuf::copyBuffer("de"));
+  handler.read(nullptr, q);
+  EXPECT_TRUE(cob.error);
+  EXPECT_FALSE(cob.routed);
+  EXPECT_EQ(1, handler.scannedFrom.size());
+}
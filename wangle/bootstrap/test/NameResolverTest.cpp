@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/bootstrap/NameResolver.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+// Answers from a scripted list of results, one per upstream call, so
+// the tests control exactly what each resolution round returns.
+class FakeResolver : public NameResolver {
+ public:
+  Future<std::vector<SocketAddress>> resolve(
+      const std::string& /* hostname */,
+      uint16_t port) override {
+    calls++;
+    if (fail) {
+      return makeFuture<std::vector<SocketAddress>>(
+          std::runtime_error("resolution failed"));
+    }
+    std::vector<SocketAddress> addresses{
+        SocketAddress(nextAddress, port),
+    };
+    return makeFuture(std::move(addresses));
+  }
+
+  int calls{0};
+  bool fail{false};
+  std::string nextAddress{"127.0.0.1"};
+};
+
+} // namespace
+
+TEST(ThreadedNameResolverTest, ResolvesLocalhost) {
+  ThreadedNameResolver resolver;
+  auto addresses = resolver.resolve("localhost", 8080).get();
+  ASSERT_FALSE(addresses.empty());
+  for (const auto& address : addresses) {
+    EXPECT_EQ(address.getPort(), 8080);
+    EXPECT_TRUE(address.isLoopbackAddress());
+  }
+}
+
+TEST(CachingNameResolverTest, ServesRepeatLookupsFromCache) {
+  auto upstream = std::make_shared<FakeResolver>();
+  auto resolver = std::make_shared<CachingNameResolver>(upstream);
+
+  auto first = resolver->resolve("example.com", 443).get();
+  auto second = resolver->resolve("example.com", 443).get();
+  EXPECT_EQ(upstream->calls, 1);
+  EXPECT_EQ(first, second);
+
+  // A different port is a different cache entry.
+  resolver->resolve("example.com", 80).get();
+  EXPECT_EQ(upstream->calls, 2);
+}
+
+TEST(CachingNameResolverTest, CachesFailures) {
+  auto upstream = std::make_shared<FakeResolver>();
+  upstream->fail = true;
+  auto resolver = std::make_shared<CachingNameResolver>(upstream);
+
+  EXPECT_THROW(resolver->resolve("example.com", 443).get(), std::runtime_error);
+  EXPECT_THROW(resolver->resolve("example.com", 443).get(), std::runtime_error);
+  // The second failure came from the negative cache.
+  EXPECT_EQ(upstream->calls, 1);
+}
+
+TEST(CachingNameResolverTest, ServesStaleWhileRevalidating) {
+  auto upstream = std::make_shared<FakeResolver>();
+  CachingNameResolver::Options options;
+  // Entries are stale immediately but usable for a long while.
+  options.positiveTtl = std::chrono::seconds(0);
+  options.staleTtl = std::chrono::seconds(300);
+  auto resolver = std::make_shared<CachingNameResolver>(upstream, options);
+
+  auto first = resolver->resolve("example.com", 443).get();
+  EXPECT_EQ(upstream->calls, 1);
+
+  // The stale entry is served without waiting, and the inline refresh
+  // has already replaced it with the upstream's new answer.
+  upstream->nextAddress = "127.0.0.2";
+  auto second = resolver->resolve("example.com", 443).get();
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(upstream->calls, 2);
+
+  auto third = resolver->resolve("example.com", 443).get();
+  EXPECT_EQ(third.at(0).getAddressStr(), "127.0.0.2");
+}
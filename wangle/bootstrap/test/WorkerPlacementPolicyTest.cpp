@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/bootstrap/WorkerPlacementPolicy.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+namespace {
+
+std::vector<WorkerLoad> makeLoads(std::vector<uint64_t> connections) {
+  std::vector<WorkerLoad> loads;
+  for (auto conns : connections) {
+    WorkerLoad load;
+    load.activeConnections = conns;
+    loads.push_back(load);
+  }
+  return loads;
+}
+
+} // namespace
+
+TEST(WorkerPlacementPolicyTest, RandomStaysInRange) {
+  RandomWorkerPlacementPolicy policy;
+  auto loads = makeLoads({0, 0, 0});
+  for (int i = 0; i < 100; i++) {
+    EXPECT_LT(policy.pickWorker(loads), loads.size());
+  }
+}
+
+TEST(WorkerPlacementPolicyTest, RoundRobinCycles) {
+  RoundRobinWorkerPlacementPolicy policy;
+  auto loads = makeLoads({0, 0, 0});
+  for (size_t i = 0; i < 9; i++) {
+    EXPECT_EQ(policy.pickWorker(loads), i % loads.size());
+  }
+}
+
+TEST(WorkerPlacementPolicyTest, LeastConnectionsPicksMinimum) {
+  LeastConnectionsWorkerPlacementPolicy policy;
+  EXPECT_EQ(policy.pickWorker(makeLoads({5, 2, 7, 2})), 1);
+  // First worker wins ties.
+  EXPECT_EQ(policy.pickWorker(makeLoads({3, 3, 3})), 0);
+}
+
+TEST(WorkerPlacementPolicyTest, LeastLagPicksCalmestLoop) {
+  LeastLagWorkerPlacementPolicy policy;
+  auto loads = makeLoads({10, 1, 10});
+  loads[0].avgLoopTime = std::chrono::microseconds(50);
+  loads[1].avgLoopTime = std::chrono::microseconds(900);
+  loads[2].avgLoopTime = std::chrono::microseconds(20);
+  // Lag, not connection count, decides.
+  EXPECT_EQ(policy.pickWorker(loads), 2);
+}
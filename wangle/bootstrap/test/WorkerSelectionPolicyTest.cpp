@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <wangle/bootstrap/WorkerSelectionPolicy.h>
+
+using namespace wangle;
+
+namespace {
+
+// Policy with injected connection counts. The Acceptor pointers are
+// distinct tags that are never dereferenced; getLoad maps them back to
+// the injected loads.
+class FakeLoadPolicy : public BoundedLoadWorkerSelectionPolicy {
+ public:
+  std::vector<uint64_t> loads;
+  std::vector<Acceptor*> acceptors;
+
+  explicit FakeLoadPolicy(std::vector<uint64_t> workerLoads)
+      : loads(std::move(workerLoads)) {
+    for (size_t i = 0; i < loads.size(); i++) {
+      acceptors.push_back(reinterpret_cast<Acceptor*>(i + 1));
+    }
+    initialize(acceptors);
+  }
+
+ protected:
+  uint64_t getLoad(Acceptor* acceptor) override {
+    return loads[reinterpret_cast<uintptr_t>(acceptor) - 1];
+  }
+};
+
+// Lag-aware policy with injected per-worker lags instead of probes.
+class FakeLagPolicy : public LagAwareWorkerSelectionPolicy {
+ public:
+  std::vector<std::chrono::microseconds> lags;
+  std::vector<Acceptor*> acceptors;
+
+  FakeLagPolicy(
+      std::vector<std::chrono::microseconds> workerLags,
+      std::chrono::microseconds threshold)
+      : LagAwareWorkerSelectionPolicy(threshold), lags(std::move(workerLags)) {
+    acceptors.resize(lags.size(), nullptr);
+  }
+
+ protected:
+  std::chrono::microseconds getLag(size_t worker) override {
+    return lags[worker];
+  }
+};
+
+} // namespace
+
+TEST(WorkerSelectionPolicy, HashModMatchesLegacyBehavior) {
+  HashModWorkerSelectionPolicy policy;
+  std::vector<Acceptor*> acceptors(4, nullptr);
+  for (uint64_t hash = 0; hash < 100; hash++) {
+    EXPECT_EQ(hash % acceptors.size(), policy.select(hash, acceptors));
+  }
+}
+
+TEST(WorkerSelectionPolicy, BoundedLoadIsStablePerKey) {
+  FakeLoadPolicy policy(std::vector<uint64_t>(8, 0));
+  for (uint64_t hash = 0; hash < 1000; hash += 13) {
+    auto first = policy.select(hash, policy.acceptors);
+    EXPECT_EQ(first, policy.select(hash, policy.acceptors));
+  }
+}
+
+TEST(WorkerSelectionPolicy, BoundedLoadSpreadsKeys) {
+  FakeLoadPolicy policy(std::vector<uint64_t>(8, 0));
+  std::vector<uint64_t> placements(8, 0);
+  for (uint64_t key = 0; key < 10000; key++) {
+    placements[policy.select(
+        folly::hash::twang_mix64(key), policy.acceptors)]++;
+  }
+  // Every worker gets a reasonable share of uniformly hashed keys.
+  for (auto count : placements) {
+    EXPECT_GT(count, 10000 / 8 / 2);
+  }
+}
+
+TEST(WorkerSelectionPolicy, BoundedLoadSkipsOverloadedWorker) {
+  // Worker loads average 100; with a 1.25 load factor, the worker
+  // sitting at 500 connections is over budget and must never be picked.
+  FakeLoadPolicy policy({50, 500, 50, 50, 50, 50, 50, 0});
+  for (uint64_t key = 0; key < 1000; key++) {
+    EXPECT_NE(
+        1, policy.select(folly::hash::twang_mix64(key), policy.acceptors));
+  }
+}
+
+TEST(WorkerSelectionPolicy, BoundedLoadAlwaysFindsAWorker) {
+  // Even with every worker loaded, the bound admits the incoming
+  // connection somewhere.
+  FakeLoadPolicy policy({1000, 1000, 1000, 1000});
+  for (uint64_t key = 0; key < 100; key++) {
+    auto idx = policy.select(folly::hash::twang_mix64(key), policy.acceptors);
+    EXPECT_LT(idx, 4);
+  }
+}
+
+TEST(WorkerSelectionPolicy, LagAwareKeepsHealthyHashedWorker) {
+  using us = std::chrono::microseconds;
+  // Every loop is under the threshold: selection matches hash-mod.
+  FakeLagPolicy policy(std::vector<us>(4, us(100)), us(5000));
+  for (uint64_t hash = 0; hash < 100; hash++) {
+    EXPECT_EQ(hash % 4, policy.select(hash, policy.acceptors));
+  }
+}
+
+TEST(WorkerSelectionPolicy, LagAwareSkipsLaggyWorker) {
+  using us = std::chrono::microseconds;
+  // Worker 1 is stuck; hashes that land on it spill to worker 2.
+  FakeLagPolicy policy(
+      {us(100), us(50000), us(100), us(100)}, us(5000));
+  EXPECT_EQ(2, policy.select(1, policy.acceptors));
+  EXPECT_EQ(2, policy.select(5, policy.acceptors));
+  // Other workers keep their hashed placements.
+  EXPECT_EQ(0, policy.select(0, policy.acceptors));
+  EXPECT_EQ(3, policy.select(3, policy.acceptors));
+}
+
+TEST(WorkerSelectionPolicy, LagAwarePicksLeastLaggyWhenAllOver) {
+  using us = std::chrono::microseconds;
+  FakeLagPolicy policy(
+      {us(40000), us(50000), us(9000), us(60000)}, us(5000));
+  for (uint64_t hash = 0; hash < 16; hash++) {
+    EXPECT_EQ(2, policy.select(hash, policy.acceptors));
+  }
+}
+
+TEST(WorkerSelectionPolicy, LoopLagProbePublishesSamples) {
+  folly::EventBase evb;
+  LoopLagProbe probe(&evb, std::chrono::milliseconds(1));
+  // Let a few probe intervals elapse; an unloaded loop reports a small
+  // non-negative lag.
+  bool done = false;
+  evb.runAfterDelay([&] { done = true; }, 20);
+  while (!done) {
+    evb.loopOnce();
+  }
+  EXPECT_GE(probe.getLag().count(), 0);
+  EXPECT_LT(probe.getLag(), std::chrono::milliseconds(20));
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+
+#include <folly/SocketAddress.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Assume.h>
+#include <folly/io/async/AsyncTransport.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <glog/logging.h>
+#include <wangle/acceptor/SecureTransportType.h>
+#include <wangle/acceptor/TransportInfo.h>
+
+namespace wangle {
+
+// ConnInfo must be a complete type here: type() below evaluates
+// typeid(ConnInfo&), which is ill-formed on an incomplete class.
+struct ConnInfo {
+  folly::AsyncTransport* sock;
+  const folly::SocketAddress* clientAddr;
+  const std::string& nextProtoName;
+  SecureTransportType secureType;
+  // Owned by the accept path and dead once the accept pipeline read
+  // returns; the terminal handler moves from it rather than copying.
+  TransportInfo& tinfo;
+};
+
+enum class ConnEvent {
+  CONN_ADDED,
+  CONN_REMOVED,
+};
+
+/**
+ * The message type flowing through accept pipelines.
+ *
+ * This used to be a boost::variant, which cost a heap-allocating backup copy
+ * on assignment and non-trivial visitation machinery on every accept. Accept
+ * is a hot path, so this is a hand-rolled tagged union instead: construction
+ * stores a tag plus the alternative in-place, and the UDP tuple alternatives
+ * (the only non-trivial ones) are moved, never copied, when the message is
+ * handed from the accept thread to a pipeline.
+ *
+ * type() intentionally mirrors boost::variant's accessor so existing
+ * `conn.type() == typeid(ConnInfo&)` checks keep working; use get<T>() in
+ * place of boost::get<T>(conn).
+ */
+class AcceptPipelineType {
+ public:
+  using UdpMsg = std::tuple<
+      folly::IOBuf*,
+      std::shared_ptr<folly::AsyncUDPSocket>,
+      folly::SocketAddress>;
+  using UdpReadMsg = std::tuple<
+      folly::IOBuf*,
+      std::shared_ptr<folly::AsyncUDPSocket>,
+      folly::SocketAddress,
+      folly::AsyncUDPSocket::ReadCallback::OnDataAvailableParams>;
+
+  // One datagram within a batched delivery; the consumer takes ownership
+  // of buf, as with UdpMsg.
+  struct UdpPacket {
+    folly::IOBuf* buf;
+    folly::SocketAddress addr;
+    folly::AsyncUDPSocket::ReadCallback::OnDataAvailableParams params;
+  };
+  using UdpBatchMsg = std::tuple<
+      std::vector<UdpPacket>,
+      std::shared_ptr<folly::AsyncUDPSocket>>;
+
+  /* implicit */ AcceptPipelineType(folly::IOBuf* buf) : kind_(Kind::BUF) {
+    storage_.buf = buf;
+  }
+
+  /* implicit */ AcceptPipelineType(folly::AsyncTransport* transport)
+      : kind_(Kind::TRANSPORT) {
+    storage_.transport = transport;
+  }
+
+  /* implicit */ AcceptPipelineType(ConnInfo& connInfo)
+      : kind_(Kind::CONN_INFO) {
+    storage_.connInfo = &connInfo;
+  }
+
+  /* implicit */ AcceptPipelineType(ConnEvent event) : kind_(Kind::CONN_EVENT) {
+    storage_.event = event;
+  }
+
+  /* implicit */ AcceptPipelineType(UdpMsg&& msg) : kind_(Kind::UDP_MSG) {
+    new (&storage_.udpMsg) UdpMsg(std::move(msg));
+  }
+
+  /* implicit */ AcceptPipelineType(UdpReadMsg&& msg)
+      : kind_(Kind::UDP_READ_MSG) {
+    new (&storage_.udpReadMsg) UdpReadMsg(std::move(msg));
+  }
+
+  /* implicit */ AcceptPipelineType(UdpBatchMsg&& msg)
+      : kind_(Kind::UDP_BATCH_MSG) {
+    new (&storage_.udpBatchMsg) UdpBatchMsg(std::move(msg));
+  }
+
+  AcceptPipelineType(AcceptPipelineType&& other) noexcept {
+    moveFrom(std::move(other));
+  }
+
+  AcceptPipelineType& operator=(AcceptPipelineType&& other) noexcept {
+    if (this != &other) {
+      destroy();
+      moveFrom(std::move(other));
+    }
+    return *this;
+  }
+
+  AcceptPipelineType(const AcceptPipelineType& other) {
+    copyFrom(other);
+  }
+
+  AcceptPipelineType& operator=(const AcceptPipelineType& other) {
+    if (this != &other) {
+      destroy();
+      copyFrom(other);
+    }
+    return *this;
+  }
+
+  ~AcceptPipelineType() {
+    destroy();
+  }
+
+  const std::type_info& type() const {
+    switch (kind_) {
+      case Kind::BUF:
+        return typeid(folly::IOBuf*);
+      case Kind::TRANSPORT:
+        return typeid(folly::AsyncTransport*);
+      case Kind::CONN_INFO:
+        return typeid(ConnInfo&);
+      case Kind::CONN_EVENT:
+        return typeid(ConnEvent);
+      case Kind::UDP_MSG:
+        return typeid(UdpMsg);
+      case Kind::UDP_READ_MSG:
+        return typeid(UdpReadMsg);
+      case Kind::UDP_BATCH_MSG:
+        return typeid(UdpBatchMsg);
+    }
+    folly::assume_unreachable();
+  }
+
+  template <class T>
+  T& get() {
+    if constexpr (std::is_same<T, folly::IOBuf*>::value) {
+      CHECK(kind_ == Kind::BUF);
+      return storage_.buf;
+    } else if constexpr (std::is_same<T, folly::AsyncTransport*>::value) {
+      CHECK(kind_ == Kind::TRANSPORT);
+      return storage_.transport;
+    } else if constexpr (std::is_same<T, ConnEvent>::value) {
+      CHECK(kind_ == Kind::CONN_EVENT);
+      return storage_.event;
+    } else if constexpr (std::is_same<T, UdpMsg>::value) {
+      CHECK(kind_ == Kind::UDP_MSG);
+      return storage_.udpMsg;
+    } else if constexpr (std::is_same<T, UdpReadMsg>::value) {
+      CHECK(kind_ == Kind::UDP_READ_MSG);
+      return storage_.udpReadMsg;
+    } else if constexpr (std::is_same<T, UdpBatchMsg>::value) {
+      CHECK(kind_ == Kind::UDP_BATCH_MSG);
+      return storage_.udpBatchMsg;
+    } else {
+      static_assert(
+          std::is_same<T, folly::IOBuf*>::value,
+          "not an AcceptPipelineType alternative");
+    }
+  }
+
+ private:
+  enum class Kind : uint8_t {
+    BUF,
+    TRANSPORT,
+    CONN_INFO,
+    CONN_EVENT,
+    UDP_MSG,
+    UDP_READ_MSG,
+    UDP_BATCH_MSG,
+  };
+
+  union Storage {
+    Storage() {}
+    ~Storage() {}
+
+    folly::IOBuf* buf;
+    folly::AsyncTransport* transport;
+    ConnInfo* connInfo;
+    ConnEvent event;
+    UdpMsg udpMsg;
+    UdpReadMsg udpReadMsg;
+    UdpBatchMsg udpBatchMsg;
+  };
+
+  void destroy() {
+    switch (kind_) {
+      case Kind::UDP_MSG:
+        storage_.udpMsg.~UdpMsg();
+        break;
+      case Kind::UDP_READ_MSG:
+        storage_.udpReadMsg.~UdpReadMsg();
+        break;
+      case Kind::UDP_BATCH_MSG:
+        storage_.udpBatchMsg.~UdpBatchMsg();
+        break;
+      default:
+        break;
+    }
+  }
+
+  void moveFrom(AcceptPipelineType&& other) noexcept {
+    kind_ = other.kind_;
+    switch (kind_) {
+      case Kind::BUF:
+        storage_.buf = other.storage_.buf;
+        break;
+      case Kind::TRANSPORT:
+        storage_.transport = other.storage_.transport;
+        break;
+      case Kind::CONN_INFO:
+        storage_.connInfo = other.storage_.connInfo;
+        break;
+      case Kind::CONN_EVENT:
+        storage_.event = other.storage_.event;
+        break;
+      case Kind::UDP_MSG:
+        new (&storage_.udpMsg) UdpMsg(std::move(other.storage_.udpMsg));
+        break;
+      case Kind::UDP_READ_MSG:
+        new (&storage_.udpReadMsg)
+            UdpReadMsg(std::move(other.storage_.udpReadMsg));
+        break;
+      case Kind::UDP_BATCH_MSG:
+        new (&storage_.udpBatchMsg)
+            UdpBatchMsg(std::move(other.storage_.udpBatchMsg));
+        break;
+    }
+  }
+
+  void copyFrom(const AcceptPipelineType& other) {
+    kind_ = other.kind_;
+    switch (kind_) {
+      case Kind::BUF:
+        storage_.buf = other.storage_.buf;
+        break;
+      case Kind::TRANSPORT:
+        storage_.transport = other.storage_.transport;
+        break;
+      case Kind::CONN_INFO:
+        storage_.connInfo = other.storage_.connInfo;
+        break;
+      case Kind::CONN_EVENT:
+        storage_.event = other.storage_.event;
+        break;
+      case Kind::UDP_MSG:
+        new (&storage_.udpMsg) UdpMsg(other.storage_.udpMsg);
+        break;
+      case Kind::UDP_READ_MSG:
+        new (&storage_.udpReadMsg) UdpReadMsg(other.storage_.udpReadMsg);
+        break;
+      case Kind::UDP_BATCH_MSG:
+        new (&storage_.udpBatchMsg) UdpBatchMsg(other.storage_.udpBatchMsg);
+        break;
+    }
+  }
+
+  Kind kind_;
+  Storage storage_;
+};
+
+// get<ConnInfo&> needs a distinct signature since we store a pointer.
+template <>
+inline ConnInfo& AcceptPipelineType::get<ConnInfo&>() {
+  CHECK(kind_ == Kind::CONN_INFO);
+  return *storage_.connInfo;
+}
+
+} // namespace wangle
@@ -16,25 +16,81 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventBaseManager.h>
+#include <folly/lang/Bits.h>
+#include <folly/small_vector.h>
 #include <wangle/channel/Handler.h>
+#include <wangle/channel/ReadBufferPool.h>
+#include <wangle/util/Tracepoints.h>
 
 namespace wangle {
 
 // This handler may only be used in a single Pipeline
 class AsyncSocketHandler : public wangle::BytesToBytesHandler,
-                           public folly::AsyncTransport::ReadCallback {
+                           public folly::AsyncTransport::ReadCallback,
+                           protected folly::EventBase::LoopCallback,
+                           private folly::AsyncTransport::BufferCallback {
  public:
+  struct CorkStats {
+    uint64_t flushes{0};
+    // Writes that were merged into an already pending flush.
+    uint64_t writesCoalesced{0};
+    // Total IOBuf chain elements flushed; divided by flushes this is the
+    // average writev vector length hitting the socket.
+    uint64_t buffersFlushed{0};
+  };
+
+  struct ZeroCopyStats {
+    // Chains at or above the threshold sent with MSG_ZEROCOPY requested.
+    uint64_t zeroCopyWrites{0};
+    // Chains sent on the copying path: below the threshold, zero-copy
+    // unavailable on the transport, or after the socket reverted.
+    uint64_t copiedWrites{0};
+    // Times the socket reverted to copying after the kernel refused
+    // zero-copy (e.g. ENOBUFS).
+    uint64_t fallbacks{0};
+  };
+
+  struct TxLatencyStats {
+    // Writes tagged for TX timestamping (1-in-N sampling).
+    uint64_t sampledWrites{0};
+    // Samples whose TX completion timestamp came back.
+    uint64_t completedSamples{0};
+    uint64_t maxLatencyUs{0};
+    // Log2 histogram of submit-to-TX latency: bucket 0 counts sends
+    // under 1us, bucket i counts [2^(i-1), 2^i) us, and the last
+    // bucket everything beyond.
+    std::array<uint64_t, 21> latencyBucketsUs{};
+  };
+
+  struct WriteCallbackStats {
+    // Write completions served from the inline callback slab.
+    uint64_t inlineCallbacks{0};
+    // Heap-allocated callbacks, used when more writes were in flight
+    // than inline slots.
+    uint64_t heapCallbacks{0};
+  };
+
   explicit AsyncSocketHandler(std::shared_ptr<folly::AsyncTransport> socket)
       : socket_(std::move(socket)) {}
 
   AsyncSocketHandler(AsyncSocketHandler&&) = default;
 
   ~AsyncSocketHandler() override {
+    detachBufferCallback();
+    detachTxObserver();
     detachReadCallback();
 
     if (socket_) {
@@ -68,7 +124,15 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
   }
 
   void detachEventBase() {
+    // The timer is registered on the event base we are about to leave;
+    // the next tracked write re-creates it on the new one.
+    writeDeadlineTimer_.reset();
+    detachBufferCallback();
     detachReadCallback();
+    if (isLoopCallbackScheduled()) {
+      cancelLoopCallback();
+      flushCorkedWrites();
+    }
     if (socket_->getEventBase()) {
       socket_->detachEventBase();
     }
@@ -76,7 +140,11 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
 
   void transportActive(Context* ctx) override {
     ctx->getPipeline()->setTransport(socket_);
+    // maxBufferSize() is const and cannot reach the context, so cache
+    // the pipeline's allocation size for movable reads here.
+    movableReadCap_ = ctx->getReadBufferSettings().second;
     attachReadCallback();
+    attachBufferCallback();
     firedInactive_ = false;
     ctx->fireTransportActive();
   }
@@ -107,12 +175,264 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
           "socket is closed in write()"));
     }
 
-    auto cb = new WriteCallback();
-    auto future = cb->promise_.getFuture();
-    socket_->writeChain(cb, std::move(buf), ctx->getWriteFlags());
+    writeDeadline_ = ctx->getPipeline()->getWriteDeadline();
+    if (corkWrites_) {
+      appendCorked(ctx, std::move(buf));
+      corkedWaiters_.emplace_back();
+      return corkedWaiters_.back().getFuture();
+    }
+
+    auto cb = acquireWriteCallback();
+    cb->promise_.emplace();
+    auto future = cb->promise_->getFuture();
+    if (writeDeadline_.count() > 0) {
+      trackWriteDeadline();
+      cb->deadlineState_ = writeDeadlineState_;
+    }
+    auto flags = addZeroCopyFlags(ctx->getWriteFlags(), *buf);
+    flags = addTxTimestampFlags(flags, *buf);
+    sdtSocketFlush(*buf);
+    socket_->writeChain(cb, std::move(buf), flags);
     return future;
   }
 
+  FastWriteResult writeFast(Context* ctx, std::unique_ptr<folly::IOBuf>& buf)
+      override {
+    if (UNLIKELY(!buf)) {
+      return FastWriteResult::DONE;
+    }
+    if (!socket_->good()) {
+      // Let the fallback write() produce the error future.
+      return FastWriteResult::UNSUPPORTED;
+    }
+    refreshTimeout();
+    writeDeadline_ = ctx->getPipeline()->getWriteDeadline();
+    if (corkWrites_) {
+      // No waiter; the shared flush callback only fulfills promises for
+      // writes that asked for a future.
+      appendCorked(ctx, std::move(buf));
+      return FastWriteResult::DONE;
+    }
+    folly::AsyncTransport::WriteCallback* cb = nullptr;
+    if (writeDeadline_.count() > 0) {
+      trackWriteDeadline();
+      auto pooled = acquireWriteCallback();
+      pooled->deadlineState_ = writeDeadlineState_;
+      cb = pooled;
+    }
+    auto flags = addZeroCopyFlags(ctx->getWriteFlags(), *buf);
+    flags = addTxTimestampFlags(flags, *buf);
+    sdtSocketFlush(*buf);
+    socket_->writeChain(cb, std::move(buf), flags);
+    return FastWriteResult::DONE;
+  }
+
+  /**
+   * Merge write chains arriving within the same event loop iteration into a
+   * single writeChain() call with one shared callback. Unlike
+   * OutputBufferingHandler, which buffers above the codecs until the loop
+   * runs, this corks at the socket, so interleaved writes from several
+   * upstream handlers still collapse into one write request.
+   */
+  void setCorkWrites(bool cork) {
+    corkWrites_ = cork;
+  }
+
+  const CorkStats& getCorkStats() const {
+    return corkStats_;
+  }
+
+  /**
+   * How write-completion callbacks were stored. Sequential writes reuse
+   * the handler's inline slots, so a steadily loaded connection shows
+   * inlineCallbacks growing and heapCallbacks flat; heapCallbacks
+   * climbing means the connection regularly has more writes in flight
+   * than slots.
+   */
+  const WriteCallbackStats& getWriteCallbackStats() const {
+    return writeCallbackStats_;
+  }
+
+  /**
+   * Number of times the pipeline's write deadline expired on this
+   * connection and tore it down. The deadline itself is configured with
+   * PipelineBase::setWriteDeadline(); zero there (the default) disables
+   * enforcement and leaves this counter at zero.
+   */
+  uint64_t getWriteDeadlineExpirations() const {
+    return writeDeadlineExpirations_;
+  }
+
+  /**
+   * Schedules the write deadline timer on the given manager instead of
+   * the socket's EventBase, and setClock() substitutes the time source
+   * the deadline ages writes against. Test seams: the simulation
+   * harness in wangle/test/Simulation.h supplies both so deadline
+   * behavior runs on virtual time.
+   */
+  void setTimeoutManager(folly::TimeoutManager* timeoutManager) {
+    timeoutManager_ = timeoutManager;
+  }
+
+  void setClock(
+      folly::Function<std::chrono::steady_clock::time_point()> clock) {
+    clock_ = std::move(clock);
+  }
+
+  /**
+   * Request MSG_ZEROCOPY sends for write chains of at least thresholdBytes.
+   * Shorter chains keep the copying path, which is cheaper than pinning
+   * pages for small writes. Takes effect only when the transport is (or
+   * wraps) a folly::AsyncSocket and the kernel accepts SO_ZEROCOPY; the
+   * socket retains the IOBuf chain until the kernel's completion
+   * notification arrives, so buffers handed to write() are never recycled
+   * while the NIC may still reference them. If the kernel later refuses
+   * zero-copy the socket reverts to copying, recorded in the stats as a
+   * fallback. Pass 0 to disable.
+   */
+  void setZeroCopyWrites(uint64_t thresholdBytes) {
+    zeroCopyThreshold_ = thresholdBytes;
+    zeroCopySock_ = nullptr;
+    if (thresholdBytes > 0 && socket_) {
+      auto sock = socket_->getUnderlyingTransport<folly::AsyncSocket>();
+      if (sock && sock->setZeroCopy(true)) {
+        zeroCopySock_ = sock;
+      }
+    }
+  }
+
+  bool isZeroCopyEnabled() const {
+    return zeroCopySock_ != nullptr;
+  }
+
+  const ZeroCopyStats& getZeroCopyStats() const {
+    return zeroCopyStats_;
+  }
+
+  /**
+   * Sample one in sampleEvery writes for kernel TX timestamping
+   * (SO_TIMESTAMPING). A sampled write is tagged with TIMESTAMP_TX;
+   * the kernel reports when its last byte left the host (hardware
+   * timestamped where the NIC supports it, software otherwise) and
+   * the socket surfaces it as a byte event. The time from write
+   * submission to that completion — the kernel and NIC queueing that
+   * app-side timing cannot see — is recorded in getTxLatencyStats().
+   * Takes effect only when the transport is (or wraps) a
+   * folly::AsyncSocket; if the kernel cannot deliver timestamps the
+   * sampling stops and the stats freeze. Pass 0 to disable.
+   */
+  void enableTxTimestamping(uint32_t sampleEvery) {
+    txSampleEvery_ = sampleEvery;
+    if (sampleEvery == 0 || txObserver_) {
+      return;
+    }
+    auto* sock = socket_
+        ? socket_->getUnderlyingTransport<folly::AsyncSocket>()
+        : nullptr;
+    if (!sock) {
+      txSampleEvery_ = 0;
+      return;
+    }
+    txObserver_ = std::make_unique<TxTimestampObserver>(this);
+    sock->addLifecycleObserver(txObserver_.get());
+    txSock_ = sock;
+  }
+
+  const TxLatencyStats& getTxLatencyStats() const {
+    return txLatencyStats_;
+  }
+
+  /**
+   * Configure egress buffer watermarks, in bytes buffered in the transport.
+   * Once more than highWatermark bytes are buffered, transportUnwritable
+   * fires inbound through the pipeline; once the buffer drains back to at
+   * or below lowWatermark, transportWritable fires. A highWatermark of 0
+   * (the default) disables both events.
+   *
+   * The watermarks are driven by the socket's buffer callback, so they only
+   * take effect when the transport is (or wraps) a folly::AsyncSocket.
+   * Drain past a non-zero lowWatermark is observed when the buffer empties
+   * completely or at the next write that buffers, whichever comes first.
+   */
+  void setWriteWatermarks(uint64_t highWatermark, uint64_t lowWatermark) {
+    writeHighWatermark_ = highWatermark;
+    writeLowWatermark_ = std::min(lowWatermark, highWatermark);
+    attachBufferCallback();
+  }
+
+  /**
+   * Size read allocations from observed read sizes instead of the
+   * pipeline's fixed readBufferSettings. The allocation starts at
+   * minSize; a read that fills it doubles the next one (up to maxSize),
+   * and two consecutive reads at or below a quarter of it halve it
+   * (down to minSize). Mostly-idle connections then settle at minSize
+   * while bulk streams grow until a read no longer fills the buffer,
+   * instead of every connection paying one fixed-size allocation and
+   * read callback per readBufferSettings chunk. minSize must be
+   * non-zero and no greater than maxSize. Pass maxSize 0 to disable.
+   */
+  void setAdaptiveReadBuffer(uint64_t minSize, uint64_t maxSize) {
+    if (maxSize == 0) {
+      adaptiveReadMin_ = 0;
+      adaptiveReadMax_ = 0;
+      return;
+    }
+    CHECK_GT(minSize, 0);
+    CHECK_LE(minSize, maxSize);
+    adaptiveReadMin_ = minSize;
+    adaptiveReadMax_ = maxSize;
+    adaptiveReadSize_ = minSize;
+    adaptiveShrinkPending_ = false;
+  }
+
+  uint64_t getAdaptiveReadSize() const {
+    return adaptiveReadSize_;
+  }
+
+  /**
+   * Serve read buffers from a recycling pool instead of fresh IOBuf
+   * allocations. Each read event gets a pooled buffer (sized by the
+   * adaptive read size when enabled, otherwise by the pipeline's
+   * readBufferSettings allocation size) whose storage returns to the
+   * pool when the last downstream reference drops. The pool must
+   * outlive every buffer read through it; the intended usage is one
+   * pool per EventBase (ReadBufferPool::getThreadLocal()). Pass nullptr
+   * to go back to plain allocation.
+   */
+  void setReadBufferPool(ReadBufferPool* pool) {
+    readBufferPool_ = pool;
+  }
+
+  /**
+   * Take reads as transport-owned IOBufs moved straight into the
+   * pipeline instead of copies into handler-provided buffers. When
+   * enabled the handler reports isBufferMovable() to the transport,
+   * which then allocates (or, on zero-copy RX capable transports,
+   * receives) the buffer itself and hands ownership over through
+   * readBufferAvailable() — the getReadBuffer()/readDataAvailable()
+   * copy disappears entirely. The adaptive read size, when configured,
+   * still steers how much the transport reads per event via
+   * maxBufferSize(); the read buffer pool does not apply, since the
+   * transport owns allocation on this path.
+   */
+  void setBufferMovableReads(bool enabled) {
+    bufferMovableReads_ = enabled;
+  }
+
+  /**
+   * Number of read events delivered as moved transport-owned buffers
+   * rather than copies. Flat while setBufferMovableReads(true) is set
+   * means the transport does not support handing buffers over and
+   * reads kept the copying contract.
+   */
+  uint64_t getMovedReadBuffers() const {
+    return movedReadBuffers_;
+  }
+
+  void runLoopCallback() noexcept override {
+    flushCorkedWrites();
+  }
+
   folly::Future<folly::Unit> writeException(
       Context* ctx,
       folly::exception_wrapper) override {
@@ -130,6 +450,83 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
     }
   }
 
+  /**
+   * Deliver well-known transport errors (connection reset, timed out,
+   * ...) through the pipeline's readError(TransportErrorCode) path
+   * instead of synthesizing an AsyncSocketException per occurrence.
+   * Connection deaths then cost an enum hop through the pipeline with
+   * no allocation; errors with no code mapping keep the
+   * readException() path either way. Off by default, because handlers
+   * that only override readException() never see mapped errors once
+   * this is on.
+   */
+  void setCheapTransportErrors(bool enabled) {
+    cheapTransportErrors_ = enabled;
+  }
+
+  /**
+   * The TransportErrorCode for an AsyncSocketException, or UNKNOWN
+   * when it has no mapping.
+   */
+  static TransportErrorCode transportErrorCode(
+      const folly::AsyncSocketException& ex) {
+    switch (ex.getErrno()) {
+      case ECONNRESET:
+        return TransportErrorCode::CONNECTION_RESET;
+      case ECONNABORTED:
+        return TransportErrorCode::CONNECTION_ABORTED;
+      case ETIMEDOUT:
+        return TransportErrorCode::TIMED_OUT;
+      case EPIPE:
+        return TransportErrorCode::BROKEN_PIPE;
+      case EHOSTUNREACH:
+      case ENETUNREACH:
+        return TransportErrorCode::NETWORK_UNREACHABLE;
+      default:
+        break;
+    }
+    return ex.getType() == folly::AsyncSocketException::TIMED_OUT
+        ? TransportErrorCode::TIMED_OUT
+        : TransportErrorCode::UNKNOWN;
+  }
+
+  /**
+   * Synthesizes the exception a readError() code stands for, for the
+   * handlers that do need a real exception_wrapper (say, to fail a
+   * promise). This is the allocation the cheap delivery path defers.
+   */
+  static folly::exception_wrapper makeTransportException(
+      TransportErrorCode code) {
+    using TransportException = folly::AsyncSocketException;
+    switch (code) {
+      case TransportErrorCode::CONNECTION_RESET:
+        return folly::make_exception_wrapper<TransportException>(
+            TransportException::NETWORK_ERROR,
+            "connection reset by peer",
+            ECONNRESET);
+      case TransportErrorCode::CONNECTION_ABORTED:
+        return folly::make_exception_wrapper<TransportException>(
+            TransportException::NETWORK_ERROR,
+            "connection aborted",
+            ECONNABORTED);
+      case TransportErrorCode::TIMED_OUT:
+        return folly::make_exception_wrapper<TransportException>(
+            TransportException::TIMED_OUT, "transport timed out", ETIMEDOUT);
+      case TransportErrorCode::BROKEN_PIPE:
+        return folly::make_exception_wrapper<TransportException>(
+            TransportException::NETWORK_ERROR, "broken pipe", EPIPE);
+      case TransportErrorCode::NETWORK_UNREACHABLE:
+        return folly::make_exception_wrapper<TransportException>(
+            TransportException::NETWORK_ERROR,
+            "network unreachable",
+            ENETUNREACH);
+      case TransportErrorCode::UNKNOWN:
+        break;
+    }
+    return folly::make_exception_wrapper<TransportException>(
+        TransportException::UNKNOWN, "unknown transport error");
+  }
+
   // Must override to avoid warnings about hidden overloaded virtual due to
   // AsyncSocket::ReadCallback::readEOF()
   void readEOF(Context* ctx) override {
@@ -137,16 +534,63 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
   }
 
   void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
-    const auto readBufferSettings = getContext()->getReadBufferSettings();
-    const auto ret = bufQueue_.preallocate(
-        readBufferSettings.first, readBufferSettings.second);
+    if (readBufferPool_) {
+      const auto size = adaptiveReadMax_ > 0
+          ? adaptiveReadSize_
+          : getContext()->getReadBufferSettings().second;
+      if (!poolReadBuf_ || poolReadBuf_->tailroom() < size) {
+        poolReadBuf_ = readBufferPool_->allocate(size);
+      }
+      *bufReturn = poolReadBuf_->writableTail();
+      *lenReturn = poolReadBuf_->tailroom();
+      return;
+    }
+    std::pair<void*, uint64_t> ret;
+    if (adaptiveReadMax_ > 0) {
+      ret = bufQueue_.preallocate(adaptiveReadSize_, adaptiveReadSize_);
+    } else {
+      const auto readBufferSettings = getContext()->getReadBufferSettings();
+      ret = bufQueue_.preallocate(
+          readBufferSettings.first, readBufferSettings.second);
+    }
     *bufReturn = ret.first;
     *lenReturn = ret.second;
   }
 
   void readDataAvailable(size_t len) noexcept override {
     refreshTimeout();
-    bufQueue_.postallocate(len);
+    if (poolReadBuf_) {
+      poolReadBuf_->append(len);
+      bufQueue_.append(std::move(poolReadBuf_));
+    } else {
+      bufQueue_.postallocate(len);
+    }
+    if (adaptiveReadMax_ > 0) {
+      adaptReadSize(len);
+    }
+    getContext()->fireRead(bufQueue_);
+  }
+
+  bool isBufferMovable() noexcept override {
+    return bufferMovableReads_;
+  }
+
+  size_t maxBufferSize() const override {
+    if (adaptiveReadMax_ > 0) {
+      return adaptiveReadSize_;
+    }
+    return movableReadCap_;
+  }
+
+  void readBufferAvailable(
+      std::unique_ptr<folly::IOBuf> buf) noexcept override {
+    refreshTimeout();
+    const auto len = buf->computeChainDataLength();
+    movedReadBuffers_++;
+    bufQueue_.append(std::move(buf));
+    if (adaptiveReadMax_ > 0) {
+      adaptReadSize(len);
+    }
     getContext()->fireRead(bufQueue_);
   }
 
@@ -155,11 +599,213 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
   }
 
   void readErr(const folly::AsyncSocketException& ex) noexcept override {
+    if (cheapTransportErrors_) {
+      const auto code = transportErrorCode(ex);
+      if (code != TransportErrorCode::UNKNOWN) {
+        getContext()->fireReadError(code);
+        return;
+      }
+    }
     getContext()->fireReadException(
         folly::make_exception_wrapper<folly::AsyncSocketException>(ex));
   }
 
  private:
+  void adaptReadSize(size_t len) {
+    if (len >= adaptiveReadSize_) {
+      // The read filled the buffer, so the socket likely had more
+      // pending; give the next read twice the room.
+      adaptiveReadSize_ = std::min(adaptiveReadSize_ * 2, adaptiveReadMax_);
+      adaptiveShrinkPending_ = false;
+    } else if (len <= adaptiveReadSize_ / 4) {
+      // Shrink only on the second consecutive small read so a single
+      // short read in a bulk stream doesn't bounce the size around.
+      if (adaptiveShrinkPending_) {
+        adaptiveReadSize_ = std::max(adaptiveReadSize_ / 2, adaptiveReadMin_);
+        adaptiveShrinkPending_ = false;
+      } else {
+        adaptiveShrinkPending_ = true;
+      }
+    } else {
+      adaptiveShrinkPending_ = false;
+    }
+  }
+
+  void attachBufferCallback() {
+    // setBufferCallback only exists on AsyncSocket; the cached pointer also
+    // spares a dynamic_cast per buffered write in updateWritability().
+    bufferSock_ =
+        socket_ ? socket_->getUnderlyingTransport<folly::AsyncSocket>()
+                : nullptr;
+    if (bufferSock_) {
+      bufferSock_->setBufferCallback(writeHighWatermark_ > 0 ? this : nullptr);
+      if (writeHighWatermark_ == 0) {
+        bufferSock_ = nullptr;
+      }
+    }
+  }
+
+  // Deliberately not part of detachReadCallback: transportInactive doubles
+  // as a soft ingress pause (see ObservingHandler), and the watermark
+  // events must keep firing through a pause or an unwritable pipeline
+  // could never learn that the buffer drained.
+  void detachBufferCallback() {
+    if (bufferSock_) {
+      bufferSock_->setBufferCallback(nullptr);
+      bufferSock_ = nullptr;
+    }
+  }
+
+  // BufferCallback overrides
+  void onEgressBuffered() override {
+    updateWritability();
+  }
+
+  void onEgressBufferCleared() override {
+    updateWritability();
+  }
+
+  void updateWritability() {
+    auto ctx = getContext();
+    if (!ctx || !bufferSock_) {
+      return;
+    }
+    const auto buffered = bufferSock_->getAppBytesBuffered();
+    if (writable_) {
+      if (buffered > writeHighWatermark_) {
+        writable_ = false;
+        ctx->fireTransportUnwritable();
+      }
+    } else if (buffered <= writeLowWatermark_) {
+      writable_ = true;
+      ctx->fireTransportWritable();
+    }
+  }
+
+  // Listens for the socket's TX byte events on behalf of the handler.
+  class TxTimestampObserver : public folly::AsyncTransport::LifecycleObserver {
+   public:
+    explicit TxTimestampObserver(AsyncSocketHandler* handler)
+        : folly::AsyncTransport::LifecycleObserver(makeConfig()),
+          handler_(handler) {}
+
+    void observerAttach(folly::AsyncTransport*) noexcept override {}
+    void observerDetach(folly::AsyncTransport*) noexcept override {}
+    void destroy(folly::AsyncTransport*) noexcept override {}
+    void close(folly::AsyncTransport*) noexcept override {}
+
+    void byteEvent(
+        folly::AsyncTransport*,
+        const folly::AsyncTransport::ByteEvent& event) noexcept override {
+      handler_->onTxByteEvent(event);
+    }
+
+    void byteEventsUnavailable(
+        folly::AsyncTransport*,
+        const folly::AsyncSocketException&) noexcept override {
+      // The kernel cannot deliver TX timestamps on this socket; stop
+      // tagging writes.
+      handler_->txSampleEvery_ = 0;
+    }
+
+   private:
+    static Config makeConfig() {
+      Config config;
+      config.byteEvents = true;
+      return config;
+    }
+
+    AsyncSocketHandler* handler_;
+  };
+
+  folly::WriteFlags addTxTimestampFlags(
+      folly::WriteFlags flags,
+      const folly::IOBuf& buf) {
+    if (txSampleEvery_ == 0 || !txSock_) {
+      return flags;
+    }
+    if (++txWriteCounter_ < txSampleEvery_) {
+      return flags;
+    }
+    txWriteCounter_ = 0;
+    if (pendingTxSamples_.size() >= kMaxPendingTxSamples) {
+      // Completions are not coming back; recycle the oldest sample
+      // rather than growing without bound.
+      pendingTxSamples_.erase(pendingTxSamples_.begin());
+    }
+    pendingTxSamples_.push_back(
+        {txSock_->getAppBytesWritten() + buf.computeChainDataLength() - 1,
+         std::chrono::steady_clock::now()});
+    txLatencyStats_.sampledWrites++;
+    return flags | folly::WriteFlags::TIMESTAMP_TX;
+  }
+
+  void onTxByteEvent(const folly::AsyncTransport::ByteEvent& event) {
+    if (event.type != folly::AsyncTransport::ByteEvent::Type::TX) {
+      return;
+    }
+    for (auto it = pendingTxSamples_.begin(); it != pendingTxSamples_.end();
+         ++it) {
+      if (it->lastByteOffset == static_cast<uint64_t>(event.offset)) {
+        recordTxLatency(std::chrono::steady_clock::now() - it->submitTime);
+        pendingTxSamples_.erase(it);
+        return;
+      }
+    }
+  }
+
+  void recordTxLatency(std::chrono::steady_clock::duration elapsed) {
+    const auto us =
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count();
+    uint64_t v = us > 0 ? static_cast<uint64_t>(us) : 0;
+    txLatencyStats_.completedSamples++;
+    txLatencyStats_.maxLatencyUs = std::max(txLatencyStats_.maxLatencyUs, v);
+    size_t bucket = 0;
+    while (v > 0 && bucket + 1 < txLatencyStats_.latencyBucketsUs.size()) {
+      v >>= 1;
+      bucket++;
+    }
+    txLatencyStats_.latencyBucketsUs[bucket]++;
+  }
+
+  void detachTxObserver() {
+    if (txSock_ && txObserver_) {
+      txSock_->removeLifecycleObserver(txObserver_.get());
+    }
+    txSock_ = nullptr;
+  }
+
+  folly::WriteFlags addZeroCopyFlags(
+      folly::WriteFlags flags,
+      const folly::IOBuf& buf) {
+    if (zeroCopyThreshold_ == 0) {
+      return flags;
+    }
+    if (zeroCopySock_ && !zeroCopySock_->getZeroCopy()) {
+      // The kernel refused a zero-copy send and the socket reverted to
+      // copying; stop asking rather than re-arming every write.
+      zeroCopyStats_.fallbacks++;
+      zeroCopySock_ = nullptr;
+    }
+    if (zeroCopySock_ &&
+        buf.computeChainDataLength() >= zeroCopyThreshold_) {
+      zeroCopyStats_.zeroCopyWrites++;
+      return flags | folly::WriteFlags::WRITE_MSG_ZEROCOPY;
+    }
+    zeroCopyStats_.copiedWrites++;
+    return flags;
+  }
+
+  // USDT probe covering every chain handed to the socket; the chain
+  // length is only computed while a tracer is attached.
+  void sdtSocketFlush(const folly::IOBuf& buf) {
+    if (WANGLE_SDT_ENABLED(socket_flush)) {
+      WANGLE_SDT_WITH_SEMAPHORE(
+          socket_flush, socket_.get(), buf.computeChainDataLength());
+    }
+  }
+
   void refreshTimeout() {
     auto manager = getContext()->getPipeline()->getPipelineManager();
     if (manager) {
@@ -167,8 +813,117 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
     }
   }
 
+  void appendCorked(Context* ctx, std::unique_ptr<folly::IOBuf> buf) {
+    corkedWriteFlags_ = ctx->getWriteFlags();
+    if (!corkedWrites_) {
+      DCHECK(!isLoopCallbackScheduled());
+      corkedWrites_ = std::move(buf);
+      socket_->getEventBase()->runInLoop(this);
+    } else {
+      DCHECK(isLoopCallbackScheduled());
+      corkStats_.writesCoalesced++;
+      corkedWrites_->prependChain(std::move(buf));
+    }
+  }
+
+  void flushCorkedWrites() {
+    if (!corkedWrites_) {
+      return;
+    }
+    corkStats_.flushes++;
+    corkStats_.buffersFlushed += corkedWrites_->countChainElements();
+    folly::AsyncTransport::WriteCallback* cb = nullptr;
+    if (!corkedWaiters_.empty() || writeDeadline_.count() > 0) {
+      auto pooled = acquireWriteCallback();
+      pooled->waiters_ = std::move(corkedWaiters_);
+      corkedWaiters_.clear();
+      if (writeDeadline_.count() > 0) {
+        trackWriteDeadline();
+        pooled->deadlineState_ = writeDeadlineState_;
+      }
+      cb = pooled;
+    }
+    auto flags = addZeroCopyFlags(corkedWriteFlags_, *corkedWrites_);
+    flags = addTxTimestampFlags(flags, *corkedWrites_);
+    sdtSocketFlush(*corkedWrites_);
+    socket_->writeChain(cb, std::move(corkedWrites_), flags);
+  }
+
+  void failCorkedWrites(const folly::AsyncSocketException& ex) {
+    if (isLoopCallbackScheduled()) {
+      cancelLoopCallback();
+    }
+    corkedWrites_.reset();
+    for (auto& waiter : corkedWaiters_) {
+      waiter.setException(ex);
+    }
+    corkedWaiters_.clear();
+  }
+
+  std::chrono::steady_clock::time_point clockNow() {
+    return clock_ ? clock_() : std::chrono::steady_clock::now();
+  }
+
+  // One timer entry covers every outstanding write on this connection:
+  // it is armed for the oldest unacked write, re-armed for the next one
+  // when it fires early, instead of one wheel entry per write.
+  void trackWriteDeadline() {
+    if (!writeDeadlineState_) {
+      writeDeadlineState_ = std::make_shared<WriteDeadlineState>();
+    }
+    writeDeadlineState_->pending.push_back(clockNow());
+    if (!writeDeadlineTimer_) {
+      folly::TimeoutManager* manager =
+          timeoutManager_ ? timeoutManager_ : socket_->getEventBase();
+      writeDeadlineTimer_ = folly::AsyncTimeout::make(
+          *manager, [this]() noexcept { onWriteDeadline(); });
+    }
+    if (!writeDeadlineTimer_->isScheduled()) {
+      writeDeadlineTimer_->scheduleTimeout(writeDeadline_);
+    }
+  }
+
+  void onWriteDeadline() {
+    auto& pending = writeDeadlineState_->pending;
+    if (pending.empty() || writeDeadline_.count() == 0) {
+      return;
+    }
+    const auto age = clockNow() - pending.front();
+    if (age < writeDeadline_) {
+      // The write the timer was armed for completed in time; re-arm for
+      // the remainder of the oldest one still outstanding.
+      writeDeadlineTimer_->scheduleTimeout(
+          writeDeadline_ -
+          std::chrono::duration_cast<std::chrono::milliseconds>(age));
+      return;
+    }
+    writeDeadlineExpirations_++;
+    folly::AsyncSocketException ex(
+        folly::AsyncSocketException::AsyncSocketExceptionType::TIMED_OUT,
+        "write deadline exceeded");
+    failCorkedWrites(ex);
+    // Close before surfacing the error: closeNow() fails the writes still
+    // queued in the socket synchronously, so by the time the pipeline
+    // reacts nothing references this handler's callbacks anymore.
+    detachBufferCallback();
+    detachReadCallback();
+    socket_->closeNow();
+    auto ctx = getContext();
+    if (ctx) {
+      ctx->fireReadException(
+          folly::make_exception_wrapper<folly::AsyncSocketException>(ex));
+    }
+  }
+
   folly::Future<folly::Unit> shutdown(Context* ctx, bool closeWithReset) {
+    if (corkedWrites_ || !corkedWaiters_.empty()) {
+      // These never reached the socket, so closeNow() won't fail them.
+      failCorkedWrites(folly::AsyncSocketException(
+          folly::AsyncSocketException::AsyncSocketExceptionType::NOT_OPEN,
+          "socket closed with corked writes pending"));
+    }
     if (socket_) {
+      detachBufferCallback();
       detachReadCallback();
       if (closeWithReset) {
         socket_->closeWithReset();
@@ -183,28 +938,158 @@ class AsyncSocketHandler : public wangle::BytesToBytesHandler,
     return folly::makeFuture();
   }
 
-  class WriteCallback : private folly::AsyncTransport::WriteCallback {
+  // Shared between the handler and its in-flight write callbacks, so a
+  // completion arriving after the handler is gone has nothing to dangle
+  // on. The socket completes writes in order, so each completion retires
+  // the front entry.
+  struct WriteDeadlineState {
+    // Enqueue time of each chain handed to the socket, oldest first.
+    std::deque<std::chrono::steady_clock::time_point> pending;
+
+    void onWriteComplete() {
+      if (!pending.empty()) {
+        pending.pop_front();
+      }
+    }
+  };
+
+  using CorkedWaiters = folly::small_vector<folly::Promise<folly::Unit>, 8>;
+
+  struct WriteCallbackSlab;
+
+  // Write-completion callback occupying a slot in the handler's inline
+  // slab, or heap-allocated when more writes are in flight than slots.
+  // One type serves every write path: futureful writes carry a promise,
+  // corked flushes carry the batch's waiters, and deadline-only
+  // writeFast() completions carry neither.
+  class PooledWriteCallback : private folly::AsyncTransport::WriteCallback {
     void writeSuccess() noexcept override {
-      promise_.setValue();
-      delete this;
+      complete(nullptr);
     }
 
     void writeErr(
         size_t /* bytesWritten */,
         const folly::AsyncSocketException& ex) noexcept override {
-      promise_.setException(ex);
-      delete this;
+      complete(&ex);
+    }
+
+    void complete(const folly::AsyncSocketException* ex) noexcept {
+      if (deadlineState_) {
+        deadlineState_->onWriteComplete();
+        deadlineState_.reset();
+      }
+      if (promise_) {
+        ex ? promise_->setException(*ex) : promise_->setValue();
+        promise_.reset();
+      }
+      for (auto& waiter : waiters_) {
+        ex ? waiter.setException(*ex) : waiter.setValue();
+      }
+      waiters_.clear();
+      if (slab_) {
+        // Completions run on the socket's EventBase like acquisitions,
+        // so the free mask needs no synchronization. Holding the slab
+        // reference here keeps the slot's storage alive even when the
+        // handler was destroyed with this write still in flight.
+        auto slab = std::move(slab_);
+        slab->freeMask |= static_cast<uint8_t>(1u << slotIndex_);
+      } else {
+        delete this;
+      }
     }
 
-   private:
     friend class AsyncSocketHandler;
-    folly::Promise<folly::Unit> promise_;
+    folly::Optional<folly::Promise<folly::Unit>> promise_;
+    std::shared_ptr<WriteDeadlineState> deadlineState_;
+    CorkedWaiters waiters_;
+    std::shared_ptr<WriteCallbackSlab> slab_;
+    uint8_t slotIndex_{0};
+  };
+
+  static constexpr size_t kInlineWriteCallbacks = 4;
+
+  // Fixed callback slots recycled across sequential writes, so steady
+  // request/response traffic completes writes without allocating.
+  // Heap-allocated once per handler and shared with each in-flight
+  // slot, so late completions always land in live storage.
+  struct WriteCallbackSlab {
+    std::array<PooledWriteCallback, kInlineWriteCallbacks> slots;
+    // Bit i set means slots[i] is free.
+    uint8_t freeMask{(1u << kInlineWriteCallbacks) - 1};
   };
 
+  PooledWriteCallback* acquireWriteCallback() {
+    if (!writeCallbackSlab_) {
+      writeCallbackSlab_ = std::make_shared<WriteCallbackSlab>();
+    }
+    auto& slab = *writeCallbackSlab_;
+    if (slab.freeMask == 0) {
+      writeCallbackStats_.heapCallbacks++;
+      return new PooledWriteCallback();
+    }
+    const size_t idx = folly::findFirstSet(slab.freeMask) - 1;
+    slab.freeMask &= static_cast<uint8_t>(~(1u << idx));
+    writeCallbackStats_.inlineCallbacks++;
+    auto* cb = &slab.slots[idx];
+    cb->slab_ = writeCallbackSlab_;
+    cb->slotIndex_ = static_cast<uint8_t>(idx);
+    return cb;
+  }
+
   folly::IOBufQueue bufQueue_{folly::IOBufQueue::cacheChainLength()};
+  ReadBufferPool* readBufferPool_{nullptr};
+  // The pooled buffer the socket is currently reading into.
+  std::unique_ptr<folly::IOBuf> poolReadBuf_;
+  uint64_t adaptiveReadMin_{0};
+  uint64_t adaptiveReadMax_{0};
+  uint64_t adaptiveReadSize_{0};
+  bool adaptiveShrinkPending_{false};
+  bool bufferMovableReads_{false};
+  // Per-event read cap for movable reads when adaptive sizing is off;
+  // refreshed from the pipeline's readBufferSettings on transportActive.
+  size_t movableReadCap_{65536};
+  uint64_t movedReadBuffers_{0};
   std::shared_ptr<folly::AsyncTransport> socket_{nullptr};
+  folly::AsyncSocket* bufferSock_{nullptr};
+  uint64_t writeHighWatermark_{0};
+  uint64_t writeLowWatermark_{0};
+  bool writable_{true};
   bool firedInactive_{false};
   bool pipelineDeleted_{false};
+  bool corkWrites_{false};
+  bool cheapTransportErrors_{false};
+  std::unique_ptr<folly::IOBuf> corkedWrites_;
+  CorkedWaiters corkedWaiters_;
+  folly::WriteFlags corkedWriteFlags_{folly::WriteFlags::NONE};
+  CorkStats corkStats_;
+  folly::AsyncSocket* zeroCopySock_{nullptr};
+  uint64_t zeroCopyThreshold_{0};
+  ZeroCopyStats zeroCopyStats_;
+  // Cached from the pipeline on each write; zero means no deadline.
+  std::chrono::milliseconds writeDeadline_{0};
+  std::shared_ptr<WriteDeadlineState> writeDeadlineState_;
+  std::unique_ptr<folly::AsyncTimeout> writeDeadlineTimer_;
+  uint64_t writeDeadlineExpirations_{0};
+  // Test seams; the socket's EventBase and the steady clock when unset.
+  folly::TimeoutManager* timeoutManager_{nullptr};
+  folly::Function<std::chrono::steady_clock::time_point()> clock_;
+  // Lazily created on the first write needing a callback.
+  std::shared_ptr<WriteCallbackSlab> writeCallbackSlab_;
+  WriteCallbackStats writeCallbackStats_;
+
+  struct PendingTxSample {
+    uint64_t lastByteOffset;
+    std::chrono::steady_clock::time_point submitTime;
+  };
+
+  static constexpr size_t kMaxPendingTxSamples = 64;
+
+  std::unique_ptr<TxTimestampObserver> txObserver_;
+  folly::AsyncSocket* txSock_{nullptr};
+  uint32_t txSampleEvery_{0};
+  uint32_t txWriteCounter_{0};
+  folly::small_vector<PendingTxSample, 4> pendingTxSamples_;
+  TxLatencyStats txLatencyStats_;
 };
 
 } // namespace wangle
@@ -16,36 +16,139 @@
 
 #pragma once
 
+#include <mutex>
+
 #include <folly/futures/Future.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/small_vector.h>
 #include <wangle/channel/Handler.h>
 
 namespace wangle {
 
+/*
+ * EventBaseHandler marshals writes and closes issued from other threads
+ * onto the transport's EventBase thread. Calls made on the EventBase
+ * thread itself go straight through with no queue hop.
+ *
+ * Cross-thread writes block the caller until the EventBase thread has
+ * run them. With setBatchCrossThreadWrites(true) they instead append to
+ * a pending chain and return immediately; the first write of a burst
+ * schedules a single EventBase hop that flushes the whole chain with one
+ * downstream write, so a batch of responses costs one wakeup instead of
+ * one per response. Batched futures complete on the EventBase thread.
+ *
+ * This handler may only be used in a single Pipeline.
+ */
 class EventBaseHandler : public OutboundBytesToBytesHandler {
  public:
   folly::Future<folly::Unit> write(
       Context* ctx,
       std::unique_ptr<folly::IOBuf> buf) override {
+    DCHECK(ctx->getTransportRaw());
+    auto* evb = ctx->getTransportRaw()->getEventBase();
+    DCHECK(evb);
+    if (evb->isInEventBaseThread()) {
+      return ctx->fireWrite(std::move(buf));
+    }
+    if (batchCrossThreadWrites_) {
+      return enqueueWrite(ctx, evb, std::move(buf));
+    }
     folly::Future<folly::Unit> retval;
-    DCHECK(ctx->getTransport());
-    DCHECK(ctx->getTransport()->getEventBase());
-    ctx->getTransport()
-        ->getEventBase()
-        ->runImmediatelyOrRunInEventBaseThreadAndWait(
-            [&]() { retval = ctx->fireWrite(std::move(buf)); });
+    evb->runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&]() { retval = ctx->fireWrite(std::move(buf)); });
     return retval;
   }
 
+  FastWriteResult writeFast(Context* ctx, std::unique_ptr<folly::IOBuf>& buf)
+      override {
+    DCHECK(ctx->getTransportRaw());
+    auto* evb = ctx->getTransportRaw()->getEventBase();
+    DCHECK(evb);
+    if (evb->isInEventBaseThread()) {
+      return ctx->fireWriteFast(buf);
+    }
+    return FastWriteResult::UNSUPPORTED;
+  }
+
   folly::Future<folly::Unit> close(Context* ctx) override {
-    DCHECK(ctx->getTransport());
-    DCHECK(ctx->getTransport()->getEventBase());
+    DCHECK(ctx->getTransportRaw());
+    auto* evb = ctx->getTransportRaw()->getEventBase();
+    DCHECK(evb);
+    if (evb->isInEventBaseThread()) {
+      return ctx->fireClose();
+    }
     folly::Future<folly::Unit> retval;
-    ctx->getTransport()
-        ->getEventBase()
-        ->runImmediatelyOrRunInEventBaseThreadAndWait(
-            [&]() { retval = ctx->fireClose(); });
+    evb->runImmediatelyOrRunInEventBaseThreadAndWait(
+        [&]() { retval = ctx->fireClose(); });
     return retval;
   }
+
+  /**
+   * Coalesce cross-thread writes into one EventBase hop per burst
+   * instead of blocking each caller for a round trip. Set before the
+   * pipeline carries traffic. Writes still reach the transport in the
+   * order they were enqueued.
+   */
+  void setBatchCrossThreadWrites(bool batch) {
+    batchCrossThreadWrites_ = batch;
+  }
+
+ private:
+  using Waiters = folly::small_vector<folly::Promise<folly::Unit>, 8>;
+
+  folly::Future<folly::Unit> enqueueWrite(
+      Context* ctx,
+      folly::EventBase* evb,
+      std::unique_ptr<folly::IOBuf> buf) {
+    bool schedule;
+    folly::Future<folly::Unit> future;
+    {
+      std::lock_guard<std::mutex> guard(pendingLock_);
+      schedule = (pendingWrites_ == nullptr);
+      if (pendingWrites_) {
+        pendingWrites_->prependChain(std::move(buf));
+      } else {
+        pendingWrites_ = std::move(buf);
+      }
+      pendingWaiters_.emplace_back();
+      future = pendingWaiters_.back().getFuture();
+    }
+    if (schedule) {
+      // The pipeline shared_ptr keeps the context (and this handler, when
+      // pipeline-owned) alive until the flush has run.
+      evb->runInEventBaseThread(
+          [this, ctx, pipeline = ctx->getPipelineShared()] {
+            drainPendingWrites(ctx);
+          });
+    }
+    return future;
+  }
+
+  void drainPendingWrites(Context* ctx) {
+    std::unique_ptr<folly::IOBuf> sends;
+    Waiters waiters;
+    {
+      std::lock_guard<std::mutex> guard(pendingLock_);
+      sends = std::move(pendingWrites_);
+      std::swap(waiters, pendingWaiters_);
+    }
+    if (!sends) {
+      return;
+    }
+    ctx->fireWrite(std::move(sends))
+        .thenTry([waiters = std::move(waiters)](
+                     folly::Try<folly::Unit> t) mutable {
+          for (auto& waiter : waiters) {
+            waiter.setTry(folly::Try<folly::Unit>(t));
+          }
+        });
+  }
+
+  bool batchCrossThreadWrites_{false};
+  std::mutex pendingLock_;
+  std::unique_ptr<folly::IOBuf> pendingWrites_;
+  Waiters pendingWaiters_;
 };
 
 } // namespace wangle
@@ -16,7 +16,9 @@
 
 #include <wangle/channel/FileRegion.h>
 
-#ifdef SPLICE_F_NONBLOCK
+#include <folly/io/async/AsyncSSLSocket.h>
+#include <folly/portability/Unistd.h>
+
 using namespace folly;
 
 namespace {
@@ -29,10 +31,233 @@ Singleton<IOThreadPoolExecutor, FileRegionReadPool> readPool([] {
       std::make_shared<NamedThreadFactory>("FileRegionReadPool"));
 });
 
+#ifdef SPLICE_F_NONBLOCK
+
+#ifdef __GLIBC__
+#if (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 9))
+#define GLIBC_AT_LEAST_2_9 1
+#endif
+#endif
+
+#ifdef GLIBC_AT_LEAST_2_9
+// Pipe pairs are pooled across transfers: on high-QPS file tiers the
+// per-request pipe2/F_SETPIPE_SZ/close churn is measurable. Only fully
+// drained pipes are returned to the pool.
+class PipePool {
+ public:
+  ~PipePool() {
+    for (auto& p : pipes_) {
+      ::close(p.first);
+      ::close(p.second);
+    }
+  }
+
+  // Fills in {readFd, writeFd}, creating a pair on pool miss.
+  bool get(int& readFd, int& writeFd) {
+    {
+      std::lock_guard<std::mutex> lg(mutex_);
+      if (!pipes_.empty()) {
+        std::tie(readFd, writeFd) = pipes_.back();
+        pipes_.pop_back();
+        return true;
+      }
+    }
+    int fds[2];
+    if (::pipe2(fds, O_NONBLOCK) == -1) {
+      return false;
+    }
+#ifdef F_SETPIPE_SZ
+    // Max size for unprevileged processes as set in
+    // /proc/sys/fs/pipe-max-size. Ignore failures and just roll with it
+    // TODO maybe read max size from /proc?
+    fcntl(fds[0], F_SETPIPE_SZ, 1048576);
+    fcntl(fds[1], F_SETPIPE_SZ, 1048576);
+#endif
+    readFd = fds[0];
+    writeFd = fds[1];
+    return true;
+  }
+
+  void put(int readFd, int writeFd) {
+    {
+      std::lock_guard<std::mutex> lg(mutex_);
+      if (pipes_.size() < kMaxPooled) {
+        pipes_.emplace_back(readFd, writeFd);
+        return;
+      }
+    }
+    ::close(readFd);
+    ::close(writeFd);
+  }
+
+ private:
+  static constexpr size_t kMaxPooled = 64;
+  std::mutex mutex_;
+  std::vector<std::pair<int, int>> pipes_;
+};
+
+struct FileRegionPipePool {};
+
+Singleton<PipePool, FileRegionPipePool> pipePool;
+#endif // GLIBC_AT_LEAST_2_9
+
+#endif // SPLICE_F_NONBLOCK
+
 } // namespace
 
 namespace wangle {
 
+Future<Unit> FileRegion::transferTo(
+    std::shared_ptr<AsyncTransport> transport) {
+  if (count_ == 0) {
+    return makeFuture();
+  }
+#ifdef SPLICE_F_NONBLOCK
+  // Zero-copy fast path for plain TCP sockets. SSL sockets must not
+  // take it: splicing into the raw fd would bypass the TLS layer.
+  auto socket = std::dynamic_pointer_cast<AsyncSocket>(transport);
+  if (socket && !std::dynamic_pointer_cast<AsyncSSLSocket>(transport)) {
+    auto cb = WriteCallback::acquire();
+    auto f = cb->promise_.getFuture();
+    auto req = new FileWriteRequest(socket.get(), cb, fd_, offset_, count_);
+    socket->writeRequest(req);
+    return f;
+  }
+#endif
+  return transferToBuffered(std::move(transport));
+}
+
+Future<Unit> FileRegion::transferToBuffered(
+    std::shared_ptr<AsyncTransport> transport) {
+  if (count_ == 0) {
+    return makeFuture();
+  }
+  auto transfer =
+      new BufferedTransfer(std::move(transport), fd_, offset_, count_);
+  return transfer->start();
+}
+
+FileRegion::BufferedTransfer::BufferedTransfer(
+    std::shared_ptr<AsyncTransport> transport,
+    int fd,
+    off_t offset,
+    size_t count)
+    : transport_(std::move(transport)),
+      fd_(fd),
+      offset_(offset),
+      remaining_(count) {}
+
+Future<Unit> FileRegion::BufferedTransfer::start() {
+  auto f = promise_.getFuture();
+  readBase_ = readPool.try_get()->getEventBase();
+  readBase_->runInEventBaseThread([this] { readChunk(); });
+  return f;
+}
+
+void FileRegion::BufferedTransfer::readChunk() noexcept {
+  const size_t len = std::min(remaining_, kChunkSize);
+  auto chunk = IOBuf::create(len);
+  size_t bytesRead = 0;
+  while (bytesRead < len) {
+    ssize_t rc = ::pread(fd_, chunk->writableTail(), len - bytesRead, offset_);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fail(AsyncSocketException(
+          AsyncSocketException::INTERNAL_ERROR, "pread failed", errno));
+      return;
+    }
+    if (rc == 0) {
+      fail(AsyncSocketException(
+          AsyncSocketException::BAD_ARGS, "file shorter than region"));
+      return;
+    }
+    chunk->append(rc);
+    offset_ += rc;
+    bytesRead += rc;
+  }
+  remaining_ -= bytesRead;
+  transport_->getEventBase()->runInEventBaseThread(
+      [this, buf = std::move(chunk)]() mutable {
+        transport_->writeChain(this, std::move(buf));
+      });
+}
+
+void FileRegion::BufferedTransfer::writeSuccess() noexcept {
+  if (remaining_ == 0) {
+    promise_.setValue();
+    delete this;
+    return;
+  }
+  readBase_->runInEventBaseThread([this] { readChunk(); });
+}
+
+void FileRegion::BufferedTransfer::writeErr(
+    size_t /* bytesWritten */,
+    const AsyncSocketException& ex) noexcept {
+  promise_.setException(ex);
+  delete this;
+}
+
+void FileRegion::BufferedTransfer::fail(const AsyncSocketException& ex) {
+  promise_.setException(ex);
+  delete this;
+}
+
+#ifdef SPLICE_F_NONBLOCK
+
+namespace {
+constexpr size_t kMaxPooledCallbacks = 64;
+} // namespace
+
+folly::Synchronized<std::vector<FileRegion::WriteCallback*>>&
+FileRegion::WriteCallback::freelist() {
+  // Leaked so callbacks completing during static teardown can still
+  // recycle safely.
+  static auto* list = new folly::Synchronized<std::vector<WriteCallback*>>();
+  return *list;
+}
+
+FileRegion::WriteCallback* FileRegion::WriteCallback::acquire() {
+  WriteCallback* cb = nullptr;
+  {
+    auto list = freelist().wlock();
+    if (!list->empty()) {
+      cb = list->back();
+      list->pop_back();
+    }
+  }
+  if (!cb) {
+    return new WriteCallback();
+  }
+  cb->promise_ = folly::Promise<folly::Unit>();
+  return cb;
+}
+
+void FileRegion::WriteCallback::writeSuccess() noexcept {
+  promise_.setValue();
+  recycle();
+}
+
+void FileRegion::WriteCallback::writeErr(
+    size_t /* bytesWritten */,
+    const AsyncSocketException& ex) noexcept {
+  promise_.setException(ex);
+  recycle();
+}
+
+void FileRegion::WriteCallback::recycle() noexcept {
+  {
+    auto list = freelist().wlock();
+    if (list->size() < kMaxPooledCallbacks) {
+      list->push_back(this);
+      return;
+    }
+  }
+  delete this;
+}
+
 FileRegion::FileWriteRequest::FileWriteRequest(
     AsyncSocket* socket,
     WriteCallback* callback,
@@ -90,12 +315,6 @@ void FileRegion::FileWriteRequest::messageAvailable(size_t&& count) noexcept {
   }
 }
 
-#ifdef __GLIBC__
-#if (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 9))
-#define GLIBC_AT_LEAST_2_9 1
-#endif
-#endif
-
 void FileRegion::FileWriteRequest::start() {
   started_ = true;
   readBase_ = readPool.try_get()->getEventBase();
@@ -128,8 +347,8 @@ void FileRegion::FileWriteRequest::start() {
             "writeFile unsupported on glibc < 2.9"));
     return;
 #else
-    int pipeFds[2];
-    if (::pipe2(pipeFds, O_NONBLOCK) == -1) {
+    auto pool = pipePool.try_get();
+    if (!pool || !pool->get(pipe_out_, pipe_in_)) {
       fail(
           __func__,
           AsyncSocketException(
@@ -137,31 +356,33 @@ void FileRegion::FileWriteRequest::start() {
       return;
     }
 
-#ifdef F_SETPIPE_SZ
-    // Max size for unprevileged processes as set in /proc/sys/fs/pipe-max-size
-    // Ignore failures and just roll with it
-    // TODO maybe read max size from /proc?
-    fcntl(pipeFds[0], F_SETPIPE_SZ, 1048576);
-    fcntl(pipeFds[1], F_SETPIPE_SZ, 1048576);
-#endif
-
-    pipe_out_ = pipeFds[0];
-
     socket_->getEventBase()->runInEventBaseThreadAndWait(
         [&] { startConsuming(socket_->getEventBase(), &queue_); });
-    readHandler_ = std::make_unique<FileReadHandler>(this, pipeFds[1], count_);
+    readHandler_ = std::make_unique<FileReadHandler>(this, pipe_in_, count_);
 #endif
   });
 }
 
 FileRegion::FileWriteRequest::~FileWriteRequest() {
   CHECK(readBase_->isInEventBaseThread());
-  socket_->getEventBase()->runInEventBaseThreadAndWait([&] {
-    stopConsuming();
-    if (pipe_out_ > -1) {
-      ::close(pipe_out_);
+  readHandler_.reset();
+  socket_->getEventBase()->runInEventBaseThreadAndWait([&] { stopConsuming(); });
+  if (pipe_out_ > -1) {
+#ifdef GLIBC_AT_LEAST_2_9
+    // A fully drained pipe goes back to the pool for the next transfer;
+    // one with leftover bytes (failed or aborted transfer) cannot be
+    // reused.
+    auto pool = pipePool.try_get();
+    if (pool && totalBytesWritten_ == count_ && bytesInPipe_ == 0) {
+      pool->put(pipe_out_, pipe_in_);
+      return;
     }
-  });
+#endif
+    ::close(pipe_out_);
+    if (pipe_in_ > -1) {
+      ::close(pipe_in_);
+    }
+  }
 }
 
 void FileRegion::FileWriteRequest::fail(
@@ -189,7 +410,7 @@ FileRegion::FileWriteRequest::FileReadHandler::FileReadHandler(
 FileRegion::FileWriteRequest::FileReadHandler::~FileReadHandler() {
   CHECK(req_->readBase_->isInEventBaseThread());
   unregisterHandler();
-  ::close(pipe_in_);
+  // pipe_in_ is owned by the request, which closes or pools it.
 }
 
 void FileRegion::FileWriteRequest::FileReadHandler::handlerReady(
@@ -229,5 +450,6 @@ void FileRegion::FileWriteRequest::FileReadHandler::handlerReady(
   }
 }
 
+#endif // SPLICE_F_NONBLOCK
+
 } // namespace wangle
-#endif
@@ -17,54 +17,108 @@
 #pragma once
 
 #include <folly/Singleton.h>
+#include <folly/Synchronized.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <folly/io/IOBuf.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/NotificationQueue.h>
 
-#ifdef SPLICE_F_NONBLOCK
 namespace wangle {
 
+/**
+ * A region of an open file to be written to a transport.
+ *
+ * Plain TCP sockets on Linux take a zero-copy path that splices the
+ * file through a pipe into the socket. Everything else — AsyncSSLSocket
+ * (splicing into the raw fd would bypass the TLS layer), non-Linux
+ * platforms — takes a buffered path: chunks are pread() on a background
+ * pool thread and written with writeChain(), one chunk in flight at a
+ * time, so TLS listeners can serve file responses and a large transfer
+ * never occupies the transport's EventBase for more than one chunk.
+ * With kernel TLS enabled on the socket, the buffered path's writes are
+ * encrypted in-kernel.
+ */
 class FileRegion {
  public:
-  FileRegion(int fd, loff_t offset, size_t count)
+  FileRegion(int fd, off_t offset, size_t count)
       : fd_(fd), offset_(offset), count_(count) {}
 
   folly::Future<folly::Unit> transferTo(
-      std::shared_ptr<folly::AsyncTransport> transport) {
-    auto socket = std::dynamic_pointer_cast<folly::AsyncSocket>(transport);
-    CHECK(socket);
-    auto cb = new WriteCallback();
-    auto f = cb->promise_.getFuture();
-    auto req = new FileWriteRequest(socket.get(), cb, fd_, offset_, count_);
-    socket->writeRequest(req);
-    return f;
-  }
+      std::shared_ptr<folly::AsyncTransport> transport);
+
+  // Forces the buffered pread() + writeChain() engine even where the
+  // splice fast path would apply.
+  folly::Future<folly::Unit> transferToBuffered(
+      std::shared_ptr<folly::AsyncTransport> transport);
 
  private:
-  class WriteCallback : private folly::AsyncSocket::WriteCallback {
-    void writeSuccess() noexcept override {
-      promise_.setValue();
-      delete this;
-    }
+  // One buffered transfer. Reads chunks on a pool thread and writes
+  // them on the transport's EventBase one at a time; owns itself and is
+  // deleted when the transfer completes or fails.
+  class BufferedTransfer : private folly::AsyncTransport::WriteCallback {
+   public:
+    BufferedTransfer(
+        std::shared_ptr<folly::AsyncTransport> transport,
+        int fd,
+        off_t offset,
+        size_t count);
+
+    folly::Future<folly::Unit> start();
+
+   private:
+    ~BufferedTransfer() override = default;
 
+    // Runs on the read pool thread.
+    void readChunk() noexcept;
+
+    // Run on the transport's EventBase thread.
+    void writeSuccess() noexcept override;
     void writeErr(
-        size_t /* bytesWritten */,
-        const folly::AsyncSocketException& ex) noexcept override {
-      promise_.setException(ex);
-      delete this;
-    }
+        size_t bytesWritten,
+        const folly::AsyncSocketException& ex) noexcept override;
 
-    friend class FileRegion;
+    void fail(const folly::AsyncSocketException& ex);
+
+    static constexpr size_t kChunkSize = 1 << 16; // 64 KB
+
+    const std::shared_ptr<folly::AsyncTransport> transport_;
+    const int fd_;
+    off_t offset_;
+    size_t remaining_;
+    folly::EventBase* readBase_{nullptr};
     folly::Promise<folly::Unit> promise_;
   };
 
   const int fd_;
-  const loff_t offset_;
+  const off_t offset_;
   const size_t count_;
 
+#ifdef SPLICE_F_NONBLOCK
+  // Completion callback for one splice transfer. Completed callbacks go
+  // back to a bounded process-wide freelist (like the pipe pairs, see
+  // FileRegion.cpp) instead of being allocated per transfer.
+  class WriteCallback : private folly::AsyncSocket::WriteCallback {
+    // Pops a recycled callback, armed with a fresh promise, or
+    // allocates one on freelist miss.
+    static WriteCallback* acquire();
+
+    void writeSuccess() noexcept override;
+    void writeErr(
+        size_t bytesWritten,
+        const folly::AsyncSocketException& ex) noexcept override;
+
+    // Refiles this under the freelist cap; deletes beyond it.
+    void recycle() noexcept;
+
+    static folly::Synchronized<std::vector<WriteCallback*>>& freelist();
+
+    friend class FileRegion;
+    folly::Promise<folly::Unit> promise_;
+  };
+
   class FileWriteRequest : public folly::AsyncSocket::WriteRequest,
                            public folly::NotificationQueue<size_t>::Consumer {
    public:
@@ -111,13 +165,14 @@ class FileRegion {
     const size_t count_;
     bool started_{false};
     int pipe_out_{-1};
+    int pipe_in_{-1};
 
     size_t bytesInPipe_{0};
     folly::EventBase* readBase_;
     folly::NotificationQueue<size_t> queue_;
     std::unique_ptr<FileReadHandler> readHandler_;
   };
+#endif
 };
 
 } // namespace wangle
-#endif
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <folly/small_vector.h>
+
+namespace wangle {
+
+/**
+ * Coalesces end-of-loop flushes across pipelines on one EventBase.
+ *
+ * Each OutputBufferingHandler normally schedules its own loop callback
+ * and flushes its own socket; with hundreds of pipelines producing
+ * responses in one loop iteration that is hundreds of callbacks and as
+ * many scattered writev calls. The coordinator registers a single loop
+ * callback per EventBase: participants mark themselves dirty as they
+ * buffer writes, and one end-of-loop pass flushes them back to back.
+ * That pass is also the one place where a transport capable of batched
+ * submission (sendmmsg, io_uring) could submit the whole set at once;
+ * through AsyncSocket each flush is still its own writev, just issued
+ * contiguously.
+ *
+ * One coordinator exists per EventBase, created on first use and torn
+ * down with the EventBase. All calls must be made on its thread.
+ */
+class FlushCoordinator : private folly::EventBase::LoopCallback {
+ public:
+  class Participant {
+   public:
+    virtual ~Participant() = default;
+    virtual void coordinatedFlush() noexcept = 0;
+  };
+
+  static FlushCoordinator& get(folly::EventBase* evb) {
+    static folly::EventBaseLocal<FlushCoordinator> storage;
+    return storage.getOrCreate(*evb, evb);
+  }
+
+  explicit FlushCoordinator(folly::EventBase* evb) : evb_(evb) {}
+
+  /**
+   * Queues a participant for the end-of-loop pass. Participants mark
+   * themselves once per iteration, on their first buffered write.
+   */
+  void markDirty(Participant* participant) {
+    dirty_.push_back(participant);
+    if (!isLoopCallbackScheduled()) {
+      evb_->runInLoop(this);
+    }
+  }
+
+  /**
+   * Drops a participant that flushed early or is being torn down before
+   * the end-of-loop pass runs.
+   */
+  void retract(Participant* participant) {
+    dirty_.erase(
+        std::remove(dirty_.begin(), dirty_.end(), participant), dirty_.end());
+  }
+
+  size_t dirtyCount() const {
+    return dirty_.size();
+  }
+
+ private:
+  void runLoopCallback() noexcept override {
+    // Swap the list out so participants going dirty again during the
+    // pass land in the next iteration's pass.
+    Participants dirty;
+    dirty.swap(dirty_);
+    for (auto* participant : dirty) {
+      participant->coordinatedFlush();
+    }
+  }
+
+  using Participants = folly::small_vector<Participant*, 16>;
+
+  folly::EventBase* evb_;
+  Participants dirty_;
+};
+
+} // namespace wangle
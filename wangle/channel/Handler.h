@@ -64,14 +64,36 @@ class Handler : public HandlerBase<HandlerContext<Rout, Wout>> {
   virtual void readException(Context* ctx, folly::exception_wrapper e) {
     ctx->fireReadException(std::move(e));
   }
+  // Allocation-free delivery of well-known transport errors; see
+  // TransportErrorCode and AsyncSocketHandler::setCheapTransportErrors.
+  virtual void readError(Context* ctx, TransportErrorCode code) {
+    ctx->fireReadError(code);
+  }
   virtual void transportActive(Context* ctx) {
     ctx->fireTransportActive();
   }
   virtual void transportInactive(Context* ctx) {
     ctx->fireTransportInactive();
   }
+  // Writability events flow inbound like transportActive: the transport
+  // handler reports its egress buffer crossing the configured watermarks
+  // so upstream producers can pause and resume. See
+  // AsyncSocketHandler::setWriteWatermarks.
+  virtual void transportWritable(Context* ctx) {
+    ctx->fireTransportWritable();
+  }
+  virtual void transportUnwritable(Context* ctx) {
+    ctx->fireTransportUnwritable();
+  }
 
   virtual folly::Future<folly::Unit> write(Context* ctx, Win msg) = 0;
+  // Synchronous fast path; handlers that can complete (or forward) a write
+  // without allocating a promise/future pair should override this. On
+  // UNSUPPORTED the message must be left intact so the caller can fall back
+  // to write(). See Pipeline::writeFast.
+  virtual FastWriteResult writeFast(Context* /*ctx*/, Win& /*msg*/) {
+    return FastWriteResult::UNSUPPORTED;
+  }
   virtual folly::Future<folly::Unit> writeException(
       Context* ctx,
       folly::exception_wrapper e) {
@@ -126,12 +148,21 @@ class InboundHandler : public HandlerBase<InboundHandlerContext<Rout>> {
   virtual void readException(Context* ctx, folly::exception_wrapper e) {
     ctx->fireReadException(std::move(e));
   }
+  virtual void readError(Context* ctx, TransportErrorCode code) {
+    ctx->fireReadError(code);
+  }
   virtual void transportActive(Context* ctx) {
     ctx->fireTransportActive();
   }
   virtual void transportInactive(Context* ctx) {
     ctx->fireTransportInactive();
   }
+  virtual void transportWritable(Context* ctx) {
+    ctx->fireTransportWritable();
+  }
+  virtual void transportUnwritable(Context* ctx) {
+    ctx->fireTransportUnwritable();
+  }
 };
 
 template <class Win, class Wout = Win>
@@ -147,6 +178,9 @@ class OutboundHandler : public HandlerBase<OutboundHandlerContext<Wout>> {
   ~OutboundHandler() override = default;
 
   virtual folly::Future<folly::Unit> write(Context* ctx, Win msg) = 0;
+  virtual FastWriteResult writeFast(Context* /*ctx*/, Win& /*msg*/) {
+    return FastWriteResult::UNSUPPORTED;
+  }
   virtual folly::Future<folly::Unit> writeException(
       Context* ctx,
       folly::exception_wrapper e) {
@@ -169,6 +203,10 @@ class HandlerAdapter : public Handler<R, R, W, W> {
   folly::Future<folly::Unit> write(Context* ctx, W msg) override {
     return ctx->fireWrite(std::forward<W>(msg));
   }
+
+  // Note: writeFast is deliberately not forwarded here. Subclasses commonly
+  // override write() with real logic, and an inherited pass-through fast
+  // path would silently skip it. Handlers opt in explicitly.
 };
 
 typedef HandlerAdapter<folly::IOBufQueue&, std::unique_ptr<folly::IOBuf>>
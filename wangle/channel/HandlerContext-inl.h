@@ -17,9 +17,25 @@
 #pragma once
 
 #include <folly/Format.h>
+#include <folly/Likely.h>
+#include <folly/chrono/Hardware.h>
 
 namespace wangle {
 
+/**
+ * Identity tag for a pipeline message type. Tags are distinct per type
+ * and stable for the life of the process, so context linking can ask
+ * "do you consume type T?" with a pointer compare instead of a
+ * dynamic_cast; see setNextIn/setNextOut below.
+ */
+using PipelineTypeId = const void*;
+
+template <class T>
+PipelineTypeId pipelineTypeId() {
+  static const char tag{};
+  return &tag;
+}
+
 class PipelineContext {
  public:
   virtual ~PipelineContext() = default;
@@ -27,6 +43,19 @@ class PipelineContext {
   virtual void attachPipeline() = 0;
   virtual void detachPipeline() = 0;
 
+  /**
+   * Type-tagged link recovery: returns this context's InboundLink<In>
+   * (resp. OutboundLink<Out>) as a void* when id matches that link's
+   * message type id, else nullptr. Callers static_cast back to the
+   * typed link, so linking a pipeline never touches RTTI.
+   */
+  virtual void* getInboundLink(PipelineTypeId /*id*/) {
+    return nullptr;
+  }
+  virtual void* getOutboundLink(PipelineTypeId /*id*/) {
+    return nullptr;
+  }
+
   template <class H, class HandlerContext>
   void attachContext(H* handler, HandlerContext* ctx) {
     if (++handler->attachCount_ == 1) {
@@ -57,8 +86,11 @@ class InboundLink {
   virtual void read(In msg) = 0;
   virtual void readEOF() = 0;
   virtual void readException(folly::exception_wrapper e) = 0;
+  virtual void readError(TransportErrorCode code) = 0;
   virtual void transportActive() = 0;
   virtual void transportInactive() = 0;
+  virtual void transportWritable() = 0;
+  virtual void transportUnwritable() = 0;
 };
 
 template <class Out>
@@ -66,11 +98,70 @@ class OutboundLink {
  public:
   virtual ~OutboundLink() = default;
   virtual folly::Future<folly::Unit> write(Out msg) = 0;
+  // Synchronous fast path; on UNSUPPORTED the message must be left intact so
+  // the caller can fall back to write().
+  virtual FastWriteResult writeFast(Out& /*msg*/) {
+    return FastWriteResult::UNSUPPORTED;
+  }
   virtual folly::Future<folly::Unit> writeException(
       folly::exception_wrapper e) = 0;
   virtual folly::Future<folly::Unit> close() = 0;
 };
 
+// Charges the elapsed cycles of one handler invocation to a stats entry.
+// Costs a single untaken branch per hop when the pipeline is not
+// instrumented (entry is null).
+class HandlerStatsGuard {
+ public:
+  explicit HandlerStatsGuard(HandlerStats* entry) : entry_(entry) {
+    if (UNLIKELY(entry_ != nullptr)) {
+      start_ = folly::hardware_timestamp();
+    }
+  }
+
+  ~HandlerStatsGuard() {
+    if (UNLIKELY(entry_ != nullptr)) {
+      entry_->record(folly::hardware_timestamp() - start_);
+    }
+  }
+
+ private:
+  HandlerStats* entry_;
+  uint64_t start_{0};
+};
+
+// Keeps the pipeline alive for the duration of one event dispatch, so
+// a handler that drops the last owning reference mid-event cannot free
+// the chain under its own stack frame. Shared pipelines promote the
+// context's weak_ptr (the historical guard); uniquely owned pipelines
+// (Pipeline::createUnique) have no control block and take the plain
+// borrow count instead, which is what makes their hops free of atomic
+// refcount traffic.
+template <class P>
+class PipelineEventGuard {
+ public:
+  PipelineEventGuard(const std::weak_ptr<PipelineBase>& pipelineWeak, P* raw)
+      : shared_(pipelineWeak.lock()), borrowed_(nullptr) {
+    if (!shared_ && raw && raw->isUniquelyOwned()) {
+      borrowed_ = raw;
+      borrowed_->addEventBorrow();
+    }
+  }
+
+  ~PipelineEventGuard() {
+    if (borrowed_) {
+      borrowed_->releaseEventBorrow();
+    }
+  }
+
+  PipelineEventGuard(const PipelineEventGuard&) = delete;
+  PipelineEventGuard& operator=(const PipelineEventGuard&) = delete;
+
+ private:
+  std::shared_ptr<PipelineBase> shared_;
+  P* borrowed_;
+};
+
 template <class H, class Context>
 class ContextImplBase : public PipelineContext {
  public:
@@ -81,16 +172,20 @@ class ContextImplBase : public PipelineContext {
   }
 
   void initialize(
-      std::weak_ptr<PipelineBase> pipeline,
+      PipelineBase* pipeline,
+      std::weak_ptr<PipelineBase> pipelineWeak,
       std::shared_ptr<H> handler) {
-    pipelineWeak_ = pipeline;
-    pipelineRaw_ = pipeline.lock().get();
+    pipelineWeak_ = std::move(pipelineWeak);
+    pipelineRaw_ = pipeline;
     handler_ = std::move(handler);
   }
 
   // PipelineContext overrides
   void attachPipeline() override {
     if (!attached_) {
+      if (auto* stats = pipelineRaw_->getPipelineStats()) {
+        statsEntry_ = stats->getEntry(typeid(*handler_));
+      }
       this->attachContext(handler_.get(), impl_);
       handler_->attachPipeline(impl_);
       attached_ = true;
@@ -100,6 +195,8 @@ class ContextImplBase : public PipelineContext {
   void detachPipeline() override {
     handler_->detachPipeline(impl_);
     attached_ = false;
+    statsEntry_ = nullptr;
+    stateSlot_.reset();
     this->detachContext(handler_.get(), impl_);
   }
 
@@ -108,7 +205,8 @@ class ContextImplBase : public PipelineContext {
       nextIn_ = nullptr;
       return;
     }
-    auto nextIn = dynamic_cast<InboundLink<typename H::rout>*>(ctx);
+    auto nextIn = static_cast<InboundLink<typename H::rout>*>(
+        ctx->getInboundLink(pipelineTypeId<typename H::rout>()));
     if (nextIn) {
       nextIn_ = nextIn;
     } else {
@@ -122,7 +220,8 @@ class ContextImplBase : public PipelineContext {
       nextOut_ = nullptr;
       return;
     }
-    auto nextOut = dynamic_cast<OutboundLink<typename H::wout>*>(ctx);
+    auto nextOut = static_cast<OutboundLink<typename H::wout>*>(
+        ctx->getOutboundLink(pipelineTypeId<typename H::wout>()));
     if (nextOut) {
       nextOut_ = nextOut;
     } else {
@@ -142,6 +241,10 @@ class ContextImplBase : public PipelineContext {
   std::shared_ptr<H> handler_;
   InboundLink<typename H::rout>* nextIn_{nullptr};
   OutboundLink<typename H::wout>* nextOut_{nullptr};
+  HandlerStats* statsEntry_{nullptr};
+  // Per-pipeline handler state; cleared on detach so a recycled context
+  // never leaks one connection's state into the next. See SharedHandler.h.
+  HandlerStateSlot stateSlot_;
 
  private:
   bool attached_{false};
@@ -161,11 +264,12 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
   typedef typename H::wout Wout;
   static const HandlerDir dir = HandlerDir::BOTH;
 
-  explicit ContextImpl(
-      std::weak_ptr<PipelineBase> pipeline,
+  ContextImpl(
+      PipelineBase* pipeline,
+      std::weak_ptr<PipelineBase> pipelineWeak,
       std::shared_ptr<H> handler) {
     this->impl_ = this;
-    this->initialize(pipeline, std::move(handler));
+    this->initialize(pipeline, std::move(pipelineWeak), std::move(handler));
   }
 
   // For StaticPipeline
@@ -175,9 +279,22 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
 
   ~ContextImpl() override = default;
 
+  // PipelineContext overrides
+  void* getInboundLink(PipelineTypeId id) override {
+    return id == pipelineTypeId<Rin>()
+        ? static_cast<void*>(static_cast<InboundLink<Rin>*>(this))
+        : nullptr;
+  }
+
+  void* getOutboundLink(PipelineTypeId id) override {
+    return id == pipelineTypeId<Win>()
+        ? static_cast<void*>(static_cast<OutboundLink<Win>*>(this))
+        : nullptr;
+  }
+
   // HandlerContext overrides
   void fireRead(Rout msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->read(std::forward<Rout>(msg));
     } else {
@@ -186,7 +303,7 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
   }
 
   void fireReadEOF() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->readEOF();
     } else {
@@ -195,7 +312,7 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
   }
 
   void fireReadException(folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->readException(std::move(e));
     } else {
@@ -203,22 +320,45 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
     }
   }
 
+  void fireReadError(TransportErrorCode code) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextIn_) {
+      this->nextIn_->readError(code);
+    } else {
+      LOG(WARNING) << "readError reached end of pipeline";
+    }
+  }
+
   void fireTransportActive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->transportActive();
     }
   }
 
   void fireTransportInactive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->transportInactive();
     }
   }
 
+  void fireTransportWritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextIn_) {
+      this->nextIn_->transportWritable();
+    }
+  }
+
+  void fireTransportUnwritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextIn_) {
+      this->nextIn_->transportUnwritable();
+    }
+  }
+
   folly::Future<folly::Unit> fireWrite(Wout msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextOut_) {
       return this->nextOut_->write(std::forward<Wout>(msg));
     } else {
@@ -227,9 +367,19 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
     }
   }
 
+  FastWriteResult fireWriteFast(Wout& msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextOut_) {
+      return this->nextOut_->writeFast(msg);
+    } else {
+      LOG(WARNING) << "writeFast reached end of pipeline";
+      return FastWriteResult::DONE;
+    }
+  }
+
   folly::Future<folly::Unit> fireWriteException(
       folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextOut_) {
       return this->nextOut_->writeException(std::move(e));
     } else {
@@ -239,7 +389,7 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
   }
 
   folly::Future<folly::Unit> fireClose() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextOut_) {
       return this->nextOut_->close();
     } else {
@@ -273,46 +423,73 @@ class ContextImpl : public HandlerContext<typename H::rout, typename H::wout>,
     return this->pipelineRaw_->getReadBufferSettings();
   }
 
+  HandlerStateSlot& getStateSlot() override {
+    return this->stateSlot_;
+  }
+
   // InboundLink overrides
   void read(Rin msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    HandlerStatsGuard stats(this->statsEntry_);
     this->handler_->read(this, std::forward<Rin>(msg));
   }
 
   void readEOF() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->readEOF(this);
   }
 
   void readException(folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->readException(this, std::move(e));
   }
 
+  void readError(TransportErrorCode code) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->handler_->readError(this, code);
+  }
+
   void transportActive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->transportActive(this);
   }
 
   void transportInactive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->transportInactive(this);
   }
 
+  void transportWritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->handler_->transportWritable(this);
+  }
+
+  void transportUnwritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->handler_->transportUnwritable(this);
+  }
+
   // OutboundLink overrides
   folly::Future<folly::Unit> write(Win msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    HandlerStatsGuard stats(this->statsEntry_);
     return this->handler_->write(this, std::forward<Win>(msg));
   }
 
+  FastWriteResult writeFast(Win& msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    HandlerStatsGuard stats(this->statsEntry_);
+    return this->handler_->writeFast(this, msg);
+  }
+
   folly::Future<folly::Unit> writeException(
       folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     return this->handler_->writeException(this, std::move(e));
   }
 
   folly::Future<folly::Unit> close() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     return this->handler_->close(this);
   }
 };
@@ -329,11 +506,12 @@ class InboundContextImpl
   typedef typename H::wout Wout;
   static const HandlerDir dir = HandlerDir::IN;
 
-  explicit InboundContextImpl(
-      std::weak_ptr<PipelineBase> pipeline,
+  InboundContextImpl(
+      PipelineBase* pipeline,
+      std::weak_ptr<PipelineBase> pipelineWeak,
       std::shared_ptr<H> handler) {
     this->impl_ = this;
-    this->initialize(pipeline, std::move(handler));
+    this->initialize(pipeline, std::move(pipelineWeak), std::move(handler));
   }
 
   // For StaticPipeline
@@ -343,9 +521,16 @@ class InboundContextImpl
 
   ~InboundContextImpl() override = default;
 
+  // PipelineContext overrides
+  void* getInboundLink(PipelineTypeId id) override {
+    return id == pipelineTypeId<Rin>()
+        ? static_cast<void*>(static_cast<InboundLink<Rin>*>(this))
+        : nullptr;
+  }
+
   // InboundHandlerContext overrides
   void fireRead(Rout msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->read(std::forward<Rout>(msg));
     } else {
@@ -354,7 +539,7 @@ class InboundContextImpl
   }
 
   void fireReadEOF() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->readEOF();
     } else {
@@ -363,7 +548,7 @@ class InboundContextImpl
   }
 
   void fireReadException(folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->readException(std::move(e));
     } else {
@@ -371,20 +556,43 @@ class InboundContextImpl
     }
   }
 
+  void fireReadError(TransportErrorCode code) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextIn_) {
+      this->nextIn_->readError(code);
+    } else {
+      LOG(WARNING) << "readError reached end of pipeline";
+    }
+  }
+
   void fireTransportActive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->transportActive();
     }
   }
 
   void fireTransportInactive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextIn_) {
       this->nextIn_->transportInactive();
     }
   }
 
+  void fireTransportWritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextIn_) {
+      this->nextIn_->transportWritable();
+    }
+  }
+
+  void fireTransportUnwritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextIn_) {
+      this->nextIn_->transportUnwritable();
+    }
+  }
+
   PipelineBase* getPipeline() override {
     return this->pipelineRaw_;
   }
@@ -393,31 +601,51 @@ class InboundContextImpl
     return this->pipelineWeak_.lock();
   }
 
+  HandlerStateSlot& getStateSlot() override {
+    return this->stateSlot_;
+  }
+
   // InboundLink overrides
   void read(Rin msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    HandlerStatsGuard stats(this->statsEntry_);
     this->handler_->read(this, std::forward<Rin>(msg));
   }
 
   void readEOF() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->readEOF(this);
   }
 
   void readException(folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->readException(this, std::move(e));
   }
 
+  void readError(TransportErrorCode code) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->handler_->readError(this, code);
+  }
+
   void transportActive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->transportActive(this);
   }
 
   void transportInactive() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     this->handler_->transportInactive(this);
   }
+
+  void transportWritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->handler_->transportWritable(this);
+  }
+
+  void transportUnwritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->handler_->transportUnwritable(this);
+  }
 };
 
 template <class H>
@@ -432,11 +660,12 @@ class OutboundContextImpl
   typedef typename H::wout Wout;
   static const HandlerDir dir = HandlerDir::OUT;
 
-  explicit OutboundContextImpl(
-      std::weak_ptr<PipelineBase> pipeline,
+  OutboundContextImpl(
+      PipelineBase* pipeline,
+      std::weak_ptr<PipelineBase> pipelineWeak,
       std::shared_ptr<H> handler) {
     this->impl_ = this;
-    this->initialize(pipeline, std::move(handler));
+    this->initialize(pipeline, std::move(pipelineWeak), std::move(handler));
   }
 
   // For StaticPipeline
@@ -446,9 +675,16 @@ class OutboundContextImpl
 
   ~OutboundContextImpl() override = default;
 
+  // PipelineContext overrides
+  void* getOutboundLink(PipelineTypeId id) override {
+    return id == pipelineTypeId<Win>()
+        ? static_cast<void*>(static_cast<OutboundLink<Win>*>(this))
+        : nullptr;
+  }
+
   // OutboundHandlerContext overrides
   folly::Future<folly::Unit> fireWrite(Wout msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextOut_) {
       return this->nextOut_->write(std::forward<Wout>(msg));
     } else {
@@ -457,9 +693,19 @@ class OutboundContextImpl
     }
   }
 
+  FastWriteResult fireWriteFast(Wout& msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    if (this->nextOut_) {
+      return this->nextOut_->writeFast(msg);
+    } else {
+      LOG(WARNING) << "writeFast reached end of pipeline";
+      return FastWriteResult::DONE;
+    }
+  }
+
   folly::Future<folly::Unit> fireWriteException(
       folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextOut_) {
       return this->nextOut_->writeException(std::move(e));
     } else {
@@ -469,7 +715,7 @@ class OutboundContextImpl
   }
 
   folly::Future<folly::Unit> fireClose() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     if (this->nextOut_) {
       return this->nextOut_->close();
     } else {
@@ -486,20 +732,31 @@ class OutboundContextImpl
     return this->pipelineWeak_.lock();
   }
 
+  HandlerStateSlot& getStateSlot() override {
+    return this->stateSlot_;
+  }
+
   // OutboundLink overrides
   folly::Future<folly::Unit> write(Win msg) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    HandlerStatsGuard stats(this->statsEntry_);
     return this->handler_->write(this, std::forward<Win>(msg));
   }
 
+  FastWriteResult writeFast(Win& msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    HandlerStatsGuard stats(this->statsEntry_);
+    return this->handler_->writeFast(this, msg);
+  }
+
   folly::Future<folly::Unit> writeException(
       folly::exception_wrapper e) override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     return this->handler_->writeException(this, std::move(e));
   }
 
   folly::Future<folly::Unit> close() override {
-    auto guard = this->pipelineWeak_.lock();
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
     return this->handler_->close(this);
   }
 };
@@ -16,6 +16,13 @@
 
 #pragma once
 
+#include <memory>
+#include <new>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include <folly/Demangle.h>
 #include <folly/ExceptionWrapper.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTransport.h>
@@ -24,6 +31,156 @@ namespace wangle {
 
 class PipelineBase;
 
+/**
+ * Result of a synchronous fast-path write attempt; see Pipeline::writeFast.
+ *
+ * DONE means the write completed inline without allocating a promise/future
+ * pair. UNSUPPORTED means some handler in the chain has no fast path (or the
+ * transport would block); the message is left untouched and the caller must
+ * fall back to the Future-returning write().
+ */
+enum class FastWriteResult {
+  DONE,
+  UNSUPPORTED,
+};
+
+/**
+ * Well-known transport failures, delivered through readError() as a
+ * plain enum instead of an exception_wrapper. Connection deaths from
+ * scanners and flaky clients arrive by the millions, and building an
+ * AsyncSocketException per occurrence allocates for information most
+ * pipelines never look at; handlers that do want the exception can
+ * synthesize one lazily (see AsyncSocketHandler::makeTransportException).
+ * Errors with no enum mapping still travel the readException() path.
+ */
+enum class TransportErrorCode : uint8_t {
+  UNKNOWN,
+  CONNECTION_RESET,
+  CONNECTION_ABORTED,
+  TIMED_OUT,
+  BROKEN_PIPE,
+  NETWORK_UNREACHABLE,
+};
+
+/**
+ * Aggregated timing for one handler type in an instrumented pipeline.
+ * Cycles are folly::hardware_timestamp() deltas; divide by the host TSC
+ * frequency if wall time is needed. A recorded invocation includes
+ * everything the handler fires into downstream synchronously, so the
+ * difference between adjacent handlers' totals is the cost of the hop
+ * between them.
+ */
+struct HandlerStats {
+  explicit HandlerStats(const std::type_info& t)
+      : type(t), name(folly::demangle(t).toStdString()) {}
+
+  std::type_index type;
+  std::string name;
+  uint64_t events{0};
+  uint64_t totalCycles{0};
+  uint64_t maxCycles{0};
+
+  void record(uint64_t cycles) {
+    events++;
+    totalCycles += cycles;
+    if (cycles > maxCycles) {
+      maxCycles = cycles;
+    }
+  }
+};
+
+/**
+ * Per-pipeline collection of HandlerStats, aggregated by handler type.
+ * A pipeline's events are all driven from its transport's EventBase
+ * thread, so recording is plain arithmetic with no atomics; read the
+ * entries from that thread (or after the pipeline is quiesced). See
+ * PipelineBase::enableHandlerStats.
+ */
+class PipelineStats {
+ public:
+  // The returned pointer is stable for the lifetime of the
+  // PipelineStats; contexts cache it and record into it directly.
+  HandlerStats* getEntry(const std::type_info& type) {
+    for (auto& entry : entries_) {
+      if (entry->type == std::type_index(type)) {
+        return entry.get();
+      }
+    }
+    entries_.push_back(std::make_unique<HandlerStats>(type));
+    return entries_.back().get();
+  }
+
+  const std::vector<std::unique_ptr<HandlerStats>>& entries() const {
+    return entries_;
+  }
+
+ private:
+  std::vector<std::unique_ptr<HandlerStats>> entries_;
+};
+
+/**
+ * Type-erased storage for one handler's per-pipeline state; every context
+ * owns one slot. A state no larger than kInlineSize lives inside the
+ * context object itself (so with a PipelineContextPool it sits in the
+ * pipeline's slab, adjacent to the chain pointers); bigger states fall
+ * back to the heap. This is what lets a single handler instance serve
+ * many pipelines: the shared object keeps the immutable configuration
+ * and each connection's mutable bytes live here. See SharedHandler.h.
+ */
+class HandlerStateSlot {
+ public:
+  HandlerStateSlot() = default;
+  ~HandlerStateSlot() {
+    reset();
+  }
+
+  HandlerStateSlot(const HandlerStateSlot&) = delete;
+  HandlerStateSlot& operator=(const HandlerStateSlot&) = delete;
+
+  template <class State, class... Args>
+  State& emplace(Args&&... args) {
+    reset();
+    if (sizeof(State) <= kInlineSize &&
+        alignof(State) <= alignof(std::max_align_t)) {
+      ptr_ = new (storage_) State(std::forward<Args>(args)...);
+      destroy_ = [](void* p) { static_cast<State*>(p)->~State(); };
+    } else {
+      ptr_ = new State(std::forward<Args>(args)...);
+      destroy_ = [](void* p) { delete static_cast<State*>(p); };
+    }
+#ifndef NDEBUG
+    type_ = &typeid(State);
+#endif
+    return *static_cast<State*>(ptr_);
+  }
+
+  template <class State>
+  State* get() {
+#ifndef NDEBUG
+    DCHECK(ptr_ == nullptr || *type_ == typeid(State));
+#endif
+    return static_cast<State*>(ptr_);
+  }
+
+  void reset() {
+    if (ptr_) {
+      destroy_(ptr_);
+      ptr_ = nullptr;
+      destroy_ = nullptr;
+    }
+  }
+
+ private:
+  static constexpr size_t kInlineSize = 64;
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  void* ptr_{nullptr};
+  void (*destroy_)(void*){nullptr};
+#ifndef NDEBUG
+  const std::type_info* type_{nullptr};
+#endif
+};
+
 template <class In, class Out>
 class HandlerContext {
  public:
@@ -32,10 +189,16 @@ class HandlerContext {
   virtual void fireRead(In msg) = 0;
   virtual void fireReadEOF() = 0;
   virtual void fireReadException(folly::exception_wrapper e) = 0;
+  virtual void fireReadError(TransportErrorCode code) = 0;
   virtual void fireTransportActive() = 0;
   virtual void fireTransportInactive() = 0;
+  virtual void fireTransportWritable() = 0;
+  virtual void fireTransportUnwritable() = 0;
 
   virtual folly::Future<folly::Unit> fireWrite(Out msg) = 0;
+  virtual FastWriteResult fireWriteFast(Out& /*msg*/) {
+    return FastWriteResult::UNSUPPORTED;
+  }
   virtual folly::Future<folly::Unit> fireWriteException(
       folly::exception_wrapper e) = 0;
   virtual folly::Future<folly::Unit> fireClose() = 0;
@@ -46,6 +209,37 @@ class HandlerContext {
     return getPipeline()->getTransport();
   }
 
+  /**
+   * Non-owning transport access for per-message paths; see
+   * PipelineBase::getTransportRaw for the lifetime contract.
+   */
+  folly::AsyncTransport* getTransportRaw() {
+    return getPipeline()->getTransportRaw();
+  }
+
+  /**
+   * Typed access to another handler in the same pipeline, for handler
+   * cross-talk. On a finalized pipeline this is a single hash probe;
+   * see PipelineBase::getHandler. For per-message use, the cheapest
+   * pattern is still to look the peer up once in attachPipeline() and
+   * cache the raw pointer in the handler:
+   *
+   *   void attachPipeline(Context* ctx) override {
+   *     peer_ = ctx->getPeerHandler<PeerHandler>();
+   *   }
+   *
+   * The cached pointer stays valid until the peer is removed from the
+   * pipeline; re-resolve it if handlers are added or removed at run
+   * time. Returns nullptr if no handler of that type is in the chain.
+   */
+  template <class H>
+  H* getPeerHandler() {
+    return getPipeline()->template getHandler<H>();
+  }
+
+  // Per-pipeline storage for this handler; see HandlerStateSlot.
+  virtual HandlerStateSlot& getStateSlot() = 0;
+
   virtual void setWriteFlags(folly::WriteFlags flags) = 0;
   virtual folly::WriteFlags getWriteFlags() = 0;
 
@@ -73,8 +267,11 @@ class InboundHandlerContext {
   virtual void fireRead(In msg) = 0;
   virtual void fireReadEOF() = 0;
   virtual void fireReadException(folly::exception_wrapper e) = 0;
+  virtual void fireReadError(TransportErrorCode code) = 0;
   virtual void fireTransportActive() = 0;
   virtual void fireTransportInactive() = 0;
+  virtual void fireTransportWritable() = 0;
+  virtual void fireTransportUnwritable() = 0;
 
   virtual PipelineBase* getPipeline() = 0;
   virtual std::shared_ptr<PipelineBase> getPipelineShared() = 0;
@@ -82,6 +279,12 @@ class InboundHandlerContext {
     return getPipeline()->getTransport();
   }
 
+  folly::AsyncTransport* getTransportRaw() {
+    return getPipeline()->getTransportRaw();
+  }
+
+  virtual HandlerStateSlot& getStateSlot() = 0;
+
   // TODO Need get/set writeFlags, readBufferSettings? Probably not.
   // Do we even really need them stored in the pipeline at all?
   // Could just always delegate to the socket impl
@@ -93,6 +296,9 @@ class OutboundHandlerContext {
   virtual ~OutboundHandlerContext() = default;
 
   virtual folly::Future<folly::Unit> fireWrite(Out msg) = 0;
+  virtual FastWriteResult fireWriteFast(Out& /*msg*/) {
+    return FastWriteResult::UNSUPPORTED;
+  }
   virtual folly::Future<folly::Unit> fireWriteException(
       folly::exception_wrapper e) = 0;
   virtual folly::Future<folly::Unit> fireClose() = 0;
@@ -102,6 +308,12 @@ class OutboundHandlerContext {
   std::shared_ptr<folly::AsyncTransport> getTransport() {
     return getPipeline()->getTransport();
   }
+
+  folly::AsyncTransport* getTransportRaw() {
+    return getPipeline()->getTransportRaw();
+  }
+
+  virtual HandlerStateSlot& getStateSlot() = 0;
 };
 
 // #include <windows.h> has blessed us with #define IN & OUT, typically mapped
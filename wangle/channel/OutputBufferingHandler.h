@@ -16,24 +16,60 @@
 
 #pragma once
 
-#include <folly/futures/SharedPromise.h>
+#include <algorithm>
+#include <chrono>
+
+#include <folly/futures/Future.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventBaseManager.h>
+#include <folly/small_vector.h>
+#include <wangle/channel/FlushCoordinator.h>
 #include <wangle/channel/Handler.h>
 
 namespace wangle {
 
 /*
  * OutputBufferingHandler buffers writes in order to minimize syscalls. The
- * transport will be written to once per event loop instead of on every write.
+ * transport will be written to once per event loop instead of on every write,
+ * or earlier if the buffered bytes exceed a configurable threshold.
+ *
+ * Waiters are plain promises held in an inline vector and fulfilled directly
+ * when the flush completes; there is no SharedPromise (whose locking and
+ * per-waiter continuation machinery is measurable at high write rates).
+ *
+ * With setMaxFlushLatency() the handler switches from per-loop-iteration
+ * flushing to a Nagle-style deadline: the first buffered write arms a
+ * high-resolution timer and the chain accumulates until the deadline, the
+ * byte threshold, a message written with WriteFlags::EOR, or an explicit
+ * flushNow() releases it.
  *
  * This handler may only be used in a single Pipeline.
  */
 class OutputBufferingHandler : public OutboundBytesToBytesHandler,
-                               protected folly::EventBase::LoopCallback {
+                               protected folly::EventBase::LoopCallback,
+                               private FlushCoordinator::Participant {
  public:
+  struct FlushStats {
+    uint64_t flushes{0};
+    // Flushes triggered by the buffered-bytes threshold rather than the
+    // end of the event loop.
+    uint64_t earlyFlushes{0};
+    uint64_t bytesFlushed{0};
+    uint64_t maxFlushBytes{0};
+    // Flushes triggered by the max-latency deadline timer.
+    uint64_t deadlineFlushes{0};
+    // Flushes forced by a message written with WriteFlags::EOR.
+    uint64_t noBatchFlushes{0};
+    // Flushes issued by the EventBase-wide coordinator pass.
+    uint64_t coordinatedFlushes{0};
+    // Flushes issued while a write message was still open (see
+    // PipelineBase::beginWriteMessage); the write went down corked.
+    uint64_t midMessageFlushes{0};
+  };
+
   folly::Future<folly::Unit> write(
       Context* ctx,
       std::unique_ptr<folly::IOBuf> buf) override {
@@ -42,56 +78,211 @@ class OutputBufferingHandler : public OutboundBytesToBytesHandler,
       return ctx->fireWrite(std::move(buf));
     } else {
       // Delay sends to optimize for fewer syscalls
+      bufferedBytes_ += buf->computeChainDataLength();
       if (!sends_) {
         DCHECK(!isLoopCallbackScheduled());
-        // Buffer all the sends, and call writev once per event loop.
+        // Buffer all the sends, and call writev once per event loop, or
+        // once per flush deadline when one is configured.
         sends_ = std::move(buf);
-        ctx->getTransport()->getEventBase()->runInLoop(this);
+        if (useFlushCoordinator_) {
+          coordinator_ =
+              &FlushCoordinator::get(ctx->getTransportRaw()->getEventBase());
+          coordinator_->markDirty(this);
+        } else if (maxFlushLatency_.count() > 0) {
+          scheduleFlushDeadline(ctx);
+        } else {
+          ctx->getTransportRaw()->getEventBase()->runInLoop(this);
+        }
       } else {
-        DCHECK(isLoopCallbackScheduled());
+        DCHECK(
+            isLoopCallbackScheduled() || coordinator_ ||
+            (maxFlushLatency_.count() > 0 && flushTimeout_));
         sends_->prependChain(std::move(buf));
       }
-      return sharedPromise_.getFuture();
+      waiters_.emplace_back();
+      auto future = waiters_.back().getFuture();
+      if (folly::isSet(ctx->getWriteFlags(), folly::WriteFlags::EOR)) {
+        // A latency-sensitive message; release the whole chain now rather
+        // than making it wait out the batching window.
+        cancelFlushCallbacks();
+        flushStats_.noBatchFlushes++;
+        flush(ctx);
+      } else if (maxBufferedBytes_ > 0 && bufferedBytes_ >= maxBufferedBytes_) {
+        cancelFlushCallbacks();
+        flushStats_.earlyFlushes++;
+        flush(ctx);
+      }
+      return future;
     }
   }
 
   void runLoopCallback() noexcept override {
-    folly::SharedPromise<folly::Unit> sharedPromise;
-    std::swap(sharedPromise, sharedPromise_);
-    getContext()
-        ->fireWrite(std::move(sends_))
-        .thenTry([sharedPromise = std::move(sharedPromise)](
-                     folly::Try<folly::Unit> t) mutable {
-          sharedPromise.setTry(std::move(t));
-        });
+    flush(getContext());
   }
 
-  void cleanUp() {
-    if (isLoopCallbackScheduled()) {
-      cancelLoopCallback();
+  /**
+   * Flushes whatever is buffered immediately, regardless of the configured
+   * thresholds. A no-op when nothing is buffered.
+   */
+  void flushNow() {
+    if (!sends_) {
+      return;
     }
+    cancelFlushCallbacks();
+    flush(getContext());
+  }
+
+  void cleanUp() {
+    cancelFlushCallbacks();
 
     sends_.reset();
-    sharedPromise_ = folly::SharedPromise<folly::Unit>();
+    bufferedBytes_ = 0;
+    waiters_.clear();
   }
 
   folly::Future<folly::Unit> close(Context* ctx) override {
-    if (isLoopCallbackScheduled()) {
-      cancelLoopCallback();
-    }
+    cancelFlushCallbacks();
 
     // If there are sends queued, cancel them
-    sharedPromise_.setException(
-        folly::make_exception_wrapper<std::runtime_error>(
-            "close() called while sends still pending"));
+    auto ew = folly::make_exception_wrapper<std::runtime_error>(
+        "close() called while sends still pending");
+    for (auto& waiter : waiters_) {
+      waiter.setException(ew);
+    }
+    waiters_.clear();
     sends_.reset();
-    sharedPromise_ = folly::SharedPromise<folly::Unit>();
+    bufferedBytes_ = 0;
     return ctx->fireClose();
   }
 
-  folly::SharedPromise<folly::Unit> sharedPromise_;
-  std::unique_ptr<folly::IOBuf> sends_{nullptr};
+  /**
+   * Flushes to the transport once this many bytes are buffered instead of
+   * waiting for the end of the event loop. 0 (the default) means unbounded,
+   * the historical behavior.
+   */
+  void setMaxBufferedBytes(uint64_t maxBufferedBytes) {
+    maxBufferedBytes_ = maxBufferedBytes;
+  }
+
+  /**
+   * Holds buffered writes for up to this long before flushing, instead of
+   * flushing at the end of the current event loop iteration. Lets several
+   * loop iterations' worth of small writes coalesce into one syscall, at
+   * the cost of up to this much added latency. 0 (the default) restores
+   * the per-loop-iteration behavior.
+   */
+  void setMaxFlushLatency(std::chrono::microseconds maxFlushLatency) {
+    maxFlushLatency_ = maxFlushLatency;
+  }
+
+  /**
+   * Flushes through the EventBase-wide FlushCoordinator instead of
+   * scheduling this handler's own loop callback: every coordinated
+   * handler on the EventBase is flushed in one end-of-loop pass, so a
+   * loop iteration that dirties hundreds of pipelines schedules one
+   * callback and issues its writes back to back. Takes precedence over
+   * setMaxFlushLatency(). Off by default.
+   */
+  void setUseFlushCoordinator(bool use) {
+    useFlushCoordinator_ = use;
+  }
+
+  /**
+   * Schedules the flush deadline timer on the given manager instead of
+   * the transport's EventBase. A test seam: the simulation harness in
+   * wangle/test/Simulation.h drives the deadline on virtual time.
+   */
+  void setTimeoutManager(folly::TimeoutManager* timeoutManager) {
+    timeoutManager_ = timeoutManager;
+  }
+
+  uint64_t getBufferedBytes() const {
+    return bufferedBytes_;
+  }
+
+  const FlushStats& getFlushStats() const {
+    return flushStats_;
+  }
+
   bool queueSends_{true};
+
+ private:
+  using Waiters = folly::small_vector<folly::Promise<folly::Unit>, 8>;
+
+  void scheduleFlushDeadline(Context* ctx) {
+    if (!flushTimeout_) {
+      folly::TimeoutManager* manager = timeoutManager_
+          ? timeoutManager_
+          : ctx->getTransportRaw()->getEventBase();
+      flushTimeout_ = folly::AsyncTimeout::make(*manager, [this]() noexcept {
+        if (!sends_) {
+          // The deadline raced with an earlier flush that already
+          // drained the buffer; nothing to do.
+          return;
+        }
+        flushStats_.deadlineFlushes++;
+        flush(getContext());
+      });
+    }
+    flushTimeout_->scheduleTimeoutHighRes(maxFlushLatency_);
+  }
+
+  void cancelFlushCallbacks() {
+    if (isLoopCallbackScheduled()) {
+      cancelLoopCallback();
+    }
+    if (flushTimeout_) {
+      flushTimeout_->cancelTimeout();
+    }
+    if (coordinator_) {
+      coordinator_->retract(this);
+      coordinator_ = nullptr;
+    }
+  }
+
+  void coordinatedFlush() noexcept override {
+    coordinator_ = nullptr;
+    flushStats_.coordinatedFlushes++;
+    flush(getContext());
+  }
+
+  void flush(Context* ctx) {
+    Waiters waiters;
+    std::swap(waiters, waiters_);
+    auto flushedBytes = bufferedBytes_;
+    bufferedBytes_ = 0;
+    flushStats_.flushes++;
+    if (folly::isSet(ctx->getWriteFlags(), folly::WriteFlags::CORK)) {
+      // A threshold or loop-end flush caught an open message; the write
+      // goes down still corked, so the kernel keeps assembling the
+      // frame instead of emitting a partial segment.
+      flushStats_.midMessageFlushes++;
+    }
+    flushStats_.bytesFlushed += flushedBytes;
+    flushStats_.maxFlushBytes =
+        std::max(flushStats_.maxFlushBytes, flushedBytes);
+    ctx->fireWrite(std::move(sends_))
+        .thenTry([waiters = std::move(waiters)](
+                     folly::Try<folly::Unit> t) mutable {
+          for (auto& waiter : waiters) {
+            waiter.setTry(folly::Try<folly::Unit>(t));
+          }
+        });
+  }
+
+  std::unique_ptr<folly::IOBuf> sends_{nullptr};
+  Waiters waiters_;
+  uint64_t bufferedBytes_{0};
+  uint64_t maxBufferedBytes_{0};
+  std::chrono::microseconds maxFlushLatency_{0};
+  // Created lazily on the transport's EventBase (or the injected
+  // manager) the first time a deadline is armed.
+  std::unique_ptr<folly::AsyncTimeout> flushTimeout_;
+  folly::TimeoutManager* timeoutManager_{nullptr};
+  bool useFlushCoordinator_{false};
+  // Set while this handler sits on the coordinator's dirty list.
+  FlushCoordinator* coordinator_{nullptr};
+  FlushStats flushStats_;
 };
 
 } // namespace wangle
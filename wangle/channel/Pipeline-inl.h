@@ -35,11 +35,21 @@ Pipeline<R, W>::~Pipeline() {
   }
 }
 
+template <class Context, class... Args>
+std::shared_ptr<Context> PipelineBase::makeContext(Args&&... args) {
+  if (contextPool_) {
+    return std::allocate_shared<Context>(
+        PipelineContextPoolAllocator<Context>(contextPool_),
+        std::forward<Args>(args)...);
+  }
+  return std::make_shared<Context>(std::forward<Args>(args)...);
+}
+
 template <class H>
 PipelineBase& PipelineBase::addBack(std::shared_ptr<H> handler) {
   typedef typename ContextType<H>::type Context;
   return addHelper(
-      std::make_shared<Context>(shared_from_this(), std::move(handler)), false);
+      makeContext<Context>(this, ownershipRef(), std::move(handler)), false);
 }
 
 template <class H>
@@ -56,7 +66,7 @@ template <class H>
 PipelineBase& PipelineBase::addFront(std::shared_ptr<H> handler) {
   typedef typename ContextType<H>::type Context;
   return addHelper(
-      std::make_shared<Context>(shared_from_this(), std::move(handler)), true);
+      makeContext<Context>(this, ownershipRef(), std::move(handler)), true);
 }
 
 template <class H>
@@ -122,8 +132,15 @@ typename ContextType<H>::type* PipelineBase::getContext(size_t i) {
 
 template <class H>
 typename ContextType<H>::type* PipelineBase::getContext() {
+  typedef typename ContextType<H>::type Context;
+  if (!typedCtxs_.empty()) {
+    // Contexts are concrete per-handler-type templates, so an exact
+    // typeid match finds the same context the dynamic_cast walk would.
+    auto it = typedCtxs_.find(std::type_index(typeid(Context)));
+    return it != typedCtxs_.end() ? static_cast<Context*>(it->second) : nullptr;
+  }
   for (auto pipelineCtx : ctxs_) {
-    auto ctx = dynamic_cast<typename ContextType<H>::type*>(pipelineCtx.get());
+    auto ctx = dynamic_cast<Context*>(pipelineCtx.get());
     if (ctx) {
       return ctx;
     }
@@ -153,6 +170,7 @@ template <class Context>
 PipelineBase& PipelineBase::addHelper(
     std::shared_ptr<Context>&& ctx,
     bool front) {
+  typedCtxs_.clear(); // stale until the next finalize()
   ctxs_.insert(front ? ctxs_.begin() : ctxs_.end(), ctx);
   if (Context::dir == HandlerDir::BOTH || Context::dir == HandlerDir::IN) {
     inCtxs_.insert(front ? inCtxs_.begin() : inCtxs_.end(), ctx.get());
@@ -224,6 +242,62 @@ Pipeline<R, W>::transportInactive() {
   }
 }
 
+template <class R, class W>
+template <class T>
+typename std::enable_if<!std::is_same<T, folly::Unit>::value, bool>::type
+Pipeline<R, W>::migrateTo(folly::EventBase* target) {
+  auto transport = getTransport();
+  if (!transport || !target) {
+    return false;
+  }
+  if (isUniquelyOwned()) {
+    // The borrow count is loop-confined and the target loop would need
+    // a shared keep-alive for the re-attach callback.
+    return false;
+  }
+  auto* source = transport->getEventBase();
+  if (!source || source == target || !source->isInEventBaseThread()) {
+    return false;
+  }
+  // Quiesce reads: handlers drop their read callbacks on
+  // transportInactive, which is what makes the socket detachable.
+  transportInactive();
+  if (!transport->isDetachable()) {
+    // Writes still in flight; resume where we were.
+    transportActive();
+    return false;
+  }
+  transport->detachEventBase();
+  auto self = std::static_pointer_cast<Pipeline<R, W>>(shared_from_this());
+  target->runInEventBaseThread([self = std::move(self), transport, target] {
+    transport->attachEventBase(target);
+    self->transportActive();
+  });
+  return true;
+}
+
+template <class R, class W>
+template <class T>
+typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
+Pipeline<R, W>::transportWritable() {
+  OptionalReqCtxScopeGuard optGuard;
+  fillRequestContextGuard(optGuard);
+  if (front_) {
+    front_->transportWritable();
+  }
+}
+
+template <class R, class W>
+template <class T>
+typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
+Pipeline<R, W>::transportUnwritable() {
+  OptionalReqCtxScopeGuard optGuard;
+  fillRequestContextGuard(optGuard);
+  if (front_) {
+    front_->transportUnwritable();
+  }
+}
+
 template <class R, class W>
 template <class T>
 typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
@@ -237,6 +311,18 @@ Pipeline<R, W>::readException(folly::exception_wrapper e) {
   front_->readException(std::move(e));
 }
 
+template <class R, class W>
+template <class T>
+typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
+Pipeline<R, W>::readError(TransportErrorCode code) {
+  OptionalReqCtxScopeGuard optGuard;
+  fillRequestContextGuard(optGuard);
+  if (!front_) {
+    throw std::invalid_argument("readError(): no inbound handler in Pipeline");
+  }
+  front_->readError(code);
+}
+
 template <class R, class W>
 template <class T>
 typename std::enable_if<
@@ -251,6 +337,19 @@ Pipeline<R, W>::write(W msg) {
   return back_->write(std::forward<W>(msg));
 }
 
+template <class R, class W>
+template <class T>
+typename std::enable_if<!std::is_same<T, folly::Unit>::value, FastWriteResult>::
+    type
+    Pipeline<R, W>::writeFast(W& msg) {
+  OptionalReqCtxScopeGuard optGuard;
+  fillRequestContextGuard(optGuard);
+  if (!back_) {
+    throw std::invalid_argument("writeFast(): no outbound handler in Pipeline");
+  }
+  return back_->writeFast(msg);
+}
+
 template <class R, class W>
 template <class T>
 typename std::enable_if<
@@ -285,7 +384,8 @@ template <class R, class W>
 void Pipeline<R, W>::finalize() {
   front_ = nullptr;
   if (!inCtxs_.empty()) {
-    front_ = dynamic_cast<InboundLink<R>*>(inCtxs_.front());
+    front_ = static_cast<InboundLink<R>*>(
+        inCtxs_.front()->getInboundLink(pipelineTypeId<R>()));
     for (size_t i = 0; i < inCtxs_.size() - 1; i++) {
       inCtxs_[i]->setNextIn(inCtxs_[i + 1]);
     }
@@ -294,7 +394,8 @@ void Pipeline<R, W>::finalize() {
 
   back_ = nullptr;
   if (!outCtxs_.empty()) {
-    back_ = dynamic_cast<OutboundLink<W>*>(outCtxs_.back());
+    back_ = static_cast<OutboundLink<W>*>(
+        outCtxs_.back()->getOutboundLink(pipelineTypeId<W>()));
     for (size_t i = outCtxs_.size() - 1; i > 0; i--) {
       outCtxs_[i]->setNextOut(outCtxs_[i - 1]);
     }
@@ -312,6 +413,8 @@ void Pipeline<R, W>::finalize() {
         "std::invalid_argument");
   }
 
+  rebuildTypedContextTable();
+
   for (auto it = ctxs_.rbegin(); it != ctxs_.rend(); it++) {
     (*it)->attachPipeline();
   }
@@ -321,9 +424,17 @@ template <class R, class W>
 void Pipeline<R, W>::fillRequestContextGuard(
     OptionalReqCtxScopeGuard& optGuard) {
   CHECK(!optGuard.has_value());
-  if (requestContext_) {
-    optGuard.emplace(requestContext_);
+  // The guard is captured lazily: pipelines that never call
+  // setRequestContext pay only this branch per event.
+  if (!requestContext_ || elideRequestContextGuard_) {
+    return;
+  }
+  // If our context is already the active one, setting and restoring it
+  // would be two refcount round trips for no observable change.
+  if (requestContext_.get() == folly::RequestContext::try_get()) {
+    return;
   }
+  optGuard.emplace(requestContext_);
 }
 
 } // namespace wangle
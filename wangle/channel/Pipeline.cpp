@@ -28,6 +28,14 @@ WriteFlags PipelineBase::getWriteFlags() {
   return writeFlags_;
 }
 
+void PipelineBase::beginWriteMessage() {
+  writeFlags_ = writeFlags_ | WriteFlags::CORK;
+}
+
+void PipelineBase::endWriteMessage() {
+  writeFlags_ = folly::unSet(writeFlags_, WriteFlags::CORK);
+}
+
 void PipelineBase::setReadBufferSettings(
     uint64_t minAvailable,
     uint64_t allocationSize) {
@@ -38,6 +46,30 @@ std::pair<uint64_t, uint64_t> PipelineBase::getReadBufferSettings() {
   return readBufferSettings_;
 }
 
+void PipelineBase::setWriteDeadline(std::chrono::milliseconds deadline) {
+  writeDeadline_ = deadline;
+}
+
+std::chrono::milliseconds PipelineBase::getWriteDeadline() {
+  return writeDeadline_;
+}
+
+void PipelineBase::reserveWriteHeadroom(size_t bytes) {
+  writeHeadroom_ += bytes;
+}
+
+void PipelineBase::reserveWriteTailroom(size_t bytes) {
+  writeTailroom_ += bytes;
+}
+
+size_t PipelineBase::getWriteHeadroom() {
+  return writeHeadroom_;
+}
+
+size_t PipelineBase::getWriteTailroom() {
+  return writeTailroom_;
+}
+
 void PipelineBase::setTransportInfo(std::shared_ptr<TransportInfo> tInfo) {
   transportInfo_ = tInfo;
 }
@@ -46,8 +78,20 @@ std::shared_ptr<TransportInfo> PipelineBase::getTransportInfo() {
   return transportInfo_;
 }
 
+void PipelineBase::rebuildTypedContextTable() {
+  typedCtxs_.clear();
+  for (auto& ctx : ctxs_) {
+    auto& slot = typedCtxs_[std::type_index(typeid(*ctx))];
+    if (!slot) {
+      // Keep the frontmost context per type, like the linear walk.
+      slot = ctx.get();
+    }
+  }
+}
+
 typename PipelineBase::ContextIterator PipelineBase::removeAt(
     const typename PipelineBase::ContextIterator& it) {
+  typedCtxs_.clear(); // stale until the next finalize()
   (*it)->detachPipeline();
 
   const auto dir = (*it)->getDirection();
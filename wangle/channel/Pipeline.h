@@ -16,20 +16,26 @@
 
 #pragma once
 
-#include <boost/variant.hpp>
+#include <chrono>
+#include <typeindex>
+
 #include <folly/ExceptionWrapper.h>
 #include <folly/Memory.h>
 #include <folly/Optional.h>
 #include <folly/Unit.h>
+#include <folly/container/F14Map.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/AsyncUDPSocket.h>
 #include <folly/io/async/DelayedDestruction.h>
 #include <folly/io/async/Request.h>
+#include <folly/small_vector.h>
 #include <wangle/acceptor/SecureTransportType.h>
 #include <wangle/acceptor/TransportInfo.h>
+#include <wangle/channel/AcceptPipelineType.h>
 #include <wangle/channel/HandlerContext.h>
+#include <wangle/channel/PipelineContextPool.h>
 
 namespace wangle {
 
@@ -70,15 +76,96 @@ class PipelineBase : public std::enable_shared_from_this<PipelineBase> {
     return transport_;
   }
 
+  /**
+   * Non-owning view of the transport, for per-message call sites (e.g.
+   * reaching the EventBase on every write) where the refcount pair of
+   * the owning accessor is measurable. The pointer is valid while the
+   * pipeline holds the transport; call sites that extend the
+   * transport's lifetime must use getTransport().
+   */
+  folly::AsyncTransport* getTransportRaw() {
+    return transport_.get();
+  }
+
   void setWriteFlags(folly::WriteFlags flags);
   folly::WriteFlags getWriteFlags();
 
+  /**
+   * Outbound message-boundary protocol. When one logical response is
+   * written in fragments by several stages — application code, a
+   * serialize handler, a length prepender — each fragment that reaches
+   * the transport as its own write can leave the host as an undersized
+   * wire segment. beginWriteMessage() marks subsequent writes as
+   * fragments of one message: they carry folly::WriteFlags::CORK, which
+   * the socket maps to MSG_MORE, so the kernel assembles full-MSS
+   * segments instead of emitting partial frames. endWriteMessage()
+   * clears the mark; write the final fragment after it so the uncorked
+   * send releases the assembled frame. Behind OutputBufferingHandler
+   * the ordering is forgiving — fragments are held in user space until
+   * the flush, which goes down corked only while a message is still
+   * open. A message left open by mistake costs bounded latency (the
+   * kernel pushes corked data out after ~200ms), not a hang.
+   */
+  void beginWriteMessage();
+  void endWriteMessage();
+
   void setReadBufferSettings(uint64_t minAvailable, uint64_t allocationSize);
   std::pair<uint64_t, uint64_t> getReadBufferSettings();
 
+  /**
+   * Bound how long a write may stay queued in the transport. When the
+   * oldest unacked write exceeds the deadline, AsyncSocketHandler
+   * closes the transport and fires a TIMED_OUT read exception, so a
+   * wedged peer releases its buffers instead of holding them until the
+   * idle timeout. Zero (the default) disables the deadline.
+   */
+  void setWriteDeadline(std::chrono::milliseconds deadline);
+  std::chrono::milliseconds getWriteDeadline();
+
+  /**
+   * Space the outbound framing stages need around each encoded message.
+   * A framing handler registers its needs when it attaches — a length
+   * prepender its header bytes as headroom, a checksum stage its trailer
+   * as tailroom — and encoders allocate each message with the totals
+   * reserved, so the framing stages write into that space in place
+   * instead of allocating and splicing a buffer per message.
+   * Reservations accumulate as handlers attach and are not returned if
+   * a handler is later removed; over-reservation only costs spare bytes.
+   */
+  void reserveWriteHeadroom(size_t bytes);
+  void reserveWriteTailroom(size_t bytes);
+  size_t getWriteHeadroom();
+  size_t getWriteTailroom();
+
   void setTransportInfo(std::shared_ptr<TransportInfo> tInfo);
   std::shared_ptr<TransportInfo> getTransportInfo();
 
+  // If set before handlers are added, contexts are allocated from the pool
+  // (and recycled back to it) instead of the heap. The pool must outlive the
+  // pipeline; see PipelineContextPool.h.
+  void setContextPool(PipelineContextPool* pool) {
+    contextPool_ = pool;
+  }
+
+  PipelineContextPool* getContextPool() {
+    return contextPool_;
+  }
+
+  // Opt-in per-handler instrumentation. If enabled before finalize(),
+  // every read/write/writeFast hop through the pipeline is timed with
+  // the cycle counter and aggregated by handler type; read the results
+  // via getPipelineStats(). Uninstrumented pipelines pay a single
+  // untaken branch per hop.
+  void enableHandlerStats() {
+    if (!stats_) {
+      stats_ = std::make_unique<PipelineStats>();
+    }
+  }
+
+  PipelineStats* getPipelineStats() const {
+    return stats_.get();
+  }
+
   template <class H>
   PipelineBase& addBack(std::shared_ptr<H> handler);
 
@@ -110,6 +197,13 @@ class PipelineBase : public std::enable_shared_from_this<PipelineBase> {
   template <class H>
   H* getHandler(size_t i);
 
+  // Typed lookup of a handler (or its context) by the handler's static
+  // type, returning the frontmost match. On a finalized pipeline this
+  // is a single hash probe into a type-index table built by finalize();
+  // structural changes (add/remove) invalidate the table and lookups
+  // fall back to the linear RTTI walk until the next finalize(). Cheap
+  // enough for per-message use on finalized pipelines; see also
+  // HandlerContext::getPeerHandler for the cached-accessor pattern.
   template <class H>
   H* getHandler();
 
@@ -130,15 +224,69 @@ class PipelineBase : public std::enable_shared_from_this<PipelineBase> {
 
   size_t numHandlers() const;
 
+  /**
+   * Lifetime interface behind the unique-ownership model; see
+   * Pipeline::createUnique(). Contexts borrow the pipeline for the
+   * duration of each event dispatch, and a deletion requested while
+   * borrows are outstanding (a handler tearing down the owning
+   * connection mid-event) is deferred until the last borrow returns.
+   * The count is plain, not atomic: a uniquely owned pipeline is
+   * confined to its transport's EventBase.
+   */
+  bool isUniquelyOwned() const {
+    return uniquelyOwned_;
+  }
+
+  void addEventBorrow() {
+    borrowCount_++;
+  }
+
+  void releaseEventBorrow() {
+    DCHECK_GT(borrowCount_, 0u);
+    if (--borrowCount_ == 0 && deleteRequested_) {
+      delete this;
+    }
+  }
+
+  /**
+   * The reference contexts hold back to the pipeline: the usual
+   * weak_ptr for shared pipelines, empty for uniquely owned ones (which
+   * have no control block; contexts fall back to the borrow count).
+   */
+  std::weak_ptr<PipelineBase> ownershipRef() {
+    return uniquelyOwned_ ? std::weak_ptr<PipelineBase>() : weak_from_this();
+  }
+
  protected:
+  // Called by the unique-ownership deleter in place of plain delete.
+  void requestDeletion() {
+    if (borrowCount_ > 0) {
+      deleteRequested_ = true;
+      return;
+    }
+    delete this;
+  }
+
+  void markUniquelyOwned() {
+    uniquelyOwned_ = true;
+  }
+
   template <class Context>
   void addContextFront(Context* ctx);
 
   void detachHandlers();
 
-  std::vector<std::shared_ptr<PipelineContext>> ctxs_;
-  std::vector<PipelineContext*> inCtxs_;
-  std::vector<PipelineContext*> outCtxs_;
+  // Rebuilds the type-index→context table behind getHandler/getContext;
+  // called from finalize() once the chain is in its final shape.
+  void rebuildTypedContextTable();
+
+  // Inline storage sized for typical pipelines (socket handler, a codec
+  // or two, service handlers), so building one does no vector heap
+  // allocations and the chain pointers sit in contiguous storage.
+  // Deeper pipelines spill to the heap as usual.
+  folly::small_vector<std::shared_ptr<PipelineContext>, 8> ctxs_;
+  folly::small_vector<PipelineContext*, 8> inCtxs_;
+  folly::small_vector<PipelineContext*, 8> outCtxs_;
 
  private:
   PipelineManager* manager_{nullptr};
@@ -148,18 +296,34 @@ class PipelineBase : public std::enable_shared_from_this<PipelineBase> {
   template <class Context>
   PipelineBase& addHelper(std::shared_ptr<Context>&& ctx, bool front);
 
+  template <class Context, class... Args>
+  std::shared_ptr<Context> makeContext(Args&&... args);
+
   template <class H>
   PipelineBase& removeHelper(H* handler, bool checkEqual);
 
-  typedef std::vector<std::shared_ptr<PipelineContext>>::iterator
+  typedef folly::small_vector<std::shared_ptr<PipelineContext>, 8>::iterator
       ContextIterator;
 
   ContextIterator removeAt(const ContextIterator& it);
 
+  uint32_t borrowCount_{0};
+  bool uniquelyOwned_{false};
+  bool deleteRequested_{false};
+
   folly::WriteFlags writeFlags_{folly::WriteFlags::NONE};
   std::pair<uint64_t, uint64_t> readBufferSettings_{2048, 2048};
+  std::chrono::milliseconds writeDeadline_{0};
+  size_t writeHeadroom_{0};
+  size_t writeTailroom_{0};
 
   std::shared_ptr<PipelineContext> owner_;
+  PipelineContextPool* contextPool_{nullptr};
+  std::unique_ptr<PipelineStats> stats_;
+
+  // Frontmost context per concrete context type; empty while the chain
+  // shape is dirty (before finalize() or after a structural change).
+  folly::F14FastMap<std::type_index, PipelineContext*> typedCtxs_;
 };
 
 /*
@@ -175,10 +339,38 @@ class Pipeline : public PipelineBase {
  public:
   using Ptr = std::shared_ptr<Pipeline>;
 
+  // Routes destruction through requestDeletion() so a teardown
+  // triggered from inside event dispatch is deferred until the
+  // dispatch unwinds.
+  struct UniquePtrDeleter {
+    void operator()(Pipeline* pipeline) const {
+      pipeline->requestDeletion();
+    }
+  };
+  using UniquePtr = std::unique_ptr<Pipeline, UniquePtrDeleter>;
+
   static Ptr create() {
     return std::shared_ptr<Pipeline>(new Pipeline());
   }
 
+  /**
+   * Unique-ownership alternative to create(). No shared_ptr control
+   * block is allocated for the pipeline, and event dispatch guards use
+   * a plain borrow count instead of promoting a weak_ptr per hop, so
+   * connection setup and teardown storms do no atomic refcount traffic
+   * for the pipeline itself. In exchange the pipeline is confined to
+   * its transport's EventBase: getPipelineShared() returns nullptr to
+   * handlers (they cannot extend the lifetime, only the owner can) and
+   * migrateTo() refuses to move it. Resetting the UniquePtr from inside
+   * a handler is safe; destruction is deferred until the current event
+   * finishes dispatching.
+   */
+  static UniquePtr createUnique() {
+    UniquePtr pipeline(new Pipeline());
+    pipeline->markUniquelyOwned();
+    return pipeline;
+  }
+
   ~Pipeline() override;
 
   template <class T = R>
@@ -192,6 +384,10 @@ class Pipeline : public PipelineBase {
   typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
   readException(folly::exception_wrapper e);
 
+  template <class T = R>
+  typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type readError(
+      TransportErrorCode code);
+
   template <class T = R>
   typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
   transportActive();
@@ -200,12 +396,43 @@ class Pipeline : public PipelineBase {
   typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
   transportInactive();
 
+  template <class T = R>
+  typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
+  transportWritable();
+
+  template <class T = R>
+  typename std::enable_if<!std::is_same<T, folly::Unit>::value>::type
+  transportUnwritable();
+
+  /**
+   * Move the transport to another EventBase: reads are quiesced via
+   * transportInactive(), the transport detaches from its current loop,
+   * then re-attaches and fires transportActive() on the target loop.
+   * Must be called on the current loop and only for quiescent
+   * connections: returns false without migrating when the transport
+   * still has writes in flight after the quiesce, reactivating the
+   * pipeline where it was. Callers must not have writes buffered above
+   * the transport (e.g. corked in AsyncSocketHandler) when migrating.
+   */
+  template <class T = R>
+  typename std::enable_if<!std::is_same<T, folly::Unit>::value, bool>::type
+  migrateTo(folly::EventBase* target);
+
   template <class T = W>
   typename std::enable_if<
       !std::is_same<T, folly::Unit>::value,
       folly::Future<folly::Unit>>::type
   write(W msg);
 
+  // Attempts to complete the write synchronously without allocating a
+  // promise/future pair. Returns UNSUPPORTED (leaving msg intact) if any
+  // handler in the chain lacks a fast path; the caller should then fall back
+  // to write(std::move(msg)).
+  template <class T = W>
+  typename std::
+      enable_if<!std::is_same<T, folly::Unit>::value, FastWriteResult>::type
+      writeFast(W& msg);
+
   template <class T = W>
   typename std::enable_if<
       !std::is_same<T, folly::Unit>::value,
@@ -230,6 +457,14 @@ class Pipeline : public PipelineBase {
     requestContext_ = std::move(requestContext);
   }
 
+  // Skip the RequestContext save/restore guard around pipeline events even
+  // when a context was set. Pipelines that never call setRequestContext
+  // already elide the guard; this is for callers that manage RequestContext
+  // themselves and don't want two shared_ptr round trips per message.
+  void setElideRequestContextGuard(bool elide) {
+    elideRequestContextGuard_ = elide;
+  }
+
  protected:
   Pipeline();
   explicit Pipeline(bool isStatic);
@@ -241,6 +476,7 @@ class Pipeline : public PipelineBase {
   void fillRequestContextGuard(OptionalReqCtxScopeGuard& optGuard);
 
   bool isStatic_{false};
+  bool elideRequestContextGuard_{false};
 
   InboundLink<R>* front_{nullptr};
   OutboundLink<W>* back_{nullptr};
@@ -275,34 +511,9 @@ class PipelineFactory {
   virtual ~PipelineFactory() = default;
 };
 
-struct ConnInfo {
-  folly::AsyncTransport* sock;
-  const folly::SocketAddress* clientAddr;
-  const std::string& nextProtoName;
-  SecureTransportType secureType;
-  const TransportInfo& tinfo;
-};
-
-enum class ConnEvent {
-  CONN_ADDED,
-  CONN_REMOVED,
-};
-
-typedef boost::variant<
-    folly::IOBuf*,
-    folly::AsyncTransport*,
-    ConnInfo&,
-    ConnEvent,
-    std::tuple<
-        folly::IOBuf*,
-        std::shared_ptr<folly::AsyncUDPSocket>,
-        folly::SocketAddress>,
-    std::tuple<
-        folly::IOBuf*,
-        std::shared_ptr<folly::AsyncUDPSocket>,
-        folly::SocketAddress,
-        folly::AsyncUDPSocket::ReadCallback::OnDataAvailableParams>>
-    AcceptPipelineType;
+// AcceptPipelineType (and the ConnInfo/ConnEvent alternatives it carries,
+// alongside IOBuf*, AsyncTransport* and the UDP read tuples) is defined in
+// wangle/channel/AcceptPipelineType.h.
 typedef Pipeline<AcceptPipelineType> AcceptPipeline;
 
 class AcceptPipelineFactory {
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <folly/io/IOBufQueue.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * Short-circuit relay between two pipelines, for proxy workloads that
+ * move bytes between a frontend and a backend connection untouched.
+ *
+ * Install one PipelineBridge on each pipeline, directly above the
+ * transport handler, and tie the pair together once both sides are
+ * established. Bytes read on one side are then written straight out of
+ * the peer bridge's position: they traverse only the peer's transport
+ * handler, not the handlers above either bridge, and the IOBuf chains
+ * move by pointer with no intermediate queue copy. Writes use the
+ * synchronous fast path when the chain below supports it, so the
+ * steady-state relay allocates no promise/future pairs either.
+ *
+ * Bytes read before the pair is tied are buffered and flushed by
+ * tie(), so a frontend may start talking while the backend connect is
+ * still in flight. EOF or an exception on either side tears both sides
+ * down, mirroring what a hand-written relay handler would do.
+ *
+ * Both pipelines must be driven by the same thread; the bridge keeps
+ * no locks, like any other handler.
+ */
+class PipelineBridge : public BytesToBytesHandler {
+ public:
+  /**
+   * Ties two bridge handlers into a relay and flushes any bytes either
+   * side buffered while waiting. Call once, after both handlers are
+   * attached to their pipelines.
+   */
+  static void tie(
+      std::shared_ptr<PipelineBridge> a,
+      std::shared_ptr<PipelineBridge> b) {
+    a->peer_ = b;
+    b->peer_ = a;
+    a->flushBuffered();
+    b->flushBuffered();
+  }
+
+  // Bytes this side has read and relayed to its peer, counted at the
+  // bridge so bypassing the upper handlers loses no accounting.
+  uint64_t bytesRelayed() const {
+    return bytesRelayed_;
+  }
+
+  void read(Context*, folly::IOBufQueue& q) override {
+    if (!peer_) {
+      buffer_.append(q);
+      return;
+    }
+    relay(q.move());
+  }
+
+  void readEOF(Context* ctx) override {
+    closePeer();
+    close(ctx);
+  }
+
+  void readException(Context* ctx, folly::exception_wrapper) override {
+    closePeer();
+    close(ctx);
+  }
+
+ private:
+  void flushBuffered() {
+    if (!buffer_.empty()) {
+      relay(buffer_.move());
+    }
+  }
+
+  void relay(std::unique_ptr<folly::IOBuf> buf) {
+    if (!buf || buf->empty()) {
+      return;
+    }
+    bytesRelayed_ += buf->computeChainDataLength();
+    peer_->writeBelow(std::move(buf));
+  }
+
+  // Sends a relayed chain outbound from this bridge's own position, so
+  // it only passes the handlers between the bridge and the transport.
+  void writeBelow(std::unique_ptr<folly::IOBuf> buf) {
+    auto* ctx = this->getContext();
+    if (!ctx) {
+      return;
+    }
+    if (ctx->fireWriteFast(buf) == FastWriteResult::DONE) {
+      return;
+    }
+    ctx->fireWrite(std::move(buf));
+  }
+
+  void closePeer() {
+    auto peer = std::move(peer_);
+    if (!peer) {
+      return;
+    }
+    peer->peer_.reset();
+    if (auto* peerCtx = peer->getContext()) {
+      peerCtx->fireClose();
+    }
+  }
+
+  std::shared_ptr<PipelineBridge> peer_;
+  folly::IOBufQueue buffer_{folly::IOBufQueue::cacheChainLength()};
+  uint64_t bytesRelayed_{0};
+};
+
+} // namespace wangle
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/ThreadLocal.h>
+#include <glog/logging.h>
+#include <wangle/util/MemoryAccounting.h>
+
+namespace wangle {
+
+/**
+ * A slab allocator for pipeline contexts (and other small per-connection
+ * objects with pipeline lifetime).
+ *
+ * Servers that accept many short-lived connections pay a malloc/free per
+ * handler context per connection. PipelineContextPool bump-allocates out of
+ * large slabs and recycles freed blocks on per-size free lists, so steady
+ * state connection setup does no individual heap allocations.
+ *
+ * The pool is intentionally not thread safe: the intended usage is one pool
+ * per EventBase (see getThreadLocal()), matching the thread on which
+ * pipelines are built and torn down. The pool must outlive every pipeline
+ * allocated from it; slabs are only returned to the system when the pool is
+ * destroyed.
+ */
+class PipelineContextPool {
+ public:
+  PipelineContextPool() = default;
+
+  ~PipelineContextPool() {
+    MemoryAccounting::sub(
+        MemorySubsystem::PIPELINE_CONTEXTS, slabs_.size() * kSlabSize);
+  }
+
+  PipelineContextPool(const PipelineContextPool&) = delete;
+  PipelineContextPool& operator=(const PipelineContextPool&) = delete;
+
+  void* allocate(size_t size) {
+    size = roundUp(size);
+    auto& freeList = freeLists_[size];
+    if (!freeList.empty()) {
+      void* p = freeList.back();
+      freeList.pop_back();
+      return p;
+    }
+    if (slabOffset_ + size > kSlabSize || slabs_.empty()) {
+      if (size > kSlabSize) {
+        // Oversized blocks bypass the slabs entirely.
+        MemoryAccounting::add(MemorySubsystem::PIPELINE_CONTEXTS, size);
+        return ::operator new(size);
+      }
+      slabs_.push_back(std::make_unique<char[]>(kSlabSize));
+      MemoryAccounting::add(MemorySubsystem::PIPELINE_CONTEXTS, kSlabSize);
+      slabOffset_ = 0;
+    }
+    void* p = slabs_.back().get() + slabOffset_;
+    slabOffset_ += size;
+    return p;
+  }
+
+  void deallocate(void* p, size_t size) {
+    size = roundUp(size);
+    if (size > kSlabSize) {
+      MemoryAccounting::sub(MemorySubsystem::PIPELINE_CONTEXTS, size);
+      ::operator delete(p);
+      return;
+    }
+    freeLists_[size].push_back(p);
+  }
+
+  size_t numSlabs() const {
+    return slabs_.size();
+  }
+
+  /**
+   * A lazily-constructed pool for the calling thread. Appropriate when
+   * pipelines are built and destroyed on their IO thread, as ServerAcceptor
+   * does.
+   */
+  static PipelineContextPool* getThreadLocal() {
+    static folly::ThreadLocal<PipelineContextPool> pool;
+    return pool.get();
+  }
+
+ private:
+  static constexpr size_t kSlabSize = 16 * 1024;
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+  static size_t roundUp(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  std::unordered_map<size_t, std::vector<void*>> freeLists_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  size_t slabOffset_{kSlabSize};
+};
+
+/**
+ * Minimal STL allocator over a PipelineContextPool, for use with
+ * std::allocate_shared so a context and its shared_ptr control block land in
+ * the same pooled block.
+ */
+template <class T>
+class PipelineContextPoolAllocator {
+ public:
+  using value_type = T;
+
+  explicit PipelineContextPoolAllocator(PipelineContextPool* pool)
+      : pool_(pool) {
+    CHECK(pool_);
+  }
+
+  template <class U>
+  /* implicit */ PipelineContextPoolAllocator(
+      const PipelineContextPoolAllocator<U>& other)
+      : pool_(other.pool()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    pool_->deallocate(p, n * sizeof(T));
+  }
+
+  PipelineContextPool* pool() const {
+    return pool_;
+  }
+
+ private:
+  PipelineContextPool* pool_;
+};
+
+template <class T, class U>
+bool operator==(
+    const PipelineContextPoolAllocator<T>& a,
+    const PipelineContextPoolAllocator<U>& b) {
+  return a.pool() == b.pool();
+}
+
+template <class T, class U>
+bool operator!=(
+    const PipelineContextPoolAllocator<T>& a,
+    const PipelineContextPoolAllocator<U>& b) {
+  return !(a == b);
+}
+
+} // namespace wangle
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <wangle/channel/AsyncSocketHandler.h>
+#include <wangle/channel/Pipeline.h>
+#include <wangle/channel/StaticPipeline.h>
+
+namespace wangle {
+
+/**
+ * A PipelineFactory that stamps per-connection pipelines from
+ * prototype handlers instead of rebuilding the chain handler by
+ * handler.
+ *
+ * The usual newPipeline runs create() -> N x addBack -> finalize per
+ * connection, re-deriving the same chain layout every time. Here the
+ * layout is fixed at the factory's type: each stamped pipeline is a
+ * StaticPipeline with an AsyncSocketHandler for the accepted transport
+ * at the front followed by copies of the prototypes, so handlers and
+ * their contexts land inline in one block and per-connection
+ * construction is memberwise prototype copies plus pointer wiring —
+ * no per-handler allocations, no chain vectors to grow, no layout
+ * decisions.
+ *
+ * Handlers must be copy-constructible; per-connection state belongs in
+ * the handler copy (or in HandlerStateSlot), while expensive shared
+ * state should sit behind a shared_ptr inside the prototype so every
+ * stamp references it instead of duplicating it.
+ */
+template <class R, class W, class... Handlers>
+class PrototypePipelineFactory : public PipelineFactory<Pipeline<R, W>> {
+ public:
+  using StampedPipeline =
+      StaticPipeline<R, W, AsyncSocketHandler, Handlers...>;
+
+  static_assert(
+      std::conjunction<std::is_copy_constructible<Handlers>...>::value,
+      "prototype handlers must be copy-constructible");
+
+  explicit PrototypePipelineFactory(Handlers... prototypes)
+      : prototypes_(std::move(prototypes)...) {}
+
+  typename Pipeline<R, W>::Ptr newPipeline(
+      std::shared_ptr<folly::AsyncTransport> sock) override {
+    return std::apply(
+        [&](const Handlers&... prototypes) {
+          return StampedPipeline::create(
+              AsyncSocketHandler(std::move(sock)), Handlers(prototypes)...);
+        },
+        prototypes_);
+  }
+
+ private:
+  std::tuple<Handlers...> prototypes_;
+};
+
+} // namespace wangle
@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <folly/Memory.h>
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Align.h>
+#include <folly/portability/SysMman.h>
+#include <wangle/util/MemoryAccounting.h>
+
+namespace wangle {
+
+/**
+ * A recycling pool of socket read buffers.
+ *
+ * Every read event otherwise mallocs fresh IOBuf storage and frees it
+ * when the last downstream reference drops; on high-ingest servers that
+ * is the top malloc site in the process. The pool keeps freed buffers
+ * on per-size-class free lists (power-of-two classes from 2KB to 64KB),
+ * so in steady state handing a buffer to getReadBuffer is a pointer pop
+ * and freeing a consumed read is a pointer push.
+ *
+ * Buffers leave the pool as ordinary IOBufs whose free function returns
+ * the storage here, so downstream handlers can hold, split, or queue
+ * them with no special handling. Like PipelineContextPool, the pool is
+ * intentionally not locked: one pool per EventBase (see
+ * getThreadLocal()), and a buffer freed on that same thread recycles
+ * with no atomics. Buffers that migrate and are freed on another thread
+ * fall back to a plain free, which keeps the fast path lock-free at the
+ * cost of not recycling cross-thread traffic.
+ *
+ * Optionally the pool carves its buffers out of 2MB hugepage-aligned
+ * slabs (madvise(MADV_HUGEPAGE), pre-faulted so the kernel can
+ * assemble the page up front). Bulk-transfer pipelines walk GBs of
+ * buffer memory per second, and 4KB-page-backed buffers make the
+ * sequential codec scans dTLB-bound; one 2MB mapping covers a whole
+ * slab of them. If the aligned allocation fails the pool falls back to
+ * per-buffer mallocs and stays there. Slab storage is only returned to
+ * the system when the pool is destroyed, and slab-backed buffers freed
+ * off-thread are parked on a locked sideline the owner drains, rather
+ * than leaked.
+ *
+ * The pool must outlive every IOBuf allocated from it.
+ */
+class ReadBufferPool {
+ public:
+  struct Options {
+    // Carve buffers from 2MB hugepage slabs instead of per-buffer
+    // mallocs.
+    bool hugePageSlabs{false};
+    // Slab bytes to allocate (and pre-fault) up front, rounded up to
+    // whole slabs. Only meaningful with hugePageSlabs.
+    size_t reserveBytes{0};
+  };
+
+  struct PoolStats {
+    // Buffers served by a free-list pop vs. a fresh malloc.
+    uint64_t poolHits{0};
+    uint64_t allocations{0};
+    // Requests larger than the biggest size class, served unpooled.
+    uint64_t unpooled{0};
+    // Same-thread returns accepted back into a free list.
+    uint64_t recycled{0};
+    uint64_t crossThreadFrees{0};
+    // Current free-list occupancy.
+    uint64_t pooledBuffers{0};
+    uint64_t pooledBytes{0};
+    // 2MB slabs allocated (including reserved spares).
+    uint64_t hugePageSlabs{0};
+  };
+
+  ReadBufferPool() : ReadBufferPool(Options{}) {}
+
+  explicit ReadBufferPool(Options options)
+      : ownerThread_(std::this_thread::get_id()),
+        hugePageSlabs_(options.hugePageSlabs) {
+    freeLists_.resize(kNumClasses);
+    if (hugePageSlabs_ && options.reserveBytes > 0) {
+      reserve(options.reserveBytes);
+    }
+  }
+
+  ReadBufferPool(const ReadBufferPool&) = delete;
+  ReadBufferPool& operator=(const ReadBufferPool&) = delete;
+
+  ~ReadBufferPool() {
+    for (auto& list : freeLists_) {
+      for (auto* header : list) {
+        if (!header->slabBacked) {
+          MemoryAccounting::sub(
+              MemorySubsystem::READ_BUFFERS,
+              sizeof(Header) + classBytes(header->cls));
+          std::free(header);
+        }
+      }
+    }
+    MemoryAccounting::sub(
+        MemorySubsystem::READ_BUFFERS,
+        (slabs_.size() + spareSlabs_.size()) * kSlabBytes);
+    for (auto* slab : slabs_) {
+      folly::aligned_free(slab);
+    }
+    for (auto* slab : spareSlabs_) {
+      folly::aligned_free(slab);
+    }
+  }
+
+  /**
+   * Pre-allocate (and pre-fault) slab memory, rounded up to whole 2MB
+   * slabs. Only meaningful on a hugepage-backed pool; call on the
+   * owner thread before taking traffic.
+   */
+  void reserve(size_t bytes) {
+    if (!hugePageSlabs_) {
+      return;
+    }
+    auto slabs = (bytes + kSlabBytes - 1) / kSlabBytes;
+    for (size_t i = 0; i < slabs; i++) {
+      auto* slab = newSlabMemory();
+      if (!slab) {
+        break;
+      }
+      spareSlabs_.push_back(slab);
+    }
+  }
+
+  bool isHugePageBacked() const {
+    return hugePageSlabs_;
+  }
+
+  /**
+   * An empty IOBuf with at least minSize of tailroom. Requests beyond
+   * the largest size class get a plain unpooled IOBuf.
+   */
+  std::unique_ptr<folly::IOBuf> allocate(size_t minSize) {
+    size_t cls = classFor(minSize);
+    if (cls == kNumClasses) {
+      stats_.unpooled++;
+      return folly::IOBuf::create(minSize);
+    }
+    auto& list = freeLists_[cls];
+    if (list.empty() &&
+        crossReturnsPending_.load(std::memory_order_acquire)) {
+      drainCrossThreadReturns();
+    }
+    Header* header;
+    if (!list.empty()) {
+      header = list.back();
+      list.pop_back();
+      stats_.poolHits++;
+      stats_.pooledBuffers--;
+      stats_.pooledBytes -= classBytes(cls);
+    } else {
+      const auto bytes = sizeof(Header) + classBytes(cls);
+      header = hugePageSlabs_ ? carveFromSlab(bytes) : nullptr;
+      bool slabBacked = header != nullptr;
+      if (!header) {
+        header = static_cast<Header*>(std::malloc(bytes));
+        MemoryAccounting::add(MemorySubsystem::READ_BUFFERS, bytes);
+      }
+      header->pool = this;
+      header->cls = cls;
+      header->slabBacked = slabBacked;
+      stats_.allocations++;
+    }
+    return folly::IOBuf::takeOwnership(
+        reinterpret_cast<uint8_t*>(header) + sizeof(Header),
+        classBytes(cls),
+        0,
+        recycle,
+        header);
+  }
+
+  PoolStats getPoolStats() const {
+    auto stats = stats_;
+    stats.crossThreadFrees = crossThreadFrees_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  /**
+   * A lazily-constructed pool for the calling thread, matching the
+   * one-pool-per-EventBase usage on IO threads. Constructed with the
+   * options last passed to setThreadLocalOptions (default: malloc
+   * backing).
+   */
+  static ReadBufferPool* getThreadLocal() {
+    static folly::ThreadLocal<ReadBufferPool> pool(
+        [] { return new ReadBufferPool(threadLocalOptions().copy()); });
+    return pool.get();
+  }
+
+  /**
+   * Options applied to thread-local pools constructed after this call;
+   * already-constructed pools are unaffected. ServerBootstrap calls
+   * this at group() time so IO threads come up with hugepage-backed,
+   * pre-reserved pools before taking traffic.
+   */
+  static void setThreadLocalOptions(Options options) {
+    *threadLocalOptions().wlock() = options;
+  }
+
+ private:
+  struct alignas(folly::max_align_v) Header {
+    ReadBufferPool* pool;
+    size_t cls;
+    bool slabBacked;
+  };
+
+  static constexpr size_t kMinClassBytes = 2048;
+  static constexpr size_t kNumClasses = 6; // 2KB .. 64KB
+  // Per-class cap so a burst doesn't pin buffer memory forever. Only
+  // applied to malloc-backed buffers: slab storage is committed for
+  // the pool's lifetime either way.
+  static constexpr size_t kMaxPooledPerClass = 64;
+  static constexpr size_t kSlabBytes = 2 * 1024 * 1024;
+
+  static folly::Synchronized<Options>& threadLocalOptions() {
+    static folly::Synchronized<Options> options;
+    return options;
+  }
+
+  static constexpr size_t classBytes(size_t cls) {
+    return kMinClassBytes << cls;
+  }
+
+  static size_t classFor(size_t size) {
+    size_t cls = 0;
+    while (cls < kNumClasses && classBytes(cls) < size) {
+      cls++;
+    }
+    return cls;
+  }
+
+  static void recycle(void* /* buf */, void* userData) {
+    auto* header = static_cast<Header*>(userData);
+    header->pool->returnBuffer(header);
+  }
+
+  void returnBuffer(Header* header) {
+    if (std::this_thread::get_id() != ownerThread_) {
+      crossThreadFrees_.fetch_add(1, std::memory_order_relaxed);
+      if (header->slabBacked) {
+        // Slab storage can't be freed piecemeal; park it for the
+        // owner to drain back into its free lists.
+        crossThreadReturns_.lock()->push_back(header);
+        crossReturnsPending_.store(true, std::memory_order_release);
+      } else {
+        MemoryAccounting::sub(
+            MemorySubsystem::READ_BUFFERS,
+            sizeof(Header) + classBytes(header->cls));
+        std::free(header);
+      }
+      return;
+    }
+    pushFree(header);
+  }
+
+  void pushFree(Header* header) {
+    auto& list = freeLists_[header->cls];
+    if (!header->slabBacked && list.size() >= kMaxPooledPerClass) {
+      MemoryAccounting::sub(
+          MemorySubsystem::READ_BUFFERS,
+          sizeof(Header) + classBytes(header->cls));
+      std::free(header);
+      return;
+    }
+    list.push_back(header);
+    stats_.recycled++;
+    stats_.pooledBuffers++;
+    stats_.pooledBytes += classBytes(header->cls);
+  }
+
+  void drainCrossThreadReturns() {
+    std::vector<Header*> returned;
+    crossThreadReturns_.swap(returned);
+    crossReturnsPending_.store(false, std::memory_order_release);
+    for (auto* header : returned) {
+      pushFree(header);
+    }
+  }
+
+  void* newSlabMemory() {
+    auto* slab = folly::aligned_malloc(kSlabBytes, kSlabBytes);
+    if (!slab) {
+      return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(slab, kSlabBytes, MADV_HUGEPAGE);
+#endif
+    // Pre-fault so the kernel can assemble the huge page before the
+    // slab sits on the read path.
+    std::memset(slab, 0, kSlabBytes);
+    stats_.hugePageSlabs++;
+    MemoryAccounting::add(MemorySubsystem::READ_BUFFERS, kSlabBytes);
+    return slab;
+  }
+
+  Header* carveFromSlab(size_t bytes) {
+    if (slabs_.empty() || slabOffset_ + bytes > kSlabBytes) {
+      void* slab;
+      if (!spareSlabs_.empty()) {
+        slab = spareSlabs_.back();
+        spareSlabs_.pop_back();
+      } else {
+        slab = newSlabMemory();
+      }
+      if (!slab) {
+        // Couldn't get slab memory; fall back to mallocs for good.
+        hugePageSlabs_ = false;
+        return nullptr;
+      }
+      slabs_.push_back(slab);
+      slabOffset_ = 0;
+    }
+    auto* header = reinterpret_cast<Header*>(
+        static_cast<char*>(slabs_.back()) + slabOffset_);
+    slabOffset_ += bytes;
+    return header;
+  }
+
+  const std::thread::id ownerThread_;
+  bool hugePageSlabs_;
+  std::vector<std::vector<Header*>> freeLists_;
+  std::vector<void*> slabs_;
+  std::vector<void*> spareSlabs_;
+  size_t slabOffset_{0};
+  PoolStats stats_;
+  // Owner-thread state ends here; the rest is touched by foreign
+  // threads returning buffers.
+  std::atomic<uint64_t> crossThreadFrees_{0};
+  std::atomic<bool> crossReturnsPending_{false};
+  folly::Synchronized<std::vector<Header*>> crossThreadReturns_;
+};
+
+} // namespace wangle
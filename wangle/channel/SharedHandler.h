@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * Base for handlers designed to be shared across many pipelines.
+ *
+ * A plain Handler either gets one instance per pipeline (per-connection
+ * allocations and a copy of its configuration in every one) or is shared
+ * by hand and must keep no mutable members at all. SharedHandler splits
+ * the two: members of the subclass are the immutable shared part —
+ * configuration, codecs' static tables, callbacks — and State holds the
+ * per-connection mutable part. One instance added to a million pipelines
+ * via addBack(std::shared_ptr<H>) costs one State per connection, placed
+ * in the context's inline slot (see HandlerStateSlot) rather than a
+ * separate heap object.
+ *
+ * State is default-constructed when the handler attaches and destroyed
+ * when the context detaches; access it from any event callback with
+ * state(ctx). Subclasses that override attachPipeline must call the base
+ * first so the state exists. Note that getContext() is unusable on a
+ * handler attached more than once — shared handlers should only reach
+ * their pipeline through the ctx argument of the current event.
+ */
+template <
+    class State,
+    class Rin,
+    class Rout = Rin,
+    class Win = Rout,
+    class Wout = Rin>
+class SharedHandler : public Handler<Rin, Rout, Win, Wout> {
+ public:
+  typedef typename Handler<Rin, Rout, Win, Wout>::Context Context;
+
+  void attachPipeline(Context* ctx) override {
+    ctx->getStateSlot().template emplace<State>();
+  }
+
+ protected:
+  State& state(Context* ctx) {
+    return *ctx->getStateSlot().template get<State>();
+  }
+};
+
+template <class State, class Rin, class Rout = Rin>
+class SharedInboundHandler : public InboundHandler<Rin, Rout> {
+ public:
+  typedef typename InboundHandler<Rin, Rout>::Context Context;
+
+  void attachPipeline(Context* ctx) override {
+    ctx->getStateSlot().template emplace<State>();
+  }
+
+ protected:
+  State& state(Context* ctx) {
+    return *ctx->getStateSlot().template get<State>();
+  }
+};
+
+template <class State, class Win, class Wout = Win>
+class SharedOutboundHandler : public OutboundHandler<Win, Wout> {
+ public:
+  typedef typename OutboundHandler<Win, Wout>::Context Context;
+
+  void attachPipeline(Context* ctx) override {
+    ctx->getStateSlot().template emplace<State>();
+  }
+
+ protected:
+  State& state(Context* ctx) {
+    return *ctx->getStateSlot().template get<State>();
+  }
+};
+
+} // namespace wangle
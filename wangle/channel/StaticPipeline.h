@@ -107,7 +107,7 @@ class StaticPipeline<R, W, Handler, Handlers...>
 
   void initialize() {
     CHECK(handlerPtr_);
-    ctx_.initialize(Pipeline<R, W>::shared_from_this(), handlerPtr_);
+    ctx_.initialize(this, this->ownershipRef(), handlerPtr_);
     StaticPipeline<R, W, Handlers...>::initialize();
   }
 
@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <wangle/channel/Pipeline.h>
+
+namespace wangle {
+
+/*
+ * TypedPipeline is a Pipeline whose handler chain is fixed at compile time.
+ *
+ * Unlike Pipeline (and StaticPipeline, which still routes every event
+ * through the virtual InboundLink/OutboundLink machinery), TypedPipeline
+ * stores its handlers by value in a std::tuple and resolves the next hop of
+ * every read/write at compile time. Handler invocations are direct calls on
+ * concrete objects, so the compiler is free to inline the entire chain; the
+ * only remaining virtual dispatch is the handler's own call back into its
+ * HandlerContext, which existing handlers take by base pointer.
+ *
+ * Handlers are constructed in place, front to back:
+ *
+ *   auto pipeline = TypedPipeline<
+ *       folly::IOBufQueue&, std::unique_ptr<folly::IOBuf>,
+ *       AsyncSocketHandler,
+ *       LineBasedFrameDecoder,
+ *       MyDispatcher>::create(
+ *           AsyncSocketHandler(socket),
+ *           LineBasedFrameDecoder(),
+ *           MyDispatcher());
+ *
+ * The usual PipelineBase facilities (transport, manager, getContext) work as
+ * for any other pipeline. Handlers must be movable; abstract handlers are not
+ * supported. The chain cannot be mutated after construction -- addBack() and
+ * friends must not be used.
+ */
+template <class R, class W, class... Handlers>
+class TypedPipeline;
+
+namespace typed_pipeline_detail {
+
+constexpr bool handlesInbound(HandlerDir dir) {
+  return dir != HandlerDir::OUT;
+}
+
+constexpr bool handlesOutbound(HandlerDir dir) {
+  return dir != HandlerDir::IN;
+}
+
+template <class... Handlers>
+constexpr size_t nextInboundFrom(size_t from) {
+  std::array<HandlerDir, sizeof...(Handlers)> dirs{{Handlers::dir...}};
+  for (size_t i = from; i < dirs.size(); i++) {
+    if (handlesInbound(dirs[i])) {
+      return i;
+    }
+  }
+  return dirs.size();
+}
+
+// Returns sizeof...(Handlers) as an off-the-front sentinel, mirroring
+// nextInboundFrom's off-the-back sentinel.
+template <class... Handlers>
+constexpr size_t prevOutboundFrom(std::ptrdiff_t from) {
+  std::array<HandlerDir, sizeof...(Handlers)> dirs{{Handlers::dir...}};
+  for (std::ptrdiff_t i = from; i >= 0; i--) {
+    if (handlesOutbound(dirs[i])) {
+      return static_cast<size_t>(i);
+    }
+  }
+  return dirs.size();
+}
+
+template <class P, size_t I, class H, HandlerDir D = H::dir>
+class TypedContext;
+
+// Bookkeeping shared by the three direction-specific contexts. Implements
+// PipelineContext so the contexts can live in PipelineBase::ctxs_ and so
+// attach/detach go through the usual attachCount_ accounting.
+template <class P, class H, class Impl>
+class TypedContextBase : public PipelineContext {
+ public:
+  ~TypedContextBase() override = default;
+
+  H* getHandler() {
+    return handler_;
+  }
+
+  void initialize(P* pipeline, H* handler) {
+    pipelineWeak_ = pipeline->ownershipRef();
+    pipelineRaw_ = pipeline;
+    handler_ = handler;
+  }
+
+  // PipelineContext overrides
+  void attachPipeline() override {
+    if (!attached_) {
+      this->attachContext(handler_, impl_);
+      handler_->attachPipeline(impl_);
+      attached_ = true;
+    }
+  }
+
+  void detachPipeline() override {
+    handler_->detachPipeline(impl_);
+    attached_ = false;
+    stateSlot_.reset();
+    this->detachContext(handler_, impl_);
+  }
+
+  // The chain is wired at compile time; there is nothing to link.
+  void setNextIn(PipelineContext* /*ctx*/) override {}
+  void setNextOut(PipelineContext* /*ctx*/) override {}
+
+  HandlerDir getDirection() override {
+    return H::dir;
+  }
+
+ protected:
+  Impl* impl_;
+  std::weak_ptr<PipelineBase> pipelineWeak_;
+  P* pipelineRaw_{nullptr};
+  H* handler_{nullptr};
+  HandlerStateSlot stateSlot_;
+
+ private:
+  bool attached_{false};
+};
+
+template <class P, size_t I, class H>
+class TypedContext<P, I, H, HandlerDir::BOTH> final
+    : public HandlerContext<typename H::rout, typename H::wout>,
+      public TypedContextBase<
+          P,
+          H,
+          HandlerContext<typename H::rout, typename H::wout>> {
+ public:
+  typedef typename H::rout Rout;
+  typedef typename H::wout Wout;
+  static const HandlerDir dir = HandlerDir::BOTH;
+
+  TypedContext() {
+    this->impl_ = this;
+  }
+
+  ~TypedContext() override = default;
+
+  // HandlerContext overrides
+  void fireRead(Rout msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readAt<P::nextInboundAfter(I)>(
+        std::forward<Rout>(msg));
+  }
+
+  void fireReadEOF() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readEOFAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireReadException(folly::exception_wrapper e) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readExceptionAt<P::nextInboundAfter(I)>(
+        std::move(e));
+  }
+
+  void fireReadError(TransportErrorCode code) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readErrorAt<P::nextInboundAfter(I)>(code);
+  }
+
+  void fireTransportActive() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template transportActiveAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireTransportInactive() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template transportInactiveAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireTransportWritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template transportWritableAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireTransportUnwritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_
+        ->template transportUnwritableAt<P::nextInboundAfter(I)>();
+  }
+
+  folly::Future<folly::Unit> fireWrite(Wout msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    return this->pipelineRaw_->template writeAt<P::prevOutboundBefore(I)>(
+        std::forward<Wout>(msg));
+  }
+
+  folly::Future<folly::Unit> fireWriteException(
+      folly::exception_wrapper e) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    return this->pipelineRaw_
+        ->template writeExceptionAt<P::prevOutboundBefore(I)>(std::move(e));
+  }
+
+  folly::Future<folly::Unit> fireClose() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    return this->pipelineRaw_->template closeAt<P::prevOutboundBefore(I)>();
+  }
+
+  PipelineBase* getPipeline() override {
+    return this->pipelineRaw_;
+  }
+
+  std::shared_ptr<PipelineBase> getPipelineShared() override {
+    return this->pipelineWeak_.lock();
+  }
+
+  void setWriteFlags(folly::WriteFlags flags) override {
+    this->pipelineRaw_->setWriteFlags(flags);
+  }
+
+  folly::WriteFlags getWriteFlags() override {
+    return this->pipelineRaw_->getWriteFlags();
+  }
+
+  void setReadBufferSettings(uint64_t minAvailable, uint64_t allocationSize)
+      override {
+    this->pipelineRaw_->setReadBufferSettings(minAvailable, allocationSize);
+  }
+
+  std::pair<uint64_t, uint64_t> getReadBufferSettings() override {
+    return this->pipelineRaw_->getReadBufferSettings();
+  }
+
+  HandlerStateSlot& getStateSlot() override {
+    return this->stateSlot_;
+  }
+};
+
+template <class P, size_t I, class H>
+class TypedContext<P, I, H, HandlerDir::IN> final
+    : public InboundHandlerContext<typename H::rout>,
+      public TypedContextBase<P, H, InboundHandlerContext<typename H::rout>> {
+ public:
+  typedef typename H::rout Rout;
+  static const HandlerDir dir = HandlerDir::IN;
+
+  TypedContext() {
+    this->impl_ = this;
+  }
+
+  ~TypedContext() override = default;
+
+  // InboundHandlerContext overrides
+  void fireRead(Rout msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readAt<P::nextInboundAfter(I)>(
+        std::forward<Rout>(msg));
+  }
+
+  void fireReadEOF() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readEOFAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireReadException(folly::exception_wrapper e) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readExceptionAt<P::nextInboundAfter(I)>(
+        std::move(e));
+  }
+
+  void fireReadError(TransportErrorCode code) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template readErrorAt<P::nextInboundAfter(I)>(code);
+  }
+
+  void fireTransportActive() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template transportActiveAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireTransportInactive() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template transportInactiveAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireTransportWritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_->template transportWritableAt<P::nextInboundAfter(I)>();
+  }
+
+  void fireTransportUnwritable() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    this->pipelineRaw_
+        ->template transportUnwritableAt<P::nextInboundAfter(I)>();
+  }
+
+  PipelineBase* getPipeline() override {
+    return this->pipelineRaw_;
+  }
+
+  std::shared_ptr<PipelineBase> getPipelineShared() override {
+    return this->pipelineWeak_.lock();
+  }
+
+  HandlerStateSlot& getStateSlot() override {
+    return this->stateSlot_;
+  }
+};
+
+template <class P, size_t I, class H>
+class TypedContext<P, I, H, HandlerDir::OUT> final
+    : public OutboundHandlerContext<typename H::wout>,
+      public TypedContextBase<P, H, OutboundHandlerContext<typename H::wout>> {
+ public:
+  typedef typename H::wout Wout;
+  static const HandlerDir dir = HandlerDir::OUT;
+
+  TypedContext() {
+    this->impl_ = this;
+  }
+
+  ~TypedContext() override = default;
+
+  // OutboundHandlerContext overrides
+  folly::Future<folly::Unit> fireWrite(Wout msg) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    return this->pipelineRaw_->template writeAt<P::prevOutboundBefore(I)>(
+        std::forward<Wout>(msg));
+  }
+
+  folly::Future<folly::Unit> fireWriteException(
+      folly::exception_wrapper e) override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    return this->pipelineRaw_
+        ->template writeExceptionAt<P::prevOutboundBefore(I)>(std::move(e));
+  }
+
+  folly::Future<folly::Unit> fireClose() override {
+    PipelineEventGuard guard(this->pipelineWeak_, this->pipelineRaw_);
+    return this->pipelineRaw_->template closeAt<P::prevOutboundBefore(I)>();
+  }
+
+  PipelineBase* getPipeline() override {
+    return this->pipelineRaw_;
+  }
+
+  std::shared_ptr<PipelineBase> getPipelineShared() override {
+    return this->pipelineWeak_.lock();
+  }
+
+  HandlerStateSlot& getStateSlot() override {
+    return this->stateSlot_;
+  }
+};
+
+template <class P, class Indices, class... Hs>
+struct ContextTuple;
+
+template <class P, size_t... Is, class... Hs>
+struct ContextTuple<P, std::index_sequence<Is...>, Hs...> {
+  using type = std::tuple<TypedContext<P, Is, Hs>...>;
+};
+
+} // namespace typed_pipeline_detail
+
+template <class R, class W, class... Handlers>
+class TypedPipeline : public PipelineBase {
+ public:
+  using Ptr = std::shared_ptr<TypedPipeline>;
+
+  static constexpr size_t kNumHandlers = sizeof...(Handlers);
+  static_assert(kNumHandlers > 0, "TypedPipeline requires at least 1 handler");
+
+  template <class... HandlerArgs>
+  static Ptr create(HandlerArgs&&... handlers) {
+    auto ptr = std::shared_ptr<TypedPipeline>(
+        new TypedPipeline(std::forward<HandlerArgs>(handlers)...));
+    ptr->finalize();
+    return ptr;
+  }
+
+  ~TypedPipeline() override {
+    detachHandlers();
+  }
+
+  static constexpr size_t nextInboundAfter(size_t i) {
+    return typed_pipeline_detail::nextInboundFrom<Handlers...>(i + 1);
+  }
+
+  static constexpr size_t prevOutboundBefore(size_t i) {
+    return typed_pipeline_detail::prevOutboundFrom<Handlers...>(
+        static_cast<std::ptrdiff_t>(i) - 1);
+  }
+
+  void read(R msg) {
+    readAt<typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>(
+        std::forward<R>(msg));
+  }
+
+  void readEOF() {
+    readEOFAt<typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>();
+  }
+
+  void readException(folly::exception_wrapper e) {
+    readExceptionAt<typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>(
+        std::move(e));
+  }
+
+  void readError(TransportErrorCode code) {
+    readErrorAt<typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>(code);
+  }
+
+  void transportActive() {
+    transportActiveAt<typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>();
+  }
+
+  void transportInactive() {
+    transportInactiveAt<
+        typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>();
+  }
+
+  void transportWritable() {
+    transportWritableAt<
+        typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>();
+  }
+
+  void transportUnwritable() {
+    transportUnwritableAt<
+        typed_pipeline_detail::nextInboundFrom<Handlers...>(0)>();
+  }
+
+  folly::Future<folly::Unit> write(W msg) {
+    return writeAt<typed_pipeline_detail::prevOutboundFrom<Handlers...>(
+        kNumHandlers - 1)>(std::forward<W>(msg));
+  }
+
+  folly::Future<folly::Unit> writeException(folly::exception_wrapper e) {
+    return writeExceptionAt<typed_pipeline_detail::prevOutboundFrom<
+        Handlers...>(kNumHandlers - 1)>(std::move(e));
+  }
+
+  folly::Future<folly::Unit> close() {
+    return closeAt<typed_pipeline_detail::prevOutboundFrom<Handlers...>(
+        kNumHandlers - 1)>();
+  }
+
+  template <size_t I>
+  auto& getHandlerAt() {
+    return std::get<I>(handlers_);
+  }
+
+  void finalize() override {
+    initializeContexts(std::make_index_sequence<kNumHandlers>{});
+    for (auto it = ctxs_.rbegin(); it != ctxs_.rend(); it++) {
+      (*it)->attachPipeline();
+    }
+  }
+
+  // Event dispatch at a specific handler index. Public so the contexts can
+  // reach back in; not intended to be called by user code directly.
+  template <size_t I, class Msg>
+  void readAt(Msg&& msg) {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "read reached end of pipeline";
+    } else {
+      std::get<I>(handlers_).read(
+          &std::get<I>(typedCtxs_), std::forward<Msg>(msg));
+    }
+  }
+
+  template <size_t I>
+  void readEOFAt() {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "readEOF reached end of pipeline";
+    } else {
+      std::get<I>(handlers_).readEOF(&std::get<I>(typedCtxs_));
+    }
+  }
+
+  template <size_t I>
+  void readExceptionAt(folly::exception_wrapper e) {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "readException reached end of pipeline";
+    } else {
+      std::get<I>(handlers_).readException(
+          &std::get<I>(typedCtxs_), std::move(e));
+    }
+  }
+
+  template <size_t I>
+  void readErrorAt(TransportErrorCode code) {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "readError reached end of pipeline";
+    } else {
+      std::get<I>(handlers_).readError(&std::get<I>(typedCtxs_), code);
+    }
+  }
+
+  template <size_t I>
+  void transportActiveAt() {
+    if constexpr (I < kNumHandlers) {
+      std::get<I>(handlers_).transportActive(&std::get<I>(typedCtxs_));
+    }
+  }
+
+  template <size_t I>
+  void transportInactiveAt() {
+    if constexpr (I < kNumHandlers) {
+      std::get<I>(handlers_).transportInactive(&std::get<I>(typedCtxs_));
+    }
+  }
+
+  template <size_t I>
+  void transportWritableAt() {
+    if constexpr (I < kNumHandlers) {
+      std::get<I>(handlers_).transportWritable(&std::get<I>(typedCtxs_));
+    }
+  }
+
+  template <size_t I>
+  void transportUnwritableAt() {
+    if constexpr (I < kNumHandlers) {
+      std::get<I>(handlers_).transportUnwritable(&std::get<I>(typedCtxs_));
+    }
+  }
+
+  template <size_t I, class Msg>
+  folly::Future<folly::Unit> writeAt(Msg&& msg) {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "write reached end of pipeline";
+      return folly::makeFuture();
+    } else {
+      return std::get<I>(handlers_).write(
+          &std::get<I>(typedCtxs_), std::forward<Msg>(msg));
+    }
+  }
+
+  template <size_t I>
+  folly::Future<folly::Unit> writeExceptionAt(folly::exception_wrapper e) {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "writeException reached end of pipeline";
+      return folly::makeFuture();
+    } else {
+      return std::get<I>(handlers_).writeException(
+          &std::get<I>(typedCtxs_), std::move(e));
+    }
+  }
+
+  template <size_t I>
+  folly::Future<folly::Unit> closeAt() {
+    if constexpr (I >= kNumHandlers) {
+      LOG(WARNING) << "close reached end of pipeline";
+      return folly::makeFuture();
+    } else {
+      return std::get<I>(handlers_).close(&std::get<I>(typedCtxs_));
+    }
+  }
+
+ protected:
+  template <class... HandlerArgs>
+  explicit TypedPipeline(HandlerArgs&&... handlers)
+      : handlers_(std::forward<HandlerArgs>(handlers)...) {
+    registerContexts(std::make_index_sequence<kNumHandlers>{});
+  }
+
+ private:
+  using CtxTuple = typename typed_pipeline_detail::ContextTuple<
+      TypedPipeline,
+      std::index_sequence_for<Handlers...>,
+      Handlers...>::type;
+
+  template <size_t... Is>
+  void registerContexts(std::index_sequence<Is...>) {
+    // addContextFront prepends, so register back to front to end up with
+    // the declared order.
+    (addContextFront(&std::get<kNumHandlers - 1 - Is>(typedCtxs_)), ...);
+  }
+
+  template <size_t... Is>
+  void initializeContexts(std::index_sequence<Is...>) {
+    (std::get<Is>(typedCtxs_).initialize(this, &std::get<Is>(handlers_)),
+     ...);
+  }
+
+  std::tuple<Handlers...> handlers_;
+  CtxTuple typedCtxs_;
+};
+
+} // namespace wangle
@@ -28,6 +28,8 @@ template <typename T, typename R>
 void BroadcastHandler<T, R>::readEOF(Context*) {
   forEachSubscriber([&](Subscriber<T, R>* s) { s->onCompleted(); });
   subscribers_.clear();
+  subscriberIndex_.clear();
+  clearPins();
   closeIfIdle();
 }
 
@@ -40,36 +42,150 @@ void BroadcastHandler<T, R>::readException(
 
   forEachSubscriber([&](Subscriber<T, R>* s) { s->onError(ex); });
   subscribers_.clear();
+  subscriberIndex_.clear();
+  clearPins();
   closeIfIdle();
 }
 
 template <typename T, typename R>
 uint64_t BroadcastHandler<T, R>::subscribe(Subscriber<T, R>* subscriber) {
   auto subscriptionId = nextSubscriptionId_++;
-  subscribers_[subscriptionId] = subscriber;
+  subscriberIndex_[subscriptionId] = subscribers_.size();
+  subscribers_.push_back({subscriptionId, subscriber});
+  // A subscriber arrived; the broadcast is no longer idle.
+  lingerTimeout_.reset();
   onSubscribe(subscriber);
   return subscriptionId;
 }
 
 template <typename T, typename R>
 void BroadcastHandler<T, R>::unsubscribe(uint64_t subscriptionId) {
-  auto iter = subscribers_.find(subscriptionId);
-  if (iter == subscribers_.end()) {
+  auto iter = subscriberIndex_.find(subscriptionId);
+  if (iter == subscriberIndex_.end()) {
     return;
   }
 
-  onUnsubscribe(iter->second);
-  subscribers_.erase(iter);
+  auto index = iter->second;
+  auto* subscriber = subscribers_[index].subscriber;
+  subscriberIndex_.erase(iter);
+
+  onUnsubscribe(subscriber);
+
+  if (fanOutDepth_ > 0) {
+    // Mid-fan-out: null the slot so the in-flight scan skips it, and
+    // compact once the outermost scan finishes.
+    subscribers_[index].subscriber = nullptr;
+    hasDeferredRemovals_ = true;
+  } else {
+    if (index != subscribers_.size() - 1) {
+      subscribers_[index] = subscribers_.back();
+      subscriberIndex_[subscribers_[index].subscriptionId] = index;
+    }
+    subscribers_.pop_back();
+  }
   closeIfIdle();
 }
 
+template <typename T, typename R>
+void BroadcastHandler<T, R>::compactSubscribers() {
+  size_t i = 0;
+  while (i < subscribers_.size()) {
+    if (subscribers_[i].subscriber) {
+      ++i;
+      continue;
+    }
+    subscribers_[i] = subscribers_.back();
+    subscribers_.pop_back();
+    // The entry moved into the hole may itself be a hole; re-examine it
+    // before advancing.
+    if (i < subscribers_.size() && subscribers_[i].subscriber) {
+      subscriberIndex_[subscribers_[i].subscriptionId] = i;
+    }
+  }
+  hasDeferredRemovals_ = false;
+}
+
 template <typename T, typename R>
 void BroadcastHandler<T, R>::closeIfIdle() {
-  if (subscribers_.empty()) {
-    // No more subscribers. Clean up.
-    // This will delete the broadcast from the pool.
-    this->close(this->getContext());
+  // The index holds only live subscriptions; the dense array may still
+  // contain slots awaiting compaction mid-fan-out.
+  if (!subscriberIndex_.empty()) {
+    return;
+  }
+  if (pinCount_ > 0) {
+    // Pinned broadcasts ride out subscriber gaps, but only up to the
+    // configured linger.
+    maybeScheduleLingerTimeout();
+    return;
+  }
+  // No more subscribers. Clean up.
+  // This will delete the broadcast from the pool.
+  this->close(this->getContext());
+}
+
+template <typename T, typename R>
+void BroadcastHandler<T, R>::pin(std::chrono::milliseconds idleLinger) {
+  ++pinCount_;
+  idleLinger_ = idleLinger;
+  if (subscriberIndex_.empty()) {
+    maybeScheduleLingerTimeout();
+  }
+}
+
+template <typename T, typename R>
+void BroadcastHandler<T, R>::unpin() {
+  if (pinCount_ == 0) {
+    return;
+  }
+  if (--pinCount_ == 0) {
+    lingerTimeout_.reset();
+    closeIfIdle();
+  }
+}
+
+template <typename T, typename R>
+void BroadcastHandler<T, R>::clearPins() {
+  pinCount_ = 0;
+  lingerTimeout_.reset();
+}
+
+template <typename T, typename R>
+void BroadcastHandler<T, R>::maybeScheduleLingerTimeout() {
+  if (idleLinger_.count() <= 0 || lingerTimeout_) {
+    return;
+  }
+  auto* ctx = this->getContext();
+  if (!ctx) {
+    return;
+  }
+  auto* evb = ctx->getTransportRaw()->getEventBase();
+  if (!evb) {
+    return;
+  }
+  lingerTimeout_ = folly::AsyncTimeout::make(*evb, [this]() noexcept {
+    clearPins();
+    closeIfIdle();
+  });
+  lingerTimeout_->scheduleTimeout(idleLinger_);
+}
+
+template <typename T, typename R>
+typename BroadcastHandler<T, R>::SubscriberLagSnapshot
+BroadcastHandler<T, R>::getSubscriberLag(uint64_t lagThreshold) const {
+  SubscriberLagSnapshot snapshot;
+  for (const auto& entry : subscribers_) {
+    if (!entry.subscriber) {
+      continue;
+    }
+    auto lag = entry.subscriber->pendingLag();
+    snapshot.subscribers++;
+    snapshot.totalLag += lag;
+    snapshot.maxLag = std::max(snapshot.maxLag, lag);
+    if (lag > lagThreshold) {
+      snapshot.laggingSubscribers++;
+    }
   }
+  return snapshot;
 }
 
 template <typename T, typename R>
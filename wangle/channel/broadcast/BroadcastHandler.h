@@ -16,6 +16,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+
+#include <folly/container/F14Map.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <wangle/channel/AsyncSocketHandler.h>
 #include <wangle/channel/Handler.h>
 #include <wangle/channel/Pipeline.h>
@@ -26,6 +31,12 @@ namespace wangle {
 /**
  * An Observable type handler for broadcasting/streaming data to a list
  * of subscribers.
+ *
+ * Fan-out hands every subscriber a const reference to the same message,
+ * so for buffer streams a refcounted payload (e.g. T =
+ * std::shared_ptr<folly::IOBuf>) together with SharedIOBufWriteHandler on
+ * the subscriber pipelines broadcasts one snapshot of each packet with no
+ * per-subscriber payload copy.
  */
 template <typename T, typename R>
 class BroadcastHandler
@@ -35,7 +46,7 @@ class BroadcastHandler
       Context;
 
   ~BroadcastHandler() override {
-    CHECK(subscribers_.empty());
+    CHECK(subscriberIndex_.empty());
   }
 
   // BytesToBytesHandler implementation
@@ -58,9 +69,32 @@ class BroadcastHandler
   /**
    * If there are no subscribers listening to the broadcast, close the pipeline.
    * This will also delete the broadcast from the BroadcastPool.
+   *
+   * A pinned broadcast is not considered idle; see pin().
    */
   virtual void closeIfIdle();
 
+  /**
+   * Pins the broadcast: while at least one pin is held, an idle
+   * broadcast stays connected through subscriber gaps instead of
+   * closing when the last subscriber leaves. If idleLinger is
+   * non-zero, a pinned broadcast that stays idle for that long is
+   * closed anyway, bounding how long an unwatched upstream is held;
+   * the last pin's linger value wins. Pins do not survive upstream
+   * EOF or errors.
+   */
+  void pin(std::chrono::milliseconds idleLinger = std::chrono::milliseconds(0));
+
+  /**
+   * Releases one pin. When the last pin is released and there are no
+   * subscribers, the broadcast is closed.
+   */
+  void unpin();
+
+  bool isPinned() const {
+    return pinCount_ > 0;
+  }
+
   /**
    * Invoked when a new subscriber is added. Subclasses can override
    * to add custom behavior.
@@ -79,6 +113,21 @@ class BroadcastHandler
    */
   virtual void onData(T& /* data */) {}
 
+  /**
+   * Point-in-time view of how far subscribers are behind the broadcast,
+   * aggregated from Subscriber::pendingLag(). laggingSubscribers counts
+   * those whose lag exceeds the given threshold, for spotting
+   * stragglers before they hurt.
+   */
+  struct SubscriberLagSnapshot {
+    uint64_t subscribers{0};
+    uint64_t totalLag{0};
+    uint64_t maxLag{0};
+    uint64_t laggingSubscribers{0};
+  };
+
+  SubscriberLagSnapshot getSubscriberLag(uint64_t lagThreshold = 0) const;
+
   /**
    * FOR TESTS ONLY!
    * Return a unique identifier of this object.
@@ -88,16 +137,50 @@ class BroadcastHandler
  protected:
   template <typename FUNC> // FUNC: Subscriber<T, R>* -> void
   void forEachSubscriber(FUNC f) {
-    auto subscribers = subscribers_;
-    for (const auto& it : subscribers) {
-      f(it.second);
+    // The registry is a dense array, so fan-out is a straight linear scan
+    // with no snapshot copy. Unsubscribes during the scan null their slot
+    // (skipped below) and are compacted once the outermost scan returns;
+    // subscribers added during the scan land past the cached bound and
+    // only see subsequent messages.
+    ++fanOutDepth_;
+    const size_t count = subscribers_.size();
+    for (size_t i = 0; i < count; ++i) {
+      if (auto* subscriber = subscribers_[i].subscriber) {
+        f(subscriber);
+      }
+    }
+    if (--fanOutDepth_ == 0 && hasDeferredRemovals_) {
+      compactSubscribers();
     }
   }
 
  private:
-  std::map<uint64_t, Subscriber<T, R>*> subscribers_;
+  struct SubscriberEntry {
+    uint64_t subscriptionId;
+    Subscriber<T, R>* subscriber;
+  };
+
+  // Drops all pins, e.g. because the upstream connection went away.
+  void clearPins();
+
+  // Starts the idle linger clock for a pinned, idle broadcast.
+  void maybeScheduleLingerTimeout();
+
+  // Swap-removes slots nulled by unsubscribes that arrived mid-fan-out.
+  void compactSubscribers();
+
+  // Fan-out set as a dense array; subscriberIndex_ maps subscription id
+  // to slot for O(1) swap-removal and carries the live subscriber count.
+  std::vector<SubscriberEntry> subscribers_;
+  folly::F14FastMap<uint64_t, size_t> subscriberIndex_;
+  uint32_t fanOutDepth_{0};
+  bool hasDeferredRemovals_{false};
   uint64_t nextSubscriptionId_{0};
 
+  uint32_t pinCount_{0};
+  std::chrono::milliseconds idleLinger_{0};
+  std::unique_ptr<folly::AsyncTimeout> lingerTimeout_;
+
   // For unit tests only.
   uint64_t identifier_{0};
 };
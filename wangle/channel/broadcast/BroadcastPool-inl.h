@@ -37,6 +37,7 @@ BroadcastPool<T, R, P>::BroadcastManager::getHandler() {
 
   // Kickoff connect request and fulfill all pending promises on completion
   connectStarted_ = true;
+  connectStartTime_ = std::chrono::steady_clock::now();
 
   broadcastPool_->serverPool_->connect(client_.get(), routingData_)
       .thenValue([this](DefaultPipeline* pipeline) {
@@ -61,6 +62,13 @@ BroadcastPool<T, R, P>::BroadcastManager::getHandler() {
 
         auto handler = pipelineFactory->getBroadcastHandler(pipeline);
         CHECK(handler);
+        handler_ = handler;
+
+        broadcastPool_->serverPool_->onConnectSuccess(
+            routingData_,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - connectStartTime_));
+
         sharedPromise_.setValue(handler);
 
         // If all the observers go away before connect returns, then the
@@ -89,6 +97,8 @@ void BroadcastPool<T, R, P>::BroadcastManager::handleConnectError(
     const std::exception& ex) noexcept {
   LOG(ERROR) << "Error connecting to upstream: " << ex.what();
 
+  broadcastPool_->serverPool_->onConnectError(routingData_);
+
   auto sharedPromise = std::move(sharedPromise_);
   broadcastPool_->deleteBroadcast(routingData_);
   sharedPromise.setException(folly::make_exception_wrapper<std::exception>(ex));
@@ -99,9 +109,17 @@ folly::Future<BroadcastHandler<T, R>*> BroadcastPool<T, R, P>::getHandler(
     const R& routingData) {
   const auto& iter = broadcasts_.find(routingData);
   if (iter != broadcasts_.end()) {
+    stats_.warmAttaches++;
+    if (auto* handler = iter->second->getHandlerIfConnected()) {
+      // Already connected: hand the handler back without allocating a
+      // promise/future pair off the SharedPromise. The future is completed,
+      // so the caller's continuation runs inline as documented.
+      return folly::makeFuture(handler);
+    }
     return iter->second->getHandler();
   }
 
+  stats_.coldStarts++;
   typename BroadcastManager::UniquePtr broadcast(
       new BroadcastManager(this, routingData));
 
@@ -114,4 +132,53 @@ folly::Future<BroadcastHandler<T, R>*> BroadcastPool<T, R, P>::getHandler(
   return broadcastPtr->getHandler();
 }
 
+template <typename T, typename R, typename P>
+folly::Future<folly::Unit> BroadcastPool<T, R, P>::prewarm(
+    const R& routingData) {
+  stats_.prewarms++;
+  auto iter = broadcasts_.find(routingData);
+  if (iter == broadcasts_.end()) {
+    typename BroadcastManager::UniquePtr broadcast(
+        new BroadcastManager(this, routingData));
+    iter = broadcasts_
+               .insert(std::make_pair(routingData, std::move(broadcast)))
+               .first;
+  }
+  // The pin runs inline when the connect completes, ahead of the
+  // manager's own closeIfIdle(), so the subscriberless broadcast
+  // survives until demand arrives.
+  return iter->second->getHandler().thenValue(
+      [linger = pinIdleLinger_](BroadcastHandler<T, R>* handler) {
+        handler->pin(linger);
+      });
+}
+
+template <typename T, typename R, typename P>
+bool BroadcastPool<T, R, P>::pin(const R& routingData) {
+  auto iter = broadcasts_.find(routingData);
+  if (iter == broadcasts_.end()) {
+    return false;
+  }
+  // Runs inline if already connected, or on connect completion; a
+  // failed connect deletes the broadcast and there is nothing to pin.
+  iter->second->getHandler()
+      .thenValue([linger = pinIdleLinger_](BroadcastHandler<T, R>* handler) {
+        handler->pin(linger);
+      })
+      .thenError(folly::tag_t<std::exception>{}, [](const std::exception&) {});
+  return true;
+}
+
+template <typename T, typename R, typename P>
+bool BroadcastPool<T, R, P>::unpin(const R& routingData) {
+  auto iter = broadcasts_.find(routingData);
+  if (iter == broadcasts_.end()) {
+    return false;
+  }
+  iter->second->getHandler()
+      .thenValue([](BroadcastHandler<T, R>* handler) { handler->unpin(); })
+      .thenError(folly::tag_t<std::exception>{}, [](const std::exception&) {});
+  return true;
+}
+
 } // namespace wangle
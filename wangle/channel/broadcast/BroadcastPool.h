@@ -16,7 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Random.h>
+#include <folly/SocketAddress.h>
 #include <folly/ThreadLocal.h>
+#include <folly/container/F14Map.h>
 #include <folly/futures/SharedPromise.h>
 #include <folly/io/async/DelayedDestruction.h>
 #include <wangle/bootstrap/BaseClientBootstrap.h>
@@ -38,6 +46,175 @@ class ServerPool {
   virtual folly::Future<P*> connect(
       BaseClientBootstrap<P>* client,
       const R& routingData) noexcept = 0;
+
+  /**
+   * Feedback from BroadcastManager on the outcome of a connect() it
+   * kicked off, keyed by the same routing data. Pools that track
+   * per-server health override these to steer future picks; the
+   * defaults ignore the feedback.
+   */
+  virtual void onConnectSuccess(
+      const R& /* routingData */,
+      std::chrono::microseconds /* connectLatency */) noexcept {}
+
+  virtual void onConnectError(const R& /* routingData */) noexcept {}
+};
+
+/**
+ * A ServerPool over a fixed set of upstream addresses that uses the
+ * connect feedback to prefer healthy, fast origins. Each server keeps
+ * an EWMA of its connect latency; selection is weighted by the inverse
+ * of that EWMA, so a degrading origin sheds new broadcasts in
+ * proportion to how badly it lags. A run of consecutive connect
+ * failures opens a circuit for that server: it is skipped entirely
+ * until a backoff elapses, after which the next pick may probe it
+ * again.
+ *
+ * Like BroadcastPool itself, an instance is meant to be used from a
+ * single thread.
+ */
+template <typename R, typename P = DefaultPipeline>
+class WeightedServerPool : public ServerPool<R, P> {
+ public:
+  struct ServerStats {
+    folly::SocketAddress address;
+    // Connect latency EWMA in microseconds; 0 until the first sample.
+    double ewmaLatencyUs{0};
+    uint32_t consecutiveFailures{0};
+    // When an open circuit allows the next probe.
+    std::chrono::steady_clock::time_point retryAfter;
+    uint64_t connects{0};
+    uint64_t failures{0};
+  };
+
+  explicit WeightedServerPool(
+      std::vector<folly::SocketAddress> servers,
+      double ewmaWeight = 0.2,
+      uint32_t circuitFailureThreshold = 3,
+      std::chrono::milliseconds circuitBreakDuration =
+          std::chrono::seconds(5))
+      : ewmaWeight_(ewmaWeight),
+        circuitFailureThreshold_(circuitFailureThreshold),
+        circuitBreakDuration_(circuitBreakDuration) {
+    CHECK(!servers.empty());
+    servers_.reserve(servers.size());
+    for (auto& address : servers) {
+      ServerStats stats;
+      stats.address = std::move(address);
+      servers_.push_back(std::move(stats));
+    }
+  }
+
+  folly::Future<P*> connect(
+      BaseClientBootstrap<P>* client,
+      const R& routingData) noexcept override {
+    auto idx = pickServer();
+    if (!idx) {
+      return folly::makeFuture<P*>(
+          folly::make_exception_wrapper<std::runtime_error>(
+              "all upstream servers are circuit-broken"));
+    }
+    pendingPicks_[routingData] = *idx;
+    return client->connect(servers_[*idx].address);
+  }
+
+  void onConnectSuccess(
+      const R& routingData,
+      std::chrono::microseconds connectLatency) noexcept override {
+    auto it = pendingPicks_.find(routingData);
+    if (it == pendingPicks_.end()) {
+      return;
+    }
+    recordSuccess(it->second, connectLatency);
+    pendingPicks_.erase(it);
+  }
+
+  void onConnectError(const R& routingData) noexcept override {
+    auto it = pendingPicks_.find(routingData);
+    if (it == pendingPicks_.end()) {
+      return;
+    }
+    recordFailure(it->second);
+    pendingPicks_.erase(it);
+  }
+
+  const std::vector<ServerStats>& getServerStats() const {
+    return servers_;
+  }
+
+ protected:
+  /**
+   * Picks a server index by inverse-latency weight among those whose
+   * circuit is closed (or due for a probe). folly::none if every
+   * server's circuit is open.
+   */
+  folly::Optional<size_t> pickServer() {
+    auto now = std::chrono::steady_clock::now();
+    double totalWeight = 0;
+    for (const auto& server : servers_) {
+      if (circuitOpen(server, now)) {
+        continue;
+      }
+      totalWeight += weight(server);
+    }
+    if (totalWeight == 0) {
+      return folly::none;
+    }
+    auto target = folly::Random::randDouble(0, totalWeight);
+    for (size_t i = 0; i < servers_.size(); i++) {
+      if (circuitOpen(servers_[i], now)) {
+        continue;
+      }
+      target -= weight(servers_[i]);
+      if (target <= 0) {
+        return i;
+      }
+    }
+    // Floating point slop; fall back to the last eligible server.
+    for (size_t i = servers_.size(); i > 0; i--) {
+      if (!circuitOpen(servers_[i - 1], now)) {
+        return i - 1;
+      }
+    }
+    return folly::none;
+  }
+
+  void recordSuccess(size_t idx, std::chrono::microseconds latency) {
+    auto& server = servers_[idx];
+    server.connects++;
+    server.consecutiveFailures = 0;
+    auto sample = static_cast<double>(latency.count());
+    server.ewmaLatencyUs = server.ewmaLatencyUs == 0
+        ? sample
+        : (1 - ewmaWeight_) * server.ewmaLatencyUs + ewmaWeight_ * sample;
+  }
+
+  void recordFailure(size_t idx) {
+    auto& server = servers_[idx];
+    server.failures++;
+    if (++server.consecutiveFailures >= circuitFailureThreshold_) {
+      server.retryAfter =
+          std::chrono::steady_clock::now() + circuitBreakDuration_;
+    }
+  }
+
+ private:
+  static bool circuitOpen(
+      const ServerStats& server,
+      std::chrono::steady_clock::time_point now) {
+    return server.retryAfter > now;
+  }
+
+  double weight(const ServerStats& server) const {
+    // Unmeasured servers weigh as if they took 1us so they get probed.
+    return 1.0 / std::max(server.ewmaLatencyUs, 1.0);
+  }
+
+  std::vector<ServerStats> servers_;
+  folly::F14FastMap<R, size_t> pendingPicks_;
+  double ewmaWeight_;
+  uint32_t circuitFailureThreshold_;
+  std::chrono::milliseconds circuitBreakDuration_;
 };
 
 /**
@@ -72,6 +249,15 @@ class BroadcastPool {
 
     folly::Future<BroadcastHandler<T, R>*> getHandler();
 
+    /**
+     * Returns the handler directly if the upstream connection is already
+     * established, nullptr otherwise. Allows callers to skip the
+     * SharedPromise machinery on the common already-connected path.
+     */
+    BroadcastHandler<T, R>* getHandlerIfConnected() const {
+      return handler_;
+    }
+
     // PipelineManager implementation
     void deletePipeline(PipelineBase* pipeline) override;
 
@@ -85,6 +271,11 @@ class BroadcastPool {
 
     bool connectStarted_{false};
     bool deletingBroadcast_{false};
+    // For reporting connect latency back to the ServerPool.
+    std::chrono::steady_clock::time_point connectStartTime_;
+    // Set once the upstream connect completes; the manager is erased from
+    // the pool before the pipeline (and thus the handler) goes away.
+    BroadcastHandler<T, R>* handler_{nullptr};
     folly::SharedPromise<BroadcastHandler<T, R>*> sharedPromise_;
   };
 
@@ -125,6 +316,57 @@ class BroadcastPool {
   virtual folly::Future<BroadcastHandler<T, R>*> getHandler(
       const R& routingData);
 
+  /**
+   * Establishes the upstream broadcast for routingData ahead of demand,
+   * so the first subscriber attaches to a warm connection instead of
+   * paying connect + subscribe latency. The broadcast is pinned (see
+   * pin()) so it survives until demand arrives; release it with
+   * unpin() if the anticipated audience never shows up, or rely on the
+   * idle linger configured via setPinIdleLinger(). The returned future
+   * completes once the upstream connection is established, with the
+   * connect error if it fails.
+   */
+  folly::Future<folly::Unit> prewarm(const R& routingData);
+
+  /**
+   * Pins the broadcast for routingData so that it is held alive
+   * through subscriber gaps instead of tearing down the upstream when
+   * the last subscriber leaves. Each successful pin() (and prewarm())
+   * holds one pin; release with unpin(). Returns false if there is no
+   * broadcast for routingData.
+   */
+  bool pin(const R& routingData);
+
+  /**
+   * Releases one pin on the broadcast for routingData. Returns false
+   * if there is no broadcast for routingData.
+   */
+  bool unpin(const R& routingData);
+
+  /**
+   * Bounds how long a pinned broadcast may stay idle before it is
+   * closed anyway. Applies to pins taken after the call; 0 (the
+   * default) lingers indefinitely.
+   */
+  void setPinIdleLinger(std::chrono::milliseconds linger) {
+    pinIdleLinger_ = linger;
+  }
+
+  /**
+   * Counters distinguishing broadcasts that had to be created on
+   * demand (cold starts) from subscriber attaches that found one
+   * already in the pool, for sizing the prewarm schedule.
+   */
+  struct PoolStats {
+    uint64_t coldStarts{0};
+    uint64_t warmAttaches{0};
+    uint64_t prewarms{0};
+  };
+
+  const PoolStats& getPoolStats() const {
+    return stats_;
+  }
+
   /**
    * Checks if a broadcast is available locally for the given routingData.
    */
@@ -140,7 +382,9 @@ class BroadcastPool {
   std::shared_ptr<ServerPool<R, P>> serverPool_;
   std::shared_ptr<BroadcastPipelineFactory<T, R>> broadcastPipelineFactory_;
   std::shared_ptr<BaseClientBootstrapFactory<>> clientBootstrapFactory_;
-  std::map<R, typename BroadcastManager::UniquePtr> broadcasts_;
+  folly::F14ValueMap<R, typename BroadcastManager::UniquePtr> broadcasts_;
+  std::chrono::milliseconds pinIdleLinger_{0};
+  PoolStats stats_;
 };
 
 } // namespace wangle
@@ -26,6 +26,9 @@ ObservingHandler<T, R, P>::ObservingHandler(
 
 template <typename T, typename R, typename P>
 ObservingHandler<T, R, P>::~ObservingHandler() {
+  // Payloads still queued die with the handler.
+  MemoryAccounting::sub(MemorySubsystem::BROADCAST_QUEUES, pendingLag_);
+
   if (broadcastHandler_) {
     auto broadcastHandler = broadcastHandler_;
     broadcastHandler_ = nullptr;
@@ -77,6 +80,42 @@ void ObservingHandler<T, R, P>::transportActive(Context* ctx) {
           });
 }
 
+template <typename T, typename R, typename P>
+void ObservingHandler<T, R, P>::transportUnwritable(Context* ctx) {
+  if (paused_) {
+    return;
+  }
+  paused_ = true;
+
+  // Stop draining this observer's ingress while its egress is saturated,
+  // using the same pause mechanism as the subscription setup above. The
+  // broadcast keeps flowing; data for this subscriber accumulates at the
+  // socket only up to the configured high watermark.
+  auto pipeline = dynamic_cast<ObservingPipeline<T>*>(ctx->getPipeline());
+  CHECK(pipeline);
+  pipeline->transportInactive();
+}
+
+template <typename T, typename R, typename P>
+void ObservingHandler<T, R, P>::transportWritable(Context* ctx) {
+  if (!paused_) {
+    return;
+  }
+  paused_ = false;
+
+  // Catch up on payloads queued while the transport was saturated. A
+  // write here can push the transport straight back over its watermark
+  // and re-pause us, in which case the rest stays queued.
+  drainPendingWrites();
+  if (paused_) {
+    return;
+  }
+
+  auto pipeline = dynamic_cast<ObservingPipeline<T>*>(ctx->getPipeline());
+  CHECK(pipeline);
+  pipeline->transportActive();
+}
+
 template <typename T, typename R, typename P>
 void ObservingHandler<T, R, P>::readEOF(Context* ctx) {
   this->close(ctx);
@@ -92,6 +131,15 @@ void ObservingHandler<T, R, P>::readException(
 
 template <typename T, typename R, typename P>
 void ObservingHandler<T, R, P>::onNext(const T& data) {
+  if (highWatermark_ > 0 && (paused_ || !pendingWrites_.empty())) {
+    enqueuePending(data);
+    return;
+  }
+  writeOne(data);
+}
+
+template <typename T, typename R, typename P>
+void ObservingHandler<T, R, P>::writeOne(const T& data) {
   auto ctx = this->getContext();
   auto deleted = deleted_;
   this->write(ctx, data).thenError(
@@ -106,6 +154,54 @@ void ObservingHandler<T, R, P>::onNext(const T& data) {
       });
 }
 
+template <typename T, typename R, typename P>
+void ObservingHandler<T, R, P>::enqueuePending(const T& data) {
+  pendingWrites_.push_back(data);
+  growPendingLag(broadcast_detail::PayloadSize<T>::get(data));
+  if (pendingLag_ <= highWatermark_) {
+    return;
+  }
+
+  switch (slowSubscriberPolicy_) {
+    case SlowSubscriberPolicy::BUFFER:
+      break;
+    case SlowSubscriberPolicy::DROP_OLDEST:
+      while (pendingLag_ > lowWatermark_ && !pendingWrites_.empty()) {
+        shrinkPendingLag(
+            broadcast_detail::PayloadSize<T>::get(pendingWrites_.front()));
+        pendingWrites_.pop_front();
+        droppedPayloads_++;
+      }
+      break;
+    case SlowSubscriberPolicy::DROP_NEWEST:
+      shrinkPendingLag(
+          broadcast_detail::PayloadSize<T>::get(pendingWrites_.back()));
+      pendingWrites_.pop_back();
+      droppedPayloads_++;
+      break;
+    case SlowSubscriberPolicy::DISCONNECT:
+      LOG(WARNING) << "Disconnecting slow subscriber with write queue lag "
+                   << pendingLag_;
+      this->close(this->getContext());
+      break;
+  }
+}
+
+template <typename T, typename R, typename P>
+void ObservingHandler<T, R, P>::drainPendingWrites() {
+  while (!pendingWrites_.empty() && !paused_) {
+    auto data = std::move(pendingWrites_.front());
+    pendingWrites_.pop_front();
+    shrinkPendingLag(broadcast_detail::PayloadSize<T>::get(data));
+    writeOne(data);
+  }
+}
+
+template <typename T, typename R, typename P>
+uint64_t ObservingHandler<T, R, P>::pendingLag() const {
+  return pendingLag_;
+}
+
 template <typename T, typename R, typename P>
 void ObservingHandler<T, R, P>::onError(folly::exception_wrapper ex) {
   LOG(ERROR) << "Error observing a broadcast: " << exceptionStr(ex);
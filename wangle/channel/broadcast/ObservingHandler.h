@@ -16,13 +16,61 @@
 
 #pragma once
 
+#include <algorithm>
+#include <deque>
+
 #include <wangle/bootstrap/AcceptRoutingHandler.h>
 #include <wangle/bootstrap/ServerBootstrap.h>
 #include <wangle/channel/broadcast/BroadcastPool.h>
 #include <wangle/channel/broadcast/Subscriber.h>
+#include <wangle/util/MemoryAccounting.h>
 
 namespace wangle {
 
+namespace broadcast_detail {
+
+/**
+ * Cost of one queued payload for flow-control accounting: chain bytes
+ * for IOBuf payloads, one unit per message for anything else.
+ */
+template <typename T>
+struct PayloadSize {
+  static uint64_t get(const T&) {
+    return 1;
+  }
+};
+
+template <>
+struct PayloadSize<std::shared_ptr<folly::IOBuf>> {
+  static uint64_t get(const std::shared_ptr<folly::IOBuf>& buf) {
+    return buf ? buf->computeChainDataLength() : 0;
+  }
+};
+
+template <>
+struct PayloadSize<std::unique_ptr<folly::IOBuf>> {
+  static uint64_t get(const std::unique_ptr<folly::IOBuf>& buf) {
+    return buf ? buf->computeChainDataLength() : 0;
+  }
+};
+
+} // namespace broadcast_detail
+
+/**
+ * What to do with a subscriber whose pending write queue exceeds its
+ * high watermark.
+ */
+enum class SlowSubscriberPolicy {
+  // Keep queueing without bound (the historical behavior).
+  BUFFER,
+  // Drop queued payloads from the front until below the low watermark.
+  DROP_OLDEST,
+  // Drop the incoming payload.
+  DROP_NEWEST,
+  // Close the subscriber's connection.
+  DISCONNECT,
+};
+
 /**
  * A Handler-Observer adaptor that can be used for subscribing to broadcasts.
  * Maintains a thread-local BroadcastPool from which a BroadcastHandler is
@@ -47,6 +95,8 @@ class ObservingHandler : public HandlerAdapter<folly::IOBufQueue&, T>,
 
   // HandlerAdapter implementation
   void transportActive(Context* ctx) override;
+  void transportWritable(Context* ctx) override;
+  void transportUnwritable(Context* ctx) override;
   void readEOF(Context* ctx) override;
   void readException(Context* ctx, folly::exception_wrapper ex) override;
 
@@ -55,8 +105,48 @@ class ObservingHandler : public HandlerAdapter<folly::IOBufQueue&, T>,
   void onError(folly::exception_wrapper ex) override;
   void onCompleted() override;
   R& routingData() override;
+  uint64_t pendingLag() const override;
+
+  /**
+   * Bounds the queue of payloads held while this subscriber's transport
+   * is unwritable. Once the queue exceeds the high watermark the
+   * configured SlowSubscriberPolicy is applied; DROP_OLDEST sheds down
+   * to the low watermark. Watermarks are in payload bytes for IOBuf
+   * streams and message counts otherwise. A high watermark of 0 (the
+   * default) disables local queueing entirely and writes straight to
+   * the transport, the historical behavior.
+   */
+  void setWriteQueueWatermarks(uint64_t high, uint64_t low) {
+    highWatermark_ = high;
+    lowWatermark_ = std::min(low, high);
+  }
+
+  void setSlowSubscriberPolicy(SlowSubscriberPolicy policy) {
+    slowSubscriberPolicy_ = policy;
+  }
+
+  uint64_t getDroppedPayloads() const {
+    return droppedPayloads_;
+  }
 
  private:
+  // Writes one payload to the transport, closing on write error.
+  void writeOne(const T& data);
+  void enqueuePending(const T& data);
+  void drainPendingWrites();
+
+  // Queue lag changes are mirrored into the BROADCAST_QUEUES memory
+  // accounting (in PayloadSize units: bytes for IOBuf streams).
+  void growPendingLag(uint64_t size) {
+    pendingLag_ += size;
+    MemoryAccounting::add(MemorySubsystem::BROADCAST_QUEUES, size);
+  }
+
+  void shrinkPendingLag(uint64_t size) {
+    pendingLag_ -= size;
+    MemoryAccounting::sub(MemorySubsystem::BROADCAST_QUEUES, size);
+  }
+
   R routingData_;
   BroadcastPool<T, R, P>* broadcastPool_{nullptr};
 
@@ -64,6 +154,13 @@ class ObservingHandler : public HandlerAdapter<folly::IOBufQueue&, T>,
   uint64_t subscriptionId_{0};
   bool paused_{false};
 
+  std::deque<T> pendingWrites_;
+  uint64_t pendingLag_{0};
+  uint64_t highWatermark_{0};
+  uint64_t lowWatermark_{0};
+  SlowSubscriberPolicy slowSubscriberPolicy_{SlowSubscriberPolicy::DROP_OLDEST};
+  uint64_t droppedPayloads_{0};
+
   // True iff the handler has been deleted
   std::shared_ptr<bool> deleted_{new bool(false)};
 };
@@ -71,6 +168,31 @@ class ObservingHandler : public HandlerAdapter<folly::IOBufQueue&, T>,
 template <typename T>
 using ObservingPipeline = Pipeline<folly::IOBufQueue&, T>;
 
+/**
+ * Outbound adapter for observing pipelines that carry refcounted buffer
+ * payloads (T = std::shared_ptr<folly::IOBuf>). The broadcast side hands
+ * every subscriber the same shared snapshot of an upstream packet; this
+ * handler converts it to the owned chain the transport expects. The clone
+ * shares the underlying data, so fanning one snapshot out to N subscribers
+ * copies no payload bytes.
+ */
+class SharedIOBufWriteHandler : public OutboundHandler<
+                                    std::shared_ptr<folly::IOBuf>,
+                                    std::unique_ptr<folly::IOBuf>> {
+ public:
+  folly::Future<folly::Unit> write(
+      Context* ctx,
+      std::shared_ptr<folly::IOBuf> buf) override {
+    return ctx->fireWrite(buf ? buf->clone() : nullptr);
+  }
+
+  FastWriteResult writeFast(Context* ctx, std::shared_ptr<folly::IOBuf>& buf)
+      override {
+    auto owned = buf ? buf->clone() : nullptr;
+    return ctx->fireWriteFast(owned);
+  }
+};
+
 template <typename T, typename R, typename P = DefaultPipeline>
 class ObservingPipelineFactory
     : public RoutingDataPipelineFactory<ObservingPipeline<T>, R> {
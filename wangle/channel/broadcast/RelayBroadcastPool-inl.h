@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+namespace wangle {
+
+template <typename T, typename R, typename P>
+typename RelayBroadcastPool<T, R, P>::Subscription
+RelayBroadcastPool<T, R, P>::subscribe(
+    const R& routingData,
+    folly::EventBase* localEvb,
+    Subscriber<T, R>* subscriber) {
+  DCHECK(localEvb->isInEventBaseThread());
+
+  std::shared_ptr<RelayStream> stream;
+  bool created = false;
+  {
+    auto streams = streams_.wlock();
+    auto& entry = (*streams)[routingData];
+    if (!entry) {
+      entry.reset(new RelayStream(this, routingData));
+      created = true;
+    }
+    stream = entry;
+    // Register the demand under the map lock so the idle check on the
+    // upstream thread, which runs under the same lock, cannot observe
+    // the stream as subscriberless halfway through the attach.
+    stream->activeSubscribers_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  auto* relay = stream->getRelay(
+      localEvb, relayQueueCapacity_.load(std::memory_order_relaxed));
+
+  Subscription subscription;
+  subscription.relay = relay;
+  subscription.subscriptionId = relay->addSubscriber(subscriber);
+
+  if (created) {
+    upstreamEvb_->runInEventBaseThread(
+        [this, stream = std::move(stream)] { startUpstream(stream); });
+  }
+  return subscription;
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::startUpstream(
+    const std::shared_ptr<RelayStream>& stream) {
+  DCHECK(upstreamEvb_->isInEventBaseThread());
+  if (stream->connectStarted_ || stream->terminated_) {
+    return;
+  }
+  stream->connectStarted_ = true;
+  upstreamConnects_.fetch_add(1, std::memory_order_relaxed);
+
+  // Completes inline (see BroadcastPool::getHandler), so the
+  // dispatcher is subscribed before the manager's own idle check runs.
+  upstreamPool_->getHandler(stream->routingData_)
+      .thenValue([stream](BroadcastHandler<T, R>* handler) {
+        if (stream->terminated_) {
+          // Demand evaporated while the connect was in flight; close
+          // the now-unwanted upstream connection.
+          handler->closeIfIdle();
+          return;
+        }
+        stream->upstreamHandler_ = handler;
+        stream->upstreamSubscriptionId_ =
+            handler->subscribe(&stream->dispatcher_);
+      })
+      .thenError(
+          folly::tag_t<std::exception>{}, [stream](const std::exception& ex) {
+            stream->onUpstreamTerminated(
+                folly::make_exception_wrapper<std::exception>(ex));
+          });
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::scheduleReap(
+    std::shared_ptr<RelayStream> stream) {
+  upstreamEvb_->runInEventBaseThread(
+      [this, stream = std::move(stream)] { maybeReapStream(stream); });
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::maybeReapStream(
+    const std::shared_ptr<RelayStream>& stream) {
+  DCHECK(upstreamEvb_->isInEventBaseThread());
+  if (stream->terminated_) {
+    return;
+  }
+  {
+    auto streams = streams_.wlock();
+    if (stream->activeSubscribers_.load(std::memory_order_acquire) > 0) {
+      // A subscriber arrived between the last detach and this check.
+      return;
+    }
+    auto iter = streams->find(stream->routingData_);
+    if (iter != streams->end() && iter->second == stream) {
+      streams->erase(iter);
+    }
+  }
+  stream->terminated_ = true;
+  if (stream->upstreamHandler_) {
+    // Dropping the dispatcher's subscription lets the upstream
+    // BroadcastHandler close the connection through its usual idle
+    // path.
+    stream->upstreamHandler_->unsubscribe(stream->upstreamSubscriptionId_);
+    stream->upstreamHandler_ = nullptr;
+  }
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::removeStream(
+    const std::shared_ptr<RelayStream>& stream) {
+  auto streams = streams_.wlock();
+  auto iter = streams->find(stream->routingData_);
+  // A new stream may already have replaced this one; only remove the
+  // exact instance.
+  if (iter != streams->end() && iter->second == stream) {
+    streams->erase(iter);
+  }
+}
+
+template <typename T, typename R, typename P>
+typename RelayBroadcastPool<T, R, P>::Relay*
+RelayBroadcastPool<T, R, P>::RelayStream::getRelay(
+    folly::EventBase* evb,
+    size_t queueCapacity) {
+  auto relays = relays_.wlock();
+  auto& entry = relays->relays[evb];
+  if (!entry) {
+    entry.reset(new Relay(this, evb, queueCapacity));
+    pool_->relaysCreated_.fetch_add(1, std::memory_order_relaxed);
+    if (relays->terminated) {
+      // The stream ended while this loop was joining; echo the
+      // terminal event so the new relay's subscribers are not left
+      // waiting forever.
+      evb->runInEventBaseThread(
+          [stream = this->shared_from_this(),
+           relay = entry.get(),
+           ex = relays->terminalEx] { relay->deliverTerminal(ex); });
+    }
+  }
+  return entry.get();
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::RelayStream::fanOut(const T& data) {
+  // The registry lock is shared and only contended when a new thread
+  // joins the stream; the per-relay handoff itself is the wait-free
+  // ring write in Relay::publish().
+  auto relays = relays_.rlock();
+  for (const auto& entry : relays->relays) {
+    entry.second->publish(data);
+  }
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::RelayStream::onUpstreamTerminated(
+    folly::exception_wrapper ex) {
+  terminated_ = true;
+  // The upstream BroadcastHandler tears itself down after EOF/error;
+  // never touch it again.
+  upstreamHandler_ = nullptr;
+  // Remove the stream first so a re-subscribe after the terminal
+  // event starts from a fresh connect.
+  pool_->removeStream(this->shared_from_this());
+
+  auto relays = relays_.wlock();
+  relays->terminated = true;
+  relays->terminalEx = ex;
+  for (const auto& entry : relays->relays) {
+    auto* relay = entry.second.get();
+    relay->evb_->runInEventBaseThread(
+        [stream = this->shared_from_this(), relay, ex] {
+          relay->deliverTerminal(ex);
+        });
+  }
+}
+
+template <typename T, typename R, typename P>
+uint64_t RelayBroadcastPool<T, R, P>::RelayStream::queuedPayloadTotal()
+    const {
+  uint64_t total = 0;
+  auto relays = relays_.rlock();
+  for (const auto& entry : relays->relays) {
+    total += entry.second->queuedPayloads();
+  }
+  return total;
+}
+
+template <typename T, typename R, typename P>
+uint64_t RelayBroadcastPool<T, R, P>::Relay::addSubscriber(
+    Subscriber<T, R>* subscriber) {
+  DCHECK(evb_->isInEventBaseThread());
+  auto subscriptionId = nextSubscriptionId_++;
+  subscribers_[subscriptionId] = subscriber;
+  if (terminalDelivered_) {
+    // The stream already ended on this relay; echo the terminal event
+    // to the late subscriber from the loop rather than re-entrantly.
+    evb_->runInEventBaseThread(
+        [stream = stream_->shared_from_this(), this] {
+          deliverTerminal(terminalEx_);
+        });
+  }
+  return subscriptionId;
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::Relay::unsubscribe(
+    uint64_t subscriptionId) {
+  DCHECK(evb_->isInEventBaseThread());
+  if (subscribers_.erase(subscriptionId) == 0) {
+    return;
+  }
+  if (stream_->activeSubscribers_.fetch_sub(1, std::memory_order_acq_rel) ==
+      1) {
+    stream_->pool_->scheduleReap(stream_->shared_from_this());
+  }
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::Relay::publish(const T& data) {
+  if (!queue_.write(data)) {
+    // A full ring means this loop is far behind; shedding the newest
+    // payload keeps the upstream thread from ever blocking on a slow
+    // peer loop.
+    droppedPayloads_.fetch_add(1, std::memory_order_relaxed);
+  }
+  scheduleDrain();
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::Relay::scheduleDrain() {
+  // The payload lands in the ring before this exchange, and the
+  // consumer clears the flag before it starts reading, so a racing
+  // producer either finds the drain still pending or schedules a
+  // fresh one; payloads are never stranded.
+  if (drainScheduled_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  evb_->runInEventBaseThread(
+      [stream = stream_->shared_from_this(), this] { drain(); });
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::Relay::drain() {
+  DCHECK(evb_->isInEventBaseThread());
+  drainScheduled_.store(false, std::memory_order_release);
+  T data;
+  while (queue_.read(data)) {
+    // Snapshot the ids so a subscriber unsubscribing from onNext()
+    // cannot invalidate the iteration.
+    folly::small_vector<uint64_t, 8> ids;
+    ids.reserve(subscribers_.size());
+    for (const auto& entry : subscribers_) {
+      ids.push_back(entry.first);
+    }
+    for (auto id : ids) {
+      auto iter = subscribers_.find(id);
+      if (iter != subscribers_.end()) {
+        iter->second->onNext(data);
+      }
+    }
+  }
+}
+
+template <typename T, typename R, typename P>
+void RelayBroadcastPool<T, R, P>::Relay::deliverTerminal(
+    folly::exception_wrapper ex) {
+  DCHECK(evb_->isInEventBaseThread());
+  // Hand over anything still queued ahead of the terminal event.
+  drain();
+  terminalDelivered_ = true;
+  terminalEx_ = ex;
+
+  auto subscribers = std::move(subscribers_);
+  subscribers_.clear();
+  if (!subscribers.empty()) {
+    // The stream is already detached from the pool; just settle the
+    // accounting for the subscriptions ending here.
+    stream_->activeSubscribers_.fetch_sub(
+        subscribers.size(), std::memory_order_acq_rel);
+  }
+  for (const auto& entry : subscribers) {
+    if (ex) {
+      entry.second->onError(ex);
+    } else {
+      entry.second->onCompleted();
+    }
+  }
+}
+
+} // namespace wangle
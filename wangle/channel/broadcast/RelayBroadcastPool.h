@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include <folly/ProducerConsumerQueue.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/small_vector.h>
+#include <wangle/channel/broadcast/BroadcastPool.h>
+#include <wangle/channel/broadcast/Subscriber.h>
+
+namespace wangle {
+
+/**
+ * A process-level tier on top of BroadcastPool that shares one upstream
+ * connection per stream across all IO threads.
+ *
+ * BroadcastPool is single-threaded, so the usual deployment keeps one
+ * pool per IO thread, and a stream watched from every thread opens one
+ * upstream connection per thread with each connection decoding the same
+ * bytes. This pool instead confines a single BroadcastPool to a
+ * designated upstream EventBase: the first subscriber anywhere in the
+ * process opens the one upstream connection there, and every thread
+ * with local demand attaches a per-EventBase Relay that receives the
+ * decoded payloads from the upstream thread over a bounded
+ * single-producer single-consumer ring and fans them out to its local
+ * subscribers. Upstream bandwidth and decode cost are paid once per
+ * stream instead of once per thread.
+ *
+ * Payloads cross threads by copy, so T must be cheaply copyable; for
+ * buffer streams use a refcounted payload such as
+ * T = std::shared_ptr<folly::IOBuf> together with
+ * SharedIOBufWriteHandler on the subscriber pipelines. A relay whose
+ * ring fills up drops the incoming payload and counts it rather than
+ * ever blocking the upstream thread; size the ring for the expected
+ * burst via setRelayQueueCapacity().
+ *
+ * subscribe() must be called from the subscriber's own EventBase
+ * thread and delivery happens on that thread, so subscribers need no
+ * locking of their own. The pool must outlive the EventBases using it.
+ */
+template <typename T, typename R, typename P = DefaultPipeline>
+class RelayBroadcastPool {
+ private:
+  class RelayStream;
+
+ public:
+  static_assert(
+      std::is_copy_constructible<T>::value,
+      "Relayed payloads must be copyable; use a refcounted type");
+
+  static constexpr size_t kDefaultRelayQueueCapacity = 1024;
+
+  /**
+   * The per-EventBase fan-out endpoint for one stream. Obtained via
+   * subscribe(); valid while at least the returned subscription is
+   * held, and until the terminal onError()/onCompleted() has been
+   * delivered.
+   */
+  class Relay {
+   public:
+    /**
+     * Detaches a subscription returned by subscribe(). Must be called
+     * on the relay's EventBase thread. When the last subscriber across
+     * all relays leaves, the upstream connection is torn down.
+     */
+    void unsubscribe(uint64_t subscriptionId);
+
+    /**
+     * Payloads shed because this loop's ring was full, i.e. the loop
+     * was too far behind the upstream thread.
+     */
+    uint64_t getDroppedPayloads() const {
+      return droppedPayloads_.load(std::memory_order_relaxed);
+    }
+
+    folly::EventBase* getEventBase() const {
+      return evb_;
+    }
+
+   private:
+    friend class RelayBroadcastPool<T, R, P>;
+    friend class RelayStream;
+
+    Relay(RelayStream* stream, folly::EventBase* evb, size_t queueCapacity)
+        : stream_(stream), evb_(evb), queue_(queueCapacity) {}
+
+    uint64_t addSubscriber(Subscriber<T, R>* subscriber);
+
+    // Upstream-thread side: queue one payload and make sure a drain
+    // is pending on the relay's loop.
+    void publish(const T& data);
+    void scheduleDrain();
+
+    // Local-loop side.
+    void drain();
+    void deliverTerminal(folly::exception_wrapper ex);
+
+    uint64_t queuedPayloads() const {
+      return queue_.sizeGuess();
+    }
+
+    RelayStream* const stream_;
+    folly::EventBase* const evb_;
+
+    // Written by the upstream thread, consumed on evb_.
+    folly::ProducerConsumerQueue<T> queue_;
+    std::atomic<bool> drainScheduled_{false};
+    std::atomic<uint64_t> droppedPayloads_{0};
+
+    // Local to evb_.
+    folly::F14FastMap<uint64_t, Subscriber<T, R>*> subscribers_;
+    uint64_t nextSubscriptionId_{0};
+    bool terminalDelivered_{false};
+    folly::exception_wrapper terminalEx_;
+  };
+
+  struct Subscription {
+    Relay* relay{nullptr};
+    uint64_t subscriptionId{0};
+  };
+
+  struct RelayPoolStats {
+    // Upstream connects started; one per stream unless the stream
+    // ends and demand later returns.
+    uint64_t upstreamConnects{0};
+    // Per-EventBase relays created, across all streams.
+    uint64_t relaysCreated{0};
+  };
+
+  RelayBroadcastPool(
+      folly::EventBase* upstreamEvb,
+      std::unique_ptr<BroadcastPool<T, R, P>> upstreamPool)
+      : upstreamEvb_(upstreamEvb), upstreamPool_(std::move(upstreamPool)) {
+    CHECK(upstreamEvb_);
+    CHECK(upstreamPool_);
+  }
+
+  RelayBroadcastPool(
+      folly::EventBase* upstreamEvb,
+      std::shared_ptr<ServerPool<R, P>> serverPool,
+      std::shared_ptr<BroadcastPipelineFactory<T, R>> broadcastPipelineFactory)
+      : RelayBroadcastPool(
+            upstreamEvb,
+            std::make_unique<BroadcastPool<T, R, P>>(
+                serverPool,
+                broadcastPipelineFactory)) {}
+
+  /**
+   * Attaches a subscriber to the calling EventBase's relay for the
+   * given stream, creating the relay and, for the first subscriber in
+   * the process, kicking off the upstream connect. Must be called on
+   * localEvb's thread. Returns the relay together with the
+   * subscription id to pass to Relay::unsubscribe().
+   *
+   * Connect errors and upstream EOF reach subscribers as
+   * onError()/onCompleted() on their own threads; subscribe again to
+   * pick the stream back up afterwards.
+   */
+  Subscription subscribe(
+      const R& routingData,
+      folly::EventBase* localEvb,
+      Subscriber<T, R>* subscriber);
+
+  bool isRelaying(const R& routingData) const {
+    return streams_.rlock()->count(routingData) > 0;
+  }
+
+  /**
+   * Ring capacity, in payloads, for relays created after the call.
+   * Intended to be set once while wiring the pool up.
+   */
+  void setRelayQueueCapacity(size_t capacity) {
+    relayQueueCapacity_.store(
+        std::max<size_t>(capacity, 2), std::memory_order_relaxed);
+  }
+
+  RelayPoolStats getPoolStats() const {
+    RelayPoolStats stats;
+    stats.upstreamConnects =
+        upstreamConnects_.load(std::memory_order_relaxed);
+    stats.relaysCreated = relaysCreated_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  /**
+   * Shared state for one stream: the origin-side subscription to the
+   * upstream BroadcastHandler plus the relays fanning its payloads out
+   * to the subscriber loops. Held by shared_ptr so callbacks in flight
+   * on subscriber loops keep it alive through teardown.
+   */
+  class RelayStream : public std::enable_shared_from_this<RelayStream> {
+   private:
+    friend class RelayBroadcastPool<T, R, P>;
+    friend class Relay;
+
+    class Dispatcher : public Subscriber<T, R> {
+     public:
+      explicit Dispatcher(RelayStream* stream) : stream_(stream) {}
+
+      void onNext(const T& data) override {
+        stream_->fanOut(data);
+      }
+      void onError(folly::exception_wrapper ex) override {
+        stream_->onUpstreamTerminated(std::move(ex));
+      }
+      void onCompleted() override {
+        stream_->onUpstreamTerminated(folly::exception_wrapper());
+      }
+      R& routingData() override {
+        return stream_->routingData_;
+      }
+      // Reported in queued payloads, summed over all relay rings.
+      uint64_t pendingLag() const override {
+        return stream_->queuedPayloadTotal();
+      }
+
+     private:
+      RelayStream* const stream_;
+    };
+
+    RelayStream(RelayBroadcastPool* pool, R routingData)
+        : pool_(pool), routingData_(std::move(routingData)) {}
+
+    Relay* getRelay(folly::EventBase* evb, size_t queueCapacity);
+    void fanOut(const T& data);
+    void onUpstreamTerminated(folly::exception_wrapper ex);
+    uint64_t queuedPayloadTotal() const;
+
+    RelayBroadcastPool* const pool_;
+    R routingData_;
+    Dispatcher dispatcher_{this};
+
+    struct RelayMap {
+      folly::F14FastMap<folly::EventBase*, std::unique_ptr<Relay>> relays;
+      // Set under the lock when the upstream ends so a relay created
+      // by a late joiner still observes the terminal event.
+      bool terminated{false};
+      folly::exception_wrapper terminalEx;
+    };
+    folly::Synchronized<RelayMap> relays_;
+
+    // Live subscriptions across all relays. Checked under the pool's
+    // stream map lock when deciding to tear the stream down, mirroring
+    // where subscribe() registers new demand.
+    std::atomic<uint64_t> activeSubscribers_{0};
+
+    // Upstream-thread state.
+    bool connectStarted_{false};
+    bool terminated_{false};
+    BroadcastHandler<T, R>* upstreamHandler_{nullptr};
+    uint64_t upstreamSubscriptionId_{0};
+  };
+
+  void startUpstream(const std::shared_ptr<RelayStream>& stream);
+  void scheduleReap(std::shared_ptr<RelayStream> stream);
+  void maybeReapStream(const std::shared_ptr<RelayStream>& stream);
+  void removeStream(const std::shared_ptr<RelayStream>& stream);
+
+  folly::EventBase* const upstreamEvb_;
+  std::unique_ptr<BroadcastPool<T, R, P>> upstreamPool_;
+
+  folly::Synchronized<folly::F14FastMap<R, std::shared_ptr<RelayStream>>>
+      streams_;
+
+  std::atomic<size_t> relayQueueCapacity_{kDefaultRelayQueueCapacity};
+  std::atomic<uint64_t> upstreamConnects_{0};
+  std::atomic<uint64_t> relaysCreated_{0};
+};
+
+} // namespace wangle
+
+#include <wangle/channel/broadcast/RelayBroadcastPool-inl.h>
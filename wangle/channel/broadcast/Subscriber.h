@@ -32,6 +32,17 @@ class Subscriber {
   virtual void onError(folly::exception_wrapper ex) = 0;
   virtual void onCompleted() = 0;
   virtual R& routingData() = 0;
+
+  /**
+   * How far this subscriber is behind the broadcast: the amount of
+   * delivered payload it has accepted but not yet written out. Units
+   * are payload bytes for IOBuf streams and message counts otherwise
+   * (see ObservingHandler's flow control). Used by BroadcastHandler to
+   * report per-subscriber lag.
+   */
+  virtual uint64_t pendingLag() const {
+    return 0;
+  }
 };
 
 } // namespace wangle
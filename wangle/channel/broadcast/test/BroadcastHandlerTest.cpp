@@ -211,6 +211,76 @@ TEST_F(BroadcastHandlerTest, BufferedRead) {
   handler->unsubscribe(1);
 }
 
+TEST_F(BroadcastHandlerTest, UnsubscribeDuringBroadcast) {
+  // A subscriber that unsubscribes while a message is being fanned out
+  // must not receive the in-flight message.
+  EXPECT_CALL(*decoder, decode(_, _, _, _))
+      .WillRepeatedly(
+          Invoke([&](MockByteToMessageDecoder<std::string>::Context*,
+                     IOBufQueue& q,
+                     std::string& data,
+                     size_t&) {
+            auto buf = q.move();
+            if (buf) {
+              buf->coalesce();
+              data = buf->moveToFbString().toStdString();
+              return true;
+            }
+            return false;
+          }));
+
+  InSequence dummy;
+
+  EXPECT_EQ(handler->subscribe(&subscriber0), 0);
+  EXPECT_EQ(handler->subscribe(&subscriber1), 1);
+
+  // subscriber0 drops subscriber1 mid-fan-out.
+  EXPECT_CALL(subscriber0, onNext("data1"))
+      .WillOnce(InvokeWithoutArgs([this] { handler->unsubscribe(1); }));
+
+  IOBufQueue q;
+  q.append(IOBuf::copyBuffer("data1"));
+  pipeline->read(q);
+  q.reset();
+
+  // Fan-out keeps working after the deferred slot is compacted out.
+  EXPECT_CALL(subscriber0, onNext("data2")).Times(1);
+  q.append(IOBuf::copyBuffer("data2"));
+  pipeline->read(q);
+  q.reset();
+
+  EXPECT_CALL(*handler, mockClose(_)).WillOnce(InvokeWithoutArgs([this] {
+    pipeline.reset();
+    return makeMoveWrapper(makeFuture());
+  }));
+
+  handler->unsubscribe(0);
+}
+
+TEST_F(BroadcastHandlerTest, SubscriberLag) {
+  // Aggregate per-subscriber lag into a snapshot
+  EXPECT_EQ(handler->subscribe(&subscriber0), 0);
+  EXPECT_EQ(handler->subscribe(&subscriber1), 1);
+
+  EXPECT_CALL(subscriber0, pendingLag()).WillRepeatedly(Return(0));
+  EXPECT_CALL(subscriber1, pendingLag()).WillRepeatedly(Return(1024));
+
+  auto snapshot = handler->getSubscriberLag(100);
+  EXPECT_EQ(snapshot.subscribers, 2);
+  EXPECT_EQ(snapshot.totalLag, 1024);
+  EXPECT_EQ(snapshot.maxLag, 1024);
+  EXPECT_EQ(snapshot.laggingSubscribers, 1);
+
+  EXPECT_CALL(*handler, mockClose(_)).WillOnce(InvokeWithoutArgs([this] {
+    pipeline.reset();
+    return makeMoveWrapper(makeFuture());
+  }));
+
+  // Unsubscribe all subscribers. The handler should be deleted now.
+  handler->unsubscribe(0);
+  handler->unsubscribe(1);
+}
+
 TEST_F(BroadcastHandlerTest, OnCompleted) {
   // Test with EOF on the handler
   EXPECT_CALL(*decoder, decode(_, _, _, _))
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <thread>
+
 #include <wangle/bootstrap/ServerBootstrap.h>
 #include <wangle/channel/broadcast/BroadcastPool.h>
 #include <wangle/channel/broadcast/test/Mocks.h>
@@ -546,3 +548,107 @@ TEST_F(BroadcastPoolTest, ThreadLocalPool) {
   pipeline2->readEOF();
   pipeline4->readEOF();
 }
+
+TEST_F(BroadcastPoolTest, PrewarmAndPin) {
+  std::string routingData = "url1";
+  auto base = EventBaseManager::get()->getEventBase();
+
+  // Nothing to pin before a broadcast exists.
+  EXPECT_FALSE(pool->pin(routingData));
+
+  // Prewarm establishes the upstream ahead of demand and pins it so it
+  // survives with zero subscribers.
+  bool prewarmed = false;
+  EXPECT_CALL(*pipelineFactory, setRoutingData(_, "url1")).Times(1);
+  pool->prewarm(routingData).thenValue([&](auto&&) { prewarmed = true; });
+  base->loopOnce(); // Do async connect
+  EXPECT_TRUE(prewarmed);
+  EXPECT_TRUE(pool->isBroadcasting(routingData));
+
+  // The first subscriber attaches warm, inline.
+  BroadcastHandler<int, std::string>* handler = nullptr;
+  uint64_t subscriptionId = 0;
+  pool->getHandler(routingData)
+      .thenValue([&](BroadcastHandler<int, std::string>* h) {
+        handler = h;
+        subscriptionId = h->subscribe(&subscriber);
+      });
+  ASSERT_TRUE(handler != nullptr);
+  EXPECT_EQ(1, pool->getPoolStats().prewarms);
+  EXPECT_EQ(0, pool->getPoolStats().coldStarts);
+  EXPECT_EQ(1, pool->getPoolStats().warmAttaches);
+
+  // The pin holds the broadcast through a subscriber gap.
+  handler->unsubscribe(subscriptionId);
+  EXPECT_TRUE(pool->isBroadcasting(routingData));
+
+  // Releasing the last pin while idle closes the broadcast.
+  EXPECT_TRUE(pool->unpin(routingData));
+  EXPECT_FALSE(pool->isBroadcasting(routingData));
+  EXPECT_FALSE(pool->unpin(routingData));
+}
+
+TEST_F(BroadcastPoolTest, PinIdleLinger) {
+  std::string routingData = "url1";
+  auto base = EventBaseManager::get()->getEventBase();
+  pool->setPinIdleLinger(std::chrono::milliseconds(1));
+
+  EXPECT_CALL(*pipelineFactory, setRoutingData(_, "url1")).Times(1);
+  pool->prewarm(routingData);
+  base->loopOnce(); // Do async connect
+  EXPECT_TRUE(pool->isBroadcasting(routingData));
+
+  // No subscriber showed up within the linger; the pin expires and the
+  // idle broadcast closes.
+  /* sleep override */ std::this_thread::sleep_for(
+      std::chrono::milliseconds(5));
+  base->loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_FALSE(pool->isBroadcasting(routingData));
+}
+
+class TestWeightedServerPool : public WeightedServerPool<std::string> {
+ public:
+  using WeightedServerPool<std::string>::WeightedServerPool;
+  using WeightedServerPool<std::string>::pickServer;
+  using WeightedServerPool<std::string>::recordSuccess;
+  using WeightedServerPool<std::string>::recordFailure;
+};
+
+TEST(WeightedServerPool, SelectionAndCircuitBreaking) {
+  std::vector<SocketAddress> servers = {
+      SocketAddress("::1", 1111), SocketAddress("::1", 2222)};
+  TestWeightedServerPool pool(
+      servers,
+      0.5 /* ewmaWeight */,
+      2 /* circuitFailureThreshold */,
+      std::chrono::minutes(1));
+
+  // Latency feedback skews selection heavily toward the fast server.
+  pool.recordSuccess(0, std::chrono::microseconds(50));
+  pool.recordSuccess(1, std::chrono::microseconds(50000));
+  size_t fastPicks = 0;
+  for (int i = 0; i < 200; i++) {
+    auto idx = pool.pickServer();
+    ASSERT_TRUE(idx.hasValue());
+    fastPicks += (*idx == 0);
+  }
+  EXPECT_GT(fastPicks, 150);
+
+  // The EWMA follows fresh samples.
+  pool.recordSuccess(1, std::chrono::microseconds(1000));
+  EXPECT_LT(pool.getServerStats()[1].ewmaLatencyUs, 50000);
+
+  // Consecutive failures open the circuit and picks avoid the server.
+  pool.recordFailure(0);
+  pool.recordFailure(0);
+  for (int i = 0; i < 20; i++) {
+    auto idx = pool.pickServer();
+    ASSERT_TRUE(idx.hasValue());
+    EXPECT_EQ(*idx, 1);
+  }
+
+  // With every circuit open there is nothing left to pick.
+  pool.recordFailure(1);
+  pool.recordFailure(1);
+  EXPECT_FALSE(pool.pickServer().hasValue());
+}
@@ -33,6 +33,7 @@ class MockSubscriber : public Subscriber<T, R> {
   MOCK_METHOD1_T(onNext, void(const T&));
   MOCK_METHOD1(onError, void(const folly::exception_wrapper ex));
   MOCK_METHOD0(onCompleted, void());
+  MOCK_CONST_METHOD0(pendingLag, uint64_t());
 
   MOCK_METHOD0_T(routingData, R&());
 
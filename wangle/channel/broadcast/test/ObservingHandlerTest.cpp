@@ -168,6 +168,69 @@ TEST_F(ObservingHandlerTest, ConnectErrorHandlerDeletion) {
   promise.setException(std::exception());
 }
 
+TEST_F(ObservingHandlerTest, SlowSubscriberDropOldest) {
+  InSequence dummy;
+
+  observingHandler->setWriteQueueWatermarks(2, 1);
+
+  EXPECT_CALL(*prevHandler, transportActive(_))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* ctx) {
+        ctx->fireTransportActive();
+      }));
+  // Verify that ingress is paused
+  EXPECT_CALL(*prevHandler, transportInactive(_)).WillOnce(Return());
+  EXPECT_CALL(pool, mockGetHandler(_))
+      .WillOnce(Return(MoveWrapper<Future<BroadcastHandler<int, std::string>*>>(
+          broadcastHandler.get())));
+  EXPECT_CALL(*broadcastHandler, subscribe(_)).Times(1);
+  // Verify that ingress is resumed
+  EXPECT_CALL(*prevHandler, transportActive(_))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* ctx) {
+        ctx->fireTransportActive();
+      }));
+
+  // Initialize the pipeline
+  pipeline->transportActive();
+
+  // Saturate the transport. Ingress pauses and broadcast payloads now
+  // queue locally instead of being written.
+  EXPECT_CALL(*prevHandler, transportUnwritable(_))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* ctx) {
+        ctx->fireTransportUnwritable();
+      }));
+  EXPECT_CALL(*prevHandler, transportInactive(_)).WillOnce(Return());
+  pipeline->transportUnwritable();
+
+  observingHandler->onNext(1);
+  observingHandler->onNext(2);
+  // The third payload exceeds the high watermark; the oldest payloads
+  // are shed down to the low watermark.
+  observingHandler->onNext(3);
+  EXPECT_EQ(observingHandler->getDroppedPayloads(), 2);
+  EXPECT_EQ(observingHandler->pendingLag(), 1);
+
+  // Draining on writability writes only the surviving payload.
+  EXPECT_CALL(*prevHandler, transportWritable(_))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* ctx) {
+        ctx->fireTransportWritable();
+      }));
+  EXPECT_CALL(*observingHandler, mockWrite(_, 3))
+      .WillOnce(Return(makeMoveWrapper(makeFuture())));
+  // Verify that ingress is resumed
+  EXPECT_CALL(*prevHandler, transportActive(_))
+      .WillOnce(Invoke([&](MockBytesToBytesHandler::Context* ctx) {
+        ctx->fireTransportActive();
+      }));
+  pipeline->transportWritable();
+  EXPECT_EQ(observingHandler->pendingLag(), 0);
+
+  EXPECT_CALL(*observingHandler, mockClose(_))
+      .WillOnce(Return(makeMoveWrapper(makeFuture())));
+
+  // Finish the broadcast
+  observingHandler->onCompleted();
+}
+
 TEST_F(ObservingHandlerTest, BroadcastError) {
   InSequence dummy;
 
@@ -355,3 +418,27 @@ TEST_F(ObservingHandlerTest, WriteErrorHandlerDeletion) {
   pipeline.reset();
   promise.setException(std::exception());
 }
+
+TEST(SharedIOBufWriteHandlerTest, ClonesSharePayloadData) {
+  auto bytesHandler = std::make_shared<StrictMock<MockBytesToBytesHandler>>();
+  auto pipeline = Pipeline<IOBufQueue&, std::shared_ptr<IOBuf>>::create();
+  pipeline->addBack(bytesHandler);
+  pipeline->addBack(SharedIOBufWriteHandler());
+  pipeline->finalize();
+
+  auto payload = std::shared_ptr<IOBuf>(IOBuf::copyBuffer("shared payload"));
+  const auto* payloadData = payload->data();
+
+  // Each write clones the snapshot; the clones point at the same bytes
+  EXPECT_CALL(*bytesHandler, write(_, _))
+      .Times(2)
+      .WillRepeatedly(Invoke(
+          [&](MockBytesToBytesHandler::Context*,
+              std::shared_ptr<IOBuf> buf) {
+            EXPECT_EQ(payloadData, buf->data());
+            return makeMoveWrapper(makeFuture());
+          }));
+
+  pipeline->write(payload);
+  pipeline->write(payload);
+}
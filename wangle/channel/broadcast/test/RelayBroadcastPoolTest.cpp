@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/channel/broadcast/RelayBroadcastPool.h>
+#include <wangle/channel/broadcast/test/Mocks.h>
+
+using namespace wangle;
+using namespace folly;
+using namespace testing;
+
+class RelayBroadcastPoolTest : public Test {
+ public:
+  class TestBroadcastHandler : public BroadcastHandler<int, std::string> {
+   public:
+    folly::Future<folly::Unit> close(Context*) override {
+      closed = true;
+      return folly::makeFuture();
+    }
+
+    bool closed{false};
+  };
+
+  void SetUp() override {
+    auto upstreamPool = std::make_unique<NiceMock<MockBroadcastPool>>();
+    mockPool = upstreamPool.get();
+    pool = std::make_unique<RelayBroadcastPool<int, std::string>>(
+        &upstreamEvb, std::move(upstreamPool));
+  }
+
+  void TearDown() override {
+    Mock::VerifyAndClear(&subscriberA);
+    Mock::VerifyAndClear(&subscriberB);
+    pool.reset();
+  }
+
+ protected:
+  EventBase upstreamEvb;
+  EventBase evbA;
+  EventBase evbB;
+
+  NiceMock<MockBroadcastPool>* mockPool{nullptr};
+  std::unique_ptr<RelayBroadcastPool<int, std::string>> pool;
+  TestBroadcastHandler handler;
+
+  StrictMock<MockSubscriber<int, std::string>> subscriberA;
+  StrictMock<MockSubscriber<int, std::string>> subscriberB;
+};
+
+TEST_F(RelayBroadcastPoolTest, FanOutSharesOneUpstream) {
+  EXPECT_CALL(*mockPool, mockGetHandler("stream1"))
+      .WillOnce(Return(makeMoveWrapper(
+          makeFuture<BroadcastHandler<int, std::string>*>(&handler))));
+
+  // Subscribers on two different loops share one upstream connect.
+  auto subA = pool->subscribe("stream1", &evbA, &subscriberA);
+  auto subB = pool->subscribe("stream1", &evbB, &subscriberB);
+  EXPECT_TRUE(pool->isRelaying("stream1"));
+
+  upstreamEvb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(handler.getSubscriberLag(0).subscribers, 1);
+
+  // One upstream payload reaches both loops' subscribers.
+  EXPECT_CALL(subscriberA, onNext(42));
+  EXPECT_CALL(subscriberB, onNext(42));
+  handler.read(nullptr, 42);
+  evbA.loopOnce(EVLOOP_NONBLOCK);
+  evbB.loopOnce(EVLOOP_NONBLOCK);
+
+  auto stats = pool->getPoolStats();
+  EXPECT_EQ(stats.upstreamConnects, 1);
+  EXPECT_EQ(stats.relaysCreated, 2);
+
+  // Detaching the last subscription closes the shared upstream.
+  subA.relay->unsubscribe(subA.subscriptionId);
+  subB.relay->unsubscribe(subB.subscriptionId);
+  upstreamEvb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_TRUE(handler.closed);
+  EXPECT_FALSE(pool->isRelaying("stream1"));
+}
+
+TEST_F(RelayBroadcastPoolTest, UpstreamEofReachesSubscribers) {
+  EXPECT_CALL(*mockPool, mockGetHandler("stream1"))
+      .WillOnce(Return(makeMoveWrapper(
+          makeFuture<BroadcastHandler<int, std::string>*>(&handler))));
+
+  auto sub = pool->subscribe("stream1", &evbA, &subscriberA);
+  upstreamEvb.loopOnce(EVLOOP_NONBLOCK);
+
+  InSequence dummy;
+  EXPECT_CALL(subscriberA, onNext(1));
+  EXPECT_CALL(subscriberA, onCompleted());
+
+  // Queued payloads are handed over ahead of the terminal event.
+  handler.read(nullptr, 1);
+  handler.readEOF(nullptr);
+  EXPECT_FALSE(pool->isRelaying("stream1"));
+  evbA.loopOnce(EVLOOP_NONBLOCK);
+
+  // The subscription ended with the stream; nothing left to detach.
+  (void)sub;
+}
+
+TEST_F(RelayBroadcastPoolTest, ConnectErrorReachesSubscribers) {
+  EXPECT_CALL(*mockPool, mockGetHandler("stream1"))
+      .WillOnce(Return(makeMoveWrapper(
+          makeFuture<BroadcastHandler<int, std::string>*>(
+              std::runtime_error("connect failed")))));
+
+  pool->subscribe("stream1", &evbA, &subscriberA);
+  EXPECT_CALL(subscriberA, onError(_));
+  upstreamEvb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_FALSE(pool->isRelaying("stream1"));
+  evbA.loopOnce(EVLOOP_NONBLOCK);
+}
+
+TEST_F(RelayBroadcastPoolTest, SlowRelayShedsNewestPayloads) {
+  // A ring of capacity four holds three payloads.
+  pool->setRelayQueueCapacity(4);
+
+  EXPECT_CALL(*mockPool, mockGetHandler("stream1"))
+      .WillOnce(Return(makeMoveWrapper(
+          makeFuture<BroadcastHandler<int, std::string>*>(&handler))));
+
+  auto sub = pool->subscribe("stream1", &evbA, &subscriberA);
+  upstreamEvb.loopOnce(EVLOOP_NONBLOCK);
+
+  // The subscriber's loop is not running while five payloads arrive:
+  // the ring holds the first three and the overflow is shed without
+  // ever blocking the upstream thread.
+  for (int i = 0; i < 5; ++i) {
+    handler.read(nullptr, i);
+  }
+  EXPECT_CALL(subscriberA, onNext(0));
+  EXPECT_CALL(subscriberA, onNext(1));
+  EXPECT_CALL(subscriberA, onNext(2));
+  evbA.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(sub.relay->getDroppedPayloads(), 2);
+
+  sub.relay->unsubscribe(sub.subscriptionId);
+  upstreamEvb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_TRUE(handler.closed);
+}
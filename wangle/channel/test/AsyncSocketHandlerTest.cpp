@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/net/NetOps.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
 #include <wangle/channel/AsyncSocketHandler.h>
 #include <wangle/channel/Pipeline.h>
 #include <wangle/channel/test/MockHandler.h>
@@ -83,3 +86,375 @@ TEST(AsyncSocketHandlerTest, TransportActiveInactive) {
   EXPECT_CALL(*handler, transportInactive(_)).Times(0);
   pipeline->close();
 }
+
+TEST(AsyncSocketHandlerTest, CheapTransportErrorDelivery) {
+  EventBase evb;
+  auto socket = AsyncSocket::newSocket(&evb);
+  auto handler = std::make_shared<StrictMock<MockBytesToBytesHandler>>();
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket)));
+  pipeline->addBack(handler);
+  pipeline->finalize();
+  auto* socketHandler = pipeline->getHandler<AsyncSocketHandler>();
+  socketHandler->setCheapTransportErrors(true);
+
+  // A mapped error arrives as a plain enum, not an exception_wrapper.
+  EXPECT_CALL(*handler, readError(_, TransportErrorCode::CONNECTION_RESET))
+      .Times(1);
+  socketHandler->readErr(AsyncSocketException(
+      AsyncSocketException::NETWORK_ERROR,
+      "Connection reset by peer",
+      ECONNRESET));
+
+  // Unmapped errors keep the exception path.
+  EXPECT_CALL(*handler, readException(_, _)).Times(1);
+  socketHandler->readErr(
+      AsyncSocketException(AsyncSocketException::SSL_ERROR, "handshake"));
+
+  EXPECT_CALL(*handler, mockClose(_))
+      .WillOnce(Return(handler->defaultFuture()));
+  pipeline->close();
+}
+
+TEST(AsyncSocketHandlerTest, TransportErrorCodeMapping) {
+  EXPECT_EQ(
+      TransportErrorCode::TIMED_OUT,
+      AsyncSocketHandler::transportErrorCode(
+          AsyncSocketException(AsyncSocketException::TIMED_OUT, "timeout")));
+  EXPECT_EQ(
+      TransportErrorCode::BROKEN_PIPE,
+      AsyncSocketHandler::transportErrorCode(AsyncSocketException(
+          AsyncSocketException::NETWORK_ERROR, "write", EPIPE)));
+  EXPECT_EQ(
+      TransportErrorCode::UNKNOWN,
+      AsyncSocketHandler::transportErrorCode(
+          AsyncSocketException(AsyncSocketException::SSL_ERROR, "alert")));
+
+  // Lazy synthesis produces the exception the code stands for.
+  auto ew = AsyncSocketHandler::makeTransportException(
+      TransportErrorCode::CONNECTION_RESET);
+  auto* ex = ew.get_exception<AsyncSocketException>();
+  ASSERT_NE(nullptr, ex);
+  EXPECT_EQ(ECONNRESET, ex->getErrno());
+}
+
+TEST(AsyncSocketHandlerTest, ZeroCopyWriteStats) {
+  EventBase evb;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket))).finalize();
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+
+  handler->setZeroCopyWrites(64 * 1024);
+
+  pipeline->write(IOBuf::copyBuffer(std::string(128, 'a')));
+  pipeline->write(IOBuf::copyBuffer(std::string(256 * 1024, 'b')));
+  evb.loopOnce(EVLOOP_NONBLOCK);
+
+  const auto& stats = handler->getZeroCopyStats();
+  if (handler->isZeroCopyEnabled()) {
+    // The kernel accepted SO_ZEROCOPY: only the large chain is tagged.
+    EXPECT_EQ(1, stats.zeroCopyWrites);
+    EXPECT_EQ(1, stats.copiedWrites);
+  } else {
+    // Zero-copy unavailable on this transport; both writes were copied.
+    EXPECT_EQ(0, stats.zeroCopyWrites);
+    EXPECT_EQ(2, stats.copiedWrites);
+  }
+
+  netops::close(fds[1]);
+  pipeline->close();
+}
+
+TEST(AsyncSocketHandlerTest, TxTimestampSampling) {
+  EventBase evb;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket))).finalize();
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+
+  handler->enableTxTimestamping(2); // sample every second write
+  for (int i = 0; i < 4; i++) {
+    pipeline->write(IOBuf::copyBuffer("ping"));
+  }
+  evb.loopOnce(EVLOOP_NONBLOCK);
+
+  // AF_UNIX sockets may not support TX timestamps; in that case the
+  // observer stops the sampling. Otherwise every second write is tagged.
+  const auto& stats = handler->getTxLatencyStats();
+  EXPECT_LE(stats.sampledWrites, 2);
+  EXPECT_LE(stats.completedSamples, stats.sampledWrites);
+
+  pipeline->close();
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, WriteDeadlineClosesSlowConnection) {
+  EventBase evb;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  // A tiny send buffer so a large write stays queued in the socket while
+  // the peer never reads.
+  int sndBuf = 4096;
+  netops::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndBuf, sizeof(sndBuf));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto observer = std::make_shared<MockBytesToBytesHandler>();
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket)));
+  pipeline->addBack(observer);
+  pipeline->finalize();
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+
+  pipeline->setWriteDeadline(std::chrono::milliseconds(20));
+  EXPECT_CALL(*observer, transportInactive(_)).Times(AnyNumber());
+  EXPECT_CALL(*observer, write(_, _))
+      .WillRepeatedly(
+          Invoke([](MockBytesToBytesHandler::Context* ctx,
+                    std::shared_ptr<IOBuf> buf) {
+            return folly::MoveWrapper<folly::Future<folly::Unit>>(
+                ctx->fireWrite(buf->clone()));
+          }));
+
+  // A write the peer keeps up with doesn't trip the deadline.
+  pipeline->write(IOBuf::copyBuffer("ping"));
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(0, handler->getWriteDeadlineExpirations());
+
+  bool sawTimeout = false;
+  EXPECT_CALL(*observer, readException(_, _))
+      .WillOnce(Invoke(
+          [&](MockBytesToBytesHandler::Context*, exception_wrapper ex) {
+            sawTimeout = ex.with_exception([](const AsyncSocketException& e) {
+              EXPECT_EQ(AsyncSocketException::TIMED_OUT, e.getType());
+            });
+          }));
+
+  // This one can never drain: it overflows the send buffer and the peer
+  // stops reading. The loop runs until the deadline closes the socket.
+  auto future = pipeline->write(IOBuf::copyBuffer(std::string(1 << 20, 'x')));
+  evb.loop();
+
+  EXPECT_TRUE(sawTimeout);
+  EXPECT_EQ(1, handler->getWriteDeadlineExpirations());
+  ASSERT_TRUE(future.isReady());
+  EXPECT_TRUE(future.hasException());
+
+  pipeline->close();
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, InlineWriteCallbackReuse) {
+  EventBase evb;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket))).finalize();
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+
+  // Sequential small writes complete before the next one starts, so the
+  // same inline slot serves all of them and nothing hits the heap.
+  for (int i = 0; i < 8; i++) {
+    auto future = pipeline->write(IOBuf::copyBuffer("ping"));
+    evb.loopOnce(EVLOOP_NONBLOCK);
+    EXPECT_TRUE(future.isReady());
+  }
+  const auto& stats = handler->getWriteCallbackStats();
+  EXPECT_EQ(8, stats.inlineCallbacks);
+  EXPECT_EQ(0, stats.heapCallbacks);
+
+  pipeline->close();
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, WriteCallbacksOverflowToHeap) {
+  EventBase evb;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  // A tiny send buffer keeps every write queued in the socket.
+  int sndBuf = 4096;
+  netops::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndBuf, sizeof(sndBuf));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket))).finalize();
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+
+  // The peer never reads, so all six writes stay in flight; the two
+  // beyond the inline slots fall back to heap allocation.
+  std::vector<Future<Unit>> futures;
+  for (int i = 0; i < 6; i++) {
+    futures.push_back(
+        pipeline->write(IOBuf::copyBuffer(std::string(1 << 16, 'x'))));
+  }
+  const auto& stats = handler->getWriteCallbackStats();
+  EXPECT_EQ(4, stats.inlineCallbacks);
+  EXPECT_EQ(2, stats.heapCallbacks);
+
+  // Closing fails the queued writes; inline and heap callbacks alike
+  // deliver the error.
+  pipeline->close();
+  for (auto& future : futures) {
+    ASSERT_TRUE(future.isReady());
+    EXPECT_TRUE(future.hasException());
+  }
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, PooledReadBuffers) {
+  EventBase evb;
+  // Declared before the pipeline: the pool must outlive the buffers.
+  ReadBufferPool pool;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto reader = std::make_shared<MockBytesToBytesHandler>();
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket)));
+  pipeline->addBack(reader);
+  pipeline->finalize();
+
+  size_t bytesRead = 0;
+  EXPECT_CALL(*reader, read(_, _))
+      .WillRepeatedly(Invoke([&](MockBytesToBytesHandler::Context*,
+                                 IOBufQueue& q) {
+        bytesRead += q.chainLength();
+        q.move(); // consume; the pooled buffer frees on this thread
+      }));
+
+  pipeline->getHandler<AsyncSocketHandler>(0)->setReadBufferPool(&pool);
+  pipeline->transportActive();
+
+  ASSERT_EQ(5, netops::send(fds[1], "hello", 5, 0));
+  evb.loopOnce();
+
+  EXPECT_EQ(5, bytesRead);
+  const auto stats = pool.getPoolStats();
+  EXPECT_GE(stats.allocations, 1);
+  // The consumed buffer went back on the free list, not to free().
+  EXPECT_GE(stats.recycled, 1);
+  EXPECT_EQ(0, stats.crossThreadFrees);
+
+  pipeline->close();
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, BufferMovableReads) {
+  EventBase evb;
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto reader = std::make_shared<MockBytesToBytesHandler>();
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket)));
+  pipeline->addBack(reader);
+  pipeline->finalize();
+
+  std::string received;
+  EXPECT_CALL(*reader, read(_, _))
+      .WillRepeatedly(Invoke([&](MockBytesToBytesHandler::Context*,
+                                 IOBufQueue& q) {
+        received += q.move()->moveToFbString().toStdString();
+      }));
+
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+  handler->setBufferMovableReads(true);
+  pipeline->transportActive();
+
+  ASSERT_EQ(5, netops::send(fds[1], "hello", 5, 0));
+  evb.loopOnce();
+
+  EXPECT_EQ("hello", received);
+  // The bytes arrived as a moved transport-owned buffer, not a copy
+  // through getReadBuffer().
+  EXPECT_GE(handler->getMovedReadBuffers(), 1);
+
+  pipeline->close();
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, PipelineMigrateToEventBase) {
+  EventBase evb;
+  ScopedEventBaseThread targetThread;
+  auto* target = targetThread.getEventBase();
+
+  NetworkSocket fds[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  auto socket = AsyncSocket::newSocket(&evb, fds[0]);
+  auto* rawSocket = socket.get();
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket))).finalize();
+  pipeline->transportActive();
+
+  EXPECT_TRUE(pipeline->migrateTo(target));
+
+  // The re-attach runs ahead of this callback on the target loop.
+  Baton<> attached;
+  target->runInEventBaseThread([&] { attached.post(); });
+  attached.wait();
+  EXPECT_EQ(target, rawSocket->getEventBase());
+  EXPECT_EQ(
+      rawSocket,
+      pipeline->getTransport()->getUnderlyingTransport<AsyncSocket>());
+
+  // The target loop owns the connection now; close it there.
+  target->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { pipeline->close(); });
+  netops::close(fds[1]);
+}
+
+TEST(AsyncSocketHandlerTest, AdaptiveReadBufferGrowsAndShrinks) {
+  EventBase evb;
+  auto socket = AsyncSocket::newSocket(&evb);
+  auto reader = std::make_shared<MockBytesToBytesHandler>();
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(AsyncSocketHandler(std::move(socket)));
+  pipeline->addBack(reader);
+  pipeline->finalize();
+  EXPECT_CALL(*reader, read(_, _)).Times(AnyNumber());
+
+  auto handler = pipeline->getHandler<AsyncSocketHandler>(0);
+  handler->setAdaptiveReadBuffer(1024, 8192);
+  EXPECT_EQ(1024, handler->getAdaptiveReadSize());
+
+  // Simulate the socket's read cycle: full reads double the allocation.
+  auto simulateRead = [&](size_t len) {
+    void* buf = nullptr;
+    size_t cap = 0;
+    handler->getReadBuffer(&buf, &cap);
+    ASSERT_GE(cap, handler->getAdaptiveReadSize());
+    handler->readDataAvailable(len);
+  };
+
+  simulateRead(1024);
+  EXPECT_EQ(2048, handler->getAdaptiveReadSize());
+  simulateRead(2048);
+  EXPECT_EQ(4096, handler->getAdaptiveReadSize());
+
+  // A lone small read doesn't shrink; two in a row halve the size.
+  simulateRead(100);
+  EXPECT_EQ(4096, handler->getAdaptiveReadSize());
+  simulateRead(100);
+  EXPECT_EQ(2048, handler->getAdaptiveReadSize());
+
+  // An intermediate fill level resets the shrink streak.
+  simulateRead(100);
+  simulateRead(1000);
+  simulateRead(100);
+  EXPECT_EQ(2048, handler->getAdaptiveReadSize());
+
+  // Bounds hold at both ends.
+  simulateRead(100);
+  simulateRead(100);
+  EXPECT_EQ(1024, handler->getAdaptiveReadSize());
+  simulateRead(100);
+  simulateRead(100);
+  EXPECT_EQ(1024, handler->getAdaptiveReadSize());
+  for (int i = 0; i < 5; ++i) {
+    simulateRead(handler->getAdaptiveReadSize());
+  }
+  EXPECT_EQ(8192, handler->getAdaptiveReadSize());
+}
@@ -83,6 +83,35 @@ TEST_F(FileRegionTest, Basic) {
   ASSERT_EQ(receivedBytes, count);
 }
 
+TEST_F(FileRegionTest, Buffered) {
+  // The pread+writeChain engine used for TLS transports and non-Linux
+  // platforms; forced here so it gets exercised on a plain socket too.
+  const size_t count = 10000000; // 10 MB, several chunks
+  std::unique_ptr<uint8_t[]> zeroBuf = std::make_unique<uint8_t[]>(count);
+  write(fd, zeroBuf.get(), count);
+
+  FileRegion fileRegion(fd, 0, count);
+  auto f = fileRegion.transferToBuffered(socket);
+  try {
+    std::move(f).getVia(&evb);
+  } catch (std::exception& e) {
+    LOG(FATAL) << exceptionStr(e);
+  }
+
+  // Let the reads run to completion
+  socket->shutdownWrite();
+  evb.loopIgnoreKeepAlive();
+
+  ASSERT_EQ(rcb.state, STATE_SUCCEEDED);
+
+  size_t receivedBytes = 0;
+  for (auto& buf : rcb.buffers) {
+    receivedBytes += buf.length;
+    ASSERT_EQ(memcmp(buf.buffer, zeroBuf.get(), buf.length), 0);
+  }
+  ASSERT_EQ(receivedBytes, count);
+}
+
 TEST_F(FileRegionTest, Repeated) {
   const size_t count = 1000000;
   std::unique_ptr<uint8_t[]> zeroBuf = std::make_unique<uint8_t[]>(count);
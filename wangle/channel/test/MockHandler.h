@@ -33,6 +33,7 @@ class MockHandler : public Handler<Rin, Rout, Win, Wout> {
   MOCK_METHOD2_T(read_, void(Context*, Rin&));
   MOCK_METHOD1_T(readEOF, void(Context*));
   MOCK_METHOD2_T(readException, void(Context*, folly::exception_wrapper));
+  MOCK_METHOD2_T(readError, void(Context*, TransportErrorCode));
 
   MOCK_METHOD2_T(write_, void(Context*, Win&));
   MOCK_METHOD1_T(close_, void(Context*));
@@ -73,9 +74,12 @@ class MockBytesToBytesHandler : public BytesToBytesHandler {
 
   MOCK_METHOD1(transportActive, void(Context*));
   MOCK_METHOD1(transportInactive, void(Context*));
+  MOCK_METHOD1(transportWritable, void(Context*));
+  MOCK_METHOD1(transportUnwritable, void(Context*));
   MOCK_METHOD2(read, void(Context*, folly::IOBufQueue&));
   MOCK_METHOD1(readEOF, void(Context*));
   MOCK_METHOD2(readException, void(Context*, folly::exception_wrapper));
+  MOCK_METHOD2(readError, void(Context*, TransportErrorCode));
   MOCK_METHOD2(
       write,
       folly::MoveWrapper<folly::Future<folly::Unit>>(
@@ -17,6 +17,7 @@
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <wangle/channel/FlushCoordinator.h>
 #include <wangle/channel/OutputBufferingHandler.h>
 #include <wangle/channel/StaticPipeline.h>
 #include <wangle/channel/test/MockHandler.h>
@@ -65,3 +66,240 @@ TEST(OutputBufferingHandlerTest, Basic) {
   EXPECT_TRUE(f.isReady());
   pipeline.reset();
 }
+
+TEST(OutputBufferingHandlerTest, EarlyFlushOnThreshold) {
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  handler.setMaxBufferedBytes(8);
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+
+  EventBase eb;
+  auto socket = AsyncSocket::newSocket(&eb);
+  pipeline->setTransport(std::move(socket));
+
+  // Crossing the byte threshold flushes without waiting for the loop.
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("helloworld")));
+  auto f1 = pipeline->write(IOBuf::copyBuffer("hello"));
+  EXPECT_FALSE(f1.isReady());
+  EXPECT_EQ(handler.getBufferedBytes(), 5);
+  auto f2 = pipeline->write(IOBuf::copyBuffer("world"));
+  EXPECT_EQ(handler.getBufferedBytes(), 0);
+  EXPECT_EQ(handler.getFlushStats().earlyFlushes, 1);
+  EXPECT_EQ(handler.getFlushStats().maxFlushBytes, 10);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
+
+TEST(OutputBufferingHandlerTest, FlushDeadline) {
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  handler.setMaxFlushLatency(std::chrono::milliseconds(1));
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+
+  EventBase eb;
+  auto socket = AsyncSocket::newSocket(&eb);
+  pipeline->setTransport(std::move(socket));
+
+  // With a flush deadline there is no per-iteration loop callback; the
+  // chain accumulates until the timer fires and keeps the loop alive
+  // until it does.
+  auto f1 = pipeline->write(IOBuf::copyBuffer("hello"));
+  auto f2 = pipeline->write(IOBuf::copyBuffer("world"));
+  EXPECT_FALSE(f1.isReady());
+  EXPECT_FALSE(f2.isReady());
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("helloworld")));
+  eb.loop();
+  EXPECT_TRUE(f1.isReady());
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_EQ(handler.getFlushStats().deadlineFlushes, 1);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
+
+TEST(OutputBufferingHandlerTest, FlushNow) {
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  handler.setMaxFlushLatency(std::chrono::seconds(10));
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+
+  EventBase eb;
+  auto socket = AsyncSocket::newSocket(&eb);
+  pipeline->setTransport(std::move(socket));
+
+  auto f = pipeline->write(IOBuf::copyBuffer("hello"));
+  EXPECT_FALSE(f.isReady());
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("hello")));
+  handler.flushNow();
+  EXPECT_TRUE(f.isReady());
+  EXPECT_EQ(handler.getBufferedBytes(), 0);
+
+  // flushNow() with nothing buffered is a no-op.
+  handler.flushNow();
+  EXPECT_EQ(handler.getFlushStats().flushes, 1);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
+
+TEST(OutputBufferingHandlerTest, CoordinatedFlush) {
+  MockBytesHandler mockHandler1;
+  MockBytesHandler mockHandler2;
+  EXPECT_CALL(mockHandler1, attachPipeline(_));
+  EXPECT_CALL(mockHandler2, attachPipeline(_));
+  OutputBufferingHandler handler1;
+  OutputBufferingHandler handler2;
+  handler1.setUseFlushCoordinator(true);
+  handler2.setUseFlushCoordinator(true);
+  auto pipeline1 = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler1, &handler1);
+  auto pipeline2 = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler2, &handler2);
+
+  EventBase eb;
+  pipeline1->setTransport(AsyncSocket::newSocket(&eb));
+  pipeline2->setTransport(AsyncSocket::newSocket(&eb));
+
+  // Both pipelines go dirty in the same iteration; the coordinator holds
+  // one loop callback for the pair and flushes them in one pass.
+  auto f1 = pipeline1->write(IOBuf::copyBuffer("hello"));
+  auto f2 = pipeline2->write(IOBuf::copyBuffer("world"));
+  EXPECT_FALSE(f1.isReady());
+  EXPECT_FALSE(f2.isReady());
+  EXPECT_EQ(FlushCoordinator::get(&eb).dirtyCount(), 2);
+
+  EXPECT_CALL(mockHandler1, write_(_, IOBufContains("hello")));
+  EXPECT_CALL(mockHandler2, write_(_, IOBufContains("world")));
+  eb.loopOnce();
+  EXPECT_TRUE(f1.isReady());
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_EQ(handler1.getFlushStats().coordinatedFlushes, 1);
+  EXPECT_EQ(handler2.getFlushStats().coordinatedFlushes, 1);
+  EXPECT_EQ(FlushCoordinator::get(&eb).dirtyCount(), 0);
+
+  EXPECT_CALL(mockHandler1, detachPipeline(_));
+  EXPECT_CALL(mockHandler2, detachPipeline(_));
+  pipeline1.reset();
+  pipeline2.reset();
+}
+
+TEST(OutputBufferingHandlerTest, NoBatchWrite) {
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  handler.setMaxFlushLatency(std::chrono::seconds(10));
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+
+  EventBase eb;
+  auto socket = AsyncSocket::newSocket(&eb);
+  pipeline->setTransport(std::move(socket));
+
+  auto f1 = pipeline->write(IOBuf::copyBuffer("bulk"));
+  EXPECT_FALSE(f1.isReady());
+
+  // An EOR-flagged write flushes the whole buffered chain immediately.
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("bulkurgent")));
+  pipeline->setWriteFlags(WriteFlags::EOR);
+  auto f2 = pipeline->write(IOBuf::copyBuffer("urgent"));
+  pipeline->setWriteFlags(WriteFlags::NONE);
+  EXPECT_TRUE(f1.isReady());
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_EQ(handler.getFlushStats().noBatchFlushes, 1);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
+
+TEST(OutputBufferingHandlerTest, WriteMessageBoundary) {
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+
+  EventBase eb;
+  auto socket = AsyncSocket::newSocket(&eb);
+  pipeline->setTransport(std::move(socket));
+
+  // Header and body fragments of one message accumulate corked.
+  pipeline->beginWriteMessage();
+  EXPECT_TRUE(isSet(pipeline->getWriteFlags(), WriteFlags::CORK));
+  auto f1 = pipeline->write(IOBuf::copyBuffer("head"));
+  auto f2 = pipeline->write(IOBuf::copyBuffer("body"));
+  pipeline->endWriteMessage();
+  EXPECT_FALSE(isSet(pipeline->getWriteFlags(), WriteFlags::CORK));
+
+  // The message was complete by flush time, so the loop-end flush
+  // delivers one uncorked write.
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("headbody")));
+  eb.loopOnce();
+  EXPECT_TRUE(f1.isReady());
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_EQ(handler.getFlushStats().midMessageFlushes, 0);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
+
+TEST(OutputBufferingHandlerTest, MidMessageFlushStaysCorked) {
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  handler.setMaxBufferedBytes(4);
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+
+  EventBase eb;
+  auto socket = AsyncSocket::newSocket(&eb);
+  pipeline->setTransport(std::move(socket));
+
+  // The byte threshold forces a flush while the message is still open;
+  // the fragment goes down with the cork flag intact.
+  pipeline->beginWriteMessage();
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("head")));
+  auto f1 = pipeline->write(IOBuf::copyBuffer("head"));
+  EXPECT_TRUE(f1.isReady());
+  EXPECT_EQ(handler.getFlushStats().midMessageFlushes, 1);
+  EXPECT_TRUE(isSet(pipeline->getWriteFlags(), WriteFlags::CORK));
+
+  pipeline->endWriteMessage();
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("tail")));
+  auto f2 = pipeline->write(IOBuf::copyBuffer("tail"));
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_EQ(handler.getFlushStats().midMessageFlushes, 1);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
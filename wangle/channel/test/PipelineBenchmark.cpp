@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <wangle/channel/AsyncSocketHandler.h>
+#include <wangle/channel/Handler.h>
+#include <wangle/channel/OutputBufferingHandler.h>
+#include <wangle/channel/Pipeline.h>
+#include <wangle/channel/PrototypePipelineFactory.h>
+#include <wangle/channel/StaticPipeline.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+/**
+ * A pipeline hop that does no work of its own, so the benchmarks below
+ * measure traversal overhead only.
+ */
+class PassThroughHandler : public BytesToBytesHandler {};
+
+/**
+ * Sits at the front of the pipeline and completes writes without a
+ * transport; reads pass through unchanged.
+ */
+class WriteSink : public BytesToBytesHandler {
+ public:
+  Future<Unit> write(Context*, std::unique_ptr<IOBuf>) override {
+    return makeFuture();
+  }
+};
+
+/**
+ * Sits at the back of the pipeline and consumes reads; writes pass
+ * through unchanged.
+ */
+class ReadSink : public BytesToBytesHandler {
+ public:
+  void read(Context*, IOBufQueue& q) override {
+    q.move();
+  }
+};
+
+DefaultPipeline::Ptr makePipeline(size_t numPassThroughHandlers) {
+  auto pipeline = DefaultPipeline::create();
+  pipeline->addBack(WriteSink());
+  for (size_t i = 0; i < numPassThroughHandlers; i++) {
+    pipeline->addBack(PassThroughHandler());
+  }
+  pipeline->addBack(ReadSink());
+  pipeline->finalize();
+  return pipeline;
+}
+
+void runRead(size_t iters, size_t numPassThroughHandlers) {
+  BenchmarkSuspender susp;
+  auto pipeline = makePipeline(numPassThroughHandlers);
+  auto data = IOBuf::copyBuffer("0123456789abcdef");
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    q.append(data->clone());
+    pipeline->read(q);
+  }
+}
+
+void runWrite(size_t iters, size_t numPassThroughHandlers) {
+  BenchmarkSuspender susp;
+  auto pipeline = makePipeline(numPassThroughHandlers);
+  auto data = IOBuf::copyBuffer("0123456789abcdef");
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    pipeline->write(data->clone());
+  }
+}
+
+void runBufferedWrites(size_t iters, size_t writesPerFlush) {
+  BenchmarkSuspender susp;
+  WriteSink sink;
+  OutputBufferingHandler buffering;
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      WriteSink,
+      OutputBufferingHandler>::create(&sink, &buffering);
+  EventBase eb;
+  pipeline->setTransport(AsyncSocket::newSocket(&eb));
+  auto data = IOBuf::copyBuffer("0123456789abcdef");
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    for (size_t j = 0; j < writesPerFlush; j++) {
+      pipeline->write(data->clone());
+    }
+    eb.loopOnce();
+  }
+}
+
+} // namespace
+
+/*
+ * Traversal cost as a function of pipeline depth; each pass-through
+ * handler is one extra hop on both the read and the write path.
+ */
+BENCHMARK_NAMED_PARAM(runRead, 0_handlers, 0)
+BENCHMARK_NAMED_PARAM(runRead, 2_handlers, 2)
+BENCHMARK_NAMED_PARAM(runRead, 8_handlers, 8)
+BENCHMARK_NAMED_PARAM(runRead, 32_handlers, 32)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_NAMED_PARAM(runWrite, 0_handlers, 0)
+BENCHMARK_NAMED_PARAM(runWrite, 2_handlers, 2)
+BENCHMARK_NAMED_PARAM(runWrite, 8_handlers, 8)
+BENCHMARK_NAMED_PARAM(runWrite, 32_handlers, 32)
+BENCHMARK_DRAW_LINE();
+
+/*
+ * StaticPipeline resolves the handler chain at compile time; compare one
+ * read against the same chain assembled dynamically (runRead above covers
+ * the dynamic side, this pair pins both to three handlers).
+ */
+BENCHMARK(staticPipelineRead, iters) {
+  BenchmarkSuspender susp;
+  WriteSink front;
+  PassThroughHandler middle;
+  ReadSink back;
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      WriteSink,
+      PassThroughHandler,
+      ReadSink>::create(&front, &middle, &back);
+  auto data = IOBuf::copyBuffer("0123456789abcdef");
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    q.append(data->clone());
+    pipeline->read(q);
+  }
+}
+
+BENCHMARK_RELATIVE(dynamicPipelineRead, iters) {
+  runRead(iters, 1);
+}
+BENCHMARK_DRAW_LINE();
+
+/*
+ * Per-connection setup cost: building the same three-handler chain with
+ * create + addBack + finalize, versus stamping it from a
+ * PrototypePipelineFactory whose layout was fixed when the factory was
+ * declared.
+ */
+BENCHMARK(dynamicPipelineConstruct, iters) {
+  BenchmarkSuspender susp;
+  EventBase eb;
+  std::shared_ptr<AsyncTransport> sock = AsyncSocket::newSocket(&eb);
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    auto pipeline = DefaultPipeline::create();
+    pipeline->addBack(AsyncSocketHandler(sock));
+    pipeline->addBack(PassThroughHandler());
+    pipeline->addBack(ReadSink());
+    pipeline->finalize();
+  }
+}
+
+BENCHMARK_RELATIVE(prototypePipelineConstruct, iters) {
+  BenchmarkSuspender susp;
+  EventBase eb;
+  std::shared_ptr<AsyncTransport> sock = AsyncSocket::newSocket(&eb);
+  PrototypePipelineFactory<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      PassThroughHandler,
+      ReadSink>
+      factory(PassThroughHandler(), ReadSink());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    auto pipeline = factory.newPipeline(sock);
+  }
+}
+BENCHMARK_DRAW_LINE();
+
+/*
+ * OutputBufferingHandler coalesces writes until the loop runs; the
+ * interesting axis is how many writes are amortized per flush.
+ */
+BENCHMARK_NAMED_PARAM(runBufferedWrites, 1_write_per_flush, 1)
+BENCHMARK_NAMED_PARAM(runBufferedWrites, 8_writes_per_flush, 8)
+BENCHMARK_NAMED_PARAM(runBufferedWrites, 64_writes_per_flush, 64)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
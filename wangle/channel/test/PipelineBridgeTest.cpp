@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <wangle/channel/Pipeline.h>
+#include <wangle/channel/PipelineBridge.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+// Stands in for the transport handler: collects outbound bytes and
+// records close, like AsyncSocketHandler would at the pipeline front.
+class WriteSink : public BytesToBytesHandler {
+ public:
+  void read(Context*, IOBufQueue&) override {}
+
+  Future<Unit> write(Context*, std::unique_ptr<IOBuf> buf) override {
+    written.append(std::move(buf));
+    return makeFuture();
+  }
+
+  Future<Unit> close(Context*) override {
+    closed = true;
+    return makeFuture();
+  }
+
+  std::string writtenString() {
+    auto buf = written.move();
+    return buf ? buf->moveToFbString().toStdString() : std::string();
+  }
+
+  IOBufQueue written{IOBufQueue::cacheChainLength()};
+  bool closed{false};
+};
+
+// Sits above the bridge; a relayed byte must never reach it.
+class UpperHandler : public BytesToBytesHandler {
+ public:
+  void read(Context*, IOBufQueue&) override {
+    reads++;
+  }
+
+  int reads{0};
+};
+
+using BridgePipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>;
+
+struct Side {
+  std::shared_ptr<WriteSink> sink;
+  std::shared_ptr<PipelineBridge> bridge;
+  std::shared_ptr<UpperHandler> upper;
+  BridgePipeline::Ptr pipeline;
+};
+
+Side makeSide() {
+  Side side;
+  side.sink = std::make_shared<WriteSink>();
+  side.bridge = std::make_shared<PipelineBridge>();
+  side.upper = std::make_shared<UpperHandler>();
+  side.pipeline = BridgePipeline::create();
+  side.pipeline->addBack(side.sink);
+  side.pipeline->addBack(side.bridge);
+  side.pipeline->addBack(side.upper);
+  side.pipeline->finalize();
+  return side;
+}
+
+void readInto(Side& side, const std::string& data) {
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer(data));
+  side.pipeline->read(q);
+}
+
+} // namespace
+
+TEST(PipelineBridge, RelaysBetweenSides) {
+  auto a = makeSide();
+  auto b = makeSide();
+  PipelineBridge::tie(a.bridge, b.bridge);
+
+  readInto(a, "hello");
+  EXPECT_EQ("hello", b.sink->writtenString());
+  EXPECT_EQ(5, a.bridge->bytesRelayed());
+
+  readInto(b, "world!");
+  EXPECT_EQ("world!", a.sink->writtenString());
+  EXPECT_EQ(6, b.bridge->bytesRelayed());
+
+  // The short circuit keeps relayed bytes below the upper handlers.
+  EXPECT_EQ(0, a.upper->reads);
+  EXPECT_EQ(0, b.upper->reads);
+}
+
+TEST(PipelineBridge, BuffersUntilTied) {
+  auto a = makeSide();
+  auto b = makeSide();
+
+  readInto(a, "early ");
+  readInto(a, "bytes");
+  EXPECT_EQ("", b.sink->writtenString());
+
+  PipelineBridge::tie(a.bridge, b.bridge);
+  EXPECT_EQ("early bytes", b.sink->writtenString());
+  EXPECT_EQ(11, a.bridge->bytesRelayed());
+}
+
+TEST(PipelineBridge, EofTearsDownBothSides) {
+  auto a = makeSide();
+  auto b = makeSide();
+  PipelineBridge::tie(a.bridge, b.bridge);
+
+  a.pipeline->readEOF();
+  EXPECT_TRUE(a.sink->closed);
+  EXPECT_TRUE(b.sink->closed);
+}
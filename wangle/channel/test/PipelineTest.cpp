@@ -21,6 +21,8 @@
 #include <wangle/channel/Handler.h>
 #include <wangle/channel/OutputBufferingHandler.h>
 #include <wangle/channel/Pipeline.h>
+#include <wangle/channel/PrototypePipelineFactory.h>
+#include <wangle/channel/SharedHandler.h>
 #include <wangle/channel/StaticPipeline.h>
 #include <wangle/channel/test/MockHandler.h>
 
@@ -43,6 +45,10 @@ ACTION(FireReadException) {
   arg0->fireReadException(arg1);
 }
 
+ACTION(FireReadError) {
+  arg0->fireReadError(arg1);
+}
+
 ACTION(FireWrite) {
   arg0->fireWrite(arg1);
 }
@@ -104,6 +110,11 @@ TEST(PipelineTest, FireActions) {
   EXPECT_CALL(handler2, readException(_, _)).Times(1);
   pipeline->readException(make_exception_wrapper<std::runtime_error>("blah"));
 
+  EXPECT_CALL(handler1, readError(_, _)).WillOnce(FireReadError());
+  EXPECT_CALL(handler2, readError(_, TransportErrorCode::CONNECTION_RESET))
+      .Times(1);
+  pipeline->readError(TransportErrorCode::CONNECTION_RESET);
+
   EXPECT_CALL(handler2, write_(_, _)).WillOnce(FireWrite());
   EXPECT_CALL(handler1, write_(_, _)).Times(1);
   EXPECT_NO_THROW(pipeline->write(1).value());
@@ -144,6 +155,57 @@ TEST(PipelineTest, ReachEndOfPipeline) {
   EXPECT_CALL(handler, detachPipeline(_));
 }
 
+// Handlers see the pipeline's RequestContext during events, unless the
+// guard has been explicitly elided.
+TEST(PipelineTest, RequestContextGuard) {
+  auto ctx = std::make_shared<RequestContext>();
+  IntHandler handler;
+  EXPECT_CALL(handler, attachPipeline(_));
+  auto pipeline = StaticPipeline<int, int, IntHandler>::create(&handler);
+  pipeline->setRequestContext(ctx);
+
+  EXPECT_CALL(handler, read_(_, _)).WillOnce(InvokeWithoutArgs([&] {
+    EXPECT_EQ(ctx.get(), RequestContext::try_get());
+  }));
+  pipeline->read(1);
+  EXPECT_NE(ctx.get(), RequestContext::try_get());
+
+  pipeline->setElideRequestContextGuard(true);
+  EXPECT_CALL(handler, read_(_, _)).WillOnce(InvokeWithoutArgs([&] {
+    EXPECT_NE(ctx.get(), RequestContext::try_get());
+  }));
+  pipeline->read(1);
+
+  EXPECT_CALL(handler, detachPipeline(_));
+}
+
+// Instrumented pipelines aggregate per-handler event counts and timings
+TEST(PipelineTest, HandlerStats) {
+  IntHandler handler1;
+  IntHandler2 handler2;
+  EXPECT_CALL(handler1, attachPipeline(_));
+  EXPECT_CALL(handler2, attachPipeline(_));
+
+  auto pipeline = Pipeline<int, int>::create();
+  pipeline->enableHandlerStats();
+  (*pipeline).addBack(&handler1).addBack(&handler2).finalize();
+
+  EXPECT_CALL(handler1, read_(_, _)).WillOnce(FireRead());
+  EXPECT_CALL(handler2, read_(_, _)).Times(1);
+  pipeline->read(1);
+
+  auto* stats = pipeline->getPipelineStats();
+  ASSERT_NE(nullptr, stats);
+  EXPECT_EQ(2, stats->entries().size());
+  for (auto& entry : stats->entries()) {
+    EXPECT_EQ(1, entry->events);
+    EXPECT_FALSE(entry->name.empty());
+  }
+
+  EXPECT_CALL(handler1, detachPipeline(_));
+  EXPECT_CALL(handler2, detachPipeline(_));
+}
+
 // Test having the last read handler turn around and write
 TEST(PipelineTest, TurnAround) {
   IntHandler handler1;
@@ -229,6 +291,43 @@ TEST(PipelineTest, GetContext) {
   EXPECT_CALL(handler, detachPipeline(_));
 }
 
+TEST(PipelineTest, TypedHandlerLookup) {
+  auto handler1 = std::make_shared<IntHandler>();
+  auto handler2 = std::make_shared<IntHandler2>();
+  EXPECT_CALL(*handler1, attachPipeline(_)).Times(AnyNumber());
+  EXPECT_CALL(*handler1, detachPipeline(_)).Times(AnyNumber());
+  EXPECT_CALL(*handler2, attachPipeline(_)).Times(AnyNumber());
+  EXPECT_CALL(*handler2, detachPipeline(_)).Times(AnyNumber());
+
+  auto pipeline = Pipeline<int, int>::create();
+  pipeline->addBack(handler1);
+  pipeline->addBack(handler2);
+
+  // Before finalize() lookups go through the linear walk.
+  EXPECT_EQ(handler1.get(), pipeline->getHandler<IntHandler>());
+
+  pipeline->finalize();
+
+  // After finalize() the same lookups hit the type-index table.
+  EXPECT_EQ(handler1.get(), pipeline->getHandler<IntHandler>());
+  EXPECT_EQ(handler2.get(), pipeline->getHandler<IntHandler2>());
+  typedef HandlerAdapter<std::string, std::string> AbsentHandler;
+  EXPECT_EQ(nullptr, pipeline->getHandler<AbsentHandler>());
+
+  // Handlers can resolve peers through their context.
+  EXPECT_EQ(
+      handler2.get(), handler1->getContext()->getPeerHandler<IntHandler2>());
+
+  // Structural changes invalidate the table; lookups still resolve
+  // until the next finalize() rebuilds it.
+  pipeline->remove<IntHandler2>();
+  EXPECT_EQ(nullptr, pipeline->getHandler<IntHandler2>());
+  EXPECT_EQ(handler1.get(), pipeline->getHandler<IntHandler>());
+  pipeline->finalize();
+  EXPECT_EQ(handler1.get(), pipeline->getHandler<IntHandler>());
+  EXPECT_EQ(nullptr, pipeline->getHandler<IntHandler2>());
+}
+
 TEST(PipelineTest, HandlerInMultiplePipelines) {
   IntHandler handler;
   EXPECT_CALL(handler, attachPipeline(_)).Times(2);
@@ -300,6 +399,16 @@ TEST(Pipeline, DynamicConstruction) {
   }
 }
 
+TEST(Pipeline, TypeMismatchThrows) {
+  // IntToString fires std::string reads, but the next handler consumes
+  // int; linking must reject the chain at finalize time.
+  auto pipeline = Pipeline<int, int>::create();
+  (*pipeline)
+      .addBack(IntToStringHandler{})
+      .addBack(ConcreteHandler<int, int>{});
+  EXPECT_THROW(pipeline->finalize(), std::invalid_argument);
+}
+
 TEST(Pipeline, RemovePointer) {
   IntHandler handler1, handler2;
   EXPECT_CALL(handler1, attachPipeline(_));
@@ -435,3 +544,258 @@ TEST(PipelineTest, HandlerReuse) {
   pipeline3->read(1);
   EXPECT_NE(nullptr, handler2.getContext());
 }
+
+TEST(PipelineTest, SharedHandlerStatePerPipeline) {
+  struct CountState {
+    int total{0};
+  };
+  struct CountingHandler : SharedHandler<CountState, int> {
+    void read(Context* ctx, int msg) override {
+      state(ctx).total += msg;
+    }
+    folly::Future<folly::Unit> write(Context* ctx, int msg) override {
+      return ctx->fireWrite(msg);
+    }
+    int totalFor(Context* ctx) {
+      return state(ctx).total;
+    }
+  };
+
+  // One handler instance serves both pipelines; each connection's counter
+  // lives in its own context slot.
+  auto handler = std::make_shared<CountingHandler>();
+  auto pipeline1 = Pipeline<int, int>::create();
+  pipeline1->addBack(handler);
+  pipeline1->finalize();
+  auto pipeline2 = Pipeline<int, int>::create();
+  pipeline2->addBack(handler);
+  pipeline2->finalize();
+
+  pipeline1->read(1);
+  pipeline1->read(2);
+  pipeline2->read(5);
+
+  EXPECT_EQ(3, handler->totalFor(pipeline1->getContext<CountingHandler>(0)));
+  EXPECT_EQ(5, handler->totalFor(pipeline2->getContext<CountingHandler>(0)));
+}
+
+TEST(PipelineTest, ContextPoolReuse) {
+  PipelineContextPool pool;
+  NiceMock<MockHandlerAdapter<int, int>> handler1, handler2;
+
+  {
+    auto pipeline = Pipeline<int, int>::create();
+    pipeline->setContextPool(&pool);
+    (*pipeline).addBack(&handler1).addBack(&handler2).finalize();
+    pipeline->read(42);
+  }
+  auto slabs = pool.numSlabs();
+  EXPECT_GE(slabs, 1);
+
+  // A second pipeline of the same shape should be served entirely from the
+  // recycled free lists.
+  {
+    auto pipeline = Pipeline<int, int>::create();
+    pipeline->setContextPool(&pool);
+    (*pipeline).addBack(&handler1).addBack(&handler2).finalize();
+    pipeline->read(42);
+  }
+  EXPECT_EQ(pool.numSlabs(), slabs);
+}
+
+TEST(PipelineTest, RawTransportAccessor) {
+  EventBase eb;
+  auto socket = folly::to_shared_ptr(AsyncSocket::newSocket(&eb));
+  auto pipeline = Pipeline<int, int>::create();
+  EXPECT_EQ(nullptr, pipeline->getTransportRaw());
+
+  pipeline->setTransport(socket);
+  EXPECT_EQ(socket.get(), pipeline->getTransportRaw());
+  EXPECT_EQ(socket.get(), pipeline->getTransport().get());
+}
+
+TEST(PipelineTest, PrototypePipelineFactoryStampsCopies) {
+  struct TaggedHandler : BytesToBytesHandler {
+    explicit TaggedHandler(int t) : tag(t) {}
+    int tag;
+  };
+
+  EventBase eb;
+  auto socket = folly::to_shared_ptr(AsyncSocket::newSocket(&eb));
+  PrototypePipelineFactory<IOBufQueue&, std::unique_ptr<IOBuf>, TaggedHandler>
+      factory(TaggedHandler(7));
+
+  // Stamped pipelines come out finalized, with an AsyncSocketHandler for
+  // the accepted transport in front of a copy of each prototype.
+  auto pipeline1 = factory.newPipeline(socket);
+  EXPECT_EQ(2, pipeline1->numHandlers());
+  EXPECT_TRUE(pipeline1->getHandler<AsyncSocketHandler>());
+  ASSERT_TRUE(pipeline1->getHandler<TaggedHandler>());
+  EXPECT_EQ(7, pipeline1->getHandler<TaggedHandler>()->tag);
+
+  // Each stamp is an independent copy of the prototype state.
+  auto pipeline2 = factory.newPipeline(socket);
+  pipeline2->getHandler<TaggedHandler>()->tag = 9;
+  EXPECT_EQ(7, pipeline1->getHandler<TaggedHandler>()->tag);
+  EXPECT_EQ(9, pipeline2->getHandler<TaggedHandler>()->tag);
+}
+
+TEST(PipelineTest, WriteFast) {
+  struct FastSink : HandlerAdapter<int, int> {
+    folly::Future<folly::Unit> write(Context*, int msg) override {
+      slowWrites.push_back(msg);
+      return folly::makeFuture();
+    }
+    FastWriteResult writeFast(Context*, int& msg) override {
+      if (!supported) {
+        return FastWriteResult::UNSUPPORTED;
+      }
+      fastWrites.push_back(msg);
+      return FastWriteResult::DONE;
+    }
+    std::vector<int> fastWrites, slowWrites;
+    bool supported{true};
+  };
+
+  FastSink sink;
+  auto pipeline = Pipeline<int, int>::create();
+  (*pipeline).addBack(&sink).finalize();
+
+  int msg = 1;
+  EXPECT_EQ(pipeline->writeFast(msg), FastWriteResult::DONE);
+  EXPECT_EQ(sink.fastWrites, std::vector<int>({1}));
+
+  // Fallback contract: UNSUPPORTED leaves the message intact for write().
+  sink.supported = false;
+  msg = 2;
+  EXPECT_EQ(pipeline->writeFast(msg), FastWriteResult::UNSUPPORTED);
+  pipeline->write(std::move(msg)).value();
+  EXPECT_EQ(sink.slowWrites, std::vector<int>({2}));
+}
+
+// Writability events flow inbound through every handler, like
+// transportActive, and default to forwarding.
+TEST(PipelineTest, TransportWritabilityEvents) {
+  struct WritabilityHandler : HandlerAdapter<int, int> {
+    void transportWritable(Context* ctx) override {
+      writable++;
+      ctx->fireTransportWritable();
+    }
+    void transportUnwritable(Context* ctx) override {
+      unwritable++;
+      ctx->fireTransportUnwritable();
+    }
+    int writable{0}, unwritable{0};
+  };
+
+  WritabilityHandler handler1, handler2;
+  auto pipeline = Pipeline<int, int>::create();
+  (*pipeline)
+      .addBack(&handler1)
+      // A handler with no override forwards by default.
+      .addBack(HandlerAdapter<int, int>())
+      .addBack(&handler2)
+      .finalize();
+
+  pipeline->transportUnwritable();
+  EXPECT_EQ(1, handler1.unwritable);
+  EXPECT_EQ(1, handler2.unwritable);
+
+  pipeline->transportWritable();
+  EXPECT_EQ(1, handler1.writable);
+  EXPECT_EQ(1, handler2.writable);
+}
+
+// Uniquely owned pipelines dispatch like shared ones; handlers see the
+// raw pipeline but cannot take shared ownership of it.
+TEST(PipelineTest, UniquePipelineDispatch) {
+  struct Recorder : HandlerAdapter<int, int> {
+    void read(Context* ctx, int msg) override {
+      reads.push_back(msg);
+      EXPECT_NE(nullptr, ctx->getPipeline());
+      EXPECT_EQ(nullptr, ctx->getPipelineShared());
+    }
+    folly::Future<folly::Unit> write(Context*, int msg) override {
+      writes.push_back(msg);
+      return folly::makeFuture();
+    }
+    std::vector<int> reads, writes;
+  };
+
+  Recorder recorder;
+  auto pipeline = Pipeline<int, int>::createUnique();
+  (*pipeline).addBack(&recorder).finalize();
+
+  pipeline->read(1);
+  EXPECT_NO_THROW(pipeline->write(2).value());
+  EXPECT_EQ(recorder.reads, std::vector<int>({1}));
+  EXPECT_EQ(recorder.writes, std::vector<int>({2}));
+}
+
+// A handler that tears down the owning connection mid-event must not
+// free the chain under its own stack frame: the deleter defers
+// destruction until the dispatch unwinds.
+TEST(PipelineTest, UniquePipelineDeletionDefersUntilDispatchEnds) {
+  using IntPipeline = Pipeline<int, int>;
+
+  // Added by value, so its lifetime tracks the pipeline's contexts.
+  struct Canary : HandlerAdapter<int, int> {
+    explicit Canary(bool* destroyed) : destroyed_(destroyed) {}
+    Canary(Canary&& other) noexcept : destroyed_(other.destroyed_) {
+      other.destroyed_ = nullptr;
+    }
+    ~Canary() override {
+      if (destroyed_) {
+        *destroyed_ = true;
+      }
+    }
+    bool* destroyed_;
+  };
+
+  struct Dropper : HandlerAdapter<int, int> {
+    void read(Context*, int) override {
+      owner->reset();
+      // The pipeline (and this handler's context chain) must still be
+      // alive here; destruction happens after the dispatch returns.
+      *aliveAfterReset = !*destroyed;
+    }
+    IntPipeline::UniquePtr* owner{nullptr};
+    bool* destroyed{nullptr};
+    bool* aliveAfterReset{nullptr};
+  };
+
+  IntPipeline::UniquePtr owner;
+  bool destroyed = false;
+  bool aliveAfterReset = false;
+  Dropper dropper;
+  dropper.owner = &owner;
+  dropper.destroyed = &destroyed;
+  dropper.aliveAfterReset = &aliveAfterReset;
+
+  owner = IntPipeline::createUnique();
+  (*owner).addBack(Canary(&destroyed)).addBack(&dropper).finalize();
+
+  owner->read(7);
+  EXPECT_TRUE(aliveAfterReset);
+  EXPECT_TRUE(destroyed);
+  EXPECT_EQ(nullptr, owner.get());
+}
+
+// Regression check: type() evaluates typeid(ConnInfo&) inline, so this
+// translation unit only compiles if ConnInfo is complete wherever
+// AcceptPipelineType is visible.
+TEST(PipelineTest, AcceptPipelineTypeConnInfo) {
+  std::string proto = "h2";
+  SocketAddress clientAddr;
+  TransportInfo tinfo;
+  ConnInfo connInfo{nullptr, &clientAddr, proto, SecureTransportType::TLS,
+                    tinfo};
+
+  AcceptPipelineType msg(connInfo);
+  EXPECT_TRUE(msg.type() == typeid(ConnInfo&));
+  EXPECT_EQ(&msg.get<ConnInfo&>(), &connInfo);
+
+  AcceptPipelineType event(ConnEvent::CONN_ADDED);
+  EXPECT_TRUE(event.type() == typeid(ConnEvent));
+  EXPECT_EQ(event.get<ConnEvent>(), ConnEvent::CONN_ADDED);
+}
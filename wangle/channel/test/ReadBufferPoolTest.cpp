@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/channel/ReadBufferPool.h>
+
+#include <thread>
+
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+TEST(ReadBufferPoolTest, RecyclesOnSameThread) {
+  ReadBufferPool pool;
+
+  auto buf = pool.allocate(2048);
+  EXPECT_GE(buf->tailroom(), 2048);
+  EXPECT_EQ(0, buf->length());
+  auto* data = buf->writableTail();
+  buf.reset();
+
+  auto stats = pool.getPoolStats();
+  EXPECT_EQ(1, stats.allocations);
+  EXPECT_EQ(1, stats.recycled);
+  EXPECT_EQ(1, stats.pooledBuffers);
+
+  // The same storage comes back with a pop, not a malloc.
+  auto buf2 = pool.allocate(2048);
+  EXPECT_EQ(data, buf2->writableTail());
+  stats = pool.getPoolStats();
+  EXPECT_EQ(1, stats.allocations);
+  EXPECT_EQ(1, stats.poolHits);
+  EXPECT_EQ(0, stats.pooledBuffers);
+}
+
+TEST(ReadBufferPoolTest, RoundsUpToSizeClass) {
+  ReadBufferPool pool;
+
+  auto buf = pool.allocate(3000);
+  EXPECT_EQ(4096, buf->tailroom());
+  buf.reset();
+
+  // A 2KB request doesn't steal the pooled 4KB buffer.
+  auto small = pool.allocate(100);
+  EXPECT_EQ(2048, small->tailroom());
+  auto stats = pool.getPoolStats();
+  EXPECT_EQ(2, stats.allocations);
+  EXPECT_EQ(0, stats.poolHits);
+}
+
+TEST(ReadBufferPoolTest, OversizedRequestsBypassThePool) {
+  ReadBufferPool pool;
+
+  auto buf = pool.allocate(256 * 1024);
+  EXPECT_GE(buf->tailroom(), 256 * 1024);
+  buf.reset();
+
+  auto stats = pool.getPoolStats();
+  EXPECT_EQ(1, stats.unpooled);
+  EXPECT_EQ(0, stats.allocations);
+  EXPECT_EQ(0, stats.pooledBuffers);
+}
+
+TEST(ReadBufferPoolTest, CrossThreadFreeDoesNotRecycle) {
+  ReadBufferPool pool;
+
+  auto buf = pool.allocate(2048);
+  std::thread([buf = std::move(buf)]() mutable { buf.reset(); }).join();
+
+  auto stats = pool.getPoolStats();
+  EXPECT_EQ(1, stats.crossThreadFrees);
+  EXPECT_EQ(0, stats.recycled);
+  EXPECT_EQ(0, stats.pooledBuffers);
+}
+
+TEST(ReadBufferPoolTest, SplitBuffersReturnWhenAllReferencesDrop) {
+  ReadBufferPool pool;
+
+  auto buf = pool.allocate(2048);
+  buf->append(100);
+  // A downstream handler slicing the read keeps the storage alive.
+  auto front = buf->cloneOne();
+  buf.reset();
+  EXPECT_EQ(0, pool.getPoolStats().recycled);
+
+  front.reset();
+  EXPECT_EQ(1, pool.getPoolStats().recycled);
+}
+
+TEST(ReadBufferPoolTest, HugePageSlabBacking) {
+  ReadBufferPool pool(ReadBufferPool::Options{true, 0});
+
+  auto a = pool.allocate(2048);
+  auto b = pool.allocate(2048);
+  if (pool.isHugePageBacked()) {
+    // Consecutive buffers are carved out of the same 2MB slab.
+    EXPECT_EQ(1, pool.getPoolStats().hugePageSlabs);
+    auto distance = b->writableTail() - a->writableTail();
+    EXPECT_GT(distance, 0);
+    EXPECT_LT(distance, 2 * 1024 * 1024);
+  }
+
+  // Recycling works the same as on the malloc backing.
+  auto* data = a->writableTail();
+  a.reset();
+  auto c = pool.allocate(2048);
+  EXPECT_EQ(data, c->writableTail());
+  EXPECT_EQ(1, pool.getPoolStats().poolHits);
+}
+
+TEST(ReadBufferPoolTest, ReservePrefaultsWholeSlabs) {
+  ReadBufferPool pool(ReadBufferPool::Options{true, 3 * 1024 * 1024});
+  if (pool.isHugePageBacked()) {
+    EXPECT_EQ(2, pool.getPoolStats().hugePageSlabs);
+  }
+}
+
+TEST(ReadBufferPoolTest, SlabBufferCrossThreadReturnIsDrained) {
+  ReadBufferPool pool(ReadBufferPool::Options{true, 0});
+
+  auto buf = pool.allocate(2048);
+  if (!pool.isHugePageBacked()) {
+    return; // no hugepage-aligned memory available here
+  }
+  auto* data = buf->writableTail();
+  std::thread([buf = std::move(buf)]() mutable { buf.reset(); }).join();
+
+  auto stats = pool.getPoolStats();
+  EXPECT_EQ(1, stats.crossThreadFrees);
+  EXPECT_EQ(0, stats.recycled);
+
+  // The parked return is drained into the free list and reused
+  // instead of carving fresh slab space.
+  auto buf2 = pool.allocate(2048);
+  EXPECT_EQ(data, buf2->writableTail());
+  stats = pool.getPoolStats();
+  EXPECT_EQ(1, stats.recycled);
+  EXPECT_EQ(1, stats.poolHits);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <wangle/channel/Handler.h>
+#include <wangle/channel/TypedPipeline.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+class IntDoubler : public HandlerAdapter<int, int> {
+ public:
+  void read(Context* ctx, int msg) override {
+    reads++;
+    ctx->fireRead(msg * 2);
+  }
+
+  Future<Unit> write(Context* ctx, int msg) override {
+    writes++;
+    return ctx->fireWrite(msg * 2);
+  }
+
+  int reads{0};
+  int writes{0};
+};
+
+class IntSink : public HandlerAdapter<int, int> {
+ public:
+  void read(Context* /*ctx*/, int msg) override {
+    lastRead = msg;
+  }
+
+  Future<Unit> write(Context* /*ctx*/, int msg) override {
+    lastWrite = msg;
+    return makeFuture();
+  }
+
+  int lastRead{-1};
+  int lastWrite{-1};
+};
+
+} // namespace
+
+TEST(TypedPipelineTest, ReadAndWriteTraverseChain) {
+  auto pipeline =
+      TypedPipeline<int, int, IntDoubler, IntDoubler, IntSink>::create(
+          IntDoubler(), IntDoubler(), IntSink());
+
+  pipeline->read(1);
+  EXPECT_EQ(pipeline->getHandlerAt<0>().reads, 1);
+  EXPECT_EQ(pipeline->getHandlerAt<1>().reads, 1);
+  EXPECT_EQ(pipeline->getHandlerAt<2>().lastRead, 4);
+
+  // Outbound enters at the back and runs toward the front; the sink at the
+  // back is also the outbound entry point here.
+  pipeline->write(3).value();
+  EXPECT_EQ(pipeline->getHandlerAt<2>().lastWrite, 3);
+}
+
+TEST(TypedPipelineTest, InboundOnlyHandlers) {
+  struct Plus : InboundHandler<int, int> {
+    void read(Context* ctx, int msg) override {
+      ctx->fireRead(msg + 1);
+    }
+  };
+
+  auto pipeline =
+      TypedPipeline<int, int, Plus, Plus, IntSink>::create(
+          Plus(), Plus(), IntSink());
+
+  pipeline->read(0);
+  EXPECT_EQ(pipeline->getHandlerAt<2>().lastRead, 2);
+}
+
+TEST(TypedPipelineTest, GetContextStillWorks) {
+  auto pipeline = TypedPipeline<int, int, IntSink>::create(IntSink());
+  EXPECT_EQ(pipeline->numHandlers(), 1);
+  auto& sink = pipeline->getHandlerAt<0>();
+  EXPECT_NE(sink.getContext(), nullptr);
+}
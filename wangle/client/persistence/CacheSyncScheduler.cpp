@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/client/persistence/CacheSyncScheduler.h>
+
+#include <algorithm>
+
+#include <folly/Random.h>
+#include <folly/portability/SysResource.h>
+#include <folly/system/ThreadName.h>
+
+namespace wangle {
+
+/**
+ * Thin per-cache facade: forwards work to the scheduler tagged with the
+ * cache's name, and keeps the scheduler alive.
+ */
+class CacheSyncScheduler::NamedExecutor : public folly::Executor {
+ public:
+  NamedExecutor(std::shared_ptr<CacheSyncScheduler> scheduler, std::string name)
+      : scheduler_(std::move(scheduler)), name_(std::move(name)) {}
+
+  void add(folly::Func fn) override {
+    scheduler_->addNamed(name_, std::move(fn));
+  }
+
+ private:
+  std::shared_ptr<CacheSyncScheduler> scheduler_;
+  std::string name_;
+};
+
+std::shared_ptr<CacheSyncScheduler> CacheSyncScheduler::create(
+    Options options) {
+  return std::shared_ptr<CacheSyncScheduler>(
+      new CacheSyncScheduler(std::move(options)));
+}
+
+CacheSyncScheduler::CacheSyncScheduler(Options options)
+    : options_(std::move(options)),
+      tokens_(options_.maxBurstSyncs),
+      lastRefill_(std::chrono::steady_clock::now()) {
+  worker_ = std::thread([this] { schedulerThread(); });
+}
+
+CacheSyncScheduler::~CacheSyncScheduler() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+std::shared_ptr<folly::Executor> CacheSyncScheduler::getCacheExecutor(
+    std::string cacheName) {
+  return std::make_shared<NamedExecutor>(
+      shared_from_this(), std::move(cacheName));
+}
+
+void CacheSyncScheduler::add(folly::Func fn) {
+  addNamed(std::string(), std::move(fn));
+}
+
+folly::Optional<CacheSyncScheduler::CacheSyncStats>
+CacheSyncScheduler::getCacheStats(const std::string& cacheName) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = stats_.find(cacheName);
+  if (it == stats_.end()) {
+    return folly::none;
+  }
+  return it->second;
+}
+
+void CacheSyncScheduler::addNamed(std::string cacheName, folly::Func fn) {
+  Task task;
+  task.enqueuedAt = std::chrono::steady_clock::now();
+  task.readyAt = task.enqueuedAt;
+  if (options_.maxSyncDelayJitter.count() > 0) {
+    task.readyAt += std::chrono::milliseconds(folly::Random::rand64(
+        static_cast<uint64_t>(options_.maxSyncDelayJitter.count()) + 1));
+  }
+  task.name = std::move(cacheName);
+  task.fn = std::move(fn);
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& stats = stats_[task.name];
+    stats.scheduled++;
+    stats.backlog++;
+    queue_.push_back(std::move(task));
+    std::push_heap(queue_.begin(), queue_.end(), TaskLater());
+  }
+  cv_.notify_one();
+}
+
+void CacheSyncScheduler::refillTokens(
+    std::chrono::steady_clock::time_point now) {
+  auto elapsed = std::chrono::duration<double>(now - lastRefill_).count();
+  tokens_ = std::min(
+      options_.maxBurstSyncs, tokens_ + elapsed * options_.syncsPerSecond);
+  lastRefill_ = now;
+}
+
+void CacheSyncScheduler::schedulerThread() {
+  folly::setThreadName("cache-sync-sched");
+  // Best effort: persistence syncs should lose the CPU to serving work.
+  setpriority(PRIO_PROCESS, 0, 19);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (queue_.empty()) {
+      if (stop_) {
+        break;
+      }
+      cv_.wait(lock);
+      continue;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!stop_) {
+      // Honor the jittered deadline, then the shared I/O budget. Both
+      // are waived once shutdown starts draining the queue.
+      if (now < queue_.front().readyAt) {
+        cv_.wait_until(lock, queue_.front().readyAt);
+        continue;
+      }
+      if (options_.syncsPerSecond > 0) {
+        refillTokens(now);
+        if (tokens_ < 1.0) {
+          cv_.wait_for(
+              lock,
+              std::chrono::duration<double>(
+                  (1.0 - tokens_) / options_.syncsPerSecond));
+          continue;
+        }
+        tokens_ -= 1.0;
+      }
+    }
+
+    std::pop_heap(queue_.begin(), queue_.end(), TaskLater());
+    Task task = std::move(queue_.back());
+    queue_.pop_back();
+    stats_[task.name].lastQueueDelay =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            now - task.enqueuedAt);
+
+    lock.unlock();
+    auto start = std::chrono::steady_clock::now();
+    task.fn();
+    task.fn = nullptr;
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    lock.lock();
+
+    auto& stats = stats_[task.name];
+    stats.completed++;
+    stats.backlog--;
+    stats.lastSyncDuration = duration;
+    stats.maxSyncDuration = std::max(stats.maxSyncDuration, duration);
+  }
+}
+
+} // namespace wangle
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/Optional.h>
+
+namespace wangle {
+
+/**
+ * A process-wide scheduler for LRUPersistentCache sync work. A binary
+ * running many caches hands each of them an executor obtained from one
+ * scheduler (PersistentCacheConfig::Builder::setExecutor), replacing a
+ * per-cache syncer thread with a single shared low-priority worker.
+ *
+ * Sync tasks are delayed by a uniformly jittered amount so caches that
+ * update together do not persist in lockstep, and a token bucket bounds
+ * how many syncs may start per second across all caches, keeping
+ * simultaneous persists from saturating the disk the serving path also
+ * uses. Per-cache scheduling and latency stats are kept under the name
+ * given to getCacheExecutor().
+ */
+class CacheSyncScheduler
+    : public folly::Executor,
+      public std::enable_shared_from_this<CacheSyncScheduler> {
+ public:
+  struct Options {
+    // Upper bound of the uniform delay jitter applied to each sync.
+    std::chrono::milliseconds maxSyncDelayJitter{500};
+    // Sustained syncs-per-second budget shared by all caches; 0 leaves
+    // sync starts unthrottled.
+    double syncsPerSecond{0};
+    // Bucket capacity: how many syncs may start back to back after an
+    // idle stretch.
+    double maxBurstSyncs{1};
+  };
+
+  struct CacheSyncStats {
+    // Tasks handed to the scheduler / run to completion.
+    uint64_t scheduled{0};
+    uint64_t completed{0};
+    // Tasks currently queued or running.
+    uint64_t backlog{0};
+    // Queue delay of the most recently started sync; includes jitter
+    // and any wait for a token.
+    std::chrono::milliseconds lastQueueDelay{0};
+    // Duration of the most recent and the slowest completed sync.
+    std::chrono::milliseconds lastSyncDuration{0};
+    std::chrono::milliseconds maxSyncDuration{0};
+  };
+
+  static std::shared_ptr<CacheSyncScheduler> create(Options options = {});
+
+  /**
+   * Stops the worker after draining already queued syncs, ignoring
+   * their deadlines and the token budget.
+   */
+  ~CacheSyncScheduler() override;
+
+  /**
+   * Returns an executor that tags work with the given cache name for
+   * stats. The returned executor keeps the scheduler alive.
+   */
+  std::shared_ptr<folly::Executor> getCacheExecutor(std::string cacheName);
+
+  /**
+   * folly::Executor implementation; work added directly is accounted
+   * under an empty cache name.
+   */
+  void add(folly::Func fn) override;
+
+  folly::Optional<CacheSyncStats> getCacheStats(
+      const std::string& cacheName) const;
+
+ private:
+  class NamedExecutor;
+  friend class NamedExecutor;
+
+  explicit CacheSyncScheduler(Options options);
+  CacheSyncScheduler(const CacheSyncScheduler&) = delete;
+  CacheSyncScheduler& operator=(const CacheSyncScheduler&) = delete;
+
+  struct Task {
+    std::chrono::steady_clock::time_point readyAt;
+    std::chrono::steady_clock::time_point enqueuedAt;
+    std::string name;
+    folly::Func fn;
+  };
+  struct TaskLater {
+    bool operator()(const Task& a, const Task& b) const {
+      return a.readyAt > b.readyAt;
+    }
+  };
+
+  void addNamed(std::string cacheName, folly::Func fn);
+  void schedulerThread();
+  // Must be called under mutex_.
+  void refillTokens(std::chrono::steady_clock::time_point now);
+
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  // Min-heap on readyAt.
+  std::vector<Task> queue_;
+  std::map<std::string, CacheSyncStats> stats_;
+  double tokens_;
+  std::chrono::steady_clock::time_point lastRefill_;
+
+  std::thread worker_;
+};
+
+} // namespace wangle
@@ -19,17 +19,79 @@
 #include <exception>
 
 #include <folly/FileUtil.h>
+#include <folly/hash/Checksum.h>
 #include <folly/json.h>
+#include <folly/lang/Bits.h>
 #include <folly/portability/Unistd.h>
 
 namespace wangle {
 
+namespace {
+
+// Prefix of compressed cache files. JSON output never starts with a
+// NUL byte, so load() can distinguish the two formats; the trailing
+// digit versions the compressed framing.
+const folly::StringPiece kCompressedHeader{"\0wglz1", 6};
+
+// Prefix of record-framed cache files, followed by one flag byte
+// saying whether record payloads are zstd-compressed.
+const folly::StringPiece kRecordHeader{"\0wglr1", 6};
+
+// Serialized bytes batched into one record on compressed layers; one
+// pair per record would leave zstd too little redundancy to work with.
+constexpr size_t kCompressedChunkBytes = 64 * 1024;
+
+void appendLE(std::string& out, uint32_t value) {
+  uint32_t le = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+bool readLE(const char*& p, const char* end, uint32_t& value) {
+  if (end - p < static_cast<ptrdiff_t>(sizeof(value))) {
+    return false;
+  }
+  value = folly::Endian::little(
+      folly::loadUnaligned<uint32_t>(reinterpret_cast<const uint8_t*>(p)));
+  p += sizeof(value);
+  return true;
+}
+
+} // namespace
+
 bool FilePersistenceLayer::persist(const folly::dynamic& dynObj) noexcept {
   std::string serializedCache;
   try {
     folly::json::serialization_opts opts;
     opts.allow_non_string_keys = true;
-    serializedCache = folly::json::serialize(dynObj, opts);
+    serializedCache.append(kRecordHeader.data(), kRecordHeader.size());
+    serializedCache.push_back(codec_ ? '\x01' : '\x00');
+    const size_t chunkCap = codec_ ? kCompressedChunkBytes : 0;
+    std::string chunk;
+    auto flushChunk = [&] {
+      if (chunk.empty()) {
+        return;
+      }
+      chunk.push_back(']');
+      std::string payload =
+          codec_ ? codec_->compress(chunk) : std::move(chunk);
+      appendLE(serializedCache, static_cast<uint32_t>(payload.size()));
+      appendLE(
+          serializedCache,
+          folly::crc32c(
+              reinterpret_cast<const uint8_t*>(payload.data()),
+              payload.size()));
+      serializedCache.append(payload);
+      chunk.clear();
+    };
+    // Each record's payload is a JSON array of key-value pairs.
+    for (const auto& kv : dynObj) {
+      chunk.push_back(chunk.empty() ? '[' : ',');
+      chunk += folly::json::serialize(kv, opts);
+      if (chunk.size() >= chunkCap) {
+        flushChunk();
+      }
+    }
+    flushChunk();
   } catch (...) {
     LOG(ERROR) << "Serializing to JSON failed with error: "
                << folly::exceptionStr(std::current_exception());
@@ -72,6 +134,20 @@ folly::Optional<folly::dynamic> FilePersistenceLayer::load() noexcept {
       return folly::none;
     }
 
+    if (folly::StringPiece(serializedCache).startsWith(kRecordHeader)) {
+      return loadRecords(
+          folly::StringPiece(serializedCache).subpiece(kRecordHeader.size()));
+    }
+
+    if (folly::StringPiece(serializedCache).startsWith(kCompressedHeader)) {
+      // decode with a fresh codec rather than codec_ so compressed
+      // files load even if this layer was constructed uncompressed
+      auto codec = folly::io::getCodec(folly::io::CodecType::ZSTD);
+      serializedCache = codec->uncompress(
+          folly::StringPiece(serializedCache)
+              .subpiece(kCompressedHeader.size()));
+    }
+
     folly::json::serialization_opts opts;
     opts.allow_non_string_keys = true;
     return folly::parseJson(serializedCache, opts);
@@ -82,6 +158,65 @@ folly::Optional<folly::dynamic> FilePersistenceLayer::load() noexcept {
   }
 }
 
+folly::Optional<folly::dynamic> FilePersistenceLayer::loadRecords(
+    folly::StringPiece data) noexcept {
+  folly::dynamic result = folly::dynamic::array;
+  if (data.empty()) {
+    return result;
+  }
+  const char* p = data.begin();
+  const char* end = data.end();
+  try {
+    std::unique_ptr<folly::io::Codec> codec;
+    if (data.front() == '\x01') {
+      codec = folly::io::getCodec(folly::io::CodecType::ZSTD);
+    }
+    p++;
+
+    folly::json::serialization_opts opts;
+    opts.allow_non_string_keys = true;
+    while (p < end) {
+      const char* recordStart = p;
+      uint32_t len = 0;
+      uint32_t crc = 0;
+      if (!readLE(p, end, len) || !readLE(p, end, crc) ||
+          end - p < static_cast<ptrdiff_t>(len)) {
+        p = recordStart;
+        break;
+      }
+      if (folly::crc32c(reinterpret_cast<const uint8_t*>(p), len) != crc) {
+        p = recordStart;
+        break;
+      }
+      std::string payload(p, len);
+      if (codec) {
+        payload = codec->uncompress(payload);
+      }
+      auto pairs = folly::parseJson(payload, opts);
+      for (auto& kv : pairs) {
+        result.push_back(std::move(kv));
+      }
+      p += len;
+    }
+    if (p != end) {
+      ++loadCorruptionEvents_;
+      loadBytesDropped_ += end - p;
+      LOG(WARNING) << "Corrupt record in " << file_ << ": salvaged "
+                   << result.size() << " entries, dropped " << (end - p)
+                   << " trailing bytes";
+    }
+    return result;
+  } catch (...) {
+    // A record that passed its checksum but fails to decompress or
+    // parse means we wrote garbage; keep what loaded before it.
+    ++loadCorruptionEvents_;
+    loadBytesDropped_ += end - p;
+    LOG(ERROR) << "Deserialization of cache file " << file_
+               << " failed: " << folly::exceptionStr(std::current_exception());
+    return result;
+  }
+}
+
 void FilePersistenceLayer::clear() {
   // This may fail but it's ok
   ::unlink(file_.c_str());
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <folly/FileUtil.h>
+#include <folly/compression/Compression.h>
 #include <folly/json.h>
 #include <folly/portability/Unistd.h>
 #include <wangle/client/persistence/LRUPersistentCache.h>
@@ -26,16 +27,60 @@ namespace wangle {
 class FilePersistenceLayer : public CachePersistence {
  public:
   explicit FilePersistenceLayer(const std::string& file) : file_(file) {}
+
+  /**
+   * Create a layer that compresses the serialized cache with zstd at
+   * the given level before writing it out. Serialized caches tend to
+   * be highly repetitive (similar keys, hostnames, certs) and shrink
+   * several-fold, cutting both the write/fsync cost and the disk
+   * footprint. Compressed files carry a header so load() can tell them
+   * apart from plain JSON; files written uncompressed by older code
+   * still load, and compressed files load even on a layer constructed
+   * without compression.
+   */
+  FilePersistenceLayer(const std::string& file, int compressionLevel)
+      : file_(file),
+        codec_(folly::io::getCodec(
+            folly::io::CodecType::ZSTD,
+            compressionLevel)) {}
+
   ~FilePersistenceLayer() override {}
 
+  /**
+   * Writes the cache as a record-framed file: a header, then
+   * length-prefixed, crc32c-checksummed records. A crash mid-write
+   * leaves a valid prefix of records, which load() salvages instead of
+   * abandoning the whole cache. Plain layers frame one key-value pair
+   * per record for fine-grained salvage; compressed layers batch pairs
+   * per record so zstd still sees cross-pair redundancy. Plain-JSON
+   * and whole-file-compressed files written by older code still load.
+   */
   bool persist(const folly::dynamic& arrayOfKvPairs) noexcept override;
 
   folly::Optional<folly::dynamic> load() noexcept override;
 
   void clear() override;
 
+  /**
+   * Corruption observed by load(): the number of loads that hit a
+   * corrupt or truncated record, and the total bytes dropped after the
+   * last valid record.
+   */
+  size_t getLoadCorruptionEvents() const {
+    return loadCorruptionEvents_;
+  }
+  size_t getLoadBytesDropped() const {
+    return loadBytesDropped_;
+  }
+
  private:
+  folly::Optional<folly::dynamic> loadRecords(folly::StringPiece data) noexcept;
+
   std::string file_;
+  // non-null iff writes are compressed
+  std::unique_ptr<folly::io::Codec> codec_;
+  size_t loadCorruptionEvents_{0};
+  size_t loadBytesDropped_{0};
 };
 
 } // namespace wangle
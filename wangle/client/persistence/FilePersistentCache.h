@@ -48,6 +48,20 @@ class FilePersistentCache : public PersistentCache<K, V> {
     cache_->init();
   }
 
+  /**
+   * As above, but the backing file is zstd-compressed at the given
+   * level. Existing uncompressed files still load.
+   */
+  FilePersistentCache(
+      const std::string& file,
+      PersistentCacheConfig config,
+      int compressionLevel)
+      : cache_(std::make_shared<LRUPersistentCache<K, V, M>>(
+            std::move(config),
+            std::make_unique<FilePersistenceLayer>(file, compressionLevel))) {
+    cache_->init();
+  }
+
   ~FilePersistentCache() override {}
 
   /**
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/client/persistence/JournalPersistenceLayer.h>
+
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#include <folly/hash/Checksum.h>
+#include <folly/lang/Bits.h>
+#include <folly/portability/Unistd.h>
+
+namespace {
+
+// Don't bother compacting a journal smaller than this, whatever its ratio
+// of dead records.
+constexpr size_t kMinCompactBytes = 64 * 1024;
+
+// Magic prefix of checksummed journals. Pre-checksum journals start
+// directly with an op byte (1 or 2), never NUL, so the formats are
+// distinguishable.
+const folly::StringPiece kJournalHeader{"\0wglj1", 6};
+
+folly::json::serialization_opts jsonOpts() {
+  folly::json::serialization_opts opts;
+  opts.allow_non_string_keys = true;
+  return opts;
+}
+
+void appendLE(std::string& out, uint32_t value) {
+  uint32_t le = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+bool readLE(const char*& p, const char* end, uint32_t& value) {
+  if (end - p < static_cast<ptrdiff_t>(sizeof(value))) {
+    return false;
+  }
+  value = folly::Endian::little(
+      folly::loadUnaligned<uint32_t>(reinterpret_cast<const uint8_t*>(p)));
+  p += sizeof(value);
+  return true;
+}
+
+} // namespace
+
+namespace wangle {
+
+JournalPersistenceLayer::~JournalPersistenceLayer() {
+  if (fd_ != -1) {
+    folly::closeNoInt(fd_);
+  }
+}
+
+void JournalPersistenceLayer::encodeRecord(
+    std::string& out,
+    RecordOp op,
+    const std::string& key,
+    const std::string& value) {
+  const size_t start = out.size();
+  out.push_back(static_cast<char>(op));
+  appendLE(out, static_cast<uint32_t>(key.size()));
+  out.append(key);
+  appendLE(out, static_cast<uint32_t>(value.size()));
+  out.append(value);
+  appendLE(
+      out,
+      folly::crc32c(
+          reinterpret_cast<const uint8_t*>(out.data() + start),
+          out.size() - start));
+}
+
+bool JournalPersistenceLayer::persist(
+    const folly::dynamic& arrayOfKvPairs) noexcept {
+  std::unordered_map<std::string, std::string> newSnapshot;
+  std::string delta;
+  try {
+    const auto opts = jsonOpts();
+    for (const auto& kv : arrayOfKvPairs) {
+      newSnapshot.emplace(
+          folly::json::serialize(kv[0], opts),
+          folly::json::serialize(kv[1], opts));
+    }
+  } catch (...) {
+    LOG(ERROR) << "Serializing to JSON failed with error: "
+               << folly::exceptionStr(std::current_exception());
+    return false;
+  }
+
+  // Without a baseline (fresh layer that never loaded) the delta is
+  // undefined, so establish one by writing the full live set. A journal
+  // in the pre-checksum format likewise gets rewritten whole, which
+  // upgrades it in place.
+  if (!snapshotValid_ || legacyFormat_) {
+    if (!compact(newSnapshot)) {
+      return false;
+    }
+    lastSnapshot_ = std::move(newSnapshot);
+    snapshotValid_ = true;
+    legacyFormat_ = false;
+    return true;
+  }
+
+  size_t liveBytes = liveBytes_;
+  for (const auto& kv : newSnapshot) {
+    auto it = lastSnapshot_.find(kv.first);
+    if (it != lastSnapshot_.end() && it->second == kv.second) {
+      continue;
+    }
+    const size_t before = delta.size();
+    encodeRecord(delta, RecordOp::PUT, kv.first, kv.second);
+    const size_t recordSize = delta.size() - before;
+    if (it != lastSnapshot_.end()) {
+      liveBytes -= 1 + 3 * sizeof(uint32_t) + kv.first.size() +
+          it->second.size();
+    }
+    liveBytes += recordSize;
+  }
+  for (const auto& kv : lastSnapshot_) {
+    if (newSnapshot.count(kv.first)) {
+      continue;
+    }
+    encodeRecord(delta, RecordOp::REMOVE, kv.first, std::string());
+    liveBytes -=
+        1 + 3 * sizeof(uint32_t) + kv.first.size() + kv.second.size();
+  }
+
+  if (delta.empty()) {
+    // Nothing changed since the last persist.
+    lastSnapshot_ = std::move(newSnapshot);
+    return true;
+  }
+
+  if (!appendRecords(delta)) {
+    return false;
+  }
+  journalBytes_ += delta.size();
+  liveBytes_ = liveBytes;
+  lastSnapshot_ = std::move(newSnapshot);
+
+  if (journalBytes_ > kMinCompactBytes && journalBytes_ > 2 * liveBytes_) {
+    // Best effort; a failed compaction leaves a valid (just oversized)
+    // journal behind.
+    compact(lastSnapshot_);
+  }
+  return true;
+}
+
+bool JournalPersistenceLayer::appendRecords(const std::string& records) {
+  if (fd_ == -1) {
+    fd_ = folly::openNoInt(
+        file_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+    if (fd_ == -1) {
+      LOG(ERROR) << "Failed to open " << file_ << ": errno " << errno;
+      return false;
+    }
+  }
+  const auto nWritten = folly::writeFull(fd_, records.data(), records.size());
+  if (nWritten < 0 || static_cast<size_t>(nWritten) != records.size()) {
+    LOG(ERROR) << "Failed to append to " << file_ << ": errno " << errno;
+    return false;
+  }
+  if (folly::fdatasyncNoInt(fd_) != 0) {
+    LOG(ERROR) << "Failed to sync " << file_ << ": errno " << errno;
+    return false;
+  }
+  return true;
+}
+
+bool JournalPersistenceLayer::compact(
+    const std::unordered_map<std::string, std::string>& snapshot) {
+  std::string compacted;
+  compacted.append(kJournalHeader.data(), kJournalHeader.size());
+  for (const auto& kv : snapshot) {
+    encodeRecord(compacted, RecordOp::PUT, kv.first, kv.second);
+  }
+
+  const auto tmpFile = file_ + ".tmp";
+  const auto fd =
+      folly::openNoInt(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd == -1) {
+    LOG(ERROR) << "Failed to open " << tmpFile << ": errno " << errno;
+    return false;
+  }
+  bool ok = true;
+  const auto nWritten =
+      folly::writeFull(fd, compacted.data(), compacted.size());
+  ok = nWritten >= 0 && static_cast<size_t>(nWritten) == compacted.size();
+  ok = folly::fdatasyncNoInt(fd) == 0 && ok;
+  ok = folly::closeNoInt(fd) == 0 && ok;
+  if (!ok) {
+    LOG(ERROR) << "Failed to write compacted journal " << tmpFile;
+    ::unlink(tmpFile.c_str());
+    return false;
+  }
+  if (::rename(tmpFile.c_str(), file_.c_str()) != 0) {
+    LOG(ERROR) << "Failed to rename " << tmpFile << ": errno " << errno;
+    ::unlink(tmpFile.c_str());
+    return false;
+  }
+  // The old fd points at the unlinked file; reopen for future appends.
+  if (fd_ != -1) {
+    folly::closeNoInt(fd_);
+    fd_ = -1;
+  }
+  liveBytes_ = compacted.size() - kJournalHeader.size();
+  journalBytes_ = compacted.size();
+  return true;
+}
+
+folly::Optional<folly::dynamic> JournalPersistenceLayer::load() noexcept {
+  std::string journal;
+  // Not being able to read the backing storage means we just start with an
+  // empty cache.
+  if (!folly::readFile(file_.c_str(), journal)) {
+    return folly::none;
+  }
+
+  // Replay in order. Keys keep the position of their first PUT so the
+  // resulting array roughly preserves insertion order for the LRU.
+  std::vector<std::string> order;
+  std::unordered_map<std::string, std::string> snapshot;
+  const char* p = journal.data();
+  const char* end = p + journal.size();
+  const bool checksummed =
+      folly::StringPiece(journal).startsWith(kJournalHeader);
+  if (checksummed) {
+    p += kJournalHeader.size();
+  } else if (!journal.empty()) {
+    legacyFormat_ = true;
+  }
+  while (p < end) {
+    const char* recordStart = p;
+    const uint8_t op = static_cast<uint8_t>(*p++);
+    uint32_t keyLen = 0;
+    uint32_t valueLen = 0;
+    if (!readLE(p, end, keyLen) || end - p < static_cast<ptrdiff_t>(keyLen)) {
+      p = recordStart;
+      break;
+    }
+    std::string key(p, keyLen);
+    p += keyLen;
+    if (!readLE(p, end, valueLen) ||
+        end - p < static_cast<ptrdiff_t>(valueLen) +
+            (checksummed ? static_cast<ptrdiff_t>(sizeof(uint32_t)) : 0)) {
+      p = recordStart;
+      break;
+    }
+    if (checksummed) {
+      const char* crcPos = p + valueLen;
+      uint32_t storedCrc = 0;
+      readLE(crcPos, end, storedCrc);
+      const auto recordLen = (p - recordStart) + valueLen;
+      if (folly::crc32c(
+              reinterpret_cast<const uint8_t*>(recordStart), recordLen) !=
+          storedCrc) {
+        p = recordStart;
+        break;
+      }
+    }
+    if (op == RecordOp::PUT) {
+      auto result = snapshot.emplace(key, std::string(p, valueLen));
+      if (result.second) {
+        order.push_back(std::move(key));
+      } else {
+        result.first->second.assign(p, valueLen);
+      }
+    } else if (op == RecordOp::REMOVE) {
+      snapshot.erase(key);
+    } else {
+      LOG(ERROR) << "Unknown journal record op " << int(op) << " in " << file_
+                 << ", dropping remainder";
+      p = recordStart;
+      break;
+    }
+    p += valueLen + (checksummed ? sizeof(uint32_t) : 0);
+  }
+  if (p != end) {
+    ++loadCorruptionEvents_;
+    loadBytesDropped_ += end - p;
+    LOG(WARNING) << "Dropping corrupt or truncated record in " << file_
+                 << " and the " << (end - p) << " bytes from it onward";
+  }
+
+  try {
+    const auto opts = jsonOpts();
+    folly::dynamic result = folly::dynamic::array;
+    std::string liveRecords;
+    for (const auto& key : order) {
+      auto it = snapshot.find(key);
+      if (it == snapshot.end()) {
+        continue;
+      }
+      result.push_back(folly::dynamic::array(
+          folly::parseJson(it->first, opts),
+          folly::parseJson(it->second, opts)));
+      encodeRecord(liveRecords, RecordOp::PUT, it->first, it->second);
+    }
+    lastSnapshot_ = std::move(snapshot);
+    snapshotValid_ = true;
+    liveBytes_ = liveRecords.size();
+    journalBytes_ = journal.size();
+    return result;
+  } catch (...) {
+    LOG(ERROR) << "Deserialization of journal " << file_ << " failed: "
+               << folly::exceptionStr(std::current_exception());
+    return folly::none;
+  }
+}
+
+void JournalPersistenceLayer::clear() {
+  if (fd_ != -1) {
+    folly::closeNoInt(fd_);
+    fd_ = -1;
+  }
+  // This may fail but it's ok
+  ::unlink(file_.c_str());
+  lastSnapshot_.clear();
+  snapshotValid_ = false;
+  legacyFormat_ = false;
+  liveBytes_ = 0;
+  journalBytes_ = 0;
+}
+
+} // namespace wangle
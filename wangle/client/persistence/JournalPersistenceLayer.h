@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <folly/FileUtil.h>
+#include <folly/json.h>
+#include <wangle/client/persistence/LRUPersistentCache.h>
+
+namespace wangle {
+
+/**
+ * A CachePersistence that journals changes instead of rewriting the whole
+ * store on every sync.
+ *
+ * persist() receives the full key-value snapshot (that is the interface),
+ * but only the delta against the previously persisted snapshot is appended
+ * to the journal as binary PUT/REMOVE records, so steady-state disk traffic
+ * is proportional to the write rate rather than the cache size. When the
+ * journal accumulates more dead records than live ones it is compacted by
+ * rewriting just the live set to a temp file and renaming it into place.
+ *
+ * The file starts with a magic header, then records, integers
+ * little-endian:
+ *   uint8_t  op (1 = PUT, 2 = REMOVE)
+ *   uint32_t key length, followed by the JSON-serialized key
+ *   uint32_t value length, followed by the JSON-serialized value
+ *            (zero and empty for REMOVE)
+ *   uint32_t crc32c of the record bytes above
+ *
+ * load() replays the journal in order; a truncated or checksum-failing
+ * record (e.g. from a crash mid-append or bit rot) is dropped along with
+ * everything after it, and everything before it is kept. Journals written
+ * before the header and checksums existed still load and are rewritten in
+ * the current format on the next persist.
+ */
+class JournalPersistenceLayer : public CachePersistence {
+ public:
+  explicit JournalPersistenceLayer(const std::string& file) : file_(file) {}
+  ~JournalPersistenceLayer() override;
+
+  bool persist(const folly::dynamic& arrayOfKvPairs) noexcept override;
+
+  folly::Optional<folly::dynamic> load() noexcept override;
+
+  void clear() override;
+
+  /**
+   * Corruption observed by load(): the number of loads that hit a
+   * corrupt or truncated record, and the total bytes dropped from the
+   * first bad record onward.
+   */
+  size_t getLoadCorruptionEvents() const {
+    return loadCorruptionEvents_;
+  }
+  size_t getLoadBytesDropped() const {
+    return loadBytesDropped_;
+  }
+
+ private:
+  enum RecordOp : uint8_t { PUT = 1, REMOVE = 2 };
+
+  bool appendRecords(const std::string& records);
+  bool compact(const std::unordered_map<std::string, std::string>& snapshot);
+  static void encodeRecord(
+      std::string& out,
+      RecordOp op,
+      const std::string& key,
+      const std::string& value);
+
+  std::string file_;
+  int fd_{-1};
+
+  // JSON key -> JSON value as of the last successful persist; the baseline
+  // delta computation runs against. Rebuilt by load().
+  std::unordered_map<std::string, std::string> lastSnapshot_;
+  bool snapshotValid_{false};
+
+  // The file on disk predates the header/checksum format; appending
+  // mixed-format records would corrupt it, so the next persist compacts
+  // (and thereby upgrades) it first.
+  bool legacyFormat_{false};
+
+  size_t loadCorruptionEvents_{0};
+  size_t loadBytesDropped_{0};
+
+  // Bytes of live records vs. total journal bytes, to decide when the dead
+  // weight justifies a compaction.
+  size_t liveBytes_{0};
+  size_t journalBytes_{0};
+};
+
+} // namespace wangle
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <glog/logging.h>
 
 #include <folly/DynamicConverter.h>
@@ -29,7 +31,15 @@ folly::Optional<V> LRUInMemoryCache<K, V, M>::get(const K& key) {
   typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
   auto itr = cache_.find(key);
   if (itr != cache_.end()) {
-    return folly::Optional<V>(itr->second);
+    if (isExpired(itr->second, nowMs())) {
+      // Lazy expiry: reap the entry now so it is neither returned nor
+      // persisted on the next sync.
+      untrack(entryBytes(key, itr->second.value));
+      cache_.erase(key);
+      incrementVersion();
+      return folly::none;
+    }
+    return folly::Optional<V>(itr->second.value);
   }
   return folly::none;
 }
@@ -37,19 +47,93 @@ folly::Optional<V> LRUInMemoryCache<K, V, M>::get(const K& key) {
 template <typename K, typename V, typename M>
 void LRUInMemoryCache<K, V, M>::put(const K& key, const V& val) {
   typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
-  cache_.set(key, val);
+  auto itr = cache_.find(key);
+  if (itr != cache_.end()) {
+    // set() replaces in place without running the prune hook.
+    untrack(entryBytes(key, itr->second.value));
+  }
+  cache_.set(key, CacheEntry{val, 0});
+  track(entryBytes(key, val));
   incrementVersion();
 }
 
 template <typename K, typename V, typename M>
-bool LRUInMemoryCache<K, V, M>::remove(const K& key) {
+void LRUInMemoryCache<K, V, M>::put(
+    const K& key,
+    const V& val,
+    std::chrono::milliseconds ttl) {
+  typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
+  auto itr = cache_.find(key);
+  if (itr != cache_.end()) {
+    untrack(entryBytes(key, itr->second.value));
+  }
+  cache_.set(key, CacheEntry{val, nowMs() + ttl.count()});
+  track(entryBytes(key, val));
+  incrementVersion();
+}
+
+template <typename K, typename V, typename M>
+std::vector<folly::Optional<V>> LRUInMemoryCache<K, V, M>::getMany(
+    const std::vector<K>& keys) {
+  std::vector<folly::Optional<V>> values;
+  values.reserve(keys.size());
+  // One write lock for the whole batch; get() mutates the LRU and
+  // may reap, so a read lock is not enough.
   typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
-  size_t nErased = cache_.erase(key);
-  if (nErased > 0) {
+  auto now = nowMs();
+  bool reaped = false;
+  for (const auto& key : keys) {
+    auto itr = cache_.find(key);
+    if (itr == cache_.end()) {
+      values.emplace_back(folly::none);
+      continue;
+    }
+    if (isExpired(itr->second, now)) {
+      untrack(entryBytes(key, itr->second.value));
+      cache_.erase(key);
+      reaped = true;
+      values.emplace_back(folly::none);
+      continue;
+    }
+    values.emplace_back(itr->second.value);
+  }
+  if (reaped) {
     incrementVersion();
-    return true;
   }
-  return false;
+  return values;
+}
+
+template <typename K, typename V, typename M>
+void LRUInMemoryCache<K, V, M>::putMany(
+    const std::vector<std::pair<K, V>>& kvPairs) {
+  if (kvPairs.empty()) {
+    return;
+  }
+  typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
+  for (const auto& kv : kvPairs) {
+    auto itr = cache_.find(kv.first);
+    if (itr != cache_.end()) {
+      untrack(entryBytes(kv.first, itr->second.value));
+    }
+    cache_.set(kv.first, CacheEntry{kv.second, 0});
+    track(entryBytes(kv.first, kv.second));
+  }
+  // One bump covers the batch: the persistence layer sees a single
+  // change to sync rather than one per pair.
+  incrementVersion();
+}
+
+template <typename K, typename V, typename M>
+bool LRUInMemoryCache<K, V, M>::remove(const K& key) {
+  typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
+  auto itr = cache_.find(key);
+  if (itr == cache_.end()) {
+    return false;
+  }
+  untrack(entryBytes(key, itr->second.value));
+  cache_.erase(key);
+  incrementVersion();
+  return true;
 }
 
 template <typename K, typename V, typename M>
@@ -68,6 +152,35 @@ void LRUInMemoryCache<K, V, M>::clear() {
   incrementVersion();
 }
 
+template <typename K, typename V, typename M>
+size_t LRUInMemoryCache<K, V, M>::sweepExpired(size_t maxEntries) {
+  typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
+  auto now = nowMs();
+  std::vector<K> expiredKeys;
+  size_t examined = 0;
+  size_t reclaimed = 0;
+  // The map iterates MRU first, so a bounded sweep may not reach the
+  // coldest entries in one pass; repeated calls make progress as
+  // expired entries near the front are removed.
+  for (const auto& kv : cache_) {
+    if (examined++ >= maxEntries) {
+      break;
+    }
+    if (isExpired(kv.second, now)) {
+      expiredKeys.push_back(kv.first);
+      reclaimed += entryBytes(kv.first, kv.second.value);
+    }
+  }
+  for (const auto& key : expiredKeys) {
+    cache_.erase(key);
+  }
+  if (!expiredKeys.empty()) {
+    untrack(reclaimed);
+    incrementVersion();
+  }
+  return expiredKeys.size();
+}
+
 template <typename K, typename V, typename M>
 CacheDataVersion LRUInMemoryCache<K, V, M>::getVersion() const {
   typename wangle::CacheLockGuard<M>::Read readLock(cacheLock_);
@@ -78,10 +191,24 @@ template <typename K, typename V, typename M>
 CacheDataVersion LRUInMemoryCache<K, V, M>::loadData(
     const folly::dynamic& data) noexcept {
   bool updated = false;
+  auto now = nowMs();
   typename wangle::CacheLockGuard<M>::Write writeLock(cacheLock_);
   try {
     for (const auto& kv : data) {
-      cache_.set(folly::convertTo<K>(kv[0]), folly::convertTo<V>(kv[1]));
+      // Entries persisted with a ttl carry the deadline as a third
+      // element; anything already expired is not resurrected.
+      uint64_t expiryMs = kv.size() > 2 ? kv[2].asInt() : 0;
+      if (expiryMs != 0 && expiryMs <= now) {
+        continue;
+      }
+      auto key = folly::convertTo<K>(kv[0]);
+      auto value = folly::convertTo<V>(kv[1]);
+      auto itr = cache_.find(key);
+      if (itr != cache_.end()) {
+        untrack(entryBytes(key, itr->second.value));
+      }
+      track(entryBytes(key, value));
+      cache_.set(std::move(key), CacheEntry{std::move(value), expiryMs});
       updated = true;
     }
   } catch (const folly::TypeError& err) {
@@ -102,10 +229,23 @@ template <typename K, typename V, typename M>
 folly::Optional<std::pair<folly::dynamic, CacheDataVersion>>
 LRUInMemoryCache<K, V, M>::convertToKeyValuePairs() noexcept {
   typename wangle::CacheLockGuard<M>::Read readLock(cacheLock_);
+  auto now = nowMs();
   try {
     folly::dynamic dynObj = folly::dynamic::array;
     for (const auto& kv : cache_) {
-      dynObj.push_back(folly::toDynamic(std::make_pair(kv.first, kv.second)));
+      if (isExpired(kv.second, now)) {
+        // Skipped rather than erased; we only hold a read lock here.
+        // get() or sweepExpired() will reap it.
+        continue;
+      }
+      // Entries without a ttl keep the historical [key, value] format;
+      // ttl entries append the absolute deadline.
+      auto pair =
+          folly::toDynamic(std::make_pair(kv.first, kv.second.value));
+      if (kv.second.expiryMs != 0) {
+        pair.push_back(kv.second.expiryMs);
+      }
+      dynObj.push_back(std::move(pair));
     }
     return std::make_pair(std::move(dynObj), version_);
   } catch (const std::exception& err) {
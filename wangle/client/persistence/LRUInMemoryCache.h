@@ -16,18 +16,25 @@
 
 #pragma once
 
+#include <chrono>
 #include <utility>
+#include <vector>
 
 #include <folly/Optional.h>
 #include <folly/container/EvictingCacheMap.h>
 #include <folly/dynamic.h>
 #include <wangle/client/persistence/PersistentCacheCommon.h>
+#include <wangle/util/MemoryAccounting.h>
 
 namespace wangle {
 
 /**
  * A threadsafe cache map that delegates to an EvictingCacheMap and maintains
  * a version of the data.
+ *
+ * Entries may carry an optional time-to-live. Expired entries are
+ * reaped lazily on get() and in bounded batches via sweepExpired();
+ * they are never persisted nor resurrected on load.
  */
 template <typename K, typename V, typename MutexT>
 class LRUInMemoryCache {
@@ -35,15 +42,71 @@ class LRUInMemoryCache {
   /**
    * Create with the specified capacity.
    */
-  explicit LRUInMemoryCache(size_t capacity) : cache_(capacity) {}
-  ~LRUInMemoryCache() = default;
+  explicit LRUInMemoryCache(size_t capacity) : cache_(capacity) {
+    // Capacity evictions and clear() release entries through the prune
+    // hook; the explicit erase() paths account for themselves.
+    cache_.setPruneHook([this](K key, CacheEntry&& entry) {
+      untrack(entryBytes(key, entry.value));
+    });
+  }
+
+  ~LRUInMemoryCache() {
+    // Entries die with the map without running the prune hook.
+    MemoryAccounting::sub(MemorySubsystem::CLIENT_CACHE, trackedBytes_);
+  }
 
   folly::Optional<V> get(const K& key);
   void put(const K& key, const V& val);
+  /**
+   * Set a value with a time-to-live. After the ttl elapses the entry
+   * behaves as if it had been removed. The deadline is stored as
+   * wall-clock milliseconds so it survives a persist/load cycle.
+   */
+  void put(const K& key, const V& val, std::chrono::milliseconds ttl);
   bool remove(const K& key);
   size_t size() const;
   void clear();
 
+  /**
+   * Look up a batch of keys under one lock acquisition; get() pays
+   * one per key. Returns one value slot per key, in the order given.
+   * Expired entries encountered along the way are reaped, with a
+   * single version bump for the whole batch.
+   */
+  std::vector<folly::Optional<V>> getMany(const std::vector<K>& keys);
+
+  /**
+   * Set a batch of key value pairs under one lock acquisition and a
+   * single version bump, so the persistence layer's change detection
+   * sees one change instead of one per pair.
+   */
+  void putMany(const std::vector<std::pair<K, V>>& kvPairs);
+
+  /**
+   * Visit every live entry under a single read lock, most recently
+   * used first, without copying the data out or disturbing the LRU
+   * order. Expired entries are skipped, not reaped. The visitor is
+   * called with (key, value) and must not reenter the cache.
+   */
+  template <typename Fn>
+  void forEach(Fn&& visitor) const {
+    typename wangle::CacheLockGuard<MutexT>::Read readLock(cacheLock_);
+    auto now = nowMs();
+    for (const auto& kv : cache_) {
+      if (isExpired(kv.second, now)) {
+        continue;
+      }
+      visitor(kv.first, kv.second.value);
+    }
+  }
+
+  /**
+   * Remove entries whose ttl has elapsed, examining at most maxEntries
+   * entries so a single call stays cheap on a large cache. Returns the
+   * number of entries removed; the version is bumped if any were.
+   */
+  size_t sweepExpired(size_t maxEntries);
+
   CacheDataVersion getVersion() const;
 
   /**
@@ -66,6 +129,41 @@ class LRUInMemoryCache {
   }
 
  private:
+  struct CacheEntry {
+    V value;
+    // Absolute deadline in milliseconds since the system_clock epoch;
+    // 0 means the entry never expires.
+    uint64_t expiryMs{0};
+  };
+
+  static uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  static bool isExpired(const CacheEntry& entry, uint64_t now) {
+    return entry.expiryMs != 0 && entry.expiryMs <= now;
+  }
+
+  // Bytes attributed to an entry in the CLIENT_CACHE accounting; node
+  // overhead inside the map is not counted.
+  static size_t entryBytes(const K& key, const V& value) {
+    return memoryFootprint(key) + memoryFootprint(value);
+  }
+
+  // must be called under a write lock
+  void track(size_t bytes) {
+    trackedBytes_ += bytes;
+    MemoryAccounting::add(MemorySubsystem::CLIENT_CACHE, bytes);
+  }
+
+  // must be called under a write lock
+  void untrack(size_t bytes) {
+    trackedBytes_ -= bytes;
+    MemoryAccounting::sub(MemorySubsystem::CLIENT_CACHE, bytes);
+  }
+
   // must be called under a write lock
   void incrementVersion() {
     ++version_;
@@ -73,7 +171,10 @@ class LRUInMemoryCache {
     // 585 years to wrap around, so don't bother
   }
 
-  folly::EvictingCacheMap<K, V> cache_;
+  folly::EvictingCacheMap<K, CacheEntry> cache_;
+  // Bytes currently attributed to this cache, so the destructor can
+  // settle the global counter.
+  size_t trackedBytes_{0};
   // Version always starts at 1
   CacheDataVersion version_{kDefaultInitCacheDataVersion};
   // mutable so we can take read locks in const methods
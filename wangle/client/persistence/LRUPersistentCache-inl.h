@@ -35,6 +35,7 @@ LRUPersistentCache<K, V, MutexT>::LRUPersistentCache(
     : cache_(config.capacity),
       syncInterval_(config.syncInterval),
       nSyncRetries_(config.nSyncRetries),
+      expirySweepBatchSize_(config.expirySweepBatchSize),
       executor_(std::move(config.executor)),
       inlinePersistenceLoading_(config.inlinePersistenceLoading) {
   if (persistence) {
@@ -88,7 +89,27 @@ void LRUPersistentCache<K, V, MutexT>::init() {
 template <typename K, typename V, typename MutexT>
 void LRUPersistentCache<K, V, MutexT>::put(const K& key, const V& val) {
   blockingAccessInMemCache().put(key, val);
+  maybeScheduleExecutorSync();
+}
+
+template <typename K, typename V, typename MutexT>
+void LRUPersistentCache<K, V, MutexT>::put(
+    const K& key,
+    const V& val,
+    std::chrono::milliseconds ttl) {
+  blockingAccessInMemCache().put(key, val, ttl);
+  maybeScheduleExecutorSync();
+}
 
+template <typename K, typename V, typename MutexT>
+void LRUPersistentCache<K, V, MutexT>::putMany(
+    const std::vector<std::pair<K, V>>& kvPairs) {
+  blockingAccessInMemCache().putMany(kvPairs);
+  maybeScheduleExecutorSync();
+}
+
+template <typename K, typename V, typename MutexT>
+void LRUPersistentCache<K, V, MutexT>::maybeScheduleExecutorSync() {
   if (!executor_) {
     return;
   }
@@ -138,6 +159,9 @@ void LRUPersistentCache<K, V, MutexT>::oneShotSync() {
   // load the cache. be silent if load fails, we just drop the cache
   // and start from scratch.
   setPersistenceHelper(true);
+  // reap a bounded batch of expired entries; removals bump the version
+  // so they sync down to persistence below
+  cache_.sweepExpired(expirySweepBatchSize_);
   auto persistence = getPersistence();
   if (persistence && !syncNow(*persistence)) {
     // track failures and give up if we tried too many times
@@ -163,6 +187,9 @@ void LRUPersistentCache<K, V, MutexT>::sync() {
   std::unique_lock<std::mutex> stopSyncerLock(stopSyncerMutex_);
   int nSyncFailures = 0;
   while (true) {
+    // expired entries are swept incrementally, a bounded batch per
+    // cycle, so a large cache does not stall the syncer
+    cache_.sweepExpired(expirySweepBatchSize_);
     auto persistence = getPersistence();
     if (stopSyncer_) {
       if (!persistence ||
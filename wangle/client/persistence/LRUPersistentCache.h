@@ -158,6 +158,25 @@ class LRUPersistentCache
 
   void put(const K& key, const V& val) override;
 
+  void put(const K& key, const V& val, std::chrono::milliseconds ttl) override;
+
+  std::vector<folly::Optional<V>> getMany(
+      const std::vector<K>& keys) override {
+    return blockingAccessInMemCache().getMany(keys);
+  }
+
+  void putMany(const std::vector<std::pair<K, V>>& kvPairs) override;
+
+  /**
+   * Visit every live entry under one read lock without copying the
+   * cache out. The visitor is called with (key, value) and must not
+   * call back into the cache.
+   */
+  template <typename Fn>
+  void forEach(Fn&& visitor) {
+    blockingAccessInMemCache().forEach(std::forward<Fn>(visitor));
+  }
+
   bool remove(const K& key) override {
     return blockingAccessInMemCache().remove(key);
   }
@@ -186,6 +205,12 @@ class LRUPersistentCache
    */
   void setPersistenceHelper(bool syncVersion) noexcept;
 
+  /**
+   * Schedule a one-shot sync on the executor after a put, unless one
+   * ran within the last sync interval or is already scheduled.
+   */
+  void maybeScheduleExecutorSync();
+
   /**
    * Load the contents of the persistence passed to constructor in to the
    * in-memory cache. Failure to read will result in no changes to the
@@ -248,6 +273,9 @@ class LRUPersistentCache
       client::persistence::DEFAULT_CACHE_SYNC_INTERVAL};
   // limit on no. of sync attempts
   const int nSyncRetries_{client::persistence::DEFAULT_CACHE_SYNC_RETRIES};
+  // max entries examined per sync cycle when sweeping expired entries
+  const std::size_t expirySweepBatchSize_{
+      client::persistence::DEFAULT_CACHE_EXPIRY_SWEEP_BATCH};
   // Sync try count across executor tasks
   int nSyncTries_{0};
   std::chrono::steady_clock::time_point lastExecutorScheduleTime_;
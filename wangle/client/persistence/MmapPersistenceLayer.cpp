@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/client/persistence/MmapPersistenceLayer.h>
+
+#include <cstring>
+#include <exception>
+
+#include <folly/FileUtil.h>
+#include <folly/MemoryMapping.h>
+#include <folly/lang/Bits.h>
+#include <folly/portability/Unistd.h>
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'M', 'P', 'C'};
+constexpr uint8_t kFormatVersion = 1;
+constexpr size_t kHeaderSize = sizeof(kMagic) + sizeof(uint8_t) +
+    sizeof(uint64_t);
+
+folly::json::serialization_opts jsonOpts() {
+  folly::json::serialization_opts opts;
+  opts.allow_non_string_keys = true;
+  return opts;
+}
+
+template <typename T>
+void appendLE(std::string& out, T value) {
+  T le = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+template <typename T>
+bool readLE(const uint8_t*& p, const uint8_t* end, T& value) {
+  if (end - p < static_cast<ptrdiff_t>(sizeof(value))) {
+    return false;
+  }
+  value = folly::Endian::little(folly::loadUnaligned<T>(p));
+  p += sizeof(value);
+  return true;
+}
+
+} // namespace
+
+namespace wangle {
+
+bool MmapPersistenceLayer::persist(
+    const folly::dynamic& arrayOfKvPairs) noexcept {
+  std::string records;
+  std::string image;
+  try {
+    const auto opts = jsonOpts();
+    const uint64_t count = arrayOfKvPairs.size();
+    const size_t tableSize = count * sizeof(uint64_t);
+
+    std::string offsets;
+    offsets.reserve(tableSize);
+    for (const auto& kv : arrayOfKvPairs) {
+      appendLE(offsets, static_cast<uint64_t>(
+          kHeaderSize + tableSize + records.size()));
+      const auto key = folly::json::serialize(kv[0], opts);
+      const auto value = folly::json::serialize(kv[1], opts);
+      appendLE(records, static_cast<uint32_t>(key.size()));
+      records.append(key);
+      appendLE(records, static_cast<uint32_t>(value.size()));
+      records.append(value);
+    }
+
+    image.reserve(kHeaderSize + tableSize + records.size());
+    image.append(kMagic, sizeof(kMagic));
+    image.push_back(static_cast<char>(kFormatVersion));
+    appendLE(image, count);
+    image.append(offsets);
+    image.append(records);
+  } catch (...) {
+    LOG(ERROR) << "Serializing to JSON failed with error: "
+               << folly::exceptionStr(std::current_exception());
+    return false;
+  }
+
+  const auto tmpFile = file_ + ".tmp";
+  const auto fd =
+      folly::openNoInt(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd == -1) {
+    LOG(ERROR) << "Failed to open " << tmpFile << ": errno " << errno;
+    return false;
+  }
+  bool ok = true;
+  const auto nWritten = folly::writeFull(fd, image.data(), image.size());
+  ok = nWritten >= 0 && static_cast<size_t>(nWritten) == image.size();
+  ok = folly::fdatasyncNoInt(fd) == 0 && ok;
+  ok = folly::closeNoInt(fd) == 0 && ok;
+  if (!ok) {
+    LOG(ERROR) << "Failed to write cache image " << tmpFile;
+    ::unlink(tmpFile.c_str());
+    return false;
+  }
+  if (::rename(tmpFile.c_str(), file_.c_str()) != 0) {
+    LOG(ERROR) << "Failed to rename " << tmpFile << ": errno " << errno;
+    ::unlink(tmpFile.c_str());
+    return false;
+  }
+  return true;
+}
+
+folly::Optional<folly::dynamic> MmapPersistenceLayer::load() noexcept {
+  // Not being able to read the backing storage means we just start with an
+  // empty cache. A malformed image is a real error so we report it.
+  const auto fd = folly::openNoInt(file_.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return folly::none;
+  }
+  try {
+    folly::MemoryMapping mapping(folly::File(fd, true /* ownsFd */));
+    auto range = mapping.range();
+    const uint8_t* p = range.begin();
+    const uint8_t* end = range.end();
+
+    if (end - p < static_cast<ptrdiff_t>(kHeaderSize) ||
+        memcmp(p, kMagic, sizeof(kMagic)) != 0) {
+      LOG(ERROR) << "Cache image " << file_ << " has bad magic";
+      return folly::none;
+    }
+    p += sizeof(kMagic);
+    if (*p++ != kFormatVersion) {
+      LOG(ERROR) << "Cache image " << file_ << " has unknown version";
+      return folly::none;
+    }
+    uint64_t count = 0;
+    readLE(p, end, count);
+    if (count > (end - p) / sizeof(uint64_t)) {
+      LOG(ERROR) << "Cache image " << file_ << " has bad record count";
+      return folly::none;
+    }
+
+    const auto opts = jsonOpts();
+    folly::dynamic result = folly::dynamic::array;
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t offset = 0;
+      readLE(p, end, offset);
+      if (offset > range.size()) {
+        LOG(ERROR) << "Cache image " << file_ << " has bad offset";
+        return folly::none;
+      }
+      const uint8_t* rp = range.begin() + offset;
+      uint32_t keyLen = 0;
+      uint32_t valueLen = 0;
+      if (!readLE(rp, end, keyLen) ||
+          end - rp < static_cast<ptrdiff_t>(keyLen)) {
+        LOG(ERROR) << "Cache image " << file_ << " has truncated record";
+        return folly::none;
+      }
+      folly::StringPiece key(reinterpret_cast<const char*>(rp), keyLen);
+      rp += keyLen;
+      if (!readLE(rp, end, valueLen) ||
+          end - rp < static_cast<ptrdiff_t>(valueLen)) {
+        LOG(ERROR) << "Cache image " << file_ << " has truncated record";
+        return folly::none;
+      }
+      folly::StringPiece value(reinterpret_cast<const char*>(rp), valueLen);
+      result.push_back(folly::dynamic::array(
+          folly::parseJson(key, opts), folly::parseJson(value, opts)));
+    }
+    return result;
+  } catch (...) {
+    LOG(ERROR) << "Deserialization of cache image " << file_
+               << " failed: " << folly::exceptionStr(std::current_exception());
+    return folly::none;
+  }
+}
+
+void MmapPersistenceLayer::clear() {
+  // This may fail but it's ok
+  ::unlink(file_.c_str());
+}
+
+} // namespace wangle
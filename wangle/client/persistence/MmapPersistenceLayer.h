@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <folly/json.h>
+#include <wangle/client/persistence/LRUPersistentCache.h>
+
+namespace wangle {
+
+/**
+ * A CachePersistence storing a directly indexable binary image instead of
+ * one monolithic JSON document.
+ *
+ * The file starts with a fixed header and an offset table, so load() can
+ * mmap the image and walk straight to each record without first copying the
+ * file into memory or parsing a document-sized JSON value. Individual keys
+ * and values are still JSON-encoded, one small parse per record.
+ *
+ * File layout, integers little-endian:
+ *   char[4]  magic "WMPC"
+ *   uint8_t  format version
+ *   uint64_t record count
+ *   uint64_t per-record offsets from the start of the file (count entries)
+ *   records: uint32_t key length + JSON key, uint32_t value length +
+ *            JSON value
+ *
+ * persist() writes the full image to a temp file and renames it into place
+ * so a concurrent load() never sees a half-written table.
+ */
+class MmapPersistenceLayer : public CachePersistence {
+ public:
+  explicit MmapPersistenceLayer(const std::string& file) : file_(file) {}
+  ~MmapPersistenceLayer() override = default;
+
+  bool persist(const folly::dynamic& arrayOfKvPairs) noexcept override;
+
+  folly::Optional<folly::dynamic> load() noexcept override;
+
+  void clear() override;
+
+ private:
+  std::string file_;
+};
+
+} // namespace wangle
@@ -16,8 +16,12 @@
 
 #pragma once
 
-#include <folly/Optional.h>
+#include <chrono>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
 
 namespace wangle {
 
@@ -50,6 +54,51 @@ class PersistentCache {
    */
   virtual void put(const K& key, const V& val) = 0;
 
+  /**
+   * Set a value corresponding to a key with a time-to-live. Once the
+   * ttl elapses the entry behaves as if it were never stored: get()
+   * misses, and implementations with persistence do not resurrect it
+   * across restarts. Implementations without native TTL support treat
+   * this as a plain put().
+   */
+  virtual void put(
+      const K& key,
+      const V& val,
+      std::chrono::milliseconds /* ttl */) {
+    put(key, val);
+  }
+
+  /**
+   * Look up a batch of keys at once
+   * @param keys the keys to look up
+   *
+   * @returns one value slot per key, in the order given; a slot is
+   *          empty if its key has no value in the cache
+   *
+   * The default walks get() per key; implementations with internal
+   * locking override it to amortize the locking over the batch.
+   */
+  virtual std::vector<folly::Optional<V>> getMany(const std::vector<K>& keys) {
+    std::vector<folly::Optional<V>> values;
+    values.reserve(keys.size());
+    for (const auto& key : keys) {
+      values.push_back(get(key));
+    }
+    return values;
+  }
+
+  /**
+   * Set a batch of key value pairs at once, overwriting any existing
+   * values. The default walks put() per pair; implementations
+   * override it to take their locks and bump their change-detection
+   * state once per batch instead of once per pair.
+   */
+  virtual void putMany(const std::vector<std::pair<K, V>>& kvPairs) {
+    for (const auto& kv : kvPairs) {
+      put(kv.first, kv.second);
+    }
+  }
+
   /**
    * Clear a cache entry associated with a key
    * @param key string, the key to lookup and clear
@@ -50,12 +50,20 @@ PersistentCacheConfig::Builder&& PersistentCacheConfig::Builder::setSyncRetries(
   return std::move(*this);
 }
 
+PersistentCacheConfig::Builder&&
+PersistentCacheConfig::Builder::setExpirySweepBatchSize(
+    std::size_t batchSize) && {
+  expirySweepBatchSize = batchSize;
+  return std::move(*this);
+}
+
 PersistentCacheConfig PersistentCacheConfig::Builder::build() && {
   return PersistentCacheConfig(
       capacity.value(),
       syncInterval,
       nSyncRetries,
       std::move(executor),
-      inlinePersistenceLoading);
+      inlinePersistenceLoading,
+      expirySweepBatchSize);
 }
 } // namespace wangle
@@ -30,6 +30,7 @@ constexpr std::chrono::milliseconds DEFAULT_CACHE_SYNC_INTERVAL =
     std::chrono::milliseconds(5000);
 constexpr int DEFAULT_CACHE_SYNC_RETRIES = 3;
 constexpr std::size_t DEFAULT_CACHE_CAPACITY = 100;
+constexpr std::size_t DEFAULT_CACHE_EXPIRY_SWEEP_BATCH = 128;
 } // namespace persistence
 } // namespace client
 
@@ -68,6 +69,10 @@ struct PersistentCacheConfig {
   std::shared_ptr<folly::Executor> executor;
   // Whether the persistence will be loaded inline on constructor thread
   bool inlinePersistenceLoading{true};
+  // Max number of entries examined per sync cycle when sweeping expired
+  // ttl entries out of the cache.
+  std::size_t expirySweepBatchSize{
+      client::persistence::DEFAULT_CACHE_EXPIRY_SWEEP_BATCH};
 
   PersistentCacheConfig() = default;
 
@@ -77,6 +82,7 @@ struct PersistentCacheConfig {
     Builder&& setExecutor(std::shared_ptr<folly::Executor> executor) &&;
     Builder&& setInlinePersistenceLoading(bool loadInline) &&;
     Builder&& setSyncRetries(int retries) &&;
+    Builder&& setExpirySweepBatchSize(std::size_t batchSize) &&;
 
     PersistentCacheConfig build() &&;
 
@@ -87,6 +93,8 @@ struct PersistentCacheConfig {
     int nSyncRetries{client::persistence::DEFAULT_CACHE_SYNC_RETRIES};
     std::shared_ptr<folly::Executor> executor;
     bool inlinePersistenceLoading{true};
+    std::size_t expirySweepBatchSize{
+        client::persistence::DEFAULT_CACHE_EXPIRY_SWEEP_BATCH};
   };
 
  private:
@@ -95,11 +103,13 @@ struct PersistentCacheConfig {
       std::chrono::milliseconds syncIntervalIn,
       int nSyncRetriesIn,
       std::shared_ptr<folly::Executor> executorIn,
-      bool inlinePersistenceLoadingIn)
+      bool inlinePersistenceLoadingIn,
+      std::size_t expirySweepBatchSizeIn)
       : capacity(capacityIn),
         syncInterval(syncIntervalIn),
         nSyncRetries(nSyncRetriesIn),
         executor(std::move(executorIn)),
-        inlinePersistenceLoading(inlinePersistenceLoadingIn) {}
+        inlinePersistenceLoading(inlinePersistenceLoadingIn),
+        expirySweepBatchSize(expirySweepBatchSizeIn) {}
 };
 } // namespace wangle
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include <folly/DynamicConverter.h>
+
+namespace wangle {
+
+template <typename K, typename V, typename M>
+ShardedLRUInMemoryCache<K, V, M>::ShardedLRUInMemoryCache(
+    size_t capacity,
+    size_t shardCount,
+    size_t evictionBatchSize) {
+  CHECK_GT(shardCount, 0);
+  auto shardCapacity = std::max<size_t>(
+      (capacity + shardCount - 1) / shardCount, evictionBatchSize);
+  shards_.reserve(shardCount);
+  for (size_t i = 0; i < shardCount; i++) {
+    shards_.push_back(
+        std::make_unique<Shard>(shardCapacity, evictionBatchSize));
+  }
+}
+
+template <typename K, typename V, typename M>
+folly::Optional<V> ShardedLRUInMemoryCache<K, V, M>::get(const K& key) {
+  auto& shard = shardFor(key);
+  // need to take a write lock since get modifies the LRU
+  typename wangle::CacheLockGuard<M>::Write writeLock(shard.lock);
+  auto itr = shard.cache.find(key);
+  if (itr != shard.cache.end()) {
+    return folly::Optional<V>(itr->second);
+  }
+  return folly::none;
+}
+
+template <typename K, typename V, typename M>
+void ShardedLRUInMemoryCache<K, V, M>::put(const K& key, const V& val) {
+  auto& shard = shardFor(key);
+  {
+    typename wangle::CacheLockGuard<M>::Write writeLock(shard.lock);
+    shard.cache.set(key, val);
+  }
+  incrementVersion();
+}
+
+template <typename K, typename V, typename M>
+bool ShardedLRUInMemoryCache<K, V, M>::remove(const K& key) {
+  auto& shard = shardFor(key);
+  size_t nErased = 0;
+  {
+    typename wangle::CacheLockGuard<M>::Write writeLock(shard.lock);
+    nErased = shard.cache.erase(key);
+  }
+  if (nErased > 0) {
+    incrementVersion();
+    return true;
+  }
+  return false;
+}
+
+template <typename K, typename V, typename M>
+std::vector<folly::Optional<V>> ShardedLRUInMemoryCache<K, V, M>::getMany(
+    const std::vector<K>& keys) {
+  std::vector<folly::Optional<V>> values(keys.size());
+  // Group the lookups so each shard's lock is taken at most once.
+  std::vector<std::vector<size_t>> byShard(shards_.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    byShard[shardIndexFor(keys[i])].push_back(i);
+  }
+  for (size_t s = 0; s < shards_.size(); s++) {
+    if (byShard[s].empty()) {
+      continue;
+    }
+    auto& shard = *shards_[s];
+    // write lock since get modifies the LRU
+    typename wangle::CacheLockGuard<M>::Write writeLock(shard.lock);
+    for (auto i : byShard[s]) {
+      auto itr = shard.cache.find(keys[i]);
+      if (itr != shard.cache.end()) {
+        values[i] = itr->second;
+      }
+    }
+  }
+  return values;
+}
+
+template <typename K, typename V, typename M>
+void ShardedLRUInMemoryCache<K, V, M>::putMany(
+    const std::vector<std::pair<K, V>>& kvPairs) {
+  if (kvPairs.empty()) {
+    return;
+  }
+  std::vector<std::vector<size_t>> byShard(shards_.size());
+  for (size_t i = 0; i < kvPairs.size(); i++) {
+    byShard[shardIndexFor(kvPairs[i].first)].push_back(i);
+  }
+  for (size_t s = 0; s < shards_.size(); s++) {
+    if (byShard[s].empty()) {
+      continue;
+    }
+    auto& shard = *shards_[s];
+    typename wangle::CacheLockGuard<M>::Write writeLock(shard.lock);
+    for (auto i : byShard[s]) {
+      shard.cache.set(kvPairs[i].first, kvPairs[i].second);
+    }
+  }
+  // One bump for the whole batch.
+  incrementVersion();
+}
+
+template <typename K, typename V, typename M>
+size_t ShardedLRUInMemoryCache<K, V, M>::size() const {
+  size_t total = 0;
+  for (const auto& shard : shards_) {
+    typename wangle::CacheLockGuard<M>::Read readLock(shard->lock);
+    total += shard->cache.size();
+  }
+  return total;
+}
+
+template <typename K, typename V, typename M>
+void ShardedLRUInMemoryCache<K, V, M>::clear() {
+  bool cleared = false;
+  for (auto& shard : shards_) {
+    typename wangle::CacheLockGuard<M>::Write writeLock(shard->lock);
+    if (!shard->cache.empty()) {
+      shard->cache.clear();
+      cleared = true;
+    }
+  }
+  if (cleared) {
+    incrementVersion();
+  }
+}
+
+template <typename K, typename V, typename M>
+CacheDataVersion ShardedLRUInMemoryCache<K, V, M>::loadData(
+    const folly::dynamic& data) noexcept {
+  try {
+    for (const auto& kv : data) {
+      // put() bumps the version per pair loaded.
+      put(folly::convertTo<K>(kv[0]), folly::convertTo<V>(kv[1]));
+    }
+  } catch (const folly::TypeError& err) {
+    LOG(ERROR) << "Load cache failed with type error: " << err.what();
+  } catch (const std::out_of_range& err) {
+    LOG(ERROR) << "Load cache failed with key error: " << err.what();
+  } catch (const std::exception& err) {
+    LOG(ERROR) << "Load cache failed with error: " << err.what();
+  }
+  return getVersion();
+}
+
+template <typename K, typename V, typename M>
+folly::Optional<std::pair<folly::dynamic, CacheDataVersion>>
+ShardedLRUInMemoryCache<K, V, M>::convertToKeyValuePairs() noexcept {
+  // Captured before the walk: a mutation racing with it changes the
+  // version, so the persistence layer will see the cache as changed and
+  // sync again rather than trust a torn snapshot.
+  auto version = getVersion();
+  try {
+    folly::dynamic dynObj = folly::dynamic::array;
+    for (const auto& shard : shards_) {
+      typename wangle::CacheLockGuard<M>::Read readLock(shard->lock);
+      for (const auto& kv : shard->cache) {
+        dynObj.push_back(folly::toDynamic(std::make_pair(kv.first, kv.second)));
+      }
+    }
+    return std::make_pair(std::move(dynObj), version);
+  } catch (const std::exception& err) {
+    LOG(ERROR) << "Converting cache to folly::dynamic failed with error: "
+               << err.what();
+  }
+  return folly::none;
+}
+
+} // namespace wangle
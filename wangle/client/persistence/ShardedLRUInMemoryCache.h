@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/dynamic.h>
+#include <folly/hash/Hash.h>
+#include <wangle/client/persistence/PersistentCacheCommon.h>
+
+namespace wangle {
+
+/**
+ * A sharded alternative to LRUInMemoryCache for high-concurrency
+ * workloads where a single cache lock convoys. Keys are
+ * hash-partitioned across a fixed number of shards, each with its own
+ * EvictingCacheMap, LRU clock and lock, so operations on different
+ * shards never contend. Eviction is amortized per shard: a full shard
+ * evicts a batch of entries at once instead of one per insert.
+ *
+ * The data version is a single atomic counter bumped on every
+ * mutation, preserving the version-based sync semantics
+ * (hasChangedSince) that the persistence layer relies on.
+ *
+ * The trade-offs against the single-map cache: LRU order is only
+ * maintained within a shard, capacity is split evenly between shards
+ * (so a hot shard may evict while others have room), and
+ * convertToKeyValuePairs() locks one shard at a time rather than
+ * snapshotting the whole cache atomically.
+ */
+template <typename K, typename V, typename MutexT>
+class ShardedLRUInMemoryCache {
+ public:
+  /**
+   * Create with the specified total capacity, split across shardCount
+   * shards. Each shard evicts evictionBatchSize entries at a time once
+   * it fills.
+   */
+  explicit ShardedLRUInMemoryCache(
+      size_t capacity,
+      size_t shardCount = 16,
+      size_t evictionBatchSize = 16);
+
+  folly::Optional<V> get(const K& key);
+  void put(const K& key, const V& val);
+  bool remove(const K& key);
+  size_t size() const;
+  void clear();
+
+  /**
+   * Look up a batch of keys, grouping them by shard so each shard's
+   * lock is taken at most once per batch rather than once per key.
+   * Returns one value slot per key, in the order given.
+   */
+  std::vector<folly::Optional<V>> getMany(const std::vector<K>& keys);
+
+  /**
+   * Set a batch of key value pairs, grouped by shard like getMany(),
+   * with a single version bump for the whole batch.
+   */
+  void putMany(const std::vector<std::pair<K, V>>& kvPairs);
+
+  /**
+   * Visit every entry, locking one shard at a time; like
+   * convertToKeyValuePairs(), the walk is not atomic across shards.
+   * The visitor is called with (key, value) and must not reenter the
+   * cache.
+   */
+  template <typename Fn>
+  void forEach(Fn&& visitor) const {
+    for (const auto& shard : shards_) {
+      typename wangle::CacheLockGuard<MutexT>::Read readLock(shard->lock);
+      for (const auto& kv : shard->cache) {
+        visitor(kv.first, kv.second);
+      }
+    }
+  }
+
+  CacheDataVersion getVersion() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Loads the list of kv pairs into the cache and bumps version.
+   * Returns the new cache version.
+   */
+  CacheDataVersion loadData(const folly::dynamic& kvPairs) noexcept;
+
+  /**
+   * Get the cache data as a list of kv pairs along with the version
+   */
+  folly::Optional<std::pair<folly::dynamic, CacheDataVersion>>
+  convertToKeyValuePairs() noexcept;
+
+  /**
+   * Determine if the cache has changed since the specified version
+   */
+  bool hasChangedSince(CacheDataVersion version) const {
+    return getVersion() != version;
+  }
+
+ private:
+  struct Shard {
+    Shard(size_t capacity, size_t clearSize) : cache(capacity, clearSize) {}
+
+    folly::EvictingCacheMap<K, V> cache;
+    // mutable so we can take read locks in const methods
+    mutable MutexT lock;
+  };
+
+  size_t shardIndexFor(const K& key) const {
+    return folly::Hash()(key) % shards_.size();
+  }
+
+  Shard& shardFor(const K& key) {
+    return *shards_[shardIndexFor(key)];
+  }
+
+  void incrementVersion() {
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Shards are heap-allocated so the cache stays movable even though
+  // mutexes are not.
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // Version always starts at 1
+  std::atomic<CacheDataVersion> version_{kDefaultInitCacheDataVersion};
+};
+
+} // namespace wangle
+
+#include <wangle/client/persistence/ShardedLRUInMemoryCache-inl.h>
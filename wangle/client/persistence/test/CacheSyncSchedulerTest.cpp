@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <wangle/client/persistence/CacheSyncScheduler.h>
+
+using namespace std::chrono;
+using namespace wangle;
+
+TEST(CacheSyncSchedulerTest, RunsTaggedTasksAndTracksStats) {
+  CacheSyncScheduler::Options options;
+  options.maxSyncDelayJitter = milliseconds(0);
+  auto scheduler = CacheSyncScheduler::create(options);
+
+  auto execA = scheduler->getCacheExecutor("cacheA");
+  auto execB = scheduler->getCacheExecutor("cacheB");
+
+  folly::Baton<> done;
+  int runs = 0;
+  execA->add([&] { ++runs; });
+  execA->add([&] { ++runs; });
+  execB->add([&] {
+    ++runs;
+    done.post();
+  });
+  ASSERT_TRUE(done.try_wait_for(seconds(5)));
+
+  // The single worker runs tasks in order, so all three finished.
+  EXPECT_EQ(runs, 3);
+  auto statsA = scheduler->getCacheStats("cacheA");
+  ASSERT_TRUE(statsA.has_value());
+  EXPECT_EQ(statsA->scheduled, 2);
+  EXPECT_EQ(statsA->completed, 2);
+  EXPECT_EQ(statsA->backlog, 0);
+  auto statsB = scheduler->getCacheStats("cacheB");
+  ASSERT_TRUE(statsB.has_value());
+  EXPECT_EQ(statsB->scheduled, 1);
+  EXPECT_FALSE(scheduler->getCacheStats("unknown").has_value());
+}
+
+TEST(CacheSyncSchedulerTest, TokenBucketSpacesSyncStarts) {
+  CacheSyncScheduler::Options options;
+  options.maxSyncDelayJitter = milliseconds(0);
+  options.syncsPerSecond = 20;
+  options.maxBurstSyncs = 1;
+  auto scheduler = CacheSyncScheduler::create(options);
+  auto exec = scheduler->getCacheExecutor("cache");
+
+  auto start = steady_clock::now();
+  folly::Baton<> done;
+  for (int i = 0; i < 3; i++) {
+    exec->add([&, i] {
+      if (i == 2) {
+        done.post();
+      }
+    });
+  }
+  ASSERT_TRUE(done.try_wait_for(seconds(5)));
+
+  // The first sync spends the burst token; the next two each wait for a
+  // ~50ms refill.
+  EXPECT_GE(steady_clock::now() - start, milliseconds(90));
+}
+
+TEST(CacheSyncSchedulerTest, DrainsQueuedSyncsOnShutdown) {
+  CacheSyncScheduler::Options options;
+  // Deadlines far in the future; shutdown must run the tasks anyway.
+  options.maxSyncDelayJitter = milliseconds(60000);
+  auto scheduler = CacheSyncScheduler::create(options);
+  auto exec = scheduler->getCacheExecutor("cache");
+
+  int runs = 0;
+  exec->add([&] { ++runs; });
+  exec->add([&] { ++runs; });
+  scheduler.reset();
+  exec.reset();
+
+  EXPECT_EQ(runs, 2);
+}
@@ -292,6 +292,111 @@ TYPED_TEST(FilePersistentCacheTest, destroyAfterLoaded) {
   cache2.reset();
 }
 
+TEST(FilePersistenceLayer, compressedRoundTrip) {
+  string filename = getPersistentCacheFilename();
+  folly::dynamic data = folly::dynamic::array;
+  for (int i = 0; i < 50; ++i) {
+    data.push_back(folly::dynamic::array(
+        folly::to<string>("host", i, ".example.com"), "session-ticket"));
+  }
+
+  FilePersistenceLayer compressed(
+      filename, folly::io::COMPRESSION_LEVEL_DEFAULT);
+  EXPECT_TRUE(compressed.persist(data));
+
+  // the file on disk is the compressed format, not JSON
+  std::string raw;
+  EXPECT_TRUE(folly::readFile(filename.c_str(), raw));
+  EXPECT_FALSE(raw.empty());
+  EXPECT_EQ(raw[0], '\0');
+  EXPECT_LT(raw.size(), folly::toJson(data).size());
+
+  auto loaded = compressed.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(loaded.value(), data);
+
+  // a layer constructed without compression can still read it
+  FilePersistenceLayer plain(filename);
+  auto plainLoaded = plain.load();
+  ASSERT_TRUE(plainLoaded.hasValue());
+  EXPECT_EQ(plainLoaded.value(), data);
+
+  EXPECT_TRUE(unlink(filename.c_str()) != -1);
+}
+
+TEST(FilePersistenceLayer, salvagesValidPrefixAfterTruncation) {
+  string filename = getPersistentCacheFilename();
+  folly::dynamic data = folly::dynamic::array;
+  for (int i = 0; i < 10; ++i) {
+    data.push_back(
+        folly::dynamic::array(folly::to<string>("key", i), "value"));
+  }
+  FilePersistenceLayer layer(filename);
+  EXPECT_TRUE(layer.persist(data));
+
+  // chop bytes off the end, as if the process died mid-write
+  std::string raw;
+  ASSERT_TRUE(folly::readFile(filename.c_str(), raw));
+  raw.resize(raw.size() - 5);
+  ASSERT_TRUE(folly::writeFile(raw, filename.c_str()));
+
+  FilePersistenceLayer reloaded(filename);
+  auto loaded = reloaded.load();
+  ASSERT_TRUE(loaded.hasValue());
+  // everything but the record the crash cut short survives
+  ASSERT_EQ(9, loaded->size());
+  for (size_t i = 0; i < loaded->size(); ++i) {
+    EXPECT_EQ(data[i], (*loaded)[i]);
+  }
+  EXPECT_EQ(1, reloaded.getLoadCorruptionEvents());
+  EXPECT_GT(reloaded.getLoadBytesDropped(), 0);
+
+  EXPECT_TRUE(unlink(filename.c_str()) != -1);
+}
+
+TEST(FilePersistenceLayer, salvageStopsAtFlippedByte) {
+  string filename = getPersistentCacheFilename();
+  folly::dynamic data = folly::dynamic::array;
+  for (int i = 0; i < 10; ++i) {
+    data.push_back(
+        folly::dynamic::array(folly::to<string>("key", i), "value"));
+  }
+  FilePersistenceLayer layer(filename);
+  EXPECT_TRUE(layer.persist(data));
+
+  std::string raw;
+  ASSERT_TRUE(folly::readFile(filename.c_str(), raw));
+  raw[raw.size() / 2] ^= 0x1;
+  ASSERT_TRUE(folly::writeFile(raw, filename.c_str()));
+
+  FilePersistenceLayer reloaded(filename);
+  auto loaded = reloaded.load();
+  ASSERT_TRUE(loaded.hasValue());
+  // the prefix before the corrupt record loads, the rest is dropped
+  EXPECT_LT(loaded->size(), data.size());
+  EXPECT_EQ(1, reloaded.getLoadCorruptionEvents());
+  EXPECT_GT(reloaded.getLoadBytesDropped(), 0);
+
+  EXPECT_TRUE(unlink(filename.c_str()) != -1);
+}
+
+TEST(FilePersistenceLayer, compressedLayerLoadsUncompressedFile) {
+  string filename = getPersistentCacheFilename();
+  folly::dynamic data =
+      folly::dynamic::array(folly::dynamic::array("key1", "value1"));
+
+  FilePersistenceLayer plain(filename);
+  EXPECT_TRUE(plain.persist(data));
+
+  FilePersistenceLayer compressed(
+      filename, folly::io::COMPRESSION_LEVEL_DEFAULT);
+  auto loaded = compressed.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(loaded.value(), data);
+
+  EXPECT_TRUE(unlink(filename.c_str()) != -1);
+}
+
 TYPED_TEST(FilePersistentCacheTest, threadstress) {
   // make sure no errors crop up when hitting the same cache
   // with multiple threads
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+
+#include <folly/FileUtil.h>
+#include <folly/lang/Bits.h>
+#include <folly/portability/GTest.h>
+#include <wangle/client/persistence/JournalPersistenceLayer.h>
+#include <wangle/client/persistence/test/TestUtil.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+dynamic makeKvPairs(const std::map<std::string, std::string>& entries) {
+  dynamic result = dynamic::array;
+  for (const auto& kv : entries) {
+    result.push_back(dynamic::array(kv.first, kv.second));
+  }
+  return result;
+}
+
+std::map<std::string, std::string> toMap(const dynamic& kvPairs) {
+  std::map<std::string, std::string> result;
+  for (const auto& kv : kvPairs) {
+    result[kv[0].asString()] = kv[1].asString();
+  }
+  return result;
+}
+
+} // namespace
+
+class JournalPersistenceLayerTest : public testing::Test {
+ protected:
+  std::string filename_{getPersistentCacheFilename()};
+};
+
+TEST_F(JournalPersistenceLayerTest, PersistLoadRoundTrip) {
+  std::map<std::string, std::string> entries{{"k1", "v1"}, {"k2", "v2"}};
+  {
+    JournalPersistenceLayer layer(filename_);
+    EXPECT_TRUE(layer.persist(makeKvPairs(entries)));
+  }
+
+  JournalPersistenceLayer layer(filename_);
+  auto loaded = layer.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(toMap(*loaded), entries);
+}
+
+TEST_F(JournalPersistenceLayerTest, DeltasAreAppended) {
+  JournalPersistenceLayer layer(filename_);
+  std::map<std::string, std::string> entries{{"k1", "v1"}};
+  EXPECT_TRUE(layer.persist(makeKvPairs(entries)));
+
+  // Overwrite one key, add one, remove one across a few persists
+  entries["k2"] = "v2";
+  EXPECT_TRUE(layer.persist(makeKvPairs(entries)));
+  entries["k1"] = "v1b";
+  EXPECT_TRUE(layer.persist(makeKvPairs(entries)));
+  entries.erase("k2");
+  EXPECT_TRUE(layer.persist(makeKvPairs(entries)));
+
+  JournalPersistenceLayer reloaded(filename_);
+  auto loaded = reloaded.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(toMap(*loaded), entries);
+}
+
+TEST_F(JournalPersistenceLayerTest, TruncatedTailIsDropped) {
+  std::map<std::string, std::string> entries{{"k1", "v1"}, {"k2", "v2"}};
+  {
+    JournalPersistenceLayer layer(filename_);
+    EXPECT_TRUE(layer.persist(makeKvPairs(entries)));
+  }
+
+  // Chop a few bytes off the end, as if the process died mid-append
+  std::string journal;
+  ASSERT_TRUE(readFile(filename_.c_str(), journal));
+  journal.resize(journal.size() - 3);
+  ASSERT_TRUE(writeFile(journal, filename_.c_str()));
+
+  JournalPersistenceLayer layer(filename_);
+  auto loaded = layer.load();
+  ASSERT_TRUE(loaded.hasValue());
+  // One full record survives
+  EXPECT_EQ(1, loaded->size());
+}
+
+TEST_F(JournalPersistenceLayerTest, ChecksumFailureDropsSuffix) {
+  {
+    JournalPersistenceLayer layer(filename_);
+    EXPECT_TRUE(layer.persist(makeKvPairs({{"k1", "v1"}})));
+    EXPECT_TRUE(layer.persist(makeKvPairs({{"k1", "v1"}, {"k2", "v2"}})));
+  }
+
+  // Flip a bit in the appended record's checksum
+  std::string journal;
+  ASSERT_TRUE(readFile(filename_.c_str(), journal));
+  journal[journal.size() - 2] ^= 0x1;
+  ASSERT_TRUE(writeFile(journal, filename_.c_str()));
+
+  JournalPersistenceLayer layer(filename_);
+  auto loaded = layer.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(
+      toMap(*loaded), (std::map<std::string, std::string>{{"k1", "v1"}}));
+  EXPECT_EQ(1, layer.getLoadCorruptionEvents());
+  EXPECT_GT(layer.getLoadBytesDropped(), 0);
+}
+
+TEST_F(JournalPersistenceLayerTest, LegacyJournalLoadsAndUpgrades) {
+  // Hand-build a journal in the pre-checksum format: no file header and
+  // no per-record crc.
+  std::string legacy;
+  auto appendLegacyPut = [&](const std::string& key, const std::string& val) {
+    legacy.push_back('\x01');
+    uint32_t len = Endian::little<uint32_t>(key.size());
+    legacy.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    legacy.append(key);
+    len = Endian::little<uint32_t>(val.size());
+    legacy.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    legacy.append(val);
+  };
+  appendLegacyPut("\"k1\"", "\"v1\"");
+  ASSERT_TRUE(writeFile(legacy, filename_.c_str()));
+
+  JournalPersistenceLayer layer(filename_);
+  auto loaded = layer.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(
+      toMap(*loaded), (std::map<std::string, std::string>{{"k1", "v1"}}));
+
+  // The next persist rewrites the journal in the checksummed format
+  EXPECT_TRUE(layer.persist(makeKvPairs({{"k1", "v1"}, {"k2", "v2"}})));
+  std::string upgraded;
+  ASSERT_TRUE(readFile(filename_.c_str(), upgraded));
+  ASSERT_FALSE(upgraded.empty());
+  EXPECT_EQ('\0', upgraded[0]);
+
+  JournalPersistenceLayer reloaded(filename_);
+  auto reloadedData = reloaded.load();
+  ASSERT_TRUE(reloadedData.hasValue());
+  EXPECT_EQ(
+      toMap(*reloadedData),
+      (std::map<std::string, std::string>{{"k1", "v1"}, {"k2", "v2"}}));
+}
+
+TEST_F(JournalPersistenceLayerTest, ClearRemovesJournal) {
+  JournalPersistenceLayer layer(filename_);
+  EXPECT_TRUE(layer.persist(makeKvPairs({{"k1", "v1"}})));
+  layer.clear();
+  EXPECT_FALSE(layer.load().hasValue());
+}
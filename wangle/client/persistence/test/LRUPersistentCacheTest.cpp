@@ -485,6 +485,108 @@ TYPED_TEST(LRUPersistentCacheTest, EmptyPersistenceMatchesEmptyCache) {
   EXPECT_TRUE(cache->hasPendingUpdates());
 }
 
+TYPED_TEST(LRUPersistentCacheTest, BatchOpsRoundTrip) {
+  auto cache = createCache<TypeParam>(10, 10, nullptr);
+  cache->init();
+  cache->putMany({{"k0", "v0"}, {"k1", "v1"}, {"k2", "v2"}});
+  EXPECT_EQ(cache->size(), 3);
+
+  auto values = cache->getMany({"k1", "missing", "k0"});
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0].value(), "v1");
+  EXPECT_FALSE(values[1].hasValue());
+  EXPECT_EQ(values[2].value(), "v0");
+
+  size_t visited = 0;
+  bool sawK2 = false;
+  cache->forEach([&](const string& key, const string& val) {
+    visited++;
+    sawK2 |= (key == "k2" && val == "v2");
+  });
+  EXPECT_EQ(visited, 3);
+  EXPECT_TRUE(sawK2);
+}
+
+TYPED_TEST(LRUPersistentCacheTest, BatchPutSyncsOnce) {
+  EXPECT_CALL(*this->persistence, load_())
+      .Times(1)
+      .WillOnce(Return(dynamic::array()));
+  auto rawPersistence = this->persistence.get();
+  auto cache = createCacheWithExecutor<TypeParam>(
+      this->inlineExecutor,
+      std::move(this->persistence),
+      std::chrono::milliseconds::zero(),
+      1);
+  cache->init();
+  EXPECT_CALL(*rawPersistence, getLastPersistedVersion())
+      .WillRepeatedly(Invoke(
+          rawPersistence,
+          &MockPersistenceLayer::getLastPersistedVersionConcrete));
+  // The batch is one version change, so it lands in a single sync.
+  EXPECT_CALL(*rawPersistence, persist_(DynSize(3)))
+      .Times(1)
+      .WillOnce(Return(true));
+  cache->putMany({{"k0", "v0"}, {"k1", "v1"}, {"k2", "v2"}});
+  cache.reset();
+}
+
+TYPED_TEST(LRUPersistentCacheTest, TtlEntryExpires) {
+  auto cache = createCache<TypeParam>(10, 10, nullptr);
+  cache->init();
+  cache->put("k0", "v0", std::chrono::milliseconds(1));
+  cache->put("k1", "v1", std::chrono::hours(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(cache->get("k0").hasValue());
+  EXPECT_TRUE(cache->get("k1").hasValue());
+}
+
+TYPED_TEST(LRUPersistentCacheTest, TtlSerializedWithDeadline) {
+  EXPECT_CALL(*this->persistence, load_())
+      .Times(1)
+      .WillOnce(Return(dynamic::array()));
+  auto rawPersistence = this->persistence.get();
+  auto cache = createCacheWithExecutor<TypeParam>(
+      this->inlineExecutor,
+      std::move(this->persistence),
+      std::chrono::milliseconds::zero(),
+      1);
+  cache->init();
+  EXPECT_CALL(*rawPersistence, getLastPersistedVersion())
+      .WillRepeatedly(Invoke(
+          rawPersistence,
+          &MockPersistenceLayer::getLastPersistedVersionConcrete));
+  EXPECT_CALL(*rawPersistence, persist_(_))
+      .WillRepeatedly(Invoke([](const dynamic& obj) {
+        EXPECT_EQ(obj.size(), 1);
+        // ttl entries carry the absolute deadline as a third element
+        EXPECT_EQ(obj[0].size(), 3);
+        EXPECT_GT(obj[0][2].asInt(), 0);
+        return true;
+      }));
+  cache->put("k0", "v0", std::chrono::hours(1));
+  cache.reset();
+}
+
+TYPED_TEST(LRUPersistentCacheTest, TtlExpiredEntriesNotResurrected) {
+  auto farFuture =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count() +
+      3600 * 1000;
+  // k1 expired long ago; k2 is still live; k3 has no ttl
+  folly::dynamic data = dynamic::array(
+      dynamic::array("k1", "v1", 1),
+      dynamic::array("k2", "v2", farFuture),
+      dynamic::array("k3", "v3"));
+  EXPECT_CALL(*this->persistence, load_()).Times(1).WillOnce(Return(data));
+  auto cache = createCache<TypeParam>(10, 10, std::move(this->persistence));
+  cache->init();
+  EXPECT_EQ(cache->size(), 2);
+  EXPECT_FALSE(cache->get("k1").hasValue());
+  EXPECT_EQ(cache->get("k2").value(), "v2");
+  EXPECT_EQ(cache->get("k3").value(), "v3");
+}
+
 TYPED_TEST(LRUPersistentCacheTest, ZeroSyncIntervalSyncsImmediately) {
   EXPECT_CALL(*this->persistence, load_())
       .Times(1)
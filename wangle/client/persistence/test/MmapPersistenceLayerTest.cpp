@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <wangle/client/persistence/MmapPersistenceLayer.h>
+#include <wangle/client/persistence/test/TestUtil.h>
+
+using namespace folly;
+using namespace wangle;
+
+class MmapPersistenceLayerTest : public testing::Test {
+ protected:
+  std::string filename_{getPersistentCacheFilename()};
+};
+
+TEST_F(MmapPersistenceLayerTest, PersistLoadRoundTrip) {
+  dynamic kvPairs = dynamic::array(
+      dynamic::array("k1", "v1"),
+      dynamic::array("k2", dynamic::object("nested", 42)),
+      dynamic::array(7, "non-string key"));
+  {
+    MmapPersistenceLayer layer(filename_);
+    EXPECT_TRUE(layer.persist(kvPairs));
+  }
+
+  MmapPersistenceLayer layer(filename_);
+  auto loaded = layer.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(*loaded, kvPairs);
+}
+
+TEST_F(MmapPersistenceLayerTest, EmptyCache) {
+  MmapPersistenceLayer layer(filename_);
+  EXPECT_TRUE(layer.persist(dynamic::array));
+  auto loaded = layer.load();
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(0, loaded->size());
+}
+
+TEST_F(MmapPersistenceLayerTest, MissingFile) {
+  MmapPersistenceLayer layer(filename_ + ".nonexistent");
+  EXPECT_FALSE(layer.load().hasValue());
+}
+
+TEST_F(MmapPersistenceLayerTest, RejectsCorruptImage) {
+  {
+    MmapPersistenceLayer layer(filename_);
+    EXPECT_TRUE(layer.persist(dynamic::array(dynamic::array("k1", "v1"))));
+  }
+
+  std::string image;
+  ASSERT_TRUE(readFile(filename_.c_str(), image));
+
+  // Bad magic
+  auto bad = image;
+  bad[0] = 'X';
+  ASSERT_TRUE(writeFile(bad, filename_.c_str()));
+  {
+    MmapPersistenceLayer layer(filename_);
+    EXPECT_FALSE(layer.load().hasValue());
+  }
+
+  // Truncated record area
+  bad = image;
+  bad.resize(bad.size() - 2);
+  ASSERT_TRUE(writeFile(bad, filename_.c_str()));
+  {
+    MmapPersistenceLayer layer(filename_);
+    EXPECT_FALSE(layer.load().hasValue());
+  }
+}
+
+TEST_F(MmapPersistenceLayerTest, ClearRemovesImage) {
+  MmapPersistenceLayer layer(filename_);
+  EXPECT_TRUE(layer.persist(dynamic::array(dynamic::array("k1", "v1"))));
+  layer.clear();
+  EXPECT_FALSE(layer.load().hasValue());
+}
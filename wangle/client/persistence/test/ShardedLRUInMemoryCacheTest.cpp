@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+#include <wangle/client/persistence/ShardedLRUInMemoryCache.h>
+
+using namespace folly;
+using namespace wangle;
+
+using TestCache = ShardedLRUInMemoryCache<std::string, std::string, std::mutex>;
+
+TEST(ShardedLRUInMemoryCache, BasicOps) {
+  TestCache cache(100, 4);
+
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.get("a").hasValue());
+
+  cache.put("a", "1");
+  cache.put("b", "2");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.get("a").value(), "1");
+  EXPECT_EQ(cache.get("b").value(), "2");
+
+  EXPECT_TRUE(cache.remove("a"));
+  EXPECT_FALSE(cache.remove("a"));
+  EXPECT_FALSE(cache.get("a").hasValue());
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(ShardedLRUInMemoryCache, VersionSemantics) {
+  TestCache cache(100, 4);
+
+  auto version = cache.getVersion();
+  EXPECT_EQ(version, kDefaultInitCacheDataVersion);
+  EXPECT_FALSE(cache.hasChangedSince(version));
+
+  cache.put("a", "1");
+  EXPECT_TRUE(cache.hasChangedSince(version));
+  version = cache.getVersion();
+
+  // A miss is not a change.
+  cache.get("missing");
+  EXPECT_FALSE(cache.hasChangedSince(version));
+
+  // Removing a missing key is not a change either.
+  cache.remove("missing");
+  EXPECT_FALSE(cache.hasChangedSince(version));
+
+  cache.remove("a");
+  EXPECT_TRUE(cache.hasChangedSince(version));
+  version = cache.getVersion();
+
+  // Clearing an empty cache is a no-op.
+  cache.clear();
+  EXPECT_FALSE(cache.hasChangedSince(version));
+}
+
+TEST(ShardedLRUInMemoryCache, BatchOps) {
+  TestCache cache(100, 4);
+
+  std::vector<std::pair<std::string, std::string>> kvs;
+  for (int i = 0; i < 20; i++) {
+    kvs.emplace_back(to<std::string>("key", i), to<std::string>("value", i));
+  }
+  auto version = cache.getVersion();
+  cache.putMany(kvs);
+  EXPECT_EQ(cache.size(), 20);
+  // The whole batch is one change as far as sync is concerned.
+  EXPECT_EQ(cache.getVersion(), version + 1);
+
+  auto values = cache.getMany({"key3", "nope", "key17"});
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0].value(), "value3");
+  EXPECT_FALSE(values[1].hasValue());
+  EXPECT_EQ(values[2].value(), "value17");
+  // Lookups, hit or miss, are not changes.
+  EXPECT_EQ(cache.getVersion(), version + 1);
+
+  size_t visited = 0;
+  bool sawKey7 = false;
+  cache.forEach([&](const std::string& key, const std::string& val) {
+    visited++;
+    sawKey7 |= (key == "key7" && val == "value7");
+  });
+  EXPECT_EQ(visited, 20);
+  EXPECT_TRUE(sawKey7);
+}
+
+TEST(ShardedLRUInMemoryCache, EvictionIsBounded) {
+  TestCache cache(64, 4, 8);
+
+  for (int i = 0; i < 1000; i++) {
+    cache.put(folly::to<std::string>(i), "v");
+  }
+  // Per-shard capacity bounds the total; eviction batches may leave
+  // each shard up to a batch below full.
+  EXPECT_LE(cache.size(), 64);
+  EXPECT_GE(cache.size(), 64 - 4 * 8);
+}
+
+TEST(ShardedLRUInMemoryCache, KeyValuePairRoundTrip) {
+  TestCache cache(100, 4);
+  cache.put("a", "1");
+  cache.put("b", "2");
+
+  auto kvPairs = cache.convertToKeyValuePairs();
+  ASSERT_TRUE(kvPairs.hasValue());
+  EXPECT_EQ(kvPairs->first.size(), 2);
+  EXPECT_EQ(kvPairs->second, cache.getVersion());
+
+  TestCache other(100, 4);
+  auto version = other.loadData(kvPairs->first);
+  EXPECT_EQ(version, other.getVersion());
+  EXPECT_EQ(other.get("a").value(), "1");
+  EXPECT_EQ(other.get("b").value(), "2");
+}
+
+TEST(ShardedLRUInMemoryCache, ConcurrentPutGet) {
+  TestCache cache(1024, 8);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t] {
+      for (int i = 0; i < 1000; i++) {
+        auto key = folly::to<std::string>(t, ":", i % 64);
+        cache.put(key, folly::to<std::string>(i));
+        EXPECT_TRUE(cache.get(key).hasValue());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(cache.size(), 4 * 64);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/client/ssl/ClientSSLSessionCache.h>
+
+using folly::SharedMutex;
+
+namespace wangle {
+
+void ClientSSLSessionCache::put(
+    const std::string& key,
+    std::shared_ptr<folly::ssl::SSLSession> session) {
+  if (!session) {
+    return;
+  }
+  SharedMutex::WriteHolder lock(mutex_);
+  sessions_.set(key, std::move(session));
+}
+
+std::shared_ptr<folly::ssl::SSLSession> ClientSSLSessionCache::get(
+    const std::string& key) {
+  // A write lock even on lookup: a hit moves the entry to the head of
+  // the LRU list.
+  SharedMutex::WriteHolder lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it == sessions_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+bool ClientSSLSessionCache::remove(const std::string& key) {
+  SharedMutex::WriteHolder lock(mutex_);
+  return sessions_.erase(key) > 0;
+}
+
+size_t ClientSSLSessionCache::size() const {
+  SharedMutex::ReadHolder lock(mutex_);
+  return sessions_.size();
+}
+
+} // namespace wangle
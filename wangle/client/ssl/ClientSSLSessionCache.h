@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/SharedMutex.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/ssl/SSLSession.h>
+
+#include <memory>
+#include <string>
+
+namespace wangle {
+
+/**
+ * A thread-safe cache of established client TLS sessions, keyed by the
+ * dialed destination. It stores the transport-agnostic
+ * folly::ssl::SSLSession, so OpenSSL sessions and fizz psks cache the
+ * same way. Attach one to a BaseClientBootstrap with sslSessionCache()
+ * and reconnects resume automatically, with no manual session plumbing
+ * around connect().
+ *
+ * The cache holds at most maxSessions entries, evicting in LRU order;
+ * a get() refreshes the entry it finds.
+ */
+class ClientSSLSessionCache {
+ public:
+  explicit ClientSSLSessionCache(size_t maxSessions = 10240)
+      : sessions_(maxSessions) {}
+
+  void put(
+      const std::string& key,
+      std::shared_ptr<folly::ssl::SSLSession> session);
+
+  std::shared_ptr<folly::ssl::SSLSession> get(const std::string& key);
+
+  bool remove(const std::string& key);
+
+  size_t size() const;
+
+ private:
+  mutable folly::SharedMutex mutex_;
+  folly::EvictingCacheMap<std::string, std::shared_ptr<folly::ssl::SSLSession>>
+      sessions_;
+};
+
+} // namespace wangle
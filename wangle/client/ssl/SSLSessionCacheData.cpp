@@ -17,8 +17,83 @@
 //
 #include <wangle/client/ssl/SSLSessionCacheData.h>
 
+#include <folly/lang/Bits.h>
+
 using namespace std::chrono;
 
+namespace wangle {
+
+namespace {
+
+template <typename T>
+void appendLE(folly::fbstring& out, T value) {
+  T le = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+void appendBlob(folly::fbstring& out, const folly::fbstring& blob) {
+  appendLE(out, static_cast<uint32_t>(blob.size()));
+  out.append(blob.data(), blob.size());
+}
+
+template <typename T>
+bool readLE(folly::ByteRange& in, T& value) {
+  if (in.size() < sizeof(T)) {
+    return false;
+  }
+  value = folly::Endian::little(folly::loadUnaligned<T>(in.data()));
+  in.advance(sizeof(T));
+  return true;
+}
+
+bool readBlob(folly::ByteRange& in, folly::fbstring& out) {
+  uint32_t len = 0;
+  if (!readLE(in, len) || in.size() < len) {
+    return false;
+  }
+  out.assign(reinterpret_cast<const char*>(in.data()), len);
+  in.advance(len);
+  return true;
+}
+
+} // namespace
+
+folly::fbstring serializeSSLSessionCacheData(const SSLSessionCacheData& data) {
+  folly::fbstring out;
+  out.reserve(
+      sizeof(uint8_t) + sizeof(int64_t) + 3 * sizeof(uint32_t) +
+      data.sessionData.size() + data.serviceIdentity.size() +
+      data.peerIdentities.size());
+  out.push_back(static_cast<char>(kSSLSessionCacheDataVersion));
+  appendLE(
+      out, static_cast<int64_t>(data.addedTime.time_since_epoch().count()));
+  appendBlob(out, data.sessionData);
+  appendBlob(out, data.serviceIdentity);
+  appendBlob(out, data.peerIdentities);
+  return out;
+}
+
+folly::Optional<SSLSessionCacheData> deserializeSSLSessionCacheData(
+    folly::ByteRange record) {
+  if (record.empty() || record.front() != kSSLSessionCacheDataVersion) {
+    return folly::none;
+  }
+  record.advance(1);
+
+  SSLSessionCacheData data;
+  int64_t addedTime = 0;
+  if (!readLE(record, addedTime) || !readBlob(record, data.sessionData) ||
+      !readBlob(record, data.serviceIdentity) ||
+      !readBlob(record, data.peerIdentities) || !record.empty()) {
+    return folly::none;
+  }
+  data.addedTime =
+      system_clock::time_point(system_clock::duration(addedTime));
+  return data;
+}
+
+} // namespace wangle
+
 namespace folly {
 
 template <>
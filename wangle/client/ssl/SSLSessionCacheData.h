@@ -21,6 +21,8 @@
 
 #include <folly/DynamicConverter.h>
 #include <folly/FBString.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
 #include <folly/ssl/OpenSSLPtrTypes.h>
 
 namespace wangle {
@@ -33,6 +35,30 @@ struct SSLSessionCacheData {
   folly::fbstring peerIdentities;
 };
 
+/**
+ * Compact binary codec for SSLSessionCacheData, for persistent stores that
+ * want to avoid the folly::dynamic/JSON round trip. Record layout, all
+ * integers little-endian:
+ *
+ *   uint8_t  version (kSSLSessionCacheDataVersion)
+ *   int64_t  addedTime, as system_clock duration ticks since epoch
+ *   uint32_t sessionData length, followed by that many bytes of DER
+ *   uint32_t serviceIdentity length, followed by the bytes
+ *   uint32_t peerIdentities length, followed by the bytes
+ *
+ * sessionDuplicateTemplate is a process-local handle and is not persisted,
+ * matching the folly::dynamic conversion.
+ */
+constexpr uint8_t kSSLSessionCacheDataVersion = 1;
+
+folly::fbstring serializeSSLSessionCacheData(const SSLSessionCacheData& data);
+
+/**
+ * Returns folly::none for an unknown version or a truncated/overlong record.
+ */
+folly::Optional<SSLSessionCacheData> deserializeSSLSessionCacheData(
+    folly::ByteRange record);
+
 } // namespace wangle
 
 namespace folly {
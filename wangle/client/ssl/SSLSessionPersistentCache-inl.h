@@ -18,13 +18,29 @@
 
 #include <wangle/client/ssl/SSLSessionCacheUtils.h>
 
+#include <mutex>
+
 #include <folly/Memory.h>
+#include <folly/container/F14Map.h>
 #include <folly/io/IOBuf.h>
 #include <folly/portability/OpenSSL.h>
 #include <wangle/client/persistence/FilePersistentCache.h>
 
 namespace wangle {
 
+template <typename K>
+struct SSLSessionPersistentCacheBase<K>::WriteBehindState {
+  struct PendingWrite {
+    folly::ssl::SSLSessionUniquePtr session;
+    std::chrono::time_point<std::chrono::system_clock> addedTime;
+  };
+
+  std::mutex mutex;
+  folly::F14FastMap<K, PendingWrite> pending;
+  bool drainScheduled{false};
+  std::shared_ptr<PersistentCache<K, SSLSessionCacheData>> cache;
+};
+
 template <typename K>
 SSLSessionPersistentCacheBase<K>::SSLSessionPersistentCacheBase(
     std::shared_ptr<PersistentCache<K, SSLSessionCacheData>> cache)
@@ -39,6 +55,25 @@ SSLSessionPersistentCacheBase<K>::SSLSessionPersistentCacheBase(
               filename,
               std::move(config))) {}
 
+template <typename K>
+SSLSessionPersistentCacheBase<K>::~SSLSessionPersistentCacheBase() {
+  if (writeBehind_) {
+    // Flush whatever the executor has not picked up yet; a drain
+    // already running holds its own reference to the state.
+    drainWriteBehind(writeBehind_);
+  }
+}
+
+template <typename K>
+void SSLSessionPersistentCacheBase<K>::setWriteBehindExecutor(
+    std::shared_ptr<folly::Executor> executor) {
+  writeBehindExecutor_ = std::move(executor);
+  if (writeBehindExecutor_ && !writeBehind_) {
+    writeBehind_ = std::make_shared<WriteBehindState>();
+    writeBehind_->cache = persistentCache_;
+  }
+}
+
 template <typename K>
 void SSLSessionPersistentCacheBase<K>::setSSLSession(
     const std::string& identity,
@@ -47,6 +82,28 @@ void SSLSessionPersistentCacheBase<K>::setSSLSession(
     return;
   }
 
+  if (writeBehindExecutor_) {
+    // Park the raw session and return; serialization is deferred to the
+    // executor, off the handshake's critical path. A newer session for
+    // the same identity simply replaces the parked one.
+    bool schedule = false;
+    {
+      std::lock_guard<std::mutex> guard(writeBehind_->mutex);
+      auto& write = writeBehind_->pending[getKey(identity)];
+      write.session = std::move(session);
+      write.addedTime = timeUtil_->now();
+      if (!writeBehind_->drainScheduled) {
+        writeBehind_->drainScheduled = true;
+        schedule = true;
+      }
+    }
+    if (schedule) {
+      writeBehindExecutor_->add(
+          [state = writeBehind_]() { drainWriteBehind(state); });
+    }
+    return;
+  }
+
   // We do not cache the session itself, but cache the session data from it in
   // order to recreate a new session later.
   auto sessionCacheData = getCacheDataForSession(session.get());
@@ -57,10 +114,42 @@ void SSLSessionPersistentCacheBase<K>::setSSLSession(
   }
 }
 
+template <typename K>
+void SSLSessionPersistentCacheBase<K>::drainWriteBehind(
+    const std::shared_ptr<WriteBehindState>& state) {
+  while (true) {
+    folly::F14FastMap<K, typename WriteBehindState::PendingWrite> batch;
+    {
+      std::lock_guard<std::mutex> guard(state->mutex);
+      if (state->pending.empty()) {
+        state->drainScheduled = false;
+        return;
+      }
+      batch.swap(state->pending);
+    }
+    for (auto& it : batch) {
+      auto sessionCacheData = getCacheDataForSession(it.second.session.get());
+      if (sessionCacheData) {
+        sessionCacheData->addedTime = it.second.addedTime;
+        state->cache->put(it.first, *sessionCacheData);
+      }
+    }
+  }
+}
+
 template <typename K>
 folly::ssl::SSLSessionUniquePtr SSLSessionPersistentCacheBase<K>::getSSLSession(
     const std::string& identity) const noexcept {
   auto key = getKey(identity);
+  if (writeBehind_) {
+    // A parked session not yet persisted is still the freshest one.
+    std::lock_guard<std::mutex> guard(writeBehind_->mutex);
+    auto pending = writeBehind_->pending.find(key);
+    if (pending != writeBehind_->pending.end()) {
+      return folly::ssl::SSLSessionUniquePtr(
+          cloneSSLSession(pending->second.session.get()));
+    }
+  }
   auto hit = persistentCache_->get(key);
   if (!hit) {
     return nullptr;
@@ -90,7 +179,12 @@ template <typename K>
 bool SSLSessionPersistentCacheBase<K>::removeSSLSession(
     const std::string& identity) noexcept {
   auto key = getKey(identity);
-  return persistentCache_->remove(key);
+  bool removedPending = false;
+  if (writeBehind_) {
+    std::lock_guard<std::mutex> guard(writeBehind_->mutex);
+    removedPending = writeBehind_->pending.erase(key) > 0;
+  }
+  return persistentCache_->remove(key) || removedPending;
 }
 
 template <typename K>
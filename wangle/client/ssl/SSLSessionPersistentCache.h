@@ -55,6 +55,8 @@ class SSLSessionPersistentCacheBase : public SSLSessionCallbacks {
       const std::string& filename,
       PersistentCacheConfig config);
 
+  ~SSLSessionPersistentCacheBase() override;
+
   // Store the session data of the specified identity in cache. Note that the
   // implementation must make it's own memory copy of the session data to put
   // into the cache.
@@ -82,6 +84,22 @@ class SSLSessionPersistentCacheBase : public SSLSessionCallbacks {
     timeUtil_ = std::move(timeUtil);
   }
 
+  /**
+   * Persist sessions through the given executor instead of inline.
+   *
+   * setSSLSession runs inside OpenSSL's new-session callback, on the
+   * connection's thread right as the handshake completes. With an
+   * executor set it only parks the session in a pending map; the
+   * executor later serializes and stores the batch, and repeated
+   * updates for the same identity coalesce so only the latest session
+   * is ever serialized. Lookups and removals consult the pending map,
+   * and leftover writes are flushed on destruction.
+   *
+   * Set this before the cache is attached to a context; it must not
+   * change while handshakes are in flight.
+   */
+  void setWriteBehindExecutor(std::shared_ptr<folly::Executor> executor);
+
   // For test only, returns the number of entries in the cache.
   size_t size() const override;
 
@@ -91,6 +109,17 @@ class SSLSessionPersistentCacheBase : public SSLSessionCallbacks {
 
   std::shared_ptr<PersistentCache<K, SSLSessionCacheData>> persistentCache_;
   std::unique_ptr<TimeUtil> timeUtil_;
+
+ private:
+  struct WriteBehindState;
+
+  // Runs on the write-behind executor (and once more on destruction);
+  // deliberately takes only the shared state so it cannot outlive-race
+  // the cache itself.
+  static void drainWriteBehind(const std::shared_ptr<WriteBehindState>& state);
+
+  std::shared_ptr<folly::Executor> writeBehindExecutor_;
+  std::shared_ptr<WriteBehindState> writeBehind_;
 };
 
 class SSLSessionPersistentCache
@@ -23,18 +23,50 @@ namespace wangle {
 void ThreadSafeSSLSessionCache::setSSLSession(
     const std::string& identity,
     folly::ssl::SSLSessionUniquePtr session) noexcept {
+  if (flushThreshold_ > 1) {
+    auto& pending = *pendingWrites_;
+    for (auto& entry : pending.entries) {
+      if (entry.first == identity) {
+        entry.second = std::move(session);
+        return;
+      }
+    }
+    pending.entries.emplace_back(identity, std::move(session));
+    if (pending.entries.size() >= flushThreshold_) {
+      flushPendingWrites(pending);
+    }
+    return;
+  }
   SharedMutex::WriteHolder lock(mutex_);
   delegate_->setSSLSession(identity, std::move(session));
 }
 
 folly::ssl::SSLSessionUniquePtr ThreadSafeSSLSessionCache::getSSLSession(
     const std::string& identity) const noexcept {
+  if (flushThreshold_ > 1) {
+    for (auto& entry : pendingWrites_->entries) {
+      if (entry.first == identity) {
+        // Hand out a copy so the entry stays pending until published.
+        return folly::ssl::SSLSessionUniquePtr(
+            cloneSSLSession(entry.second.get()));
+      }
+    }
+  }
   SharedMutex::ReadHolder lock(mutex_);
   return delegate_->getSSLSession(identity);
 }
 
 bool ThreadSafeSSLSessionCache::removeSSLSession(
     const std::string& identity) noexcept {
+  if (flushThreshold_ > 1) {
+    auto& entries = pendingWrites_->entries;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      if (it->first == identity) {
+        entries.erase(it);
+        break;
+      }
+    }
+  }
   SharedMutex::WriteHolder lock(mutex_);
   return delegate_->removeSSLSession(identity);
 }
@@ -49,4 +81,12 @@ size_t ThreadSafeSSLSessionCache::size() const {
   return delegate_->size();
 }
 
+void ThreadSafeSSLSessionCache::flushPendingWrites(PendingWrites& pending) {
+  SharedMutex::WriteHolder lock(mutex_);
+  for (auto& entry : pending.entries) {
+    delegate_->setSSLSession(entry.first, std::move(entry.second));
+  }
+  pending.entries.clear();
+}
+
 } // namespace wangle
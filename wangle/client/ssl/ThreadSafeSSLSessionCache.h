@@ -20,6 +20,10 @@
 #include <wangle/client/ssl/SSLSessionCallbacks.h>
 
 #include <folly/SharedMutex.h>
+#include <folly/ThreadLocal.h>
+
+#include <utility>
+#include <vector>
 
 namespace wangle {
 
@@ -34,6 +38,22 @@ class ThreadSafeSSLSessionCache : public SSLSessionCallbacks {
       std::unique_ptr<SSLSessionCallbacks> delegate)
       : delegate_(std::move(delegate)) {}
 
+  /**
+   * Buffer session writes thread-locally and publish them to the
+   * delegate in batches of flushThreshold, so the write lock is taken
+   * once per batch instead of once per handshake. Lookups consult the
+   * calling thread's unpublished entries first, so a session captured
+   * on a thread is immediately resumable from that thread; entries
+   * pending on other threads become visible once those threads publish.
+   * size() only counts published entries, and entries still pending
+   * when the cache or a thread goes away are dropped (the cache is
+   * best-effort either way). Values below 2 restore immediate writes.
+   * Call before the cache is shared across threads.
+   */
+  void setDeferredWrites(size_t flushThreshold) {
+    flushThreshold_ = flushThreshold;
+  }
+
   // From SSLSessionCallbacks
   void setSSLSession(
       const std::string& identity,
@@ -45,8 +65,17 @@ class ThreadSafeSSLSessionCache : public SSLSessionCallbacks {
   size_t size() const override;
 
  private:
+  struct PendingWrites {
+    std::vector<std::pair<std::string, folly::ssl::SSLSessionUniquePtr>>
+        entries;
+  };
+
+  void flushPendingWrites(PendingWrites& pending);
+
   std::unique_ptr<SSLSessionCallbacks> delegate_;
   mutable folly::SharedMutex mutex_;
+  size_t flushThreshold_{0};
+  mutable folly::ThreadLocal<PendingWrites> pendingWrites_;
 };
 
 } // namespace wangle
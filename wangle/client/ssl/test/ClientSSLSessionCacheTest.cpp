@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/client/ssl/ClientSSLSessionCache.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+namespace {
+
+// The cache only hands the session back out, so an opaque token will do.
+class FakeSession : public folly::ssl::SSLSession {};
+
+std::shared_ptr<folly::ssl::SSLSession> makeSession() {
+  return std::make_shared<FakeSession>();
+}
+
+} // namespace
+
+TEST(ClientSSLSessionCacheTest, PutGetRemove) {
+  ClientSSLSessionCache cache;
+  auto session = makeSession();
+
+  EXPECT_EQ(nullptr, cache.get("example.com:443"));
+  cache.put("example.com:443", session);
+  EXPECT_EQ(session, cache.get("example.com:443"));
+  EXPECT_EQ(nullptr, cache.get("other.com:443"));
+  EXPECT_EQ(1, cache.size());
+
+  EXPECT_TRUE(cache.remove("example.com:443"));
+  EXPECT_FALSE(cache.remove("example.com:443"));
+  EXPECT_EQ(nullptr, cache.get("example.com:443"));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(ClientSSLSessionCacheTest, NullSessionsAreNotStored) {
+  ClientSSLSessionCache cache;
+  cache.put("example.com:443", nullptr);
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(ClientSSLSessionCacheTest, EvictsLeastRecentlyUsed) {
+  ClientSSLSessionCache cache(2);
+  auto first = makeSession();
+  auto second = makeSession();
+
+  cache.put("first:443", first);
+  cache.put("second:443", second);
+  // Touch the older entry so "second" is now least recently used.
+  EXPECT_EQ(first, cache.get("first:443"));
+
+  cache.put("third:443", makeSession());
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(first, cache.get("first:443"));
+  EXPECT_EQ(nullptr, cache.get("second:443"));
+}
@@ -63,6 +63,49 @@ TEST_F(SSLSessionCacheDataTest, Basic) {
   EXPECT_EQ(deserializedData.peerIdentities, data.peerIdentities);
 }
 
+TEST_F(SSLSessionCacheDataTest, BinaryRoundTrip) {
+  SSLSessionCacheData data;
+  data.sessionData = folly::fbstring("some session data\0with nul", 26);
+  data.addedTime = system_clock::now();
+  data.serviceIdentity = "some service";
+  data.peerIdentities = "svc:serviceId";
+
+  auto record = serializeSSLSessionCacheData(data);
+  auto deserialized = deserializeSSLSessionCacheData(folly::ByteRange(
+      reinterpret_cast<const uint8_t*>(record.data()), record.size()));
+
+  ASSERT_TRUE(deserialized.hasValue());
+  EXPECT_EQ(deserialized->sessionData, data.sessionData);
+  EXPECT_EQ(deserialized->addedTime, data.addedTime);
+  EXPECT_EQ(deserialized->serviceIdentity, data.serviceIdentity);
+  EXPECT_EQ(deserialized->peerIdentities, data.peerIdentities);
+}
+
+TEST_F(SSLSessionCacheDataTest, BinaryRejectsBadRecords) {
+  SSLSessionCacheData data;
+  data.sessionData = folly::fbstring("some session data");
+  data.addedTime = system_clock::now();
+
+  auto record = serializeSSLSessionCacheData(data);
+  auto* bytes = reinterpret_cast<const uint8_t*>(record.data());
+
+  // Truncated anywhere should fail cleanly
+  for (size_t len = 0; len < record.size(); len++) {
+    EXPECT_FALSE(
+        deserializeSSLSessionCacheData(folly::ByteRange(bytes, len))
+            .hasValue());
+  }
+
+  // Unknown version byte
+  auto bad = record;
+  bad[0] = static_cast<char>(kSSLSessionCacheDataVersion + 1);
+  EXPECT_FALSE(deserializeSSLSessionCacheData(
+                   folly::ByteRange(
+                       reinterpret_cast<const uint8_t*>(bad.data()),
+                       bad.size()))
+                   .hasValue());
+}
+
 TEST_F(SSLSessionCacheDataTest, CloneSSLSession) {
   for (auto& it : sessions_) {
     auto sess = SSLSessionUniquePtr(cloneSSLSession(it.first));
@@ -17,6 +17,7 @@
 #include <folly/DynamicConverter.h>
 #include <folly/Format.h>
 #include <folly/Memory.h>
+#include <folly/executors/ManualExecutor.h>
 
 #include <folly/portability/GMock.h>
 
@@ -166,6 +167,39 @@ TEST_F(SSLSessionPersistentCacheTest, Overwrite) {
   }
 }
 
+TEST_F(SSLSessionPersistentCacheTest, WriteBehind) {
+  auto executor = std::make_shared<folly::ManualExecutor>();
+  cache_->setWriteBehindExecutor(executor);
+
+  cache_->setSSLSession("host0", createPersistentTestSession(sessions_[0]));
+
+  // Nothing persisted until the executor drains, but the parked entry
+  // is already visible to lookups.
+  ASSERT_EQ(0, cache_->size());
+  verifyEntryInCache("host0", sessions_[0]);
+
+  executor->drain();
+  ASSERT_EQ(1, cache_->size());
+  verifyEntryInCache("host0", sessions_[0]);
+
+  {
+    // Repeated updates for the same identity coalesce; only the latest
+    // session survives the drain.
+    cache_->setSSLSession("host0", createPersistentTestSession(sessions_[1]));
+    cache_->setSSLSession("host0", createPersistentTestSession(sessions_[2]));
+    executor->drain();
+    verifyEntryInCache("host0", sessions_[2]);
+  }
+
+  {
+    // Removal covers parked writes too.
+    cache_->setSSLSession("host1", createPersistentTestSession(sessions_[0]));
+    ASSERT_TRUE(cache_->removeSSLSession("host1"));
+    executor->drain();
+    ASSERT_FALSE(cache_->getSSLSession("host1"));
+  }
+}
+
 TEST_F(SSLSessionPersistentCacheTest, SessionTicketTimeout) {
   std::string myhost("host3");
   cache_->setSSLSession(
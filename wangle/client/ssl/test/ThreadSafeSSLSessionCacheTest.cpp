@@ -105,3 +105,28 @@ TEST_F(ThreadSafeSSLSessionCacheTest, ReadWrite) {
   reader.join();
   EXPECT_GE(readOps, writeOps);
 }
+
+TEST_F(ThreadSafeSSLSessionCacheTest, DeferredWritesVisibleToOwnThread) {
+  cache_->setDeferredWrites(4);
+  cache_->setSSLSession("host", createPersistentTestSession(sessions_[0]));
+  // Unpublished entries serve repeated lookups from the capturing thread.
+  EXPECT_NE(nullptr, cache_->getSSLSession("host").get());
+  EXPECT_NE(nullptr, cache_->getSSLSession("host").get());
+}
+
+TEST_F(ThreadSafeSSLSessionCacheTest, DeferredWritesFlushAtThreshold) {
+  cache_->setDeferredWrites(2);
+  cache_->setSSLSession("host0", createPersistentTestSession(sessions_[0]));
+  cache_->setSSLSession("host1", createPersistentTestSession(sessions_[0]));
+  // The batch was published; the one-time-use delegate hands each out once.
+  EXPECT_NE(nullptr, cache_->getSSLSession("host0").get());
+  EXPECT_EQ(nullptr, cache_->getSSLSession("host0").get());
+  EXPECT_NE(nullptr, cache_->getSSLSession("host1").get());
+}
+
+TEST_F(ThreadSafeSSLSessionCacheTest, DeferredRemoveDropsPendingEntry) {
+  cache_->setDeferredWrites(4);
+  cache_->setSSLSession("host", createPersistentTestSession(sessions_[0]));
+  cache_->removeSSLSession("host");
+  EXPECT_EQ(nullptr, cache_->getSSLSession("host").get());
+}
@@ -16,10 +16,20 @@
 
 #pragma once
 
+#include <folly/small_vector.h>
 #include <wangle/channel/Handler.h>
+#include <wangle/codec/CodecStats.h>
+#include <wangle/util/Tracepoints.h>
 
 namespace wangle {
 
+/**
+ * A batch of decoded messages delivered in one pipeline traversal.
+ * Sized so a typical socket read's worth of small RPC frames stays inline.
+ */
+template <typename M>
+using ReadBatch = folly::small_vector<M, 16>;
+
 /**
  * A Handler which decodes bytes in a stream-like fashion from
  * IOBufQueue to a  Message type.
@@ -54,6 +64,44 @@ class ByteToMessageDecoder : public InboundHandler<folly::IOBufQueue&, M> {
   virtual bool
   decode(Context* ctx, folly::IOBufQueue& buf, M& result, size_t&) = 0;
 
+  /**
+   * Decode every complete frame currently in buf into batch. The default
+   * re-enters decode() until it reports insufficient bytes; decoders whose
+   * framing lets them size the whole run up front (FixedLengthFrameDecoder)
+   * override this to slice the queue in a single pass. Called by
+   * BatchedByteToMessageDecoder once per read event.
+   */
+  virtual void
+  decodeBatch(Context* ctx, folly::IOBufQueue& buf, ReadBatch<M>& batch) {
+    resolveStats(ctx);
+    bool success = true;
+    while (success) {
+      M result;
+      size_t needed = 0;
+      const size_t before = statsQueueLength(buf);
+      success = decode(ctx, buf, result, needed);
+      recordDecode(success, before, statsQueueLength(buf));
+      if (success) {
+        if (WANGLE_SDT_ENABLED(frame_decoded)) {
+          WANGLE_SDT_WITH_SEMAPHORE(frame_decoded, ctx->getTransportRaw());
+        }
+        batch.push_back(std::move(result));
+      }
+    }
+    recordReadEnd(statsQueueLength(buf));
+  }
+
+#if WANGLE_CODEC_STATS
+  /**
+   * Records into the given aggregate instead of the per-EventBase one
+   * resolved from the attached transport. Mainly for tests and for
+   * pipelines without a transport.
+   */
+  void setCodecStats(CodecStats* stats) {
+    stats_ = stats;
+  }
+#endif
+
   void transportActive(Context* ctx) override {
     transportActive_ = true;
     ctx->fireTransportActive();
@@ -65,21 +113,214 @@ class ByteToMessageDecoder : public InboundHandler<folly::IOBufQueue&, M> {
   }
 
   void read(Context* ctx, folly::IOBufQueue& q) override {
+    resolveStats(ctx);
     bool success = true;
     while (success && transportActive_) {
       M result;
       size_t needed = 0;
+      const size_t before = statsQueueLength(q);
       success = decode(ctx, q, result, needed);
+      recordDecode(success, before, statsQueueLength(q));
       if (success) {
+        if (WANGLE_SDT_ENABLED(frame_decoded)) {
+          WANGLE_SDT_WITH_SEMAPHORE(frame_decoded, ctx->getTransportRaw());
+        }
         ctx->fireRead(std::move(result));
       }
     }
+    recordReadEnd(statsQueueLength(q));
   }
 
  private:
+  // The telemetry helpers compile to empty inline functions when
+  // WANGLE_CODEC_STATS is 0, so the read loop above stays unchanged.
+  void resolveStats(Context* ctx) {
+#if WANGLE_CODEC_STATS
+    if (!stats_) {
+      if (auto* transport = ctx->getTransportRaw()) {
+        if (auto* evb = transport->getEventBase()) {
+          stats_ = &CodecStats::forEventBase(evb);
+        }
+      }
+    }
+#else
+    (void)ctx;
+#endif
+  }
+
+  size_t statsQueueLength(const folly::IOBufQueue& q) const {
+#if WANGLE_CODEC_STATS
+    if (stats_) {
+      return q.chainLength();
+    }
+#else
+    (void)q;
+#endif
+    return 0;
+  }
+
+  void recordDecode(bool success, size_t before, size_t after) {
+#if WANGLE_CODEC_STATS
+    if (!stats_) {
+      return;
+    }
+    stats_->decodeCalls++;
+    if (success) {
+      stats_->frames++;
+      stats_->frameSizes.record(before - after);
+      stats_->decodeCallsPerFrame.record(decodeCallsThisFrame_ + 1);
+      decodeCallsThisFrame_ = 0;
+    } else if (after > 0) {
+      // A genuine stall: bytes are buffered but no frame completed.
+      // (The trailing probe on an empty queue is not one.)
+      decodeCallsThisFrame_++;
+    }
+#else
+    (void)success;
+    (void)before;
+    (void)after;
+#endif
+  }
+
+  void recordReadEnd(size_t buffered) {
+#if WANGLE_CODEC_STATS
+    if (!stats_) {
+      return;
+    }
+    stats_->queueResidency.record(buffered);
+    if (buffered > 0) {
+      stats_->stalledReads++;
+    }
+#else
+    (void)buffered;
+#endif
+  }
+
+#if WANGLE_CODEC_STATS
+  CodecStats* stats_{nullptr};
+  uint32_t decodeCallsThisFrame_{0};
+#endif
   bool transportActive_ = true;
 };
 
 typedef ByteToMessageDecoder<std::unique_ptr<folly::IOBuf>> ByteToByteDecoder;
 
+/**
+ * Adapts a ByteToMessageDecoder so that all frames decodable from a single
+ * read event are delivered downstream as one ReadBatch<M>& instead of one
+ * fireRead per frame. A socket read carrying dozens of pipelined frames then
+ * walks the remaining handler chain once rather than once per frame.
+ *
+ * Downstream handlers consume the batch by declaring their inbound type as
+ * ReadBatch<M>& (passed by reference, like IOBufQueue&, so the batch is
+ * never copied). Example:
+ *
+ *   pipeline->addBack(BatchedByteToMessageDecoder<LineBasedFrameDecoder>());
+ *   pipeline->addBack(MyBatchHandler());  // InboundHandler<ReadBatch<...>&>
+ *
+ * The wrapped decoder is constructed in place and is not itself attached to
+ * the pipeline; exceptions it fires during decode are forwarded to this
+ * handler's context.
+ */
+template <typename Decoder, typename M = typename Decoder::rout>
+class BatchedByteToMessageDecoder
+    : public InboundHandler<folly::IOBufQueue&, ReadBatch<M>&> {
+ public:
+  typedef
+      typename InboundHandler<folly::IOBufQueue&, ReadBatch<M>&>::Context
+          Context;
+
+  template <typename... Args>
+  explicit BatchedByteToMessageDecoder(Args&&... args)
+      : decoder_(std::forward<Args>(args)...) {}
+
+  void transportActive(Context* ctx) override {
+    transportActive_ = true;
+    ctx->fireTransportActive();
+  }
+
+  void transportInactive(Context* ctx) override {
+    transportActive_ = false;
+    ctx->fireTransportInactive();
+  }
+
+  void read(Context* ctx, folly::IOBufQueue& q) override {
+    DecodeContext decodeCtx(ctx, &batch_);
+    batch_.clear();
+    if (transportActive_) {
+      decoder_.decodeBatch(&decodeCtx, q, batch_);
+    }
+    if (!batch_.empty()) {
+      ctx->fireRead(batch_);
+      batch_.clear();
+    }
+  }
+
+  Decoder* getDecoder() {
+    return &decoder_;
+  }
+
+ private:
+  // The context handed to the wrapped decoder. Frames the decoder fires
+  // itself (beyond decode()'s out-param) are appended to the current batch;
+  // everything else forwards to the batch handler's own context.
+  class DecodeContext : public InboundHandlerContext<M> {
+   public:
+    DecodeContext(Context* ctx, ReadBatch<M>* batch)
+        : ctx_(ctx), batch_(batch) {}
+
+    void fireRead(M msg) override {
+      batch_->push_back(std::move(msg));
+    }
+
+    void fireReadEOF() override {
+      ctx_->fireReadEOF();
+    }
+
+    void fireReadException(folly::exception_wrapper e) override {
+      ctx_->fireReadException(std::move(e));
+    }
+
+    void fireReadError(TransportErrorCode code) override {
+      ctx_->fireReadError(code);
+    }
+
+    void fireTransportActive() override {
+      ctx_->fireTransportActive();
+    }
+
+    void fireTransportInactive() override {
+      ctx_->fireTransportInactive();
+    }
+
+    void fireTransportWritable() override {
+      ctx_->fireTransportWritable();
+    }
+
+    void fireTransportUnwritable() override {
+      ctx_->fireTransportUnwritable();
+    }
+
+    PipelineBase* getPipeline() override {
+      return ctx_->getPipeline();
+    }
+
+    std::shared_ptr<PipelineBase> getPipelineShared() override {
+      return ctx_->getPipelineShared();
+    }
+
+    HandlerStateSlot& getStateSlot() override {
+      return ctx_->getStateSlot();
+    }
+
+   private:
+    Context* ctx_;
+    ReadBatch<M>* batch_;
+  };
+
+  Decoder decoder_;
+  ReadBatch<M> batch_;
+  bool transportActive_ = true;
+};
+
 } // namespace wangle
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/codec/ChecksumHandler.h>
+
+#include <cstring>
+
+#include <folly/hash/Checksum.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/lang/Bits.h>
+
+namespace wangle {
+
+namespace {
+
+uint32_t checksumOfChain(ChecksumType type, const folly::IOBuf& buf) {
+  uint32_t crc = 0;
+  size_t seen = 0;
+  for (auto range : buf) {
+    if (range.empty()) {
+      continue;
+    }
+    uint32_t segment = type == ChecksumType::CRC32C
+        ? folly::crc32c(range.data(), range.size())
+        : folly::crc32(range.data(), range.size());
+    crc = seen == 0
+        ? segment
+        : (type == ChecksumType::CRC32C
+               ? folly::crc32c_combine(crc, segment, range.size())
+               : folly::crc32_combine(crc, segment, range.size()));
+    seen += range.size();
+  }
+  // An empty chain yields 0, the checksum of zero bytes for both types.
+  return crc;
+}
+
+} // namespace
+
+void ChecksumHandler::attachPipeline(Context* ctx) {
+  ctx->getPipeline()->reserveWriteTailroom(kChecksumLength);
+}
+
+void ChecksumHandler::read(Context* ctx, std::unique_ptr<folly::IOBuf> msg) {
+  auto len = msg->computeChainDataLength();
+  if (len < kChecksumLength) {
+    ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+        "frame too short to carry a checksum trailer"));
+    return;
+  }
+
+  folly::io::Cursor cursor(msg.get());
+  cursor.skip(len - kChecksumLength);
+  const auto expected = cursor.readBE<uint32_t>();
+
+  folly::IOBufQueue q;
+  q.append(std::move(msg));
+  q.trimEnd(kChecksumLength);
+  msg = q.move();
+  if (!msg) {
+    msg = folly::IOBuf::create(0);
+  }
+
+  if (checksumOfChain(type_, *msg) != expected) {
+    ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+        "frame checksum mismatch"));
+    return;
+  }
+  ctx->fireRead(std::move(msg));
+}
+
+folly::Future<folly::Unit> ChecksumHandler::write(
+    Context* ctx,
+    std::unique_ptr<folly::IOBuf> buf) {
+  appendChecksum(buf);
+  return ctx->fireWrite(std::move(buf));
+}
+
+void ChecksumHandler::appendChecksum(std::unique_ptr<folly::IOBuf>& buf) {
+  const uint32_t wire = folly::Endian::big(checksumOfChain(type_, *buf));
+  auto* tail = buf->prev();
+  if (!tail->isSharedOne() && tail->tailroom() >= kChecksumLength) {
+    std::memcpy(tail->writableTail(), &wire, kChecksumLength);
+    tail->append(kChecksumLength);
+    return;
+  }
+  auto trailer = folly::IOBuf::create(kChecksumLength);
+  std::memcpy(trailer->writableData(), &wire, kChecksumLength);
+  trailer->append(kChecksumLength);
+  buf->prependChain(std::move(trailer));
+}
+
+} // namespace wangle
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+enum class ChecksumType {
+  CRC32C,
+  CRC32,
+};
+
+/**
+ * Verifies and strips a per-frame checksum trailer on read, and computes
+ * and appends one on write.
+ *
+ * The handler sits downstream of a framing codec, e.g.:
+ *
+ *   pipeline->addBack(LengthFieldPrepender());
+ *   pipeline->addBack(LengthFieldBasedFrameDecoder());
+ *   pipeline->addBack(ChecksumHandler());
+ *
+ * so every read is one complete frame whose last four bytes are the
+ * big-endian checksum of the preceding payload, and every written frame
+ * gets the trailer appended before the length field (which then covers
+ * payload plus trailer) is prepended.
+ *
+ * Checksums are computed with folly's implementations, which use SSE4.2
+ * on x86 and the CRC extension on ARMv8 with a software fallback, and
+ * walk the frame's IOBuf chain segment by segment without flattening.
+ * On write the trailer lands in the tail buffer's tailroom when there is
+ * room, avoiding an extra allocation; the handler reserves that tailroom
+ * on the pipeline when it attaches, so buffers allocated through
+ * MessageToByteEncoder::newEncodeBuffer() always have it.
+ *
+ * A frame that is too short to carry a trailer or whose checksum does
+ * not match is dropped and surfaced as a readException.
+ */
+class ChecksumHandler
+    : public HandlerAdapter<
+          std::unique_ptr<folly::IOBuf>,
+          std::unique_ptr<folly::IOBuf>> {
+ public:
+  static constexpr size_t kChecksumLength = 4;
+
+  explicit ChecksumHandler(ChecksumType type = ChecksumType::CRC32C)
+      : type_(type) {}
+
+  void attachPipeline(Context* ctx) override;
+
+  void read(Context* ctx, std::unique_ptr<folly::IOBuf> msg) override;
+
+  folly::Future<folly::Unit> write(
+      Context* ctx,
+      std::unique_ptr<folly::IOBuf> buf) override;
+
+ private:
+  void appendChecksum(std::unique_ptr<folly::IOBuf>& buf);
+
+  ChecksumType type_;
+};
+
+} // namespace wangle
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/codec/ChunkedFrameDecoder.h>
+
+#include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
+
+using folly::IOBuf;
+using folly::IOBufQueue;
+
+namespace wangle {
+
+ChunkedLengthFieldBasedFrameDecoder::ChunkedLengthFieldBasedFrameDecoder(
+    uint32_t lengthFieldLength,
+    uint64_t maxFrameLength,
+    uint64_t streamingThreshold,
+    bool networkByteOrder)
+    : lengthFieldLength_(lengthFieldLength),
+      maxFrameLength_(maxFrameLength),
+      streamingThreshold_(streamingThreshold),
+      networkByteOrder_(networkByteOrder) {
+  CHECK(
+      lengthFieldLength == 1 || lengthFieldLength == 2 ||
+      lengthFieldLength == 4 || lengthFieldLength == 8);
+  CHECK(maxFrameLength > 0);
+}
+
+void ChunkedLengthFieldBasedFrameDecoder::read(Context* ctx, IOBufQueue& q) {
+  while (true) {
+    if (inFrame_) {
+      if (!pumpBody(ctx, q)) {
+        return;
+      }
+      continue;
+    }
+
+    if (q.chainLength() < lengthFieldLength_) {
+      return;
+    }
+
+    const uint64_t bodyLength = readLengthField(q);
+
+    if (bodyLength > maxFrameLength_) {
+      q.trimStart(lengthFieldLength_);
+      q.trimStartAtMost(bodyLength);
+      ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+          "Frame larger than " + folly::to<std::string>(maxFrameLength_)));
+      return;
+    }
+
+    if (bodyLength < streamingThreshold_) {
+      // Small frame: wait for all of it and deliver it whole.
+      if (q.chainLength() < lengthFieldLength_ + bodyLength) {
+        return;
+      }
+      q.trimStart(lengthFieldLength_);
+      FrameChunk whole;
+      whole.kind = FrameChunk::Kind::WHOLE;
+      whole.frameLength = bodyLength;
+      whole.data = q.split(bodyLength);
+      ctx->fireRead(std::move(whole));
+      continue;
+    }
+
+    // Oversized frame: announce it and stream the body as it arrives.
+    q.trimStart(lengthFieldLength_);
+    inFrame_ = true;
+    bodyRemaining_ = bodyLength;
+    FrameChunk start;
+    start.kind = FrameChunk::Kind::START;
+    start.frameLength = bodyLength;
+    ctx->fireRead(std::move(start));
+  }
+}
+
+bool ChunkedLengthFieldBasedFrameDecoder::pumpBody(
+    Context* ctx,
+    IOBufQueue& q) {
+  while (bodyRemaining_ > 0 && q.chainLength() > 0) {
+    // One chunk per pass over what is buffered: bounded by what a read
+    // event brought in, split off the queue without copying.
+    const auto n = std::min<uint64_t>(bodyRemaining_, q.chainLength());
+    FrameChunk body;
+    body.kind = FrameChunk::Kind::BODY;
+    body.data = q.split(n);
+    bodyRemaining_ -= n;
+    ctx->fireRead(std::move(body));
+  }
+  if (bodyRemaining_ > 0) {
+    return false;
+  }
+  inFrame_ = false;
+  FrameChunk end;
+  end.kind = FrameChunk::Kind::END;
+  ctx->fireRead(std::move(end));
+  return true;
+}
+
+uint64_t ChunkedLengthFieldBasedFrameDecoder::readLengthField(
+    IOBufQueue& q) const {
+  // Fast path: the whole field lies in the head buffer (nearly always).
+  const IOBuf* head = q.front();
+  if (LIKELY(head != nullptr && head->length() >= lengthFieldLength_)) {
+    const uint8_t* p = head->data();
+    switch (lengthFieldLength_) {
+      case 1:
+        return *p;
+      case 2: {
+        auto v = folly::loadUnaligned<uint16_t>(p);
+        return networkByteOrder_ ? folly::Endian::big(v)
+                                 : folly::Endian::little(v);
+      }
+      case 4: {
+        auto v = folly::loadUnaligned<uint32_t>(p);
+        return networkByteOrder_ ? folly::Endian::big(v)
+                                 : folly::Endian::little(v);
+      }
+      case 8: {
+        auto v = folly::loadUnaligned<uint64_t>(p);
+        return networkByteOrder_ ? folly::Endian::big(v)
+                                 : folly::Endian::little(v);
+      }
+    }
+  }
+
+  // Slow path: the field spans IOBufs.
+  folly::io::Cursor c(q.front());
+  switch (lengthFieldLength_) {
+    case 1:
+      return c.read<uint8_t>();
+    case 2:
+      return networkByteOrder_ ? c.readBE<uint16_t>() : c.readLE<uint16_t>();
+    case 4:
+      return networkByteOrder_ ? c.readBE<uint32_t>() : c.readLE<uint32_t>();
+    default:
+      return networkByteOrder_ ? c.readBE<uint64_t>() : c.readLE<uint64_t>();
+  }
+}
+
+} // namespace wangle
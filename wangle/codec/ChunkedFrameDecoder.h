@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <climits>
+#include <memory>
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * One event emitted by ChunkedLengthFieldBasedFrameDecoder. Small
+ * frames arrive as a single WHOLE event carrying the complete body;
+ * frames at or above the streaming threshold arrive as START (total
+ * body length, no data), a run of BODY events each carrying a
+ * zero-copy slice of the body, then END.
+ */
+struct FrameChunk {
+  enum class Kind : uint8_t { WHOLE, START, BODY, END };
+
+  Kind kind{Kind::WHOLE};
+  // Total body length of the frame; set on WHOLE and START.
+  uint64_t frameLength{0};
+  // The body (WHOLE) or body slice (BODY); null on START and END.
+  std::unique_ptr<folly::IOBuf> data;
+};
+
+/**
+ * A length-field frame decoder that streams oversized frames instead
+ * of buffering them. LengthFieldBasedFrameDecoder holds a whole frame
+ * in the read queue before emitting it, so a 100MB frame costs 100MB
+ * resident per in-flight transfer and one decode burst when the last
+ * byte lands. This decoder forwards the body of any frame at or above
+ * streamingThreshold as it arrives, in FrameChunk events sliced
+ * zero-copy off the read queue: peak memory per transfer drops from
+ * frame size to roughly one socket read, and decode work spreads over
+ * the reads that carry the frame. Frames below the threshold are
+ * delivered whole, so a mixed protocol only pays the event framing on
+ * its large messages.
+ *
+ * The length field must sit at offset zero and is always stripped;
+ * protocols with header fields around the length need the buffering
+ * decoder. A frame longer than maxFrameLength fires a read exception,
+ * as the buffering decoders do.
+ *
+ * @see FrameChunk for the event sequence contract.
+ */
+class ChunkedLengthFieldBasedFrameDecoder
+    : public InboundHandler<folly::IOBufQueue&, FrameChunk> {
+ public:
+  explicit ChunkedLengthFieldBasedFrameDecoder(
+      uint32_t lengthFieldLength = 4,
+      uint64_t maxFrameLength = UINT_MAX,
+      uint64_t streamingThreshold = 1 << 20,
+      bool networkByteOrder = true);
+
+  void read(Context* ctx, folly::IOBufQueue& q) override;
+
+ private:
+  // Emits chunks for the frame currently being streamed; true once its
+  // END event has fired.
+  bool pumpBody(Context* ctx, folly::IOBufQueue& q);
+
+  uint64_t readLengthField(folly::IOBufQueue& q) const;
+
+  uint32_t lengthFieldLength_;
+  uint64_t maxFrameLength_;
+  uint64_t streamingThreshold_;
+  bool networkByteOrder_;
+
+  // Body bytes still to emit for the frame being streamed; zero when
+  // between frames.
+  uint64_t bodyRemaining_{0};
+  bool inFrame_{false};
+};
+
+} // namespace wangle
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <folly/lang/Bits.h>
+
+// Codec telemetry is compiled in by default; define WANGLE_CODEC_STATS=0
+// to compile it out entirely.
+#ifndef WANGLE_CODEC_STATS
+#define WANGLE_CODEC_STATS 1
+#endif
+
+namespace wangle {
+
+/**
+ * Intrinsic decoder telemetry: frame-size distribution, decode calls
+ * needed per frame, and how many bytes sit buffered awaiting a complete
+ * frame. Protocol-shape regressions — a peer switching to pathologically
+ * small frames, frames that straddle many reads — show up here without
+ * any per-protocol instrumentation.
+ *
+ * Histograms are log-bucketed and recording is a find-last-set, an
+ * index and an increment, cheap enough to leave on. One aggregate
+ * exists per EventBase, shared by every decoder driven from that loop;
+ * like PipelineStats it is single-threaded by construction, so there
+ * are no atomics and it must be read from its own thread (or once the
+ * loop is quiesced).
+ */
+class CodecStats {
+ public:
+  /**
+   * Bucket 0 counts zeros; bucket i counts values in [2^(i-1), 2^i).
+   * Values past the last bucket land in it.
+   */
+  struct Histogram {
+    static constexpr size_t kBuckets = 32;
+
+    void record(uint64_t value) {
+      const size_t bucket = folly::findLastSet(value);
+      buckets[std::min(bucket, kBuckets - 1)]++;
+    }
+
+    uint64_t total() const {
+      uint64_t sum = 0;
+      for (const auto count : buckets) {
+        sum += count;
+      }
+      return sum;
+    }
+
+    std::array<uint64_t, kBuckets> buckets{};
+  };
+
+  static CodecStats& forEventBase(folly::EventBase* evb) {
+    static folly::EventBaseLocal<CodecStats> storage;
+    return storage.getOrCreate(*evb);
+  }
+
+  // Completed frame sizes, in bytes consumed from the read queue.
+  Histogram frameSizes;
+  // decode() calls it took to complete each frame; everything past the
+  // first bucket is a frame that stalled waiting for more reads.
+  Histogram decodeCallsPerFrame;
+  // Bytes still buffered awaiting a complete frame when each read event
+  // ended.
+  Histogram queueResidency;
+  uint64_t frames{0};
+  uint64_t decodeCalls{0};
+  // Read events that ended with a partial frame buffered.
+  uint64_t stalledReads{0};
+};
+
+} // namespace wangle
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <exception>
+#include <utility>
+
+#include <folly/Optional.h>
+#include <folly/experimental/coro/Coroutine.h>
+#include <wangle/codec/ByteToMessageDecoder.h>
+
+namespace wangle {
+
+/**
+ * The byte source handed to a coroutine decoder. co_await need(n)
+ * suspends the decoder until at least n bytes are buffered; buffer()
+ * then exposes the underlying IOBufQueue so frames are consumed with
+ * the usual split()/trimStart() calls.
+ */
+class DecoderByteSource {
+ public:
+  class NeedBytes {
+   public:
+    NeedBytes(DecoderByteSource* source, size_t n) : source_(source), n_(n) {}
+
+    bool await_ready() const noexcept {
+      return source_->queue_->chainLength() >= n_;
+    }
+    void await_suspend(folly::coro::coroutine_handle<>) noexcept {
+      source_->needed_ = n_;
+    }
+    void await_resume() noexcept {
+      source_->needed_ = 0;
+    }
+
+   private:
+    DecoderByteSource* source_;
+    size_t n_;
+  };
+
+  /**
+   * Awaitable that resumes the decoder once at least n bytes are
+   * buffered; it resumes immediately when the bytes are already there.
+   */
+  NeedBytes need(size_t n) {
+    return NeedBytes(this, n);
+  }
+
+  /**
+   * The buffered bytes. After co_await need(n) at least n bytes are
+   * readable.
+   */
+  folly::IOBufQueue& buffer() {
+    return *queue_;
+  }
+
+ private:
+  template <typename M>
+  friend class CoroByteToMessageDecoder;
+
+  folly::IOBufQueue* queue_{nullptr};
+  size_t needed_{0};
+};
+
+/**
+ * The resumable frame behind a coroutine decoder. co_yield suspends
+ * after each decoded frame so the handler can deliver it and resume
+ * exactly where framing left off; co_await on DecoderByteSource::need
+ * suspends until enough input arrives. Move-only; destroys the
+ * coroutine frame on destruction.
+ */
+template <typename M>
+class DecoderGenerator {
+ public:
+  class promise_type {
+   public:
+    DecoderGenerator get_return_object() {
+      return DecoderGenerator(
+          folly::coro::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    folly::coro::suspend_always initial_suspend() noexcept {
+      return {};
+    }
+    folly::coro::suspend_always final_suspend() noexcept {
+      return {};
+    }
+    folly::coro::suspend_always yield_value(M&& frame) {
+      frame_ = std::move(frame);
+      return {};
+    }
+    void return_void() {}
+    void unhandled_exception() {
+      exception_ = std::current_exception();
+    }
+
+    folly::Optional<M> frame_;
+    std::exception_ptr exception_;
+  };
+
+  DecoderGenerator() = default;
+  DecoderGenerator(DecoderGenerator&& other) noexcept
+      : coro_(std::exchange(other.coro_, {})) {}
+  DecoderGenerator& operator=(DecoderGenerator&& other) noexcept {
+    if (this != &other) {
+      if (coro_) {
+        coro_.destroy();
+      }
+      coro_ = std::exchange(other.coro_, {});
+    }
+    return *this;
+  }
+  ~DecoderGenerator() {
+    if (coro_) {
+      coro_.destroy();
+    }
+  }
+
+  explicit operator bool() const {
+    return bool(coro_);
+  }
+  bool done() const {
+    return coro_.done();
+  }
+  void resume() {
+    coro_.resume();
+  }
+  promise_type& promise() {
+    return coro_.promise();
+  }
+
+ private:
+  explicit DecoderGenerator(folly::coro::coroutine_handle<promise_type> coro)
+      : coro_(coro) {}
+
+  folly::coro::coroutine_handle<promise_type> coro_;
+};
+
+/**
+ * A ByteToMessageDecoder whose framing logic is a coroutine instead of
+ * the decode(ctx, buf, result, needed) state machine. Decoders that
+ * straddle partial input no longer carry an explicit state enum and
+ * re-dispatch through it on every read: suspension captures the decode
+ * position in the coroutine frame, and resumption is a jump back into
+ * the middle of the framing expression.
+ *
+ * Subclasses implement decodeFrames() as an ordinarily infinite loop:
+ *
+ *   DecoderGenerator<std::unique_ptr<folly::IOBuf>> decodeFrames(
+ *       DecoderByteSource& source) override {
+ *     while (true) {
+ *       co_await source.need(4);
+ *       folly::io::Cursor c(source.buffer().front());
+ *       auto length = c.readBE<uint32_t>();
+ *       co_await source.need(4 + length);
+ *       source.buffer().trimStart(4);
+ *       co_yield source.buffer().split(length);
+ *     }
+ *   }
+ *
+ * co_return ends decoding for the connection; an exception escaping the
+ * coroutine is delivered downstream as a readException. The classic
+ * decode() entry point is implemented on top of the coroutine, so these
+ * decoders drop into existing pipelines — including under
+ * BatchedByteToMessageDecoder — unchanged.
+ *
+ * The handler must not be moved once decoding has started (the running
+ * coroutine holds a reference to this handler's byte source); pipeline
+ * construction moves happen before the first read and are fine.
+ */
+template <typename M>
+class CoroByteToMessageDecoder : public ByteToMessageDecoder<M> {
+ public:
+  using Context = typename ByteToMessageDecoder<M>::Context;
+
+  virtual DecoderGenerator<M> decodeFrames(DecoderByteSource& source) = 0;
+
+  bool decode(Context* ctx, folly::IOBufQueue& buf, M& result, size_t& needed)
+      override {
+    source_.queue_ = &buf;
+    if (!generator_) {
+      generator_ = decodeFrames(source_);
+    }
+    while (true) {
+      if (generator_.done()) {
+        auto& promise = generator_.promise();
+        if (promise.exception_) {
+          ctx->fireReadException(folly::exception_wrapper(
+              std::exchange(promise.exception_, nullptr)));
+        }
+        return false;
+      }
+      if (buf.chainLength() < source_.needed_) {
+        needed = source_.needed_ - buf.chainLength();
+        return false;
+      }
+      generator_.resume();
+      auto& promise = generator_.promise();
+      if (promise.frame_) {
+        result = std::move(*promise.frame_);
+        promise.frame_.reset();
+        return true;
+      }
+      // Suspended awaiting more bytes or finished; the loop re-checks.
+    }
+  }
+
+ private:
+  DecoderByteSource source_;
+  DecoderGenerator<M> generator_;
+};
+
+} // namespace wangle
+
+#endif // FOLLY_HAS_COROUTINES
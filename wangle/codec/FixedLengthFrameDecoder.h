@@ -55,6 +55,24 @@ class FixedLengthFrameDecoder : public ByteToByteDecoder {
     return true;
   }
 
+  // With a fixed frame size the whole run is known up front: one division
+  // sizes the batch and each frame is a single split, with no per-frame
+  // decode() re-entry. A 64KB read of 128-byte frames becomes one pass
+  // instead of 512 loop iterations.
+  void decodeBatch(
+      Context*,
+      folly::IOBufQueue& q,
+      ReadBatch<std::unique_ptr<folly::IOBuf>>& batch) override {
+    auto frames = q.chainLength() / length_;
+    if (frames == 0) {
+      return;
+    }
+    batch.reserve(batch.size() + frames);
+    for (size_t i = 0; i < frames; i++) {
+      batch.push_back(q.split(length_));
+    }
+  }
+
  private:
   size_t length_;
 };
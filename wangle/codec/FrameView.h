@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/io/Cursor.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * A cheap value type referencing a decoded frame's bytes in place.
+ * The view shares ownership of the backing IOBuf chain: copying a
+ * FrameView clones the chain, which refcounts the underlying storage
+ * and never copies bytes, so handlers can hold or forward views
+ * without coalescing and without one handler's reads perturbing what
+ * the next handler sees.
+ *
+ * Fields are read with a folly::io::Cursor, which walks chained
+ * buffers in place; reader() positions one at the start of the frame.
+ */
+class FrameView {
+ public:
+  FrameView() = default;
+
+  explicit FrameView(std::unique_ptr<folly::IOBuf> buf)
+      : buf_(std::move(buf)),
+        length_(buf_ ? buf_->computeChainDataLength() : 0) {}
+
+  FrameView(const FrameView& other)
+      : buf_(other.buf_ ? other.buf_->clone() : nullptr),
+        length_(other.length_) {}
+
+  FrameView& operator=(const FrameView& other) {
+    if (this != &other) {
+      buf_ = other.buf_ ? other.buf_->clone() : nullptr;
+      length_ = other.length_;
+    }
+    return *this;
+  }
+
+  FrameView(FrameView&&) = default;
+  FrameView& operator=(FrameView&&) = default;
+
+  folly::io::Cursor reader() const {
+    return folly::io::Cursor(buf_.get());
+  }
+
+  size_t size() const {
+    return length_;
+  }
+
+  bool empty() const {
+    return length_ == 0;
+  }
+
+  const folly::IOBuf* buf() const {
+    return buf_.get();
+  }
+
+ private:
+  std::unique_ptr<folly::IOBuf> buf_;
+  size_t length_{0};
+};
+
+/**
+ * Sits below a frame decoder and republishes each decoded frame as a
+ * FrameView, so deserialization stages further up read typed fields in
+ * place rather than splitting or coalescing the bytes first. Writes
+ * pass through untouched.
+ */
+class FrameViewCodec : public Handler<
+                           std::unique_ptr<folly::IOBuf>,
+                           FrameView,
+                           std::unique_ptr<folly::IOBuf>,
+                           std::unique_ptr<folly::IOBuf>> {
+ public:
+  typedef typename Handler<
+      std::unique_ptr<folly::IOBuf>,
+      FrameView,
+      std::unique_ptr<folly::IOBuf>,
+      std::unique_ptr<folly::IOBuf>>::Context Context;
+
+  void read(Context* ctx, std::unique_ptr<folly::IOBuf> buf) override {
+    if (buf) {
+      ctx->fireRead(FrameView(std::move(buf)));
+    }
+  }
+
+  folly::Future<folly::Unit> write(
+      Context* ctx,
+      std::unique_ptr<folly::IOBuf> buf) override {
+    return ctx->fireWrite(std::move(buf));
+  }
+};
+
+} // namespace wangle
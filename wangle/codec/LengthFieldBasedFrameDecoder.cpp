@@ -16,6 +16,8 @@
 
 #include <wangle/codec/LengthFieldBasedFrameDecoder.h>
 
+#include <folly/lang/Bits.h>
+
 using folly::IOBuf;
 using folly::IOBufQueue;
 
@@ -85,11 +87,44 @@ bool LengthFieldBasedFrameDecoder::decode(
   return true;
 }
 
+namespace {
+
+template <typename T>
+uint64_t loadLength(const uint8_t* p, bool networkByteOrder) {
+  auto value = folly::loadUnaligned<T>(p);
+  return networkByteOrder ? folly::Endian::big(value)
+                          : folly::Endian::little(value);
+}
+
+} // namespace
+
 uint64_t LengthFieldBasedFrameDecoder::getUnadjustedFrameLength(
     IOBufQueue& buf,
     int offset,
     int length,
     bool networkByteOrder) {
+  // Fast path: the whole length field lies in the head buffer (nearly
+  // always), so read it directly with an unaligned load instead of going
+  // through a Cursor.
+  const IOBuf* head = buf.front();
+  if (LIKELY(
+          head != nullptr &&
+          head->length() >= static_cast<size_t>(offset) + length)) {
+    const uint8_t* p = head->data() + offset;
+    switch (length) {
+      case 1:
+        return loadLength<uint8_t>(p, networkByteOrder);
+      case 2:
+        return loadLength<uint16_t>(p, networkByteOrder);
+      case 4:
+        return loadLength<uint32_t>(p, networkByteOrder);
+      case 8:
+        return loadLength<uint64_t>(p, networkByteOrder);
+    }
+  }
+
+  // Slow path: the field spans IOBufs. Cursor gathers the bytes across the
+  // seam without coalescing (and thus without copying payload data).
   folly::io::Cursor c(buf.front());
   uint64_t frameLength;
 
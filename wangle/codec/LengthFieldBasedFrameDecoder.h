@@ -17,6 +17,7 @@
 #pragma once
 
 #include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
 #include <wangle/codec/ByteToMessageDecoder.h>
 
 namespace wangle {
@@ -217,4 +218,124 @@ class LengthFieldBasedFrameDecoder : public ByteToByteDecoder {
   uint32_t lengthFieldEndOffset_;
 };
 
+namespace length_field_detail {
+
+template <uint32_t LengthBytes>
+struct UintOfSize;
+template <>
+struct UintOfSize<1> {
+  using type = uint8_t;
+};
+template <>
+struct UintOfSize<2> {
+  using type = uint16_t;
+};
+template <>
+struct UintOfSize<4> {
+  using type = uint32_t;
+};
+template <>
+struct UintOfSize<8> {
+  using type = uint64_t;
+};
+
+} // namespace length_field_detail
+
+/**
+ * Compile-time specialized LengthFieldBasedFrameDecoder for the common
+ * case of a length field at offset zero. The runtime class re-branches
+ * every frame on lengthFieldLength, byte order and offsets; when the
+ * framing never changes, baking them into template parameters turns
+ * length extraction into a single unaligned load plus (for big-endian
+ * fields on little-endian hosts) a bswap. Frames with a length field at
+ * a nonzero offset still need the runtime class.
+ *
+ * Adjustment is added to the extracted length exactly like the runtime
+ * class's lengthAdjustment; maxFrameLength and initialBytesToStrip stay
+ * runtime parameters since they don't sit on the per-frame branch path.
+ */
+template <uint32_t LengthBytes, bool BigEndian = true, int32_t Adjustment = 0>
+class LengthFieldBasedFrameDecoderT : public ByteToByteDecoder {
+ public:
+  static_assert(
+      LengthBytes == 1 || LengthBytes == 2 || LengthBytes == 4 ||
+          LengthBytes == 8,
+      "length field must be 1, 2, 4 or 8 bytes");
+
+  explicit LengthFieldBasedFrameDecoderT(
+      uint32_t maxFrameLength = UINT_MAX,
+      uint32_t initialBytesToStrip = LengthBytes)
+      : maxFrameLength_(maxFrameLength),
+        initialBytesToStrip_(initialBytesToStrip) {
+    CHECK(maxFrameLength > 0);
+  }
+
+  bool decode(
+      Context* ctx,
+      folly::IOBufQueue& buf,
+      std::unique_ptr<folly::IOBuf>& result,
+      size_t&) override {
+    if (buf.chainLength() < LengthBytes) {
+      return false;
+    }
+
+    uint64_t frameLength = readLengthField(buf);
+    frameLength += Adjustment + LengthBytes;
+
+    if (frameLength < LengthBytes) {
+      buf.trimStart(LengthBytes);
+      ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+          "Frame too small"));
+      return false;
+    }
+
+    if (frameLength > maxFrameLength_) {
+      buf.trimStartAtMost(frameLength);
+      ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+          "Frame larger than " + folly::to<std::string>(maxFrameLength_)));
+      return false;
+    }
+
+    if (buf.chainLength() < frameLength) {
+      return false;
+    }
+
+    if (initialBytesToStrip_ > frameLength) {
+      buf.trimStart(frameLength);
+      ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+          "InitialBytesToSkip larger than frame"));
+      return false;
+    }
+
+    buf.trimStart(initialBytesToStrip_);
+    int actualFrameLength =
+        static_cast<int>(frameLength) - initialBytesToStrip_;
+    result = buf.split(actualFrameLength);
+    return true;
+  }
+
+ private:
+  using FieldType = typename length_field_detail::UintOfSize<LengthBytes>::type;
+
+  static uint64_t readLengthField(folly::IOBufQueue& buf) {
+    // Fast path: the field lies in the head buffer (nearly always);
+    // the branch on LengthBytes and BigEndian is resolved at compile
+    // time, leaving a load and at most a bswap.
+    const folly::IOBuf* head = buf.front();
+    if (LIKELY(head != nullptr && head->length() >= LengthBytes)) {
+      auto value = folly::loadUnaligned<FieldType>(head->data());
+      return BigEndian ? folly::Endian::big(value)
+                       : folly::Endian::little(value);
+    }
+
+    // Slow path: the field spans IOBufs.
+    folly::io::Cursor c(buf.front());
+    return BigEndian ? c.template readBE<FieldType>()
+                     : c.template readLE<FieldType>();
+  }
+
+  uint32_t maxFrameLength_;
+  uint32_t initialBytesToStrip_;
+};
+
 } // namespace wangle
@@ -36,6 +36,10 @@ LengthFieldPrepender::LengthFieldPrepender(
       lengthFieldLength == 4 || lengthFieldLength == 8);
 }
 
+void LengthFieldPrepender::attachPipeline(Context* ctx) {
+  ctx->getPipeline()->reserveWriteHeadroom(lengthFieldLength_);
+}
+
 Future<Unit> LengthFieldPrepender::write(
     Context* ctx,
     std::unique_ptr<IOBuf> buf) {
@@ -48,8 +52,17 @@ Future<Unit> LengthFieldPrepender::write(
     throw std::runtime_error("Length field < 0");
   }
 
-  auto len = IOBuf::create(lengthFieldLength_);
-  len->append(lengthFieldLength_);
+  std::unique_ptr<IOBuf> len;
+  if (!buf->isSharedOne() &&
+      buf->headroom() >= static_cast<size_t>(lengthFieldLength_)) {
+    // Zero-allocation path: the field fits in the head buffer's headroom
+    // (typically reserved through the pipeline's write headroom).
+    buf->prepend(lengthFieldLength_);
+    len = std::move(buf);
+  } else {
+    len = IOBuf::create(lengthFieldLength_);
+    len->append(lengthFieldLength_);
+  }
   folly::io::RWPrivateCursor c(len.get());
 
   switch (lengthFieldLength_) {
@@ -96,7 +109,9 @@ Future<Unit> LengthFieldPrepender::write(
     }
   }
 
-  len->prependChain(std::move(buf));
+  if (buf) {
+    len->prependChain(std::move(buf));
+  }
   return ctx->fireWrite(std::move(len));
 }
 
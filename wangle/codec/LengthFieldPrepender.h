@@ -46,6 +46,12 @@ namespace wangle {
  * + 0x000E | "HELLO, WORLD" |
  * +--------+----------------+
  *
+ * When the message's head buffer has enough headroom and is not shared,
+ * the field is written into the headroom in place; the handler reserves
+ * that headroom on the pipeline when it attaches, so encoders that
+ * allocate through MessageToByteEncoder::newEncodeBuffer() frame
+ * without a second allocation. Otherwise a header IOBuf is prepended
+ * to the chain.
  */
 class LengthFieldPrepender : public OutboundBytesToBytesHandler {
  public:
@@ -55,6 +61,8 @@ class LengthFieldPrepender : public OutboundBytesToBytesHandler {
       bool lengthIncludesLengthField = false,
       bool networkByteOrder = true);
 
+  void attachPipeline(Context* ctx) override;
+
   folly::Future<folly::Unit> write(
       Context* ctx,
       std::unique_ptr<folly::IOBuf> buf) override;
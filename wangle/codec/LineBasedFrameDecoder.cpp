@@ -16,6 +16,9 @@
 
 #include <wangle/codec/LineBasedFrameDecoder.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace wangle {
 
 using folly::IOBuf;
@@ -36,6 +39,9 @@ bool LineBasedFrameDecoder::decode(
     std::unique_ptr<IOBuf>& result,
     size_t&) {
   int64_t eol = findEndOfLine(buf);
+  if (eol >= 0) {
+    scanOffset_ = 0;
+  }
 
   if (!discarding_) {
     if (eol >= 0) {
@@ -64,6 +70,7 @@ bool LineBasedFrameDecoder::decode(
       if (len > maxLength_) {
         discardedBytes_ = folly::to_narrow(len);
         buf.trimStart(len);
+        scanOffset_ = 0;
         discarding_ = true;
         fail(ctx, "over " + folly::to<std::string>(len));
       }
@@ -80,6 +87,7 @@ bool LineBasedFrameDecoder::decode(
     } else {
       discardedBytes_ = folly::to_narrow(buf.chainLength());
       buf.move();
+      scanOffset_ = 0;
     }
 
     return false;
@@ -93,18 +101,64 @@ void LineBasedFrameDecoder::fail(Context* ctx, std::string len) {
 }
 
 int64_t LineBasedFrameDecoder::findEndOfLine(IOBufQueue& buf) {
-  Cursor c(buf.front());
-  for (uint32_t i = 0; i < maxLength_ && i < buf.chainLength(); i++) {
-    auto b = c.read<char>();
-    if (b == '\n' && terminatorType_ != TerminatorType::CARRIAGENEWLINE) {
-      return i;
-    } else if (
-        terminatorType_ != TerminatorType::NEWLINE && b == '\r' &&
-        !c.isAtEnd() && *c.peekBytes().data() == '\n') {
-      return i;
-    }
+  const IOBuf* head = buf.front();
+  if (!head) {
+    return -1;
   }
 
+  // Scan each contiguous IOBuf range with memchr (vectorized by libc) for
+  // '\n', then classify the hit against the preceding byte. A '\r' that is
+  // the last byte of one buffer and a '\n' that is the first byte of the
+  // next are handled by carrying the previous buffer's final byte across
+  // the seam. Search one byte past maxLength_ so a "\r\n" whose '\r' sits
+  // at index maxLength_ - 1 is still found, as with the old scalar loop.
+  const size_t len = buf.chainLength();
+  const size_t limit =
+      std::min<size_t>(len, static_cast<size_t>(maxLength_) + 1);
+
+  size_t offset = 0; // chain-global index of the current buffer's first byte
+  char prevByte = 0; // last byte of the previous buffer
+  const IOBuf* io = head;
+  do {
+    const auto* data = reinterpret_cast<const char*>(io->data());
+    const size_t bufLen = io->length();
+    if (offset >= limit) {
+      break;
+    }
+    const size_t searchLen = std::min(bufLen, limit - offset);
+    // Skip bytes already scanned by a previous decode() that found no line.
+    const size_t start =
+        scanOffset_ > offset ? std::min(scanOffset_ - offset, searchLen) : 0;
+    const char* p = data + start;
+    const char* end = data + searchLen;
+    while (p < end) {
+      const auto* hit = static_cast<const char*>(memchr(p, '\n', end - p));
+      if (!hit) {
+        break;
+      }
+      const size_t i = offset + static_cast<size_t>(hit - data);
+      const char before = (hit == data) ? prevByte : hit[-1];
+      if (terminatorType_ != TerminatorType::NEWLINE && i > 0 &&
+          before == '\r') {
+        return static_cast<int64_t>(i) - 1;
+      }
+      if (terminatorType_ != TerminatorType::CARRIAGENEWLINE &&
+          i < maxLength_) {
+        return static_cast<int64_t>(i);
+      }
+      p = hit + 1;
+    }
+    if (bufLen > 0) {
+      prevByte = data[bufLen - 1];
+    }
+    offset += bufLen;
+    io = io->next();
+  } while (io != head);
+
+  // Remember how far we got, backing up one byte in case the data ends with
+  // the '\r' of a split "\r\n".
+  const size_t scanned = std::min(len, limit);
+  scanOffset_ = scanned > 0 ? scanned - 1 : 0;
   return -1;
 }
 
@@ -53,6 +53,10 @@ class LineBasedFrameDecoder : public ByteToByteDecoder {
   bool discarding_{false};
   uint32_t discardedBytes_{0};
 
+  // Number of buffered bytes already scanned without finding a terminator;
+  // re-entry after a partial line resumes from here instead of rescanning.
+  size_t scanOffset_{0};
+
   TerminatorType terminatorType_;
 };
 
@@ -34,9 +34,30 @@ class MessageToByteEncoder
   virtual std::unique_ptr<folly::IOBuf> encode(M& msg) = 0;
 
   folly::Future<folly::Unit> write(Context* ctx, M msg) override {
+    encodeHeadroom_ = ctx->getPipeline()->getWriteHeadroom();
+    encodeTailroom_ = ctx->getPipeline()->getWriteTailroom();
     auto buf = encode(msg);
     return buf ? ctx->fireWrite(std::move(buf)) : folly::makeFuture();
   }
+
+ protected:
+  /**
+   * Allocate the buffer encode() fills. The headroom and tailroom the
+   * downstream framing stages reserved on the pipeline are laid out
+   * around the payload, so a length prepender writes its header and a
+   * checksum stage its trailer into this buffer in place — one
+   * allocation per message end to end instead of one per stage.
+   */
+  std::unique_ptr<folly::IOBuf> newEncodeBuffer(size_t payloadSize) {
+    auto buf =
+        folly::IOBuf::create(encodeHeadroom_ + payloadSize + encodeTailroom_);
+    buf->advance(encodeHeadroom_);
+    return buf;
+  }
+
+ private:
+  size_t encodeHeadroom_{0};
+  size_t encodeTailroom_{0};
 };
 
 } // namespace wangle
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/codec/ProtocolMultiplexHandler.h>
+
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/io/async/EventBase.h>
+
+namespace wangle {
+
+ProtocolMultiplexHandler::ProtocolMultiplexHandler(size_t maxDetectBytes)
+    : maxDetectBytes_(maxDetectBytes) {}
+
+ProtocolMultiplexHandler& ProtocolMultiplexHandler::addProtocol(
+    std::string name,
+    Detector detector,
+    ChainInstaller installer) {
+  Candidate candidate;
+  candidate.name = std::move(name);
+  candidate.detect = std::move(detector);
+  candidate.install = std::move(installer);
+  candidates_.push_back(std::move(candidate));
+  return *this;
+}
+
+void ProtocolMultiplexHandler::read(Context* ctx, folly::IOBufQueue& q) {
+  if (selected_) {
+    // Only reachable until the deferred self-removal runs, or on
+    // pipelines with no event base to defer to.
+    ctx->fireRead(q);
+    return;
+  }
+
+  auto buffered = q.chainLength();
+  if (buffered == 0) {
+    return;
+  }
+
+  bool undecided = false;
+  for (auto& candidate : candidates_) {
+    if (candidate.eliminated) {
+      continue;
+    }
+    switch (candidate.detect(q)) {
+      case DetectResult::MATCH:
+        select(ctx, candidate, q);
+        return;
+      case DetectResult::NEED_MORE_DATA:
+        undecided = true;
+        break;
+      case DetectResult::NO_MATCH:
+        candidate.eliminated = true;
+        break;
+    }
+  }
+
+  if (!undecided) {
+    fail(ctx, "no registered protocol matched");
+  } else if (buffered >= maxDetectBytes_) {
+    fail(
+        ctx,
+        "protocol undecided after " + folly::to<std::string>(buffered) +
+            " bytes");
+  }
+  // Otherwise leave the prefix in the queue; the socket handler keeps
+  // it buffered and we re-run detection when more bytes arrive.
+}
+
+void ProtocolMultiplexHandler::select(
+    Context* ctx,
+    Candidate& candidate,
+    folly::IOBufQueue& q) {
+  selected_ = true;
+  selectedProtocol_ = candidate.name;
+  // The installer finalizes the pipeline, which re-links this context
+  // to the first handler of the new sub-chain.
+  candidate.install(ctx->getPipeline());
+  scheduleRemoval(ctx);
+  // Replay the buffered prefix into the chosen chain: same queue, no
+  // copy.
+  ctx->fireRead(q);
+}
+
+void ProtocolMultiplexHandler::scheduleRemoval(Context* ctx) {
+  auto pipeline = ctx->getPipelineShared();
+  if (!pipeline) {
+    // Uniquely owned pipeline; stay in place as a passthrough.
+    return;
+  }
+  auto transport = ctx->getTransport();
+  auto* evb = transport ? transport->getEventBase() : nullptr;
+  if (!evb) {
+    return;
+  }
+  // Removing the handler here would delete the context whose read()
+  // frame is still on the stack, so defer to the next loop tick. The
+  // captured shared_ptr keeps the pipeline (and with it this handler)
+  // alive until then.
+  evb->runInEventBaseThread([pipeline, this] {
+    pipeline->remove(this);
+    pipeline->finalize();
+  });
+}
+
+void ProtocolMultiplexHandler::fail(Context* ctx, const std::string& msg) {
+  for (auto& candidate : candidates_) {
+    candidate.eliminated = true;
+  }
+  ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+      "ProtocolMultiplexHandler: " + msg));
+}
+
+} // namespace wangle
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <folly/Function.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * Selects one of several protocol sub-chains by peeking at the first
+ * bytes of a connection, for listeners that serve multiple wire
+ * protocols on one port.
+ *
+ * Like TLSPlaintextPeekingCallback, detection inspects the buffered
+ * bytes in place: detectors receive the socket handler's own
+ * IOBufQueue and examine it through a Cursor without splitting or
+ * copying. Once a detector matches, its installer splices the
+ * protocol's handlers into the pipeline exactly once and the buffered
+ * prefix is replayed into them by firing the same queue downstream --
+ * no second buffer and no re-injection copy. After selection the
+ * handler schedules its own removal from the pipeline, so the steady
+ * state carries no multiplexing overhead at all.
+ */
+class ProtocolMultiplexHandler : public BytesToBytesHandler {
+ public:
+  enum class DetectResult {
+    // The prefix identifies this protocol; install its chain.
+    MATCH,
+    // The prefix is consistent with this protocol but too short to be
+    // conclusive; ask again when more bytes arrive.
+    NEED_MORE_DATA,
+    // The prefix rules this protocol out for good.
+    NO_MATCH,
+  };
+
+  /**
+   * Inspects the buffered prefix without consuming it. Detectors must
+   * not split or pop the queue; read it via front() and a Cursor.
+   */
+  using Detector = folly::Function<DetectResult(const folly::IOBufQueue&)>;
+
+  /**
+   * Appends the matched protocol's handlers to the pipeline and
+   * finalizes it. The installer downcasts to the concrete pipeline
+   * type it built the base of, so the addBack calls type-check.
+   */
+  using ChainInstaller = folly::Function<void(PipelineBase*)>;
+
+  /**
+   * Connections still undecided after maxDetectBytes buffered bytes
+   * are failed rather than buffered without bound.
+   */
+  explicit ProtocolMultiplexHandler(size_t maxDetectBytes = 1024);
+
+  /**
+   * Registers a protocol. Detectors run in registration order on each
+   * read until one matches, so put the cheapest or most common
+   * protocol first.
+   */
+  ProtocolMultiplexHandler&
+  addProtocol(std::string name, Detector detector, ChainInstaller installer);
+
+  /**
+   * The name of the selected protocol, or an empty string while
+   * detection is still in progress.
+   */
+  const std::string& getSelectedProtocol() const {
+    return selectedProtocol_;
+  }
+
+  void read(Context* ctx, folly::IOBufQueue& q) override;
+
+ private:
+  struct Candidate {
+    std::string name;
+    Detector detect;
+    ChainInstaller install;
+    bool eliminated{false};
+  };
+
+  void select(Context* ctx, Candidate& candidate, folly::IOBufQueue& q);
+  void scheduleRemoval(Context* ctx);
+  void fail(Context* ctx, const std::string& msg);
+
+  std::vector<Candidate> candidates_;
+  size_t maxDetectBytes_;
+  bool selected_{false};
+  std::string selectedProtocol_;
+};
+
+} // namespace wangle
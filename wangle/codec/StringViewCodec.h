@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * A string view that owns the IOBuf backing it. StringViewCodec produces
+ * these on the read path so inbound messages are never copied; call
+ * str() when an owned std::string is really needed.
+ */
+class IOBufString {
+ public:
+  IOBufString() = default;
+
+  explicit IOBufString(std::unique_ptr<folly::IOBuf> buf)
+      : buf_(std::move(buf)) {
+    if (buf_) {
+      if (buf_->isChained()) {
+        buf_->coalesce();
+      }
+      view_.reset(
+          reinterpret_cast<const char*>(buf_->data()), buf_->length());
+    }
+  }
+
+  folly::StringPiece view() const {
+    return view_;
+  }
+
+  /* implicit */ operator folly::StringPiece() const {
+    return view_;
+  }
+
+  std::string str() const {
+    return view_.str();
+  }
+
+  const char* data() const {
+    return view_.data();
+  }
+
+  size_t size() const {
+    return view_.size();
+  }
+
+  bool empty() const {
+    return view_.empty();
+  }
+
+ private:
+  std::unique_ptr<folly::IOBuf> buf_;
+  folly::StringPiece view_;
+};
+
+inline bool operator==(const IOBufString& lhs, folly::StringPiece rhs) {
+  return lhs.view() == rhs;
+}
+
+inline bool operator==(folly::StringPiece lhs, const IOBufString& rhs) {
+  return lhs == rhs.view();
+}
+
+/*
+ * StringViewCodec is StringCodec without the copies: reads retain the
+ * backing IOBuf behind an IOBufString view instead of copying into a
+ * std::string (a chained buf is coalesced, the common single-buffer
+ * case is untouched), and writes move the string to the heap and wrap
+ * its storage in an IOBuf that frees it once the write completes. The
+ * write side still takes std::string, so pipelines keep their string
+ * ergonomics.
+ */
+class StringViewCodec : public Handler<
+                            std::unique_ptr<folly::IOBuf>,
+                            IOBufString,
+                            std::string,
+                            std::unique_ptr<folly::IOBuf>> {
+ public:
+  typedef typename Handler<
+      std::unique_ptr<folly::IOBuf>,
+      IOBufString,
+      std::string,
+      std::unique_ptr<folly::IOBuf>>::Context Context;
+
+  void read(Context* ctx, std::unique_ptr<folly::IOBuf> buf) override {
+    if (buf) {
+      ctx->fireRead(IOBufString(std::move(buf)));
+    }
+  }
+
+  folly::Future<folly::Unit> write(Context* ctx, std::string msg) override {
+    if (msg.empty()) {
+      return ctx->fireWrite(folly::IOBuf::create(0));
+    }
+    auto* storage = new std::string(std::move(msg));
+    auto buf = folly::IOBuf::takeOwnership(
+        storage->data(),
+        storage->size(),
+        [](void* /* data */, void* userData) {
+          delete static_cast<std::string*>(userData);
+        },
+        storage);
+    return ctx->fireWrite(std::move(buf));
+  }
+};
+
+} // namespace wangle
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/codec/VarintLengthFrameCodec.h>
+
+using folly::Future;
+using folly::IOBuf;
+using folly::IOBufQueue;
+using folly::Unit;
+
+namespace wangle {
+
+void VarintLengthFramePrepender::attachPipeline(Context* ctx) {
+  // The worst-case header; encoders allocating through the pipeline's
+  // write headroom then always hit the zero-allocation path below.
+  ctx->getPipeline()->reserveWriteHeadroom(folly::kMaxVarintLength64);
+}
+
+Future<Unit> VarintLengthFramePrepender::write(
+    Context* ctx,
+    std::unique_ptr<IOBuf> buf) {
+  uint8_t header[folly::kMaxVarintLength64];
+  size_t headerSize = folly::encodeVarint(buf->computeChainDataLength(), header);
+
+  if (buf->headroom() >= headerSize && !buf->isSharedOne()) {
+    // Zero-allocation path: the header fits in the head buffer's headroom.
+    buf->prepend(headerSize);
+    memcpy(buf->writableData(), header, headerSize);
+    return ctx->fireWrite(std::move(buf));
+  }
+
+  auto len = IOBuf::create(headerSize);
+  len->append(headerSize);
+  memcpy(len->writableData(), header, headerSize);
+  len->prependChain(std::move(buf));
+  return ctx->fireWrite(std::move(len));
+}
+
+VarintLengthFrameDecoder::VarintLengthFrameDecoder(uint64_t maxFrameLength)
+    : maxFrameLength_(maxFrameLength) {
+  CHECK(maxFrameLength > 0);
+}
+
+bool VarintLengthFrameDecoder::decode(
+    Context* ctx,
+    IOBufQueue& buf,
+    std::unique_ptr<IOBuf>& result,
+    size_t&) {
+  const size_t avail = buf.chainLength();
+  folly::io::Cursor c(buf.front());
+  uint64_t frameLength = 0;
+  size_t headerSize = 0;
+  int shift = 0;
+
+  while (true) {
+    if (headerSize == avail) {
+      // Header incomplete, wait for more data.
+      return false;
+    }
+    if (headerSize == folly::kMaxVarintLength64) {
+      buf.trimStart(headerSize);
+      ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+          "Invalid varint length header"));
+      return false;
+    }
+    uint8_t byte = c.read<uint8_t>();
+    headerSize++;
+    frameLength |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+    shift += 7;
+  }
+
+  if (frameLength > maxFrameLength_) {
+    buf.trimStartAtMost(headerSize + frameLength);
+    ctx->fireReadException(folly::make_exception_wrapper<std::runtime_error>(
+        "Frame larger than " + folly::to<std::string>(maxFrameLength_)));
+    return false;
+  }
+
+  if (avail - headerSize < frameLength) {
+    return false;
+  }
+
+  buf.trimStart(headerSize);
+  result = buf.split(frameLength);
+  return true;
+}
+
+} // namespace wangle
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Varint.h>
+#include <folly/io/Cursor.h>
+#include <wangle/codec/ByteToMessageDecoder.h>
+
+namespace wangle {
+
+/**
+ * An encoder that prepends the length of the message as a LEB128 varint.
+ *
+ * For example, a 12-byte message is framed with a single length byte:
+ *
+ * +------+----------------+
+ * + 0x0C | "HELLO, WORLD" |
+ * +------+----------------+
+ *
+ * while a 300-byte message gets a two-byte header (0xAC 0x02).
+ *
+ * When the message's head buffer has enough headroom and is not shared,
+ * the header is written into the headroom, so framing allocates nothing;
+ * otherwise a header IOBuf is prepended to the chain, as
+ * LengthFieldPrepender does.
+ *
+ * @see VarintLengthFrameDecoder
+ */
+class VarintLengthFramePrepender : public OutboundBytesToBytesHandler {
+ public:
+  void attachPipeline(Context* ctx) override;
+
+  folly::Future<folly::Unit> write(
+      Context* ctx,
+      std::unique_ptr<folly::IOBuf> buf) override;
+};
+
+/**
+ * A decoder that splits the received IOBufs by a varint length header,
+ * the inverse of VarintLengthFramePrepender. The header is parsed byte
+ * by byte through a Cursor, so a varint split across IOBufs is decoded
+ * across the seam without coalescing (and thus without copying payload
+ * data).
+ */
+class VarintLengthFrameDecoder : public ByteToByteDecoder {
+ public:
+  explicit VarintLengthFrameDecoder(uint64_t maxFrameLength = UINT_MAX);
+
+  bool decode(
+      Context* ctx,
+      folly::IOBufQueue& buf,
+      std::unique_ptr<folly::IOBuf>& result,
+      size_t&) override;
+
+ private:
+  uint64_t maxFrameLength_;
+};
+
+} // namespace wangle
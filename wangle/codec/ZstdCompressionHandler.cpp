@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/codec/ZstdCompressionHandler.h>
+
+using folly::Future;
+using folly::IOBuf;
+using folly::IOBufQueue;
+using folly::Unit;
+using FlushOp = folly::io::StreamCodec::FlushOp;
+
+namespace wangle {
+
+namespace {
+
+constexpr size_t kOutputChunkSize = 4096;
+
+folly::MutableByteRange preallocateOutput(
+    IOBufQueue& out,
+    std::pair<void*, std::size_t>& pre) {
+  pre = out.preallocate(kOutputChunkSize, kOutputChunkSize);
+  return folly::MutableByteRange(
+      static_cast<uint8_t*>(pre.first), pre.second);
+}
+
+} // namespace
+
+ZstdCompressionHandler::ZstdCompressionHandler(int level)
+    : codec_(folly::io::getStreamCodec(folly::io::CodecType::ZSTD, level)) {
+  codec_->resetStream(folly::none);
+}
+
+Future<Unit> ZstdCompressionHandler::write(
+    Context* ctx,
+    std::unique_ptr<IOBuf> buf) {
+  if (UNLIKELY(!buf)) {
+    return ctx->fireWrite(std::move(buf));
+  }
+
+  IOBufQueue out(IOBufQueue::cacheChainLength());
+  std::pair<void*, std::size_t> pre;
+
+  for (auto range : *buf) {
+    folly::ByteRange input = range;
+    while (!input.empty()) {
+      auto output = preallocateOutput(out, pre);
+      codec_->compressStream(input, output, FlushOp::NONE);
+      out.postallocate(pre.second - output.size());
+    }
+  }
+
+  // Flush so the peer can decode this write without waiting for more
+  // data; the stream itself stays open for the next write.
+  bool flushed = false;
+  while (!flushed) {
+    folly::ByteRange empty;
+    auto output = preallocateOutput(out, pre);
+    flushed = codec_->compressStream(empty, output, FlushOp::FLUSH);
+    out.postallocate(pre.second - output.size());
+  }
+
+  return ctx->fireWrite(out.move());
+}
+
+ZstdDecompressionHandler::ZstdDecompressionHandler()
+    : codec_(folly::io::getStreamCodec(folly::io::CodecType::ZSTD)) {
+  codec_->resetStream(folly::none);
+}
+
+void ZstdDecompressionHandler::read(Context* ctx, IOBufQueue& q) {
+  auto chain = q.move();
+  if (!chain) {
+    return;
+  }
+
+  std::pair<void*, std::size_t> pre;
+  for (auto range : *chain) {
+    folly::ByteRange input = range;
+    // Keep going while there is input left or the previous chunk filled
+    // completely, which means the codec may have more buffered output.
+    bool outputFull = true;
+    while (!input.empty() || outputFull) {
+      auto output = preallocateOutput(decompressed_, pre);
+      bool frameEnded = codec_->uncompressStream(input, output, FlushOp::NONE);
+      outputFull = output.empty();
+      decompressed_.postallocate(pre.second - output.size());
+      if (frameEnded) {
+        // The peer ended a zstd frame (e.g. a one-shot compressor on the
+        // other side); be ready for the next one.
+        codec_->resetStream(folly::none);
+      }
+    }
+  }
+
+  if (!decompressed_.empty()) {
+    ctx->fireRead(decompressed_);
+  }
+}
+
+} // namespace wangle
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/compression/Compression.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+
+/**
+ * An outbound handler that compresses every write with a streaming zstd
+ * context. The context is reused across writes, so the compressor's
+ * history window spans the whole connection (small frames compress far
+ * better than with one-shot compression), and each write ends with a
+ * zstd flush so the peer can decode it without waiting for more data.
+ *
+ * Input is consumed chain element by chain element and output is
+ * appended straight into an IOBufQueue; nothing is flattened or copied
+ * through an intermediate buffer.
+ *
+ * Typically installed below the framing codec, directly above
+ * AsyncSocketHandler:
+ *
+ *   pipeline->addBack(AsyncSocketHandler(socket));
+ *   pipeline->addBack(ZstdDecompressionHandler());
+ *   pipeline->addBack(ZstdCompressionHandler(level));
+ *   pipeline->addBack(LengthFieldBasedFrameDecoder());
+ *   ...
+ *
+ * This handler may only be used in a single Pipeline.
+ */
+class ZstdCompressionHandler : public OutboundBytesToBytesHandler {
+ public:
+  explicit ZstdCompressionHandler(
+      int level = folly::io::COMPRESSION_LEVEL_DEFAULT);
+
+  folly::Future<folly::Unit> write(
+      Context* ctx,
+      std::unique_ptr<folly::IOBuf> buf) override;
+
+ private:
+  std::unique_ptr<folly::io::StreamCodec> codec_;
+};
+
+/**
+ * The inbound counterpart of ZstdCompressionHandler: decompresses reads
+ * with a streaming zstd context reused across reads, handling
+ * compressed data split at arbitrary IOBuf seams without coalescing.
+ * Fires the decompressed bytes as an IOBufQueue so the usual frame
+ * decoders chain directly behind it.
+ *
+ * This handler may only be used in a single Pipeline.
+ */
+class ZstdDecompressionHandler : public InboundHandler<folly::IOBufQueue&> {
+ public:
+  ZstdDecompressionHandler();
+
+  void read(Context* ctx, folly::IOBufQueue& q) override;
+
+ private:
+  std::unique_ptr<folly::io::StreamCodec> codec_;
+  folly::IOBufQueue decompressed_{folly::IOBufQueue::cacheChainLength()};
+};
+
+} // namespace wangle
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+
+#include <wangle/codec/ChecksumHandler.h>
+#include <wangle/codec/CoroDecoder.h>
+#include <wangle/codec/FixedLengthFrameDecoder.h>
+#include <wangle/codec/LengthFieldBasedFrameDecoder.h>
+#include <wangle/codec/LengthFieldPrepender.h>
+#include <wangle/codec/LineBasedFrameDecoder.h>
+#include <wangle/codec/MessageToByteEncoder.h>
+#include <wangle/codec/VarintLengthFrameCodec.h>
+#include <wangle/codec/test/CodecTestUtils.h>
+
+using namespace folly;
+using namespace folly::io;
+using namespace wangle;
+
+namespace {
+
+/**
+ * Feeds clones of one well-formed frame through a pipeline ending in the
+ * given decoder, so the numbers isolate decode cost per frame.
+ */
+template <class Decoder>
+void runDecode(size_t iters, Decoder decoder, std::unique_ptr<IOBuf> frame) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+  (*pipeline)
+      .addBack(std::move(decoder))
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    q.append(frame->clone());
+    pipeline->read(q);
+  }
+  doNotOptimizeAway(frames);
+}
+
+std::unique_ptr<IOBuf> makeFrame(size_t size) {
+  auto frame = IOBuf::create(size);
+  frame->append(size);
+  std::memset(frame->writableData(), 'x', size);
+  return frame;
+}
+
+std::unique_ptr<IOBuf> makeLengthFieldFrame(size_t payloadSize) {
+  auto frame = makeFrame(payloadSize + 4);
+  RWPrivateCursor c(frame.get());
+  c.writeBE(uint32_t(payloadSize));
+  return frame;
+}
+
+std::unique_ptr<IOBuf> makeVarintFrame(size_t payloadSize) {
+  uint8_t header[folly::kMaxVarintLength64];
+  size_t headerSize = folly::encodeVarint(payloadSize, header);
+  auto frame = makeFrame(payloadSize + headerSize);
+  std::memcpy(frame->writableData(), header, headerSize);
+  return frame;
+}
+
+/**
+ * Like runDecode, but delivers each frame in two read events split
+ * mid-header, so the numbers cover the partial-input resumption path
+ * (state-machine replay vs coroutine jump).
+ */
+template <class Decoder>
+void runSplitDecode(
+    size_t iters,
+    Decoder decoder,
+    std::unique_ptr<IOBuf> frame) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+  (*pipeline)
+      .addBack(std::move(decoder))
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+  auto head = frame->clone();
+  head->trimEnd(frame->length() - 2);
+  auto tail = frame->clone();
+  tail->trimStart(2);
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    q.append(head->clone());
+    pipeline->read(q);
+    q.append(tail->clone());
+    pipeline->read(q);
+  }
+  doNotOptimizeAway(frames);
+}
+
+#if FOLLY_HAS_COROUTINES
+
+// The coroutine twin of LengthFieldBasedFrameDecoder's default shape:
+// 4-byte big-endian length prefix, header stripped. See CoroDecoder.h.
+class CoroLengthFieldDecoder
+    : public CoroByteToMessageDecoder<std::unique_ptr<IOBuf>> {
+ public:
+  DecoderGenerator<std::unique_ptr<IOBuf>> decodeFrames(
+      DecoderByteSource& source) override {
+    while (true) {
+      co_await source.need(4);
+      Cursor c(source.buffer().front());
+      auto length = c.readBE<uint32_t>();
+      co_await source.need(4 + length);
+      source.buffer().trimStart(4);
+      co_yield source.buffer().split(length);
+    }
+  }
+};
+
+#endif // FOLLY_HAS_COROUTINES
+
+std::unique_ptr<IOBuf> makeLineFrame(size_t size) {
+  auto frame = makeFrame(size);
+  frame->writableData()[size - 1] = '\n';
+  return frame;
+}
+
+// One iteration is one 64KB read event full of frameSize-byte frames —
+// the market-data shape — so the bulk numbers compare the per-frame
+// fireRead loop against decodeBatch's single-pass slice directly.
+constexpr size_t kBulkReadSize = 64 * 1024;
+
+void runBulkFixedDecode(size_t iters, size_t frameSize) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+  (*pipeline)
+      .addBack(FixedLengthFrameDecoder(frameSize))
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+  auto bulk = makeFrame(kBulkReadSize - kBulkReadSize % frameSize);
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    q.append(bulk->clone());
+    pipeline->read(q);
+  }
+  doNotOptimizeAway(frames);
+}
+
+struct BatchCounter
+    : InboundHandler<ReadBatch<std::unique_ptr<IOBuf>>&, folly::Unit> {
+  explicit BatchCounter(size_t& frames) : frames_(frames) {}
+  void read(Context*, ReadBatch<std::unique_ptr<IOBuf>>& batch) override {
+    frames_ += batch.size();
+  }
+  size_t& frames_;
+};
+
+void runBulkBatchedFixedDecode(size_t iters, size_t frameSize) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&>::create();
+  size_t frames = 0;
+  (*pipeline)
+      .addBack(BatchedByteToMessageDecoder<FixedLengthFrameDecoder>(frameSize))
+      .addBack(BatchCounter(frames))
+      .finalize();
+  auto bulk = makeFrame(kBulkReadSize - kBulkReadSize % frameSize);
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    q.append(bulk->clone());
+    pipeline->read(q);
+  }
+  doNotOptimizeAway(frames);
+}
+
+// Allocates exactly the payload, so every framing stage downstream has
+// to allocate and splice its own buffer.
+class PlainStringEncoder : public MessageToByteEncoder<std::string> {
+ public:
+  std::unique_ptr<IOBuf> encode(std::string& msg) override {
+    auto buf = IOBuf::create(msg.size());
+    std::memcpy(buf->writableTail(), msg.data(), msg.size());
+    buf->append(msg.size());
+    return buf;
+  }
+};
+
+// Allocates through newEncodeBuffer(), so the length field and checksum
+// trailer land in the reserved head/tailroom: one allocation per message.
+class ReservingStringEncoder : public MessageToByteEncoder<std::string> {
+ public:
+  std::unique_ptr<IOBuf> encode(std::string& msg) override {
+    auto buf = newEncodeBuffer(msg.size());
+    std::memcpy(buf->writableTail(), msg.data(), msg.size());
+    buf->append(msg.size());
+    return buf;
+  }
+};
+
+struct EncodeSink : OutboundBytesToBytesHandler {
+  explicit EncodeSink(size_t& chains) : chains_(chains) {}
+  Future<Unit> write(Context*, std::unique_ptr<IOBuf> buf) override {
+    // Chain elements per message is the allocation count: 1 on the
+    // reserving path, up to 3 on the plain one.
+    chains_ += buf->countChainElements();
+    return makeFuture();
+  }
+  size_t& chains_;
+};
+
+/**
+ * Drives whole-message encodes through checksum plus length framing,
+ * comparing the headroom-reserving encode protocol against per-stage
+ * allocation.
+ */
+template <class Encoder>
+void runEncode(size_t iters, size_t payloadSize) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&, std::string>::create();
+  size_t chains = 0;
+  (*pipeline)
+      .addBack(EncodeSink(chains))
+      .addBack(LengthFieldPrepender())
+      .addBack(ChecksumHandler())
+      .addBack(Encoder())
+      .finalize();
+  std::string msg(payloadSize, 'x');
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    pipeline->write(msg);
+  }
+  doNotOptimizeAway(chains);
+}
+
+} // namespace
+
+BENCHMARK(fixedLengthDecode16, iters) {
+  runDecode(iters, FixedLengthFrameDecoder(16), makeFrame(16));
+}
+
+BENCHMARK(fixedLengthDecode4096, iters) {
+  runDecode(iters, FixedLengthFrameDecoder(4096), makeFrame(4096));
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(lengthFieldDecode16, iters) {
+  runDecode(iters, LengthFieldBasedFrameDecoder(), makeLengthFieldFrame(16));
+}
+
+BENCHMARK_RELATIVE(lengthFieldDecodeSpecialized16, iters) {
+  runDecode(
+      iters, LengthFieldBasedFrameDecoderT<4>(), makeLengthFieldFrame(16));
+}
+
+#if FOLLY_HAS_COROUTINES
+BENCHMARK_RELATIVE(lengthFieldDecodeCoro16, iters) {
+  runDecode(iters, CoroLengthFieldDecoder(), makeLengthFieldFrame(16));
+}
+#endif
+
+BENCHMARK(lengthFieldDecode4096, iters) {
+  runDecode(iters, LengthFieldBasedFrameDecoder(), makeLengthFieldFrame(4096));
+}
+
+BENCHMARK_RELATIVE(lengthFieldDecodeSpecialized4096, iters) {
+  runDecode(
+      iters, LengthFieldBasedFrameDecoderT<4>(), makeLengthFieldFrame(4096));
+}
+
+#if FOLLY_HAS_COROUTINES
+BENCHMARK_RELATIVE(lengthFieldDecodeCoro4096, iters) {
+  runDecode(iters, CoroLengthFieldDecoder(), makeLengthFieldFrame(4096));
+}
+#endif
+
+BENCHMARK_DRAW_LINE();
+
+// Split delivery exercises what the coroutine base is for: resuming a
+// parked decode instead of replaying the framing state machine.
+BENCHMARK(lengthFieldDecodeSplit16, iters) {
+  runSplitDecode(
+      iters, LengthFieldBasedFrameDecoder(), makeLengthFieldFrame(16));
+}
+
+#if FOLLY_HAS_COROUTINES
+BENCHMARK_RELATIVE(lengthFieldDecodeCoroSplit16, iters) {
+  runSplitDecode(iters, CoroLengthFieldDecoder(), makeLengthFieldFrame(16));
+}
+#endif
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(varintDecode16, iters) {
+  runDecode(iters, VarintLengthFrameDecoder(), makeVarintFrame(16));
+}
+
+BENCHMARK(varintDecode4096, iters) {
+  runDecode(iters, VarintLengthFrameDecoder(), makeVarintFrame(4096));
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(lineBasedDecode16, iters) {
+  runDecode(iters, LineBasedFrameDecoder(), makeLineFrame(16));
+}
+
+BENCHMARK(lineBasedDecode4096, iters) {
+  runDecode(iters, LineBasedFrameDecoder(4096), makeLineFrame(4096));
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(fixedLengthBulkRead64, iters) {
+  runBulkFixedDecode(iters, 64);
+}
+
+BENCHMARK_RELATIVE(fixedLengthBulkRead64Batched, iters) {
+  runBulkBatchedFixedDecode(iters, 64);
+}
+
+BENCHMARK(fixedLengthBulkRead128, iters) {
+  runBulkFixedDecode(iters, 128);
+}
+
+BENCHMARK_RELATIVE(fixedLengthBulkRead128Batched, iters) {
+  runBulkBatchedFixedDecode(iters, 128);
+}
+
+BENCHMARK(fixedLengthBulkRead256, iters) {
+  runBulkFixedDecode(iters, 256);
+}
+
+BENCHMARK_RELATIVE(fixedLengthBulkRead256Batched, iters) {
+  runBulkBatchedFixedDecode(iters, 256);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(lengthFieldChecksumEncode16, iters) {
+  runEncode<PlainStringEncoder>(iters, 16);
+}
+
+BENCHMARK_RELATIVE(lengthFieldChecksumEncodeReserved16, iters) {
+  runEncode<ReservingStringEncoder>(iters, 16);
+}
+
+BENCHMARK(lengthFieldChecksumEncode4096, iters) {
+  runEncode<PlainStringEncoder>(iters, 4096);
+}
+
+BENCHMARK_RELATIVE(lengthFieldChecksumEncodeReserved4096, iters) {
+  runEncode<ReservingStringEncoder>(iters, 4096);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -14,12 +14,23 @@
  * limitations under the License.
  */
 
+#include <folly/hash/Checksum.h>
 #include <folly/portability/GTest.h>
 
+#include <wangle/codec/ChecksumHandler.h>
+#include <wangle/codec/ChunkedFrameDecoder.h>
+#include <wangle/codec/CodecStats.h>
+#include <wangle/codec/CoroDecoder.h>
 #include <wangle/codec/FixedLengthFrameDecoder.h>
+#include <wangle/codec/FrameView.h>
 #include <wangle/codec/LengthFieldBasedFrameDecoder.h>
 #include <wangle/codec/LengthFieldPrepender.h>
 #include <wangle/codec/LineBasedFrameDecoder.h>
+#include <wangle/codec/MessageToByteEncoder.h>
+#include <wangle/codec/ProtocolMultiplexHandler.h>
+#include <wangle/codec/StringViewCodec.h>
+#include <wangle/codec/VarintLengthFrameCodec.h>
+#include <wangle/codec/ZstdCompressionHandler.h>
 #include <wangle/codec/test/CodecTestUtils.h>
 
 using namespace folly;
@@ -67,6 +78,50 @@ TEST(FixedLengthFrameDecoder, FailWhenLengthFieldEndOffset) {
   EXPECT_EQ(called, 3);
 }
 
+TEST(CodecStats, RecordsFrameShape) {
+  CodecStats stats;
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  auto decoder = std::make_shared<FixedLengthFrameDecoder>(10);
+  decoder->setCodecStats(&stats);
+  int called = 0;
+
+  (*pipeline)
+      .addBack(decoder)
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> /* buf */) { called++; }))
+      .finalize();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  // A partial frame stalls: nothing decoded, three bytes left buffered.
+  q.append(createZeroedBuffer(3));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+  EXPECT_EQ(stats.frames, 0);
+  EXPECT_EQ(stats.stalledReads, 1);
+
+  // The rest arrives: one 10-byte frame, completed on its second read
+  // event.
+  q.append(createZeroedBuffer(7));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+  EXPECT_EQ(stats.frames, 1);
+  // 10-byte frames land in the [8, 16) bucket.
+  EXPECT_EQ(stats.frameSizes.buckets[4], 1);
+  // The frame took two decode calls, one per read event.
+  EXPECT_EQ(stats.decodeCallsPerFrame.buckets[2], 1);
+
+  // Two whole frames in one read, each completing on its first call.
+  q.append(createZeroedBuffer(20));
+  pipeline->read(q);
+  EXPECT_EQ(called, 3);
+  EXPECT_EQ(stats.frames, 3);
+  EXPECT_EQ(stats.frameSizes.buckets[4], 3);
+  EXPECT_EQ(stats.decodeCallsPerFrame.buckets[1], 2);
+  // The trailing probe on an emptied queue is not a stall.
+  EXPECT_EQ(stats.stalledReads, 1);
+}
+
 TEST(LengthFieldFramePipeline, SimpleTest) {
   auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
   int called = 0;
@@ -418,6 +473,147 @@ TEST(LengthFieldFrameDecoder, FailTestNotEnoughBytes) {
   EXPECT_EQ(called, 1);
 }
 
+TEST(LengthFieldFrameDecoderT, Simple) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoderT<4>())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        auto sz = buf->computeChainDataLength();
+        called++;
+        EXPECT_EQ(sz, 1);
+      }))
+      .finalize();
+
+  auto bufFrame = createZeroedBuffer(4);
+  RWPrivateCursor c(bufFrame.get());
+  c.writeBE((uint32_t)1);
+  auto bufData = createZeroedBuffer(1);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  q.append(std::move(bufFrame));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+
+  q.append(std::move(bufData));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(LengthFieldFrameDecoderT, LittleEndianNoStrip) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoderT<2, false>(10, 0))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        auto sz = buf->computeChainDataLength();
+        called++;
+        EXPECT_EQ(sz, 3);
+      }))
+      .finalize();
+
+  auto bufFrame = createZeroedBuffer(2);
+  RWPrivateCursor c(bufFrame.get());
+  c.writeLE((uint16_t)1);
+  auto bufData = createZeroedBuffer(1);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  q.append(std::move(bufFrame));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+
+  q.append(std::move(bufData));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(LengthFieldFrameDecoderT, Adjustment) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoderT<2, true, -2>(10, 0))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        auto sz = buf->computeChainDataLength();
+        called++;
+        EXPECT_EQ(sz, 3);
+      }))
+      .finalize();
+
+  auto bufFrame = createZeroedBuffer(2);
+  RWPrivateCursor c(bufFrame.get());
+  c.writeBE((uint16_t)3); // includes frame size
+  auto bufData = createZeroedBuffer(1);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  q.append(std::move(bufFrame));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+
+  q.append(std::move(bufData));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(LengthFieldFrameDecoderT, HeaderSpansBuffers) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoderT<4>())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        auto sz = buf->computeChainDataLength();
+        called++;
+        EXPECT_EQ(sz, 1);
+      }))
+      .finalize();
+
+  // Split the 4-byte length field across two IOBufs so the slow
+  // (cursor) extraction path runs.
+  auto part1 = createZeroedBuffer(2);
+  auto part2 = createZeroedBuffer(3);
+  RWPrivateCursor c2(part2.get());
+  c2.writeBE<uint8_t>(0);
+  c2.writeBE<uint8_t>(1);
+  c2.writeBE<uint8_t>(0xEF);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(part1));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+  q.append(std::move(part2));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(LengthFieldFrameDecoderT, FailTestFrameTooLarge) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoderT<4>(10))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        ASSERT_EQ(nullptr, buf);
+        called++;
+      }))
+      .finalize();
+
+  auto bufFrame = createZeroedBuffer(16);
+  RWPrivateCursor c(bufFrame.get());
+  c.writeBE((uint32_t)7); // frame size - 1 byte too large (7 > 10 - 4)
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  q.append(std::move(bufFrame));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
 TEST(LineBasedFrameDecoder, Simple) {
   auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
   int called = 0;
@@ -640,3 +836,994 @@ TEST(LineBasedFrameDecoder, DoubleCarriage) {
   pipeline->read(q);
   EXPECT_EQ(called, 2);
 }
+
+TEST(BatchedByteToMessageDecoder, BatchesFramesFromOneRead) {
+  auto pipeline = Pipeline<IOBufQueue&>::create();
+  size_t batches = 0;
+  size_t frames = 0;
+
+  struct BatchTester
+      : InboundHandler<ReadBatch<std::unique_ptr<IOBuf>>&, folly::Unit> {
+    explicit BatchTester(size_t& batches, size_t& frames)
+        : batches_(batches), frames_(frames) {}
+    void read(Context*, ReadBatch<std::unique_ptr<IOBuf>>& batch) override {
+      batches_++;
+      frames_ += batch.size();
+      for (auto& buf : batch) {
+        EXPECT_EQ(buf->computeChainDataLength(), 4);
+      }
+    }
+    size_t& batches_;
+    size_t& frames_;
+  };
+
+  (*pipeline)
+      .addBack(BatchedByteToMessageDecoder<FixedLengthFrameDecoder>(4))
+      .addBack(BatchTester(batches, frames))
+      .finalize();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  // Three complete frames plus a partial one arrive in a single read event:
+  // one batch of three frames should be fired.
+  q.append(createZeroedBuffer(14));
+  pipeline->read(q);
+  EXPECT_EQ(batches, 1);
+  EXPECT_EQ(frames, 3);
+
+  // Nothing decodable: no batch at all.
+  q.append(createZeroedBuffer(1));
+  pipeline->read(q);
+  EXPECT_EQ(batches, 1);
+
+  // Completing the partial frame fires a batch of one.
+  q.append(createZeroedBuffer(1));
+  pipeline->read(q);
+  EXPECT_EQ(batches, 2);
+  EXPECT_EQ(frames, 4);
+}
+
+TEST(LineBasedFrameDecoder, SplitCarriageReturnAcrossBuffers) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LineBasedFrameDecoder(
+          100, true, LineBasedFrameDecoder::TerminatorType::CARRIAGENEWLINE))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 3);
+      }))
+      .finalize();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  // "\r\n" split across two reads (and two IOBufs): the remembered scan
+  // offset must back up over the trailing '\r'.
+  q.append(IOBuf::copyBuffer("abc\r"));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+  q.append(IOBuf::copyBuffer("\n"));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(LineBasedFrameDecoder, IncrementalScanLongLine) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LineBasedFrameDecoder(1000))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 300);
+      }))
+      .finalize();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  std::string chunk(100, 'x');
+  q.append(IOBuf::copyBuffer(chunk));
+  pipeline->read(q);
+  q.append(IOBuf::copyBuffer(chunk));
+  pipeline->read(q);
+  q.append(IOBuf::copyBuffer(chunk));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+
+  q.append(IOBuf::copyBuffer("\nrest"));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+  EXPECT_EQ(q.chainLength(), 4);
+}
+
+TEST(LengthFieldFrameDecoder, HeaderSpansBuffersNoCoalesce) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoder(4))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 1);
+      }))
+      .finalize();
+
+  // Split the 4-byte length field across two IOBufs so the slow gather path
+  // runs; the payload buffers must still be shared, not copied.
+  auto part1 = createZeroedBuffer(2);
+  auto part2 = createZeroedBuffer(3);
+  RWPrivateCursor c2(part2.get());
+  c2.writeBE<uint8_t>(0);
+  c2.writeBE<uint8_t>(1);
+  c2.writeBE<uint8_t>(0xEF);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(part1));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+  q.append(std::move(part2));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(VarintLengthFramePipeline, SimpleTest) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(test::BytesReflector())
+      .addBack(VarintLengthFramePrepender())
+      .addBack(VarintLengthFrameDecoder())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        auto sz = buf->computeChainDataLength();
+        called++;
+        EXPECT_EQ(sz, 300);
+      }))
+      .finalize();
+
+  // 300 bytes takes a two-byte varint header.
+  auto buf = createZeroedBuffer(300);
+  pipeline->write(std::move(buf));
+  EXPECT_EQ(called, 1);
+}
+
+namespace {
+class FrameCapture : public OutboundBytesToBytesHandler {
+ public:
+  explicit FrameCapture(folly::Function<void(std::unique_ptr<IOBuf>)> test)
+      : test_(std::move(test)) {}
+
+  Future<Unit> write(Context*, std::unique_ptr<IOBuf> buf) override {
+    test_(std::move(buf));
+    return makeFuture();
+  }
+
+ private:
+  folly::Function<void(std::unique_ptr<IOBuf>)> test_;
+};
+} // namespace
+
+TEST(VarintLengthFramePrepender, HeadroomNoAllocation) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(FrameCapture([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        // The header was written into the payload's headroom rather than
+        // a prepended IOBuf.
+        EXPECT_FALSE(buf->isChained());
+        EXPECT_EQ(buf->computeChainDataLength(), 3);
+        EXPECT_EQ(buf->data()[0], 2);
+      }))
+      .addBack(VarintLengthFramePrepender())
+      .finalize();
+
+  auto buf = IOBuf::create(16);
+  buf->advance(8);
+  buf->append(2);
+  std::memset(buf->writableData(), 0x00, 2);
+  pipeline->write(std::move(buf));
+  EXPECT_EQ(called, 1);
+}
+
+TEST(ChecksumHandler, RoundTripThroughLengthFieldPipeline) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(test::BytesReflector())
+      .addBack(LengthFieldPrepender())
+      .addBack(LengthFieldBasedFrameDecoder())
+      .addBack(ChecksumHandler())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        // The trailer was covered by the length field on the way out and
+        // stripped again on the way in.
+        EXPECT_EQ(buf->computeChainDataLength(), 16);
+      }))
+      .finalize();
+
+  pipeline->write(createZeroedBuffer(16));
+  EXPECT_EQ(called, 1);
+}
+
+TEST(ChecksumHandler, AppendsBigEndianCrc32cTrailer) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(FrameCapture([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        auto bytes = buf->coalesce();
+        ASSERT_EQ(bytes.size(), 7);
+        auto expected = folly::crc32c(bytes.data(), bytes.size() - 4);
+        Cursor c(buf.get());
+        c.skip(3);
+        EXPECT_EQ(c.readBE<uint32_t>(), expected);
+      }))
+      .addBack(ChecksumHandler())
+      .finalize();
+
+  pipeline->write(IOBuf::copyBuffer("abc"));
+  EXPECT_EQ(called, 1);
+}
+
+TEST(ChecksumHandler, RejectsCorruptFrame) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int frames = 0;
+  int errors = 0;
+
+  (*pipeline)
+      .addBack(FixedLengthFrameDecoder(8))
+      .addBack(ChecksumHandler())
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { buf ? frames++ : errors++; }))
+      .finalize();
+
+  // An all-zero trailer does not match the payload: the frame is dropped
+  // and surfaced as a readException.
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(createZeroedBuffer(8));
+  pipeline->read(q);
+  EXPECT_EQ(frames, 0);
+  EXPECT_EQ(errors, 1);
+
+  // The same payload with its real checksum passes.
+  auto payload = createZeroedBuffer(4);
+  auto trailer = createZeroedBuffer(4);
+  RWPrivateCursor c(trailer.get());
+  c.writeBE(folly::crc32c(payload->data(), 4));
+  q.append(std::move(payload));
+  q.append(std::move(trailer));
+  pipeline->read(q);
+  EXPECT_EQ(frames, 1);
+  EXPECT_EQ(errors, 1);
+}
+
+TEST(LengthFieldPrepender, HeadroomNoAllocation) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(FrameCapture([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        // The field was written into the payload's headroom rather than
+        // a prepended IOBuf.
+        EXPECT_FALSE(buf->isChained());
+        EXPECT_EQ(buf->computeChainDataLength(), 6);
+        Cursor c(buf.get());
+        EXPECT_EQ(c.readBE<uint32_t>(), 2);
+      }))
+      .addBack(LengthFieldPrepender())
+      .finalize();
+
+  auto buf = IOBuf::create(16);
+  buf->advance(8);
+  buf->append(2);
+  std::memset(buf->writableData(), 0x00, 2);
+  pipeline->write(std::move(buf));
+  EXPECT_EQ(called, 1);
+}
+
+namespace {
+// Copies the string into a buffer allocated with the framing stages'
+// reserved headroom and tailroom around it.
+class ReservingStringEncoder : public MessageToByteEncoder<std::string> {
+ public:
+  std::unique_ptr<IOBuf> encode(std::string& msg) override {
+    auto buf = newEncodeBuffer(msg.size());
+    std::memcpy(buf->writableTail(), msg.data(), msg.size());
+    buf->append(msg.size());
+    return buf;
+  }
+};
+} // namespace
+
+TEST(MessageToByteEncoder, OneAllocationThroughFramingStages) {
+  auto pipeline = Pipeline<IOBufQueue&, std::string>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(FrameCapture([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        // Length field, payload and checksum trailer all landed in the
+        // encoder's single buffer: header in the reserved headroom,
+        // trailer in the reserved tailroom.
+        EXPECT_FALSE(buf->isChained());
+        ASSERT_EQ(buf->computeChainDataLength(), 4 + 5 + 4);
+        Cursor c(buf.get());
+        EXPECT_EQ(c.readBE<uint32_t>(), 5 + 4);
+      }))
+      .addBack(LengthFieldPrepender())
+      .addBack(ChecksumHandler())
+      .addBack(ReservingStringEncoder())
+      .finalize();
+
+  pipeline->write(std::string("hello"));
+  EXPECT_EQ(called, 1);
+}
+
+TEST(VarintLengthFrameDecoder, HeaderSpansBuffers) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(VarintLengthFrameDecoder())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 300);
+      }))
+      .finalize();
+
+  // Split the two-byte varint header (300 = 0xAC 0x02) across IOBufs.
+  auto part1 = IOBuf::create(1);
+  part1->append(1);
+  part1->writableData()[0] = 0xAC;
+  auto part2 = createZeroedBuffer(301);
+  part2->writableData()[0] = 0x02;
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(part1));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+  q.append(std::move(part2));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+namespace {
+class QueueTester : public InboundHandler<IOBufQueue&> {
+ public:
+  explicit QueueTester(folly::Function<void(IOBufQueue&)> test)
+      : test_(std::move(test)) {}
+
+  void read(Context*, IOBufQueue& q) override {
+    test_(q);
+  }
+
+ private:
+  folly::Function<void(IOBufQueue&)> test_;
+};
+} // namespace
+
+namespace {
+class StringViewTester : public InboundHandler<IOBufString> {
+ public:
+  explicit StringViewTester(folly::Function<void(IOBufString)> test)
+      : test_(std::move(test)) {}
+
+  void read(Context*, IOBufString msg) override {
+    test_(std::move(msg));
+  }
+
+ private:
+  folly::Function<void(IOBufString)> test_;
+};
+} // namespace
+
+TEST(StringViewCodec, ZeroCopyRead) {
+  auto pipeline = Pipeline<std::unique_ptr<IOBuf>, std::string>::create();
+  int called = 0;
+  const uint8_t* payload = nullptr;
+
+  (*pipeline)
+      .addBack(StringViewCodec())
+      .addBack(StringViewTester([&](IOBufString msg) {
+        called++;
+        EXPECT_EQ(msg, StringPiece("hello view"));
+        // The view points into the original buffer, not a copy.
+        EXPECT_EQ(reinterpret_cast<const uint8_t*>(msg.data()), payload);
+      }))
+      .finalize();
+
+  auto buf = IOBuf::copyBuffer("hello view");
+  payload = buf->data();
+  pipeline->read(std::move(buf));
+  EXPECT_EQ(called, 1);
+}
+
+TEST(StringViewCodec, ZeroCopyWrite) {
+  auto pipeline = Pipeline<std::unique_ptr<IOBuf>, std::string>::create();
+  int called = 0;
+  const char* storage = nullptr;
+
+  (*pipeline)
+      .addBack(FrameCapture([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 64);
+        // The IOBuf wraps the string's heap storage rather than copying.
+        EXPECT_EQ(reinterpret_cast<const char*>(buf->data()), storage);
+      }))
+      .addBack(StringViewCodec())
+      .finalize();
+
+  std::string msg(64, 'x');
+  storage = msg.data();
+  pipeline->write(std::move(msg));
+  EXPECT_EQ(called, 1);
+}
+
+namespace {
+class FrameViewTester : public InboundHandler<FrameView> {
+ public:
+  explicit FrameViewTester(folly::Function<void(FrameView)> test)
+      : test_(std::move(test)) {}
+
+  void read(Context*, FrameView msg) override {
+    test_(std::move(msg));
+  }
+
+ private:
+  folly::Function<void(FrameView)> test_;
+};
+} // namespace
+
+TEST(FrameViewCodec, ChainedReadInPlace) {
+  auto pipeline =
+      Pipeline<std::unique_ptr<IOBuf>, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+  const uint8_t* payload = nullptr;
+
+  (*pipeline)
+      .addBack(FrameViewCodec())
+      .addBack(FrameViewTester([&](FrameView msg) {
+        called++;
+        EXPECT_EQ(msg.size(), 6);
+        // The frame is still chained; no coalesce happened.
+        EXPECT_TRUE(msg.buf()->isChained());
+        EXPECT_EQ(msg.buf()->data(), payload);
+        // Typed reads walk the chain in place, across the buffer
+        // boundary.
+        auto cursor = msg.reader();
+        EXPECT_EQ(cursor.readBE<uint32_t>(), 0x12345678);
+        EXPECT_EQ(cursor.readFixedString(2), "hi");
+
+        // Copies refcount the same storage instead of copying bytes.
+        FrameView copy = msg;
+        EXPECT_EQ(copy.buf()->data(), msg.buf()->data());
+        EXPECT_EQ(copy.reader().readBE<uint16_t>(), 0x1234);
+      }))
+      .finalize();
+
+  auto head = IOBuf::copyBuffer("\x12\x34", 2);
+  head->prependChain(IOBuf::copyBuffer("\x56\x78hi", 4));
+  payload = head->data();
+  pipeline->read(std::move(head));
+  EXPECT_EQ(called, 1);
+}
+
+TEST(ZstdCompressionPipeline, RoundTrip) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  std::string decoded;
+
+  (*pipeline)
+      .addBack(test::BytesReflector())
+      .addBack(ZstdDecompressionHandler())
+      .addBack(QueueTester([&](IOBufQueue& q) {
+        auto buf = q.move();
+        buf->coalesce();
+        decoded.append(
+            reinterpret_cast<const char*>(buf->data()), buf->length());
+      }))
+      .addBack(ZstdCompressionHandler(1))
+      .finalize();
+
+  std::string msg1(1024, 'a');
+  std::string msg2 = "hello compressed world";
+  pipeline->write(IOBuf::copyBuffer(msg1));
+  // The streaming context spans writes; each write is flushed so it
+  // decodes on its own.
+  pipeline->write(IOBuf::copyBuffer(msg2));
+  EXPECT_EQ(decoded, msg1 + msg2);
+}
+
+TEST(VarintLengthFrameDecoder, FailTooLargeFrame) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(VarintLengthFrameDecoder(10))
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        ASSERT_EQ(nullptr, buf);
+        called++;
+      }))
+      .finalize();
+
+  auto buf = IOBuf::create(1);
+  buf->append(1);
+  buf->writableData()[0] = 11;
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(buf));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+namespace {
+
+using MuxPipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>;
+
+ProtocolMultiplexHandler::DetectResult detectLine(const IOBufQueue& q) {
+  Cursor c(q.front());
+  while (!c.isAtEnd()) {
+    if (c.read<char>() == '\n') {
+      return ProtocolMultiplexHandler::DetectResult::MATCH;
+    }
+  }
+  return ProtocolMultiplexHandler::DetectResult::NEED_MORE_DATA;
+}
+
+ProtocolMultiplexHandler::DetectResult detectLengthPrefixed(
+    const IOBufQueue& q) {
+  // Short length-prefixed frames lead with a 0x00 length byte; the
+  // printable line protocol never does.
+  Cursor c(q.front());
+  return c.read<uint8_t>() == 0x00
+      ? ProtocolMultiplexHandler::DetectResult::MATCH
+      : ProtocolMultiplexHandler::DetectResult::NO_MATCH;
+}
+
+class MuxErrorTester : public BytesToBytesHandler {
+ public:
+  explicit MuxErrorTester(int* errors) : errors_(errors) {}
+
+  void readException(Context*, exception_wrapper) override {
+    (*errors_)++;
+  }
+
+ private:
+  int* errors_;
+};
+
+} // namespace
+
+TEST(ProtocolMultiplexHandler, SelectsLineProtocolAndReplays) {
+  auto pipeline = MuxPipeline::create();
+  std::vector<std::string> frames;
+
+  ProtocolMultiplexHandler mux;
+  mux.addProtocol(
+         "length",
+         detectLengthPrefixed,
+         [](PipelineBase*) { ADD_FAILURE() << "wrong protocol installed"; })
+      .addProtocol("line", detectLine, [&](PipelineBase* p) {
+        auto* pl = static_cast<MuxPipeline*>(p);
+        (*pl)
+            .addBack(LineBasedFrameDecoder())
+            .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+              auto bytes = buf->coalesce();
+              frames.emplace_back(
+                  reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            }))
+            .finalize();
+      });
+  (*pipeline).addBack(std::move(mux)).finalize();
+  auto* handler = pipeline->getHandler<ProtocolMultiplexHandler>();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer("hello\nworld\n"));
+  pipeline->read(q);
+
+  // Both frames from the buffered prefix were replayed into the
+  // installed chain.
+  EXPECT_EQ(handler->getSelectedProtocol(), "line");
+  ASSERT_EQ(frames.size(), 2);
+  EXPECT_EQ(frames[0], "hello");
+  EXPECT_EQ(frames[1], "world");
+
+  // Later reads pass straight through; detection does not rerun.
+  q.append(IOBuf::copyBuffer("again\n"));
+  pipeline->read(q);
+  ASSERT_EQ(frames.size(), 3);
+  EXPECT_EQ(frames[2], "again");
+}
+
+TEST(ProtocolMultiplexHandler, SelectsLengthPrefixedProtocol) {
+  auto pipeline = MuxPipeline::create();
+  std::vector<std::string> frames;
+
+  ProtocolMultiplexHandler mux;
+  mux.addProtocol(
+         "length",
+         detectLengthPrefixed,
+         [&](PipelineBase* p) {
+           auto* pl = static_cast<MuxPipeline*>(p);
+           (*pl)
+               .addBack(LengthFieldBasedFrameDecoder(2, 10, 0, 0, 2))
+               .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+                 auto bytes = buf->coalesce();
+                 frames.emplace_back(
+                     reinterpret_cast<const char*>(bytes.data()),
+                     bytes.size());
+               }))
+               .finalize();
+         })
+      .addProtocol("line", detectLine, [](PipelineBase*) {
+        ADD_FAILURE() << "wrong protocol installed";
+      });
+  (*pipeline).addBack(std::move(mux)).finalize();
+  auto* handler = pipeline->getHandler<ProtocolMultiplexHandler>();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer("\x00\x05hello", 7));
+  pipeline->read(q);
+
+  EXPECT_EQ(handler->getSelectedProtocol(), "length");
+  ASSERT_EQ(frames.size(), 1);
+  EXPECT_EQ(frames[0], "hello");
+}
+
+TEST(ProtocolMultiplexHandler, AccumulatesUntilDecisive) {
+  auto pipeline = MuxPipeline::create();
+  std::vector<std::string> frames;
+
+  ProtocolMultiplexHandler mux;
+  mux.addProtocol("length", detectLengthPrefixed, [](PipelineBase*) {
+       ADD_FAILURE() << "wrong protocol installed";
+     }).addProtocol("line", detectLine, [&](PipelineBase* p) {
+    auto* pl = static_cast<MuxPipeline*>(p);
+    (*pl)
+        .addBack(LineBasedFrameDecoder())
+        .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+          auto bytes = buf->coalesce();
+          frames.emplace_back(
+              reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }))
+        .finalize();
+  });
+  (*pipeline).addBack(std::move(mux)).finalize();
+  auto* handler = pipeline->getHandler<ProtocolMultiplexHandler>();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer("he"));
+  pipeline->read(q);
+
+  // Too short to decide; the prefix stays buffered in the queue.
+  EXPECT_EQ(handler->getSelectedProtocol(), "");
+  EXPECT_EQ(q.chainLength(), 2);
+
+  q.append(IOBuf::copyBuffer("llo\n"));
+  pipeline->read(q);
+
+  EXPECT_EQ(handler->getSelectedProtocol(), "line");
+  ASSERT_EQ(frames.size(), 1);
+  EXPECT_EQ(frames[0], "hello");
+}
+
+TEST(ProtocolMultiplexHandler, FailsWhenAllDetectorsReject) {
+  auto pipeline = MuxPipeline::create();
+  int errors = 0;
+
+  ProtocolMultiplexHandler mux;
+  mux.addProtocol("length", detectLengthPrefixed, [](PipelineBase*) {
+    ADD_FAILURE() << "nothing should be installed";
+  });
+  (*pipeline)
+      .addBack(std::move(mux))
+      .addBack(MuxErrorTester(&errors))
+      .finalize();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(IOBuf::copyBuffer("GARBAGE"));
+  pipeline->read(q);
+  EXPECT_EQ(errors, 1);
+}
+
+TEST(ProtocolMultiplexHandler, FailsWhenUndecidedPastCap) {
+  auto pipeline = MuxPipeline::create();
+  int errors = 0;
+
+  ProtocolMultiplexHandler mux(4);
+  mux.addProtocol(
+      "stalling",
+      [](const IOBufQueue&) {
+        return ProtocolMultiplexHandler::DetectResult::NEED_MORE_DATA;
+      },
+      [](PipelineBase*) { ADD_FAILURE() << "nothing should be installed"; });
+  (*pipeline)
+      .addBack(std::move(mux))
+      .addBack(MuxErrorTester(&errors))
+      .finalize();
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(createZeroedBuffer(8));
+  pipeline->read(q);
+  EXPECT_EQ(errors, 1);
+}
+
+namespace {
+
+class ChunkTester : public InboundHandler<FrameChunk> {
+ public:
+  ChunkTester(std::vector<FrameChunk>* chunks, int* errors)
+      : chunks_(chunks), errors_(errors) {}
+
+  void read(Context*, FrameChunk chunk) override {
+    chunks_->push_back(std::move(chunk));
+  }
+
+  void readException(Context*, exception_wrapper) override {
+    (*errors_)++;
+  }
+
+ private:
+  std::vector<FrameChunk>* chunks_;
+  int* errors_;
+};
+
+} // namespace
+
+TEST(ChunkedFrameDecoder, SmallFramesDeliveredWhole) {
+  auto pipeline = Pipeline<IOBufQueue&, FrameChunk>::create();
+  std::vector<FrameChunk> chunks;
+  int errors = 0;
+
+  (*pipeline)
+      .addBack(ChunkedLengthFieldBasedFrameDecoder(
+          4, UINT_MAX, 64 /* streamingThreshold */))
+      .addBack(ChunkTester(&chunks, &errors))
+      .finalize();
+
+  // Two sub-threshold frames in one read.
+  auto bufs = createZeroedBuffer(4 + 10 + 4 + 20);
+  RWPrivateCursor c(bufs.get());
+  c.writeBE((uint32_t)10);
+  c.skip(10);
+  c.writeBE((uint32_t)20);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(bufs));
+  pipeline->read(q);
+
+  ASSERT_EQ(chunks.size(), 2);
+  EXPECT_EQ(chunks[0].kind, FrameChunk::Kind::WHOLE);
+  EXPECT_EQ(chunks[0].frameLength, 10);
+  EXPECT_EQ(chunks[0].data->computeChainDataLength(), 10);
+  EXPECT_EQ(chunks[1].kind, FrameChunk::Kind::WHOLE);
+  EXPECT_EQ(chunks[1].data->computeChainDataLength(), 20);
+  EXPECT_EQ(errors, 0);
+}
+
+TEST(ChunkedFrameDecoder, StreamsLargeFrameIncrementally) {
+  auto pipeline = Pipeline<IOBufQueue&, FrameChunk>::create();
+  std::vector<FrameChunk> chunks;
+  int errors = 0;
+
+  (*pipeline)
+      .addBack(ChunkedLengthFieldBasedFrameDecoder(
+          4, UINT_MAX, 16 /* streamingThreshold */))
+      .addBack(ChunkTester(&chunks, &errors))
+      .finalize();
+
+  auto header = createZeroedBuffer(4);
+  RWPrivateCursor c(header.get());
+  c.writeBE((uint32_t)40);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(header));
+  q.append(createZeroedBuffer(10));
+  pipeline->read(q);
+
+  // The frame is announced and its first slice forwarded before the
+  // rest of the body exists; nothing is left buffering in the queue.
+  ASSERT_EQ(chunks.size(), 2);
+  EXPECT_EQ(chunks[0].kind, FrameChunk::Kind::START);
+  EXPECT_EQ(chunks[0].frameLength, 40);
+  EXPECT_EQ(chunks[1].kind, FrameChunk::Kind::BODY);
+  EXPECT_EQ(chunks[1].data->computeChainDataLength(), 10);
+  EXPECT_EQ(q.chainLength(), 0);
+
+  q.append(createZeroedBuffer(25));
+  pipeline->read(q);
+  ASSERT_EQ(chunks.size(), 3);
+  EXPECT_EQ(chunks[2].data->computeChainDataLength(), 25);
+
+  // The read completing the body also carries the next (small) frame;
+  // the decoder ends the stream and keeps decoding.
+  auto tail = createZeroedBuffer(5 + 4 + 3);
+  RWPrivateCursor tc(tail.get());
+  tc.skip(5);
+  tc.writeBE((uint32_t)3);
+  q.append(std::move(tail));
+  pipeline->read(q);
+
+  ASSERT_EQ(chunks.size(), 6);
+  EXPECT_EQ(chunks[3].kind, FrameChunk::Kind::BODY);
+  EXPECT_EQ(chunks[3].data->computeChainDataLength(), 5);
+  EXPECT_EQ(chunks[4].kind, FrameChunk::Kind::END);
+  EXPECT_EQ(chunks[5].kind, FrameChunk::Kind::WHOLE);
+  EXPECT_EQ(chunks[5].data->computeChainDataLength(), 3);
+  EXPECT_EQ(errors, 0);
+}
+
+TEST(ChunkedFrameDecoder, FailsFrameOverMax) {
+  auto pipeline = Pipeline<IOBufQueue&, FrameChunk>::create();
+  std::vector<FrameChunk> chunks;
+  int errors = 0;
+
+  (*pipeline)
+      .addBack(ChunkedLengthFieldBasedFrameDecoder(
+          4, 1024 /* maxFrameLength */, 64))
+      .addBack(ChunkTester(&chunks, &errors))
+      .finalize();
+
+  auto header = createZeroedBuffer(4);
+  RWPrivateCursor c(header.get());
+  c.writeBE((uint32_t)2048);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(header));
+  pipeline->read(q);
+
+  EXPECT_EQ(chunks.size(), 0);
+  EXPECT_EQ(errors, 1);
+}
+
+#if FOLLY_HAS_COROUTINES
+
+namespace {
+
+class CoroLengthFieldDecoder
+    : public CoroByteToMessageDecoder<std::unique_ptr<IOBuf>> {
+ public:
+  DecoderGenerator<std::unique_ptr<IOBuf>> decodeFrames(
+      DecoderByteSource& source) override {
+    while (true) {
+      co_await source.need(4);
+      Cursor c(source.buffer().front());
+      auto length = c.readBE<uint32_t>();
+      if (length > 1024) {
+        throw std::runtime_error("frame too large");
+      }
+      co_await source.need(4 + length);
+      source.buffer().trimStart(4);
+      co_yield source.buffer().split(length);
+    }
+  }
+};
+
+} // namespace
+
+TEST(CoroDecoder, ResumesAcrossPartialReads) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(CoroLengthFieldDecoder())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 3);
+      }))
+      .finalize();
+
+  auto frame = createZeroedBuffer(7);
+  RWPrivateCursor c(frame.get());
+  c.writeBE((uint32_t)3);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  // Half a header parks the decoder mid-expression.
+  q.append(IOBuf::copyBuffer(frame->data(), 2));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+
+  // Header completes, payload is still short.
+  q.append(IOBuf::copyBuffer(frame->data() + 2, 3));
+  pipeline->read(q);
+  EXPECT_EQ(called, 0);
+
+  // The rest of the payload resumes and yields the frame.
+  q.append(IOBuf::copyBuffer(frame->data() + 5, 2));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+TEST(CoroDecoder, MultipleFramesInOneRead) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(CoroLengthFieldDecoder())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        called++;
+        EXPECT_EQ(buf->computeChainDataLength(), 1);
+      }))
+      .finalize();
+
+  auto twoFrames = createZeroedBuffer(10);
+  RWPrivateCursor c(twoFrames.get());
+  c.writeBE((uint32_t)1);
+  c.skip(1);
+  c.writeBE((uint32_t)1);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(twoFrames));
+  pipeline->read(q);
+  EXPECT_EQ(called, 2);
+}
+
+TEST(CoroDecoder, WorksUnderBatchingAdapter) {
+  auto pipeline = Pipeline<IOBufQueue&>::create();
+  size_t batches = 0;
+  size_t frames = 0;
+
+  struct BatchTester
+      : InboundHandler<ReadBatch<std::unique_ptr<IOBuf>>&, folly::Unit> {
+    explicit BatchTester(size_t& batches, size_t& frames)
+        : batches_(batches), frames_(frames) {}
+    void read(Context*, ReadBatch<std::unique_ptr<IOBuf>>& batch) override {
+      batches_++;
+      frames_ += batch.size();
+    }
+    size_t& batches_;
+    size_t& frames_;
+  };
+
+  (*pipeline)
+      .addBack(BatchedByteToMessageDecoder<CoroLengthFieldDecoder>())
+      .addBack(BatchTester(batches, frames))
+      .finalize();
+
+  auto twoFrames = createZeroedBuffer(10);
+  RWPrivateCursor c(twoFrames.get());
+  c.writeBE((uint32_t)1);
+  c.skip(1);
+  c.writeBE((uint32_t)1);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(twoFrames));
+  pipeline->read(q);
+  EXPECT_EQ(batches, 1);
+  EXPECT_EQ(frames, 2);
+}
+
+TEST(CoroDecoder, ExceptionFiresReadException) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int called = 0;
+
+  (*pipeline)
+      .addBack(CoroLengthFieldDecoder())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        ASSERT_EQ(nullptr, buf);
+        called++;
+      }))
+      .finalize();
+
+  auto bogus = createZeroedBuffer(4);
+  RWPrivateCursor c(bogus.get());
+  c.writeBE((uint32_t)2048);
+
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+  q.append(std::move(bogus));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+
+  // The decoder is finished for this connection; more bytes are inert.
+  q.append(createZeroedBuffer(8));
+  pipeline->read(q);
+  EXPECT_EQ(called, 1);
+}
+
+#endif // FOLLY_HAS_COROUTINES
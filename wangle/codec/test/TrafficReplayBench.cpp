@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+
+#include <wangle/codec/LengthFieldBasedFrameDecoder.h>
+#include <wangle/codec/LineBasedFrameDecoder.h>
+#include <wangle/codec/StringCodec.h>
+#include <wangle/codec/test/CodecTestUtils.h>
+#include <wangle/codec/test/TrafficTrace.h>
+#include <wangle/service/ServerDispatcher.h>
+#include <wangle/service/Service.h>
+
+using namespace folly;
+using namespace wangle;
+using namespace wangle::test;
+
+DEFINE_string(
+    trace_file,
+    "",
+    "Replay this recorded trace (TrafficTrace text format) instead of "
+    "running the built-in benchmarks");
+DEFINE_double(
+    speedup,
+    0.0,
+    "Divide recorded inter-arrival gaps by this; 0 replays flat out");
+DEFINE_int32(
+    frame_size,
+    512,
+    "Payload size of the synthesized frames sliced by --trace_file replay");
+
+namespace {
+
+/**
+ * Arrival events of fixed size covering totalBytes, i.e. a trace
+ * shaped like a sender saturating a path with a given read size.
+ */
+TrafficTrace traceOfArrivals(uint64_t totalBytes, uint32_t arrivalBytes) {
+  TrafficTrace trace;
+  while (totalBytes > 0) {
+    const auto bytes = std::min<uint64_t>(arrivalBytes, totalBytes);
+    trace.events.push_back({uint32_t(bytes), 0});
+    totalBytes -= bytes;
+  }
+  return trace;
+}
+
+std::vector<uint32_t> repeatMix(std::vector<uint32_t> mix, size_t times) {
+  std::vector<uint32_t> out;
+  out.reserve(mix.size() * times);
+  for (size_t i = 0; i < times; i++) {
+    out.insert(out.end(), mix.begin(), mix.end());
+  }
+  return out;
+}
+
+/**
+ * Replays a frame mix, delivered in arrivalBytes-sized reads, through
+ * a pipeline ending in the given decoder; one iteration is one full
+ * pass over the trace.
+ */
+template <class Decoder>
+void runReplay(
+    size_t iters,
+    Decoder decoder,
+    std::unique_ptr<IOBuf> stream,
+    uint32_t arrivalBytes) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+  (*pipeline)
+      .addBack(std::move(decoder))
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+  auto trace =
+      traceOfArrivals(stream->computeChainDataLength(), arrivalBytes);
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    replayTrace(trace, *stream, *pipeline);
+  }
+  doNotOptimizeAway(frames);
+}
+
+class EchoService : public Service<std::string, std::string> {
+ public:
+  Future<std::string> operator()(std::string req) override {
+    return req;
+  }
+};
+
+/**
+ * Swallows the dispatcher's responses so the replay measures the
+ * inbound path plus dispatch, not a transport.
+ */
+class ResponseSink : public OutboundBytesToBytesHandler {
+ public:
+  explicit ResponseSink(size_t& bytes) : bytes_(bytes) {}
+
+  Future<Unit> write(Context*, std::unique_ptr<IOBuf> buf) override {
+    bytes_ += buf->computeChainDataLength();
+    return makeFuture();
+  }
+
+ private:
+  size_t& bytes_;
+};
+
+/**
+ * The full server inbound path: framing, string decode, and a serial
+ * dispatcher invoking an echo service per request.
+ */
+void runDispatchReplay(
+    size_t iters,
+    std::unique_ptr<IOBuf> stream,
+    uint32_t arrivalBytes) {
+  BenchmarkSuspender susp;
+  auto pipeline = Pipeline<IOBufQueue&, std::string>::create();
+  EchoService service;
+  size_t responseBytes = 0;
+  (*pipeline)
+      .addBack(ResponseSink(responseBytes))
+      .addBack(LengthFieldBasedFrameDecoder())
+      .addBack(StringCodec())
+      .addBack(SerialServerDispatcher<std::string, std::string>(&service))
+      .finalize();
+  auto trace =
+      traceOfArrivals(stream->computeChainDataLength(), arrivalBytes);
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    replayTrace(trace, *stream, *pipeline);
+  }
+  doNotOptimizeAway(responseBytes);
+}
+
+} // namespace
+
+/*
+ * RPC-shaped traffic: mostly small requests with periodic large ones,
+ * coalesced into MTU-sized reads. The mix is where frame-straddling
+ * and small-frame-per-read pathologies show up.
+ */
+BENCHMARK(replayRpcMixMtuReads, iters) {
+  runReplay(
+      iters,
+      LengthFieldBasedFrameDecoder(),
+      makeLengthPrefixedStream(
+          repeatMix({16, 64, 16, 32, 4096, 16, 64, 700}, 64)),
+      1460);
+}
+
+/*
+ * Bulk transfer: large frames arriving in large socket reads.
+ */
+BENCHMARK(replayBulkTransfer, iters) {
+  runReplay(
+      iters,
+      LengthFieldBasedFrameDecoder(),
+      makeLengthPrefixedStream(repeatMix({65536}, 16)),
+      16384);
+}
+
+/*
+ * Line protocol with a production-ish length mix, one-MTU reads.
+ */
+BENCHMARK(replayLineMixMtuReads, iters) {
+  runReplay(
+      iters,
+      LineBasedFrameDecoder(4096),
+      makeLineStream(repeatMix({12, 80, 200, 12, 40, 1024}, 64)),
+      1460);
+}
+
+BENCHMARK_DRAW_LINE();
+
+/*
+ * The same RPC mix through framing + StringCodec + serial dispatch,
+ * so codec changes are also judged with the service path attached.
+ */
+BENCHMARK(replayRpcMixDispatched, iters) {
+  runDispatchReplay(
+      iters,
+      makeLengthPrefixedStream(
+          repeatMix({16, 64, 16, 32, 4096, 16, 64, 700}, 64)),
+      1460);
+}
+
+namespace {
+
+/**
+ * Replay a recorded trace file at recorded or accelerated pacing and
+ * print a one-line report.
+ */
+int replayTraceFile() {
+  std::string data;
+  if (!folly::readFile(FLAGS_trace_file.c_str(), data)) {
+    LOG(ERROR) << "cannot read " << FLAGS_trace_file;
+    return 1;
+  }
+  auto trace = TrafficTrace::parse(data);
+  if (!trace) {
+    LOG(ERROR) << FLAGS_trace_file << " is not a wangle-trace v1 file";
+    return 1;
+  }
+
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoder())
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+
+  auto stream = makeLengthPrefixedStream(
+      std::vector<uint32_t>(64, uint32_t(FLAGS_frame_size)));
+  auto report = replayTrace(*trace, *stream, *pipeline, FLAGS_speedup);
+
+  printf(
+      "%s: %lu events, %lu bytes, %lu frames, %.1f ms, %.1f MB/s\n",
+      FLAGS_trace_file.c_str(),
+      (unsigned long)report.events,
+      (unsigned long)report.bytes,
+      (unsigned long)frames,
+      report.wallTime.count() / 1000.0,
+      report.throughputMBps());
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (!FLAGS_trace_file.empty()) {
+    return replayTraceFile();
+  }
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/Optional.h>
+#include <folly/String.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <wangle/channel/Handler.h>
+
+namespace wangle {
+namespace test {
+
+/**
+ * One read event in a captured traffic trace: how many bytes arrived
+ * and how long after the previous event they arrived.
+ */
+struct TraceEvent {
+  uint32_t bytes{0};
+  uint32_t gapUs{0};
+};
+
+/**
+ * A length/timing-shaped traffic trace: the arrival-size and
+ * inter-arrival-time sequence of a connection, with no payload bytes.
+ * Traces recorded from production (TraceRecordingHandler) carry the
+ * real-world read coalescing and frame-size mix that synthetic
+ * benchmarks miss; replayTrace() drives them through an assembled
+ * pipeline.
+ *
+ * The serialized form is line oriented so traces are diffable and easy
+ * to sanitize by hand: a "wangle-trace v1" header, then one
+ * "<bytes> <gap-in-microseconds>" pair per line, with '#' comments
+ * ignored.
+ */
+class TrafficTrace {
+ public:
+  std::vector<TraceEvent> events;
+
+  uint64_t totalBytes() const {
+    uint64_t total = 0;
+    for (const auto& event : events) {
+      total += event.bytes;
+    }
+    return total;
+  }
+
+  std::string serialize() const {
+    std::string out = "wangle-trace v1\n";
+    for (const auto& event : events) {
+      out += folly::to<std::string>(event.bytes, ' ', event.gapUs, '\n');
+    }
+    return out;
+  }
+
+  static folly::Optional<TrafficTrace> parse(folly::StringPiece data) {
+    std::vector<folly::StringPiece> lines;
+    folly::split('\n', data, lines);
+    if (lines.empty() || folly::trimWhitespace(lines[0]) != "wangle-trace v1") {
+      return folly::none;
+    }
+    TrafficTrace trace;
+    for (size_t i = 1; i < lines.size(); i++) {
+      auto line = folly::trimWhitespace(lines[i]);
+      if (line.empty() || line.startsWith("#")) {
+        continue;
+      }
+      TraceEvent event;
+      if (!folly::split(' ', line, event.bytes, event.gapUs)) {
+        return folly::none;
+      }
+      trace.events.push_back(event);
+    }
+    return trace;
+  }
+};
+
+/**
+ * Records the arrival shape of a live connection. Install anywhere in
+ * a bytes-level pipeline; it forwards reads untouched and notes each
+ * event's size and gap since the previous one. Only lengths and
+ * timings are kept, never payload bytes, so the result is safe to
+ * attach to a report as-is.
+ */
+class TraceRecordingHandler : public BytesToBytesHandler {
+ public:
+  void read(Context* ctx, folly::IOBufQueue& q) override {
+    const auto now = std::chrono::steady_clock::now();
+    TraceEvent event;
+    event.bytes = q.chainLength() - lastResidual_;
+    if (!trace_.events.empty()) {
+      event.gapUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - lastRead_)
+                        .count();
+    }
+    trace_.events.push_back(event);
+    lastRead_ = now;
+    ctx->fireRead(q);
+    // Whatever the downstream decoders left buffered will be part of
+    // the next event's chain length; don't count it twice.
+    lastResidual_ = q.chainLength();
+  }
+
+  const TrafficTrace& trace() const {
+    return trace_;
+  }
+
+ private:
+  TrafficTrace trace_;
+  std::chrono::steady_clock::time_point lastRead_;
+  size_t lastResidual_{0};
+};
+
+/**
+ * A contiguous byte stream of length-prefixed frames (4-byte
+ * big-endian size, the LengthFieldBasedFrameDecoder default) with the
+ * given payload sizes, for replays to slice by arrival events.
+ */
+inline std::unique_ptr<folly::IOBuf> makeLengthPrefixedStream(
+    const std::vector<uint32_t>& payloadSizes) {
+  size_t total = 0;
+  for (const auto size : payloadSizes) {
+    total += size + sizeof(uint32_t);
+  }
+  auto stream = folly::IOBuf::create(total);
+  stream->append(total);
+  folly::io::RWPrivateCursor c(stream.get());
+  for (const auto size : payloadSizes) {
+    c.writeBE(uint32_t(size));
+    for (uint32_t i = 0; i < size; i++) {
+      c.write(uint8_t('x'));
+    }
+  }
+  return stream;
+}
+
+/**
+ * The same for newline-terminated frames, for line-based pipelines.
+ */
+inline std::unique_ptr<folly::IOBuf> makeLineStream(
+    const std::vector<uint32_t>& lineLengths) {
+  size_t total = 0;
+  for (const auto size : lineLengths) {
+    total += size + 1;
+  }
+  auto stream = folly::IOBuf::create(total);
+  stream->append(total);
+  folly::io::RWPrivateCursor c(stream.get());
+  for (const auto size : lineLengths) {
+    for (uint32_t i = 0; i < size; i++) {
+      c.write(uint8_t('x'));
+    }
+    c.write(uint8_t('\n'));
+  }
+  return stream;
+}
+
+struct ReplayReport {
+  uint64_t events{0};
+  uint64_t bytes{0};
+  std::chrono::microseconds wallTime{0};
+
+  double throughputMBps() const {
+    return wallTime.count() == 0
+        ? 0.0
+        : double(bytes) / double(wallTime.count());
+  }
+};
+
+/**
+ * Replays a trace through a pipeline: each trace event delivers its
+ * recorded number of bytes, sliced off the given stream (shared, not
+ * copied; the stream wraps around when exhausted, so it only needs to
+ * be long enough to be representative).
+ *
+ * speedup 0 replays flat out for throughput numbers; any other value
+ * divides the recorded inter-arrival gaps, so 1.0 reproduces recorded
+ * pacing and e.g. 10.0 compresses a ten-minute capture into a minute.
+ */
+template <class P>
+ReplayReport replayTrace(
+    const TrafficTrace& trace,
+    const folly::IOBuf& stream,
+    P& pipeline,
+    double speedup = 0.0) {
+  ReplayReport report;
+  if (stream.computeChainDataLength() == 0) {
+    return report;
+  }
+  folly::IOBufQueue q(folly::IOBufQueue::cacheChainLength());
+  folly::io::Cursor cursor(&stream);
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& event : trace.events) {
+    if (speedup > 0 && event.gapUs > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(uint64_t(event.gapUs / speedup)));
+    }
+    size_t remaining = event.bytes;
+    while (remaining > 0) {
+      std::unique_ptr<folly::IOBuf> chunk;
+      const size_t cloned = cursor.cloneAtMost(chunk, remaining);
+      if (cloned > 0) {
+        q.append(std::move(chunk));
+        remaining -= cloned;
+      }
+      if (remaining > 0) {
+        // Stream exhausted mid-event: wrap to the start. The stream
+        // ends on a frame boundary, so wrapped frames stay intact.
+        cursor = folly::io::Cursor(&stream);
+      }
+    }
+    pipeline.read(q);
+    report.events++;
+    report.bytes += event.bytes;
+  }
+  report.wallTime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  return report;
+}
+
+} // namespace test
+} // namespace wangle
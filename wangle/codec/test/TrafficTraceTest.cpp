@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/portability/GTest.h>
+#include <wangle/codec/LengthFieldBasedFrameDecoder.h>
+#include <wangle/codec/LineBasedFrameDecoder.h>
+#include <wangle/codec/test/CodecTestUtils.h>
+#include <wangle/codec/test/TrafficTrace.h>
+
+using namespace folly;
+using namespace wangle;
+using namespace wangle::test;
+
+TEST(TrafficTrace, SerializeParseRoundTrip) {
+  TrafficTrace trace;
+  trace.events = {{1460, 0}, {16, 120}, {65536, 5}};
+
+  auto parsed = TrafficTrace::parse(trace.serialize());
+  ASSERT_TRUE(parsed.hasValue());
+  ASSERT_EQ(parsed->events.size(), 3);
+  EXPECT_EQ(parsed->events[0].bytes, 1460);
+  EXPECT_EQ(parsed->events[1].gapUs, 120);
+  EXPECT_EQ(parsed->events[2].bytes, 65536);
+  EXPECT_EQ(parsed->totalBytes(), trace.totalBytes());
+}
+
+TEST(TrafficTrace, ParseSkipsCommentsAndRejectsGarbage) {
+  auto parsed = TrafficTrace::parse(
+      "wangle-trace v1\n"
+      "# sanitized capture, 2 events\n"
+      "100 0\n"
+      "\n"
+      "200 50\n");
+  ASSERT_TRUE(parsed.hasValue());
+  EXPECT_EQ(parsed->events.size(), 2);
+  EXPECT_EQ(parsed->totalBytes(), 300);
+
+  EXPECT_FALSE(TrafficTrace::parse("100 0\n").hasValue());
+  EXPECT_FALSE(
+      TrafficTrace::parse("wangle-trace v1\nnot numbers\n").hasValue());
+}
+
+TEST(TrafficTrace, RecordingHandlerCapturesArrivalShape) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  int frames = 0;
+
+  TraceRecordingHandler* recorder = nullptr;
+  (*pipeline)
+      .addBack(TraceRecordingHandler())
+      .addBack(LengthFieldBasedFrameDecoder())
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+  recorder = pipeline->getHandler<TraceRecordingHandler>();
+
+  auto stream = makeLengthPrefixedStream({10, 20});
+  IOBufQueue q(IOBufQueue::cacheChainLength());
+
+  // Deliver as two reads split mid-frame; the recorder must see the
+  // arrival sizes, not the decoded frame sizes.
+  io::Cursor c(stream.get());
+  std::unique_ptr<IOBuf> part;
+  c.clone(part, 17);
+  q.append(std::move(part));
+  pipeline->read(q);
+  c.clone(part, 21);
+  q.append(std::move(part));
+  pipeline->read(q);
+
+  EXPECT_EQ(frames, 2);
+  const auto& trace = recorder->trace();
+  ASSERT_EQ(trace.events.size(), 2);
+  EXPECT_EQ(trace.events[0].bytes, 17);
+  EXPECT_EQ(trace.events[1].bytes, 21);
+  EXPECT_EQ(trace.totalBytes(), 38);
+}
+
+TEST(TrafficTrace, ReplayDeliversEveryFrame) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+  uint64_t frameBytes = 0;
+
+  (*pipeline)
+      .addBack(LengthFieldBasedFrameDecoder())
+      .addBack(test::FrameTester([&](std::unique_ptr<IOBuf> buf) {
+        frames++;
+        frameBytes += buf->computeChainDataLength();
+      }))
+      .finalize();
+
+  // A production-ish mix: mostly small frames with a large outlier.
+  std::vector<uint32_t> payloads = {16, 16, 4096, 16, 700, 16};
+  auto stream = makeLengthPrefixedStream(payloads);
+  const auto streamBytes = stream->computeChainDataLength();
+
+  // Arrival events with awkward boundaries summing to the stream
+  // length, so frames straddle reads but everything is delivered.
+  TrafficTrace trace;
+  uint64_t remaining = streamBytes;
+  const uint32_t arrivals[] = {7, 1000, 3, 1460, 1460, 1};
+  for (const auto size : arrivals) {
+    const auto bytes = std::min<uint64_t>(size, remaining);
+    trace.events.push_back({uint32_t(bytes), 0});
+    remaining -= bytes;
+  }
+  trace.events.push_back({uint32_t(remaining), 0});
+
+  auto report = replayTrace(trace, *stream, *pipeline);
+
+  EXPECT_EQ(report.bytes, streamBytes);
+  EXPECT_EQ(report.events, trace.events.size());
+  EXPECT_EQ(frames, payloads.size());
+  EXPECT_EQ(frameBytes, 16 * 4 + 4096 + 700);
+}
+
+TEST(TrafficTrace, ReplayWrapsStreamOnFrameBoundaries) {
+  auto pipeline = Pipeline<IOBufQueue&, std::unique_ptr<IOBuf>>::create();
+  size_t frames = 0;
+
+  (*pipeline)
+      .addBack(LineBasedFrameDecoder(1024))
+      .addBack(test::FrameTester(
+          [&](std::unique_ptr<IOBuf> buf) { frames += buf ? 1 : 0; }))
+      .finalize();
+
+  auto stream = makeLineStream({9, 19});
+  const auto streamBytes = stream->computeChainDataLength();
+
+  // Three times around the stream in uneven arrival sizes.
+  TrafficTrace trace;
+  uint64_t remaining = streamBytes * 3;
+  while (remaining > 0) {
+    const auto bytes = std::min<uint64_t>(13, remaining);
+    trace.events.push_back({uint32_t(bytes), 0});
+    remaining -= bytes;
+  }
+
+  auto report = replayTrace(trace, *stream, *pipeline);
+
+  EXPECT_EQ(report.bytes, streamBytes * 3);
+  EXPECT_EQ(frames, 6);
+}
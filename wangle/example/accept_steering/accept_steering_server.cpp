@@ -26,6 +26,11 @@ using namespace folly;
 using namespace wangle;
 
 DEFINE_int32(port, 23, "test server port");
+DEFINE_bool(
+    lag_aware_steering,
+    false,
+    "Steer connections away from workers with high loop lag instead of "
+    "routing purely on the hashed client byte");
 
 /**
  * A simple server that hashes connections to worker threads
@@ -109,9 +114,16 @@ int main(int argc, char** argv) {
   auto childPipelineFactory = std::make_shared<ServerPipelineFactory>();
 
   ServerBootstrap<DefaultPipeline> server;
-  server.pipeline(
+  auto pipelineFactory =
       std::make_shared<AcceptRoutingPipelineFactory<DefaultPipeline, char>>(
-          &server, routingHandlerFactory, childPipelineFactory));
+          &server, routingHandlerFactory, childPipelineFactory);
+  if (FLAGS_lag_aware_steering) {
+    // A worker stuck in a long batch stops receiving new connections;
+    // the hashed worker is kept whenever its loop lag is healthy.
+    pipelineFactory->setWorkerSelectionPolicy(
+        std::make_shared<LagAwareWorkerSelectionPolicy>());
+  }
+  server.pipeline(pipelineFactory);
   server.bind(FLAGS_port);
   server.waitForStop();
 
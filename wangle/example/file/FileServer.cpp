@@ -22,6 +22,7 @@
 #include <wangle/channel/FileRegion.h>
 #include <wangle/codec/LineBasedFrameDecoder.h>
 #include <wangle/codec/StringCodec.h>
+#include <wangle/util/StaticFileCache.h>
 
 using namespace folly;
 using namespace wangle;
@@ -32,32 +33,28 @@ typedef Pipeline<IOBufQueue&, std::string> FileServerPipeline;
 
 class FileServerHandler : public HandlerAdapter<std::string> {
  public:
+  explicit FileServerHandler(std::shared_ptr<StaticFileCache> cache)
+      : cache_(std::move(cache)) {}
+
   void read(Context* ctx, std::string filename) override {
     if (filename == "bye") {
       close(ctx);
     }
 
-    int fd = open(filename.c_str(), O_RDONLY);
-    if (fd == -1) {
-      write(
-          ctx, sformat("Error opening {}: {}\r\n", filename, strerror(errno)));
-      return;
-    }
-
-    struct stat buf;
-    if (fstat(fd, &buf) == -1) {
-      write(
-          ctx,
-          sformat("Could not stat file {}: {}\r\n", filename, strerror(errno)));
+    auto file = cache_->getFile(filename);
+    if (!file) {
+      write(ctx, sformat("Error opening {}\r\n", filename));
       return;
     }
 
-    FileRegion fileRegion(fd, 0, buf.st_size);
+    FileRegion fileRegion(file->fd(), 0, file->size);
     auto guard = ctx->getPipelineShared();
+    // The cache entry is captured so the descriptor stays open even if
+    // the entry is invalidated while the transfer is in flight.
     fileRegion.transferTo(ctx->getTransport())
         .thenError(
             folly::tag_t<std::exception>{},
-            [this, guard, ctx, filename](const std::exception& e) {
+            [this, guard, file, ctx, filename](const std::exception& e) {
               write(
                   ctx,
                   sformat(
@@ -79,21 +76,31 @@ class FileServerHandler : public HandlerAdapter<std::string> {
     write(ctx, "Type the name of a file and it will be streamed to you!\r\n");
     write(ctx, "Type 'bye' to exit.\r\n");
   }
+
+ private:
+  std::shared_ptr<StaticFileCache> cache_;
 };
 
 class FileServerPipelineFactory : public PipelineFactory<FileServerPipeline> {
  public:
+  FileServerPipelineFactory()
+      : cache_(std::make_shared<StaticFileCache>()) {}
+
   FileServerPipeline::Ptr newPipeline(
       std::shared_ptr<AsyncTransport> sock) override {
     auto pipeline = FileServerPipeline::create();
     pipeline->addBack(AsyncSocketHandler(sock));
     pipeline->addBack(LineBasedFrameDecoder());
     pipeline->addBack(StringCodec());
-    pipeline->addBack(FileServerHandler());
+    pipeline->addBack(FileServerHandler(cache_));
     pipeline->finalize();
 
     return pipeline;
   }
+
+ private:
+  // One cache shared by every connection across all IO threads.
+  std::shared_ptr<StaticFileCache> cache_;
 };
 
 int main(int argc, char** argv) {
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+
+#include <folly/portability/GFlags.h>
+
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <wangle/bootstrap/ClientBootstrap.h>
+#include <wangle/channel/AsyncSocketHandler.h>
+#include <wangle/channel/EventBaseHandler.h>
+#include <wangle/codec/LineBasedFrameDecoder.h>
+#include <wangle/codec/StringCodec.h>
+#include <wangle/loadgen/LoadGenerator.h>
+#include <wangle/service/ClientDispatcher.h>
+
+using namespace folly;
+using namespace wangle;
+
+DEFINE_int32(port, 8080, "echo server port");
+DEFINE_string(host, "::1", "echo server address");
+DEFINE_int32(connections, 4, "number of connections");
+DEFINE_int32(io_threads, 2, "number of IO threads");
+DEFINE_double(rps, 1000, "request arrival rate, requests per second");
+DEFINE_int32(duration_s, 10, "run duration in seconds");
+
+typedef Pipeline<folly::IOBufQueue&, std::string> EchoPipeline;
+
+// The same stages an echo client would use; swap in any codec stack to
+// drive a different protocol.
+class EchoPipelineFactory : public PipelineFactory<EchoPipeline> {
+ public:
+  EchoPipeline::Ptr newPipeline(std::shared_ptr<AsyncTransport> sock) override {
+    auto pipeline = EchoPipeline::create();
+    pipeline->addBack(AsyncSocketHandler(sock));
+    pipeline->addBack(EventBaseHandler());
+    pipeline->addBack(LineBasedFrameDecoder(8192, false));
+    pipeline->addBack(StringCodec());
+    pipeline->finalize();
+    return pipeline;
+  }
+};
+
+using EchoDispatcher = PipelinedClientDispatcher<EchoPipeline, std::string>;
+
+int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
+
+  auto group = std::make_shared<folly::IOThreadPoolExecutor>(FLAGS_io_threads);
+  std::vector<std::unique_ptr<ClientBootstrap<EchoPipeline>>> clients;
+  std::vector<LoadGenerator<std::string>::Endpoint> endpoints;
+  SocketAddress address(FLAGS_host, FLAGS_port);
+
+  for (int i = 0; i < FLAGS_connections; i++) {
+    auto client = std::make_unique<ClientBootstrap<EchoPipeline>>();
+    client->group(group);
+    client->pipelineFactory(std::make_shared<EchoPipelineFactory>());
+    auto pipeline = client->connect(address).get();
+    // Pipelined so the open loop can issue requests while earlier ones
+    // are still in flight.
+    auto dispatcher = std::make_shared<EchoDispatcher>();
+    dispatcher->setPipeline(pipeline);
+    endpoints.push_back(
+        {dispatcher, pipeline->getTransport()->getEventBase()});
+    clients.push_back(std::move(client));
+  }
+
+  std::vector<LoadPhase> phases{
+      {FLAGS_rps, std::chrono::seconds(FLAGS_duration_s)}};
+  LoadGenerator<std::string> generator(
+      std::move(endpoints), std::move(phases), [] {
+        return std::string("ping\r\n");
+      });
+
+  auto report = generator.run();
+  std::cout << folly::toPrettyJson(report.toDynamic()) << std::endl;
+
+  return 0;
+}
@@ -20,6 +20,7 @@
 #include <wangle/bootstrap/ClientBootstrap.h>
 #include <wangle/bootstrap/ServerBootstrap.h>
 #include <wangle/channel/AsyncSocketHandler.h>
+#include <wangle/channel/PipelineBridge.h>
 
 using namespace folly;
 using namespace wangle;
@@ -28,98 +29,51 @@ DEFINE_int32(port, 1080, "proxy server port");
 DEFINE_string(remote_host, "127.0.0.1", "remote host");
 DEFINE_int32(remote_port, 23, "remote port");
 
-class ProxyBackendHandler : public InboundBytesToBytesHandler {
- public:
-  explicit ProxyBackendHandler(DefaultPipeline* frontendPipeline)
-      : frontendPipeline_(frontendPipeline) {}
-
-  void read(Context*, IOBufQueue& q) override {
-    frontendPipeline_->write(q.move());
-  }
-
-  void readEOF(Context*) override {
-    LOG(INFO) << "Connection closed by remote host";
-    frontendPipeline_->close();
-  }
-
-  void readException(Context*, exception_wrapper e) override {
-    LOG(ERROR) << "Remote error: " << exceptionStr(e);
-    frontendPipeline_->close();
-  }
-
- private:
-  DefaultPipeline* frontendPipeline_;
-};
-
 class ProxyBackendPipelineFactory : public PipelineFactory<DefaultPipeline> {
  public:
-  explicit ProxyBackendPipelineFactory(DefaultPipeline* frontendPipeline)
-      : frontendPipeline_(frontendPipeline) {}
+  explicit ProxyBackendPipelineFactory(
+      std::shared_ptr<PipelineBridge> frontendBridge)
+      : frontendBridge_(std::move(frontendBridge)) {}
 
   DefaultPipeline::Ptr newPipeline(
       std::shared_ptr<AsyncTransport> sock) override {
     auto pipeline = DefaultPipeline::create();
     pipeline->addBack(AsyncSocketHandler(sock));
-    pipeline->addBack(ProxyBackendHandler(frontendPipeline_));
+    auto backendBridge = std::make_shared<PipelineBridge>();
+    pipeline->addBack(backendBridge);
     pipeline->finalize();
 
+    // Both sides are established; from here on bytes relay directly
+    // between the two transports. Anything the frontend read while the
+    // connect was in flight flushes now.
+    PipelineBridge::tie(frontendBridge_, backendBridge);
+
     return pipeline;
   }
 
  private:
-  DefaultPipeline* frontendPipeline_;
+  std::shared_ptr<PipelineBridge> frontendBridge_;
 };
 
 class ProxyFrontendHandler : public BytesToBytesHandler {
  public:
-  explicit ProxyFrontendHandler(SocketAddress remoteAddress)
-      : remoteAddress_(remoteAddress) {}
+  ProxyFrontendHandler(
+      SocketAddress remoteAddress,
+      std::shared_ptr<PipelineBridge> bridge)
+      : remoteAddress_(remoteAddress), bridge_(std::move(bridge)) {}
 
-  void read(Context*, IOBufQueue& q) override {
-    buffer_.append(q);
-    if (!backendPipeline_) {
-      return;
-    }
-
-    backendPipeline_->write(buffer_.move());
-  }
-
-  void readEOF(Context* ctx) override {
-    LOG(INFO) << "Connection closed by local host";
-    if (!backendPipeline_) {
-      return;
-    }
-    backendPipeline_->close().thenValue(
-        [this, ctx](auto&&) { this->close(ctx); });
-  }
-
-  void readException(Context* ctx, exception_wrapper e) override {
-    LOG(ERROR) << "Local error: " << exceptionStr(e);
-    if (!backendPipeline_) {
-      return;
-    }
-    backendPipeline_->close().thenValue(
-        [this, ctx](auto&&) { this->close(ctx); });
-  }
+  // The bridge below relays (or buffers) all bytes; nothing reaches us.
+  void read(Context*, IOBufQueue&) override {}
 
   void transportActive(Context* ctx) override {
-    if (backendPipeline_) {
-      // Already connected
+    if (connectStarted_) {
       return;
     }
-
-    // Pause reading from the socket until remote connection succeeds
-    auto frontendPipeline = dynamic_cast<DefaultPipeline*>(ctx->getPipeline());
-    frontendPipeline->transportInactive();
+    connectStarted_ = true;
 
     client_.pipelineFactory(
-        std::make_shared<ProxyBackendPipelineFactory>(frontendPipeline));
+        std::make_shared<ProxyBackendPipelineFactory>(bridge_));
     client_.connect(remoteAddress_)
-        .thenValue([this, frontendPipeline](DefaultPipeline* pipeline) {
-          backendPipeline_ = pipeline;
-          // Resume read
-          frontendPipeline->transportActive();
-        })
         .thenError(
             folly::tag_t<std::exception>{},
             [this, ctx](const std::exception& e) {
@@ -130,9 +84,9 @@ class ProxyFrontendHandler : public BytesToBytesHandler {
 
  private:
   SocketAddress remoteAddress_;
+  std::shared_ptr<PipelineBridge> bridge_;
   ClientBootstrap<DefaultPipeline> client_;
-  DefaultPipeline* backendPipeline_{nullptr};
-  folly::IOBufQueue buffer_{folly::IOBufQueue::cacheChainLength()};
+  bool connectStarted_{false};
 };
 
 class ProxyFrontendPipelineFactory : public PipelineFactory<DefaultPipeline> {
@@ -144,7 +98,10 @@ class ProxyFrontendPipelineFactory : public PipelineFactory<DefaultPipeline> {
       std::shared_ptr<AsyncTransport> sock) override {
     auto pipeline = DefaultPipeline::create();
     pipeline->addBack(AsyncSocketHandler(sock));
-    pipeline->addBack(std::make_shared<ProxyFrontendHandler>(remoteAddress_));
+    auto bridge = std::make_shared<PipelineBridge>();
+    pipeline->addBack(bridge);
+    pipeline->addBack(
+        std::make_shared<ProxyFrontendHandler>(remoteAddress_, bridge));
     pipeline->finalize();
 
     return pipeline;
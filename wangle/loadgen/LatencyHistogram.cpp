@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/loadgen/LatencyHistogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <folly/Format.h>
+#include <folly/lang/Bits.h>
+
+namespace wangle {
+
+LatencyHistogram::LatencyHistogram() : counts_(kBucketCount, 0) {}
+
+size_t LatencyHistogram::indexOf(uint64_t value) {
+  if (value < kSubBucketCount) {
+    return value;
+  }
+  // Shift so the value lands in [kSubBucketCount, 2 * kSubBucketCount);
+  // the discarded low bits are the precision given up in this range.
+  const size_t exponent = folly::findLastSet(value) - 1 - kSubBucketBits;
+  return (exponent + 1) * kSubBucketCount +
+      ((value >> exponent) - kSubBucketCount);
+}
+
+uint64_t LatencyHistogram::valueAt(size_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  const size_t exponent = index / kSubBucketCount - 1;
+  const uint64_t sub = index % kSubBucketCount + kSubBucketCount;
+  return sub << exponent;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  const uint64_t value = latency.count() < 0 ? 0 : latency.count();
+  counts_[indexOf(value)]++;
+  count_++;
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  max_ = std::max(max_, other.max_);
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double pct) const {
+  if (count_ == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  const uint64_t target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(pct / 100.0 * count_)));
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    cumulative += counts_[i];
+    if (cumulative >= target) {
+      return std::chrono::nanoseconds(valueAt(i));
+    }
+  }
+  return std::chrono::nanoseconds(max_);
+}
+
+folly::dynamic LatencyHistogram::toDynamic() const {
+  folly::dynamic percentiles = folly::dynamic::object;
+  for (double p : {50.0, 75.0, 90.0, 95.0, 99.0, 99.9, 99.99}) {
+    percentiles[folly::sformat("p{}", p)] = percentile(p).count();
+  }
+  folly::dynamic result = folly::dynamic::object;
+  result["count"] = count_;
+  result["max_ns"] = max_;
+  result["percentiles_ns"] = std::move(percentiles);
+  return result;
+}
+
+} // namespace wangle
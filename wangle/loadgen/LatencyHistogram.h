@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <folly/dynamic.h>
+
+namespace wangle {
+
+/**
+ * Fixed-footprint latency histogram with HDR-style log-linear buckets:
+ * each power-of-two range is split into 32 linear sub-buckets, giving
+ * about 3% relative precision from one nanosecond up to the full
+ * uint64_t range with ~15KB of counters and no allocation on record().
+ *
+ * record() is plain arithmetic with no synchronization; keep one
+ * histogram per recording thread and merge() them when the run is done.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void record(std::chrono::nanoseconds latency);
+
+  // Adds the other histogram's samples into this one.
+  void merge(const LatencyHistogram& other);
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  // The largest recorded value, exact.
+  std::chrono::nanoseconds max() const {
+    return std::chrono::nanoseconds(max_);
+  }
+
+  /**
+   * The smallest bucket boundary at or below which at least pct percent
+   * of the samples fall, e.g. percentile(99.9). Accurate to the bucket
+   * width (~3%).
+   */
+  std::chrono::nanoseconds percentile(double pct) const;
+
+  /**
+   * Machine-readable summary: count, max and the standard percentile
+   * ladder, all in nanoseconds. Serialize with folly::toJson.
+   */
+  folly::dynamic toDynamic() const;
+
+ private:
+  static constexpr size_t kSubBucketBits = 5;
+  static constexpr size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+  static constexpr size_t kBucketCount =
+      (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+  static size_t indexOf(uint64_t value);
+  static uint64_t valueAt(size_t index);
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_{0};
+  uint64_t max_{0};
+};
+
+} // namespace wangle
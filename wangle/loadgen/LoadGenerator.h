@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/dynamic.h>
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+#include <wangle/loadgen/LatencyHistogram.h>
+#include <wangle/service/Service.h>
+
+namespace wangle {
+
+/**
+ * One step of an arrival-rate schedule: hold requestsPerSecond for
+ * duration, then move to the next phase.
+ */
+struct LoadPhase {
+  double requestsPerSecond;
+  std::chrono::milliseconds duration;
+};
+
+struct LoadGenReport {
+  uint64_t requestsSent{0};
+  uint64_t responsesReceived{0};
+  uint64_t errors{0};
+  std::chrono::milliseconds wallTime{0};
+  LatencyHistogram latency;
+
+  folly::dynamic toDynamic() const {
+    folly::dynamic result = folly::dynamic::object;
+    result["requests_sent"] = requestsSent;
+    result["responses_received"] = responsesReceived;
+    result["errors"] = errors;
+    result["wall_time_ms"] = wallTime.count();
+    if (wallTime.count() > 0) {
+      result["achieved_rps"] = 1000.0 * responsesReceived / wallTime.count();
+    }
+    result["latency"] = latency.toDynamic();
+    return result;
+  }
+};
+
+/**
+ * Open-loop load generator over wangle services.
+ *
+ * The caller builds the connections — any pipeline, any codec stack —
+ * and hands each one in as a Service (typically via a client
+ * dispatcher) paired with the EventBase driving it. The generator's
+ * own thread walks the arrival schedule and dispatches each request at
+ * its intended time regardless of how many responses are outstanding;
+ * latency is measured from that intended time, so a stalled server
+ * inflates the recorded tail instead of silently slowing the request
+ * stream (the coordinated omission trap a closed loop falls into).
+ *
+ * Requests round-robin across the endpoints. The request factory runs
+ * on the generator thread, never concurrently. Each endpoint records
+ * into its own histogram on its EventBase thread; run() merges them
+ * once the run has drained.
+ *
+ * Use a pipelining-capable dispatcher (PipelinedClientDispatcher or
+ * WindowedClientDispatcher): an open loop must be able to issue a
+ * request while earlier ones are still in flight.
+ */
+template <typename Req, typename Resp = Req>
+class LoadGenerator {
+ public:
+  struct Endpoint {
+    std::shared_ptr<Service<Req, Resp>> service;
+    folly::EventBase* evb{nullptr};
+  };
+
+  LoadGenerator(
+      std::vector<Endpoint> endpoints,
+      std::vector<LoadPhase> phases,
+      folly::Function<Req()> requestFactory)
+      : endpoints_(std::move(endpoints)),
+        phases_(std::move(phases)),
+        requestFactory_(std::move(requestFactory)) {
+    CHECK(!endpoints_.empty());
+  }
+
+  /**
+   * Runs the schedule on the calling thread and blocks until every
+   * response has arrived (or the drain timeout passes, counting the
+   * stragglers as errors).
+   */
+  LoadGenReport run() {
+    auto state = std::make_shared<RunState>(endpoints_.size());
+    const auto runStart = std::chrono::steady_clock::now();
+    uint64_t sent = 0;
+
+    for (const auto& phase : phases_) {
+      const auto phaseStart = std::chrono::steady_clock::now();
+      const double nsPerRequest = 1e9 / phase.requestsPerSecond;
+      uint64_t phaseSent = 0;
+      while (true) {
+        const auto offset = std::chrono::nanoseconds(
+            static_cast<uint64_t>(phaseSent * nsPerRequest));
+        if (offset >= phase.duration) {
+          break;
+        }
+        const auto intended = phaseStart + offset;
+        // Sleep to the schedule, never to the responses: that is what
+        // keeps the loop open.
+        std::this_thread::sleep_until(intended);
+        dispatchOne(state, sent % endpoints_.size(), intended);
+        sent++;
+        phaseSent++;
+      }
+    }
+
+    drain(state);
+
+    LoadGenReport report;
+    report.requestsSent = sent;
+    report.errors =
+        state->errors.load() + state->outstanding.load(); // stragglers
+    report.responsesReceived = state->completed.load();
+    report.wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - runStart);
+    for (const auto& histogram : state->perEndpoint) {
+      report.latency.merge(histogram);
+    }
+    return report;
+  }
+
+ private:
+  // Shared with the in-flight callbacks so a drain timeout cannot leave
+  // them pointing at a dead stack frame.
+  struct RunState {
+    explicit RunState(size_t numEndpoints) : perEndpoint(numEndpoints) {}
+
+    std::atomic<uint64_t> outstanding{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> errors{0};
+    std::vector<LatencyHistogram> perEndpoint;
+  };
+
+  void dispatchOne(
+      const std::shared_ptr<RunState>& state,
+      size_t endpointIndex,
+      std::chrono::steady_clock::time_point intended) {
+    auto& endpoint = endpoints_[endpointIndex];
+    state->outstanding++;
+    endpoint.evb->runInEventBaseThread(
+        [state, endpointIndex, intended, service = endpoint.service,
+         request = requestFactory_()]() mutable {
+          (*service)(std::move(request))
+              .thenTry([state, endpointIndex, intended](
+                           folly::Try<Resp>&& response) {
+                if (response.hasException()) {
+                  state->errors++;
+                } else {
+                  state->perEndpoint[endpointIndex].record(
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - intended));
+                  state->completed++;
+                }
+                state->outstanding--;
+              });
+        });
+  }
+
+  void drain(const std::shared_ptr<RunState>& state) {
+    const auto deadline = std::chrono::steady_clock::now() + kDrainTimeout;
+    while (state->outstanding.load() != 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Barrier: the histograms are written on the EventBase threads;
+    // make those writes visible before merging.
+    for (auto& endpoint : endpoints_) {
+      endpoint.evb->runInEventBaseThreadAndWait([] {});
+    }
+  }
+
+  static constexpr std::chrono::seconds kDrainTimeout{30};
+
+  std::vector<Endpoint> endpoints_;
+  std::vector<LoadPhase> phases_;
+  folly::Function<Req()> requestFactory_;
+};
+
+} // namespace wangle
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/loadgen/LatencyHistogram.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono;
+using namespace wangle;
+
+TEST(LatencyHistogram, PercentilesWithinBucketPrecision) {
+  LatencyHistogram histogram;
+  // 1..1000 microseconds, one sample each.
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(microseconds(i));
+  }
+
+  EXPECT_EQ(1000, histogram.count());
+  EXPECT_EQ(microseconds(1000), histogram.max());
+
+  // Bucket width is ~3%, so p50 should come back near 500us.
+  auto p50 = histogram.percentile(50);
+  EXPECT_GE(p50, microseconds(480));
+  EXPECT_LE(p50, microseconds(520));
+
+  auto p99 = histogram.percentile(99);
+  EXPECT_GE(p99, microseconds(950));
+  EXPECT_LE(p99, microseconds(1000));
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 16; ++i) {
+    histogram.record(nanoseconds(i));
+  }
+  // Values below the sub-bucket count map to their own bucket.
+  EXPECT_EQ(nanoseconds(7), histogram.percentile(50));
+  EXPECT_EQ(nanoseconds(15), histogram.percentile(100));
+}
+
+TEST(LatencyHistogram, MergeCombinesSamples) {
+  LatencyHistogram low;
+  LatencyHistogram high;
+  for (int i = 0; i < 100; ++i) {
+    low.record(microseconds(10));
+    high.record(milliseconds(10));
+  }
+
+  low.merge(high);
+  EXPECT_EQ(200, low.count());
+  EXPECT_EQ(milliseconds(10), low.max());
+  EXPECT_LT(low.percentile(50), milliseconds(1));
+  EXPECT_GE(low.percentile(99), milliseconds(9));
+}
+
+TEST(LatencyHistogram, ToDynamicIsMachineReadable) {
+  LatencyHistogram histogram;
+  histogram.record(microseconds(100));
+  auto summary = histogram.toDynamic();
+  EXPECT_EQ(1, summary["count"].asInt());
+  EXPECT_EQ(100000, summary["max_ns"].asInt());
+  EXPECT_TRUE(summary["percentiles_ns"].count("p99.9"));
+}
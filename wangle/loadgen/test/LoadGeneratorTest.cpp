@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/loadgen/LoadGenerator.h>
+
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono;
+using namespace wangle;
+
+namespace {
+
+class ImmediateEchoService : public Service<std::string, std::string> {
+ public:
+  folly::Future<std::string> operator()(std::string request) override {
+    requests++;
+    return folly::makeFuture(std::move(request));
+  }
+
+  int requests{0};
+};
+
+class FailingService : public Service<std::string, std::string> {
+ public:
+  folly::Future<std::string> operator()(std::string) override {
+    return folly::makeFuture<std::string>(
+        std::runtime_error("injected failure"));
+  }
+};
+
+} // namespace
+
+TEST(LoadGenerator, FollowsScheduleAndRecordsLatency) {
+  folly::ScopedEventBaseThread evbThread;
+  auto serviceA = std::make_shared<ImmediateEchoService>();
+  auto serviceB = std::make_shared<ImmediateEchoService>();
+
+  // 1000 requests/s for 100ms: exactly 100 intended send times.
+  std::vector<LoadPhase> phases{{1000.0, milliseconds(100)}};
+  LoadGenerator<std::string> generator(
+      {{serviceA, evbThread.getEventBase()},
+       {serviceB, evbThread.getEventBase()}},
+      phases,
+      [] { return std::string("ping"); });
+
+  auto report = generator.run();
+  EXPECT_EQ(100, report.requestsSent);
+  EXPECT_EQ(100, report.responsesReceived);
+  EXPECT_EQ(0, report.errors);
+  EXPECT_EQ(100, report.latency.count());
+  EXPECT_GT(report.latency.max(), nanoseconds(0));
+
+  // Round-robin across endpoints.
+  EXPECT_EQ(50, serviceA->requests);
+  EXPECT_EQ(50, serviceB->requests);
+}
+
+TEST(LoadGenerator, CountsFailuresAsErrors) {
+  folly::ScopedEventBaseThread evbThread;
+  auto service = std::make_shared<FailingService>();
+
+  std::vector<LoadPhase> phases{{1000.0, milliseconds(20)}};
+  LoadGenerator<std::string> generator(
+      {{service, evbThread.getEventBase()}}, phases, [] {
+        return std::string("ping");
+      });
+
+  auto report = generator.run();
+  EXPECT_EQ(20, report.requestsSent);
+  EXPECT_EQ(0, report.responsesReceived);
+  EXPECT_EQ(20, report.errors);
+  EXPECT_EQ(0, report.latency.count());
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/AtomicIntrusiveLinkedList.h>
+#include <wangle/service/Service.h>
+
+namespace wangle {
+
+/**
+ * Like ExecutorFilter, but built for high dispatch rates: requests are
+ * linked into a lock-free MPSC queue and only the submission that finds
+ * the queue empty schedules a drain, so a burst of same-tick dispatches
+ * costs one executor wakeup instead of one per request (and no via()
+ * future-core chain per request).
+ *
+ * Responses complete on the target executor by default; pass a
+ * replyExecutor (typically the origin EventBase) to have completions
+ * handed back there instead, where its notification queue coalesces the
+ * return crossings the same way.
+ *
+ * The filter must outlive the executor's processing of all submitted
+ * requests.
+ */
+template <typename Req, typename Resp = Req>
+class BatchingExecutorFilter : public ServiceFilter<Req, Resp> {
+ public:
+  BatchingExecutorFilter(
+      std::shared_ptr<folly::Executor> exe,
+      std::shared_ptr<Service<Req, Resp>> service,
+      folly::Executor* replyExecutor = nullptr)
+      : ServiceFilter<Req, Resp>(service),
+        exe_(std::move(exe)),
+        replyExecutor_(replyExecutor) {}
+
+  folly::Future<Resp> operator()(Req req) override {
+    auto node = new Node(std::move(req));
+    auto future = node->promise.getFuture();
+    if (queue_.insertHead(node)) {
+      exe_->add([this]() { drain(); });
+    }
+    return future;
+  }
+
+ private:
+  struct Node {
+    explicit Node(Req&& r) : req(std::move(r)) {}
+
+    Req req;
+    folly::Promise<Resp> promise;
+    folly::AtomicIntrusiveLinkedListHook<Node> hook;
+  };
+
+  void drain() {
+    // sweep() hands back nodes in submission order.
+    queue_.sweep([this](Node* node) {
+      (*this->service_)(std::move(node->req))
+          .thenTry([this, node](folly::Try<Resp> t) {
+            if (replyExecutor_) {
+              replyExecutor_->add(
+                  [node, t = std::move(t)]() mutable {
+                    node->promise.setTry(std::move(t));
+                    delete node;
+                  });
+            } else {
+              node->promise.setTry(std::move(t));
+              delete node;
+            }
+          });
+    });
+  }
+
+  std::shared_ptr<folly::Executor> exe_;
+  folly::Executor* replyExecutor_;
+  folly::AtomicIntrusiveLinkedList<Node, &Node::hook> queue_;
+};
+
+} // namespace wangle
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <folly/Function.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/SharedPromise.h>
+#include <wangle/client/persistence/ShardedLRUInMemoryCache.h>
+#include <wangle/service/Service.h>
+
+namespace wangle {
+
+/**
+ * A memoizing filter for idempotent services. Responses are cached by
+ * a caller-supplied key with a caller-supplied TTL, backed by a
+ * sharded LRU so concurrent lookups on different keys do not convoy on
+ * one lock. Concurrent requests for the same key while an upstream
+ * call is in flight are collapsed onto that call instead of each
+ * hitting the backend.
+ *
+ * The key extractor derives the cache key from a request; the TTL
+ * policy decides, per response, how long it may be served from cache
+ * (a TTL of zero or less means "do not cache this response"). Errors
+ * are never cached: every waiter collapsed onto a failed call sees the
+ * failure, and the next request retries upstream.
+ *
+ * Resp must be copyable; cache hits and collapsed requests each hand
+ * back a copy of the response.
+ */
+template <typename Req, typename Resp = Req, typename Key = Req>
+class CachingFilter : public ServiceFilter<Req, Resp> {
+ public:
+  using KeyExtractor = folly::Function<Key(const Req&) const>;
+  using TtlPolicy = folly::Function<
+      std::chrono::milliseconds(const Key&, const Resp&) const>;
+
+  struct CacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    // Requests satisfied by an upstream call already in flight.
+    uint64_t collapsed{0};
+  };
+
+  CachingFilter(
+      std::shared_ptr<Service<Req, Resp>> service,
+      size_t cacheCapacity,
+      KeyExtractor keyExtractor,
+      TtlPolicy ttlPolicy,
+      size_t shardCount = 16)
+      : ServiceFilter<Req, Resp>(service),
+        keyExtractor_(std::move(keyExtractor)),
+        ttlPolicy_(std::move(ttlPolicy)),
+        cache_(cacheCapacity, shardCount) {}
+
+  folly::Future<Resp> operator()(Req request) override {
+    auto key = keyExtractor_(request);
+    if (auto cached = cache_.get(key)) {
+      if (Clock::now() < cached->expiry) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return folly::makeFuture<Resp>(Resp(cached->response));
+      }
+      cache_.remove(key);
+    }
+
+    std::shared_ptr<folly::SharedPromise<Resp>> promise;
+    {
+      auto inflight = inflight_.wlock();
+      auto it = inflight->find(key);
+      if (it != inflight->end()) {
+        collapsed_.fetch_add(1, std::memory_order_relaxed);
+        return it->second->getFuture();
+      }
+      promise = std::make_shared<folly::SharedPromise<Resp>>();
+      inflight->emplace(key, promise);
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    (*this->service_)(std::move(request))
+        .thenTry([this, key, promise](folly::Try<Resp> result) {
+          if (result.hasValue()) {
+            auto ttl = ttlPolicy_(key, result.value());
+            if (ttl.count() > 0) {
+              cache_.put(key, {result.value(), Clock::now() + ttl});
+            }
+          }
+          // Erase before fulfilling so a retry issued from a waiter's
+          // continuation goes upstream rather than joining this call.
+          inflight_.wlock()->erase(key);
+          promise->setTry(std::move(result));
+        });
+    return promise->getFuture();
+  }
+
+  CacheStats getCacheStats() const {
+    CacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.collapsed = collapsed_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct CachedResponse {
+    Resp response;
+    Clock::time_point expiry;
+  };
+
+  KeyExtractor keyExtractor_;
+  TtlPolicy ttlPolicy_;
+  ShardedLRUInMemoryCache<Key, CachedResponse, folly::SharedMutex> cache_;
+  folly::Synchronized<
+      folly::F14FastMap<Key, std::shared_ptr<folly::SharedPromise<Resp>>>>
+      inflight_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> collapsed_{0};
+};
+
+} // namespace wangle
@@ -16,9 +16,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/container/F14Map.h>
 #include <wangle/channel/Handler.h>
+#include <wangle/service/CoroService.h>
 #include <wangle/service/Service.h>
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Baton.h>
+#include <folly/experimental/coro/Task.h>
+#endif
+
 namespace wangle {
 
 template <typename Pipeline, typename Req, typename Resp = Req>
@@ -123,10 +135,246 @@ class PipelinedClientDispatcher
   std::deque<folly::Promise<Resp>> p_;
 };
 
-/*
- * A full out-of-order request/response client would require some sort
- * of sequence id on the wire.  Currently this is left up to
- * individual protocol writers to implement.
+/**
+ * Dispatch requests over a single pipelined connection, with responses
+ * correlated by a protocol-level sequence id so they may complete in any
+ * order. The protocol owns the wire format; the caller supplies one
+ * function that stamps an id onto an outgoing request and one that reads
+ * it back off a response.
+ *
+ * At most maxInFlight requests are outstanding at once. When the window
+ * is full, further requests are either held in a queue and dispatched as
+ * responses free up slots (the default) or failed immediately, per the
+ * configured policy.
+ *
+ * The correlation table is a flat array of maxInFlight slots indexed by
+ * id modulo the window size; a slot whose index is already taken by a
+ * straggler spills to an F14 map, so lookups are a single array probe in
+ * the common case of roughly in-order completion.
+ */
+template <typename Pipeline, typename Req, typename Resp = Req>
+class WindowedClientDispatcher
+    : public ClientDispatcherBase<Pipeline, Req, Resp> {
+ public:
+  typedef typename HandlerAdapter<Resp, Req>::Context Context;
+  using SequenceId = uint64_t;
+
+  enum class WindowFullPolicy {
+    // Hold requests past the window and dispatch them as slots free up.
+    QUEUE,
+    // Fail the returned future immediately.
+    FAIL,
+  };
+
+  struct WindowStats {
+    uint64_t dispatched{0};
+    uint64_t completed{0};
+    // Requests that waited in the queue for a window slot.
+    uint64_t queued{0};
+    // Requests failed under WindowFullPolicy::FAIL.
+    uint64_t rejected{0};
+    uint64_t totalLatencyUs{0};
+    uint64_t maxLatencyUs{0};
+  };
+
+  WindowedClientDispatcher(
+      folly::Function<void(Req&, SequenceId)> setSequenceId,
+      folly::Function<SequenceId(const Resp&)> getSequenceId,
+      size_t maxInFlight = 64,
+      WindowFullPolicy policy = WindowFullPolicy::QUEUE)
+      : setSequenceId_(std::move(setSequenceId)),
+        getSequenceId_(std::move(getSequenceId)),
+        maxInFlight_(std::max<size_t>(maxInFlight, 1)),
+        policy_(policy),
+        slots_(maxInFlight_) {}
+
+  void read(Context*, Resp in) override {
+    auto entry = takeEntry(getSequenceId_(in));
+    if (!entry) {
+      // A response with no matching request; the protocol is confused.
+      DCHECK(false) << "response with unknown sequence id";
+      return;
+    }
+    inFlight_--;
+    stats_.completed++;
+    auto latencyUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - entry->start)
+            .count());
+    stats_.totalLatencyUs += latencyUs;
+    stats_.maxLatencyUs = std::max(stats_.maxLatencyUs, latencyUs);
+    entry->p.setValue(std::move(in));
+    while (!queue_.empty() && inFlight_ < maxInFlight_) {
+      auto next = std::move(queue_.front());
+      queue_.pop_front();
+      dispatch(std::move(next.first), std::move(next.second));
+    }
+  }
+
+  folly::Future<Resp> operator()(Req arg) override {
+    DCHECK(this->pipeline_);
+
+    folly::Promise<Resp> p;
+    auto f = p.getFuture();
+    if (inFlight_ >= maxInFlight_) {
+      if (policy_ == WindowFullPolicy::FAIL) {
+        stats_.rejected++;
+        p.setException(folly::make_exception_wrapper<std::runtime_error>(
+            "in-flight window exhausted"));
+      } else {
+        stats_.queued++;
+        queue_.emplace_back(std::move(arg), std::move(p));
+      }
+    } else {
+      dispatch(std::move(arg), std::move(p));
+    }
+    return f;
+  }
+
+  folly::Future<folly::Unit> close(Context* ctx) override {
+    auto ew = folly::make_exception_wrapper<std::runtime_error>(
+        "dispatcher closed with requests in flight");
+    for (auto& slot : slots_) {
+      if (slot.entry) {
+        slot.entry->p.setException(ew);
+        slot.entry.reset();
+      }
+    }
+    for (auto& kv : overflow_) {
+      kv.second.p.setException(ew);
+    }
+    overflow_.clear();
+    for (auto& queued : queue_) {
+      queued.second.setException(ew);
+    }
+    queue_.clear();
+    inFlight_ = 0;
+    return ClientDispatcherBase<Pipeline, Req, Resp>::close(ctx);
+  }
+
+  size_t getRequestsInFlight() const {
+    return inFlight_;
+  }
+
+  const WindowStats& getWindowStats() const {
+    return stats_;
+  }
+
+ private:
+  struct Entry {
+    folly::Promise<Resp> p;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  struct Slot {
+    SequenceId id{0};
+    folly::Optional<Entry> entry;
+  };
+
+  void dispatch(Req&& arg, folly::Promise<Resp>&& p) {
+    auto id = nextSequenceId_++;
+    setSequenceId_(arg, id);
+    Entry entry{std::move(p), std::chrono::steady_clock::now()};
+    auto& slot = slots_[id % maxInFlight_];
+    if (!slot.entry) {
+      slot.id = id;
+      slot.entry = std::move(entry);
+    } else {
+      // The slot is still held by an older in-flight request.
+      overflow_.emplace(id, std::move(entry));
+    }
+    inFlight_++;
+    stats_.dispatched++;
+    this->pipeline_->write(std::move(arg));
+  }
+
+  folly::Optional<Entry> takeEntry(SequenceId id) {
+    auto& slot = slots_[id % maxInFlight_];
+    if (slot.entry && slot.id == id) {
+      auto entry = std::move(slot.entry);
+      slot.entry.reset();
+      return entry;
+    }
+    auto it = overflow_.find(id);
+    if (it == overflow_.end()) {
+      return folly::none;
+    }
+    auto entry = std::move(it->second);
+    overflow_.erase(it);
+    return folly::Optional<Entry>(std::move(entry));
+  }
+
+  folly::Function<void(Req&, SequenceId)> setSequenceId_;
+  folly::Function<SequenceId(const Resp&)> getSequenceId_;
+  size_t maxInFlight_;
+  WindowFullPolicy policy_;
+  std::vector<Slot> slots_;
+  folly::F14FastMap<SequenceId, Entry> overflow_;
+  std::deque<std::pair<Req, folly::Promise<Resp>>> queue_;
+  SequenceId nextSequenceId_{0};
+  size_t inFlight_{0};
+  WindowStats stats_;
+};
+
+#if FOLLY_HAS_COROUTINES
+
+/**
+ * The coroutine analog of SerialClientDispatcher: dispatch a request
+ * and await the response; only one request is allowed at a time.
+ *
+ * The response wakes the awaiting coroutine through a coro::Baton
+ * rather than a promise/future pair, so a request costs no future core
+ * and resumes inline on the EventBase thread that read the response.
+ * operator() is still provided for callers that are not yet
+ * coroutines; that path starts a task on the transport's EventBase and
+ * pays the future core the coroutine path avoids.
  */
+template <typename Pipeline, typename Req, typename Resp = Req>
+class CoroSerialClientDispatcher
+    : public ClientDispatcherBase<Pipeline, Req, Resp>,
+      public CoroService<Req, Resp> {
+ public:
+  typedef typename HandlerAdapter<Resp, Req>::Context Context;
+
+  void read(Context*, Resp in) override {
+    DCHECK(waiting_);
+    response_.emplace(std::move(in));
+    baton_.post();
+  }
+
+  folly::coro::Task<Resp> co_invoke(Req arg) override {
+    CHECK(!waiting_);
+    DCHECK(this->pipeline_);
+
+    waiting_ = true;
+    this->pipeline_->write(std::move(arg));
+    co_await baton_;
+    baton_.reset();
+    waiting_ = false;
+    auto resp = std::move(*response_);
+    response_.reset();
+    co_return resp;
+  }
+
+  folly::Future<Resp> operator()(Req arg) override {
+    auto* evb = this->pipeline_->getTransport()->getEventBase();
+    return co_invoke(std::move(arg)).scheduleOn(evb).start().via(evb);
+  }
+
+  folly::coro::Task<void> co_close() override {
+    co_await this->close();
+  }
+
+  bool isAvailable() override {
+    return true;
+  }
+
+ private:
+  folly::coro::Baton baton_;
+  folly::Optional<Resp> response_;
+  bool waiting_{false};
+};
+
+#endif // FOLLY_HAS_COROUTINES
 
 } // namespace wangle
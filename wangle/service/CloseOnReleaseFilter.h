@@ -32,7 +32,12 @@ class CloseOnReleaseFilter : public ServiceFilter<Req, Resp> {
 
   folly::Future<Resp> operator()(Req req) override {
     if (!released) {
-      return (*this->service_)(std::move(req));
+      pending_++;
+      return (*this->service_)(std::move(req)).ensure([this]() {
+        if (--pending_ == 0 && draining_) {
+          fulfillDrained();
+        }
+      });
     } else {
       return folly::makeFuture<Resp>(
           folly::make_exception_wrapper<std::runtime_error>("Service Closed"));
@@ -47,8 +52,42 @@ class CloseOnReleaseFilter : public ServiceFilter<Req, Resp> {
     }
   }
 
+  /**
+   * Stops accepting new dispatches immediately but waits up to timeout for
+   * outstanding responses before closing the underlying service, so
+   * connection recycling doesn't tail-drop requests already in flight.
+   * Responses still pending when the deadline fires are abandoned to the
+   * close, as with close().
+   */
+  folly::Future<folly::Unit> closeGracefully(
+      std::chrono::milliseconds timeout,
+      folly::Timekeeper* timekeeper = nullptr) {
+    if (released.exchange(true)) {
+      return folly::makeFuture();
+    }
+    draining_ = true;
+    if (pending_ == 0) {
+      fulfillDrained();
+    }
+    return drained_.getFuture()
+        .within(timeout, timekeeper)
+        .thenTry([this](folly::Try<folly::Unit>) {
+          return this->service_->close();
+        });
+  }
+
  private:
+  void fulfillDrained() {
+    if (!drainedFulfilled_.exchange(true)) {
+      drained_.setValue();
+    }
+  }
+
   std::atomic<bool> released{false};
+  std::atomic<bool> draining_{false};
+  std::atomic<bool> drainedFulfilled_{false};
+  std::atomic<uint32_t> pending_{0};
+  folly::Promise<folly::Unit> drained_;
 };
 
 } // namespace wangle
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/Traits.h>
+#include <folly/futures/Future.h>
+#include <wangle/service/Service.h>
+
+namespace wangle {
+
+namespace detail {
+
+template <typename T, typename = void>
+struct LayerHasClose : std::false_type {};
+template <typename T>
+struct LayerHasClose<T, folly::void_t<decltype(std::declval<T&>().close())>>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct LayerHasIsAvailable : std::false_type {};
+template <typename T>
+struct LayerHasIsAvailable<
+    T,
+    folly::void_t<decltype(std::declval<T&>().isAvailable())>>
+    : std::true_type {};
+
+} // namespace detail
+
+/**
+ * A filter chain fused at compile time.
+ *
+ * A stack of ServiceFilters costs a virtual dispatch per layer per
+ * request, and each layer that decorates the response adds a Future
+ * continuation of its own. ComposedService holds the layers by value
+ * in a tuple and threads the call through them directly, so the
+ * compiler can inline the whole chain and layers that only transform
+ * the request add no per-request allocation at all.
+ *
+ * Every layer but the last implements
+ *
+ *   folly::Future<Resp> operator()(Next&& next, Req request);
+ *
+ * where calling next(request) invokes the rest of the chain; a layer
+ * may rewrite the request, decorate the returned future, or
+ * short-circuit without calling next at all. The last layer is the
+ * leaf service and implements plain operator()(Req) ->
+ * folly::Future<Resp>. Layers may also expose close() and
+ * isAvailable(); the composed service forwards both to every layer
+ * that does.
+ *
+ * The composition is itself a Service<Req, Resp>, so a fused chain
+ * drops into any slot built for the dynamic API; use the dynamic
+ * ServiceFilter stack when the chain has to be assembled at runtime.
+ */
+template <typename Req, typename Resp, typename... Layers>
+class ComposedService : public Service<Req, Resp> {
+  static_assert(
+      sizeof...(Layers) > 0,
+      "ComposedService needs at least the leaf service layer");
+
+ public:
+  explicit ComposedService(Layers... layers) : layers_(std::move(layers)...) {}
+
+  folly::Future<Resp> operator()(Req request) override {
+    return callFrom<0>(std::move(request));
+  }
+
+  folly::Future<folly::Unit> close() override {
+    std::vector<folly::Future<folly::Unit>> closing;
+    std::apply(
+        [&](auto&... layer) { (closeLayer(layer, closing), ...); }, layers_);
+    return folly::collectAll(std::move(closing)).toUnsafeFuture().unit();
+  }
+
+  bool isAvailable() override {
+    return std::apply(
+        [](auto&... layer) { return (layerAvailable(layer) && ...); },
+        layers_);
+  }
+
+ private:
+  template <std::size_t I, typename R>
+  auto callFrom(R request) {
+    auto& layer = std::get<I>(layers_);
+    if constexpr (I + 1 == sizeof...(Layers)) {
+      return layer(std::move(request));
+    } else {
+      return layer(
+          [this](auto innerRequest) {
+            return callFrom<I + 1>(std::move(innerRequest));
+          },
+          std::move(request));
+    }
+  }
+
+  template <typename Layer>
+  static void closeLayer(
+      Layer& layer,
+      std::vector<folly::Future<folly::Unit>>& closing) {
+    if constexpr (detail::LayerHasClose<Layer>::value) {
+      closing.push_back(layer.close());
+    }
+  }
+
+  template <typename Layer>
+  static bool layerAvailable(Layer& layer) {
+    if constexpr (detail::LayerHasIsAvailable<Layer>::value) {
+      return layer.isAvailable();
+    } else {
+      return true;
+    }
+  }
+
+  std::tuple<Layers...> layers_;
+};
+
+/**
+ * Leaf layer adapting a dynamically assembled Service, so a fused
+ * prefix of hot filters can sit in front of an existing service
+ * without rewriting it.
+ */
+template <typename Req, typename Resp = Req>
+class ServiceLeaf {
+ public:
+  explicit ServiceLeaf(std::shared_ptr<Service<Req, Resp>> service)
+      : service_(std::move(service)) {}
+
+  folly::Future<Resp> operator()(Req request) {
+    return (*service_)(std::move(request));
+  }
+
+  folly::Future<folly::Unit> close() {
+    return service_->close();
+  }
+
+  bool isAvailable() {
+    return service_->isAvailable();
+  }
+
+ private:
+  std::shared_ptr<Service<Req, Resp>> service_;
+};
+
+} // namespace wangle
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/experimental/coro/Task.h>
+#include <wangle/service/Service.h>
+
+namespace wangle {
+
+/**
+ * A CoroService is an asynchronous function from Request to
+ * Task<Response> — the coroutine-native sibling of Service. A handler
+ * that is itself a coroutine implements co_invoke directly instead of
+ * paying a coroutine -> Future -> coroutine round trip (one
+ * promise/core allocation in each direction) per request.
+ */
+template <typename Req, typename Resp = Req>
+class CoroService {
+ public:
+  virtual ~CoroService() = default;
+
+  virtual folly::coro::Task<Resp> co_invoke(Req request) = 0;
+
+  virtual folly::coro::Task<void> co_close() {
+    co_return;
+  }
+
+  virtual bool isAvailable() {
+    return true;
+  }
+};
+
+/**
+ * The coroutine analog of ServiceFilter: a decorator/transformer of a
+ * CoroService. See ServiceFilter for the request/response diagram.
+ */
+template <
+    typename ReqA,
+    typename RespA,
+    typename ReqB = ReqA,
+    typename RespB = RespA>
+class CoroServiceFilter : public CoroService<ReqA, RespA> {
+ public:
+  explicit CoroServiceFilter(std::shared_ptr<CoroService<ReqB, RespB>> service)
+      : service_(std::move(service)) {}
+  ~CoroServiceFilter() override = default;
+
+  folly::coro::Task<void> co_close() override {
+    return service_->co_close();
+  }
+
+  bool isAvailable() override {
+    return service_->isAvailable();
+  }
+
+ protected:
+  std::shared_ptr<CoroService<ReqB, RespB>> service_;
+};
+
+/**
+ * Presents a Future-based Service as a CoroService, so a coroutine
+ * filter chain can sit on top of a not-yet-migrated service. The
+ * wrapped service's Future is awaited directly; completion resumes the
+ * caller wherever the future completes.
+ */
+template <typename Req, typename Resp = Req>
+class ServiceToCoroService : public CoroService<Req, Resp> {
+ public:
+  explicit ServiceToCoroService(std::shared_ptr<Service<Req, Resp>> service)
+      : service_(std::move(service)) {}
+
+  folly::coro::Task<Resp> co_invoke(Req request) override {
+    co_return co_await (*service_)(std::move(request));
+  }
+
+  folly::coro::Task<void> co_close() override {
+    co_await service_->close();
+  }
+
+  bool isAvailable() override {
+    return service_->isAvailable();
+  }
+
+ private:
+  std::shared_ptr<Service<Req, Resp>> service_;
+};
+
+/**
+ * Presents a CoroService as a Future-based Service for the other
+ * migration direction. Each call starts a task on the given executor;
+ * this direction necessarily pays the future core, so once a chain is
+ * fully coroutines the adapter should come out.
+ */
+template <typename Req, typename Resp = Req>
+class CoroServiceToService : public Service<Req, Resp> {
+ public:
+  CoroServiceToService(
+      std::shared_ptr<CoroService<Req, Resp>> service,
+      folly::Executor::KeepAlive<> executor)
+      : service_(std::move(service)), executor_(std::move(executor)) {}
+
+  folly::Future<Resp> operator()(Req request) override {
+    return service_->co_invoke(std::move(request))
+        .scheduleOn(executor_)
+        .start()
+        .via(executor_);
+  }
+
+  folly::Future<folly::Unit> close() override {
+    return service_->co_close().scheduleOn(executor_).start().via(executor_);
+  }
+
+  bool isAvailable() override {
+    return service_->isAvailable();
+  }
+
+ private:
+  std::shared_ptr<CoroService<Req, Resp>> service_;
+  folly::Executor::KeepAlive<> executor_;
+};
+
+} // namespace wangle
+
+#endif // FOLLY_HAS_COROUTINES
@@ -17,12 +17,19 @@
 #pragma once
 
 #include <wangle/service/Service.h>
+#include <wangle/service/ServiceExpiryTracker.h>
 
 namespace wangle {
 /**
  * A service filter that expires the self service after a certain
  * amount of idle time, or after a maximum amount of time total.
  * Idle timeout is cancelled when any requests are outstanding.
+ *
+ * By default each filter arms its own timekeeper timeouts. When many
+ * filters share a process, construct them with a common
+ * ServiceExpiryTracker instead: expiry is then coarse-bucketed, each
+ * request costs a timestamp store rather than a timer cancel/re-arm,
+ * and the whole population wakes the timekeeper once per tick.
  */
 
 template <typename Req, typename Resp = Req>
@@ -44,7 +51,41 @@ class ExpiringFilter : public ServiceFilter<Req, Resp> {
     startIdleTimer();
   }
 
+  ExpiringFilter(
+      std::shared_ptr<Service<Req, Resp>> service,
+      std::shared_ptr<ServiceExpiryTracker> tracker,
+      std::chrono::milliseconds idleTimeoutTime = std::chrono::milliseconds(0),
+      std::chrono::milliseconds maxTime = std::chrono::milliseconds(0))
+      : ServiceFilter<Req, Resp>(service),
+        idleTimeoutTime_(idleTimeoutTime),
+        maxTime_(maxTime),
+        timekeeper_(nullptr),
+        tracker_(std::move(tracker)) {
+    if (maxTime_ > std::chrono::milliseconds(0)) {
+      maxToken_ = tracker_->track(maxTime_, [this] {
+        this->close();
+        return true;
+      });
+    }
+    if (idleTimeoutTime_ > std::chrono::milliseconds(0)) {
+      idleToken_ = tracker_->track(idleTimeoutTime_, [this] {
+        if (draining_) {
+          return true;
+        }
+        if (requests_ != 0) {
+          return false; // busy; check again a full timeout later
+        }
+        this->close();
+        return true;
+      });
+    }
+  }
+
   ~ExpiringFilter() override {
+    if (tracker_) {
+      tracker_->untrack(idleToken_);
+      tracker_->untrack(maxToken_);
+    }
     if (!idleTimeout_.isReady()) {
       idleTimeout_.cancel();
     }
@@ -53,8 +94,37 @@ class ExpiringFilter : public ServiceFilter<Req, Resp> {
     }
   }
 
+  /**
+   * Drains instead of closing abruptly: once close() is triggered (by a
+   * timer or by the caller), new dispatches are rejected and outstanding
+   * responses get up to drainTimeout to finish before the underlying
+   * service is closed. 0 (the default) closes immediately, the historical
+   * behavior.
+   */
+  void setDrainTimeout(std::chrono::milliseconds drainTimeout) {
+    drainTimeout_ = drainTimeout;
+  }
+
+  folly::Future<folly::Unit> close() override {
+    if (drainTimeout_ <= std::chrono::milliseconds(0)) {
+      return ServiceFilter<Req, Resp>::close();
+    }
+    if (draining_) {
+      return folly::makeFuture();
+    }
+    draining_ = true;
+    if (requests_ == 0) {
+      return ServiceFilter<Req, Resp>::close();
+    }
+    return drained_.getFuture()
+        .within(drainTimeout_, timekeeper_)
+        .thenTry([this](folly::Try<folly::Unit>) {
+          return ServiceFilter<Req, Resp>::close();
+        });
+  }
+
   void startIdleTimer() {
-    if (requests_ != 0) {
+    if (tracker_ || requests_ != 0 || draining_) {
       return;
     }
     if (idleTimeoutTime_ > std::chrono::milliseconds(0)) {
@@ -64,13 +134,24 @@ class ExpiringFilter : public ServiceFilter<Req, Resp> {
   }
 
   folly::Future<Resp> operator()(Req req) override {
-    if (!idleTimeout_.isReady()) {
+    if (draining_) {
+      return folly::makeFuture<Resp>(
+          folly::make_exception_wrapper<std::runtime_error>("Service Closed"));
+    }
+    if (!tracker_ && !idleTimeout_.isReady()) {
       idleTimeout_.cancel();
     }
     requests_++;
     return (*this->service_)(std::move(req)).ensure([this]() {
       requests_--;
-      startIdleTimer();
+      if (draining_ && requests_ == 0) {
+        drained_.setValue();
+      }
+      if (tracker_) {
+        tracker_->touch(idleToken_);
+      } else {
+        startIdleTimer();
+      }
     });
   }
 
@@ -79,8 +160,14 @@ class ExpiringFilter : public ServiceFilter<Req, Resp> {
   folly::Future<folly::Unit> maxTimeout_;
   std::chrono::milliseconds idleTimeoutTime_{0};
   std::chrono::milliseconds maxTime_{0};
+  std::chrono::milliseconds drainTimeout_{0};
   folly::Timekeeper* timekeeper_;
+  std::shared_ptr<ServiceExpiryTracker> tracker_;
+  uint64_t idleToken_{0};
+  uint64_t maxToken_{0};
   uint32_t requests_{0};
+  bool draining_{false};
+  folly::Promise<folly::Unit> drained_;
 };
 
 } // namespace wangle
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <folly/Traits.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseLocal.h>
+
+namespace wangle {
+
+/**
+ * A recycling pool for request/response message objects.
+ *
+ * Thrift-style Req/Resp structs (a handful of strings and vectors) are
+ * constructed and destroyed once per message as they move through the
+ * service-layer dispatchers; at high request rates those short-lived
+ * objects dominate malloc traffic. The pool keeps retired objects on a
+ * freelist and hands them back out with their capacity intact, so in
+ * steady state acquiring a message is a pointer pop and the strings
+ * inside reuse their previous heap storage.
+ *
+ * T must model Reusable: default-constructible, with a clear() that
+ * resets it for reuse (thrift structs and most hand-written message
+ * types already have one). clear() runs on recycle, not on acquire, so
+ * a pooled object never keeps its last payload alive between requests.
+ *
+ * acquire() returns MessagePool<T>::Ptr, a unique_ptr whose deleter
+ * returns the object here, so every completion path — normal response,
+ * early return, exception unwind — recycles instead of leaking. The
+ * Ptr moves through pipelines and futures like any other message type;
+ * the dispatchers in wangle/service are templates over the message
+ * type and construct no messages of their own, so instantiating them
+ * with Req = MessagePool<T>::Ptr makes per-request allocation optional
+ * across the service layer with no dispatcher changes.
+ *
+ * Like PipelineContextPool, a pool is intentionally unlocked: use one
+ * per EventBase (see get()) and acquire/release on its thread. The
+ * pool must outlive every Ptr acquired from it.
+ */
+template <typename T>
+class MessagePool {
+ public:
+  struct Recycler {
+    void operator()(T* obj) noexcept {
+      if (pool) {
+        pool->recycle(obj);
+      } else {
+        delete obj;
+      }
+    }
+    MessagePool* pool{nullptr};
+  };
+
+  using Ptr = std::unique_ptr<T, Recycler>;
+
+  struct PoolStats {
+    // Objects served by a freelist pop vs. a fresh allocation.
+    uint64_t poolHits{0};
+    uint64_t allocations{0};
+    // Returns accepted into the freelist vs. dropped at capacity.
+    uint64_t recycled{0};
+    uint64_t discarded{0};
+  };
+
+  // Bounds the freelist so a traffic burst does not pin its peak
+  // working set forever.
+  explicit MessagePool(size_t maxPooled = 1024) : maxPooled_(maxPooled) {}
+
+  /**
+   * The pool for this EventBase, created on first use and torn down
+   * with the EventBase.
+   */
+  static MessagePool& get(folly::EventBase* evb) {
+    static folly::EventBaseLocal<MessagePool> storage;
+    return storage.getOrCreate(*evb);
+  }
+
+  Ptr acquire() {
+    if (!freelist_.empty()) {
+      auto* obj = freelist_.back().release();
+      freelist_.pop_back();
+      stats_.poolHits++;
+      return Ptr(obj, Recycler{this});
+    }
+    stats_.allocations++;
+    return Ptr(new T(), Recycler{this});
+  }
+
+  size_t pooledObjects() const {
+    return freelist_.size();
+  }
+
+  const PoolStats& getPoolStats() const {
+    return stats_;
+  }
+
+ private:
+  template <typename U, typename = void>
+  struct IsReusable : std::false_type {};
+  template <typename U>
+  struct IsReusable<U, folly::void_t<decltype(std::declval<U&>().clear())>>
+      : std::true_type {};
+  static_assert(
+      std::is_default_constructible<T>::value && IsReusable<T>::value,
+      "MessagePool<T> requires a Reusable T: default-constructible with "
+      "a clear() that resets the object for reuse");
+
+  void recycle(T* obj) noexcept {
+    if (freelist_.size() >= maxPooled_) {
+      stats_.discarded++;
+      delete obj;
+      return;
+    }
+    obj->clear();
+    stats_.recycled++;
+    freelist_.emplace_back(obj);
+  }
+
+  const size_t maxPooled_;
+  std::vector<std::unique_ptr<T>> freelist_;
+  PoolStats stats_;
+};
+
+} // namespace wangle
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+#include <wangle/service/Service.h>
+
+namespace wangle {
+
+/**
+ * Runs requests directly on the calling (IO) thread instead of hopping
+ * to an executor and back, for services cheap enough that the two
+ * context switches would dominate their latency.
+ *
+ * Each inline invocation's synchronous cost is measured against a
+ * per-request budget. A request cannot be aborted mid-run, so the
+ * budget acts one request late: after an overrun, the next
+ * offloadedPerOverrun requests go to the fallback executor (the usual
+ * ExecutorFilter path) before inline execution is probed again. A
+ * service that has genuinely become expensive therefore converges to
+ * offloading all but one request per probe interval, while a service
+ * with an occasional slow outlier stays mostly inline.
+ *
+ * Only the synchronous portion of the service counts against the
+ * budget; a service that quickly returns an unfulfilled future is a
+ * good inline citizen no matter how long the future takes.
+ *
+ * Like the client dispatchers, this filter is single-threaded: all
+ * requests must come from the same IO thread. Use the inline/offloaded
+ * counters in DispatchStats to tune the budget per service.
+ */
+template <typename Req, typename Resp = Req>
+class RunInlineFilter : public ServiceFilter<Req, Resp> {
+ public:
+  struct DispatchStats {
+    uint64_t inlineRequests{0};
+    uint64_t offloadedRequests{0};
+    // Inline invocations whose synchronous cost exceeded the budget.
+    uint64_t budgetOverruns{0};
+    uint64_t maxInlineUs{0};
+  };
+
+  RunInlineFilter(
+      std::shared_ptr<folly::Executor> fallback,
+      std::shared_ptr<Service<Req, Resp>> service,
+      std::chrono::microseconds budget = std::chrono::microseconds(50),
+      uint32_t offloadedPerOverrun = 16)
+      : ServiceFilter<Req, Resp>(service),
+        fallback_(std::move(fallback)),
+        budget_(budget),
+        offloadedPerOverrun_(offloadedPerOverrun) {}
+
+  folly::Future<Resp> operator()(Req req) override {
+    if (offloadRemaining_ > 0) {
+      offloadRemaining_--;
+      stats_.offloadedRequests++;
+      return folly::via(fallback_.get())
+          .thenValue([req = std::move(req), this](auto&&) mutable {
+            return (*this->service_)(std::move(req));
+          });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto f = (*this->service_)(std::move(req));
+    auto costUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    stats_.inlineRequests++;
+    stats_.maxInlineUs = std::max(stats_.maxInlineUs, costUs);
+    if (budget_.count() > 0 &&
+        costUs > static_cast<uint64_t>(budget_.count())) {
+      stats_.budgetOverruns++;
+      offloadRemaining_ = offloadedPerOverrun_;
+    }
+    return f;
+  }
+
+  const DispatchStats& getDispatchStats() const {
+    return stats_;
+  }
+
+ private:
+  std::shared_ptr<folly::Executor> fallback_;
+  std::chrono::microseconds budget_;
+  uint32_t offloadedPerOverrun_;
+  uint32_t offloadRemaining_{0};
+  DispatchStats stats_;
+};
+
+} // namespace wangle
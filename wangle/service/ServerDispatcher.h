@@ -16,8 +16,25 @@
 
 #pragma once
 
+#include <array>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
+#include <folly/Try.h>
+#include <folly/container/F14Map.h>
 #include <wangle/channel/Handler.h>
+#include <wangle/service/CoroService.h>
 #include <wangle/service/Service.h>
+#include <wangle/service/StreamingService.h>
+#include <wangle/util/Tracepoints.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Invoke.h>
+#include <folly/experimental/coro/Task.h>
+#endif
 
 namespace wangle {
 
@@ -34,6 +51,9 @@ class SerialServerDispatcher : public HandlerAdapter<Req, Resp> {
       : service_(service) {}
 
   void read(Context* ctx, Req in) override {
+    if (WANGLE_SDT_ENABLED(dispatch_read)) {
+      WANGLE_SDT_WITH_SEMAPHORE(dispatch_read, ctx->getTransportRaw(), this);
+    }
     auto resp = (*service_)(std::move(in)).get();
     ctx->fireWrite(std::move(resp));
   }
@@ -42,9 +62,76 @@ class SerialServerDispatcher : public HandlerAdapter<Req, Resp> {
   Service<Req, Resp>* service_;
 };
 
+/**
+ * Dispatch requests from pipeline as they come in, preserving response
+ * order without ever blocking the IO thread (unlike SerialServerDispatcher,
+ * which calls .get() per request).
+ *
+ * A response whose future is already complete with nothing queued ahead of
+ * it is written inline. Otherwise a slot is appended to a completion queue
+ * and filled in when the future fires; completed responses are flushed from
+ * the front in order. Responses are moved end to end, never copied.
+ */
+template <typename Req, typename Resp = Req>
+class OrderedServerDispatcher : public HandlerAdapter<Req, Resp> {
+ public:
+  typedef typename HandlerAdapter<Req, Resp>::Context Context;
+
+  explicit OrderedServerDispatcher(Service<Req, Resp>* service)
+      : service_(service) {}
+
+  void read(Context* ctx, Req in) override {
+    if (WANGLE_SDT_ENABLED(dispatch_read)) {
+      WANGLE_SDT_WITH_SEMAPHORE(dispatch_read, ctx->getTransportRaw(), this);
+    }
+    auto f = (*service_)(std::move(in));
+    if (f.isReady() && pending_.empty()) {
+      // Fast path: nothing queued ahead, complete inline.
+      writeTry(ctx, std::move(f).result());
+      return;
+    }
+
+    pending_.emplace_back();
+    // deque guarantees reference stability under push_back/pop_front, so
+    // the slot pointer stays valid until its own pop.
+    auto* slot = &pending_.back();
+    std::move(f).thenTry([this, slot](folly::Try<Resp> t) {
+      slot->emplace(std::move(t));
+      flush();
+    });
+  }
+
+ private:
+  void flush() {
+    auto ctx = this->getContext();
+    while (!pending_.empty() && pending_.front().has_value()) {
+      auto t = std::move(*pending_.front());
+      pending_.pop_front();
+      writeTry(ctx, std::move(t));
+    }
+  }
+
+  void writeTry(Context* ctx, folly::Try<Resp>&& t) {
+    if (t.hasException()) {
+      ctx->fireWriteException(std::move(t.exception()));
+    } else {
+      ctx->fireWrite(std::move(t).value());
+    }
+  }
+
+  Service<Req, Resp>* service_;
+  std::deque<folly::Optional<folly::Try<Resp>>> pending_;
+};
+
 /**
  * Dispatch requests from pipeline as they come in.
  * Responses are queued until they can be sent in order.
+ *
+ * The reorder buffer is a small ring indexed by requestId: ids within
+ * kReorderRingSize of the last written id land in a fixed slot with no
+ * hashing or rehash churn, which covers all but pathologically deep
+ * pipelines. Deeper completions spill to an F14 map and are drained from
+ * there. Responses are moved end to end, never copied.
  */
 template <typename Req, typename Resp = Req>
 class PipelinedServerDispatcher : public HandlerAdapter<Req, Resp> {
@@ -56,27 +143,56 @@ class PipelinedServerDispatcher : public HandlerAdapter<Req, Resp> {
 
   void read(Context*, Req in) override {
     auto requestId = requestId_++;
-    (*service_)(std::move(in)).then([requestId, this](Resp& resp) {
-      responses_[requestId] = resp;
+    (*service_)(std::move(in)).thenValue([requestId, this](Resp resp) {
+      storeResponse(requestId, std::move(resp));
       sendResponses();
     });
   }
 
   void sendResponses() {
-    auto search = responses_.find(lastWrittenId_ + 1);
-    while (search != responses_.end()) {
-      Resp resp = std::move(search->second);
-      responses_.erase(search->first);
-      this->getContext()->fireWrite(std::move(resp));
+    auto ctx = this->getContext();
+    while (true) {
+      const uint32_t id = lastWrittenId_ + 1;
+      auto& slot = ring_[id & kRingMask];
+      folly::Optional<Resp> resp;
+      if (slot.has_value()) {
+        resp = std::move(slot);
+        slot.reset();
+      } else {
+        auto search = overflow_.find(id);
+        if (search == overflow_.end()) {
+          break;
+        }
+        resp = std::move(search->second);
+        overflow_.erase(search);
+      }
+      ctx->fireWrite(std::move(*resp));
       lastWrittenId_++;
-      search = responses_.find(lastWrittenId_ + 1);
     }
   }
 
  private:
+  static constexpr uint32_t kReorderRingSize = 64;
+  static constexpr uint32_t kRingMask = kReorderRingSize - 1;
+  static_assert(
+      (kReorderRingSize & kRingMask) == 0,
+      "ring size must be a power of two");
+
+  void storeResponse(uint32_t requestId, Resp&& resp) {
+    // Only ids in (lastWrittenId_, lastWrittenId_ + ring size] can share a
+    // slot with another outstanding id, so anything farther out spills to
+    // the map. Slots of already-written ids are always clear.
+    if (requestId - lastWrittenId_ <= kReorderRingSize) {
+      ring_[requestId & kRingMask].emplace(std::move(resp));
+    } else {
+      overflow_.emplace(requestId, std::move(resp));
+    }
+  }
+
   Service<Req, Resp>* service_;
   uint32_t requestId_{1};
-  std::unordered_map<uint32_t, Resp> responses_;
+  std::array<folly::Optional<Resp>, kReorderRingSize> ring_;
+  folly::F14FastMap<uint32_t, Resp> overflow_;
   uint32_t lastWrittenId_{0};
 };
 
@@ -86,6 +202,12 @@ class PipelinedServerDispatcher : public HandlerAdapter<Req, Resp> {
  * by the pipeline.  Unlike a multiplexed client dispatcher, a
  * multiplexed server dispatcher needs no state, and the sequence id's
  * can just be copied from the request to the response in the pipeline.
+ *
+ * While the transport reports itself unwritable (see
+ * AsyncSocketHandler::setWriteWatermarks) requests are parked in a queue
+ * instead of being dispatched, so a slow client stops feeding the service
+ * rather than growing the egress buffer without bound. The queue drains
+ * when the transport turns writable again.
  */
 template <typename Req, typename Resp = Req>
 class MultiplexServerDispatcher : public HandlerAdapter<Req, Resp> {
@@ -96,13 +218,313 @@ class MultiplexServerDispatcher : public HandlerAdapter<Req, Resp> {
       : service_(service) {}
 
   void read(Context* ctx, Req in) override {
+    if (WANGLE_SDT_ENABLED(dispatch_read)) {
+      WANGLE_SDT_WITH_SEMAPHORE(dispatch_read, ctx->getTransportRaw(), this);
+    }
+    if (!writable_) {
+      parked_.push_back(std::move(in));
+      return;
+    }
+    dispatch(ctx, std::move(in));
+  }
+
+  void transportUnwritable(Context* ctx) override {
+    writable_ = false;
+    ctx->fireTransportUnwritable();
+  }
+
+  void transportWritable(Context* ctx) override {
+    writable_ = true;
+    ctx->fireTransportWritable();
+    // A dispatched response can re-saturate the transport inline, which
+    // lands back in transportUnwritable() and stops the drain.
+    while (writable_ && !parked_.empty()) {
+      auto req = std::move(parked_.front());
+      parked_.pop_front();
+      dispatch(ctx, std::move(req));
+    }
+  }
+
+ private:
+  void dispatch(Context* ctx, Req&& in) {
     (*service_)(std::move(in)).thenValue([ctx](Resp resp) {
       ctx->fireWrite(std::move(resp));
     });
   }
 
+  Service<Req, Resp>* service_;
+  std::deque<Req> parked_;
+  bool writable_{true};
+};
+
+/**
+ * Dispatch requests from pipeline through per-lane FIFO queues with a
+ * weighted scheduler, so latency-sensitive requests can overtake bulk
+ * work multiplexed on the same connection. Sequencing is assumed to be
+ * handled by ids in the pipeline, as with MultiplexServerDispatcher.
+ *
+ * A classifier maps each request to a lane; each lane has a weight
+ * (its dispatch share relative to the other lanes when several have
+ * work queued) and a concurrency cap. It is the caps that create the
+ * backlog the scheduler arbitrates: a lane at its cap holds further
+ * requests queued while other lanes keep dispatching. With unlimited
+ * caps every request dispatches immediately and this behaves exactly
+ * like MultiplexServerDispatcher.
+ *
+ * An unwritable transport (see AsyncSocketHandler::setWriteWatermarks)
+ * parks every lane until it turns writable again, exactly as
+ * MultiplexServerDispatcher parks its single queue.
+ */
+template <typename Req, typename Resp = Req>
+class PriorityMultiplexServerDispatcher : public HandlerAdapter<Req, Resp> {
+ public:
+  typedef typename HandlerAdapter<Req, Resp>::Context Context;
+
+  /**
+   * Returns the lane for a request. Out-of-range lanes are clamped to
+   * the last (typically lowest-priority) lane.
+   */
+  using Classifier = folly::Function<size_t(const Req&)>;
+
+  struct LaneConfig {
+    // Dispatch share relative to the other lanes while several lanes
+    // have queued work.
+    uint32_t weight{1};
+    // Maximum requests from this lane in service at once.
+    uint32_t maxConcurrency{std::numeric_limits<uint32_t>::max()};
+  };
+
+  PriorityMultiplexServerDispatcher(
+      Service<Req, Resp>* service,
+      std::vector<LaneConfig> laneConfigs,
+      Classifier classifier)
+      : service_(service), classifier_(std::move(classifier)) {
+    CHECK(!laneConfigs.empty());
+    lanes_.reserve(laneConfigs.size());
+    for (auto& config : laneConfigs) {
+      lanes_.emplace_back();
+      lanes_.back().config = config;
+    }
+  }
+
+  void read(Context* ctx, Req in) override {
+    if (WANGLE_SDT_ENABLED(dispatch_read)) {
+      WANGLE_SDT_WITH_SEMAPHORE(dispatch_read, ctx->getTransportRaw(), this);
+    }
+    auto idx = std::min(classifier_(in), lanes_.size() - 1);
+    lanes_[idx].queue.push_back(std::move(in));
+    pump(ctx);
+  }
+
+  void transportUnwritable(Context* ctx) override {
+    writable_ = false;
+    ctx->fireTransportUnwritable();
+  }
+
+  void transportWritable(Context* ctx) override {
+    writable_ = true;
+    ctx->fireTransportWritable();
+    pump(ctx);
+  }
+
  private:
+  struct Lane {
+    LaneConfig config;
+    std::deque<Req> queue;
+    uint32_t inFlight{0};
+    // Smooth weighted round-robin credit.
+    int64_t credit{0};
+  };
+
+  // Dispatches queued work until every lane is empty or at its cap.
+  // Lane selection is smooth weighted round robin: every eligible lane
+  // gains its weight in credit per pick, the richest lane dispatches
+  // and pays back the total, so picks interleave in weight proportion.
+  void pump(Context* ctx) {
+    if (pumping_) {
+      // An inline service completion re-entered; the outer loop will
+      // pick up the new state.
+      return;
+    }
+    pumping_ = true;
+    while (writable_) {
+      Lane* best = nullptr;
+      int64_t totalWeight = 0;
+      for (auto& lane : lanes_) {
+        if (lane.queue.empty() || lane.inFlight >= lane.config.maxConcurrency) {
+          continue;
+        }
+        lane.credit += lane.config.weight;
+        totalWeight += lane.config.weight;
+        if (best == nullptr || lane.credit > best->credit) {
+          best = &lane;
+        }
+      }
+      if (best == nullptr) {
+        break;
+      }
+      best->credit -= totalWeight;
+      auto req = std::move(best->queue.front());
+      best->queue.pop_front();
+      dispatch(ctx, *best, std::move(req));
+    }
+    pumping_ = false;
+  }
+
+  void dispatch(Context* ctx, Lane& lane, Req&& req) {
+    ++lane.inFlight;
+    // lanes_ never resizes after construction, so the reference stays
+    // valid for the completion callback.
+    (*service_)(std::move(req)).thenValue([this, ctx, &lane](Resp resp) {
+      ctx->fireWrite(std::move(resp));
+      --lane.inFlight;
+      pump(ctx);
+    });
+  }
+
   Service<Req, Resp>* service_;
+  Classifier classifier_;
+  std::vector<Lane> lanes_;
+  bool pumping_{false};
+  bool writable_{true};
+};
+
+/**
+ * Dispatch requests to a StreamingService one at a time, writing each
+ * chunk through the pipeline as it is produced; requests arriving
+ * while a stream is in flight are parked and served in order once it
+ * ends.
+ *
+ * Demand is tied to transport writability (see
+ * AsyncSocketHandler::setWriteWatermarks): at most one chunk is ever
+ * pulled at a time, and while the transport reports itself unwritable
+ * no further chunks are pulled at all, so a stalled client pauses
+ * production with at most one chunk buffered instead of the whole
+ * result set sitting in the egress buffer.
+ */
+template <typename Req, typename Resp = Req>
+class StreamingServerDispatcher : public HandlerAdapter<Req, Resp> {
+ public:
+  typedef typename HandlerAdapter<Req, Resp>::Context Context;
+
+  explicit StreamingServerDispatcher(StreamingService<Req, Resp>* service)
+      : service_(service) {}
+
+  void read(Context* ctx, Req in) override {
+    if (WANGLE_SDT_ENABLED(dispatch_read)) {
+      WANGLE_SDT_WITH_SEMAPHORE(dispatch_read, ctx->getTransportRaw(), this);
+    }
+    if (stream_) {
+      parked_.push_back(std::move(in));
+      return;
+    }
+    stream_ = (*service_)(std::move(in));
+    pump(ctx);
+  }
+
+  void transportUnwritable(Context* ctx) override {
+    writable_ = false;
+    ctx->fireTransportUnwritable();
+  }
+
+  void transportWritable(Context* ctx) override {
+    writable_ = true;
+    ctx->fireTransportWritable();
+    pump(ctx);
+  }
+
+ private:
+  // Pulls and writes chunks until the stream ends, the transport
+  // turns unwritable, or a pull goes asynchronous. Iterative so a
+  // stream of already-ready chunks costs no stack depth.
+  void pump(Context* ctx) {
+    if (pumping_) {
+      return;
+    }
+    pumping_ = true;
+    while (stream_ && writable_ && !pullPending_) {
+      auto f = stream_->next();
+      if (!f.isReady()) {
+        pullPending_ = true;
+        std::move(f).thenTry(
+            [this, ctx](folly::Try<folly::Optional<Resp>> t) {
+              pullPending_ = false;
+              onChunk(ctx, std::move(t));
+              pump(ctx);
+            });
+        break;
+      }
+      onChunk(ctx, std::move(f).result());
+    }
+    pumping_ = false;
+  }
+
+  // Writes one pulled chunk; an empty chunk or an error ends the
+  // stream and starts the next parked request, if any.
+  void onChunk(Context* ctx, folly::Try<folly::Optional<Resp>>&& t) {
+    if (t.hasException()) {
+      stream_.reset();
+      ctx->fireWriteException(std::move(t.exception()));
+    } else if (t->has_value()) {
+      // fireWrite can turn the transport unwritable inline; the pump
+      // loop rechecks writable_ before the next pull.
+      ctx->fireWrite(std::move(**t));
+      return;
+    } else {
+      stream_.reset();
+    }
+    if (!parked_.empty()) {
+      auto req = std::move(parked_.front());
+      parked_.pop_front();
+      stream_ = (*service_)(std::move(req));
+    }
+  }
+
+  StreamingService<Req, Resp>* service_;
+  std::unique_ptr<ResponseStream<Resp>> stream_;
+  std::deque<Req> parked_;
+  bool writable_{true};
+  bool pullPending_{false};
+  bool pumping_{false};
 };
 
+#if FOLLY_HAS_COROUTINES
+
+/**
+ * The coroutine analog of MultiplexServerDispatcher: each request
+ * starts a task on the transport's EventBase that awaits the
+ * CoroService and writes the response out. Sequencing is assumed to be
+ * handled by ids in the pipeline, exactly as for the Future version.
+ *
+ * A request that never suspends runs start-to-finish in one executor
+ * hop with no future cores; the Future version pays a promise/core
+ * pair per request on top of the service's own.
+ */
+template <typename Req, typename Resp = Req>
+class CoroMultiplexServerDispatcher : public HandlerAdapter<Req, Resp> {
+ public:
+  typedef typename HandlerAdapter<Req, Resp>::Context Context;
+
+  explicit CoroMultiplexServerDispatcher(CoroService<Req, Resp>* service)
+      : service_(service) {}
+
+  void read(Context* ctx, Req in) override {
+    if (WANGLE_SDT_ENABLED(dispatch_read)) {
+      WANGLE_SDT_WITH_SEMAPHORE(dispatch_read, ctx->getTransportRaw(), this);
+    }
+    folly::coro::co_invoke(
+        [this, ctx, in = std::move(in)]() mutable -> folly::coro::Task<void> {
+          auto resp = co_await service_->co_invoke(std::move(in));
+          ctx->fireWrite(std::move(resp));
+        })
+        .scheduleOn(ctx->getTransport()->getEventBase())
+        .start();
+  }
+
+ private:
+  CoroService<Req, Resp>* service_;
+};
+
+#endif // FOLLY_HAS_COROUTINES
+
 } // namespace wangle
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <folly/Function.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/Future.h>
+
+namespace wangle {
+
+/**
+ * Coarse-bucketed expiry timers shared by many services.
+ *
+ * A per-instance timeout (one folly timekeeper entry per ExpiringFilter,
+ * cancelled and re-armed on every request) is fine for a handful of
+ * services but loads the timekeeper heavily when hundreds of thousands
+ * of filtered services are alive at once. This tracker instead sorts
+ * tracked entries into generation buckets of tickInterval width and
+ * keeps a single timekeeper timer armed for the next tick, so there is
+ * one wakeup per tick regardless of population. Activity is recorded
+ * lazily: touch() only stamps a timestamp, and when an entry's bucket
+ * comes due it is re-bucketed at its real deadline instead of fired.
+ *
+ * Deadlines are rounded up to the tick interval, so expiry can fire up
+ * to one tick late; pick a tick that is coarse relative to the
+ * timekeeper (the default one second) but fine relative to the
+ * timeouts being tracked.
+ *
+ * Must be owned by a shared_ptr: the armed timer holds a weak
+ * reference and goes quiet when the tracker is destroyed. All methods
+ * are thread-safe. Expiry callbacks run on the timekeeper's thread and
+ * must not block; a callback may return false to decline expiry (e.g.
+ * requests are still outstanding), which re-arms the entry a full
+ * timeout out.
+ */
+class ServiceExpiryTracker
+    : public std::enable_shared_from_this<ServiceExpiryTracker> {
+ public:
+  using ExpiryCallback = folly::Function<bool()>;
+
+  explicit ServiceExpiryTracker(
+      std::chrono::milliseconds tickInterval = std::chrono::seconds(1),
+      folly::Timekeeper* timekeeper = nullptr)
+      : tickInterval_(tickInterval), timekeeper_(timekeeper) {}
+
+  /**
+   * Starts tracking an entry that expires once no touch() has been seen
+   * for the given timeout. Returns a token for touch()/untrack(); 0 is
+   * never a valid token.
+   */
+  uint64_t track(std::chrono::milliseconds timeout, ExpiryCallback callback) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    const auto token = nextToken_++;
+    const auto now = std::chrono::steady_clock::now();
+    entries_.emplace(token, Entry{timeout, now, std::move(callback)});
+    buckets_[deadlineBucket(now + timeout)].push_back(token);
+    armTimer();
+    return token;
+  }
+
+  /**
+   * Records activity on an entry. O(1): the entry is not moved between
+   * buckets until its current bucket comes due.
+   */
+  void touch(uint64_t token) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = entries_.find(token);
+    if (it != entries_.end()) {
+      it->second.lastActivity = std::chrono::steady_clock::now();
+    }
+  }
+
+  void untrack(uint64_t token) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    entries_.erase(token);
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::chrono::milliseconds timeout;
+    std::chrono::steady_clock::time_point lastActivity;
+    ExpiryCallback callback;
+  };
+
+  using Bucket = uint64_t;
+
+  // Rounded up, so an entry never comes due before its deadline.
+  Bucket deadlineBucket(std::chrono::steady_clock::time_point tp) const {
+    const auto sinceEpoch =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            tp.time_since_epoch());
+    return (sinceEpoch + tickInterval_ - std::chrono::milliseconds(1)) /
+        tickInterval_;
+  }
+
+  Bucket elapsedBucket(std::chrono::steady_clock::time_point tp) const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               tp.time_since_epoch()) /
+        tickInterval_;
+  }
+
+  // Called with mutex_ held.
+  void armTimer() {
+    if (timerArmed_ || entries_.empty()) {
+      return;
+    }
+    timerArmed_ = true;
+    folly::futures::sleep(tickInterval_, timekeeper_)
+        .toUnsafeFuture()
+        .thenValue([weak = weak_from_this()](auto&&) {
+          if (auto self = weak.lock()) {
+            self->onTick();
+          }
+        });
+  }
+
+  void onTick() {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<uint64_t> due;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      timerArmed_ = false;
+      const auto nowBucket = elapsedBucket(now);
+      for (auto it = buckets_.begin(); it != buckets_.end();) {
+        if (it->first <= nowBucket) {
+          due.insert(due.end(), it->second.begin(), it->second.end());
+          it = buckets_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    for (const auto token : due) {
+      fireOrRebucket(token, now);
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    armTimer();
+  }
+
+  void fireOrRebucket(
+      uint64_t token,
+      std::chrono::steady_clock::time_point now) {
+    ExpiryCallback callback;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto it = entries_.find(token);
+      if (it == entries_.end()) {
+        return;
+      }
+      const auto deadline = it->second.lastActivity + it->second.timeout;
+      if (deadline > now) {
+        // Touched since it was bucketed; park it at the real deadline.
+        buckets_[deadlineBucket(deadline)].push_back(token);
+        return;
+      }
+      callback = std::move(it->second.callback);
+    }
+    // Run the callback unlocked: it may call back into the tracker.
+    const bool expired = callback();
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = entries_.find(token);
+    if (it == entries_.end()) {
+      return; // untracked while firing
+    }
+    if (expired) {
+      entries_.erase(it);
+    } else {
+      it->second.callback = std::move(callback);
+      it->second.lastActivity = now;
+      buckets_[deadlineBucket(now + it->second.timeout)].push_back(token);
+    }
+  }
+
+  const std::chrono::milliseconds tickInterval_;
+  folly::Timekeeper* timekeeper_;
+  mutable std::mutex mutex_;
+  uint64_t nextToken_{1};
+  folly::F14FastMap<uint64_t, Entry> entries_;
+  folly::F14FastMap<Bucket, std::vector<uint64_t>> buckets_;
+  bool timerArmed_{false};
+};
+
+} // namespace wangle
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
+#include <folly/futures/Future.h>
+
+namespace wangle {
+
+/**
+ * A pull-based stream of response chunks. next() yields the next
+ * chunk; an empty Optional ends the stream. The consumer pulls one
+ * chunk at a time and never calls next() again before the previous
+ * pull completes, so pausing the pulls pauses production - that is
+ * the whole flow-control story - and implementations need no internal
+ * buffering or synchronization of their own.
+ */
+template <typename Resp>
+class ResponseStream {
+ public:
+  virtual ~ResponseStream() = default;
+
+  virtual folly::Future<folly::Optional<Resp>> next() = 0;
+};
+
+/**
+ * Adapts a pull function into a ResponseStream, for streams whose
+ * production state fits in a lambda.
+ */
+template <typename Resp>
+class FunctionResponseStream : public ResponseStream<Resp> {
+ public:
+  using PullFn = folly::Function<folly::Future<folly::Optional<Resp>>()>;
+
+  explicit FunctionResponseStream(PullFn pull) : pull_(std::move(pull)) {}
+
+  folly::Future<folly::Optional<Resp>> next() override {
+    return pull_();
+  }
+
+ private:
+  PullFn pull_;
+};
+
+/**
+ * A Service variant for scan-style RPCs whose response is a stream of
+ * chunks rather than one value. Where Service<Req, Resp> forces the
+ * whole result set into a single Resp before anything is written, a
+ * StreamingService hands back a ResponseStream that the dispatcher
+ * (see StreamingServerDispatcher) drains chunk by chunk: the first
+ * chunk reaches the wire as soon as it is produced, and peak
+ * buffering is one chunk instead of the result set.
+ */
+template <typename Req, typename Resp = Req>
+class StreamingService {
+ public:
+  virtual ~StreamingService() = default;
+
+  virtual std::unique_ptr<ResponseStream<Resp>> operator()(Req request) = 0;
+
+  virtual folly::Future<folly::Unit> close() {
+    return folly::makeFuture();
+  }
+
+  virtual bool isAvailable() {
+    return true;
+  }
+};
+
+} // namespace wangle
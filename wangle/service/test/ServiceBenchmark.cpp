@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <wangle/service/ComposedService.h>
+#include <wangle/service/Service.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+class EchoService : public Service<std::string, std::string> {
+ public:
+  Future<std::string> operator()(std::string req) override {
+    return req;
+  }
+};
+
+/**
+ * A filter that forwards unchanged, so the chains below measure layer
+ * plumbing only.
+ */
+class PassThroughFilter : public ServiceFilter<std::string, std::string> {
+ public:
+  using ServiceFilter<std::string, std::string>::ServiceFilter;
+
+  Future<std::string> operator()(std::string req) override {
+    return (*service_)(std::move(req));
+  }
+};
+
+/**
+ * The same no-op as a compile-time layer.
+ */
+struct PassThroughLayer {
+  template <typename Next>
+  Future<std::string> operator()(Next&& next, std::string req) {
+    return next(std::move(req));
+  }
+};
+
+struct EchoLayer {
+  Future<std::string> operator()(std::string req) {
+    return req;
+  }
+};
+
+std::shared_ptr<Service<std::string, std::string>> makeDynamicChain(
+    size_t depth) {
+  std::shared_ptr<Service<std::string, std::string>> service =
+      std::make_shared<EchoService>();
+  for (size_t i = 0; i < depth; i++) {
+    service = std::make_shared<PassThroughFilter>(service);
+  }
+  return service;
+}
+
+void runDynamic(size_t iters, size_t depth) {
+  BenchmarkSuspender susp;
+  auto service = makeDynamicChain(depth);
+  std::string payload = "0123456789abcdef";
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    doNotOptimizeAway((*service)(payload).get());
+  }
+}
+
+} // namespace
+
+/*
+ * Per-layer plumbing cost of the dynamic filter stack: every layer is a
+ * virtual hop through a separately allocated filter object.
+ */
+BENCHMARK_NAMED_PARAM(runDynamic, 0_filters, 0)
+BENCHMARK_NAMED_PARAM(runDynamic, 1_filter, 1)
+BENCHMARK_NAMED_PARAM(runDynamic, 6_filters, 6)
+BENCHMARK_DRAW_LINE();
+
+/*
+ * The standard six-deep production stack, dynamic versus fused. The
+ * fused chain resolves every hop at compile time, so the pass-through
+ * layers should cost nothing beyond the leaf service call.
+ */
+BENCHMARK(dynamicChain6, iters) {
+  runDynamic(iters, 6);
+}
+
+BENCHMARK_RELATIVE(fusedChain6, iters) {
+  BenchmarkSuspender susp;
+  ComposedService<
+      std::string,
+      std::string,
+      PassThroughLayer,
+      PassThroughLayer,
+      PassThroughLayer,
+      PassThroughLayer,
+      PassThroughLayer,
+      PassThroughLayer,
+      EchoLayer>
+      service(
+          PassThroughLayer(),
+          PassThroughLayer(),
+          PassThroughLayer(),
+          PassThroughLayer(),
+          PassThroughLayer(),
+          PassThroughLayer(),
+          EchoLayer());
+  std::string payload = "0123456789abcdef";
+  susp.dismiss();
+
+  for (size_t i = 0; i < iters; i++) {
+    doNotOptimizeAway(service(payload).get());
+  }
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
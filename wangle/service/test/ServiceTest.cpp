@@ -14,15 +14,34 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <deque>
+#include <thread>
+
 #include <folly/portability/GTest.h>
 
+#include <folly/executors/ManualExecutor.h>
+#include <folly/synchronization/Baton.h>
 #include <wangle/codec/ByteToMessageDecoder.h>
 #include <wangle/codec/StringCodec.h>
+#include <wangle/service/BatchingExecutorFilter.h>
+#include <wangle/service/CachingFilter.h>
 #include <wangle/service/ClientDispatcher.h>
 #include <wangle/service/CloseOnReleaseFilter.h>
+#include <wangle/service/ComposedService.h>
+#include <wangle/service/CoroService.h>
 #include <wangle/service/ExpiringFilter.h>
+#include <wangle/service/LoadSheddingFilter.h>
+#include <wangle/service/MessagePool.h>
+#include <wangle/service/RunInlineFilter.h>
 #include <wangle/service/ServerDispatcher.h>
 #include <wangle/service/Service.h>
+#include <wangle/service/ServiceExpiryTracker.h>
+#include <wangle/service/StreamingService.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#endif
 
 namespace wangle {
 
@@ -253,6 +272,84 @@ TEST(Wangle, FactoryToService) {
   EXPECT_EQ("test", service("test").value());
 }
 
+struct SeqMsg {
+  uint64_t id{0};
+  std::string text;
+};
+
+typedef Pipeline<SeqMsg, SeqMsg> SeqMsgPipeline;
+
+// Captures writes at the bottom of the pipeline so the test can play the
+// "server" and feed responses back in any order.
+class SeqMsgCapture : public HandlerAdapter<SeqMsg, SeqMsg> {
+ public:
+  Future<Unit> write(Context*, SeqMsg msg) override {
+    writes.push_back(std::move(msg));
+    return makeFuture();
+  }
+  std::vector<SeqMsg> writes;
+};
+
+TEST(Wangle, WindowedClientDispatcher) {
+  SeqMsgCapture capture;
+  auto pipeline = SeqMsgPipeline::create();
+  pipeline->addBack(&capture);
+
+  WindowedClientDispatcher<SeqMsgPipeline, SeqMsg> dispatcher(
+      [](SeqMsg& msg, uint64_t id) { msg.id = id; },
+      [](const SeqMsg& msg) { return msg.id; },
+      2 /* maxInFlight */);
+  dispatcher.setPipeline(pipeline.get());
+
+  auto f1 = dispatcher(SeqMsg{0, "a"});
+  auto f2 = dispatcher(SeqMsg{0, "b"});
+  // Window is full; the third request waits for a free slot.
+  auto f3 = dispatcher(SeqMsg{0, "c"});
+  EXPECT_EQ(capture.writes.size(), 2);
+  EXPECT_EQ(dispatcher.getRequestsInFlight(), 2);
+  EXPECT_EQ(dispatcher.getWindowStats().queued, 1);
+
+  // Complete out of order: the second response frees a slot, which
+  // dispatches the queued request.
+  pipeline->read(SeqMsg{capture.writes[1].id, "B"});
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_FALSE(f1.isReady());
+  EXPECT_EQ(capture.writes.size(), 3);
+  EXPECT_EQ(capture.writes[2].text, "c");
+
+  pipeline->read(SeqMsg{capture.writes[0].id, "A"});
+  pipeline->read(SeqMsg{capture.writes[2].id, "C"});
+  EXPECT_EQ(std::move(f1).get().text, "A");
+  EXPECT_EQ(std::move(f2).get().text, "B");
+  EXPECT_EQ(std::move(f3).get().text, "C");
+  EXPECT_EQ(dispatcher.getRequestsInFlight(), 0);
+  EXPECT_EQ(dispatcher.getWindowStats().dispatched, 3);
+  EXPECT_EQ(dispatcher.getWindowStats().completed, 3);
+}
+
+TEST(Wangle, WindowedClientDispatcherFailPolicy) {
+  SeqMsgCapture capture;
+  auto pipeline = SeqMsgPipeline::create();
+  pipeline->addBack(&capture);
+
+  typedef WindowedClientDispatcher<SeqMsgPipeline, SeqMsg> Dispatcher;
+  Dispatcher dispatcher(
+      [](SeqMsg& msg, uint64_t id) { msg.id = id; },
+      [](const SeqMsg& msg) { return msg.id; },
+      1 /* maxInFlight */,
+      Dispatcher::WindowFullPolicy::FAIL);
+  dispatcher.setPipeline(pipeline.get());
+
+  auto f1 = dispatcher(SeqMsg{0, "a"});
+  auto f2 = dispatcher(SeqMsg{0, "b"});
+  EXPECT_TRUE(f2.isReady());
+  EXPECT_TRUE(std::move(f2).result().hasException());
+  EXPECT_EQ(dispatcher.getWindowStats().rejected, 1);
+
+  pipeline->read(SeqMsg{capture.writes[0].id, "A"});
+  EXPECT_EQ(std::move(f1).get().text, "A");
+}
+
 class TimekeeperTester : public Timekeeper {
  public:
   SemiFuture<Unit> after(HighResDuration) override {
@@ -328,4 +425,601 @@ TEST(ServiceFilter, NoIdleDuringRequests) {
   EXPECT_EQ(3, timekeeper.promises_.size());
 }
 
+// A service whose responses complete only when the test says so.
+class ManualService : public Service<std::string, std::string> {
+ public:
+  Future<std::string> operator()(std::string /* req */) override {
+    promises_.emplace_back();
+    return promises_.back().getFuture();
+  }
+
+  std::vector<Promise<std::string>> promises_;
+};
+
+TEST(ServiceFilter, GracefulRelease) {
+  TimekeeperTester timekeeper;
+
+  auto service = std::make_shared<ManualService>();
+  auto closeOnReleaseService =
+      std::make_shared<CloseOnReleaseFilter<std::string, std::string>>(service);
+
+  auto pending = (*closeOnReleaseService)("inflight");
+  auto closed = closeOnReleaseService->closeGracefully(
+      std::chrono::milliseconds(100), &timekeeper);
+
+  // New dispatches are rejected immediately...
+  EXPECT_TRUE((*closeOnReleaseService)("rejected").result().hasException());
+  // ...but the close waits for the in-flight response.
+  EXPECT_FALSE(closed.isReady());
+  service->promises_[0].setValue("done");
+  EXPECT_EQ("done", std::move(pending).get());
+  EXPECT_TRUE(closed.isReady());
+}
+
+TEST(ServiceFilter, ExpiringDrainsBeforeClose) {
+  TimekeeperTester timekeeper;
+
+  auto service = std::make_shared<ManualService>();
+  auto closeOnReleaseService =
+      std::make_shared<CloseOnReleaseFilter<std::string, std::string>>(service);
+  auto expiringService =
+      std::make_shared<ExpiringFilter<std::string, std::string>>(
+          closeOnReleaseService,
+          std::chrono::milliseconds(0),
+          std::chrono::milliseconds(400),
+          &timekeeper);
+  expiringService->setDrainTimeout(std::chrono::milliseconds(100));
+
+  auto pending = (*expiringService)("inflight");
+  // Fire the max timer; the filter starts draining instead of closing.
+  timekeeper.promises_[0].setValue();
+  EXPECT_TRUE((*expiringService)("rejected").result().hasException());
+  EXPECT_FALSE(pending.isReady());
+
+  service->promises_[0].setValue("done");
+  EXPECT_EQ("done", std::move(pending).get());
+  // Once drained, the wrapped service has been closed too.
+  EXPECT_TRUE((*closeOnReleaseService)("closed").result().hasException());
+}
+
+TEST(ServiceExpiryTracker, FiresExpiredEntries) {
+  auto tracker =
+      std::make_shared<ServiceExpiryTracker>(std::chrono::milliseconds(5));
+
+  folly::Baton<> fired;
+  tracker->track(std::chrono::milliseconds(1), [&] {
+    fired.post();
+    return true;
+  });
+  EXPECT_TRUE(fired.try_wait_for(std::chrono::seconds(2)));
+  // A consumed entry is dropped from the tracker.
+  while (tracker->size() != 0) {
+    std::this_thread::yield();
+  }
+}
+
+TEST(ServiceExpiryTracker, DecliningExpiryRearms) {
+  auto tracker =
+      std::make_shared<ServiceExpiryTracker>(std::chrono::milliseconds(5));
+
+  // The first firing declines; the tracker must come back a full
+  // timeout later instead of dropping the entry.
+  std::atomic<int> firings{0};
+  folly::Baton<> done;
+  tracker->track(std::chrono::milliseconds(1), [&] {
+    if (++firings < 2) {
+      return false;
+    }
+    done.post();
+    return true;
+  });
+  EXPECT_TRUE(done.try_wait_for(std::chrono::seconds(2)));
+  EXPECT_EQ(2, firings.load());
+}
+
+TEST(ServiceFilter, ExpiringWithSharedTracker) {
+  auto tracker =
+      std::make_shared<ServiceExpiryTracker>(std::chrono::milliseconds(5));
+
+  std::shared_ptr<Service<std::string, std::string>> service =
+      std::make_shared<EchoService>();
+  std::shared_ptr<Service<std::string, std::string>> closeOnReleaseService =
+      std::make_shared<CloseOnReleaseFilter<std::string, std::string>>(service);
+  auto expiringService =
+      std::make_shared<ExpiringFilter<std::string, std::string>>(
+          closeOnReleaseService, tracker, std::chrono::milliseconds(1));
+
+  EXPECT_EQ("test", (*expiringService)("test").get());
+
+  // The shared tracker closes the filter once it goes idle.
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  bool closed = false;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if ((*expiringService)("test").result().hasException()) {
+      closed = true;
+      break;
+    }
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  EXPECT_TRUE(closed);
+}
+
+// Compile-time layers for the fused chain tests. Layers live at
+// namespace scope because their call operators are templates.
+struct BangLayer {
+  template <typename Next>
+  Future<std::string> operator()(Next&& next, std::string req) {
+    return next(std::move(req) + "!");
+  }
+};
+
+struct RejectEmptyLayer {
+  template <typename Next>
+  Future<std::string> operator()(Next&& next, std::string req) {
+    if (req.empty()) {
+      return makeFuture<std::string>(
+          make_exception_wrapper<std::runtime_error>("empty request"));
+    }
+    return next(std::move(req));
+  }
+};
+
+TEST(ComposedService, FusedChain) {
+  auto leaf = std::make_shared<EchoService>();
+  ComposedService<
+      std::string,
+      std::string,
+      RejectEmptyLayer,
+      BangLayer,
+      ServiceLeaf<std::string>>
+      service(RejectEmptyLayer(), BangLayer(), ServiceLeaf<std::string>(leaf));
+
+  EXPECT_EQ("test!", service("test").get());
+  // A layer may short-circuit without reaching the leaf.
+  EXPECT_TRUE(service("").result().hasException());
+}
+
+TEST(ComposedService, ForwardsCloseToLayers) {
+  std::shared_ptr<Service<std::string, std::string>> echo =
+      std::make_shared<EchoService>();
+  auto closeOnRelease =
+      std::make_shared<CloseOnReleaseFilter<std::string, std::string>>(echo);
+  ComposedService<std::string, std::string, BangLayer, ServiceLeaf<std::string>>
+      service(BangLayer(), ServiceLeaf<std::string>(closeOnRelease));
+
+  EXPECT_TRUE(service.isAvailable());
+  service.close().get();
+  // close() reached the wrapped dynamic service through the leaf layer.
+  EXPECT_TRUE((*closeOnRelease)("closed").result().hasException());
+}
+
+TEST(ServiceFilter, LoadShedding) {
+  auto service = std::make_shared<ManualService>();
+  LoadSheddingFilter<std::string> filter(
+      service, 2 /* maxInFlight */, [](const std::string&) {
+        return std::chrono::microseconds(1000);
+      });
+
+  auto f1 = filter("a");
+  auto f2 = filter("b");
+  // Over the in-flight cap: fails fast without reaching the service.
+  auto f3 = filter("c");
+  EXPECT_TRUE(f3.isReady());
+  EXPECT_TRUE(f3.result().hasException<LoadSheddedException>());
+  EXPECT_EQ(2, service->promises_.size());
+  EXPECT_EQ(2, filter.getStats().passed);
+  EXPECT_EQ(1, filter.getStats().shed);
+
+  service->promises_[0].setValue("done");
+  EXPECT_EQ("done", std::move(f1).get());
+
+  // One slot free, but the estimated queueing delay behind the remaining
+  // in-flight request now exceeds the 1ms deadline tag.
+  filter.setLatencyEstimate(std::chrono::microseconds(5000));
+  auto f4 = filter("d");
+  EXPECT_TRUE(f4.result().hasException<LoadSheddedException>());
+  EXPECT_EQ(2, filter.getStats().shed);
+
+  service->promises_[1].setValue("done");
+  EXPECT_EQ("done", std::move(f2).get());
+  // Everything drained; dispatches flow again.
+  auto f5 = filter("e");
+  EXPECT_FALSE(f5.isReady());
+  EXPECT_EQ(3, filter.getStats().passed);
+}
+
+TEST(ServiceFilter, BatchingExecutor) {
+  auto executor = std::make_shared<folly::ManualExecutor>();
+  auto filter =
+      std::make_shared<BatchingExecutorFilter<std::string, std::string>>(
+          executor, std::make_shared<EchoService>());
+
+  auto f1 = (*filter)("1");
+  auto f2 = (*filter)("2");
+  auto f3 = (*filter)("3");
+  EXPECT_FALSE(f1.isReady());
+
+  // The whole burst drains off a single executor wakeup, in order.
+  EXPECT_EQ(1, executor->run());
+  EXPECT_EQ("1", std::move(f1).get());
+  EXPECT_EQ("2", std::move(f2).get());
+  EXPECT_EQ("3", std::move(f3).get());
+}
+
+// Echoes after spinning for a configurable amount of CPU time.
+class BusyEchoService : public Service<std::string, std::string> {
+ public:
+  Future<std::string> operator()(std::string req) override {
+    auto until = std::chrono::steady_clock::now() + busy;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    return req;
+  }
+
+  std::chrono::microseconds busy{0};
+};
+
+TEST(ServiceFilter, RunInline) {
+  auto executor = std::make_shared<folly::ManualExecutor>();
+  auto service = std::make_shared<BusyEchoService>();
+  auto filter = std::make_shared<RunInlineFilter<std::string, std::string>>(
+      executor,
+      service,
+      std::chrono::microseconds(500),
+      2 /* offloadedPerOverrun */);
+
+  // Cheap requests complete synchronously on the calling thread.
+  EXPECT_EQ("a", (*filter)("a").value());
+  EXPECT_EQ(filter->getDispatchStats().inlineRequests, 1);
+  EXPECT_EQ(filter->getDispatchStats().offloadedRequests, 0);
+
+  // Blowing the budget sends the next two requests to the executor.
+  service->busy = std::chrono::milliseconds(5);
+  EXPECT_EQ("b", (*filter)("b").value());
+  EXPECT_EQ(filter->getDispatchStats().budgetOverruns, 1);
+
+  service->busy = std::chrono::microseconds(0);
+  auto f1 = (*filter)("c");
+  auto f2 = (*filter)("d");
+  EXPECT_FALSE(f1.isReady());
+  EXPECT_FALSE(f2.isReady());
+  executor->run();
+  EXPECT_EQ("c", std::move(f1).get());
+  EXPECT_EQ("d", std::move(f2).get());
+  EXPECT_EQ(filter->getDispatchStats().offloadedRequests, 2);
+
+  // Then inline execution is probed again.
+  EXPECT_EQ("e", (*filter)("e").value());
+  EXPECT_EQ(filter->getDispatchStats().inlineRequests, 3);
+}
+
+typedef Pipeline<std::string, std::string> StreamPipeline;
+
+// Captures what the streaming dispatcher writes; can flip the
+// transport unwritable after a set number of writes to simulate a
+// watermark trip in the middle of a stream.
+class StreamCapture : public HandlerAdapter<std::string, std::string> {
+ public:
+  Future<Unit> write(Context*, std::string msg) override {
+    writes.push_back(std::move(msg));
+    if (pauseAfter > 0 && writes.size() == pauseAfter && pipeline) {
+      pauseAfter = 0;
+      pipeline->transportUnwritable();
+    }
+    return makeFuture();
+  }
+  Future<Unit> writeException(Context*, exception_wrapper) override {
+    errors++;
+    return makeFuture();
+  }
+  std::vector<std::string> writes;
+  size_t pauseAfter{0};
+  StreamPipeline* pipeline{nullptr};
+  int errors{0};
+};
+
+// Streams "<req>:0" .. "<req>:n-1", every chunk ready immediately.
+class CountdownStreamingService
+    : public StreamingService<std::string, std::string> {
+ public:
+  explicit CountdownStreamingService(int chunks) : chunks_(chunks) {}
+
+  std::unique_ptr<ResponseStream<std::string>> operator()(
+      std::string req) override {
+    auto sent = std::make_shared<int>(0);
+    auto total = chunks_;
+    return std::make_unique<FunctionResponseStream<std::string>>(
+        [req = std::move(req), sent, total]() -> Future<Optional<std::string>> {
+          if (*sent == total) {
+            return folly::none;
+          }
+          return folly::make_optional(
+              folly::to<std::string>(req, ":", (*sent)++));
+        });
+  }
+
+ private:
+  int chunks_;
+};
+
+// Every pull hands back a promise for the test to fulfill.
+class ManualStreamingService
+    : public StreamingService<std::string, std::string> {
+ public:
+  std::unique_ptr<ResponseStream<std::string>> operator()(
+      std::string) override {
+    return std::make_unique<FunctionResponseStream<std::string>>([this] {
+      pulls.emplace_back();
+      return pulls.back().getFuture();
+    });
+  }
+
+  std::deque<Promise<Optional<std::string>>> pulls;
+};
+
+TEST(Wangle, StreamingServerDispatcher) {
+  StreamCapture capture;
+  CountdownStreamingService service(3);
+  auto pipeline = StreamPipeline::create();
+  pipeline->addBack(&capture);
+  pipeline->addBack(
+      StreamingServerDispatcher<std::string, std::string>(&service));
+  pipeline->finalize();
+
+  pipeline->read("a");
+  ASSERT_EQ(capture.writes.size(), 3);
+  EXPECT_EQ(capture.writes[0], "a:0");
+  EXPECT_EQ(capture.writes[1], "a:1");
+  EXPECT_EQ(capture.writes[2], "a:2");
+
+  // While the transport is unwritable nothing is pulled; a request
+  // arriving on top of an open stream is parked and served after it.
+  pipeline->transportUnwritable();
+  pipeline->read("b");
+  pipeline->read("c");
+  EXPECT_EQ(capture.writes.size(), 3);
+
+  pipeline->transportWritable();
+  ASSERT_EQ(capture.writes.size(), 9);
+  EXPECT_EQ(capture.writes[3], "b:0");
+  EXPECT_EQ(capture.writes[5], "b:2");
+  EXPECT_EQ(capture.writes[6], "c:0");
+  EXPECT_EQ(capture.writes[8], "c:2");
+}
+
+TEST(Wangle, StreamingServerDispatcherMidStreamBackpressure) {
+  StreamCapture capture;
+  CountdownStreamingService service(5);
+  auto pipeline = StreamPipeline::create();
+  pipeline->addBack(&capture);
+  pipeline->addBack(
+      StreamingServerDispatcher<std::string, std::string>(&service));
+  pipeline->finalize();
+  capture.pipeline = pipeline.get();
+  capture.pauseAfter = 2;
+
+  // The second write trips the watermark from inside fireWrite; the
+  // pump must notice before pulling the third chunk.
+  pipeline->read("a");
+  EXPECT_EQ(capture.writes.size(), 2);
+
+  pipeline->transportWritable();
+  ASSERT_EQ(capture.writes.size(), 5);
+  EXPECT_EQ(capture.writes[4], "a:4");
+}
+
+TEST(Wangle, StreamingServerDispatcherAsyncPull) {
+  StreamCapture capture;
+  ManualStreamingService service;
+  auto pipeline = StreamPipeline::create();
+  pipeline->addBack(&capture);
+  pipeline->addBack(
+      StreamingServerDispatcher<std::string, std::string>(&service));
+  pipeline->finalize();
+
+  // Exactly one pull is outstanding at a time.
+  pipeline->read("a");
+  ASSERT_EQ(service.pulls.size(), 1);
+  EXPECT_EQ(capture.writes.size(), 0);
+
+  service.pulls[0].setValue(folly::make_optional<std::string>("x"));
+  ASSERT_EQ(capture.writes.size(), 1);
+  EXPECT_EQ(capture.writes[0], "x");
+  ASSERT_EQ(service.pulls.size(), 2);
+
+  // A failed pull surfaces as a write exception and ends the stream.
+  service.pulls[1].setException(std::runtime_error("boom"));
+  EXPECT_EQ(capture.errors, 1);
+  EXPECT_EQ(service.pulls.size(), 2);
+
+  // The dispatcher is idle again and takes the next request.
+  pipeline->read("b");
+  ASSERT_EQ(service.pulls.size(), 3);
+  service.pulls[2].setValue(folly::none);
+  EXPECT_EQ(capture.writes.size(), 1);
+  EXPECT_EQ(capture.errors, 1);
+}
+
+#if FOLLY_HAS_COROUTINES
+
+class EchoCoroService : public CoroService<std::string, std::string> {
+ public:
+  folly::coro::Task<std::string> co_invoke(std::string req) override {
+    co_return req;
+  }
+};
+
+class CoroAppendFilter : public CoroServiceFilter<std::string, std::string> {
+ public:
+  explicit CoroAppendFilter(
+      std::shared_ptr<CoroService<std::string, std::string>> service)
+      : CoroServiceFilter<std::string, std::string>(service) {}
+
+  folly::coro::Task<std::string> co_invoke(std::string req) override {
+    co_return co_await (*service_).co_invoke(req + "\n");
+  }
+};
+
+TEST(Wangle, CoroFilterTest) {
+  auto service = std::make_shared<EchoCoroService>();
+  auto filter = std::make_shared<CoroAppendFilter>(service);
+  auto result = folly::coro::blockingWait(filter->co_invoke("test"));
+  EXPECT_EQ("test\n", result);
+}
+
+TEST(Wangle, FutureServiceAsCoro) {
+  // A coro filter on top of a not-yet-migrated Future service.
+  auto service = std::make_shared<EchoService>();
+  auto coroService =
+      std::make_shared<ServiceToCoroService<std::string, std::string>>(service);
+  auto filter = std::make_shared<CoroAppendFilter>(coroService);
+  auto result = folly::coro::blockingWait(filter->co_invoke("test"));
+  EXPECT_EQ("test\n", result);
+}
+
+TEST(Wangle, CoroServiceAsFuture) {
+  // A coro service at the bottom of a still-Future chain.
+  auto coroService = std::make_shared<EchoCoroService>();
+  folly::ManualExecutor executor;
+  auto service =
+      std::make_shared<CoroServiceToService<std::string, std::string>>(
+          coroService, &executor);
+  auto filter = std::make_shared<AppendFilter>(service);
+
+  auto f = (*filter)("test");
+  executor.drain();
+  EXPECT_EQ("test\n", std::move(f).value());
+}
+
+#endif // FOLLY_HAS_COROUTINES
+
+class CountingEchoService : public Service<std::string, std::string> {
+ public:
+  Future<std::string> operator()(std::string req) override {
+    calls++;
+    return req;
+  }
+
+  uint32_t calls{0};
+};
+
+class ManualResponseService : public Service<std::string, std::string> {
+ public:
+  Future<std::string> operator()(std::string /* req */) override {
+    calls++;
+    promises.emplace_back();
+    return promises.back().getFuture();
+  }
+
+  uint32_t calls{0};
+  std::deque<Promise<std::string>> promises;
+};
+
+TEST(ServiceFilter, CachingFilterHitsAndTtl) {
+  auto backend = std::make_shared<CountingEchoService>();
+  auto cached = std::make_shared<CachingFilter<std::string>>(
+      backend,
+      10,
+      [](const std::string& req) { return req; },
+      [](const std::string&, const std::string& resp) {
+        // Don't cache empty responses.
+        return resp.empty() ? std::chrono::milliseconds(0)
+                            : std::chrono::milliseconds(60000);
+      });
+
+  EXPECT_EQ("a", (*cached)("a").get());
+  EXPECT_EQ("a", (*cached)("a").get());
+  EXPECT_EQ(1, backend->calls);
+  EXPECT_EQ("b", (*cached)("b").get());
+  EXPECT_EQ(2, backend->calls);
+
+  // Responses the TTL policy declines are served fresh every time.
+  EXPECT_EQ("", (*cached)("").get());
+  EXPECT_EQ("", (*cached)("").get());
+  EXPECT_EQ(4, backend->calls);
+
+  auto stats = cached->getCacheStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(4, stats.misses);
+}
+
+TEST(ServiceFilter, CachingFilterCollapsesInflight) {
+  auto backend = std::make_shared<ManualResponseService>();
+  auto cached = std::make_shared<CachingFilter<std::string>>(
+      backend,
+      10,
+      [](const std::string& req) { return req; },
+      [](const std::string&, const std::string&) {
+        return std::chrono::milliseconds(60000);
+      });
+
+  // Concurrent identical requests trigger a single upstream call.
+  auto f1 = (*cached)("key");
+  auto f2 = (*cached)("key");
+  auto f3 = (*cached)("key");
+  EXPECT_EQ(1, backend->calls);
+
+  backend->promises.front().setValue("value");
+  EXPECT_EQ("value", std::move(f1).get());
+  EXPECT_EQ("value", std::move(f2).get());
+  EXPECT_EQ("value", std::move(f3).get());
+
+  auto stats = cached->getCacheStats();
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(2, stats.collapsed);
+
+  // Errors are not cached: the next request retries upstream.
+  auto f4 = (*cached)("err");
+  backend->promises.back().setException(
+      folly::make_exception_wrapper<std::runtime_error>("boom"));
+  EXPECT_THROW(std::move(f4).get(), std::runtime_error);
+  auto f5 = (*cached)("err");
+  EXPECT_EQ(3, backend->calls);
+  backend->promises.back().setValue("ok");
+  EXPECT_EQ("ok", std::move(f5).get());
+}
+
+TEST(MessagePool, RecyclesClearedObjects) {
+  MessagePool<std::string> pool;
+
+  auto msg = pool.acquire();
+  *msg = "payload";
+  msg.reset();
+  EXPECT_EQ(1, pool.pooledObjects());
+  EXPECT_EQ(1, pool.getPoolStats().allocations);
+  EXPECT_EQ(1, pool.getPoolStats().recycled);
+
+  // The recycled object comes back cleared, by a freelist pop.
+  auto again = pool.acquire();
+  EXPECT_TRUE(again->empty());
+  EXPECT_EQ(0, pool.pooledObjects());
+  EXPECT_EQ(1, pool.getPoolStats().poolHits);
+}
+
+TEST(MessagePool, RecyclesAcrossExceptionUnwind) {
+  MessagePool<std::string> pool;
+  try {
+    auto msg = pool.acquire();
+    *msg = "in flight";
+    throw std::runtime_error("handler failed");
+  } catch (const std::runtime_error&) {
+  }
+  // The unwind returned the object instead of leaking or freeing it.
+  EXPECT_EQ(1, pool.pooledObjects());
+  EXPECT_EQ(1, pool.getPoolStats().recycled);
+}
+
+TEST(MessagePool, BoundsFreelist) {
+  MessagePool<std::string> pool(1 /* maxPooled */);
+  auto a = pool.acquire();
+  auto b = pool.acquire();
+  a.reset();
+  b.reset();
+  EXPECT_EQ(1, pool.pooledObjects());
+  EXPECT_EQ(1, pool.getPoolStats().recycled);
+  EXPECT_EQ(1, pool.getPoolStats().discarded);
+}
+
 } // namespace wangle
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/CertFileRegistry.h>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+#include <sys/stat.h>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Singleton.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/synchronization/Baton.h>
+
+namespace wangle {
+
+namespace {
+
+folly::Singleton<CertFileRegistry> registrySingleton;
+
+} // namespace
+
+std::shared_ptr<CertFileRegistry> CertFileRegistry::getInstance() {
+  return registrySingleton.try_get();
+}
+
+std::shared_ptr<const std::string> CertFileRegistry::getFileContents(
+    const std::string& path) {
+  struct stat st;
+  bool haveStat = stat(path.c_str(), &st) == 0;
+  if (haveStat) {
+    std::shared_lock<folly::SharedMutex> g(mutex_);
+    auto it = byPath_.find(path);
+    if (it != byPath_.end() && it->second.mtime == st.st_mtime &&
+        it->second.fileSize == st.st_size) {
+      return it->second.contents;
+    }
+  }
+
+  std::string data;
+  if (!folly::readFile(path.c_str(), data)) {
+    throw std::runtime_error(
+        folly::to<std::string>("error reading certificate file ", path));
+  }
+  auto hash = folly::hash::SpookyHashV2::Hash64(data.data(), data.size(), 0);
+
+  std::unique_lock<folly::SharedMutex> g(mutex_);
+  std::shared_ptr<const std::string> contents;
+  auto hashIt = byHash_.find(hash);
+  if (hashIt != byHash_.end()) {
+    auto existing = hashIt->second.lock();
+    // Compare bytes: a 64-bit hash is a dedup key, not an identity proof.
+    if (existing && *existing == data) {
+      contents = std::move(existing);
+    }
+  }
+  if (!contents) {
+    contents = std::make_shared<const std::string>(std::move(data));
+    byHash_[hash] = contents;
+  }
+  auto& entry = byPath_[path];
+  entry.contents = contents;
+  entry.contentHash = hash;
+  entry.mtime = haveStat ? st.st_mtime : 0;
+  entry.fileSize = haveStat ? st.st_size : 0;
+  return contents;
+}
+
+void CertFileRegistry::prefetch(
+    const std::vector<std::string>& paths,
+    folly::Executor* executor) {
+  if (paths.empty()) {
+    return;
+  }
+  if (!executor) {
+    for (const auto& path : paths) {
+      try {
+        getFileContents(path);
+      } catch (const std::runtime_error&) {
+        // Reported by the load that follows.
+      }
+    }
+    return;
+  }
+  auto remaining = std::make_shared<std::atomic<size_t>>(paths.size());
+  auto done = std::make_shared<folly::Baton<>>();
+  for (const auto& path : paths) {
+    executor->add([this, path, remaining, done] {
+      try {
+        getFileContents(path);
+      } catch (const std::runtime_error&) {
+        // Reported by the load that follows.
+      }
+      if (remaining->fetch_sub(1) == 1) {
+        done->post();
+      }
+    });
+  }
+  done->wait();
+}
+
+size_t CertFileRegistry::size() const {
+  std::shared_lock<folly::SharedMutex> g(mutex_);
+  return byPath_.size();
+}
+
+} // namespace wangle
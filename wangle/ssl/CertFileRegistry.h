@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/SharedMutex.h>
+
+namespace wangle {
+
+/**
+ * A process-wide, content-deduplicated cache of PEM credential files.
+ *
+ * A process that runs many listeners builds one SSLContextManager per
+ * SharedSSLContextManager, each of which historically read and parsed
+ * the same certificate and key files from disk. The registry reads
+ * every distinct file at most once per content change and hands out
+ * shared buffers, so N managers loading the same cert set cost one
+ * pass over the files, and identical files living at different paths
+ * share a single buffer.
+ *
+ * Freshness is stat-based (mtime and size) — the same signal FilePoller
+ * and TLSCredProcessor use to trigger cert reloads in the first place.
+ * By the time a reload runs, the changed file's mtime has moved, so
+ * getFileContents re-reads exactly the changed files and reload cost
+ * scales with the number of changed certs rather than the total.
+ */
+class CertFileRegistry {
+ public:
+  /**
+   * The process-wide instance shared by all SharedSSLContextManagers.
+   * May return nullptr during shutdown.
+   */
+  static std::shared_ptr<CertFileRegistry> getInstance();
+
+  /**
+   * Returns the contents of the PEM file at path, reading the file only
+   * if it is not cached or has changed on disk since it was. Throws
+   * std::runtime_error if the file cannot be read.
+   */
+  std::shared_ptr<const std::string> getFileContents(const std::string& path);
+
+  /**
+   * Warms the cache for a batch of paths. With an executor, the reads
+   * and hashing fan out across its threads and prefetch returns once all
+   * of them have completed; without one they run inline. Unreadable
+   * files are skipped here so the load that follows can report them
+   * with its usual per-certificate error.
+   */
+  void prefetch(
+      const std::vector<std::string>& paths,
+      folly::Executor* executor);
+
+  /**
+   * Number of distinct paths cached.
+   */
+  size_t size() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const std::string> contents;
+    uint64_t contentHash{0};
+    int64_t mtime{0};
+    int64_t fileSize{0};
+  };
+
+  mutable folly::SharedMutex mutex_;
+  std::unordered_map<std::string, Entry> byPath_;
+
+  /**
+   * Shares one buffer among identical files at different paths. Weak so
+   * certs dropped from every config don't stay pinned by the registry.
+   */
+  std::unordered_map<uint64_t, std::weak_ptr<const std::string>> byHash_;
+};
+
+} // namespace wangle
@@ -18,6 +18,12 @@
 
 #include <wangle/acceptor/SSLContextSelectionMisc.h>
 
+namespace folly {
+namespace ssl {
+struct ClientHelloInfo;
+} // namespace ssl
+} // namespace folly
+
 namespace wangle {
 
 class ClientHelloExtStats {
@@ -31,6 +37,12 @@ class ClientHelloExtStats {
   virtual void recordCertCrypto(
       CertCrypto requested,
       CertCrypto served) noexcept = 0;
+
+  // Full parsed hello, invoked from the servername callback when hello
+  // parsing is enabled on the socket. Default is a no-op so existing
+  // implementations are unaffected.
+  virtual void recordClientHello(
+      const folly::ssl::ClientHelloInfo& /* info */) noexcept {}
 };
 
 } // namespace wangle
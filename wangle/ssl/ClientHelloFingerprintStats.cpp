@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/ClientHelloFingerprintStats.h>
+
+#include <algorithm>
+
+#include <folly/container/F14Map.h>
+#include <folly/hash/Hash.h>
+
+namespace wangle {
+
+void ClientHelloFingerprintStats::recordAbsentHostname() noexcept {
+  ++counters_->absentHostname;
+}
+
+void ClientHelloFingerprintStats::recordMatch() noexcept {
+  ++counters_->matches;
+}
+
+void ClientHelloFingerprintStats::recordNotMatch() noexcept {
+  ++counters_->notMatches;
+}
+
+void ClientHelloFingerprintStats::recordCertCrypto(
+    CertCrypto /* requested */,
+    CertCrypto served) noexcept {
+  if (served != CertCrypto::BEST_AVAILABLE) {
+    ++counters_->weakCertCrypto;
+  }
+}
+
+void ClientHelloFingerprintStats::recordClientHello(
+    const folly::ssl::ClientHelloInfo& info) noexcept {
+  auto& counters = *counters_;
+  ++counters.hellos;
+  for (auto extension : info.clientHelloExtensions_) {
+    auto idx =
+        std::min<size_t>(static_cast<size_t>(extension), kExtensionSlots - 1);
+    ++counters.extensionCounts[idx];
+  }
+  auto bucket = std::min(
+      info.clientHelloCiphers_.size() / kCiphersPerBucket,
+      kCipherCountBuckets - 1);
+  ++counters.cipherCountBuckets[bucket];
+  recordFingerprint(counters, computeFingerprint(info));
+}
+
+uint64_t ClientHelloFingerprintStats::computeFingerprint(
+    const folly::ssl::ClientHelloInfo& info) noexcept {
+  // Same spirit as JA3: the tuple of version, cipher list, extension
+  // list and signature algorithms in their wire order identifies a
+  // client implementation. The hash folds the fields in directly, so
+  // nothing is stringified or materialized.
+  uint64_t hash = folly::hash::hash_combine(
+      info.clientHelloMajorVersion_, info.clientHelloMinorVersion_);
+  for (auto cipher : info.clientHelloCiphers_) {
+    hash = folly::hash::hash_combine(hash, cipher);
+  }
+  for (auto extension : info.clientHelloExtensions_) {
+    hash = folly::hash::hash_combine(hash, static_cast<uint16_t>(extension));
+  }
+  for (const auto& sigAlg : info.clientHelloSigAlgs_) {
+    hash = folly::hash::hash_combine(
+        hash,
+        static_cast<uint8_t>(sigAlg.first),
+        static_cast<uint8_t>(sigAlg.second));
+  }
+  return hash;
+}
+
+void ClientHelloFingerprintStats::recordFingerprint(
+    Counters& counters,
+    uint64_t hash) noexcept {
+  for (size_t probe = 0; probe < kFingerprintMaxProbes; ++probe) {
+    auto idx = (hash + probe) % kFingerprintSlots;
+    if (counters.fingerprintCounts[idx] == 0) {
+      counters.fingerprintKeys[idx] = hash;
+      counters.fingerprintCounts[idx] = 1;
+      return;
+    }
+    if (counters.fingerprintKeys[idx] == hash) {
+      ++counters.fingerprintCounts[idx];
+      return;
+    }
+  }
+  ++counters.fingerprintOverflows;
+}
+
+ClientHelloFingerprintStats::Aggregate
+ClientHelloFingerprintStats::aggregate() {
+  Aggregate agg;
+  folly::F14FastMap<uint64_t, uint64_t> fingerprints;
+  for (const auto& counters : counters_.accessAllThreads()) {
+    agg.hellos += counters.hellos;
+    agg.absentHostname += counters.absentHostname;
+    agg.matches += counters.matches;
+    agg.notMatches += counters.notMatches;
+    agg.weakCertCrypto += counters.weakCertCrypto;
+    for (size_t i = 0; i < kExtensionSlots; ++i) {
+      agg.extensionCounts[i] += counters.extensionCounts[i];
+    }
+    for (size_t i = 0; i < kCipherCountBuckets; ++i) {
+      agg.cipherCountBuckets[i] += counters.cipherCountBuckets[i];
+    }
+    for (size_t i = 0; i < kFingerprintSlots; ++i) {
+      if (counters.fingerprintCounts[i] != 0) {
+        fingerprints[counters.fingerprintKeys[i]] +=
+            counters.fingerprintCounts[i];
+      }
+    }
+    agg.fingerprintOverflows += counters.fingerprintOverflows;
+  }
+  agg.fingerprints.assign(fingerprints.begin(), fingerprints.end());
+  return agg;
+}
+
+} // namespace wangle
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <folly/ThreadLocal.h>
+#include <folly/io/async/ssl/TLSDefinitions.h>
+#include <wangle/ssl/ClientHelloExtStats.h>
+
+namespace wangle {
+
+/**
+ * A concrete ClientHelloExtStats that records every hello into
+ * fixed-size per-thread counters, so the handshake path never
+ * allocates and never contends on a shared lock. Each hello bumps a
+ * per-extension counter, a cipher-list-length histogram bucket and a
+ * slot in a small open-addressed fingerprint table; aggregate() merges
+ * the per-thread counters on demand.
+ *
+ * The fingerprint is a JA3-style hash of the parsed hello (version,
+ * cipher list, extension list and signature algorithms in wire order),
+ * computed incrementally over the fields folly already parsed. Clients
+ * of the same implementation hash identically, which is what makes the
+ * table useful for bot/client-mix telemetry.
+ */
+class ClientHelloFingerprintStats : public ClientHelloExtStats {
+ public:
+  // extension ids at or above the last slot fold into it
+  static constexpr size_t kExtensionSlots = 64;
+  // cipher list length histogram granularity
+  static constexpr size_t kCiphersPerBucket = 8;
+  static constexpr size_t kCipherCountBuckets = 16;
+  // per-thread fingerprint table; small and fixed so recording a hello
+  // never allocates
+  static constexpr size_t kFingerprintSlots = 256;
+  static constexpr size_t kFingerprintMaxProbes = 4;
+
+  struct Aggregate {
+    uint64_t hellos{0};
+    uint64_t absentHostname{0};
+    uint64_t matches{0};
+    uint64_t notMatches{0};
+    // hellos served a cert weaker than BEST_AVAILABLE
+    uint64_t weakCertCrypto{0};
+    std::array<uint64_t, kExtensionSlots> extensionCounts{};
+    std::array<uint64_t, kCipherCountBuckets> cipherCountBuckets{};
+    // fingerprint hash -> hello count, merged across threads
+    std::vector<std::pair<uint64_t, uint64_t>> fingerprints;
+    // hellos whose fingerprint found no free slot within the probe
+    // limit
+    uint64_t fingerprintOverflows{0};
+  };
+
+  void recordAbsentHostname() noexcept override;
+  void recordMatch() noexcept override;
+  void recordNotMatch() noexcept override;
+  void recordCertCrypto(CertCrypto requested, CertCrypto served) noexcept
+      override;
+  void recordClientHello(const folly::ssl::ClientHelloInfo& info) noexcept
+      override;
+
+  /**
+   * The JA3-style hash described above. Exposed so callers can label
+   * individual connections with the same value aggregate() buckets by.
+   */
+  static uint64_t computeFingerprint(
+      const folly::ssl::ClientHelloInfo& info) noexcept;
+
+  /**
+   * Sum the per-thread counters. Threads keep recording while this
+   * runs, so the result is a close approximation rather than an atomic
+   * snapshot, which is fine for periodic export.
+   */
+  Aggregate aggregate();
+
+ private:
+  struct Counters {
+    uint64_t hellos{0};
+    uint64_t absentHostname{0};
+    uint64_t matches{0};
+    uint64_t notMatches{0};
+    uint64_t weakCertCrypto{0};
+    std::array<uint64_t, kExtensionSlots> extensionCounts{};
+    std::array<uint64_t, kCipherCountBuckets> cipherCountBuckets{};
+    // a slot is empty iff its count is zero
+    std::array<uint64_t, kFingerprintSlots> fingerprintKeys{};
+    std::array<uint64_t, kFingerprintSlots> fingerprintCounts{};
+    uint64_t fingerprintOverflows{0};
+  };
+
+  static void recordFingerprint(Counters& counters, uint64_t hash) noexcept;
+
+  class CountersTag;
+  folly::ThreadLocal<Counters, CountersTag> counters_;
+};
+
+} // namespace wangle
@@ -18,6 +18,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <string>
 
 namespace wangle {
 
@@ -26,6 +27,14 @@ struct SSLCacheOptions {
   uint64_t maxSSLCacheSize;
   uint64_t sslCacheFlushSize;
   std::chrono::seconds handshakeValidity;
+
+  /**
+   * File the local session cache is snapshotted to on shutdown and
+   * warm-loaded from at the next Acceptor::init, so a restart resumes
+   * sessions instead of running minutes of full handshakes while the
+   * cache refills.  Empty (the default) disables persistence.
+   */
+  std::string sessionPersistencePath;
 };
 
 } // namespace wangle
@@ -67,6 +67,25 @@ class SSLCacheProvider {
   virtual folly::Future<folly::ssl::SSLSessionUniquePtr> getFuture(
       const std::string& sessionId) = 0;
 
+  /**
+   * Retrieve several sessions from the external cache in one request.
+   * SSLSessionCacheManager batches the lookups issued within one event
+   * loop iteration and fetches them through this entry point, so
+   * providers backed by stores with multi-get support should override
+   * it; the default falls back to one getFuture() per ID.
+   * @param sessionIds  Session IDs to fetch
+   * @return One future per session ID, in the same order.
+   */
+  virtual std::vector<folly::Future<folly::ssl::SSLSessionUniquePtr>>
+  getFutures(const std::vector<std::string>& sessionIds) {
+    std::vector<folly::Future<folly::ssl::SSLSessionUniquePtr>> futures;
+    futures.reserve(sessionIds.size());
+    for (const auto& sessionId : sessionIds) {
+      futures.push_back(getFuture(sessionId));
+    }
+    return futures;
+  }
+
   virtual void setSecrets(
       const std::vector<std::string>& /*oldSecrets*/,
       const std::vector<std::string>& /*currentSecrets*/,
@@ -19,6 +19,7 @@
 #include <folly/Optional.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/SSLOptions.h>
+#include <chrono>
 #include <set>
 #include <string>
 #include <vector>
@@ -56,6 +57,12 @@ struct SSLContextConfig {
     bool isBuffer{false};
   };
 
+  // TLS certificate compression algorithms (RFC 8879).
+  enum class CertCompressionAlgorithm {
+    ZLIB,
+    ZSTD,
+  };
+
   static const std::string& getDefaultCiphers() {
     static const std::string& defaultCiphers =
         folly::join(':', folly::ssl::SSLServerOptions::ciphers());
@@ -143,6 +150,13 @@ struct SSLContextConfig {
   // Key offload configuration
   KeyOffloadParams keyOffloadParams;
 
+  // Run RSA/ECDSA private key operations for this context as OpenSSL
+  // async jobs (SSL_MODE_ASYNC), letting an async-capable engine such as
+  // Intel QAT suspend the handshake for the hardware round trip instead
+  // of blocking the IO thread. Requires an async engine to be loaded;
+  // without one OpenSSL completes the jobs synchronously.
+  bool asyncCryptoEnabled{false};
+
   // If true, read cert-key files locally. Otherwise, fetch them from cryptossl
   bool offloadDisabled{true};
 
@@ -155,6 +169,28 @@ struct SSLContextConfig {
   folly::Optional<std::string> sessionContext;
 
   bool alpnAllowMismatch{true};
+
+  // Certificate compression algorithms to offer, in preference order.
+  // Each configured chain is compressed once at load time and the cached
+  // compressed form is served per handshake, so enabling this costs
+  // nothing on the handshake path. Only honored by Fizz (TLS 1.3)
+  // contexts.
+  std::vector<CertCompressionAlgorithm> certCompressionAlgorithms;
+
+  // DER-encoded OCSP response to staple on handshakes that request
+  // certificate status. Loaded when the context is configured and
+  // re-read in the background ahead of expiry (see
+  // ServerSSLContext::setupOcspStapling); an external fetcher keeps the
+  // file current, the same delivery model as ticket seeds and certs.
+  // Empty disables stapling.
+  std::string ocspResponseFile;
+
+  // How often the staple file is re-read, and the +/- jitter applied
+  // to each period so a fleet does not reload in lockstep. Keep the
+  // interval comfortably below the responder's update period so a
+  // fresh staple is picked up well before the served one goes stale.
+  std::chrono::seconds ocspRefreshInterval{std::chrono::hours(1)};
+  std::chrono::seconds ocspRefreshJitter{std::chrono::minutes(5)};
 };
 
 } // namespace wangle
@@ -27,8 +27,10 @@
 #include <folly/Conv.h>
 #include <folly/ScopeGuard.h>
 #include <folly/String.h>
+#include <folly/container/F14Map.h>
 #include <folly/portability/OpenSSL.h>
 #include <folly/ssl/OpenSSLCertUtils.h>
+#include <array>
 #include <functional>
 
 #include <folly/io/async/EventBase.h>
@@ -44,6 +46,40 @@ using std::shared_ptr;
 using std::string;
 // Get OpenSSL portability APIs
 
+namespace {
+
+/**
+ * A lowercased view of a servername, canonicalized on the stack for
+ * DNS-length names so servername resolution stays allocation free.
+ */
+class CanonicalizedDn {
+ public:
+  explicit CanonicalizedDn(folly::StringPiece dn) {
+    char* out;
+    if (dn.size() <= sizeof(inline_)) {
+      out = inline_;
+    } else {
+      overflow_.resize(dn.size());
+      out = &overflow_[0];
+    }
+    memcpy(out, dn.data(), dn.size());
+    folly::toLowerAscii(out, dn.size());
+    name_ = folly::StringPiece(out, dn.size());
+  }
+
+  folly::StringPiece operator*() const {
+    return name_;
+  }
+
+ private:
+  // Maximum length of a DNS name.
+  char inline_[255];
+  std::string overflow_;
+  folly::StringPiece name_;
+};
+
+} // namespace
+
 /**
  * SSLContextManager helps to create and manage all SSL_CTX,
  * SSLSessionCacheManager and TLSTicketManager for a listening
@@ -266,6 +302,17 @@ class SSLContextManager::SslContexts
   std::shared_ptr<folly::SSLContext> getSSLCtxByExactDomain(
       const SSLContextKey& key) const;
 
+  /**
+   * Allocation-free variants used on the handshake path: the caller
+   * canonicalizes (lowercases) the servername once, and each lookup is a
+   * single hash probe into the canonicalized index.
+   */
+  std::shared_ptr<folly::SSLContext> getSSLCtx(
+      folly::StringPiece canonicalDn,
+      CertCrypto certCrypto) const;
+  bool isDefaultCtx(folly::StringPiece canonicalDn, CertCrypto certCrypto)
+      const;
+
   void insertSSLCtxByDomainName(
       const std::string& dn,
       std::shared_ptr<folly::SSLContext> sslCtx,
@@ -353,13 +400,40 @@ class SSLContextManager::SslContexts
   bool strict_{true};
 
   /**
-   * Container to store the (DomainName -> SSL_CTX) mapping
+   * Keeps the canonicalized index below in sync with dnMap_; called at the
+   * few places dnMap_ is mutated.
+   */
+  void indexInsert(
+      const SSLContextKey& key,
+      std::shared_ptr<folly::SSLContext> sslCtx);
+  void indexErase(const SSLContextKey& key);
+  std::shared_ptr<folly::SSLContext> indexFind(
+      folly::StringPiece canonicalDn,
+      CertCrypto certCrypto) const;
+
+  /**
+   * Container to store the (DomainName -> SSL_CTX) mapping.  This is the
+   * source of truth, only touched at config time.
    */
   std::unordered_map<
       SSLContextKey,
       std::shared_ptr<folly::SSLContext>,
       SSLContextKeyHash>
       dnMap_;
+
+  /**
+   * A mirror of dnMap_ keyed on lowercased names, one map per CertCrypto
+   * level, used for servername resolution.  Probing it requires no
+   * locking, no allocation (SSLContextKeyHash lowercases into a fresh
+   * string on every hash) and no case-insensitive compares.  Wildcard
+   * entries are stored under their ".suffix" key, as in dnMap_.  The index
+   * is immutable once the enclosing SslContexts is published;
+   * resetSSLContextConfigs builds a fresh SslContexts and swaps it in.
+   */
+  using DnIndex =
+      folly::F14FastMap<std::string, std::shared_ptr<folly::SSLContext>>;
+  static constexpr size_t kCertCryptoCount = 2;
+  std::array<DnIndex, kCertCryptoCount> dnIndex_;
 };
 
 SSLContextManager::~SSLContextManager() = default;
@@ -384,12 +458,16 @@ void SSLContextManager::SslContexts::swap(SslContexts& other) noexcept {
   ctxs_.swap(other.ctxs_);
   defaultCtxKeys_.swap(other.defaultCtxKeys_);
   dnMap_.swap(other.dnMap_);
+  dnIndex_.swap(other.dnIndex_);
 }
 
 void SSLContextManager::SslContexts::clear() {
   ctxs_.clear();
   defaultCtxKeys_.clear();
   dnMap_.clear();
+  for (auto& index : dnIndex_) {
+    index.clear();
+  }
 }
 
 TLSTicketKeySeeds SSLContextManager::SslContexts::getTicketKeys() const {
@@ -473,6 +551,7 @@ void SSLContextManager::SslContexts::removeSSLContextConfig(
     CHECK(vIt != ctxs_.end());
     ctxs_.erase(vIt);
     dnMap_.erase(mapIt);
+    indexErase(key);
   }
 }
 
@@ -637,6 +716,7 @@ void SSLContextManager::SslContexts::addSSLContextConfig(
   sslCtx->setupSessionCache(
       ctxConfig, cacheOptions, externalCache, sessionIdContext, mgr->stats_);
   configureTicketResumption(sslCtx, ticketSeeds, ctxConfig, mgr->stats_);
+  sslCtx->setupOcspStapling(ctxConfig, mgr->stats_);
 
   VLOG(3) << "On VipID=" << vipAddress.describe() << " context=" << sslCtx;
 
@@ -688,6 +768,14 @@ void SSLContextManager::loadCertsFromFiles(
     const std::shared_ptr<folly::SSLContext>& sslCtx,
     const SSLContextConfig::CertificateInfo& cert) const {
   try {
+    if (certFileRegistry_ && cert.passwordPath.empty()) {
+      // Unencrypted cert/key pairs can be served out of the shared
+      // registry, so concurrent managers read each file once.
+      auto certPem = certFileRegistry_->getFileContents(cert.certPath);
+      auto keyPem = certFileRegistry_->getFileContents(cert.keyPath);
+      sslCtx->loadCertKeyPairFromBufferPEM(*certPem, *keyPem);
+      return;
+    }
     // The private key lives in the same process
     // This needs to be called before loadPrivateKey().
     if (!cert.passwordPath.empty()) {
@@ -805,6 +893,9 @@ SSLContextManager::SslContexts::serverNameCallback(
   // TODO: use SSL_get_sigalgs (requires openssl 1.0.2).
   auto clientInfo = sslSocket->getClientHelloInfo();
   if (clientInfo) {
+    if (stats) {
+      stats->recordClientHello(*clientInfo);
+    }
     certCryptoReq = CertCrypto::SHA1_SIGNATURE;
     for (const auto& sigAlgPair : clientInfo->clientHelloSigAlgs_) {
       if (sigAlgPair.first == folly::ssl::HashAlgorithm::SHA256) {
@@ -823,16 +914,17 @@ SSLContextManager::SslContexts::serverNameCallback(
     }
   }
 
-  DNString dnstr(sn, snLen);
+  // Canonicalize (lowercase) the servername once; each lookup below is then
+  // a single hash probe into the canonicalized index with no allocation.
+  CanonicalizedDn dn(folly::StringPiece(sn, snLen));
   // First look for a context with the exact crypto needed. Weaker crypto will
   // be in the map as best available if it is the best we have for that
   // subject name.
-  SSLContextKey key(dnstr, certCryptoReq);
-  ctx = contexts->getSSLCtx(key);
+  ctx = contexts->getSSLCtx(*dn, certCryptoReq);
   if (ctx) {
     sslSocket->switchServerSSLContext(ctx);
   }
-  if (ctx || contexts->isDefaultCtx(key)) {
+  if (ctx || contexts->isDefaultCtx(*dn, certCryptoReq)) {
     if (stats) {
       if (reqHasServerName) {
         stats->recordMatch();
@@ -844,12 +936,11 @@ SSLContextManager::SslContexts::serverNameCallback(
 
   // If we didn't find an exact match, look for a cert with upgraded crypto.
   if (certCryptoReq != CertCrypto::BEST_AVAILABLE) {
-    SSLContextKey fallbackKey(dnstr, CertCrypto::BEST_AVAILABLE);
-    ctx = contexts->getSSLCtx(fallbackKey);
+    ctx = contexts->getSSLCtx(*dn, CertCrypto::BEST_AVAILABLE);
     if (ctx) {
       sslSocket->switchServerSSLContext(ctx);
     }
-    if (ctx || contexts->isDefaultCtx(fallbackKey)) {
+    if (ctx || contexts->isDefaultCtx(*dn, CertCrypto::BEST_AVAILABLE)) {
       if (stats) {
         if (reqHasServerName) {
           stats->recordMatch();
@@ -893,6 +984,17 @@ void SSLContextManager::SslContexts::ctxSetupByOpensslFeature(
   SSL_CTX_set_mode(sslCtx->getSSLCtx(), SSL_MODE_EARLY_RELEASE_BBIO);
 #endif
 
+  // Run private key operations as async jobs, so an async-capable engine
+  // can park the handshake during the hardware round trip; the transport
+  // resumes it when the engine signals completion.
+  if (ctxConfig.asyncCryptoEnabled) {
+#ifdef SSL_MODE_ASYNC
+    SSL_CTX_set_mode(sslCtx->getSSLCtx(), SSL_MODE_ASYNC);
+#else
+    OPENSSL_MISSING_FEATURE(AsyncCrypto);
+#endif
+  }
+
   // This number should (probably) correspond to HTTPSession::kMaxReadSize
   // For now, this number must also be large enough to accommodate our
   // largest certificate, because some older clients (IE6/7) require the
@@ -1112,6 +1214,7 @@ void SSLContextManager::SslContexts::insertIntoDnMap(
   if (v1 == dnMap_.end() && v2 == defaultCtxKeys_.end()) {
     VLOG(6) << "Inserting SSLContext into map.";
     dnMap_.emplace(key, sslCtx);
+    indexInsert(key, sslCtx);
   } else if (v1 != dnMap_.end()) {
     DCHECK(v2 == defaultCtxKeys_.end());
     if (v1->second == sslCtx) {
@@ -1121,6 +1224,7 @@ void SSLContextManager::SslContexts::insertIntoDnMap(
     } else if (overwrite) {
       VLOG(6) << "Overwriting SSLContext.";
       v1->second = sslCtx;
+      indexInsert(key, sslCtx);
     } else {
       VLOG(6) << "Leaving existing SSLContext in map.";
     }
@@ -1130,6 +1234,7 @@ void SSLContextManager::SslContexts::insertIntoDnMap(
       VLOG(6) << "Overwriting SSLContext, removing from defaults.";
       defaultCtxKeys_.erase(v2);
       dnMap_.emplace(key, sslCtx);
+      indexInsert(key, sslCtx);
     } else {
       VLOG(6) << "Leaving existing SSLContextKey in vector.";
     }
@@ -1150,6 +1255,7 @@ void SSLContextManager::SslContexts::insertIntoDefaultKeys(
     if (overwrite) {
       VLOG(6) << "SSLContextKey reassigned to default";
       dnMap_.erase(v1);
+      indexErase(key);
       defaultCtxKeys_.emplace_back(key);
     } else {
       VLOG(6) << "Leaving existing SSLContext in map.";
@@ -1207,14 +1313,15 @@ shared_ptr<SSLContext> SSLContextManager::SslContexts::getSSLCtxBySuffix(
   size_t dot;
 
   if ((dot = key.dnString.find_first_of(".")) != DNString::npos) {
-    SSLContextKey suffixKey(DNString(key.dnString, dot), key.certCrypto);
-    const auto v = dnMap_.find(suffixKey);
-    if (v != dnMap_.end()) {
+    CanonicalizedDn suffix(folly::StringPiece(
+        key.dnString.data() + dot, key.dnString.size() - dot));
+    auto ctx = indexFind(*suffix, key.certCrypto);
+    if (ctx) {
       VLOG(6) << folly::stringPrintf(
           "\"%s\" is a willcard match to \"%s\"",
           key.dnString.c_str(),
-          suffixKey.dnString.c_str());
-      return v->second;
+          (*suffix).str().c_str());
+      return ctx;
     }
   }
 
@@ -1225,18 +1332,79 @@ shared_ptr<SSLContext> SSLContextManager::SslContexts::getSSLCtxBySuffix(
 
 shared_ptr<SSLContext> SSLContextManager::SslContexts::getSSLCtxByExactDomain(
     const SSLContextKey& key) const {
-  const auto v = dnMap_.find(key);
-  if (v == dnMap_.end()) {
+  CanonicalizedDn dn(
+      folly::StringPiece(key.dnString.data(), key.dnString.size()));
+  auto ctx = indexFind(*dn, key.certCrypto);
+  if (!ctx) {
     VLOG(6) << folly::stringPrintf(
         "\"%s\" is not an exact match", key.dnString.c_str());
     return shared_ptr<SSLContext>();
   } else {
     VLOG(6) << folly::stringPrintf(
         "\"%s\" is an exact match", key.dnString.c_str());
-    return v->second;
+    return ctx;
   }
 }
 
+shared_ptr<SSLContext> SSLContextManager::SslContexts::getSSLCtx(
+    folly::StringPiece canonicalDn,
+    CertCrypto certCrypto) const {
+  auto ctx = indexFind(canonicalDn, certCrypto);
+  if (ctx) {
+    return ctx;
+  }
+  auto dot = canonicalDn.find('.');
+  if (dot != folly::StringPiece::npos) {
+    return indexFind(canonicalDn.subpiece(dot), certCrypto);
+  }
+  return shared_ptr<SSLContext>();
+}
+
+bool SSLContextManager::SslContexts::isDefaultCtx(
+    folly::StringPiece canonicalDn,
+    CertCrypto certCrypto) const {
+  // defaultCtxKeys_ is typically a handful of entries; compare without
+  // materializing SSLContextKeys.
+  auto matches = [&](folly::StringPiece dn) {
+    for (const auto& key : defaultCtxKeys_) {
+      if (key.certCrypto == certCrypto && key.dnString.size() == dn.size() &&
+          dn_char_traits::compare(
+              key.dnString.data(), dn.data(), dn.size()) == 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+  if (matches(canonicalDn)) {
+    return true;
+  }
+  auto dot = canonicalDn.find('.');
+  return dot != folly::StringPiece::npos && matches(canonicalDn.subpiece(dot));
+}
+
+void SSLContextManager::SslContexts::indexInsert(
+    const SSLContextKey& key,
+    shared_ptr<SSLContext> sslCtx) {
+  CanonicalizedDn dn(
+      folly::StringPiece(key.dnString.data(), key.dnString.size()));
+  dnIndex_[static_cast<size_t>(key.certCrypto)].insert_or_assign(
+      (*dn).str(), std::move(sslCtx));
+}
+
+void SSLContextManager::SslContexts::indexErase(const SSLContextKey& key) {
+  CanonicalizedDn dn(
+      folly::StringPiece(key.dnString.data(), key.dnString.size()));
+  dnIndex_[static_cast<size_t>(key.certCrypto)].erase(*dn);
+}
+
+shared_ptr<SSLContext> SSLContextManager::SslContexts::indexFind(
+    folly::StringPiece canonicalDn,
+    CertCrypto certCrypto) const {
+  const auto& index = dnIndex_[static_cast<size_t>(certCrypto)];
+  const auto v = index.find(canonicalDn);
+  return v == index.end() ? shared_ptr<SSLContext>() : v->second;
+}
+
 void SSLContextManager::SslContexts::reloadTLSTicketKeys(
     const std::vector<std::string>& oldSeeds,
     const std::vector<std::string>& currentSeeds,
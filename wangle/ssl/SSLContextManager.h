@@ -22,6 +22,7 @@
 
 #include <glog/logging.h>
 #include <wangle/acceptor/SSLContextSelectionMisc.h>
+#include <wangle/ssl/CertFileRegistry.h>
 #include <wangle/ssl/PasswordInFileFactory.h>
 #include <wangle/ssl/SSLContextConfig.h>
 #include <wangle/ssl/SSLSessionCacheManager.h>
@@ -198,6 +199,15 @@ class SSLContextManager {
     passwordFactory_ = std::move(factory);
   }
 
+  /**
+   * Serve file-backed certs and keys out of a shared registry so many
+   * managers in one process read each PEM file once. Certs with a
+   * passwordPath (encrypted keys) keep the direct file path.
+   */
+  void setCertFileRegistry(std::shared_ptr<CertFileRegistry> registry) {
+    certFileRegistry_ = std::move(registry);
+  }
+
  protected:
   // Return value indicates if any certificates were loaded. If not, the cert
   // manager skips this context config. Allows for contexts using certs only
@@ -262,6 +272,7 @@ class SSLContextManager {
   std::unique_ptr<ClientCertVerifyCallback> clientCertVerifyCallback_{nullptr};
   std::shared_ptr<ServerSSLContext> defaultCtx_;
   std::shared_ptr<PasswordInFileFactory> passwordFactory_{nullptr};
+  std::shared_ptr<CertFileRegistry> certFileRegistry_{nullptr};
 };
 
 } // namespace wangle
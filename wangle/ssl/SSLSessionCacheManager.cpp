@@ -16,16 +16,21 @@
 
 #include <wangle/ssl/SSLSessionCacheManager.h>
 
+#include <wangle/client/persistence/FilePersistenceLayer.h>
 #include <wangle/ssl/SSLCacheProvider.h>
 #include <wangle/ssl/SSLStats.h>
 #include <wangle/ssl/SSLUtil.h>
+#include <wangle/util/MemoryAccounting.h>
 
+#include <folly/String.h>
 #include <folly/fibers/Fiber.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/OpenSSL.h>
 
+#include <ctime>
+
 using folly::AsyncSSLSocket;
 using folly::SSLContext;
 using std::shared_ptr;
@@ -33,12 +38,23 @@ using std::string;
 
 namespace {
 
-const uint32_t NUM_CACHE_BUCKETS = 16;
+// More shards than typical worker counts so that a resumption lookup and a
+// new-session insert rarely land on the same lock.
+const uint32_t NUM_CACHE_BUCKETS = 64;
 
 // We use the default ID generator which fills the maximum ID length
 // for the protocol.  16 bytes for SSLv2 or 32 for SSLv3+
 const int MIN_SESSION_ID_LENGTH = 16;
 
+// Bytes attributed to a cached session in the SSL_SESSION_CACHE
+// accounting: its DER length plus the ID it is keyed under. Measured
+// only on store/remove, which happen at handshake rate, not lookup
+// rate.
+size_t sessionFootprint(const std::string& sessionId, SSL_SESSION* session) {
+  int len = i2d_SSL_SESSION(session, nullptr);
+  return sessionId.size() + (len > 0 ? size_t(len) : 0);
+}
+
 } // namespace
 
 FOLLY_GFLAGS_DEFINE_bool(
@@ -51,6 +67,7 @@ namespace wangle {
 int SSLSessionCacheManager::sExDataIndex_ = -1;
 shared_ptr<ShardedLocalSSLSessionCache> SSLSessionCacheManager::sCache_;
 std::mutex SSLSessionCacheManager::sCacheLock_;
+std::string SSLSessionCacheManager::sPersistencePath_;
 
 LocalSSLSessionCache::LocalSSLSessionCache(
     uint32_t maxCacheSize,
@@ -68,8 +85,12 @@ void LocalSSLSessionCache::pruneSessionCallback(
     SSL_SESSION* session) {
   VLOG(4) << "Free SSL session from local cache; id="
           << SSLUtil::hexlify(sessionId);
+  MemoryAccounting::sub(
+      MemorySubsystem::SSL_SESSION_CACHE,
+      sessionFootprint(sessionId, session));
   SSL_SESSION_free(session);
   ++removedSessions_;
+  evictions.fetch_add(1, std::memory_order_relaxed);
 }
 
 // ShardedLocalSSLSessionCache Implementation
@@ -95,16 +116,21 @@ ShardedLocalSSLSessionCache::ShardedLocalSSLSessionCache(
 SSL_SESSION* ShardedLocalSSLSessionCache::lookupSession(
     const std::string& sessionId) {
   size_t bucket = hash(sessionId);
+  auto& cache = *caches_[bucket];
   SSL_SESSION* session = nullptr;
-  std::lock_guard<std::mutex> g(caches_[bucket]->lock);
+  std::shared_lock<folly::SharedMutex> g(cache.lock);
 
-  auto itr = caches_[bucket]->sessionCache.find(sessionId);
-  if (itr != caches_[bucket]->sessionCache.end()) {
+  // No LRU promotion, so concurrent lookups only need the lock shared.
+  auto itr = cache.sessionCache.findWithoutPromotion(sessionId);
+  if (itr != cache.sessionCache.end()) {
     session = itr->second;
   }
 
   if (session) {
     SSL_SESSION_up_ref(session);
+    cache.hits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    cache.misses.fetch_add(1, std::memory_order_relaxed);
   }
   return session;
 }
@@ -115,7 +141,7 @@ void ShardedLocalSSLSessionCache::storeSession(
     SSLStats* stats) {
   size_t bucket = hash(sessionId);
   SSL_SESSION* oldSession = nullptr;
-  std::lock_guard<std::mutex> g(caches_[bucket]->lock);
+  std::unique_lock<folly::SharedMutex> g(caches_[bucket]->lock);
 
   auto itr = caches_[bucket]->sessionCache.find(sessionId);
   if (itr != caches_[bucket]->sessionCache.end()) {
@@ -125,8 +151,14 @@ void ShardedLocalSSLSessionCache::storeSession(
   if (oldSession) {
     // LRUCacheMap doesn't free on overwrite, so 2x the work for us
     // This can happen in race conditions
+    MemoryAccounting::sub(
+        MemorySubsystem::SSL_SESSION_CACHE,
+        sessionFootprint(sessionId, oldSession));
     SSL_SESSION_free(oldSession);
   }
+  MemoryAccounting::add(
+      MemorySubsystem::SSL_SESSION_CACHE,
+      sessionFootprint(sessionId, session));
   caches_[bucket]->removedSessions_ = 0;
   caches_[bucket]->sessionCache.set(sessionId, session, true);
   if (stats) {
@@ -134,9 +166,93 @@ void ShardedLocalSSLSessionCache::storeSession(
   }
 }
 
+ShardedLocalSSLSessionCache::ShardStats
+ShardedLocalSSLSessionCache::getShardStats(size_t shard) const {
+  const auto& cache = *caches_[shard];
+  ShardStats stats;
+  stats.hits = cache.hits.load(std::memory_order_relaxed);
+  stats.misses = cache.misses.load(std::memory_order_relaxed);
+  stats.evictions = cache.evictions.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void ShardedLocalSSLSessionCache::reportShardStats(SSLStats* stats) {
+  if (!stats) {
+    return;
+  }
+  for (uint32_t i = 0; i < caches_.size(); i++) {
+    auto& cache = *caches_[i];
+    stats->recordSSLLocalCacheShardStats(
+        i,
+        cache.hits.exchange(0, std::memory_order_relaxed),
+        cache.misses.exchange(0, std::memory_order_relaxed),
+        cache.evictions.exchange(0, std::memory_order_relaxed));
+  }
+}
+
+folly::dynamic ShardedLocalSSLSessionCache::serializeSessions() {
+  folly::dynamic sessions = folly::dynamic::array;
+  for (auto& cache : caches_) {
+    std::shared_lock<folly::SharedMutex> g(cache->lock);
+    for (const auto& entry : cache->sessionCache) {
+      int len = i2d_SSL_SESSION(entry.second, nullptr);
+      if (len <= 0) {
+        continue;
+      }
+      std::string der(size_t(len), '\0');
+      auto* p = reinterpret_cast<unsigned char*>(&der[0]);
+      i2d_SSL_SESSION(entry.second, &p);
+      sessions.push_back(folly::dynamic::object(
+          "id", SSLUtil::hexlify(entry.first))(
+          "session", SSLUtil::hexlify(der)));
+    }
+  }
+  return sessions;
+}
+
+size_t ShardedLocalSSLSessionCache::loadSerializedSessions(
+    const folly::dynamic& sessions) {
+  if (!sessions.isArray()) {
+    return 0;
+  }
+  size_t loaded = 0;
+  const auto now = std::time(nullptr);
+  for (const auto& entry : sessions) {
+    if (!entry.isObject()) {
+      continue;
+    }
+    const auto* id = entry.get_ptr("id");
+    const auto* data = entry.get_ptr("session");
+    if (!id || !data || !id->isString() || !data->isString()) {
+      continue;
+    }
+    std::string sessionId;
+    std::string der;
+    if (!folly::unhexlify(id->asString(), sessionId) ||
+        !folly::unhexlify(data->asString(), der)) {
+      continue;
+    }
+    const auto* p = reinterpret_cast<const unsigned char*>(der.data());
+    SSL_SESSION* session = d2i_SSL_SESSION(nullptr, &p, long(der.size()));
+    if (!session) {
+      continue;
+    }
+    // Staleness validation: a session past its own expiry would only be
+    // offered to clients that can no longer resume with it.
+    if (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <=
+        now) {
+      SSL_SESSION_free(session);
+      continue;
+    }
+    storeSession(sessionId, session, nullptr);
+    loaded++;
+  }
+  return loaded;
+}
+
 void ShardedLocalSSLSessionCache::removeSession(const std::string& sessionId) {
   size_t bucket = hash(sessionId);
-  std::lock_guard<std::mutex> g(caches_[bucket]->lock);
+  std::unique_lock<folly::SharedMutex> g(caches_[bucket]->lock);
 
   auto itr = caches_[bucket]->sessionCache.find(sessionId);
   if (itr == caches_[bucket]->sessionCache.end()) {
@@ -145,6 +261,9 @@ void ShardedLocalSSLSessionCache::removeSession(const std::string& sessionId) {
   }
 
   // LRUCacheMap doesn't free on erase either
+  MemoryAccounting::sub(
+      MemorySubsystem::SSL_SESSION_CACHE,
+      sessionFootprint(sessionId, itr->second));
   SSL_SESSION_free(itr->second);
   caches_[bucket]->sessionCache.erase(sessionId);
 }
@@ -185,9 +304,25 @@ SSLSessionCacheManager::~SSLSessionCacheManager() {}
 
 void SSLSessionCacheManager::shutdown() {
   std::lock_guard<std::mutex> g(sCacheLock_);
+  if (sCache_ && !sPersistencePath_.empty()) {
+    FilePersistenceLayer persistence(sPersistencePath_);
+    auto sessions = sCache_->serializeSessions();
+    if (!persistence.persist(sessions)) {
+      LOG(WARNING) << "failed to snapshot SSL session cache to "
+                   << sPersistencePath_;
+    } else {
+      VLOG(2) << "snapshotted " << sessions.size() << " SSL sessions to "
+              << sPersistencePath_;
+    }
+  }
   sCache_.reset();
 }
 
+void SSLSessionCacheManager::setPersistencePath(const std::string& path) {
+  std::lock_guard<std::mutex> g(sCacheLock_);
+  sPersistencePath_ = path;
+}
+
 shared_ptr<ShardedLocalSSLSessionCache> SSLSessionCacheManager::getLocalCache(
     uint32_t maxCacheSize,
     uint32_t cacheCullSize) {
@@ -195,6 +330,14 @@ shared_ptr<ShardedLocalSSLSessionCache> SSLSessionCacheManager::getLocalCache(
   if (!sCache_) {
     sCache_.reset(new ShardedLocalSSLSessionCache(
         NUM_CACHE_BUCKETS, maxCacheSize, cacheCullSize));
+    if (!sPersistencePath_.empty()) {
+      FilePersistenceLayer persistence(sPersistencePath_);
+      if (auto sessions = persistence.load()) {
+        auto loaded = sCache_->loadSerializedSessions(*sessions);
+        VLOG(2) << "warmed SSL session cache with " << loaded
+                << " sessions from " << sPersistencePath_;
+      }
+    }
   }
   return sCache_;
 }
@@ -291,7 +434,7 @@ SSL_SESSION* SSLSessionCacheManager::getSession(
     DCHECK(folly::fibers::onFiber());
     if (folly::fibers::onFiber()) {
       try {
-        session = externalCache_->getFuture(sessionId).get();
+        session = lookupCacheRecord(sessionId, sslSocket).get();
       } catch (const std::exception& e) {
         missReason = folly::to<std::string>("reason: ", e.what(), ";");
       }
@@ -325,6 +468,94 @@ SSL_SESSION* SSLSessionCacheManager::getSession(
   return session.release();
 }
 
+folly::Future<folly::ssl::SSLSessionUniquePtr>
+SSLSessionCacheManager::lookupCacheRecord(
+    const string& sessionId,
+    AsyncSSLSocket* sslSocket) {
+  std::shared_ptr<folly::SharedPromise<std::shared_ptr<SSL_SESSION>>> promise;
+  bool scheduleFlush = false;
+  {
+    std::lock_guard<std::mutex> g(pendingLookups_->lock);
+    auto& entry = pendingLookups_->inFlight[sessionId];
+    if (!entry) {
+      entry = std::make_shared<
+          folly::SharedPromise<std::shared_ptr<SSL_SESSION>>>();
+      pendingLookups_->batch.push_back(sessionId);
+      if (!pendingLookups_->flushScheduled) {
+        pendingLookups_->flushScheduled = true;
+        scheduleFlush = true;
+      }
+    } else {
+      VLOG(4) << "Collapsing lookup onto in-flight fetch; id="
+              << SSLUtil::hexlify(sessionId);
+    }
+    promise = entry;
+  }
+  if (scheduleFlush) {
+    // Flush at the end of this loop iteration so every lookup issued by
+    // the handshakes running in it lands in one multi-get.
+    sslSocket->getEventBase()->runInLoop(
+        [state = pendingLookups_, cache = externalCache_] {
+          flushPendingLookups(std::move(state), std::move(cache));
+        },
+        true /* thisIteration */);
+  }
+  return promise->getFuture().thenValue([](std::shared_ptr<SSL_SESSION> s) {
+    if (!s) {
+      return folly::ssl::SSLSessionUniquePtr();
+    }
+    SSL_SESSION_up_ref(s.get());
+    return folly::ssl::SSLSessionUniquePtr(s.get());
+  });
+}
+
+void SSLSessionCacheManager::flushPendingLookups(
+    std::shared_ptr<PendingExternalLookups> state,
+    std::shared_ptr<SSLCacheProvider> externalCache) {
+  std::vector<string> batch;
+  {
+    std::lock_guard<std::mutex> g(state->lock);
+    batch.swap(state->batch);
+    state->flushScheduled = false;
+  }
+  if (batch.empty()) {
+    return;
+  }
+  VLOG(4) << "Flushing " << batch.size() << " external cache lookups";
+  auto futures = externalCache->getFutures(batch);
+  DCHECK_EQ(futures.size(), batch.size());
+  for (size_t i = 0; i < futures.size() && i < batch.size(); i++) {
+    std::move(futures[i])
+        .thenTry([state, sessionId = batch[i]](
+                     folly::Try<folly::ssl::SSLSessionUniquePtr> result) {
+          std::shared_ptr<folly::SharedPromise<std::shared_ptr<SSL_SESSION>>>
+              promise;
+          {
+            std::lock_guard<std::mutex> g(state->lock);
+            auto it = state->inFlight.find(sessionId);
+            if (it == state->inFlight.end()) {
+              return;
+            }
+            promise = std::move(it->second);
+            state->inFlight.erase(it);
+          }
+          if (result.hasException()) {
+            promise->setException(std::move(result.exception()));
+            return;
+          }
+          // All collapsed waiters share one refcount via the
+          // shared_ptr; each takes its own SSL_SESSION reference on
+          // receipt.
+          promise->setValue(std::shared_ptr<SSL_SESSION>(
+              result->release(), [](SSL_SESSION* s) {
+                if (s) {
+                  SSL_SESSION_free(s);
+                }
+              }));
+        });
+  }
+}
+
 bool SSLSessionCacheManager::storeCacheRecord(
     const string& sessionId,
     SSL_SESSION* session) {
@@ -19,10 +19,16 @@
 #include <wangle/ssl/SSLCacheProvider.h>
 #include <wangle/ssl/SSLStats.h>
 
+#include <folly/SharedMutex.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <folly/dynamic.h>
+#include <folly/futures/SharedPromise.h>
 #include <folly/hash/Hash.h>
 #include <folly/io/async/AsyncSSLSocket.h>
+#include <atomic>
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace wangle {
 
@@ -34,21 +40,28 @@ class SSLStats;
 typedef folly::EvictingCacheMap<std::string, SSL_SESSION*> SSLSessionCacheMap;
 
 /**
- * Holds an SSLSessionCacheMap and associated lock
+ * Holds an SSLSessionCacheMap and associated lock.
+ *
+ * Lookups take the lock shared and do not promote the entry in the LRU;
+ * stores and removes take it exclusive. Hit/miss/eviction counters are
+ * atomics so the shared-lock read path can bump them.
  */
 class LocalSSLSessionCache {
  public:
   LocalSSLSessionCache(uint32_t maxCacheSize, uint32_t cacheCullSize);
 
   ~LocalSSLSessionCache() {
-    std::lock_guard<std::mutex> g(lock);
+    std::unique_lock<folly::SharedMutex> g(lock);
     // EvictingCacheMap dtor doesn't free values
     sessionCache.clear();
   }
 
   SSLSessionCacheMap sessionCache;
-  std::mutex lock;
+  folly::SharedMutex lock;
   uint32_t removedSessions_{0};
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> evictions{0};
 
  private:
   LocalSSLSessionCache(const LocalSSLSessionCache&) = delete;
@@ -61,9 +74,22 @@ class LocalSSLSessionCache {
  * A sharded LRU for SSL sessions.  The sharding is inteneded to reduce
  * contention for the LRU locks.  Assuming uniform distribution, two workers
  * will contend for the same lock with probability 1 / n_buckets^2.
+ *
+ * Resumption lookups take a shard's lock shared and look the session up
+ * without promoting it in the LRU, so concurrent lookups never serialize
+ * against each other, only against inserts into the same shard.  A session
+ * therefore ages from its last store, not its last use; resumed sessions
+ * are looked up a bounded number of times before they expire anyway, so
+ * this trades exact LRU order for reader concurrency.
  */
 class ShardedLocalSSLSessionCache {
  public:
+  struct ShardStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+  };
+
   ShardedLocalSSLSessionCache(
       uint32_t n_buckets,
       uint32_t maxCacheSize,
@@ -78,6 +104,29 @@ class ShardedLocalSSLSessionCache {
 
   void removeSession(const std::string& sessionId);
 
+  ShardStats getShardStats(size_t shard) const;
+
+  /**
+   * Report each shard's hit/miss/eviction counts accumulated since the last
+   * call, then reset them. Meant to be called periodically so cache sizing
+   * can be driven from production data.
+   */
+  void reportShardStats(SSLStats* stats);
+
+  /**
+   * Serialize every cached session (DER via i2d_SSL_SESSION, hex
+   * encoded) into the array-of-objects shape the client persistence
+   * layers read and write, for snapshotting across restarts.
+   */
+  folly::dynamic serializeSessions();
+
+  /**
+   * Bulk-load sessions produced by serializeSessions().  Sessions past
+   * their OpenSSL expiry (session time + timeout) and entries that fail
+   * to parse are skipped.  Returns the number of sessions loaded.
+   */
+  size_t loadSerializedSessions(const folly::dynamic& sessions);
+
   size_t hash(const std::string& key) {
     return folly::Hash()(key) % caches_.size();
   }
@@ -132,10 +181,21 @@ class SSLSessionCacheManager {
 
   /**
    * Call this on shutdown to release the global instance of the
-   * ShardedLocalSSLSessionCache.
+   * ShardedLocalSSLSessionCache.  If a persistence path is set, the
+   * cache's sessions are snapshotted to it first.
    */
   static void shutdown();
 
+  /**
+   * File used to carry the local session cache across restarts: the
+   * next cache creation bulk-loads still-valid sessions from it, and
+   * shutdown() snapshots the cache back.  Set before the first
+   * SSLSessionCacheManager is constructed (Acceptor::init does this
+   * from SSLCacheOptions::sessionPersistencePath) so the warm cache is
+   * in place before traffic lands.  Empty disables persistence.
+   */
+  static void setPersistencePath(const std::string& path);
+
  private:
   SSLSessionCacheManager(const SSLSessionCacheManager&) = delete;
   SSLSessionCacheManager& operator=(const SSLSessionCacheManager&) = delete;
@@ -151,6 +211,8 @@ class SSLSessionCacheManager {
   std::shared_ptr<ShardedLocalSSLSessionCache> localCache_;
   SSLStats* stats_{nullptr};
   std::shared_ptr<SSLCacheProvider> externalCache_;
+  std::shared_ptr<PendingExternalLookups> pendingLookups_{
+      std::make_shared<PendingExternalLookups>()};
 
   /**
    * Invoked by openssl when a new SSL session is created
@@ -177,6 +239,36 @@ class SSLSessionCacheManager {
    */
   bool storeCacheRecord(const std::string& sessionId, SSL_SESSION* session);
 
+  /**
+   * External lookups in flight and the batch accumulated for the next
+   * flush. Concurrent handshakes for the same session ID collapse onto
+   * one in-flight fetch; distinct IDs issued within one event loop
+   * iteration are flushed as a single getFutures() call. Shared with
+   * the flush callback so it can outlive the manager.
+   */
+  struct PendingExternalLookups {
+    std::mutex lock;
+    std::unordered_map<
+        std::string,
+        std::shared_ptr<folly::SharedPromise<std::shared_ptr<SSL_SESSION>>>>
+        inFlight;
+    std::vector<std::string> batch;
+    bool flushScheduled{false};
+  };
+
+  /**
+   * Request a session from the external cache, collapsing onto an
+   * in-flight fetch for the same ID and batching with other lookups
+   * from this loop iteration.
+   */
+  folly::Future<folly::ssl::SSLSessionUniquePtr> lookupCacheRecord(
+      const std::string& sessionId,
+      folly::AsyncSSLSocket* sslSocket);
+
+  static void flushPendingLookups(
+      std::shared_ptr<PendingExternalLookups> state,
+      std::shared_ptr<SSLCacheProvider> externalCache);
+
   /**
    * Get or create the LRU cache for the given VIP ID
    */
@@ -205,6 +297,7 @@ class SSLSessionCacheManager {
   static int32_t sExDataIndex_;
   static std::shared_ptr<ShardedLocalSSLSessionCache> sCache_;
   static std::mutex sCacheLock_;
+  static std::string sPersistencePath_;
 };
 
 } // namespace wangle
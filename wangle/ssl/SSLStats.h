@@ -37,6 +37,53 @@ class SSLStats {
   virtual void recordSSLClientCertificateMismatch() noexcept = 0;
   virtual void recordTLSTicketRotation(bool valid) noexcept = 0;
 
+  /**
+   * Per-shard local session cache counters, reported periodically via
+   * ShardedLocalSSLSessionCache::reportShardStats. Defaulted to a no-op so
+   * existing implementations are unaffected.
+   */
+  virtual void recordSSLLocalCacheShardStats(
+      uint32_t /* shard */,
+      uint64_t /* hits */,
+      uint64_t /* misses */,
+      uint64_t /* evictions */) noexcept {}
+
+  /**
+   * Latency of a completed downstream handshake, split by whether it ran
+   * inline on the acceptor's EventBase or was offloaded to a handshake
+   * pool. Defaulted to a no-op so existing implementations are unaffected.
+   */
+  virtual void recordSSLHandshakeLatency(
+      int64_t /* latencyMs */,
+      bool /* offloaded */) noexcept {}
+
+  /**
+   * Outcome of the post-handshake kernel TLS offload stage when the
+   * acceptor prefers kTLS: success means record crypto moved into the
+   * kernel for this connection, failure means it stayed in userspace
+   * (unsupported cipher or kernel, or a non-fizz transport). Defaulted to
+   * a no-op so existing implementations are unaffected.
+   */
+  virtual void recordKTLSOffload(bool /* success */) noexcept {}
+
+  /**
+   * A handshake shed by per-source admission control before it was
+   * started: the client's source prefix exceeded its full-handshake
+   * rate limit (ServerSocketConfig::maxHandshakesPerSourcePerWindow).
+   * Defaulted to a no-op so existing implementations are unaffected.
+   */
+  virtual void recordHandshakeRateLimited() noexcept {}
+
+  /**
+   * Outcome of serving an OCSP status request: served means a fresh
+   * staple went out with the handshake; otherwise the context had no
+   * staple, or the staple had gone stale and was withheld. Defaulted
+   * to a no-op so existing implementations are unaffected.
+   */
+  virtual void recordOcspStapleStatus(
+      bool /* served */,
+      bool /* stale */) noexcept {}
+
   // upstream
   virtual void recordSSLUpstreamConnection(bool handshake) noexcept = 0;
   virtual void recordSSLUpstreamConnectionError(bool verifyError) noexcept = 0;
@@ -19,9 +19,12 @@
 #include <folly/FileUtil.h>
 #include <folly/Format.h>
 #include <folly/Memory.h>
+#include <folly/Synchronized.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/ssl/OpenSSLPtrTypes.h>
 
+#include <map>
+
 #include <folly/portability/OpenSSL.h>
 
 namespace wangle {
@@ -48,6 +51,34 @@ SSLResumeEnum SSLUtil::getResumeState(folly::AsyncSSLSocket* sslSocket) {
       : SSLResumeEnum::HANDSHAKE;
 }
 
+std::shared_ptr<std::string> SSLUtil::internString(const char* cstr) {
+  if (!cstr) {
+    return nullptr;
+  }
+  return internString(folly::StringPiece(cstr));
+}
+
+std::shared_ptr<std::string> SSLUtil::internString(folly::StringPiece str) {
+  // std::less<> makes find() transparent, so the hot-path lookup
+  // compares against the StringPiece without materializing a string.
+  static folly::Synchronized<
+      std::map<std::string, std::shared_ptr<std::string>, std::less<>>>
+      sInternTable;
+  {
+    auto table = sInternTable.rlock();
+    auto it = table->find(str);
+    if (it != table->end()) {
+      return it->second;
+    }
+  }
+  auto table = sInternTable.wlock();
+  auto& entry = (*table)[str.str()];
+  if (!entry) {
+    entry = std::make_shared<std::string>(str.str());
+  }
+  return entry;
+}
+
 std::unique_ptr<std::string> SSLUtil::getCommonName(const X509* cert) {
   X509_NAME* subject = X509_get_subject_name((X509*)cert);
   if (!subject) {
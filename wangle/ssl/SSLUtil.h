@@ -181,6 +181,18 @@ class SSLUtil {
    */
   static SSLResumeEnum getResumeState(folly::AsyncSSLSocket* sslSocket);
 
+  /**
+   * Return a process-wide canonical copy of str. Values like negotiated
+   * cipher and signature algorithm names are drawn from a tiny fixed
+   * set but used to be copied into a fresh string per connection; the
+   * interned copy is allocated on first sight and shared afterwards.
+   * Only use this for low-cardinality values (never e.g. SNI names, or
+   * the table grows without bound), and never mutate the returned
+   * string through the pointer. Returns null for a null cstr.
+   */
+  static std::shared_ptr<std::string> internString(const char* cstr);
+  static std::shared_ptr<std::string> internString(folly::StringPiece str);
+
   /**
    * Get the Common Name from an X.509 certificate
    * @param cert  certificate to inspect
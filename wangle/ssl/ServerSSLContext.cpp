@@ -16,18 +16,38 @@
 
 #include <wangle/ssl/ServerSSLContext.h>
 
+#include <cstring>
+
+#include <glog/logging.h>
+#include <openssl/ocsp.h>
+
+#include <folly/FileUtil.h>
 #include <folly/Memory.h>
+#include <folly/ScopeGuard.h>
+#include <folly/experimental/FunctionScheduler.h>
 #include <wangle/ssl/SSLCacheOptions.h>
 #include <wangle/ssl/SSLContextConfig.h>
 #include <wangle/ssl/SSLSessionCacheManager.h>
+#include <wangle/ssl/SSLStats.h>
 
 namespace wangle {
 
+namespace {
+
+// Fallback staple validity when the response carries no usable
+// nextUpdate: long enough to bridge refresh periods, short enough to
+// stop serving a staple the responder has long since superseded.
+constexpr std::chrono::hours kDefaultOcspValidity{24};
+
+} // namespace
+
 ServerSSLContext::ServerSSLContext(SSLVersion version)
     : folly::SSLContext(version) {
   setSessionCacheContext("ServerSSLContext");
 }
 
+ServerSSLContext::~ServerSSLContext() = default;
+
 void ServerSSLContext::setupSessionCache(
     const SSLContextConfig& ctxConfig,
     const SSLCacheOptions& cacheOptions,
@@ -52,4 +72,162 @@ void ServerSSLContext::setupSessionCache(
   }
 }
 
+void ServerSSLContext::setupOcspStapling(
+    const SSLContextConfig& ctxConfig,
+    SSLStats* stats) {
+  ocspStats_ = stats;
+  if (ctxConfig.ocspResponseFile.empty()) {
+    return;
+  }
+
+  std::string responseDer;
+  if (folly::readFile(ctxConfig.ocspResponseFile.c_str(), responseDer) &&
+      !responseDer.empty()) {
+    auto expiry = parseOcspExpiry(responseDer);
+    updateOcspStaple(std::move(responseDer), expiry);
+  } else {
+    LOG(ERROR) << "Unable to read OCSP response from "
+               << ctxConfig.ocspResponseFile << "; stapling starts cold";
+  }
+
+  SSL_CTX_set_tlsext_status_cb(getSSLCtx(), ocspStatusCallback);
+  SSL_CTX_set_tlsext_status_arg(getSSLCtx(), this);
+
+  startOcspRefresh(ctxConfig);
+}
+
+void ServerSSLContext::updateOcspStaple(
+    std::string responseDer,
+    std::chrono::system_clock::time_point expiry) {
+  auto staple = std::make_shared<OcspStaple>();
+  staple->responseDer = std::move(responseDer);
+  staple->expiry = expiry;
+  ocspStaple_.store(
+      std::shared_ptr<const OcspStaple>(std::move(staple)),
+      std::memory_order_release);
+}
+
+std::chrono::system_clock::time_point ServerSSLContext::parseOcspExpiry(
+    const std::string& responseDer) {
+  const auto fallback = std::chrono::system_clock::now() + kDefaultOcspValidity;
+
+  auto* data = reinterpret_cast<const unsigned char*>(responseDer.data());
+  auto* response = d2i_OCSP_RESPONSE(nullptr, &data, responseDer.size());
+  if (!response) {
+    return fallback;
+  }
+  SCOPE_EXIT {
+    OCSP_RESPONSE_free(response);
+  };
+
+  auto* basic = OCSP_response_get1_basic(response);
+  if (!basic) {
+    return fallback;
+  }
+  SCOPE_EXIT {
+    OCSP_BASICRESP_free(basic);
+  };
+
+  auto expiry = fallback;
+  bool found = false;
+  for (int i = 0; i < OCSP_resp_count(basic); i++) {
+    auto* single = OCSP_resp_get0(basic, i);
+    if (!single) {
+      continue;
+    }
+    ASN1_GENERALIZEDTIME* revokedAt = nullptr;
+    ASN1_GENERALIZEDTIME* thisUpdate = nullptr;
+    ASN1_GENERALIZEDTIME* nextUpdate = nullptr;
+    int reason = 0;
+    OCSP_single_get0_status(
+        single, &reason, &revokedAt, &thisUpdate, &nextUpdate);
+    if (!nextUpdate) {
+      continue;
+    }
+    int days = 0;
+    int secs = 0;
+    if (ASN1_TIME_diff(&days, &secs, nullptr, nextUpdate) != 1) {
+      continue;
+    }
+    auto candidate = std::chrono::system_clock::now() +
+        std::chrono::hours(24 * days) + std::chrono::seconds(secs);
+    if (!found || candidate < expiry) {
+      expiry = candidate;
+      found = true;
+    }
+  }
+  return expiry;
+}
+
+int ServerSSLContext::ocspStatusCallback(SSL* ssl, void* arg) {
+  return static_cast<ServerSSLContext*>(arg)->handleOcspStatusRequest(ssl);
+}
+
+int ServerSSLContext::handleOcspStatusRequest(SSL* ssl) {
+  auto staple = getOcspStaple();
+  bool stale = staple && staple->expiry <= std::chrono::system_clock::now();
+  if (!staple || stale) {
+    // Withhold rather than serve an expired staple, which clients
+    // treat as a hard verification failure.
+    if (ocspStats_) {
+      ocspStats_->recordOcspStapleStatus(false /* served */, stale);
+    }
+    return SSL_TLSEXT_ERR_NOACK;
+  }
+
+  // OpenSSL takes ownership of the buffer and frees it with the SSL.
+  auto len = staple->responseDer.size();
+  auto* copy = static_cast<unsigned char*>(OPENSSL_malloc(len));
+  if (!copy) {
+    return SSL_TLSEXT_ERR_NOACK;
+  }
+  memcpy(copy, staple->responseDer.data(), len);
+  if (SSL_set_tlsext_status_ocsp_resp(ssl, copy, len) != 1) {
+    OPENSSL_free(copy);
+    return SSL_TLSEXT_ERR_NOACK;
+  }
+  if (ocspStats_) {
+    ocspStats_->recordOcspStapleStatus(true /* served */, false /* stale */);
+  }
+  return SSL_TLSEXT_ERR_OK;
+}
+
+void ServerSSLContext::startOcspRefresh(const SSLContextConfig& ctxConfig) {
+  if (ctxConfig.ocspRefreshInterval.count() <= 0) {
+    return;
+  }
+  auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(
+      ctxConfig.ocspRefreshInterval);
+  auto jitter = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::min(ctxConfig.ocspRefreshJitter, ctxConfig.ocspRefreshInterval));
+  auto path = ctxConfig.ocspResponseFile;
+
+  // The refresh runs on the scheduler's own thread, never an IO
+  // thread, and publishes through the same lock-free swap as
+  // updateOcspStaple().
+  ocspRefresher_ = std::make_unique<folly::FunctionScheduler>();
+  ocspRefresher_->setThreadName("ocsp-refresh");
+  ocspRefresher_->addFunctionUniformDistribution(
+      [this, path] {
+        std::string responseDer;
+        if (!folly::readFile(path.c_str(), responseDer) ||
+            responseDer.empty()) {
+          LOG(WARNING) << "OCSP refresh: unable to read " << path;
+          return;
+        }
+        auto current = getOcspStaple();
+        if (current && current->responseDer == responseDer) {
+          // Unchanged on disk; keep the current expiry.
+          return;
+        }
+        auto expiry = parseOcspExpiry(responseDer);
+        updateOcspStaple(std::move(responseDer), expiry);
+      },
+      interval - jitter,
+      interval + jitter,
+      "ocsp-refresh",
+      interval - jitter);
+  ocspRefresher_->start();
+}
+
 } // namespace wangle
@@ -16,14 +16,17 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 
+#include <folly/concurrency/AtomicSharedPtr.h>
 #include <folly/io/async/SSLContext.h>
 
 namespace folly {
 
 class EventBase;
+class FunctionScheduler;
 class SocketAddress;
 
 } // namespace folly
@@ -42,7 +45,7 @@ class ServerSSLContext : public folly::SSLContext {
  public:
   explicit ServerSSLContext(SSLVersion version = TLSv1_2);
 
-  virtual ~ServerSSLContext() override = default;
+  virtual ~ServerSSLContext() override;
 
   void setupSessionCache(
       const SSLContextConfig& ctxConfig,
@@ -56,8 +59,57 @@ class ServerSSLContext : public folly::SSLContext {
     return sessionCacheManager_.get();
   }
 
+  /**
+   * A stapled OCSP response plus the point after which it is stale.
+   * Stale staples are withheld rather than served, since clients treat
+   * an expired staple as a verification failure.
+   */
+  struct OcspStaple {
+    std::string responseDer;
+    std::chrono::system_clock::time_point expiry;
+  };
+
+  /**
+   * Managed OCSP stapling: loads the staple from
+   * ctxConfig.ocspResponseFile, installs the status callback that
+   * serves it to handshakes, and starts re-reading the file on a
+   * background scheduler thread with the configured period and jitter.
+   * Swapping the staple in is a lock-free atomic pointer exchange, so
+   * in-flight handshakes see either the old or the new staple, never a
+   * torn one. No-op when no staple file is configured.
+   */
+  void setupOcspStapling(const SSLContextConfig& ctxConfig, SSLStats* stats);
+
+  /**
+   * Atomically replaces the served staple; callable from any thread.
+   * The expiry is normally the response's nextUpdate time, as parsed
+   * by parseOcspExpiry().
+   */
+  void updateOcspStaple(
+      std::string responseDer,
+      std::chrono::system_clock::time_point expiry);
+
+  std::shared_ptr<const OcspStaple> getOcspStaple() const {
+    return ocspStaple_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * The earliest nextUpdate across the response's singles, or now plus
+   * a conservative day when the field is absent or unparsable.
+   */
+  static std::chrono::system_clock::time_point parseOcspExpiry(
+      const std::string& responseDer);
+
  private:
+  static int ocspStatusCallback(SSL* ssl, void* arg);
+  int handleOcspStatusRequest(SSL* ssl);
+  void startOcspRefresh(const SSLContextConfig& ctxConfig);
+
   std::unique_ptr<SSLSessionCacheManager> sessionCacheManager_;
+  folly::atomic_shared_ptr<const OcspStaple> ocspStaple_;
+  SSLStats* ocspStats_{nullptr};
+  // Declared last so refresh stops before the staple state goes away.
+  std::unique_ptr<folly::FunctionScheduler> ocspRefresher_;
 };
 
 } // namespace wangle
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/SharedMemorySSLCacheProvider.h>
+
+#include <sys/file.h>
+
+#include <cstring>
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/hash/Hash.h>
+#include <folly/portability/Unistd.h>
+#include <glog/logging.h>
+#include <openssl/ssl.h>
+
+namespace wangle {
+
+namespace {
+
+constexpr uint64_t kMagic = 0x77676c5353436163ULL; // "wglSSCac"
+constexpr uint32_t kFormatVersion = 1;
+constexpr size_t kNumStripes = 64;
+constexpr size_t kMaxKeyLength = 64;
+constexpr size_t kMaxValueLength = 4096;
+
+int64_t nowSeconds() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+struct SharedMemorySSLCacheProvider::Header {
+  uint64_t magic;
+  uint32_t formatVersion;
+  // Stamped into every valid entry; bumped on re-initialization so
+  // entries written against an older layout are shed wholesale.
+  uint32_t generation;
+  uint64_t numBuckets;
+  pthread_mutex_t stripes[kNumStripes];
+};
+
+struct SharedMemorySSLCacheProvider::Entry {
+  // 0 marks the entry invalid (empty, or torn by a crashed writer).
+  uint32_t generation;
+  uint32_t keyLength;
+  uint32_t valueLength;
+  int64_t expiresAt; // seconds since the system_clock epoch
+  uint8_t key[kMaxKeyLength];
+  uint8_t value[kMaxValueLength];
+};
+
+SharedMemorySSLCacheProvider::SharedMemorySSLCacheProvider(
+    const std::string& path,
+    size_t numBuckets)
+    : numBuckets_(numBuckets) {
+  CHECK_GT(numBuckets_, 0u);
+  const off_t size = sizeof(Header) + numBuckets_ * sizeof(Entry);
+  folly::File file(path.c_str(), O_RDWR | O_CREAT, 0600);
+  folly::checkUnixError(
+      ftruncate(file.fd(), size), "failed to size SSL cache segment");
+  // Serializes header validation against sibling processes attaching at
+  // the same time; released (with the fd) when this scope ends.
+  folly::checkUnixError(
+      flock(file.fd(), LOCK_EX), "failed to lock SSL cache segment");
+  mapping_ = std::make_unique<folly::MemoryMapping>(
+      file.dup(), 0, size, folly::MemoryMapping::writable());
+  auto data = mapping_->writableRange();
+  header_ = reinterpret_cast<Header*>(data.data());
+  entries_ = reinterpret_cast<Entry*>(data.data() + sizeof(Header));
+  if (header_->magic != kMagic || header_->formatVersion != kFormatVersion ||
+      header_->numBuckets != numBuckets_) {
+    initializeSegment();
+  }
+  folly::checkUnixError(
+      flock(file.fd(), LOCK_UN), "failed to unlock SSL cache segment");
+}
+
+void SharedMemorySSLCacheProvider::initializeSegment() {
+  const uint32_t nextGeneration = header_->generation + 1;
+  header_->magic = 0;
+  std::memset(entries_, 0, numBuckets_ * sizeof(Entry));
+  pthread_mutexattr_t attr;
+  CHECK_EQ(pthread_mutexattr_init(&attr), 0);
+  CHECK_EQ(pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED), 0);
+  CHECK_EQ(pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST), 0);
+  for (auto& stripe : header_->stripes) {
+    CHECK_EQ(pthread_mutex_init(&stripe, &attr), 0);
+  }
+  pthread_mutexattr_destroy(&attr);
+  header_->formatVersion = kFormatVersion;
+  header_->generation = nextGeneration == 0 ? 1 : nextGeneration;
+  header_->numBuckets = numBuckets_;
+  // Written last: a crash mid-initialization leaves the magic unset and
+  // the next process re-runs this from the top.
+  header_->magic = kMagic;
+}
+
+size_t SharedMemorySSLCacheProvider::bucketOf(
+    const std::string& sessionId) const {
+  return folly::hash::fnv64(sessionId) % numBuckets_;
+}
+
+pthread_mutex_t* SharedMemorySSLCacheProvider::stripeFor(size_t bucket) {
+  return &header_->stripes[bucket % kNumStripes];
+}
+
+void SharedMemorySSLCacheProvider::lockStripe(pthread_mutex_t* mutex) {
+  const int rc = pthread_mutex_lock(mutex);
+  if (rc == EOWNERDEAD) {
+    // The previous holder died mid-critical-section. Any entry it was
+    // writing is still stamped invalid, so the table is consistent
+    // again the moment we take over.
+    pthread_mutex_consistent(mutex);
+  } else {
+    CHECK_EQ(rc, 0);
+  }
+}
+
+bool SharedMemorySSLCacheProvider::setAsync(
+    const std::string& sessionId,
+    const std::string& value,
+    std::chrono::seconds expiration) {
+  if (sessionId.empty() || sessionId.size() > kMaxKeyLength ||
+      value.empty() || value.size() > kMaxValueLength) {
+    return false;
+  }
+  const auto bucket = bucketOf(sessionId);
+  auto& entry = entries_[bucket];
+  auto* mutex = stripeFor(bucket);
+  lockStripe(mutex);
+  // Invalidate while the fields are in flux; see lockStripe().
+  entry.generation = 0;
+  entry.keyLength = sessionId.size();
+  entry.valueLength = value.size();
+  entry.expiresAt = nowSeconds() + expiration.count();
+  std::memcpy(entry.key, sessionId.data(), sessionId.size());
+  std::memcpy(entry.value, value.data(), value.size());
+  entry.generation = header_->generation;
+  pthread_mutex_unlock(mutex);
+  return true;
+}
+
+folly::Optional<std::string> SharedMemorySSLCacheProvider::lookupSerialized(
+    const std::string& sessionId) {
+  if (sessionId.empty() || sessionId.size() > kMaxKeyLength) {
+    return folly::none;
+  }
+  const auto bucket = bucketOf(sessionId);
+  auto& entry = entries_[bucket];
+  auto* mutex = stripeFor(bucket);
+  folly::Optional<std::string> result;
+  lockStripe(mutex);
+  if (entry.generation == header_->generation &&
+      entry.keyLength == sessionId.size() &&
+      std::memcmp(entry.key, sessionId.data(), sessionId.size()) == 0 &&
+      entry.expiresAt > nowSeconds()) {
+    result.emplace(
+        reinterpret_cast<const char*>(entry.value), entry.valueLength);
+  }
+  pthread_mutex_unlock(mutex);
+  return result;
+}
+
+folly::Future<folly::ssl::SSLSessionUniquePtr>
+SharedMemorySSLCacheProvider::getFuture(const std::string& sessionId) {
+  auto serialized = lookupSerialized(sessionId);
+  if (!serialized) {
+    return folly::makeFuture<folly::ssl::SSLSessionUniquePtr>(
+        std::runtime_error("session not in shared-memory cache"));
+  }
+  auto* data = reinterpret_cast<const unsigned char*>(serialized->data());
+  SSL_SESSION* session = d2i_SSL_SESSION(nullptr, &data, serialized->size());
+  if (!session) {
+    return folly::makeFuture<folly::ssl::SSLSessionUniquePtr>(
+        std::runtime_error("corrupt session in shared-memory cache"));
+  }
+  return folly::makeFuture(folly::ssl::SSLSessionUniquePtr(session));
+}
+
+} // namespace wangle
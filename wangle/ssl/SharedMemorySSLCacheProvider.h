@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <memory>
+#include <string>
+
+#include <folly/Optional.h>
+#include <folly/system/MemoryMapping.h>
+#include <wangle/ssl/SSLCacheProvider.h>
+
+namespace wangle {
+
+/**
+ * An SSLCacheProvider backed by a fixed-size hash table in a shared
+ * memory segment, so sibling processes accepting from one SO_REUSEPORT
+ * group resume each other's sessions instead of missing the local cache
+ * and falling back to an external store or a full handshake.
+ *
+ * The segment is a file — put it on a tmpfs such as /dev/shm — mapped
+ * MAP_SHARED by every process; the first process to attach (or any
+ * process finding a stale or mismatched header) initializes it, under a
+ * file lock so concurrently starting siblings do not race. The table is
+ * direct-mapped: the key hash picks the bucket and a colliding store
+ * overwrites, which plain cache semantics tolerate. Buckets are guarded
+ * by a fixed set of process-shared robust mutexes, one per stripe, so
+ * writers in different stripes never contend.
+ *
+ * Entries carry a generation stamp for crash-safe reuse: a writer
+ * zeroes the stamp, fills the entry, then stamps the table's current
+ * generation. A write torn by a crash leaves the stamp zero (the robust
+ * mutex hands the lock on with EOWNERDEAD), so readers skip the entry;
+ * re-initializing the segment bumps the table generation, shedding
+ * every surviving entry at once.
+ *
+ * Lookups and stores complete inline on the calling thread; getFuture()
+ * is always ready on return.
+ */
+class SharedMemorySSLCacheProvider : public SSLCacheProvider {
+ public:
+  /**
+   * Attaches to (creating and initializing if needed) the segment at
+   * path. Sessions serializing to more than about 4KB are not cached.
+   */
+  explicit SharedMemorySSLCacheProvider(
+      const std::string& path,
+      size_t numBuckets = 16384);
+
+  bool setAsync(
+      const std::string& sessionId,
+      const std::string& value,
+      std::chrono::seconds expiration) override;
+
+  folly::Future<folly::ssl::SSLSessionUniquePtr> getFuture(
+      const std::string& sessionId) override;
+
+  /**
+   * The stored serialized session, or none on a miss. The lookup
+   * getFuture() performs, without the OpenSSL deserialization; exposed
+   * for tests and debugging tools.
+   */
+  folly::Optional<std::string> lookupSerialized(const std::string& sessionId);
+
+  size_t getNumBuckets() const {
+    return numBuckets_;
+  }
+
+ private:
+  struct Header;
+  struct Entry;
+
+  void initializeSegment();
+  size_t bucketOf(const std::string& sessionId) const;
+  pthread_mutex_t* stripeFor(size_t bucket);
+  static void lockStripe(pthread_mutex_t* mutex);
+
+  size_t numBuckets_;
+  std::unique_ptr<folly::MemoryMapping> mapping_;
+  Header* header_{nullptr};
+  Entry* entries_{nullptr};
+};
+
+} // namespace wangle
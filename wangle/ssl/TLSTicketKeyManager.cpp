@@ -33,15 +33,14 @@ namespace {
 const int kTLSTicketKeyNameLen = 4;
 const int kTLSTicketKeySaltLen = 12;
 
+// Resumes hashing from a midstate that already absorbed the base key, so
+// each ticket operation only pays for the salt block.
 void saltKey(
-    const unsigned char* baseKey,
-    size_t keyLen,
+    const SHA256_CTX& prehashedKey,
     unsigned char* salt,
     unsigned char* output) {
-  SHA256_CTX hash_ctx;
+  SHA256_CTX hash_ctx = prehashedKey;
 
-  SHA256_Init(&hash_ctx);
-  SHA256_Update(&hash_ctx, baseKey, keyLen);
   SHA256_Update(&hash_ctx, salt, kTLSTicketKeySaltLen);
   SHA256_Final(output, &hash_ctx);
 }
@@ -58,6 +57,8 @@ TLSTicketKeyManager::TLSTicketKey::TLSTicketKey(
     TLSTicketSeedType type)
     : seed_(std::move(seed)), type_(type) {
   SHA256((unsigned char*)seed_.data(), seed_.length(), keyValue_);
+  SHA256_Init(&preKeyHash_);
+  SHA256_Update(&preKeyHash_, keyValue_, VALUE_LENGTH);
   name_ = computeName();
 }
 
@@ -93,7 +94,8 @@ std::unique_ptr<TLSTicketKeyManager> TLSTicketKeyManager::fromSeeds(
   return mgr;
 }
 
-TLSTicketKeyManager::TLSTicketKeyManager() {}
+TLSTicketKeyManager::TLSTicketKeyManager()
+    : keySet_(std::make_shared<const KeySet>()) {}
 
 TLSTicketKeyManager::~TLSTicketKeyManager() {}
 
@@ -131,7 +133,10 @@ int TLSTicketKeyManager::encryptCallback(
     unsigned char* iv,
     EVP_CIPHER_CTX* cipherCtx,
     HMAC_CTX* hmacCtx) {
-  auto key = findEncryptionKey();
+  // One lock-free load; name and key come from the same snapshot even if a
+  // rotation lands mid-handshake.
+  auto keySet = keySet_.load(std::memory_order_acquire);
+  auto key = findEncryptionKey(*keySet);
   if (key == nullptr) {
     // no keys available to encrypt
     FB_LOG_EVERY_MS(WARNING, 1000)
@@ -140,24 +145,13 @@ int TLSTicketKeyManager::encryptCallback(
     return 0;
   }
   VLOG(4) << "Encrypting new ticket with key name="
-          << SSLUtil::hexlify(encryptionKeyName_);
-  memcpy(keyName, encryptionKeyName_.data(), kTLSTicketKeyNameLen);
+          << SSLUtil::hexlify(keySet->encryptionKeyName);
+  memcpy(keyName, keySet->encryptionKeyName.data(), kTLSTicketKeyNameLen);
 
   uint8_t* salt = keyName + kTLSTicketKeyNameLen;
   populateRandom(salt, kTLSTicketKeySaltLen);
-
-  // Create the unique keys by hashing with the salt. Take the first 16 bytes
-  // of output as the hmac key, and the second 16 bytes as the aes key.
-  uint8_t output[SHA256_DIGEST_LENGTH];
-  saltKey(key->value(), TLSTicketKey::VALUE_LENGTH, salt, output);
-  uint8_t* hmacKey = output;
-  uint8_t* aesKey = output + SHA256_DIGEST_LENGTH / 2;
-
-  // Initialize iv and cipher/mac CTX
   populateRandom(iv, AES_BLOCK_SIZE);
-  HMAC_Init_ex(
-      hmacCtx, hmacKey, SHA256_DIGEST_LENGTH / 2, EVP_sha256(), nullptr);
-  EVP_EncryptInit_ex(cipherCtx, EVP_aes_128_cbc(), nullptr, aesKey, iv);
+  initTicketCryptoState(key, keyName, iv, cipherCtx, hmacCtx, 1);
 
   return 1;
 }
@@ -168,7 +162,8 @@ int TLSTicketKeyManager::decryptCallback(
     EVP_CIPHER_CTX* cipherCtx,
     HMAC_CTX* hmacCtx) {
   std::string name((char*)keyName, kTLSTicketKeyNameLen);
-  auto key = findDecryptionKey(name);
+  auto keySet = keySet_.load(std::memory_order_acquire);
+  auto key = findDecryptionKey(*keySet, name);
   if (key == nullptr) {
     // no ticket found for decryption - will issue a new ticket
     VLOG(4) << "Can't find ticket key with name=" << SSLUtil::hexlify(name)
@@ -177,22 +172,72 @@ int TLSTicketKeyManager::decryptCallback(
   }
   VLOG(4) << "Decrypting ticket with key name=" << SSLUtil::hexlify(name);
 
-  // Reconstruct the unique key via the salt
-  uint8_t* saltptr = keyName + kTLSTicketKeyNameLen;
+  initTicketCryptoState(key, keyName, iv, cipherCtx, hmacCtx, 0);
+
+  return 1;
+}
+
+void TLSTicketKeyManager::initTicketCryptoState(
+    const TLSTicketKey* key,
+    unsigned char* keyName,
+    unsigned char* iv,
+    EVP_CIPHER_CTX* cipherCtx,
+    HMAC_CTX* hmacCtx,
+    int encrypt) {
+  // Create the unique keys by hashing with the salt. Take the first 16 bytes
+  // of output as the hmac key, and the second 16 bytes as the aes key.
+  uint8_t* salt = keyName + kTLSTicketKeyNameLen;
   uint8_t output[SHA256_DIGEST_LENGTH];
-  saltKey(key->value(), TLSTicketKey::VALUE_LENGTH, saltptr, output);
+  saltKey(key->prehashedKey(), salt, output);
   uint8_t* hmacKey = output;
   uint8_t* aesKey = output + SHA256_DIGEST_LENGTH / 2;
 
-  // Initialize cipher/mac CTX
   HMAC_Init_ex(
       hmacCtx, hmacKey, SHA256_DIGEST_LENGTH / 2, EVP_sha256(), nullptr);
-  EVP_DecryptInit_ex(cipherCtx, EVP_aes_128_cbc(), nullptr, aesKey, iv);
+  if (encrypt) {
+    EVP_EncryptInit_ex(cipherCtx, EVP_aes_128_cbc(), nullptr, aesKey, iv);
+  } else {
+    EVP_DecryptInit_ex(cipherCtx, EVP_aes_128_cbc(), nullptr, aesKey, iv);
+  }
+}
 
-  return 1;
+size_t TLSTicketKeyManager::decryptBatch(
+    std::vector<PendingTicketDecrypt>& batch) {
+  // One snapshot load serves the whole batch; bursts arriving together are
+  // decrypted against a single key generation.
+  auto keySet = keySet_.load(std::memory_order_acquire);
+  const TLSTicketKey* lastKey = nullptr;
+  std::string lastName;
+  bool haveLast = false;
+  size_t found = 0;
+
+  for (auto& pending : batch) {
+    std::string name((char*)pending.keyName, kTLSTicketKeyNameLen);
+    if (!haveLast || name != lastName) {
+      lastKey = findDecryptionKey(*keySet, name);
+      lastName = std::move(name);
+      haveLast = true;
+    }
+    if (lastKey == nullptr) {
+      VLOG(4) << "Can't find ticket key with name="
+              << SSLUtil::hexlify(lastName) << ", will generate new ticket";
+      pending.result = 0;
+    } else {
+      initTicketCryptoState(
+          lastKey, pending.keyName, pending.iv, pending.cipherCtx,
+          pending.hmacCtx, 0);
+      pending.result = 1;
+      ++found;
+    }
+    if (stats_) {
+      stats_->recordTLSTicket(false /* encrypt */, pending.result);
+    }
+  }
+  return found;
 }
 
 bool TLSTicketKeyManager::insertSeed(
+    KeySet& keySet,
     const std::string& seedInput,
     TLSTicketSeedType type) {
   std::string seedOutput;
@@ -204,10 +249,10 @@ bool TLSTicketKeyManager::insertSeed(
 
   auto ticketKey = std::make_unique<TLSTicketKey>(std::move(seedOutput), type);
   auto name = ticketKey->name();
-  ticketKeyMap_[name] = std::move(ticketKey);
+  keySet.ticketKeyMap[name] = std::move(ticketKey);
 
   if (type == TLSTicketSeedType::SEED_CURRENT) {
-    encryptionKeyName_ = name;
+    keySet.encryptionKeyName = name;
   }
   return true;
 }
@@ -218,24 +263,32 @@ bool TLSTicketKeyManager::setTLSTicketKeySeeds(
     const std::vector<std::string>& newSeeds) {
   recordTlsTicketRotation(oldSeeds, currentSeeds, newSeeds);
 
-  encryptionKeyName_ = "";
-  ticketKeyMap_.clear();
+  // Build the new key set off to the side; in-flight callbacks keep using
+  // the previous snapshot until the store below.
+  auto newKeySet = std::make_shared<KeySet>();
   bool success = true;
   for (auto& seed : oldSeeds) {
-    success &= insertSeed(seed, TLSTicketSeedType::SEED_OLD);
+    success &= insertSeed(*newKeySet, seed, TLSTicketSeedType::SEED_OLD);
   }
   for (auto& seed : currentSeeds) {
-    success &= insertSeed(seed, TLSTicketSeedType::SEED_CURRENT);
+    success &= insertSeed(*newKeySet, seed, TLSTicketSeedType::SEED_CURRENT);
   }
   for (auto& seed : newSeeds) {
-    success &= insertSeed(seed, TLSTicketSeedType::SEED_NEW);
+    success &= insertSeed(*newKeySet, seed, TLSTicketSeedType::SEED_NEW);
   }
 
   if (!success) {
     VLOG(2) << "One or more seeds failed to decode";
   }
 
-  if (encryptionKeyName_.empty() || ticketKeyMap_.empty()) {
+  const bool valid =
+      !newKeySet->encryptionKeyName.empty() && !newKeySet->ticketKeyMap.empty();
+
+  keySet_.store(
+      std::shared_ptr<const KeySet>(std::move(newKeySet)),
+      std::memory_order_release);
+
+  if (!valid) {
     VLOG(1) << "No keys configured, session ticket resumption disabled";
     return false;
   }
@@ -251,7 +304,8 @@ bool TLSTicketKeyManager::getTLSTicketKeySeeds(
   currentSeeds.clear();
   newSeeds.clear();
   auto success = true;
-  for (const auto& keyValue : ticketKeyMap_) {
+  auto keySet = keySet_.load(std::memory_order_acquire);
+  for (const auto& keyValue : keySet->ticketKeyMap) {
     auto& ticketKey = *keyValue.second;
 
     std::string hexSeed;
@@ -287,14 +341,16 @@ void TLSTicketKeyManager::recordTlsTicketRotation(
   }
 }
 
-TLSTicketKeyManager::TLSTicketKey* TLSTicketKeyManager::findEncryptionKey() {
-  return findDecryptionKey(encryptionKeyName_);
+const TLSTicketKeyManager::TLSTicketKey* TLSTicketKeyManager::findEncryptionKey(
+    const KeySet& keySet) {
+  return findDecryptionKey(keySet, keySet.encryptionKeyName);
 }
 
-TLSTicketKeyManager::TLSTicketKey* TLSTicketKeyManager::findDecryptionKey(
+const TLSTicketKeyManager::TLSTicketKey* TLSTicketKeyManager::findDecryptionKey(
+    const KeySet& keySet,
     const std::string& keyName) {
-  auto iter = ticketKeyMap_.find(keyName);
-  if (iter == ticketKeyMap_.end()) {
+  auto iter = keySet.ticketKeyMap.find(keyName);
+  if (iter == keySet.ticketKeyMap.end()) {
     return nullptr;
   }
   return iter->second.get();
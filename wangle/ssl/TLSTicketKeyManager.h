@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <folly/concurrency/AtomicSharedPtr.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/ssl/OpenSSLTicketHandler.h>
@@ -29,11 +30,15 @@ struct TLSTicketKeySeeds;
  * The TLSTicketKeyManager handles TLS ticket encryption and decryption in a
  * way that facilitates sharing of ticket keys across a range of servers. This
  * implements the OpenSSLTicketHandler interface and is meant to be attached to
- * an SSLContext via setTicketHandler() and should therefore only be used in
- * one thread.
+ * an SSLContext via setTicketHandler(). The encrypt/decrypt callbacks must be
+ * invoked from the SSLContext's thread.
  *
  * Ticket seeds should be updated periodically (e.g., daily) via the
- * setTLSTicketKeySeeds() API.
+ * setTLSTicketKeySeeds() API. The full key set is published as an immutable
+ * snapshot behind an atomic_shared_ptr: each callback takes one consistent
+ * snapshot with a single lock-free load, and rotation is a pointer swap, so
+ * rotating seeds while handshakes are in flight never blocks or tears the
+ * key material the callbacks see.
  */
 class TLSTicketKeyManager : public folly::OpenSSLTicketHandler {
  public:
@@ -106,6 +111,30 @@ class TLSTicketKeyManager : public folly::OpenSSLTicketHandler {
     stats_ = stats;
   }
 
+  /**
+   * One pending ticket decryption for decryptBatch().  The pointer
+   * fields mirror the ticketCallback arguments; result is filled in
+   * with the value ticketCallback would have returned for this ticket.
+   */
+  struct PendingTicketDecrypt {
+    unsigned char* keyName{nullptr};
+    unsigned char* iv{nullptr};
+    EVP_CIPHER_CTX* cipherCtx{nullptr};
+    HMAC_CTX* hmacCtx{nullptr};
+    int result{0};
+  };
+
+  /**
+   * Prepare cipher/HMAC contexts for a burst of ticket decryptions in
+   * one call: a single key-set snapshot load covers the whole batch,
+   * and the decryption key is looked up once per run of tickets
+   * sharing a key name (bursts after an LB flap overwhelmingly carry
+   * the same generation).  Suited to a handshake offload pool draining
+   * a resumption burst.  Returns the number of tickets whose contexts
+   * were initialized.
+   */
+  size_t decryptBatch(std::vector<PendingTicketDecrypt>& batch);
+
  private:
   TLSTicketKeyManager(const TLSTicketKeyManager&) = delete;
   TLSTicketKeyManager& operator=(const TLSTicketKeyManager&) = delete;
@@ -152,6 +181,16 @@ class TLSTicketKeyManager : public folly::OpenSSLTicketHandler {
       return keyValue_;
     }
 
+    /**
+     * SHA256 state with the key value already absorbed.  Per-ticket
+     * salting resumes from a copy of this instead of rehashing the key
+     * for every operation; it lives in the immutable key set, so
+     * rotation replaces it along with the key.
+     */
+    const SHA256_CTX& prehashedKey() const {
+      return preKeyHash_;
+    }
+
     static constexpr uint32_t VALUE_LENGTH = SHA256_DIGEST_LENGTH;
 
    private:
@@ -164,19 +203,48 @@ class TLSTicketKeyManager : public folly::OpenSSLTicketHandler {
     TLSTicketSeedType type_;
     std::string name_;
     unsigned char keyValue_[SHA256_DIGEST_LENGTH];
+    SHA256_CTX preKeyHash_;
+  };
+
+  /**
+   * An immutable set of ticket keys. Built off to the side during rotation
+   * and published wholesale; never mutated after publication.
+   */
+  struct KeySet {
+    std::string encryptionKeyName;
+    std::unordered_map<std::string, std::unique_ptr<TLSTicketKey>>
+        ticketKeyMap;
   };
 
-  bool insertSeed(const std::string& seedInput, TLSTicketSeedType type);
+  static bool insertSeed(
+      KeySet& keySet,
+      const std::string& seedInput,
+      TLSTicketSeedType type);
+
+  /**
+   * Locate the key for encrypting a new ticket within the given snapshot
+   */
+  static const TLSTicketKey* findEncryptionKey(const KeySet& keySet);
 
   /**
-   * Locate the key for encrypting a new ticket
+   * Locate a key for decrypting a ticket with the given keyName within the
+   * given snapshot
    */
-  TLSTicketKey* findEncryptionKey();
+  static const TLSTicketKey* findDecryptionKey(
+      const KeySet& keySet,
+      const std::string& keyName);
 
   /**
-   * Locate a key for decrypting a ticket with the given keyName
+   * Salt the given key for one ticket and initialize the cipher and HMAC
+   * contexts; shared by the per-ticket callbacks and decryptBatch
    */
-  TLSTicketKey* findDecryptionKey(const std::string& keyName);
+  static void initTicketCryptoState(
+      const TLSTicketKey* key,
+      unsigned char* keyName,
+      unsigned char* iv,
+      EVP_CIPHER_CTX* cipherCtx,
+      HMAC_CTX* hmacCtx,
+      int encrypt);
 
   /**
    * Record the rotation of the ticket seeds with a new set
@@ -186,8 +254,7 @@ class TLSTicketKeyManager : public folly::OpenSSLTicketHandler {
       const std::vector<std::string>& currentSeeds,
       const std::vector<std::string>& newSeeds);
 
-  std::string encryptionKeyName_;
-  std::unordered_map<std::string, std::unique_ptr<TLSTicketKey>> ticketKeyMap_;
+  folly::atomic_shared_ptr<const KeySet> keySet_;
   SSLStats* stats_{nullptr};
 };
 using TicketSeedHandler = TLSTicketKeyManager;
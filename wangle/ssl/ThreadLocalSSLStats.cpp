@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/ThreadLocalSSLStats.h>
+
+namespace wangle {
+
+void ThreadLocalSSLStats::recordSSLAcceptLatency(int64_t latency) noexcept {
+  if (latency >= 0) {
+    acceptLatencySumMs_.increment(latency);
+    acceptLatencyCount_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordTLSTicket(
+    bool ticketNew,
+    bool ticketHit) noexcept {
+  if (ticketNew) {
+    ticketsNew_.increment(1);
+  } else if (ticketHit) {
+    ticketsHit_.increment(1);
+  } else {
+    ticketsMiss_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordSSLSession(
+    bool sessionNew,
+    bool sessionHit,
+    bool foreign) noexcept {
+  if (sessionNew) {
+    sessionsNew_.increment(1);
+  } else if (sessionHit) {
+    sessionsHit_.increment(1);
+    if (foreign) {
+      sessionsForeignHit_.increment(1);
+    }
+  } else {
+    sessionsMiss_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordSSLSessionRemove() noexcept {
+  sessionRemoves_.increment(1);
+}
+
+void ThreadLocalSSLStats::recordSSLSessionFree(uint32_t freed) noexcept {
+  sessionsFreed_.increment(freed);
+}
+
+void ThreadLocalSSLStats::recordSSLSessionSetError(uint32_t) noexcept {
+  sessionSetErrors_.increment(1);
+}
+
+void ThreadLocalSSLStats::recordSSLSessionGetError(uint32_t) noexcept {
+  sessionGetErrors_.increment(1);
+}
+
+void ThreadLocalSSLStats::recordClientRenegotiation() noexcept {
+  clientRenegotiations_.increment(1);
+}
+
+void ThreadLocalSSLStats::recordSSLClientCertificateMismatch() noexcept {
+  clientCertMismatches_.increment(1);
+}
+
+void ThreadLocalSSLStats::recordTLSTicketRotation(bool valid) noexcept {
+  if (valid) {
+    ticketRotationsValid_.increment(1);
+  } else {
+    ticketRotationsInvalid_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordSSLLocalCacheShardStats(
+    uint32_t /* shard */,
+    uint64_t hits,
+    uint64_t misses,
+    uint64_t evictions) noexcept {
+  localCacheShardHits_.increment(hits);
+  localCacheShardMisses_.increment(misses);
+  localCacheShardEvictions_.increment(evictions);
+}
+
+void ThreadLocalSSLStats::recordSSLHandshakeLatency(
+    int64_t latencyMs,
+    bool offloaded) noexcept {
+  if (latencyMs >= 0) {
+    handshakeLatencySumMs_.increment(latencyMs);
+    handshakeLatencyCount_.increment(1);
+  }
+  if (offloaded) {
+    handshakesOffloaded_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordKTLSOffload(bool success) noexcept {
+  if (success) {
+    ktlsOffloadSuccesses_.increment(1);
+  } else {
+    ktlsOffloadFailures_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordHandshakeRateLimited() noexcept {
+  handshakesRateLimited_.increment(1);
+}
+
+void ThreadLocalSSLStats::recordSSLUpstreamConnection(
+    bool handshake) noexcept {
+  upstreamConnections_.increment(1);
+  if (handshake) {
+    upstreamHandshakes_.increment(1);
+  }
+}
+
+void ThreadLocalSSLStats::recordSSLUpstreamConnectionError(
+    bool verifyError) noexcept {
+  upstreamConnectionErrors_.increment(1);
+  if (verifyError) {
+    upstreamVerifyErrors_.increment(1);
+  }
+}
+
+ThreadLocalSSLStats::Snapshot ThreadLocalSSLStats::getSnapshot() const {
+  Snapshot snapshot;
+  snapshot.acceptLatencySumMs = acceptLatencySumMs_.readFull();
+  snapshot.acceptLatencyCount = acceptLatencyCount_.readFull();
+  snapshot.ticketsNew = ticketsNew_.readFull();
+  snapshot.ticketsHit = ticketsHit_.readFull();
+  snapshot.ticketsMiss = ticketsMiss_.readFull();
+  snapshot.sessionsNew = sessionsNew_.readFull();
+  snapshot.sessionsHit = sessionsHit_.readFull();
+  snapshot.sessionsForeignHit = sessionsForeignHit_.readFull();
+  snapshot.sessionsMiss = sessionsMiss_.readFull();
+  snapshot.sessionRemoves = sessionRemoves_.readFull();
+  snapshot.sessionsFreed = sessionsFreed_.readFull();
+  snapshot.sessionSetErrors = sessionSetErrors_.readFull();
+  snapshot.sessionGetErrors = sessionGetErrors_.readFull();
+  snapshot.clientRenegotiations = clientRenegotiations_.readFull();
+  snapshot.clientCertMismatches = clientCertMismatches_.readFull();
+  snapshot.ticketRotationsValid = ticketRotationsValid_.readFull();
+  snapshot.ticketRotationsInvalid = ticketRotationsInvalid_.readFull();
+  snapshot.localCacheShardHits = localCacheShardHits_.readFull();
+  snapshot.localCacheShardMisses = localCacheShardMisses_.readFull();
+  snapshot.localCacheShardEvictions = localCacheShardEvictions_.readFull();
+  snapshot.handshakeLatencySumMs = handshakeLatencySumMs_.readFull();
+  snapshot.handshakeLatencyCount = handshakeLatencyCount_.readFull();
+  snapshot.handshakesOffloaded = handshakesOffloaded_.readFull();
+  snapshot.ktlsOffloadSuccesses = ktlsOffloadSuccesses_.readFull();
+  snapshot.ktlsOffloadFailures = ktlsOffloadFailures_.readFull();
+  snapshot.handshakesRateLimited = handshakesRateLimited_.readFull();
+  snapshot.upstreamConnections = upstreamConnections_.readFull();
+  snapshot.upstreamHandshakes = upstreamHandshakes_.readFull();
+  snapshot.upstreamConnectionErrors = upstreamConnectionErrors_.readFull();
+  snapshot.upstreamVerifyErrors = upstreamVerifyErrors_.readFull();
+  return snapshot;
+}
+
+} // namespace wangle
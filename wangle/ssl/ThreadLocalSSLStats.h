@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/ThreadCachedInt.h>
+#include <wangle/ssl/SSLStats.h>
+
+namespace wangle {
+
+/**
+ * SSLStats implementation backed by per-thread counter caches.
+ *
+ * The record methods run on handshake hot paths from every IO thread;
+ * an implementation backed by shared atomics bounces the counter cache
+ * lines across cores on every increment. Here each increment lands in
+ * a folly::ThreadCachedInt's thread-local cache — unsynchronized
+ * arithmetic — and the caches fold into the shared totals only when a
+ * cache fills or a sampling read flushes them via getSnapshot().
+ *
+ * Snapshot reads pay the aggregation cost instead, which is the right
+ * trade for counters written 40k times a second and read once a
+ * minute. Counts are monotonic totals since construction; rates come
+ * from differencing successive snapshots.
+ */
+class ThreadLocalSSLStats : public SSLStats {
+ public:
+  struct Snapshot {
+    // downstream
+    uint64_t acceptLatencySumMs{0};
+    uint64_t acceptLatencyCount{0};
+    uint64_t ticketsNew{0};
+    uint64_t ticketsHit{0};
+    uint64_t ticketsMiss{0};
+    uint64_t sessionsNew{0};
+    uint64_t sessionsHit{0};
+    uint64_t sessionsForeignHit{0};
+    uint64_t sessionsMiss{0};
+    uint64_t sessionRemoves{0};
+    uint64_t sessionsFreed{0};
+    uint64_t sessionSetErrors{0};
+    uint64_t sessionGetErrors{0};
+    uint64_t clientRenegotiations{0};
+    uint64_t clientCertMismatches{0};
+    uint64_t ticketRotationsValid{0};
+    uint64_t ticketRotationsInvalid{0};
+    uint64_t localCacheShardHits{0};
+    uint64_t localCacheShardMisses{0};
+    uint64_t localCacheShardEvictions{0};
+    uint64_t handshakeLatencySumMs{0};
+    uint64_t handshakeLatencyCount{0};
+    uint64_t handshakesOffloaded{0};
+    uint64_t ktlsOffloadSuccesses{0};
+    uint64_t ktlsOffloadFailures{0};
+    uint64_t handshakesRateLimited{0};
+
+    // upstream
+    uint64_t upstreamConnections{0};
+    uint64_t upstreamHandshakes{0};
+    uint64_t upstreamConnectionErrors{0};
+    uint64_t upstreamVerifyErrors{0};
+  };
+
+  void recordSSLAcceptLatency(int64_t latency) noexcept override;
+  void recordTLSTicket(bool ticketNew, bool ticketHit) noexcept override;
+  void recordSSLSession(
+      bool sessionNew,
+      bool sessionHit,
+      bool foreign) noexcept override;
+  void recordSSLSessionRemove() noexcept override;
+  void recordSSLSessionFree(uint32_t freed) noexcept override;
+  void recordSSLSessionSetError(uint32_t err) noexcept override;
+  void recordSSLSessionGetError(uint32_t err) noexcept override;
+  void recordClientRenegotiation() noexcept override;
+  void recordSSLClientCertificateMismatch() noexcept override;
+  void recordTLSTicketRotation(bool valid) noexcept override;
+  void recordSSLLocalCacheShardStats(
+      uint32_t shard,
+      uint64_t hits,
+      uint64_t misses,
+      uint64_t evictions) noexcept override;
+  void recordSSLHandshakeLatency(
+      int64_t latencyMs,
+      bool offloaded) noexcept override;
+  void recordKTLSOffload(bool success) noexcept override;
+  void recordHandshakeRateLimited() noexcept override;
+  void recordSSLUpstreamConnection(bool handshake) noexcept override;
+  void recordSSLUpstreamConnectionError(bool verifyError) noexcept override;
+
+  // Flushes every thread's caches and returns the current totals.
+  Snapshot getSnapshot() const;
+
+ private:
+  using Counter = folly::ThreadCachedInt<uint64_t>;
+
+  // downstream
+  Counter acceptLatencySumMs_;
+  Counter acceptLatencyCount_;
+  Counter ticketsNew_;
+  Counter ticketsHit_;
+  Counter ticketsMiss_;
+  Counter sessionsNew_;
+  Counter sessionsHit_;
+  Counter sessionsForeignHit_;
+  Counter sessionsMiss_;
+  Counter sessionRemoves_;
+  Counter sessionsFreed_;
+  Counter sessionSetErrors_;
+  Counter sessionGetErrors_;
+  Counter clientRenegotiations_;
+  Counter clientCertMismatches_;
+  Counter ticketRotationsValid_;
+  Counter ticketRotationsInvalid_;
+  Counter localCacheShardHits_;
+  Counter localCacheShardMisses_;
+  Counter localCacheShardEvictions_;
+  Counter handshakeLatencySumMs_;
+  Counter handshakeLatencyCount_;
+  Counter handshakesOffloaded_;
+  Counter ktlsOffloadSuccesses_;
+  Counter ktlsOffloadFailures_;
+  Counter handshakesRateLimited_;
+
+  // upstream
+  Counter upstreamConnections_;
+  Counter upstreamHandshakes_;
+  Counter upstreamConnectionErrors_;
+  Counter upstreamVerifyErrors_;
+};
+
+} // namespace wangle
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/CertFileRegistry.h>
+
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Stdlib.h>
+
+using namespace folly;
+using namespace wangle;
+
+class CertFileRegistryTest : public testing::Test {
+ public:
+  void SetUp() override {
+    char certTemp[] = {"/tmp/certFile-XXXXXX"};
+    File(mkstemp(certTemp), true);
+    certFile = certTemp;
+    char keyTemp[] = {"/tmp/keyFile-XXXXXX"};
+    File(mkstemp(keyTemp), true);
+    keyFile = keyTemp;
+  }
+
+  void TearDown() override {
+    remove(certFile.c_str());
+    remove(keyFile.c_str());
+  }
+
+  CertFileRegistry registry;
+  std::string certFile;
+  std::string keyFile;
+};
+
+TEST_F(CertFileRegistryTest, SharesBufferWhileUnchanged) {
+  CHECK(writeFile(std::string("cert contents"), certFile.c_str()));
+  auto first = registry.getFileContents(certFile);
+  auto second = registry.getFileContents(certFile);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ("cert contents", *first);
+  EXPECT_EQ(1, registry.size());
+}
+
+TEST_F(CertFileRegistryTest, RereadsChangedFile) {
+  CHECK(writeFile(std::string("old contents"), certFile.c_str()));
+  auto old = registry.getFileContents(certFile);
+  // Different length, so the stat freshness check must notice even if
+  // both writes land within the same mtime tick.
+  CHECK(writeFile(std::string("new, longer contents"), certFile.c_str()));
+  auto fresh = registry.getFileContents(certFile);
+  EXPECT_NE(old.get(), fresh.get());
+  EXPECT_EQ("old contents", *old);
+  EXPECT_EQ("new, longer contents", *fresh);
+}
+
+TEST_F(CertFileRegistryTest, DedupsIdenticalFilesAcrossPaths) {
+  CHECK(writeFile(std::string("same contents"), certFile.c_str()));
+  CHECK(writeFile(std::string("same contents"), keyFile.c_str()));
+  auto viaCertPath = registry.getFileContents(certFile);
+  auto viaKeyPath = registry.getFileContents(keyFile);
+  EXPECT_EQ(viaCertPath.get(), viaKeyPath.get());
+  EXPECT_EQ(2, registry.size());
+}
+
+TEST_F(CertFileRegistryTest, ThrowsOnMissingFile) {
+  EXPECT_THROW(
+      registry.getFileContents("/tmp/doesnotexist-cert-registry"),
+      std::runtime_error);
+}
+
+TEST_F(CertFileRegistryTest, PrefetchWarmsCache) {
+  CHECK(writeFile(std::string("cert contents"), certFile.c_str()));
+  CHECK(writeFile(std::string("key contents"), keyFile.c_str()));
+  CPUThreadPoolExecutor executor(2);
+  // Missing paths are skipped, not thrown, so the real load can report
+  // them with its per-certificate error message.
+  registry.prefetch(
+      {certFile, keyFile, "/tmp/doesnotexist-cert-registry"}, &executor);
+  EXPECT_EQ(2, registry.size());
+  EXPECT_EQ("cert contents", *registry.getFileContents(certFile));
+  EXPECT_EQ("key contents", *registry.getFileContents(keyFile));
+}
+
+TEST_F(CertFileRegistryTest, ProcessInstanceIsShared) {
+  auto a = CertFileRegistry::getInstance();
+  auto b = CertFileRegistry::getInstance();
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ(a.get(), b.get());
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/ClientHelloFingerprintStats.h>
+
+#include <thread>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly::ssl;
+using namespace wangle;
+
+namespace {
+
+ClientHelloInfo makeHello() {
+  ClientHelloInfo info;
+  info.clientHelloMajorVersion_ = 3;
+  info.clientHelloMinorVersion_ = 3;
+  info.clientHelloCiphers_ = {0x1301, 0x1302, 0xc02b};
+  info.clientHelloExtensions_ = {
+      TLSExtension::SERVER_NAME,
+      TLSExtension::SESSION_TICKET,
+      TLSExtension::SIGNATURE_ALGORITHMS};
+  info.clientHelloSigAlgs_ = {
+      {HashAlgorithm::SHA256, SignatureAlgorithm::RSA}};
+  return info;
+}
+
+} // namespace
+
+TEST(ClientHelloFingerprintStats, CountersAndFingerprints) {
+  ClientHelloFingerprintStats stats;
+  auto hello = makeHello();
+  stats.recordClientHello(hello);
+  stats.recordClientHello(hello);
+  stats.recordMatch();
+  stats.recordAbsentHostname();
+  stats.recordCertCrypto(
+      CertCrypto::SHA1_SIGNATURE, CertCrypto::SHA1_SIGNATURE);
+  stats.recordCertCrypto(
+      CertCrypto::BEST_AVAILABLE, CertCrypto::BEST_AVAILABLE);
+
+  auto agg = stats.aggregate();
+  EXPECT_EQ(agg.hellos, 2);
+  EXPECT_EQ(agg.matches, 1);
+  EXPECT_EQ(agg.absentHostname, 1);
+  EXPECT_EQ(agg.notMatches, 0);
+  EXPECT_EQ(agg.weakCertCrypto, 1);
+  EXPECT_EQ(
+      agg.extensionCounts[static_cast<size_t>(TLSExtension::SERVER_NAME)], 2);
+  // 3 ciphers land in the first bucket
+  EXPECT_EQ(agg.cipherCountBuckets[0], 2);
+  ASSERT_EQ(agg.fingerprints.size(), 1);
+  EXPECT_EQ(
+      agg.fingerprints[0].first,
+      ClientHelloFingerprintStats::computeFingerprint(hello));
+  EXPECT_EQ(agg.fingerprints[0].second, 2);
+  EXPECT_EQ(agg.fingerprintOverflows, 0);
+}
+
+TEST(ClientHelloFingerprintStats, FingerprintDistinguishesClients) {
+  auto hello = makeHello();
+  auto other = makeHello();
+  other.clientHelloCiphers_.push_back(0xcca9);
+  EXPECT_NE(
+      ClientHelloFingerprintStats::computeFingerprint(hello),
+      ClientHelloFingerprintStats::computeFingerprint(other));
+
+  // reordering the extension list changes the fingerprint, as with JA3
+  auto reordered = makeHello();
+  std::swap(
+      reordered.clientHelloExtensions_[0], reordered.clientHelloExtensions_[1]);
+  EXPECT_NE(
+      ClientHelloFingerprintStats::computeFingerprint(hello),
+      ClientHelloFingerprintStats::computeFingerprint(reordered));
+}
+
+TEST(ClientHelloFingerprintStats, AggregatesAcrossThreads) {
+  ClientHelloFingerprintStats stats;
+  auto hello = makeHello();
+  stats.recordClientHello(hello);
+  std::thread other([&] { stats.recordClientHello(hello); });
+  other.join();
+
+  auto agg = stats.aggregate();
+  EXPECT_EQ(agg.hellos, 2);
+  ASSERT_EQ(agg.fingerprints.size(), 1);
+  EXPECT_EQ(agg.fingerprints[0].second, 2);
+}
+
+TEST(ClientHelloFingerprintStats, ExtensionFoldAndOverflow) {
+  ClientHelloFingerprintStats stats;
+  // an extension id beyond the table folds into the last slot
+  ClientHelloInfo info;
+  info.clientHelloExtensions_ = {TLSExtension::RENEGOTIATION_INFO};
+  stats.recordClientHello(info);
+  auto agg = stats.aggregate();
+  EXPECT_EQ(
+      agg.extensionCounts[ClientHelloFingerprintStats::kExtensionSlots - 1],
+      1);
+}
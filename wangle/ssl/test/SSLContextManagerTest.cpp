@@ -505,6 +505,36 @@ TEST(SSLContextManagerTest, TestAlpnNotAllowMismatch) {
   ASSERT_FALSE(ctx->getAlpnAllowMismatch());
 }
 
+#ifdef SSL_MODE_ASYNC
+TEST(SSLContextManagerTest, TestAsyncCryptoMode) {
+  SSLContextManagerForTest sslCtxMgr(
+      "vip_ssl_context_manager_test_", true, nullptr);
+  SSLContextConfig ctxConfig;
+  ctxConfig.asyncCryptoEnabled = true;
+  ctxConfig.addCertificateBuf(kTestCert1PEM, kTestCert1Key);
+
+  SSLCacheOptions cacheOptions;
+  SocketAddress addr;
+
+  sslCtxMgr.addSSLContextConfig(
+      ctxConfig, cacheOptions, nullptr, addr, nullptr);
+
+  SSLContextKey key("test.com", CertCrypto::BEST_AVAILABLE);
+  auto ctx = sslCtxMgr.getSSLCtx(key);
+  ASSERT_NE(ctx, nullptr);
+  EXPECT_TRUE(SSL_CTX_get_mode(ctx->getSSLCtx()) & SSL_MODE_ASYNC);
+
+  SSLContextConfig syncConfig;
+  syncConfig.addCertificateBuf(kTestCert2PEM, kTestCert2Key);
+  sslCtxMgr.addSSLContextConfig(
+      syncConfig, cacheOptions, nullptr, addr, nullptr);
+  SSLContextKey syncKey("test2.com", CertCrypto::BEST_AVAILABLE);
+  auto syncCtx = sslCtxMgr.getSSLCtx(syncKey);
+  ASSERT_NE(syncCtx, nullptr);
+  EXPECT_FALSE(SSL_CTX_get_mode(syncCtx->getSSLCtx()) & SSL_MODE_ASYNC);
+}
+#endif
+
 TEST(SSLContextManagerTest, TestSingleClientCAFileSet) {
   SSLContextManagerForTest sslCtxMgr(
       "vip_ssl_context_manager_test_", true, nullptr);
@@ -22,6 +22,39 @@
 using namespace folly;
 using namespace wangle;
 
+namespace {
+
+// Provider that counts singleton fetches; getFutures is left on the
+// default per-key fallback.
+class CountingCacheProvider : public SSLCacheProvider {
+ public:
+  bool setAsync(const std::string&, const std::string&, std::chrono::seconds)
+      override {
+    return true;
+  }
+
+  Future<ssl::SSLSessionUniquePtr> getFuture(
+      const std::string& /* sessionId */) override {
+    ++gets;
+    return makeFuture(ssl::SSLSessionUniquePtr());
+  }
+
+  uint32_t gets{0};
+};
+
+} // namespace
+
+TEST(SSLCacheProviderTest, TestGetFuturesFallback) {
+  CountingCacheProvider provider;
+  std::vector<std::string> ids{"a", "b", "c"};
+  auto futures = provider.getFutures(ids);
+  ASSERT_EQ(3, futures.size());
+  EXPECT_EQ(3, provider.gets);
+  for (auto& f : futures) {
+    EXPECT_EQ(nullptr, std::move(f).get());
+  }
+}
+
 TEST(ShardedLocalSSLSessionCacheTest, TestHash) {
   uint32_t buckets = 10;
   uint32_t cacheSize = 20;
@@ -33,3 +66,70 @@ TEST(ShardedLocalSSLSessionCacheTest, TestHash) {
   ShardedLocalSSLSessionCache cache(buckets, cacheSize, cacheCullSize);
   cache.hash(std::string((char*)id.data(), id.size()));
 }
+
+TEST(ShardedLocalSSLSessionCacheTest, TestShardStats) {
+  uint32_t buckets = 4;
+  uint32_t cacheSize = 20;
+  uint32_t cacheCullSize = 100;
+
+  std::array<uint8_t, 32> id;
+  Random::secureRandom(id.data(), id.size());
+  std::string sessionId((char*)id.data(), id.size());
+
+  ShardedLocalSSLSessionCache cache(buckets, cacheSize, cacheCullSize);
+  EXPECT_EQ(nullptr, cache.lookupSession(sessionId));
+  EXPECT_EQ(nullptr, cache.lookupSession(sessionId));
+
+  auto stats = cache.getShardStats(cache.hash(sessionId));
+  EXPECT_EQ(0, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(0, stats.evictions);
+}
+
+namespace {
+
+SSL_SESSION* makeSession(const std::string& id, long time, long timeout) {
+  auto* session = SSL_SESSION_new();
+  CHECK(session);
+  SSL_SESSION_set1_id(
+      session,
+      reinterpret_cast<const unsigned char*>(id.data()),
+      id.size());
+  SSL_SESSION_set_protocol_version(session, TLS1_2_VERSION);
+  SSL_SESSION_set_time(session, time);
+  SSL_SESSION_set_timeout(session, timeout);
+  return session;
+}
+
+} // namespace
+
+TEST(ShardedLocalSSLSessionCacheTest, SerializeRoundTrip) {
+  uint32_t buckets = 4;
+  uint32_t cacheSize = 20;
+  uint32_t cacheCullSize = 100;
+
+  const std::string freshId(32, 'a');
+  const std::string staleId(32, 'b');
+  const auto now = std::time(nullptr);
+
+  ShardedLocalSSLSessionCache cache(buckets, cacheSize, cacheCullSize);
+  cache.storeSession(freshId, makeSession(freshId, now, 3600), nullptr);
+  cache.storeSession(staleId, makeSession(staleId, now - 7200, 60), nullptr);
+
+  auto serialized = cache.serializeSessions();
+  EXPECT_EQ(2, serialized.size());
+
+  // Only the session still within its own expiry survives the load.
+  ShardedLocalSSLSessionCache warmed(buckets, cacheSize, cacheCullSize);
+  EXPECT_EQ(1, warmed.loadSerializedSessions(serialized));
+  EXPECT_EQ(nullptr, warmed.lookupSession(staleId));
+  auto* session = warmed.lookupSession(freshId);
+  ASSERT_NE(nullptr, session);
+  SSL_SESSION_free(session);
+
+  // Garbage entries are skipped, not fatal.
+  EXPECT_EQ(0, warmed.loadSerializedSessions(folly::dynamic::object()));
+  folly::dynamic junk = folly::dynamic::array;
+  junk.push_back(folly::dynamic::object("id", "zz")("session", "zz"));
+  EXPECT_EQ(0, warmed.loadSerializedSessions(junk));
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/SSLUtil.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+TEST(SSLUtilTest, InternStringSharesEqualValues) {
+  auto a = SSLUtil::internString("ECDHE-ECDSA-AES128-GCM-SHA256");
+  auto b = SSLUtil::internString(
+      folly::StringPiece("ECDHE-ECDSA-AES128-GCM-SHA256"));
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_EQ("ECDHE-ECDSA-AES128-GCM-SHA256", *a);
+}
+
+TEST(SSLUtilTest, InternStringDistinguishesValues) {
+  auto a = SSLUtil::internString("RSA-SHA256");
+  auto b = SSLUtil::internString("ECDSA-SHA256");
+  EXPECT_NE(a.get(), b.get());
+}
+
+TEST(SSLUtilTest, InternStringNullAndEmpty) {
+  EXPECT_EQ(nullptr, SSLUtil::internString(nullptr));
+  auto empty = SSLUtil::internString("");
+  ASSERT_NE(nullptr, empty);
+  EXPECT_TRUE(empty->empty());
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/ServerSSLContext.h>
+
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Stdlib.h>
+#include <wangle/ssl/SSLContextConfig.h>
+
+using namespace folly;
+using namespace wangle;
+
+TEST(ServerSSLContextTest, OcspStapleUpdateAndGet) {
+  ServerSSLContext ctx;
+  EXPECT_EQ(ctx.getOcspStaple(), nullptr);
+
+  auto expiry = std::chrono::system_clock::now() + std::chrono::hours(1);
+  ctx.updateOcspStaple("staple-one", expiry);
+
+  auto staple = ctx.getOcspStaple();
+  ASSERT_NE(staple, nullptr);
+  EXPECT_EQ(staple->responseDer, "staple-one");
+  EXPECT_EQ(staple->expiry, expiry);
+
+  // A swap replaces the served staple but leaves earlier snapshots
+  // (as an in-flight handshake would hold) intact.
+  ctx.updateOcspStaple("staple-two", expiry);
+  EXPECT_EQ(ctx.getOcspStaple()->responseDer, "staple-two");
+  EXPECT_EQ(staple->responseDer, "staple-one");
+}
+
+TEST(ServerSSLContextTest, OcspSetupLoadsStapleFile) {
+  char stapleTemp[] = {"/tmp/ocspStaple-XXXXXX"};
+  File file(mkstemp(stapleTemp), true);
+  std::string path = stapleTemp;
+  ASSERT_TRUE(writeFile(std::string("not-a-real-response"), path.c_str()));
+
+  SSLContextConfig config;
+  config.ocspResponseFile = path;
+  // Keep the unit test single-threaded.
+  config.ocspRefreshInterval = std::chrono::seconds(0);
+
+  ServerSSLContext ctx;
+  ctx.setupOcspStapling(config, nullptr);
+
+  auto staple = ctx.getOcspStaple();
+  ASSERT_NE(staple, nullptr);
+  EXPECT_EQ(staple->responseDer, "not-a-real-response");
+  // Unparsable responses get the conservative fallback validity.
+  EXPECT_GT(staple->expiry, std::chrono::system_clock::now());
+  unlink(path.c_str());
+}
+
+TEST(ServerSSLContextTest, ParseOcspExpiryFallsBack) {
+  auto before = std::chrono::system_clock::now();
+  auto expiry = ServerSSLContext::parseOcspExpiry("garbage");
+  EXPECT_GE(expiry, before + std::chrono::hours(23));
+  EXPECT_LE(expiry, before + std::chrono::hours(25));
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/SharedMemorySSLCacheProvider.h>
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+TEST(SharedMemorySSLCacheProvider, SetAndGetAcrossInstances) {
+  folly::test::TemporaryFile segment;
+  SharedMemorySSLCacheProvider writer(segment.path().string(), 128);
+  ASSERT_TRUE(
+      writer.setAsync("session-1", "serialized", std::chrono::seconds(60)));
+
+  // A second instance attached to the same segment — a sibling process,
+  // as far as the table is concerned — sees the entry.
+  SharedMemorySSLCacheProvider reader(segment.path().string(), 128);
+  auto found = reader.lookupSerialized("session-1");
+  ASSERT_TRUE(found.hasValue());
+  EXPECT_EQ(*found, "serialized");
+}
+
+TEST(SharedMemorySSLCacheProvider, MissAndExpiry) {
+  folly::test::TemporaryFile segment;
+  SharedMemorySSLCacheProvider cache(segment.path().string(), 128);
+
+  EXPECT_FALSE(cache.lookupSerialized("absent").hasValue());
+  EXPECT_TRUE(cache.getFuture("absent").result().hasException());
+
+  // An entry stored already expired is a miss.
+  ASSERT_TRUE(
+      cache.setAsync("session-1", "serialized", std::chrono::seconds(0)));
+  EXPECT_FALSE(cache.lookupSerialized("session-1").hasValue());
+}
+
+TEST(SharedMemorySSLCacheProvider, RejectsOversizeRecords) {
+  folly::test::TemporaryFile segment;
+  SharedMemorySSLCacheProvider cache(segment.path().string(), 128);
+
+  std::string hugeValue(1 << 20, 'x');
+  EXPECT_FALSE(
+      cache.setAsync("session-1", hugeValue, std::chrono::seconds(60)));
+  std::string hugeKey(1024, 'k');
+  EXPECT_FALSE(cache.setAsync(hugeKey, "value", std::chrono::seconds(60)));
+}
+
+TEST(SharedMemorySSLCacheProvider, ReinitializationShedsEntries) {
+  folly::test::TemporaryFile segment;
+  SharedMemorySSLCacheProvider first(segment.path().string(), 128);
+  ASSERT_TRUE(
+      first.setAsync("session-1", "serialized", std::chrono::seconds(60)));
+
+  // Attaching with a different geometry re-initializes the segment and
+  // bumps the generation, shedding the old entries.
+  SharedMemorySSLCacheProvider resized(segment.path().string(), 256);
+  EXPECT_FALSE(resized.lookupSerialized("session-1").hasValue());
+}
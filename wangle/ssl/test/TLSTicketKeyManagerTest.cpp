@@ -94,6 +94,47 @@ TEST(TLSTicketKeyManager, TestValidateTicketSeedsFailure) {
   manager.setTLSTicketKeySeeds(newOld, newCurr, newNext);
 }
 
+TEST(TLSTicketKeyManager, TestDecryptBatch) {
+  wangle::TLSTicketKeyManager manager;
+  manager.setTLSTicketKeySeeds({}, {"68"}, {});
+
+  // Encrypt two tickets the way OpenSSL would during full handshakes.
+  unsigned char name1[16], name2[16];
+  unsigned char iv1[EVP_MAX_IV_LENGTH], iv2[EVP_MAX_IV_LENGTH];
+  auto* encCipher = EVP_CIPHER_CTX_new();
+  auto* encHmac = HMAC_CTX_new();
+  ASSERT_EQ(
+      1, manager.ticketCallback(nullptr, name1, iv1, encCipher, encHmac, 1));
+  ASSERT_EQ(
+      1, manager.ticketCallback(nullptr, name2, iv2, encCipher, encHmac, 1));
+
+  // Both decrypt in one batch.
+  auto* cipher1 = EVP_CIPHER_CTX_new();
+  auto* cipher2 = EVP_CIPHER_CTX_new();
+  auto* hmac1 = HMAC_CTX_new();
+  auto* hmac2 = HMAC_CTX_new();
+  std::vector<wangle::TLSTicketKeyManager::PendingTicketDecrypt> batch(2);
+  batch[0] = {name1, iv1, cipher1, hmac1, 0};
+  batch[1] = {name2, iv2, cipher2, hmac2, 0};
+  EXPECT_EQ(2, manager.decryptBatch(batch));
+  EXPECT_EQ(1, batch[0].result);
+  EXPECT_EQ(1, batch[1].result);
+
+  // An unknown key name fails only its own entry.
+  unsigned char bogusName[16] = {};
+  batch[1].keyName = bogusName;
+  EXPECT_EQ(1, manager.decryptBatch(batch));
+  EXPECT_EQ(1, batch[0].result);
+  EXPECT_EQ(0, batch[1].result);
+
+  EVP_CIPHER_CTX_free(encCipher);
+  EVP_CIPHER_CTX_free(cipher1);
+  EVP_CIPHER_CTX_free(cipher2);
+  HMAC_CTX_free(encHmac);
+  HMAC_CTX_free(hmac1);
+  HMAC_CTX_free(hmac2);
+}
+
 TEST(TLSTicketKeyManager, TestValidateTicketSeedsSubsetPass) {
   MockSSLStats stats;
   InSequence inSequence;
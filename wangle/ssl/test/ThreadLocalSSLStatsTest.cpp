@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/ssl/ThreadLocalSSLStats.h>
+
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace wangle;
+
+TEST(ThreadLocalSSLStats, ClassifiesSessionOutcomes) {
+  ThreadLocalSSLStats stats;
+  stats.recordSSLSession(true, false, false); // new
+  stats.recordSSLSession(false, true, false); // local hit
+  stats.recordSSLSession(false, true, true); // foreign hit
+  stats.recordSSLSession(false, false, false); // miss
+
+  auto snapshot = stats.getSnapshot();
+  EXPECT_EQ(1, snapshot.sessionsNew);
+  EXPECT_EQ(2, snapshot.sessionsHit);
+  EXPECT_EQ(1, snapshot.sessionsForeignHit);
+  EXPECT_EQ(1, snapshot.sessionsMiss);
+}
+
+TEST(ThreadLocalSSLStats, AggregatesAcrossThreads) {
+  ThreadLocalSSLStats stats;
+  constexpr int kThreads = 8;
+  constexpr int kPerThread = 10000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&stats] {
+      for (int i = 0; i < kPerThread; ++i) {
+        stats.recordSSLAcceptLatency(2);
+        stats.recordTLSTicket(false, true);
+        stats.recordSSLUpstreamConnection(i % 2 == 0);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto snapshot = stats.getSnapshot();
+  EXPECT_EQ(kThreads * kPerThread, snapshot.acceptLatencyCount);
+  EXPECT_EQ(kThreads * kPerThread * 2, snapshot.acceptLatencySumMs);
+  EXPECT_EQ(kThreads * kPerThread, snapshot.ticketsHit);
+  EXPECT_EQ(kThreads * kPerThread, snapshot.upstreamConnections);
+  EXPECT_EQ(kThreads * kPerThread / 2, snapshot.upstreamHandshakes);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/test/Simulation.h>
+
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <wangle/acceptor/ConnectionManager.h>
+#include <wangle/channel/OutputBufferingHandler.h>
+#include <wangle/loadgen/LatencyHistogram.h>
+#include <wangle/channel/StaticPipeline.h>
+#include <wangle/channel/test/MockHandler.h>
+
+using namespace folly;
+using namespace std::chrono;
+using namespace wangle;
+using namespace testing;
+
+namespace {
+
+typedef StrictMock<MockHandlerAdapter<IOBufQueue&, std::unique_ptr<IOBuf>>>
+    MockBytesHandler;
+
+MATCHER_P(IOBufContains, str, "") {
+  return arg->moveToFbString() == str;
+}
+
+class SimConnection : public ManagedConnection {
+ public:
+  using UniquePtr = folly::DelayedDestructionUniquePtr<SimConnection>;
+
+  void timeoutExpired() noexcept override {}
+  void describe(std::ostream& os) const override {
+    os << "SimConnection";
+  }
+  bool isBusy() const override {
+    return true;
+  }
+  void notifyPendingShutdown() override {
+    notified = true;
+  }
+  void closeWhenIdle() override {
+    closed = true;
+  }
+  void dropConnection(const std::string& /* errorMsg */ = "") override {}
+  void dumpConnectionState(uint8_t /* loglevel */) override {}
+
+  bool notified{false};
+  bool closed{false};
+};
+
+} // namespace
+
+TEST(SimulationTest, FiresInDeadlineOrder) {
+  Simulation sim;
+  std::vector<int> order;
+  sim.runAfter(milliseconds(10), [&] { order.push_back(3); });
+  sim.runAfter(milliseconds(5), [&] { order.push_back(1); });
+  sim.runAfter(milliseconds(5), [&] { order.push_back(2); });
+
+  const auto start = sim.now();
+  sim.advance(milliseconds(20));
+
+  // Deadline order, FIFO among equal deadlines, and virtual time moved
+  // by exactly the advance.
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(sim.now() - start, milliseconds(20));
+}
+
+TEST(SimulationTest, FlushDeadlineOnVirtualTime) {
+  Simulation sim;
+  MockBytesHandler mockHandler;
+  EXPECT_CALL(mockHandler, attachPipeline(_));
+  OutputBufferingHandler handler;
+  handler.setMaxFlushLatency(milliseconds(1));
+  handler.setTimeoutManager(&sim);
+  auto pipeline = StaticPipeline<
+      IOBufQueue&,
+      std::unique_ptr<IOBuf>,
+      MockBytesHandler,
+      OutputBufferingHandler>::create(&mockHandler, &handler);
+  auto socket = AsyncSocket::newSocket(sim.getEventBase());
+  pipeline->setTransport(std::move(socket));
+
+  // No wall-clock wait: the 1ms flush deadline fires when virtual time
+  // crosses it, and not before.
+  auto f = pipeline->write(IOBuf::copyBuffer("hello"));
+  sim.advance(microseconds(500));
+  EXPECT_FALSE(f.isReady());
+
+  EXPECT_CALL(mockHandler, write_(_, IOBufContains("hello")));
+  sim.advance(microseconds(600));
+  EXPECT_TRUE(f.isReady());
+  EXPECT_EQ(handler.getFlushStats().deadlineFlushes, 1);
+
+  EXPECT_CALL(mockHandler, detachPipeline(_));
+  pipeline.reset();
+}
+
+TEST(SimulationTest, DrainIdleGraceOnVirtualTime) {
+  Simulation sim;
+  auto cm = ConnectionManager::makeUnique(
+      sim.getEventBase(), milliseconds(100), nullptr);
+  cm->setDrainTimeoutManager(&sim);
+  SimConnection::UniquePtr conn(new SimConnection());
+  cm->addConnection(conn.get());
+
+  // A two-hour idle grace: the notify phase runs promptly, the close
+  // phase only once virtual time crosses the grace.
+  cm->initiateGracefulShutdown(hours(2));
+  sim.drain();
+  EXPECT_TRUE(conn->notified);
+  EXPECT_FALSE(conn->closed);
+
+  sim.advance(hours(1));
+  EXPECT_FALSE(conn->closed);
+
+  sim.advance(hours(1) + milliseconds(1));
+  EXPECT_TRUE(conn->closed);
+
+  cm->removeConnection(conn.get());
+}
+
+TEST(SimulationTest, FastForwardsHoursAndRecordsDistribution) {
+  Simulation sim;
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; i++) {
+    sim.runAfter(seconds(i * 36), [&histogram, i] {
+      histogram.record(microseconds(i));
+    });
+  }
+
+  // Ten simulated hours pass in one call.
+  const auto start = sim.now();
+  sim.advance(hours(10));
+  EXPECT_EQ(sim.now() - start, hours(10));
+
+  EXPECT_EQ(histogram.count(), 1000);
+  EXPECT_EQ(histogram.max(), microseconds(1000));
+  // Histogram percentiles are accurate to the bucket width (~3%).
+  EXPECT_GE(histogram.percentile(50), microseconds(480));
+  EXPECT_LE(histogram.percentile(50), microseconds(520));
+}
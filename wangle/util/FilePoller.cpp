@@ -23,6 +23,14 @@
 #include <folly/Singleton.h>
 #include <sys/stat.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <folly/io/async/EventHandler.h>
+#include <folly/net/NetworkSocket.h>
+#endif
+
 namespace wangle {
 
 namespace {
@@ -41,12 +49,24 @@ class PollerContext {
     return scheduler;
   }
 
+#ifdef __linux__
+  // Shared by all pollers like the scheduler; pollers hang on to it so
+  // it keeps running even if this context is destroyed.
+  const std::shared_ptr<folly::ScopedEventBaseThread>& getInotifyThread() {
+    return inotifyThread;
+  }
+#endif
+
   uint64_t getNextId() {
     return nextPollerId++;
   }
 
  private:
   std::shared_ptr<folly::FunctionScheduler> scheduler;
+#ifdef __linux__
+  std::shared_ptr<folly::ScopedEventBaseThread> inotifyThread{
+      std::make_shared<folly::ScopedEventBaseThread>("file-watcher")};
+#endif
   std::atomic<uint64_t> nextPollerId;
 };
 
@@ -78,6 +98,10 @@ void FilePoller::init(std::chrono::milliseconds pollInterval) {
   }
   pollerId_ = context->getNextId();
   scheduler_ = context->getScheduler();
+#ifdef __linux__
+  inotifyThread_ = context->getInotifyThread();
+  initInotify();
+#endif
   scheduler_->addFunction(
       [this] { this->checkFiles(); },
       pollInterval,
@@ -88,21 +112,29 @@ void FilePoller::stop() {
   if (scheduler_) {
     scheduler_->cancelFunctionAndWait(folly::to<std::string>(pollerId_));
   }
+#ifdef __linux__
+  stopInotify();
+#endif
 }
 
 void FilePoller::checkFiles() noexcept {
   std::lock_guard<std::mutex> lg(filesMutex_);
   ThreadProtector tp;
   for (auto& fData : fileDatum_) {
-    auto modData = getFileModData(fData.first);
-    auto& fileData = fData.second;
-    if (fileData.condition(fileData.modData, modData) && fileData.yCob) {
-      fileData.yCob();
-    } else if (fileData.nCob) {
-      fileData.nCob();
-    }
-    fileData.modData = modData;
+    checkFileLocked(fData.first, fData.second);
+  }
+}
+
+void FilePoller::checkFileLocked(
+    const std::string& fileName,
+    FileData& fileData) noexcept {
+  auto modData = getFileModData(fileName);
+  if (fileData.condition(fileData.modData, modData) && fileData.yCob) {
+    fileData.yCob();
+  } else if (fileData.nCob) {
+    fileData.nCob();
   }
+  fileData.modData = modData;
 }
 
 void FilePoller::initFileData(
@@ -127,6 +159,11 @@ void FilePoller::addFileToTrack(
     return;
   }
   std::lock_guard<std::mutex> lg(filesMutex_);
+#ifdef __linux__
+  if (fileDatum_.count(fileName) == 0) {
+    addWatch(fileName);
+  }
+#endif
   fileDatum_[fileName] = FileData(yCob, nCob, condition);
   initFileData(fileName, fileDatum_[fileName]);
 }
@@ -141,6 +178,11 @@ void FilePoller::removeFileToTrack(const std::string& fileName) {
     return;
   }
   std::lock_guard<std::mutex> lg(filesMutex_);
+#ifdef __linux__
+  if (fileDatum_.count(fileName) != 0) {
+    removeWatch(fileName);
+  }
+#endif
   fileDatum_.erase(fileName);
 }
 
@@ -173,4 +215,151 @@ FilePoller::FileModificationData FilePoller::getFileModData(
 
   return FileModificationData{true, system_time};
 }
+
+#ifdef __linux__
+
+namespace {
+
+// The poller watches the parent directory of a tracked path rather
+// than the path itself; a watch on the file would miss the
+// replace-by-rename pattern cert updaters use.
+std::string parentDir(const std::string& fileName) {
+  auto pos = fileName.rfind('/');
+  if (pos == std::string::npos) {
+    return "";
+  }
+  return pos == 0 ? "/" : fileName.substr(0, pos);
+}
+
+std::string joinDir(const std::string& dir, const char* name) {
+  if (dir.empty()) {
+    return name;
+  }
+  if (dir == "/") {
+    return "/" + std::string(name);
+  }
+  return dir + "/" + name;
+}
+
+} // namespace
+
+class FilePoller::InotifyHandler : public folly::EventHandler {
+ public:
+  InotifyHandler(FilePoller* poller, folly::EventBase* evb, int fd)
+      : folly::EventHandler(evb, folly::NetworkSocket::fromFd(fd)),
+        poller_(poller) {}
+
+  void handlerReady(uint16_t /*events*/) noexcept override {
+    poller_->onInotifyReadable();
+  }
+
+ private:
+  FilePoller* poller_;
+};
+
+void FilePoller::initInotify() {
+  inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd_ < 0) {
+    PLOG(WARNING) << "inotify_init1 failed; falling back to stat polling";
+    return;
+  }
+  auto evb = inotifyThread_->getEventBase();
+  inotifyHandler_ = std::make_unique<InotifyHandler>(this, evb, inotifyFd_);
+  // Registration has to happen in the watcher thread; the handler is
+  // guaranteed alive there because stopInotify() serializes behind this.
+  evb->runInEventBaseThread([handler = inotifyHandler_.get()] {
+    handler->registerHandler(
+        folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  });
+}
+
+void FilePoller::stopInotify() {
+  if (inotifyFd_ < 0) {
+    return;
+  }
+  inotifyThread_->getEventBase()->runInEventBaseThreadAndWait(
+      [this] { inotifyHandler_->unregisterHandler(); });
+  std::lock_guard<std::mutex> lg(filesMutex_);
+  inotifyHandler_.reset();
+  close(inotifyFd_);
+  inotifyFd_ = -1;
+  dirWatches_.clear();
+  watchToDir_.clear();
+}
+
+void FilePoller::addWatch(const std::string& fileName) {
+  if (inotifyFd_ < 0) {
+    return;
+  }
+  auto dir = parentDir(fileName);
+  auto& watch = dirWatches_[dir];
+  if (watch.refCount++ > 0) {
+    return;
+  }
+  watch.wd = inotify_add_watch(
+      inotifyFd_,
+      dir.empty() ? "." : dir.c_str(),
+      IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_TO |
+          IN_MOVED_FROM | IN_ONLYDIR);
+  if (watch.wd < 0) {
+    PLOG(WARNING) << "inotify_add_watch failed for " << fileName
+                  << "; relying on the poll sweep";
+    return;
+  }
+  watchToDir_[watch.wd] = dir;
+}
+
+void FilePoller::removeWatch(const std::string& fileName) {
+  if (inotifyFd_ < 0) {
+    return;
+  }
+  auto it = dirWatches_.find(parentDir(fileName));
+  if (it == dirWatches_.end() || --it->second.refCount > 0) {
+    return;
+  }
+  if (it->second.wd >= 0) {
+    inotify_rm_watch(inotifyFd_, it->second.wd);
+    watchToDir_.erase(it->second.wd);
+  }
+  dirWatches_.erase(it);
+}
+
+void FilePoller::onInotifyReadable() noexcept {
+  alignas(struct inotify_event) char buf[4096];
+  bool overflowed = false;
+  while (true) {
+    auto len = ::read(inotifyFd_, buf, sizeof(buf));
+    if (len <= 0) {
+      break;
+    }
+    std::lock_guard<std::mutex> lg(filesMutex_);
+    ThreadProtector tp;
+    for (char* p = buf; p < buf + len;) {
+      auto* event = reinterpret_cast<struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        overflowed = true;
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+      auto dirIt = watchToDir_.find(event->wd);
+      if (dirIt == watchToDir_.end()) {
+        continue;
+      }
+      auto fileIt = fileDatum_.find(joinDir(dirIt->second, event->name));
+      if (fileIt != fileDatum_.end()) {
+        checkFileLocked(fileIt->first, fileIt->second);
+      }
+    }
+  }
+  if (overflowed) {
+    // The kernel dropped events; run a full sweep to catch up.
+    checkFiles();
+  }
+}
+
+#endif // __linux__
+
 } // namespace wangle
@@ -38,6 +38,14 @@ namespace wangle {
  * assumption to make, so it should not be used in
  * situations where files may be modified without
  * changing the modified time.
+ *
+ * On Linux the poller additionally watches the parent directory of
+ * every tracked file with inotify, so changes (including atomic
+ * replace-by-rename) are picked up within milliseconds instead of on
+ * the next poll sweep. The periodic stat() sweep keeps running as a
+ * backstop — and is the only mechanism on other platforms or when
+ * inotify setup fails — so callers that care about steady-state cost
+ * can pass a long poll interval and still get prompt updates.
  */
 class FilePoller {
  public:
@@ -141,9 +149,40 @@ class FilePoller {
 
   // Grabs a read lock
   void checkFiles() noexcept;
+  // Stats one file and runs its callbacks; filesMutex_ must be held.
+  void checkFileLocked(const std::string& fileName, FileData& fileData) noexcept;
   void initFileData(const std::string& fName, FileData& fData) noexcept;
   void init(std::chrono::milliseconds pollInterval);
 
+#ifdef __linux__
+  // Event-driven backend. Tracked files are watched through their
+  // parent directory (a watch on the file itself would miss the
+  // replace-by-rename pattern cert updaters use); events run the same
+  // condition/callback logic as the poll sweep, just immediately.
+  class InotifyHandler;
+  friend class InotifyHandler;
+
+  struct DirWatch {
+    int wd{-1};
+    size_t refCount{0};
+  };
+
+  void initInotify();
+  void stopInotify();
+  // These two expect filesMutex_ to be held.
+  void addWatch(const std::string& fileName);
+  void removeWatch(const std::string& fileName);
+  void onInotifyReadable() noexcept;
+
+  int inotifyFd_{-1};
+  std::shared_ptr<folly::ScopedEventBaseThread> inotifyThread_;
+  std::unique_ptr<InotifyHandler> inotifyHandler_;
+  // Parent directory -> watch, and watch descriptor -> parent
+  // directory; both protected by filesMutex_.
+  std::unordered_map<std::string, DirWatch> dirWatches_;
+  std::unordered_map<int, std::string> watchToDir_;
+#endif
+
   FileDatas fileDatum_;
 
   // This protects fileDatum_.
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <folly/ThreadCachedInt.h>
+
+// Memory accounting is compiled in by default; define
+// WANGLE_MEMORY_ACCOUNTING=0 to compile it out entirely.
+#ifndef WANGLE_MEMORY_ACCOUNTING
+#define WANGLE_MEMORY_ACCOUNTING 1
+#endif
+
+namespace wangle {
+
+/**
+ * The major wangle allocation sites, so heap growth can be attributed
+ * to a subsystem instead of one undifferentiated process RSS number.
+ */
+enum class MemorySubsystem : uint8_t {
+  // PipelineContextPool slabs and oversized context blocks.
+  PIPELINE_CONTEXTS,
+  // ReadBufferPool heap: buffer mallocs and hugepage slabs. Reads too
+  // large for the pool's size classes are served by plain IOBufs and
+  // are not tracked, since their frees are not observable here.
+  READ_BUFFERS,
+  // LRUInMemoryCache entry payloads (see memoryFootprint below).
+  CLIENT_CACHE,
+  // ShardedLocalSSLSessionCache sessions, measured as DER length at
+  // store time, plus session ID bytes.
+  SSL_SESSION_CACHE,
+  // ObservingHandler pending-write queues held for slow subscribers.
+  BROADCAST_QUEUES,
+};
+
+constexpr size_t kNumMemorySubsystems = 5;
+
+inline const char* memorySubsystemName(MemorySubsystem subsystem) {
+  switch (subsystem) {
+    case MemorySubsystem::PIPELINE_CONTEXTS:
+      return "pipeline_contexts";
+    case MemorySubsystem::READ_BUFFERS:
+      return "read_buffers";
+    case MemorySubsystem::CLIENT_CACHE:
+      return "client_cache";
+    case MemorySubsystem::SSL_SESSION_CACHE:
+      return "ssl_session_cache";
+    case MemorySubsystem::BROADCAST_QUEUES:
+      return "broadcast_queues";
+  }
+  return "unknown";
+}
+
+/**
+ * Approximate bytes attributable to a value held in an accounted
+ * container. The default is the object's inline size; types with
+ * out-of-line storage get an overload here or, for user types, one
+ * found by argument-dependent lookup next to the type.
+ */
+template <class T>
+size_t memoryFootprint(const T&) {
+  return sizeof(T);
+}
+
+inline size_t memoryFootprint(const std::string& s) {
+  return sizeof(std::string) + s.capacity();
+}
+
+/**
+ * Process-wide, per-subsystem byte counters for the allocation sites
+ * enumerated above.
+ *
+ * add() and sub() update a thread-cached counter, so instrumented fast
+ * paths pay an unsynchronized increment; the cross-thread sum is only
+ * computed when snapshot() walks the caches. Counters track bytes the
+ * subsystem currently holds, not allocation rate, so a capacity
+ * regression shows up as one subsystem's curve diverging from the
+ * others.
+ */
+class MemoryAccounting {
+ public:
+  static void add(MemorySubsystem subsystem, size_t bytes) {
+#if WANGLE_MEMORY_ACCOUNTING
+    counter(subsystem).increment(static_cast<int64_t>(bytes));
+#else
+    (void)subsystem;
+    (void)bytes;
+#endif
+  }
+
+  static void sub(MemorySubsystem subsystem, size_t bytes) {
+#if WANGLE_MEMORY_ACCOUNTING
+    counter(subsystem).increment(-static_cast<int64_t>(bytes));
+#else
+    (void)subsystem;
+    (void)bytes;
+#endif
+  }
+
+  struct Snapshot {
+    std::array<int64_t, kNumMemorySubsystems> bytes{};
+
+    int64_t get(MemorySubsystem subsystem) const {
+      return bytes[static_cast<size_t>(subsystem)];
+    }
+
+    int64_t total() const {
+      int64_t sum = 0;
+      for (const auto b : bytes) {
+        sum += b;
+      }
+      return sum;
+    }
+  };
+
+  static Snapshot snapshot() {
+    Snapshot snap;
+#if WANGLE_MEMORY_ACCOUNTING
+    for (size_t i = 0; i < kNumMemorySubsystems; i++) {
+      snap.bytes[i] = counter(static_cast<MemorySubsystem>(i)).readFull();
+    }
+#endif
+    return snap;
+  }
+
+ private:
+#if WANGLE_MEMORY_ACCOUNTING
+  static folly::ThreadCachedInt<int64_t>& counter(MemorySubsystem subsystem) {
+    static std::array<folly::ThreadCachedInt<int64_t>, kNumMemorySubsystems>
+        counters;
+    return counters[static_cast<size_t>(subsystem)];
+  }
+#endif
+};
+
+} // namespace wangle
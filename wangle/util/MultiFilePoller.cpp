@@ -17,15 +17,43 @@
 #include <wangle/util/MultiFilePoller.h>
 
 #include <folly/FileUtil.h>
+#include <folly/Singleton.h>
 #include <folly/String.h>
+#include <folly/hash/Hash.h>
 #include <algorithm>
 
 using namespace folly;
 
 namespace wangle {
 
+namespace {
+
+constexpr std::chrono::milliseconds kSharedPollInterval{10000};
+constexpr std::chrono::milliseconds kSharedBatchWindow{100};
+
+folly::Singleton<MultiFilePoller> sharedPollerSingleton([] {
+  return new MultiFilePoller(kSharedPollInterval, kSharedBatchWindow);
+});
+
+} // namespace
+
 MultiFilePoller::MultiFilePoller(std::chrono::milliseconds pollInterval)
-    : poller_(pollInterval) {}
+    : MultiFilePoller(pollInterval, std::chrono::milliseconds::zero()) {}
+
+MultiFilePoller::MultiFilePoller(
+    std::chrono::milliseconds pollInterval,
+    std::chrono::milliseconds batchWindow)
+    : batchWindow_(batchWindow),
+      batchThread_(
+          batchWindow_.count() > 0
+              ? std::make_unique<folly::ScopedEventBaseThread>(
+                    "MultiFilePollerBatch")
+              : nullptr),
+      poller_(pollInterval) {}
+
+std::shared_ptr<MultiFilePoller> MultiFilePoller::getShared() {
+  return sharedPollerSingleton.try_get();
+}
 
 size_t MultiFilePoller::getNextCallbackId() {
   size_t ret = lastCallbackId_;
@@ -108,36 +136,127 @@ void MultiFilePoller::cancelCallback(const CallbackId& cbId) {
   // Release rwlock_ before acquiring filepoller mutex.
   for (const auto& path : pathsToErase) {
     poller_.removeFileToTrack(path);
+    std::lock_guard<std::mutex> g(cacheMutex_);
+    contentCache_.erase(path);
+  }
+}
+
+bool MultiFilePoller::updateCachedContents(const std::string& path) {
+  std::string data;
+  const bool readOk = readFile(path.c_str(), data);
+  std::lock_guard<std::mutex> g(cacheMutex_);
+  auto pos = contentCache_.find(path);
+  if (!readOk) {
+    VLOG(4) << "Failed to read file " << path;
+    if (pos == contentCache_.end()) {
+      return false;
+    }
+    // A previously readable file went away; that is a change.
+    contentCache_.erase(pos);
+    return true;
+  }
+  const uint64_t hash = hash::fnv64(data);
+  if (pos != contentCache_.end() && pos->second.hash == hash &&
+      pos->second.data.size() == data.size()) {
+    return false;
+  }
+  contentCache_[path] = CachedFile{std::move(data), hash};
+  return true;
+}
+
+Optional<std::string> MultiFilePoller::getCachedOrRead(
+    const std::string& path) {
+  {
+    std::lock_guard<std::mutex> g(cacheMutex_);
+    auto pos = contentCache_.find(path);
+    if (pos != contentCache_.end()) {
+      return pos->second.data;
+    }
+  }
+  updateCachedContents(path);
+  std::lock_guard<std::mutex> g(cacheMutex_);
+  auto pos = contentCache_.find(path);
+  if (pos != contentCache_.end()) {
+    return pos->second.data;
   }
+  return none;
 }
 
 void MultiFilePoller::onFileUpdated(const std::string& triggeredPath) {
   VLOG(4) << "onFileUpdated(" << triggeredPath << ").";
 
-  // A temporary read cache. Not worth it making it permanent because
-  // files do not change frequently.
-  std::unordered_map<std::string, std::string> filePathsToFileContents;
+  if (!batchThread_) {
+    if (!updateCachedContents(triggeredPath)) {
+      VLOG(4) << "Content of " << triggeredPath << " unchanged; skipping.";
+      return;
+    }
+    dispatchForPaths({triggeredPath});
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> g(pendingMutex_);
+    pendingPaths_.insert(triggeredPath);
+    if (dispatchScheduled_) {
+      return;
+    }
+    dispatchScheduled_ = true;
+  }
+  auto* evb = batchThread_->getEventBase();
+  evb->runInEventBaseThread([this, evb] {
+    evb->runAfterDelay(
+        [this] { dispatchPending(); },
+        static_cast<uint32_t>(batchWindow_.count()));
+  });
+}
+
+void MultiFilePoller::dispatchPending() {
+  std::vector<std::string> paths;
+  {
+    std::lock_guard<std::mutex> g(pendingMutex_);
+    paths.assign(pendingPaths_.begin(), pendingPaths_.end());
+    pendingPaths_.clear();
+    dispatchScheduled_ = false;
+  }
+  std::vector<std::string> changed;
+  for (const auto& path : paths) {
+    if (updateCachedContents(path)) {
+      changed.push_back(path);
+    } else {
+      VLOG(4) << "Content of " << path << " unchanged; skipping.";
+    }
+  }
+  if (!changed.empty()) {
+    dispatchForPaths(changed);
+  }
+}
+
+void MultiFilePoller::dispatchForPaths(
+    const std::vector<std::string>& changedPaths) {
   SharedMutex::ReadHolder rh(rwlock_);
 
-  const auto& callbacks = pathsToCallbackIds_.find(triggeredPath);
-  if (callbacks == pathsToCallbackIds_.end()) {
-    return;
+  // Collect each affected callback once, even when several of its files
+  // changed in the same batch.
+  std::vector<size_t> cbIds;
+  for (const auto& path : changedPaths) {
+    const auto& callbacks = pathsToCallbackIds_.find(path);
+    if (callbacks != pathsToCallbackIds_.end()) {
+      cbIds.insert(
+          cbIds.end(), callbacks->second.begin(), callbacks->second.end());
+    }
   }
+  std::sort(cbIds.begin(), cbIds.end());
+  cbIds.erase(std::unique(cbIds.begin(), cbIds.end()), cbIds.end());
 
-  for (const auto& cbId : callbacks->second) {
+  for (const auto& cbId : cbIds) {
     const auto& cbEnt = idsToCallbacks_.find(cbId);
-    // Lazily read all files needed by the callback.
+    CallbackArg arg;
     for (const auto& path : cbEnt->second.files_) {
-      if (filePathsToFileContents.find(path) == filePathsToFileContents.end()) {
-        std::string data;
-        if (readFile(path.get().c_str(), data)) {
-          filePathsToFileContents.emplace(path, std::move(data));
-        } else {
-          VLOG(4) << "Failed to read file " << path.get();
-        }
+      if (auto contents = getCachedOrRead(path)) {
+        arg.emplace(path, std::move(*contents));
       }
     }
-    cbEnt->second.cb_(filePathsToFileContents);
+    cbEnt->second.cb_(arg);
   }
 }
 
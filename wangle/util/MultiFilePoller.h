@@ -17,10 +17,15 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <unordered_map>
 
 #include <folly/Function.h>
+#include <folly/Optional.h>
 #include <folly/SharedMutex.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
 #include <wangle/util/FilePoller.h>
 
 namespace wangle {
@@ -29,6 +34,12 @@ namespace wangle {
  * An extension to wangle::FilePoller with the ability to register one or more
  * callback on a file, and to track one or more file in a callback, and to
  * deliver cached file data to callbacks.
+ *
+ * File contents are cached keyed by path and invalidated by content hash, so
+ * a touch that leaves the bytes unchanged fires no callbacks, and a file
+ * shared by several callbacks is read once per change rather than once per
+ * dispatch.  An optional batch window coalesces changes to many files (e.g.
+ * a cert directory rotation) into a single delivery per callback.
  */
 class MultiFilePoller {
  public:
@@ -76,6 +87,25 @@ class MultiFilePoller {
    */
   explicit MultiFilePoller(std::chrono::milliseconds pollInterval);
 
+  /**
+   * @param pollInterval See above.
+   * @param batchWindow When non-zero, a file change does not dispatch
+   *   immediately; it starts (or joins) a batch that is delivered once the
+   *   window elapses, so a callback whose files all changed in one rotation
+   *   runs once with all of the new contents instead of once per file.
+   */
+  MultiFilePoller(
+      std::chrono::milliseconds pollInterval,
+      std::chrono::milliseconds batchWindow);
+
+  /**
+   * A process-wide instance (10_s poll interval, 100_ms batch window) for
+   * components that track the same paths — e.g. many listeners watching one
+   * set of cert/ticket files — so one file touch costs one read and one
+   * batched fan-out instead of a read per component.
+   */
+  static std::shared_ptr<MultiFilePoller> getShared();
+
   ~MultiFilePoller() = default;
 
   /**
@@ -106,6 +136,30 @@ class MultiFilePoller {
    */
   void onFileUpdated(const std::string& triggeredPath);
 
+  /**
+   * Re-read the file and refresh the content cache. Returns true iff the
+   * content actually changed (including creation and deletion). Takes
+   * cacheMutex_ internally.
+   */
+  bool updateCachedContents(const std::string& path);
+
+  /**
+   * Return the cached content of path, reading (and caching) it on a miss.
+   * Returns folly::none if the file is unreadable.
+   */
+  folly::Optional<std::string> getCachedOrRead(const std::string& path);
+
+  /**
+   * Run every callback registered on any of changedPaths, each exactly once.
+   */
+  void dispatchForPaths(const std::vector<std::string>& changedPaths);
+
+  /**
+   * Drain the pending path set accumulated during a batch window and
+   * dispatch callbacks for the paths whose content actually changed.
+   */
+  void dispatchPending();
+
   /**
    * Find an unused size_t value as callback Id. Caller must acquire wlock.
    */
@@ -121,13 +175,32 @@ class MultiFilePoller {
     Callback cb_;
   };
 
+  struct CachedFile {
+    std::string data;
+    uint64_t hash{0};
+  };
+
   // The following data structures are protected by the mutex.
   folly::SharedMutex rwlock_;
   size_t lastCallbackId_ = 0;
   std::unordered_map<std::string, std::vector<size_t>> pathsToCallbackIds_;
   std::unordered_map<size_t, CallbackDetail> idsToCallbacks_;
 
-  // The following data structures are set by ctor only.
+  // Latest known contents per path, protected by cacheMutex_.
+  std::mutex cacheMutex_;
+  std::unordered_map<std::string, CachedFile> contentCache_;
+
+  // Paths changed during the current batch window, protected by
+  // pendingMutex_.
+  std::mutex pendingMutex_;
+  std::set<std::string> pendingPaths_;
+  bool dispatchScheduled_{false};
+
+  // The following data structures are set by ctor only.  poller_ is last so
+  // its destruction stops update events before the batch thread and the
+  // maps they both use go away.
+  const std::chrono::milliseconds batchWindow_;
+  std::unique_ptr<folly::ScopedEventBaseThread> batchThread_;
   wangle::FilePoller poller_;
 };
 
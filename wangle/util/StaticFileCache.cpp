@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/util/StaticFileCache.h>
+
+#include <mutex>
+#include <shared_mutex>
+
+#include <sys/stat.h>
+
+namespace wangle {
+
+namespace {
+
+// Invalidate on any observable change: modification, replacement,
+// creation and deletion. The default fileTouchedCond ignores deletion.
+bool fileChangedCond(
+    const FilePoller::FileModificationData& oldData,
+    const FilePoller::FileModificationData& newData) {
+  return oldData.exists != newData.exists || oldData.modTime != newData.modTime;
+}
+
+} // namespace
+
+constexpr size_t StaticFileCache::kDefaultMaxEntries;
+
+StaticFileCache::StaticFileCache(
+    size_t maxEntries,
+    std::chrono::milliseconds pollInterval)
+    : maxEntries_(maxEntries), poller_(pollInterval) {}
+
+std::shared_ptr<const StaticFileCache::CachedFile> StaticFileCache::getFile(
+    const std::string& path) {
+  {
+    std::shared_lock<folly::SharedMutex> g(mutex_);
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+      it->second.lastAccess.store(nowTicks(), std::memory_order_relaxed);
+      return it->second.file;
+    }
+  }
+  return openAndInsert(path);
+}
+
+std::shared_ptr<const StaticFileCache::CachedFile>
+StaticFileCache::openAndInsert(const std::string& path) {
+  folly::File file;
+  try {
+    file = folly::File(path);
+  } catch (const std::system_error&) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(file.fd(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    return nullptr;
+  }
+  auto cached = std::make_shared<const CachedFile>(CachedFile{
+      std::move(file),
+      st.st_size,
+      std::chrono::system_clock::from_time_t(st.st_mtime)});
+
+  std::string evicted;
+  {
+    std::unique_lock<folly::SharedMutex> g(mutex_);
+    auto& entry = entries_[path];
+    entry.file = cached;
+    entry.lastAccess.store(nowTicks(), std::memory_order_relaxed);
+    if (entries_.size() > maxEntries_) {
+      auto victim = entries_.end();
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->first == path) {
+          continue;
+        }
+        if (victim == entries_.end() ||
+            it->second.lastAccess.load(std::memory_order_relaxed) <
+                victim->second.lastAccess.load(std::memory_order_relaxed)) {
+          victim = it;
+        }
+      }
+      if (victim != entries_.end()) {
+        evicted = victim->first;
+        entries_.erase(victim);
+      }
+    }
+  }
+
+  // Poller calls are made outside mutex_: the change callback runs with
+  // the poller's own lock held and takes mutex_, so taking them in the
+  // other order here could deadlock.
+  if (!evicted.empty()) {
+    poller_.removeFileToTrack(evicted);
+  }
+  poller_.addFileToTrack(
+      path, [this, path] { invalidate(path); }, nullptr, fileChangedCond);
+  return cached;
+}
+
+void StaticFileCache::invalidate(const std::string& path) {
+  std::unique_lock<folly::SharedMutex> g(mutex_);
+  entries_.erase(path);
+}
+
+size_t StaticFileCache::size() const {
+  std::shared_lock<folly::SharedMutex> g(mutex_);
+  return entries_.size();
+}
+
+} // namespace wangle
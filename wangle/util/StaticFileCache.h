@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <folly/File.h>
+#include <folly/SharedMutex.h>
+#include <wangle/util/FilePoller.h>
+
+namespace wangle {
+
+/**
+ * A cache of open file descriptors and stat metadata for static-file
+ * serving, shared across IO threads. Serving a cached file costs a
+ * shared-lock lookup instead of an open/fstat/close per request.
+ *
+ * Entries are invalidated through FilePoller (inotify-backed on Linux)
+ * when the underlying file is modified, replaced or deleted, and
+ * evicted least-recently-used beyond maxEntries. A returned CachedFile
+ * keeps its descriptor open for as long as the caller holds it, even
+ * if the entry is invalidated or evicted meanwhile, so it is safe to
+ * hand to an in-flight FileRegion transfer.
+ */
+class StaticFileCache {
+ public:
+  struct CachedFile {
+    folly::File file;
+    off_t size{0};
+    std::chrono::system_clock::time_point modTime;
+
+    int fd() const {
+      return file.fd();
+    }
+  };
+
+  // pollInterval is the backstop stat() cadence; on Linux the inotify
+  // backend usually invalidates well before it fires.
+  explicit StaticFileCache(
+      size_t maxEntries = kDefaultMaxEntries,
+      std::chrono::milliseconds pollInterval = std::chrono::seconds(10));
+
+  StaticFileCache(const StaticFileCache&) = delete;
+  StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+  // Returns nullptr if the path cannot be opened or is not a regular
+  // file. This is threadsafe.
+  std::shared_ptr<const CachedFile> getFile(const std::string& path);
+
+  // Drops the cache entry for a path, if any; the next getFile reopens
+  // it. Called automatically when the poller sees the file change.
+  void invalidate(const std::string& path);
+
+  size_t size() const;
+
+ private:
+  static constexpr size_t kDefaultMaxEntries = 1024;
+
+  struct Entry {
+    std::shared_ptr<const CachedFile> file;
+    // Approximate LRU: hits bump a timestamp under the shared lock
+    // instead of reordering a list, which would need the exclusive one.
+    mutable std::atomic<std::chrono::steady_clock::rep> lastAccess{0};
+  };
+
+  std::shared_ptr<const CachedFile> openAndInsert(const std::string& path);
+
+  static std::chrono::steady_clock::rep nowTicks() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+
+  mutable folly::SharedMutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  const size_t maxEntries_;
+  FilePoller poller_;
+};
+
+} // namespace wangle
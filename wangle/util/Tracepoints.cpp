@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/util/Tracepoints.h>
+
+// One definition per semaphored probe; the tracer increments these on
+// attach, which is what flips WANGLE_SDT_ENABLED.
+FOLLY_SDT_DEFINE_SEMAPHORE(wangle, handshake_success);
+FOLLY_SDT_DEFINE_SEMAPHORE(wangle, frame_decoded);
+FOLLY_SDT_DEFINE_SEMAPHORE(wangle, dispatch_read);
+FOLLY_SDT_DEFINE_SEMAPHORE(wangle, socket_flush);
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/tracing/StaticTracepoint.h>
+
+/**
+ * Compiled-in USDT probes at wangle's subsystem boundaries, under the
+ * "wangle" provider. Each probe is a single nop in the instruction
+ * stream until a tracer (bpftrace, perf, ...) attaches to it, so the
+ * steady-state cost is zero; probes whose arguments take any work to
+ * compute carry a semaphore, and their call sites skip the computation
+ * entirely unless something is attached.
+ *
+ * Probes, in connection order:
+ *
+ *   conn_accepted(fd)
+ *       Acceptor::onDoneAcceptingConnection, one per accepted socket.
+ *   handshake_success(fd, transport, elapsed_ms)
+ *       AcceptorHandshakeManager::connectionReady. The transport
+ *       pointer is the connection id every later probe carries; this
+ *       probe joins it to the accept-time fd.
+ *   frame_decoded(transport)
+ *       ByteToMessageDecoder, one per decoded frame.
+ *   dispatch_read(transport, dispatcher)
+ *       Request entry into a server dispatcher.
+ *   socket_flush(transport, bytes)
+ *       AsyncSocketHandler handing a write chain to the socket.
+ *
+ * A pipeline stage breakdown for slow connections is then e.g.:
+ *
+ *   bpftrace -e '
+ *     usdt:PATH:wangle:frame_decoded { @t[arg0] = nsecs; }
+ *     usdt:PATH:wangle:socket_flush /@t[arg0]/ {
+ *       @stage_us = hist((nsecs - @t[arg0]) / 1000); delete(@t[arg0]);
+ *     }'
+ */
+#define WANGLE_SDT(name, ...) FOLLY_SDT(wangle, name, ##__VA_ARGS__)
+
+/**
+ * Guard for probes with non-trivial arguments: false until a tracer
+ * attaches, so argument computation can sit behind it. Only valid for
+ * the semaphored probes listed below.
+ */
+#define WANGLE_SDT_ENABLED(name) FOLLY_SDT_IS_ENABLED(wangle, name)
+
+#define WANGLE_SDT_WITH_SEMAPHORE(name, ...) \
+  FOLLY_SDT_WITH_SEMAPHORE(wangle, name, ##__VA_ARGS__)
+
+// Semaphores live in Tracepoints.cpp.
+FOLLY_SDT_DECLARE_SEMAPHORE(wangle, handshake_success);
+FOLLY_SDT_DECLARE_SEMAPHORE(wangle, frame_decoded);
+FOLLY_SDT_DECLARE_SEMAPHORE(wangle, dispatch_read);
+FOLLY_SDT_DECLARE_SEMAPHORE(wangle, socket_flush);
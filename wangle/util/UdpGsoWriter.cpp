@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <wangle/util/UdpGsoWriter.h>
+
+#include <glog/logging.h>
+
+namespace {
+
+// Kernel cap on segments per UDP_SEGMENT send (UDP_MAX_SEGMENTS).
+constexpr size_t kMaxGsoSegments = 64;
+
+} // namespace
+
+namespace wangle {
+
+UdpGsoWriter::UdpGsoWriter(std::shared_ptr<folly::AsyncUDPSocket> socket)
+    : socket_(std::move(socket)) {
+  CHECK(socket_);
+}
+
+UdpGsoWriter::~UdpGsoWriter() {
+  flush();
+}
+
+bool UdpGsoWriter::fitsBatch(
+    const folly::SocketAddress& addr,
+    size_t length) const {
+  // Segments before the last must be exactly segmentSize_; a smaller
+  // datagram can still join as the final segment.
+  return addr == batchAddr_ && length <= segmentSize_;
+}
+
+ssize_t UdpGsoWriter::write(
+    const folly::SocketAddress& addr,
+    std::unique_ptr<folly::IOBuf> datagram) {
+  if (!datagram) {
+    return 0;
+  }
+  const auto length = datagram->computeChainDataLength();
+  if (length == 0) {
+    return 0;
+  }
+  counters_.datagrams++;
+
+  if (gsoSupported_ < 0) {
+    gsoSupported_ = socket_->getGSO() >= 0 ? 1 : 0;
+    VLOG_IF(2, !gsoSupported_)
+        << "UDP_SEGMENT unsupported, degrading to per-datagram sends";
+  }
+  if (!gsoSupported_) {
+    counters_.sendCalls++;
+    return socket_->write(addr, datagram);
+  }
+
+  if (batch_ && !fitsBatch(addr, length)) {
+    if (flush() < 0) {
+      return -1;
+    }
+  }
+
+  if (!batch_) {
+    batchAddr_ = addr;
+    segmentSize_ = length;
+    batch_ = std::move(datagram);
+    pendingCount_ = 1;
+    return length;
+  }
+
+  const bool undersized = length < segmentSize_;
+  batch_->prependChain(std::move(datagram));
+  pendingCount_++;
+  // An undersized datagram is only legal as the final segment, and a
+  // full batch has reached the kernel's per-send segment cap.
+  if (undersized || pendingCount_ >= kMaxGsoSegments) {
+    if (flush() < 0) {
+      return -1;
+    }
+  }
+  return length;
+}
+
+ssize_t UdpGsoWriter::flush() {
+  if (!batch_) {
+    return 0;
+  }
+  auto buf = std::move(batch_);
+  const auto count = pendingCount_;
+  pendingCount_ = 0;
+
+  counters_.sendCalls++;
+  ssize_t rc;
+  if (count == 1) {
+    // Nothing to segment; a plain send avoids the cmsg.
+    rc = socket_->write(batchAddr_, buf);
+  } else {
+    folly::AsyncUDPSocket::WriteOptions options;
+    options.gso = static_cast<int>(segmentSize_);
+    rc = socket_->writeGSO(batchAddr_, buf, options);
+    if (rc >= 0) {
+      counters_.gsoSends++;
+      counters_.gsoDatagrams += count;
+    }
+  }
+  segmentSize_ = 0;
+  return rc < 0 ? -1 : static_cast<ssize_t>(count);
+}
+
+} // namespace wangle
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+
+namespace wangle {
+
+/**
+ * Coalesces bursts of same-destination datagrams into single UDP_SEGMENT
+ * (GSO) sends: queued datagrams sharing a destination and the first
+ * datagram's size are chained into one super-buffer and handed to the
+ * kernel in one sendmsg, which segments them on the wire. A burst of
+ * 20-50 packets to one peer collapses to a handful of syscalls.
+ *
+ * Datagrams queue while they match the open batch; a different
+ * destination or size, a full batch (the kernel caps GSO at 64
+ * segments), or flush() sends what is pending. A datagram smaller than
+ * the segment size is legal only as the last segment, so it is appended
+ * and the batch flushed immediately. When the socket reports no GSO
+ * support, every datagram is written directly and the writer degrades
+ * to plain per-packet sends.
+ *
+ * Single-threaded, like the AsyncUDPSocket it wraps; call flush() before
+ * relinquishing the loop if latency matters, otherwise the batch sends
+ * when broken. Counters expose datagram/syscall rates so segmentation
+ * efficiency can be exported per socket.
+ */
+class UdpGsoWriter {
+ public:
+  struct Counters {
+    /** Datagrams handed to write() */
+    uint64_t datagrams{0};
+    /** sendmsg calls actually issued */
+    uint64_t sendCalls{0};
+    /** Subset of sendCalls that carried a GSO super-buffer */
+    uint64_t gsoSends{0};
+    /** Datagrams that traveled inside a GSO super-buffer */
+    uint64_t gsoDatagrams{0};
+  };
+
+  explicit UdpGsoWriter(std::shared_ptr<folly::AsyncUDPSocket> socket);
+
+  ~UdpGsoWriter();
+
+  /**
+   * Queue one datagram for addr, sending any batch it cannot join.
+   * Returns the bytes accepted (the datagram length), or -1 when an
+   * eager send of the displaced batch failed.
+   */
+  ssize_t write(
+      const folly::SocketAddress& addr,
+      std::unique_ptr<folly::IOBuf> datagram);
+
+  /**
+   * Send whatever is pending. Returns the number of datagrams sent, or
+   * -1 on send failure (the batch is dropped either way).
+   */
+  ssize_t flush();
+
+  size_t pendingDatagrams() const {
+    return pendingCount_;
+  }
+
+  const Counters& counters() const {
+    return counters_;
+  }
+
+ private:
+  UdpGsoWriter(const UdpGsoWriter&) = delete;
+  UdpGsoWriter& operator=(const UdpGsoWriter&) = delete;
+
+  bool fitsBatch(
+      const folly::SocketAddress& addr,
+      size_t length) const;
+
+  std::shared_ptr<folly::AsyncUDPSocket> socket_;
+  // < 0 until the socket has been probed for UDP_SEGMENT support
+  int gsoSupported_{-1};
+
+  folly::SocketAddress batchAddr_;
+  std::unique_ptr<folly::IOBuf> batch_;
+  size_t segmentSize_{0};
+  size_t pendingCount_{0};
+  Counters counters_;
+};
+
+} // namespace wangle
@@ -161,6 +161,33 @@ TEST_F(FilePollerTest, TestDeleteFile) {
   ASSERT_FALSE(updated);
 }
 
+#ifdef __linux__
+// With a poll interval far longer than the wait, only the inotify
+// backend can deliver these updates in time.
+TEST_F(FilePollerTest, TestInotifyUpdate) {
+  createFile();
+  Baton<> baton;
+  FilePoller poller(seconds(10));
+  poller.addFileToTrack(tmpFile, [&]() { baton.post(); });
+  updateModifiedTime(tmpFile);
+  ASSERT_TRUE(baton.try_wait_for(seconds(2)));
+}
+
+TEST_F(FilePollerTest, TestInotifyReplaceByRename) {
+  createFile();
+  Baton<> baton;
+  FilePoller poller(seconds(10));
+  poller.addFileToTrack(tmpFile, [&]() { baton.post(); });
+  // Write a sibling and rename it over the tracked path, the way cert
+  // updaters atomically replace files.
+  std::string sibling = tmpFile + ".new";
+  File(sibling, O_CREAT);
+  updateModifiedTime(sibling);
+  PCHECK(rename(sibling.c_str(), tmpFile.c_str()) == 0);
+  ASSERT_TRUE(baton.try_wait_for(seconds(2)));
+}
+#endif
+
 struct UpdateSyncState {
   std::mutex m;
   std::condition_variable cv;
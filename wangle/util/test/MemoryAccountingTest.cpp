@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <string>
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+#include <wangle/channel/PipelineContextPool.h>
+#include <wangle/channel/ReadBufferPool.h>
+#include <wangle/client/persistence/LRUInMemoryCache.h>
+#include <wangle/util/MemoryAccounting.h>
+
+using namespace wangle;
+
+TEST(MemoryAccountingTest, AddSubSnapshot) {
+  auto baseline = MemoryAccounting::snapshot();
+
+  MemoryAccounting::add(MemorySubsystem::READ_BUFFERS, 4096);
+  MemoryAccounting::add(MemorySubsystem::CLIENT_CACHE, 100);
+
+  auto snap = MemoryAccounting::snapshot();
+  EXPECT_EQ(
+      snap.get(MemorySubsystem::READ_BUFFERS) -
+          baseline.get(MemorySubsystem::READ_BUFFERS),
+      4096);
+  EXPECT_EQ(
+      snap.get(MemorySubsystem::CLIENT_CACHE) -
+          baseline.get(MemorySubsystem::CLIENT_CACHE),
+      100);
+  EXPECT_EQ(snap.total() - baseline.total(), 4196);
+
+  MemoryAccounting::sub(MemorySubsystem::READ_BUFFERS, 4096);
+  MemoryAccounting::sub(MemorySubsystem::CLIENT_CACHE, 100);
+  EXPECT_EQ(MemoryAccounting::snapshot().total(), baseline.total());
+}
+
+TEST(MemoryAccountingTest, SubsystemNames) {
+  EXPECT_STREQ(
+      memorySubsystemName(MemorySubsystem::PIPELINE_CONTEXTS),
+      "pipeline_contexts");
+  EXPECT_STREQ(
+      memorySubsystemName(MemorySubsystem::BROADCAST_QUEUES),
+      "broadcast_queues");
+}
+
+TEST(MemoryAccountingTest, PipelineContextPoolAttribution) {
+  const auto baseline =
+      MemoryAccounting::snapshot().get(MemorySubsystem::PIPELINE_CONTEXTS);
+  {
+    PipelineContextPool pool;
+    void* p = pool.allocate(64);
+    EXPECT_GT(
+        MemoryAccounting::snapshot().get(MemorySubsystem::PIPELINE_CONTEXTS),
+        baseline);
+    pool.deallocate(p, 64);
+    // Recycled blocks stay attributed to the pool.
+    EXPECT_GT(
+        MemoryAccounting::snapshot().get(MemorySubsystem::PIPELINE_CONTEXTS),
+        baseline);
+  }
+  EXPECT_EQ(
+      MemoryAccounting::snapshot().get(MemorySubsystem::PIPELINE_CONTEXTS),
+      baseline);
+}
+
+TEST(MemoryAccountingTest, ReadBufferPoolAttribution) {
+  const auto baseline =
+      MemoryAccounting::snapshot().get(MemorySubsystem::READ_BUFFERS);
+  {
+    ReadBufferPool pool;
+    auto buf = pool.allocate(4096);
+    EXPECT_GE(
+        MemoryAccounting::snapshot().get(MemorySubsystem::READ_BUFFERS) -
+            baseline,
+        4096);
+    buf.reset();
+    // Pooled buffers stay attributed until the pool releases them.
+    EXPECT_GE(
+        MemoryAccounting::snapshot().get(MemorySubsystem::READ_BUFFERS) -
+            baseline,
+        4096);
+  }
+  EXPECT_EQ(
+      MemoryAccounting::snapshot().get(MemorySubsystem::READ_BUFFERS),
+      baseline);
+}
+
+TEST(MemoryAccountingTest, LRUInMemoryCacheAttribution) {
+  const auto baseline =
+      MemoryAccounting::snapshot().get(MemorySubsystem::CLIENT_CACHE);
+  {
+    LRUInMemoryCache<std::string, std::string, std::mutex> cache(4);
+    cache.put("key", "a value with some heft to it");
+    EXPECT_GT(
+        MemoryAccounting::snapshot().get(MemorySubsystem::CLIENT_CACHE),
+        baseline);
+
+    // Overwrites replace the old attribution instead of stacking.
+    cache.put("key", "v2");
+    const auto afterOverwrite =
+        MemoryAccounting::snapshot().get(MemorySubsystem::CLIENT_CACHE);
+
+    EXPECT_TRUE(cache.remove("key"));
+    EXPECT_EQ(
+        MemoryAccounting::snapshot().get(MemorySubsystem::CLIENT_CACHE),
+        baseline);
+    EXPECT_GT(afterOverwrite, baseline);
+
+    // Capacity evictions are released through the prune hook.
+    for (int i = 0; i < 10; i++) {
+      cache.put(folly::to<std::string>("key", i), "value");
+    }
+    EXPECT_EQ(cache.size(), 4);
+    cache.clear();
+    EXPECT_EQ(
+        MemoryAccounting::snapshot().get(MemorySubsystem::CLIENT_CACHE),
+        baseline);
+
+    cache.put("tail", "entry alive at destruction");
+  }
+  // Entries alive at destruction are settled by the destructor.
+  EXPECT_EQ(
+      MemoryAccounting::snapshot().get(MemorySubsystem::CLIENT_CACHE),
+      baseline);
+}
@@ -103,6 +103,87 @@ TEST_F(MultiFilePollerTest, BasicTest) {
   // If the callback runs, the assertion inside callback will also fail.
 }
 
+/**
+ * ContentHashDedupTest
+ * This test checks that a write which changes mtime but not content does
+ * not trigger callbacks, while a real content change still does.
+ */
+TEST_F(MultiFilePollerTest, ContentHashDedupTest) {
+  const std::string f(tmpdirPath_ + "/Dedup1"), d1("abc"), d2("xyz");
+  folly::SaturatingSemaphore<true /* MayBlock */> sem;
+  std::string data;
+  size_t count = 0;
+
+  updater_->registerFile(
+      f, [&](const MultiFilePoller::CallbackArg& newData) {
+        data = folly::get_or_throw(newData, f);
+        count++;
+        sem.post();
+      });
+
+  // Create the file. First sighting of the content fires the callback.
+  ASSERT_TRUE(folly::writeFile(d1, f.c_str()));
+  ASSERT_TRUE(sem.try_wait_until(
+      std::chrono::steady_clock::now() + kMaxSemaphoreWaitMs));
+  sem.reset();
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(d1, data);
+
+  // Rewrite the same bytes. The mtime advances but the content hash does
+  // not, so the callback must not run.
+  delayedWrite(f, d1);
+  ASSERT_FALSE(sem.try_wait_until(
+      std::chrono::steady_clock::now() + kMaxSemaphoreWaitMs));
+  EXPECT_EQ(1, count);
+
+  // A real content change still fires.
+  delayedWrite(f, d2);
+  ASSERT_TRUE(sem.try_wait_until(
+      std::chrono::steady_clock::now() + kMaxSemaphoreWaitMs));
+  sem.reset();
+  EXPECT_EQ(2, count);
+  EXPECT_EQ(d2, data);
+}
+
+/**
+ * BatchedDeliveryTest
+ * This test checks that with a batch window configured, changes to several
+ * files of one callback are delivered as a single invocation carrying all
+ * of the new contents.
+ */
+TEST_F(MultiFilePollerTest, BatchedDeliveryTest) {
+  MultiFilePoller batched(kPollIntervalMs, std::chrono::milliseconds(500));
+  const std::string f1(tmpdirPath_ + "/Batch1"), d1("a");
+  const std::string f2(tmpdirPath_ + "/Batch2"), d2("b");
+  folly::SaturatingSemaphore<true /* MayBlock */> sem;
+  MultiFilePoller::CallbackArg lastData;
+  size_t count = 0;
+
+  batched.registerFiles(
+      {f1, f2}, [&](const MultiFilePoller::CallbackArg& newData) {
+        lastData = newData;
+        count++;
+        sem.post();
+      });
+
+  // Create both files within one batch window.
+  ASSERT_TRUE(folly::writeFile(d1, f1.c_str()));
+  ASSERT_TRUE(folly::writeFile(d2, f2.c_str()));
+
+  ASSERT_TRUE(sem.try_wait_until(
+      std::chrono::steady_clock::now() + kMaxSemaphoreWaitMs +
+      std::chrono::milliseconds(500)));
+  sem.reset();
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(d1, folly::get_or_throw(lastData, f1));
+  EXPECT_EQ(d2, folly::get_or_throw(lastData, f2));
+
+  // The second file's change was part of the batch; no second delivery.
+  ASSERT_FALSE(sem.try_wait_until(
+      std::chrono::steady_clock::now() + kMaxSemaphoreWaitMs));
+  EXPECT_EQ(1, count);
+}
+
 /**
  * CancellationTest
  * This test tests the basic functionality of callback cancellation.
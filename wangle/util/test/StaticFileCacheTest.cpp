@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <thread>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <wangle/util/StaticFileCache.h>
+
+using namespace std::chrono;
+using namespace wangle;
+
+class StaticFileCacheTest : public testing::Test {
+ protected:
+  std::string writeFile(const std::string& name, const std::string& data) {
+    auto path = (tmpDir_.path() / name).string();
+    CHECK(folly::writeFile(data, path.c_str()));
+    return path;
+  }
+
+  folly::test::TemporaryDirectory tmpDir_;
+};
+
+TEST_F(StaticFileCacheTest, HitReturnsSameEntry) {
+  auto path = writeFile("a", "hello");
+  StaticFileCache cache;
+  auto f1 = cache.getFile(path);
+  ASSERT_NE(nullptr, f1);
+  EXPECT_EQ(5, f1->size);
+  EXPECT_GT(f1->fd(), -1);
+  auto f2 = cache.getFile(path);
+  EXPECT_EQ(f1.get(), f2.get());
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST_F(StaticFileCacheTest, MissingFile) {
+  StaticFileCache cache;
+  EXPECT_EQ(nullptr, cache.getFile((tmpDir_.path() / "nope").string()));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST_F(StaticFileCacheTest, Eviction) {
+  StaticFileCache cache(2);
+  cache.getFile(writeFile("a", "1"));
+  cache.getFile(writeFile("b", "22"));
+  cache.getFile(writeFile("c", "333"));
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST_F(StaticFileCacheTest, InvalidateOnChange) {
+  auto path = writeFile("a", "hello");
+  StaticFileCache cache(1024, milliseconds(1));
+  auto f1 = cache.getFile(path);
+  ASSERT_NE(nullptr, f1);
+
+  writeFile("a", "goodbye!");
+  std::shared_ptr<const StaticFileCache::CachedFile> f2;
+  auto deadline = steady_clock::now() + seconds(5);
+  while (steady_clock::now() < deadline) {
+    f2 = cache.getFile(path);
+    if (f2 && f2->size == 8) {
+      break;
+    }
+    /* sleep override */
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  ASSERT_NE(nullptr, f2);
+  EXPECT_EQ(8, f2->size);
+  // The old entry stays usable for in-flight transfers.
+  EXPECT_EQ(5, f1->size);
+  EXPECT_GT(f1->fd(), -1);
+}
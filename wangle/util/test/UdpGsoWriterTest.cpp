@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <wangle/util/UdpGsoWriter.h>
+
+using namespace folly;
+using namespace wangle;
+
+namespace {
+
+class Receiver : public AsyncUDPSocket::ReadCallback {
+ public:
+  Receiver(EventBase* evb, size_t expectedBytes)
+      : evb_(evb), expectedBytes_(expectedBytes) {}
+
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    *buf = buffer_;
+    *len = sizeof(buffer_);
+  }
+
+  void onDataAvailable(
+      const SocketAddress& /* client */,
+      size_t len,
+      bool /* truncated */,
+      OnDataAvailableParams /* params */) noexcept override {
+    bytes_ += len;
+    datagrams_++;
+    if (bytes_ >= expectedBytes_) {
+      evb_->terminateLoopSoon();
+    }
+  }
+
+  void onReadError(const AsyncSocketException& ex) noexcept override {
+    ADD_FAILURE() << ex.what();
+    evb_->terminateLoopSoon();
+  }
+
+  void onReadClosed() noexcept override {}
+
+  size_t bytes_{0};
+  size_t datagrams_{0};
+
+ private:
+  EventBase* evb_;
+  size_t expectedBytes_;
+  char buffer_[65536];
+};
+
+} // namespace
+
+TEST(UdpGsoWriter, BatchRoundTrip) {
+  EventBase evb;
+
+  constexpr size_t kSegment = 200;
+  constexpr size_t kFullSegments = 20;
+  constexpr size_t kTailSize = 50;
+  constexpr size_t kTotalBytes = kFullSegments * kSegment + kTailSize;
+
+  AsyncUDPSocket receiver(&evb);
+  receiver.bind(SocketAddress("127.0.0.1", 0));
+  Receiver readCallback(&evb, kTotalBytes);
+  receiver.resumeRead(&readCallback);
+
+  auto sender = std::make_shared<AsyncUDPSocket>(&evb);
+  sender->bind(SocketAddress("127.0.0.1", 0));
+
+  auto makeDatagram = [](size_t size) {
+    auto buf = IOBuf::create(size);
+    memset(buf->writableData(), 'x', size);
+    buf->append(size);
+    return buf;
+  };
+
+  UdpGsoWriter writer(sender);
+  for (size_t i = 0; i < kFullSegments; i++) {
+    EXPECT_EQ(
+        kSegment, writer.write(receiver.address(), makeDatagram(kSegment)));
+  }
+  // An undersized datagram can only be the final segment, so it flushes
+  // the batch on its own.
+  EXPECT_EQ(
+      kTailSize, writer.write(receiver.address(), makeDatagram(kTailSize)));
+  EXPECT_GE(writer.flush(), 0);
+  EXPECT_EQ(0, writer.pendingDatagrams());
+
+  evb.runAfterDelay([&] { evb.terminateLoopSoon(); }, 5000);
+  evb.loopForever();
+
+  EXPECT_EQ(kTotalBytes, readCallback.bytes_);
+  const auto& counters = writer.counters();
+  EXPECT_EQ(kFullSegments + 1, counters.datagrams);
+  EXPECT_GE(counters.sendCalls, 1);
+  // Without kernel GSO support the writer degrades to one send per
+  // datagram; with it the whole burst goes out in one sendmsg.
+  if (sender->getGSO() >= 0) {
+    EXPECT_EQ(1, counters.sendCalls);
+    EXPECT_EQ(1, counters.gsoSends);
+    EXPECT_EQ(kFullSegments + 1, counters.gsoDatagrams);
+  } else {
+    EXPECT_EQ(kFullSegments + 1, counters.sendCalls);
+    EXPECT_EQ(0, counters.gsoSends);
+  }
+
+  receiver.pauseRead();
+}